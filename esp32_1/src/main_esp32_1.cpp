@@ -1,21 +1,47 @@
 /*
 ///////////////// IMPORTACION DE MODULOS \\\\\\\\\\\\\\\\\
 */
-#include <ArduinoJson.h>
-// Ofrecerinterfaz MQTT
-#include <PubSubClient.h>
-// Leer sensores a traves de distintas plataformas y librerias
-#include <Adafruit_Sensor.h>
-// Leer datos del sensor DHT11
-#include <DHT.h>
-// Leer sonda temperatura DS18B20
-#include <OneWire.h>
-#include <DallasTemperature.h>
-
-#include "main.h"
-#include "led/rgb.h"
-#include "wifi/wifi.h"
-#include "mqtt/mqtt.h"
+// Planificador cooperativo de tareas periodicas
+#include <scheduler.h>
+// Lectura de todos los sensores del nodo
+#include <sample.h>
+// Codificacion de los mensajes (binario compacto o JSON)
+#include <payload.h>
+// Agrupacion de varias lecturas en un unico mensaje
+#include <sample_batch.h>
+// Envio por cambio: cada canal se publica al salir de su banda muerta o al vencer el latido
+#include <report_policy.h>
+// Resumen por ventana (minimo, maximo, media y desviacion) en lugar de cada lectura
+#include <window_stats.h>
+// Sistema de ficheros con la calibracion y la cola persistente
+#include <LittleFS.h>
+// Adquisicion solapada: el resto de sensores se leen mientras convierte la sonda
+#include <acquisition.h>
+// Pines y constantes de la placa, y drivers de los sensores del nodo
+#include <board.h>
+#include <sensor_set.h>
+#include <sensor_ds18b20.h>
+#include <sensor_dht11.h>
+#include <sensor_soil.h>
+// Instantes de cada fase del arranque hasta la primera publicacion
+#include <boot_timeline.h>
+// LED RGB, conexion WiFi y MQTT comunes a todos los nodos
+#include <rgb.h>
+#include <node_wifi.h>
+#include <node_mqtt.h>
+// Contadores e histogramas del camino critico, expuestos en /metrics
+#include <node_metrics.h>
+// Hora UTC por SNTP con correccion de deriva, para fechar las lecturas en el nodo
+#include <node_time.h>
+// Periodo de muestreo adaptativo y configuracion remota por MQTT
+#include <adaptive_sampler.h>
+#include <node_config.h>
+// Cola sin cerrojos entre la tarea de sensores y la de red (modo de doble nucleo)
+#include <spsc_ring.h>
+// Envio directo de las lecturas a la pasarela por ESP-NOW (modo ESPNOW_LEAF)
+#include <node_espnow.h>
+
+#include "sleep/duty_cycle.h"
 
 /*
 ///////////////// ASIGNACION DE VALORES \\\\\\\\\\\\\\\\\
@@ -32,135 +58,500 @@ const char* mqtt_server = "192.168.1.70";
 const int mqtt_port = 1883;
 const char* mqtt_topic_params = "esp32_1/params";
 const char* mqtt_topic_coverage = "esp32_1/coverage";
+const char* mqtt_topic_link = "esp32_1/link";
+const char* mqtt_topic_boot = "esp32_1/boot";
+const char* mqtt_topic_summary = "esp32_1/summary";
+const char* mqtt_topic_config = "esp32_1/config";
+const char* mqtt_topic_sampler = "esp32_1/sampler";
+
+// Servidor NTP de la red local (la Raspberry, junto al broker)
+const char* ntp_server = "192.168.1.70";
+
+#ifdef ESPNOW_LEAF
+// Configurar el enlace ESP-NOW con la pasarela (gateway_1) //
+// MAC de la interfaz WiFi de la pasarela, que publica las lecturas como "esp32_1/params"
+const uint8_t gateway_mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+const char* node_name = "esp32_1";
+#endif
 
-// Variable para almacenar el tiempo anterior
-unsigned long tiempoAnterior2 = 0;
 // Intervalo de tiempo deseado para "Intensidad de señal"
 // Cada 10s se monitoriza la intensidad de la señal
 const unsigned long intervalo2 = 10000;
 
-// Pin analógico conectado al sensor de humedad del suelo (ejemplo: GPIO32)
-const int analogPin = 35;
-// Calibracion del sensor capacitivo: Aire-Agua
-const int HumedityMin = 990;
-const int Humeditymax = 2870;
-
-// Pin de datos de la sonda DS18B20
-#define ONE_WIRE_BUS 33
-OneWire oneWire(ONE_WIRE_BUS);
-DallasTemperature sensors(&oneWire);
-
-// configura los pines del sensor DHT11 //
-const int DHTTYPE = DHT11;
-const int DHTPIN = 32;
-DHT dht(DHTPIN, DHTTYPE);
-
-// configura los pines del LED RGB //
-const int pinRojo = 23;
-const int pinAzul = 22;
-const int pinVerde = 21;
+// Periodo inicial de muestreo y publicacion de los sensores; despues lo ajusta el muestreo
+// adaptativo entre los limites de la configuracion
+const unsigned long periodoMuestreo = 30000;
+// Periodo de consulta de la conversion de la sonda en curso
+const unsigned long periodoAdquisicion = 50;
+// Periodo de supervision de las conexiones WiFi y MQTT
+const unsigned long periodoSupervision = 250;
+// Periodo de consulta de peticiones al servidor de metricas
+const unsigned long periodoMetricas = 200;
+// Periodo de servicio del socket MQTT: envio del anillo de salida, PUBACK y keepalive
+const unsigned long periodoMqtt = 50;
+
+#ifdef DUAL_CORE_MODE
+// Modo de doble nucleo: la adquisicion corre en una tarea fija en APP_CPU y la red (WiFi,
+// MQTT, lotes y metricas) en otra fija en PRO_CPU. Ninguna bloquea a la otra: la conversion
+// de la sonda no retrasa la red y un envio TCP atascado no retrasa el muestreo
+#ifndef DUAL_CORE_RING_SIZE
+#define DUAL_CORE_RING_SIZE 16
+#endif
+// Espera maxima (ms) de la tarea de sensores cuando la cola esta llena antes de descartar
+#ifndef DUAL_CORE_BACKPRESSURE_MS
+#define DUAL_CORE_BACKPRESSURE_MS 1000
+#endif
+const uint32_t pilaSensores = 4096;
+const uint32_t pilaRed = 8192;
+#endif
+
+// Sensores del nodo: sonda DS18B20, DHT11 y sensor capacitivo de humedad del suelo.
+// Los pines y la calibracion por defecto estan en Esp32Board (board.h)
+typedef SensorSet<Ds18b20Probe<Board>, Dht11Sensor<Board>, SoilSensor<Board>> Sensores;
+constexpr SensorDrivers sensores = Sensores::drivers();
+
+// Ultima lectura completa de los sensores
+SensorSample ultimaLectura;
+// Lecturas acumuladas hasta completar el lote
+SampleBatch lote;
+// Politica de envio de cada canal
+ReportPolicy politica;
+// Adquisicion en curso de los sensores
+Acquisition adquisicion;
+// Estadisticos de la ventana en curso. Con PUBLISH_RAW_SAMPLES se publican las lecturas
+// (por cambio y en lotes) en lugar del resumen
+WindowStats ventana;
+// Periodo de muestreo adaptativo y configuracion recibida por MQTT
+AdaptiveSampler muestreo;
+NodeConfig configuracion;
+Task* tareaMuestreo = nullptr;
+Task* tareaCobertura = nullptr;
+// Reloj sincronizado con el que se fechan las lecturas (en modo bajo consumo, el de memoria RTC)
+SyncClock reloj;
+
+#ifdef DUAL_CORE_MODE
+/**
+ * @brief Lectura completa que la tarea de sensores entrega a la de red.
+ */
+struct SampleRecord {
+  SensorSample sample;
+  // duracion de la adquisicion en ms
+  uint32_t duration;
+  // Lectura del ADC del sensor de humedad del suelo de esta muestra
+  uint16_t adc;
+};
+
+// Unico productor: tarea_sensores(). Unico consumidor: tarea_lecturas()
+SpscRing<SampleRecord, DUAL_CORE_RING_SIZE> colaLecturas;
+// Periodo de muestreo que decide la tarea de red y sigue la de sensores
+std::atomic<uint32_t> periodoSensores(periodoMuestreo);
+#endif
 
 /*
 ///////////////// DECLARACION DE FUNCIONES \\\\\\\\\\\\\\\\\
 */
-void setup() {
-  // Configurar serial monitor
-  Serial.begin(9600);
-
-  // configura el LED RGB para que se pueda escribir
-  pinMode(pinRojo, OUTPUT);
-  pinMode(pinAzul, OUTPUT);
-  pinMode(pinVerde, OUTPUT);
-
-  // apaga desde un inicio el LED RGB
-  turnOffLED(pinRojo, pinVerde, pinAzul);
-
-  // Iniciar servicio sonda de temperatura
-  sensors.begin();
-
-  // inicia el sensor DHT11
-  dht.begin();
+void tarea_red() {
+  // Supervisa la red WiFi y la sesion MQTT sin bloquear
+  wifi_supervise();
+  // Sincroniza el reloj cuando toca (un intercambio SNTP de pocos ms en la red local)
+  time_sync_poll();
+  if (!mqtt_is_connected()) {
+    return;
+  }
 
-  // Conectar a la red wifi local
-  setup_wifi(ssid, password, ip, gateway, subnet);
+  // Se publica el estado del enlace tras cada conexion con el broker
+  static uint32_t conexionesPublicadas = 0;
+  if (conexion.stats.mqttConnects != conexionesPublicadas) {
+    conexionesPublicadas = conexion.stats.mqttConnects;
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_link(conexion.stats, payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_link, payload, len);
+  }
 
-  // Condifurar servidor mqtt para enviar datos
-  mqtt_init(mqtt_server, mqtt_port);
+  // Tiempos del arranque, una sola vez tras la primera publicacion
+  static bool arranquePublicado = false;
+  if (!arranquePublicado && boot_complete()) {
+    arranquePublicado = true;
+    Serial.print("Primera publicacion a los ");
+    Serial.print(boot_timeline().phases[ARRANQUE_PUBLICACION]);
+    Serial.println(" ms del arranque");
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_boot(boot_timeline(), payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_boot, payload, len);
+  }
 }
 
-void loop() {
-
-  // Comprobar conexion MQTT
-  mqtt_is_connected();
-
-  turnOffLED(pinRojo, pinVerde, pinAzul);
-  commandLED(1023, 0, 1023, pinRojo, pinVerde, pinAzul);
-  // Leer temperatura del sensor
-  float temperatureDHT = dht.readTemperature();
-
-  // Leer humedad del sensor
-  float humidityDHT = dht.readHumidity();
-
-  // Lectura de la humedad del suelo
-  int sensorValue = analogRead(analogPin);
-  int humidityCapacitor = 100 - map(sensorValue, HumedityMin, Humeditymax, 0, 100);
-  // Conversión a voltaje (rango de 0 a 3.3V)
-  float voltage = sensorValue * (3.3 / 4095.0);
-
-  // Lectura de la temperatura del suelo
-  sensors.requestTemperatures();
-  float temperatureProbe = sensors.getTempCByIndex(0);
-  commandLED(0, 20, 0, pinRojo, pinVerde, pinAzul);
+void mostrar_lectura(const SensorSample& lectura, uint32_t duracion, uint16_t adc) {
+  // Solo usa los datos de la propia lectura: en modo de doble nucleo la adquisicion sigue en
+  // el otro nucleo mientras se muestra
+  static uint32_t duracionMaxima = 0;
+  duracionMaxima = duracion > duracionMaxima ? duracion : duracionMaxima;
 
   Serial.print("Temperatura sonda DS18B20: ");
-  Serial.print(temperatureProbe);
+  Serial.print(lectura.temperatureProbe);
   Serial.println(" °C");
 
   Serial.print("Temperatura DHT11: ");
-  Serial.print(temperatureDHT);
+  Serial.print(lectura.temperatureDHT);
   Serial.print(" °C, Humedad DHT11: ");
-  Serial.print(humidityDHT);
+  Serial.print(lectura.humidityDHT);
   Serial.println(" %");
 
   Serial.print("% humedad: ");
-  Serial.print(humidityCapacitor);
+  Serial.print(lectura.humidityCapacitor);
   Serial.print("%");
   Serial.print(", Voltaje: ");
-  Serial.print(voltage, 2);
+  Serial.print(SoilSensor<Board>::voltaje(adc), 2);
   Serial.println("V");
 
-  // usa el formato json para enviar datos
-  StaticJsonDocument<64> params;
-  params["temperatura_sonda"] = temperatureProbe;
-  params["temperatura_dht"] = temperatureDHT;
-  params["humedad_capacitor"] = humidityCapacitor;
-  params["humedad_dht"] = humidityDHT;
+  Serial.print("Tiempo de adquisicion: ");
+  Serial.print(duracion);
+  Serial.print(" ms (max ");
+  Serial.print(duracionMaxima);
+  Serial.println(" ms)");
+}
+
+void mostrar_politica() {
+  // Valores enviados frente a suprimidos por la politica de envio, por canal
+  for (uint8_t campo = 0; campo < REPORT_CHANNELS; campo++) {
+    const ReportChannel& canal = politica.channels[campo];
+    Serial.print(report_channel_name(campo));
+    Serial.print(": ");
+    Serial.print(canal.sent);
+    Serial.print(" enviados, ");
+    Serial.print(canal.suppressed);
+    Serial.println(" suprimidos");
+  }
+}
+
+bool publicar_lectura(const SensorSample& lectura, uint32_t ahora) {
+  // Codifica la lectura en un buffer en la pila, sin memoria dinamica. Se fecha con la hora
+  // UTC de su adquisicion; sin reloj sincronizado indica los segundos transcurridos desde ella
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_params(lectura, (ahora - lectura.timestamp) / 1000, time_epoch(lectura.timestamp),
+                                     payload, sizeof(payload));
+
+  // publica los datos mediante protocolo MQTT
+  return mqtt_publish(mqtt_topic_params, payload, len);
+}
+
+void publicar_muestreo() {
+  // Estado del muestreo adaptativo: la frecuencia efectiva es lecturas / tiempo_s
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_sampler(muestreo, millis(), payload, sizeof(payload));
+  mqtt_publish(mqtt_topic_sampler, payload, len);
+}
 
-  String jsonStringParams;
-  serializeJson(params, jsonStringParams);
+void aplicar_periodo() {
+  Serial.print("Periodo de muestreo: ");
+  Serial.print(muestreo.period);
+  Serial.println(" ms");
+  metricas.periodoMuestreo = muestreo.period;
+#ifdef DUAL_CORE_MODE
+  periodoSensores = muestreo.period;
+#else
+  if (tareaMuestreo != nullptr) {
+    scheduler_set_period(tareaMuestreo, muestreo.period);
+  }
+#endif
+  publicar_muestreo();
+}
 
-   // publica los datos mediante protocolo MQTT
-  client.publish(mqtt_topic_params, (char*)jsonStringParams.c_str());
+void aplicar_configuracion(const NodeConfig& config) {
+  // Configuracion nueva recibida por MQTT, ya guardada en flash
+  sampler_configure(&muestreo, config.sampler);
+  if (tareaCobertura != nullptr) {
+    scheduler_set_period(tareaCobertura, config.coveragePeriod);
+  }
+  aplicar_periodo();
+}
 
+Task* agregar_tarea(const char* nombre, TaskCallback funcion, unsigned long periodo, unsigned long presupuesto,
+                    unsigned long desfase = 0) {
+  // Registra la tarea y avisa si el planificador no tiene hueco: la tarea no se ejecutaria
+  Task* tarea = scheduler_add(nombre, funcion, periodo, presupuesto, desfase);
+  if (tarea == nullptr) {
+    Serial.print("Sin hueco en el planificador para la tarea ");
+    Serial.print(nombre);
+    Serial.println(": aumentar SCHEDULER_MAX_TASKS");
+  }
+  return tarea;
+}
 
-  if (millis() - tiempoAnterior2 >= intervalo2) {
-    tiempoAnterior2 = millis();
+void tarea_reenvio() {
+  // Reenvia las lecturas guardadas mientras no habia conexion
+  mqtt_drain();
+}
 
-    int rssi = WiFi.RSSI();
-    Serial.print("Intensidad de señal: ");
-    Serial.print(rssi);
-    Serial.println(" dBm");
+void tarea_muestreo() {
+  // Inicia la adquisicion; la lectura se completa en tarea_adquisicion()
+  turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  commandLED(1023, 0, 1023, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  acquisition_start(&adquisicion);
+}
 
-    StaticJsonDocument<64> coverage;
-    coverage["dBm"] = rssi;
+#ifdef PUBLISH_RAW_SAMPLES
+void tarea_lotes() {
+  // Se publica cuando el lote esta completo o la lectura mas antigua es demasiado vieja. Tambien
+  // corre como tarea periodica: si la politica de envio descarta las lecturas siguientes el
+  // lote no se revisaria al vencer BATCH_MAX_LATENCY
+  uint32_t ahora = millis();
+  if (!batch_ready(&lote, ahora)) {
+    return;
+  }
 
-    String jsonStringCoverage;
-    serializeJson(coverage, jsonStringCoverage);
+  // Buffer estatico: un lote completo no cabe con holgura en la pila del loop
+  static uint8_t payload[PAYLOAD_BATCH_MAX_SIZE];
+  uint32_t inicio = micros();
+  size_t len = batch_encode(&lote, ahora, &time_clock(), payload, sizeof(payload));
+  metrics_observe(&metricas.serializacion, micros() - inicio);
 
-    // publica los datos mediante protocolo MQTT
-    client.publish(mqtt_topic_coverage, (char*)jsonStringCoverage.c_str());
+  // publica los datos mediante protocolo MQTT; sin conexion se guarda en la cola persistente
+  mqtt_publish(mqtt_topic_params, payload, len);
+  batch_clear(&lote);
+  mostrar_politica();
+}
+#endif
+
+void tarea_publicacion() {
+  // Se llama una vez por cada lectura completa (acquisition_poll() o la cola de lecturas)
+#ifndef PUBLISH_RAW_SAMPLES
+  // La lectura se acumula en la ventana; tarea_resumen() publica al cerrarla
+  stats_add(&ventana, ultimaLectura);
+#else
+  // Solo entran en el lote los canales que han cambiado o cuyo latido ha vencido
+  SensorSample lectura = ultimaLectura;
+  if (report_filter(&politica, lectura)) {
+    batch_add(&lote, lectura);
   }
 
-  // Retardo al final del loop para reducir el consumo de energía
-  delay(30000);
+  tarea_lotes();
+#endif
+}
+
+void tarea_resumen() {
+  // Cierra la ventana en curso y publica un unico mensaje con sus estadisticos
+  uint32_t ahora = millis();
+  if (stats_has_data(&ventana)) {
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    uint32_t inicio = micros();
+    size_t len = payload_encode_summary(ventana, ahora - ventana.start, time_epoch(ahora), payload, sizeof(payload));
+    metrics_observe(&metricas.serializacion, micros() - inicio);
+
+    // publica los datos mediante protocolo MQTT; sin conexion se guarda en la cola persistente
+    mqtt_publish(mqtt_topic_summary, payload, len);
+  }
+  stats_reset(&ventana, ahora);
+}
+
+void tarea_adquisicion() {
+  // Comprueba si la sonda ha terminado la conversion, sin bloquear
+  if (!acquisition_poll(&adquisicion)) {
+    return;
+  }
+  commandLED(0, 20, 0, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  metrics_observe(&metricas.lectura, adquisicion.lastDuration * 1000UL);
+  metrics_count(&metricas.lecturas);
+  ultimaLectura = adquisicion.sample;
+  mostrar_lectura(ultimaLectura, adquisicion.lastDuration, SoilSensor<Board>::adc);
+  tarea_publicacion();
+
+  // Ajusta el periodo a la velocidad de cambio de las lecturas
+  if (sampler_update(&muestreo, ultimaLectura)) {
+    aplicar_periodo();
+  }
+}
+
+#ifdef DUAL_CORE_MODE
+void tarea_sensores(void*) {
+  // Muestreo con periodo fijo en APP_CPU; la espera de la conversion cede el nucleo
+  TickType_t siguiente = xTaskGetTickCount();
+  while (true) {
+    tarea_muestreo();
+    while (!acquisition_poll(&adquisicion)) {
+      vTaskDelay(pdMS_TO_TICKS(periodoAdquisicion));
+    }
+    commandLED(0, 20, 0, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+
+    // Contrapresion: si la tarea de red no da abasto se espera un tiempo acotado a que
+    // libere hueco; despues la lectura se descarta y se cuenta en la cola
+    SampleRecord registro = {adquisicion.sample, adquisicion.lastDuration, SoilSensor<Board>::adc};
+    for (uint32_t espera = 0; colaLecturas.full() && espera < DUAL_CORE_BACKPRESSURE_MS; espera += periodoAdquisicion) {
+      vTaskDelay(pdMS_TO_TICKS(periodoAdquisicion));
+    }
+    colaLecturas.push(registro);
+
+    vTaskDelayUntil(&siguiente, pdMS_TO_TICKS(periodoSensores.load()));
+  }
+}
+
+void tarea_lecturas() {
+  // Consume las lecturas de la tarea de sensores y las publica por el camino habitual
+  SampleRecord registro;
+  while (colaLecturas.pop(registro)) {
+    metrics_observe(&metricas.lectura, registro.duration * 1000UL);
+    metrics_count(&metricas.lecturas);
+    ultimaLectura = registro.sample;
+    mostrar_lectura(ultimaLectura, registro.duration, registro.adc);
+    tarea_publicacion();
+    if (sampler_update(&muestreo, ultimaLectura)) {
+      aplicar_periodo();
+    }
+  }
+  metricas.descartadas = colaLecturas.overflows();
+}
+
+void tarea_red_nucleo(void*) {
+  // Bucle del planificador en PRO_CPU. Se cede al menos un tick en cada pasada para que
+  // la tarea inactiva del nucleo atienda su watchdog
+  while (true) {
+    unsigned long idle = scheduler_run();
+    metrics_observe_loop();
+    delay(idle > 0 ? idle : 1);
+  }
+}
+#endif
+
+void tarea_cobertura() {
+  if (!mqtt_connected()) {
+    return;
+  }
+
+  int rssi = WiFi.RSSI();
+  Serial.print("Intensidad de señal: ");
+  Serial.print(rssi);
+  Serial.println(" dBm");
+
+  // La cobertura solo se publica si cambia mas que su banda muerta o vence el latido
+  if (!report_channel_due(&politica.channels[CAMPO_DBM], rssi, millis())) {
+    return;
+  }
+
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_coverage(rssi, payload, sizeof(payload));
+
+  // publica los datos mediante protocolo MQTT
+  mqtt_publish(mqtt_topic_coverage, payload, len);
+}
+
+void setup() {
+  // Configurar serial monitor
+  Serial.begin(9600);
+
+  // configura el LED RGB para que se pueda escribir
+  pinMode(Board::pinRojo, OUTPUT);
+  pinMode(Board::pinAzul, OUTPUT);
+  pinMode(Board::pinVerde, OUTPUT);
+
+  // apaga desde un inicio el LED RGB
+  turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+
+  // Montar el sistema de ficheros con la calibracion propia del sensor de humedad del suelo
+  LittleFS.begin(true);
+
+  // Iniciar los sensores del nodo. La conversion de la sonda no bloquea: se leen los
+  // demas sensores mientras tanto
+  Sensores::begin();
+  boot_mark(ARRANQUE_SENSORES, millis());
+
+#ifdef DUTY_CYCLE_MODE
+  // Modo bajo consumo: muestrea, guarda en memoria RTC y vuelve a dormir.
+  // Solo cada DUTY_CYCLE_FLUSH_EVERY despertares se enciende la radio para vaciar el buffer
+  duty_cycle_begin();
+  acquisition_init(&adquisicion, &sensores, millis);
+  acquisition_start(&adquisicion);
+  while (!acquisition_poll(&adquisicion)) {
+    delay(10);
+  }
+  SensorSample lectura = adquisicion.sample;
+  mostrar_lectura(lectura, adquisicion.lastDuration, SoilSensor<Board>::adc);
+  lectura.timestamp = duty_cycle_now();
+  duty_cycle_store(lectura);
+
+  if (duty_cycle_flush_due()) {
+#ifdef ESPNOW_LEAF
+    // Sin asociarse al punto de acceso ni abrir sesion MQTT: la pasarela publica las lecturas
+    if (espnow_leaf_begin(gateway_mac)) {
+      duty_cycle_send(espnow_transport(), node_name);
+    }
+#else
+    setup_wifi(ssid, password, ip, gateway, subnet);
+    mqtt_init(mqtt_server, mqtt_port);
+    time_sync_begin(ntp_server, duty_cycle_clock(), duty_cycle_now);
+    duty_cycle_flush(publicar_lectura);
+#endif
+  }
+  duty_cycle_sleep();
+#endif
+
+  // Conectar a la red wifi local
+  setup_wifi(ssid, password, ip, gateway, subnet);
+
+  // Condifurar servidor mqtt para enviar datos
+  mqtt_init(mqtt_server, mqtt_port);
+
+  // Hora UTC por SNTP: la primera consulta se hace en cuanto hay WiFi
+  sync_clock_init(&reloj);
+  time_sync_begin(ntp_server, &reloj, millis);
+
+  // Configuracion guardada y suscripcion a la configuracion remota (mensaje retenido)
+  configuracion.sampler = sampler_default_config();
+  configuracion.coveragePeriod = intervalo2;
+  node_config_begin(mqtt_topic_config, &configuracion, aplicar_configuracion);
+  sampler_init(&muestreo, configuracion.sampler, periodoMuestreo, millis());
+  metricas.periodoMuestreo = muestreo.period;
+#ifdef DUAL_CORE_MODE
+  periodoSensores = muestreo.period;
+#endif
+
+  // Servidor HTTP con las metricas del nodo para Prometheus
+  metrics_server_begin();
+
+  // Agrupar BATCH_SIZE lecturas por mensaje
+  batch_init(&lote, BATCH_SIZE, BATCH_MAX_LATENCY);
+
+  // Motor de adquisicion con los sensores del nodo
+  acquisition_init(&adquisicion, &sensores, millis);
+
+  // Politica de envio por cambio con los umbrales por defecto
+  report_init(&politica);
+
+  // Primera ventana de estadisticos
+  stats_reset(&ventana, millis());
+
+  // Registrar las tareas periodicas: nombre, funcion, periodo, presupuesto y desfase
+  scheduler_init(millis);
+  agregar_tarea("red", tarea_red, periodoSupervision, 50);
+  agregar_tarea("mqtt", mqtt_poll, periodoMqtt, 20);
+#ifdef DUAL_CORE_MODE
+  // La adquisicion la hace tarea_sensores(); aqui solo se recogen sus lecturas
+  agregar_tarea("lecturas", tarea_lecturas, periodoAdquisicion, 100);
+#else
+  tareaMuestreo = agregar_tarea("muestreo", tarea_muestreo, muestreo.period, 1000);
+  agregar_tarea("adquisicion", tarea_adquisicion, periodoAdquisicion, 100);
+#endif
+  tareaCobertura = agregar_tarea("cobertura", tarea_cobertura, configuracion.coveragePeriod, 50);
+  agregar_tarea("reenvio", tarea_reenvio, 1000, 200);
+  agregar_tarea("metricas", metrics_server_poll, periodoMetricas, 100);
+#ifndef PUBLISH_RAW_SAMPLES
+  agregar_tarea("resumen", tarea_resumen, STATS_WINDOW, 50, STATS_WINDOW);
+#else
+  agregar_tarea("lotes", tarea_lotes, 1000, 50);
+#endif
+
+#ifdef DUAL_CORE_MODE
+  xTaskCreatePinnedToCore(tarea_sensores, "sensores", pilaSensores, nullptr, 1, nullptr, APP_CPU_NUM);
+  xTaskCreatePinnedToCore(tarea_red_nucleo, "red", pilaRed, nullptr, 1, nullptr, PRO_CPU_NUM);
+#endif
+}
+
+void loop() {
+#ifdef DUAL_CORE_MODE
+  // Todo el trabajo esta en las tareas fijas a cada nucleo
+  vTaskDelete(nullptr);
+#endif
+  // Ejecuta la tarea mas urgente y cede la CPU hasta el siguiente deadline
+  unsigned long idle = scheduler_run();
+  metrics_observe_loop();
+  delay(idle);
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <sample_buffer.h>
+#include <node_wifi.h>
+#include <node_mqtt.h>
+#include <node_time.h>
+#include "duty_cycle.h"
+
+// Buffer de lecturas en memoria RTC: sobrevive al deep sleep, no a un arranque en frio
+RTC_DATA_ATTR static SampleBuffer rtcBuffer;
+// Hora y deriva del reloj, tambien en memoria RTC: la radio solo se enciende en los envios
+RTC_DATA_ATTR static SyncClock rtcClock;
+// Sesion y secuencia del enlace directo con la pasarela: la secuencia sigue entre despertares
+RTC_DATA_ATTR static LinkSender rtcSender;
+
+void duty_cycle_begin() {
+    if (!sample_buffer_restore(&rtcBuffer)) {
+        Serial.println("Cold boot, RTC sample buffer reset");
+        sync_clock_init(&rtcClock);
+        link_sender_init(&rtcSender, esp_random());
+    }
+    rtcBuffer.wakeups++;
+}
+
+unsigned long duty_cycle_now() {
+    return rtcBuffer.elapsed + millis();
+}
+
+SyncClock* duty_cycle_clock() {
+    return &rtcClock;
+}
+
+void duty_cycle_store(const SensorSample& lectura) {
+    if (!sample_buffer_push(&rtcBuffer, lectura)) {
+        Serial.println("RTC sample buffer full, oldest sample dropped");
+    }
+}
+
+bool duty_cycle_flush_due() {
+    return rtcBuffer.wakeups % DUTY_CYCLE_FLUSH_EVERY == 0 || rtcBuffer.count == SAMPLE_BUFFER_CAPACITY;
+}
+
+uint16_t duty_cycle_flush(DutyCyclePublish publish) {
+    // Espera acotada: en este modo no hay ninguna otra tarea que atender
+    unsigned long start = millis();
+    while (!(wifi_supervise() && mqtt_is_connected())) {
+        if (millis() - start >= DUTY_CYCLE_CONNECT_TIMEOUT) {
+            Serial.println("Flush aborted, samples kept for the next cycle");
+            return 0;
+        }
+        delay(50);
+    }
+
+    // Una consulta SNTP por envio; si falla las lecturas se fechan con el reloj que haya
+    time_sync_now();
+
+    // Publica todo el buffer en la misma sesion MQTT, sin adelantarse mas de
+    // MQTT_MAX_INFLIGHT mensajes a las confirmaciones del broker. Si la sesion cae se para:
+    // mqtt_publish() dejaria el resto en la cola de flash, desordenado respecto al anillo
+    uint32_t ahora = duty_cycle_now();
+    uint16_t sent = 0;
+    while (sent < rtcBuffer.count && mqtt_connected()) {
+        if (mqtt_client().pending() >= MQTT_MAX_INFLIGHT && !mqtt_flush(DUTY_CYCLE_CONNECT_TIMEOUT)) {
+            break;
+        }
+        if (!publish(*sample_buffer_at(&rtcBuffer, sent), ahora)) {
+            break;
+        }
+        sent++;
+    }
+
+    // Solo salen del buffer las lecturas confirmadas: los mensajes del anillo sin PUBACK se
+    // perderian con el deep sleep. El anillo los libera en orden, asi que son las primeras
+    mqtt_flush(DUTY_CYCLE_CONNECT_TIMEOUT);
+    uint16_t pending = mqtt_client().pending();
+    uint16_t confirmed = sent > pending ? sent - pending : 0;
+    sample_buffer_consume(&rtcBuffer, confirmed);
+    if (confirmed < sent) {
+        Serial.println("Flush not acknowledged, samples kept for the next cycle");
+    }
+
+    mqtt_disconnect();
+    return confirmed;
+}
+
+uint16_t duty_cycle_send(LinkTransport& transport, const char* node) {
+    // Cada trama va confirmada por la pasarela: se para en la primera que no llega
+    uint32_t ahora = duty_cycle_now();
+    uint16_t sent = 0;
+    while (sent < rtcBuffer.count && link_send(transport, &rtcSender, node, *sample_buffer_at(&rtcBuffer, sent), ahora)) {
+        sent++;
+    }
+    sample_buffer_consume(&rtcBuffer, sent);
+    if (rtcBuffer.count > 0) {
+        Serial.println("Gateway not reachable, samples kept for the next cycle");
+    }
+    return sent;
+}
+
+void duty_cycle_sleep() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+
+    // Descuenta el tiempo despierto para mantener constante el periodo de muestreo
+    uint32_t period = DUTY_CYCLE_SAMPLE_PERIOD_S * 1000UL;
+    uint32_t awake = millis();
+    uint32_t sleep = awake < period ? period - awake : 1;
+    rtcBuffer.elapsed += awake + sleep;
+
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep * 1000ULL);
+    esp_deep_sleep_start();
+}
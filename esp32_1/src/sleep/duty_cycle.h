@@ -0,0 +1,89 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <sample.h>
+#include <sync_clock.h>
+#include <sensor_link.h>
+
+/*
+///////////////// MODO BAJO CONSUMO (DEEP SLEEP) \\\\\\\\\\\\\\\\\
+*/
+// Periodo de muestreo en segundos (tiempo entre dos despertares)
+#ifndef DUTY_CYCLE_SAMPLE_PERIOD_S
+#define DUTY_CYCLE_SAMPLE_PERIOD_S 30
+#endif
+
+// Numero de despertares entre dos envios del buffer por MQTT
+#ifndef DUTY_CYCLE_FLUSH_EVERY
+#define DUTY_CYCLE_FLUSH_EVERY 10
+#endif
+
+// Tiempo maximo (ms) que se espera a la conexion WiFi y MQTT antes de volver a dormir
+#ifndef DUTY_CYCLE_CONNECT_TIMEOUT
+#define DUTY_CYCLE_CONNECT_TIMEOUT 15000
+#endif
+
+/**
+ * @brief Funcion que publica una lectura del buffer.
+ *
+ * @param lectura Lectura a publicar.
+ * @param ahora Instante actual en la base de tiempo del nodo, para calcular la edad de la lectura.
+ * @return true si se ha publicado correctamente.
+ */
+typedef bool (*DutyCyclePublish)(const SensorSample& lectura, uint32_t ahora);
+
+/**
+ * @brief Recupera el buffer de memoria RTC y contabiliza el despertar.
+ */
+void duty_cycle_begin();
+
+/**
+ * @brief Instante actual en milisegundos, incluyendo el tiempo dormido desde el arranque en frio.
+ */
+unsigned long duty_cycle_now();
+
+/**
+ * @brief Reloj sincronizado por SNTP sobre la base de tiempo de duty_cycle_now(). Esta en
+ * memoria RTC: conserva la hora y la deriva entre despertares.
+ */
+SyncClock* duty_cycle_clock();
+
+/**
+ * @brief Guarda una lectura en el buffer de memoria RTC.
+ *
+ * @param lectura Lectura a guardar.
+ */
+void duty_cycle_store(const SensorSample& lectura);
+
+/**
+ * @brief Indica si en este despertar toca encender la radio y vaciar el buffer.
+ */
+bool duty_cycle_flush_due();
+
+/**
+ * @brief Espera a la conexion WiFi y MQTT, sincroniza el reloj y publica todo el buffer en
+ * una sola rafaga. Las lecturas que el broker no llegue a confirmar (PUBACK) se conservan
+ * para el siguiente envio.
+ *
+ * @param publish Funcion que publica cada lectura.
+ * @return Numero de lecturas confirmadas.
+ */
+uint16_t duty_cycle_flush(DutyCyclePublish publish);
+
+/**
+ * @brief Envia todo el buffer a la pasarela por el enlace directo (modo ESPNOW_LEAF), sin
+ * asociarse al punto de acceso. Se para en la primera lectura que la pasarela no confirma;
+ * esa y las siguientes se conservan para el siguiente envio.
+ *
+ * @param transport Medio hasta la pasarela, ya iniciado.
+ * @param node Nombre del nodo con el que la pasarela publica sus lecturas.
+ * @return Numero de lecturas entregadas.
+ */
+uint16_t duty_cycle_send(LinkTransport& transport, const char* node);
+
+/**
+ * @brief Apaga la radio y entra en deep sleep hasta el siguiente periodo de muestreo. No retorna.
+ */
+void duty_cycle_sleep();
+
+#endif // DUTY_CYCLE_H
@@ -0,0 +1,238 @@
+/*
+///////////////// PRUEBAS DE LA ADQUISICION SOLAPADA \\\\\\\\\\\\\\\\\
+*/
+// lib/acquisition con sensores falsos sobre un reloj falso. Cada driver avanza el reloj lo
+// que tarda el sensor real (DS18B20 a 12 bits 750 ms, DHT11 unos 25 ms, rafaga del ADC 2 ms)
+// y apunta el intervalo que ocupa, para comprobar que la lectura del DHT11 y del ADC cae
+// dentro de la conversion de la sonda y no despues. El DHT11 se prueba tambien por fases,
+// como el driver RMT del ESP32, en el que ninguna llamada avanza el reloj.
+#include <acquisition.h>
+#include <math.h>
+#include <unity.h>
+
+static const uint16_t CONVERSION_SONDA = 750;
+static const uint32_t LECTURA_DHT = 25;
+static const uint32_t LECTURA_SUELO = 2;
+
+static unsigned long reloj = 0;
+
+struct Fase {
+  uint32_t inicio;
+  uint32_t fin;
+  uint8_t veces;
+};
+
+static Fase sonda;
+static Fase dht;
+static Fase suelo;
+// Tiempo real de conversion de la sonda; mas que el maximo simula una sonda colgada
+static uint32_t conversionReal = 0;
+static bool sondaResponde = true;
+
+static unsigned long fake_clock() {
+  return reloj;
+}
+
+static uint16_t fake_probe_start() {
+  sonda.inicio = reloj;
+  sonda.fin = reloj + conversionReal;
+  sonda.veces++;
+  return CONVERSION_SONDA;
+}
+
+static bool fake_probe_ready() {
+  return (long)(reloj - sonda.fin) >= 0;
+}
+
+static float fake_probe_read() {
+  return sondaResponde && fake_probe_ready() ? 21.5f : NAN;
+}
+
+static void fake_read_dht(SensorSample& lectura) {
+  dht.inicio = reloj;
+  reloj += LECTURA_DHT;
+  dht.fin = reloj;
+  dht.veces++;
+  lectura.temperatureDHT = 22.0f;
+  lectura.humidityDHT = 48.0f;
+}
+
+// DHT11 por fases: la transaccion termina LECTURA_DHT ms despues de iniciarla
+static void fake_dht_start() {
+  dht.inicio = reloj;
+  dht.fin = reloj + LECTURA_DHT;
+}
+
+static bool fake_dht_ready() {
+  return (long)(reloj - dht.fin) >= 0;
+}
+
+static void fake_dht_result(SensorSample& lectura) {
+  dht.veces++;
+  lectura.temperatureDHT = 22.0f;
+  lectura.humidityDHT = 48.0f;
+}
+
+static void fake_read_soil(SensorSample& lectura) {
+  suelo.inicio = reloj;
+  reloj += LECTURA_SUELO;
+  suelo.fin = reloj;
+  suelo.veces++;
+  lectura.humidityCapacitor = 57;
+}
+
+static const SensorDrivers DRIVERS = {fake_probe_start, fake_probe_ready, fake_probe_read, nullptr, nullptr,
+                                      fake_read_dht,    fake_read_soil};
+static const SensorDrivers DRIVERS_FASES = {fake_probe_start, fake_probe_ready, fake_probe_read, fake_dht_start,
+                                            fake_dht_ready,   fake_dht_result,  fake_read_soil};
+
+// Llama a acquisition_poll() cada paso ms, como la tarea de adquisicion del planificador
+static uint32_t poll_until_done(Acquisition* adquisicion, uint32_t paso) {
+  uint32_t consultas = 1;
+  while (!acquisition_poll(adquisicion)) {
+    reloj += paso;
+    consultas++;
+    TEST_ASSERT_TRUE(consultas < 10000);
+  }
+  return consultas;
+}
+
+static bool inside(const Fase& fase, const Fase& conversion) {
+  return fase.inicio >= conversion.inicio && fase.fin <= conversion.fin;
+}
+
+void setUp() {
+  reloj = 5000;
+  sonda = dht = suelo = Fase{0, 0, 0};
+  conversionReal = CONVERSION_SONDA;
+  sondaResponde = true;
+}
+
+void tearDown() {}
+
+// El DHT11 y el ADC se leen durante la conversion de la sonda: la adquisicion dura lo que
+// la fase mas larga, no la suma de las tres
+void test_phases_overlap() {
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &DRIVERS, fake_clock);
+  TEST_ASSERT_TRUE(acquisition_start(&adquisicion));
+  poll_until_done(&adquisicion, 1);
+
+  TEST_ASSERT_EQUAL(1, sonda.veces);
+  TEST_ASSERT_EQUAL(1, dht.veces);
+  TEST_ASSERT_EQUAL(1, suelo.veces);
+  TEST_ASSERT_TRUE(inside(dht, sonda));
+  TEST_ASSERT_TRUE(inside(suelo, sonda));
+  TEST_ASSERT_EQUAL(CONVERSION_SONDA, adquisicion.lastDuration);
+  TEST_ASSERT_TRUE(adquisicion.lastDuration < CONVERSION_SONDA + LECTURA_DHT + LECTURA_SUELO);
+
+  // Una sola lectura con todos los canales, fechada al inicio
+  const SensorSample& lectura = adquisicion.sample;
+  TEST_ASSERT_EQUAL_UINT32(5000, lectura.timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, lectura.temperatureProbe);
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, lectura.temperatureDHT);
+  TEST_ASSERT_EQUAL_FLOAT(48.0f, lectura.humidityDHT);
+  TEST_ASSERT_EQUAL(57, lectura.humidityCapacitor);
+}
+
+// Mientras la sonda convierte acquisition_poll() vuelve enseguida y sin leer nada
+void test_poll_does_not_block() {
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &DRIVERS, fake_clock);
+  acquisition_start(&adquisicion);
+  uint32_t antes = reloj;
+  TEST_ASSERT_FALSE(acquisition_poll(&adquisicion));
+  TEST_ASSERT_EQUAL_UINT32(antes, reloj);
+  TEST_ASSERT_FALSE(acquisition_start(&adquisicion));
+
+  // La lectura del DHT11 y del ADC ya ha consumido parte de la conversion
+  uint32_t consultas = poll_until_done(&adquisicion, 100);
+  TEST_ASSERT_EQUAL(1 + (CONVERSION_SONDA - LECTURA_DHT - LECTURA_SUELO + 99) / 100, consultas);
+  TEST_ASSERT_EQUAL(1, dht.veces);
+  TEST_ASSERT_FALSE(acquisition_poll(&adquisicion));
+}
+
+// Una sonda que termina antes de tiempo se recoge en cuanto esta lista
+void test_early_probe_completion() {
+  conversionReal = 94;
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &DRIVERS, fake_clock);
+  acquisition_start(&adquisicion);
+  poll_until_done(&adquisicion, 1);
+  TEST_ASSERT_EQUAL(94, adquisicion.lastDuration);
+}
+
+// Una sonda colgada no bloquea la adquisicion mas alla de su tiempo maximo de conversion
+void test_probe_timeout() {
+  conversionReal = 60000;
+  sondaResponde = false;
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &DRIVERS, fake_clock);
+  acquisition_start(&adquisicion);
+  poll_until_done(&adquisicion, 1);
+  TEST_ASSERT_EQUAL(CONVERSION_SONDA, adquisicion.lastDuration);
+  TEST_ASSERT_TRUE(isnan(adquisicion.sample.temperatureProbe));
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, adquisicion.sample.temperatureDHT);
+
+  // La siguiente adquisicion normal no cambia el maximo
+  conversionReal = 400;
+  sondaResponde = true;
+  acquisition_start(&adquisicion);
+  poll_until_done(&adquisicion, 1);
+  TEST_ASSERT_EQUAL(400, adquisicion.lastDuration);
+  TEST_ASSERT_EQUAL(CONVERSION_SONDA, adquisicion.maxDuration);
+}
+
+// Un nodo sin sonda (NodeMCU) completa la lectura en la primera consulta
+void test_node_without_probe() {
+  const SensorDrivers sinSonda = {nullptr, nullptr, nullptr, nullptr, nullptr, fake_read_dht, nullptr};
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &sinSonda, fake_clock);
+  acquisition_start(&adquisicion);
+  TEST_ASSERT_TRUE(acquisition_poll(&adquisicion));
+  TEST_ASSERT_EQUAL(LECTURA_DHT, adquisicion.lastDuration);
+  TEST_ASSERT_TRUE(isnan(adquisicion.sample.temperatureProbe));
+  TEST_ASSERT_EQUAL(SAMPLE_NO_HUMIDITY, adquisicion.sample.humidityCapacitor);
+}
+
+// El DHT11 por fases no bloquea ni al iniciar ni al consultar, y se recoge dentro de la
+// conversion de la sonda
+void test_dht_phases_do_not_block() {
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &DRIVERS_FASES, fake_clock);
+  acquisition_start(&adquisicion);
+  TEST_ASSERT_EQUAL_UINT32(5000 + LECTURA_SUELO, reloj);
+  TEST_ASSERT_FALSE(acquisition_poll(&adquisicion));
+  TEST_ASSERT_EQUAL(0, dht.veces);
+
+  poll_until_done(&adquisicion, 1);
+  TEST_ASSERT_EQUAL(1, dht.veces);
+  TEST_ASSERT_TRUE(inside(dht, sonda));
+  TEST_ASSERT_EQUAL(CONVERSION_SONDA, adquisicion.lastDuration);
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, adquisicion.sample.temperatureDHT);
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, adquisicion.sample.temperatureProbe);
+}
+
+// Sin sonda, la adquisicion espera solo a que termine la transaccion del DHT11
+void test_dht_phases_without_probe() {
+  const SensorDrivers sinSonda = {nullptr, nullptr, nullptr, fake_dht_start, fake_dht_ready, fake_dht_result, nullptr};
+  Acquisition adquisicion;
+  acquisition_init(&adquisicion, &sinSonda, fake_clock);
+  acquisition_start(&adquisicion);
+  uint32_t consultas = poll_until_done(&adquisicion, 5);
+  TEST_ASSERT_EQUAL(1 + LECTURA_DHT / 5, consultas);
+  TEST_ASSERT_EQUAL(LECTURA_DHT, adquisicion.lastDuration);
+  TEST_ASSERT_EQUAL_FLOAT(48.0f, adquisicion.sample.humidityDHT);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_phases_overlap);
+  RUN_TEST(test_poll_does_not_block);
+  RUN_TEST(test_early_probe_completion);
+  RUN_TEST(test_probe_timeout);
+  RUN_TEST(test_node_without_probe);
+  RUN_TEST(test_dht_phases_do_not_block);
+  RUN_TEST(test_dht_phases_without_probe);
+  return UNITY_END();
+}
@@ -0,0 +1,270 @@
+/*
+///////////////// PRUEBAS DEL SUPERVISOR DE CONEXION \\\\\\\\\\\\\\\\\
+*/
+// Dos nodos con su propio supervisor (lib/connection) frente a un broker guionizado que,
+// como Mosquitto, expulsa la sesion abierta cuando otro cliente se conecta con el mismo
+// identificador, y que se puede caer y volver durante la prueba. El broker simulado de la
+// HAL (native/fake_hal) solo admite una conexion y un firmware por proceso, asi que aqui
+// se usa uno minimo con una sesion por nodo. El tiempo avanza en pasos de 10 ms.
+#include <conn_supervisor.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define NODOS 2
+#define PASO 10
+
+struct Nodo {
+  ConnSupervisor supervisor;
+  char clientId[24];
+  bool wifi;
+  bool sesion;
+  // Instantes de los intentos de conexion con el broker
+  uint32_t intentos[4096];
+  uint16_t numIntentos;
+};
+
+struct Broker {
+  bool activo;
+  // Sesiones expulsadas por otro cliente con el mismo identificador
+  uint32_t expulsiones;
+};
+
+static Nodo nodos[NODOS];
+static Broker broker;
+static uint32_t ahora = 0;
+
+// Generadores hardware independientes, uno por nodo
+static uint32_t semillas[NODOS];
+
+static uint32_t next_random(uint8_t nodo) {
+  semillas[nodo] = semillas[nodo] * 1664525UL + 1013904223UL;
+  return semillas[nodo];
+}
+
+static uint32_t random_0() {
+  return next_random(0);
+}
+
+static uint32_t random_1() {
+  return next_random(1);
+}
+
+static uint32_t (*const RANDOM[NODOS])() = {random_0, random_1};
+
+// CONNECT: con el broker caido se rechaza; si el identificador ya tiene sesion, esta se cierra
+static bool broker_connect(uint8_t nodo) {
+  if (!broker.activo) {
+    return false;
+  }
+  for (uint8_t otro = 0; otro < NODOS; otro++) {
+    if (otro != nodo && nodos[otro].sesion && strcmp(nodos[otro].clientId, nodos[nodo].clientId) == 0) {
+      nodos[otro].sesion = false;
+      broker.expulsiones++;
+    }
+  }
+  return true;
+}
+
+static void broker_set(bool activo) {
+  broker.activo = activo;
+  if (!activo) {
+    for (Nodo& nodo : nodos) {
+      nodo.sesion = false;
+    }
+  }
+}
+
+// Una pasada de la tarea de red de cada nodo, como wifi_supervise() y mqtt_reconnect()
+static void step() {
+  for (uint8_t i = 0; i < NODOS; i++) {
+    Nodo& nodo = nodos[i];
+    // Los reintentos de asociacion no cambian la red simulada
+    conn_wifi_update(&nodo.supervisor, ahora, nodo.wifi);
+    if (conn_mqtt_update(&nodo.supervisor, ahora, nodo.sesion)) {
+      if (nodo.numIntentos < sizeof(nodo.intentos) / sizeof(nodo.intentos[0])) {
+        nodo.intentos[nodo.numIntentos++] = ahora;
+      }
+      nodo.sesion = broker_connect(i);
+      conn_mqtt_result(&nodo.supervisor, ahora, nodo.sesion);
+    }
+  }
+}
+
+static void run(uint32_t ms) {
+  for (uint32_t fin = ahora + ms; ahora != fin; ahora += PASO) {
+    step();
+  }
+}
+
+static bool all_connected() {
+  for (const Nodo& nodo : nodos) {
+    if (!nodo.sesion || nodo.supervisor.state != CONN_CONECTADO) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Identificador como en node_mqtt.cpp: prefijo de la placa y 3 ultimos bytes de la MAC
+static void start_nodes(bool sharedId) {
+  const uint32_t chipIds[NODOS] = {0x1a2b3c, 0x4d5e6f};
+  for (uint8_t i = 0; i < NODOS; i++) {
+    Nodo& nodo = nodos[i];
+    memset(&nodo, 0, sizeof(nodo));
+    if (sharedId) {
+      // Identificador fijo anterior al supervisor, igual en las dos placas
+      strcpy(nodo.clientId, "nodemcu-client");
+    } else {
+      snprintf(nodo.clientId, sizeof(nodo.clientId), "%s-%06lx", i == 0 ? "esp32" : "nodemcu",
+               (unsigned long)chipIds[i]);
+    }
+    semillas[i] = chipIds[i];
+    nodo.wifi = true;
+    conn_init(&nodo.supervisor, ahora, RANDOM[i]);
+  }
+}
+
+void setUp() {
+  ahora = 1000;
+  broker.activo = true;
+  broker.expulsiones = 0;
+}
+
+void tearDown() {}
+
+// La espera crece como base * 2^intentos, sin bajar del minimo ni pasar del tope
+void test_backoff_window() {
+  Backoff backoff = {500, 1000, 60000, 0, 0};
+  for (uint8_t intento = 0; intento < 40; intento++) {
+    uint32_t ventana = intento < 6 ? 1000UL << intento : 60000;
+    TEST_ASSERT_EQUAL(intento, backoff.attempt);
+    uint8_t antes = backoff.attempt;
+    TEST_ASSERT_EQUAL(500, backoff_next(&backoff, 0));
+    backoff.attempt = antes;
+    TEST_ASSERT_EQUAL(ventana, backoff_next(&backoff, ventana - 500));
+    backoff.attempt = antes;
+    uint32_t espera = backoff_next(&backoff, 0xFFFFFFFFUL);
+    TEST_ASSERT_TRUE(espera >= 500 && espera <= ventana);
+  }
+}
+
+// Con el identificador compartido los nodos se expulsan sin parar aunque esperen entre
+// reintentos: el backoff no arregla la colision de identificadores
+void test_shared_client_id_thrashes() {
+  start_nodes(true);
+  run(600000);
+  char mensaje[96];
+  snprintf(mensaje, sizeof(mensaje), "identificador compartido: %u expulsiones en 10 min", broker.expulsiones);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_TRUE(broker.expulsiones > 100);
+}
+
+// Con identificadores propios los dos nodos se conectan una vez y no se molestan
+void test_unique_ids_converge() {
+  start_nodes(false);
+  TEST_ASSERT_TRUE(strcmp(nodos[0].clientId, nodos[1].clientId) != 0);
+  uint32_t inicio = ahora;
+  while (!all_connected()) {
+    run(PASO);
+    TEST_ASSERT_TRUE(ahora - inicio < CONN_MQTT_BACKOFF_BASE + PASO);
+  }
+  run(600000);
+
+  TEST_ASSERT_EQUAL(0, broker.expulsiones);
+  TEST_ASSERT_TRUE(all_connected());
+  for (const Nodo& nodo : nodos) {
+    TEST_ASSERT_EQUAL(1, nodo.supervisor.stats.mqttConnects);
+    TEST_ASSERT_EQUAL(1, nodo.supervisor.stats.mqttAttempts);
+    TEST_ASSERT_EQUAL(0, nodo.supervisor.stats.mqttLosses);
+  }
+}
+
+// Tras una caida del broker los nodos reintentan cada vez mas espaciados y sin coincidir,
+// y vuelven a converger cuando el broker vuelve
+void test_broker_restart_without_storm() {
+  start_nodes(false);
+  run(30000);
+  TEST_ASSERT_TRUE(all_connected());
+
+  const uint32_t CAIDA = 120000;
+  broker_set(false);
+  uint32_t caida = ahora;
+  run(CAIDA);
+  broker_set(true);
+  uint32_t vuelta = ahora;
+  while (!all_connected()) {
+    run(PASO);
+    // Como mucho una espera maxima despues de volver el broker
+    TEST_ASSERT_TRUE(ahora - vuelta <= CONN_MQTT_BACKOFF_MAX + PASO);
+  }
+  run(60000);
+  TEST_ASSERT_TRUE(all_connected());
+  TEST_ASSERT_EQUAL(0, broker.expulsiones);
+
+  for (const Nodo& nodo : nodos) {
+    const ConnStats& stats = nodo.supervisor.stats;
+    char mensaje[128];
+    snprintf(mensaje, sizeof(mensaje), "%s: %u intentos, %u fallidos, reconexion en %u ms", nodo.clientId,
+             stats.mqttAttempts, stats.mqttFailures, stats.lastLatency);
+    TEST_MESSAGE(mensaje);
+
+    // Espera exponencial: unos log2(CAIDA / base) reintentos mas los del tope, no uno por segundo
+    TEST_ASSERT_TRUE(stats.mqttFailures <= 10);
+    TEST_ASSERT_EQUAL(2, stats.mqttConnects);
+    TEST_ASSERT_EQUAL(1, stats.mqttLosses);
+    TEST_ASSERT_TRUE(stats.lastLatency >= CAIDA && stats.lastLatency == stats.maxLatency);
+  }
+
+  // El jitter completo evita que los dos nodos, caidos a la vez, reintenten a la vez
+  uint16_t coincidencias = 0;
+  for (uint16_t k = 0; k < nodos[0].numIntentos; k++) {
+    for (uint16_t m = 0; m < nodos[1].numIntentos; m++) {
+      if (nodos[0].intentos[k] >= caida && nodos[0].intentos[k] == nodos[1].intentos[m]) {
+        coincidencias++;
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(coincidencias <= 1);
+}
+
+// Sin WiFi no se intenta el broker: los fallos de cada nivel se cuentan por separado
+void test_wifi_and_broker_failures_are_separate() {
+  start_nodes(false);
+  run(10000);
+  TEST_ASSERT_TRUE(all_connected());
+
+  nodos[0].wifi = false;
+  nodos[0].sesion = false;
+  uint32_t intentos = nodos[0].supervisor.stats.mqttAttempts;
+  run(300000);
+  const ConnStats& stats = nodos[0].supervisor.stats;
+  TEST_ASSERT_EQUAL(CONN_SIN_WIFI, nodos[0].supervisor.state);
+  TEST_ASSERT_EQUAL(intentos, stats.mqttAttempts);
+  TEST_ASSERT_EQUAL(1, stats.wifiLosses);
+  TEST_ASSERT_EQUAL(1, stats.mqttLosses);
+  // Asociacion con espera exponencial: 300 s no dan para un reintento cada 5 s
+  TEST_ASSERT_TRUE(stats.wifiRetries >= 3 && stats.wifiRetries < 300000 / CONN_WIFI_BACKOFF_MIN);
+  // El otro nodo no se entera
+  TEST_ASSERT_TRUE(nodos[1].sesion);
+  TEST_ASSERT_EQUAL(1, nodos[1].supervisor.stats.mqttConnects);
+
+  // Al volver la WiFi el broker se reintenta desde la espera minima
+  nodos[0].wifi = true;
+  uint32_t vuelta = ahora;
+  while (!all_connected()) {
+    run(PASO);
+    TEST_ASSERT_TRUE(ahora - vuelta < CONN_MQTT_BACKOFF_BASE + 2 * PASO);
+  }
+  TEST_ASSERT_EQUAL(0, stats.mqttFailures);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_backoff_window);
+  RUN_TEST(test_shared_client_id_thrashes);
+  RUN_TEST(test_unique_ids_converge);
+  RUN_TEST(test_broker_restart_without_storm);
+  RUN_TEST(test_wifi_and_broker_failures_are_separate);
+  return UNITY_END();
+}
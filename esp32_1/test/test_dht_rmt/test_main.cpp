@@ -0,0 +1,263 @@
+/*
+///////////////// PRUEBAS DEL DHT11 CON EL RMT \\\\\\\\\\\\\\\\\
+*/
+// lib/dht_frame con formas de onda sinteticas en el formato de rmt_item32_t: ruido en la
+// duracion de los pulsos, capturas que empiezan antes o despues de la respuesta del sensor,
+// tramas cortadas, pulsos imposibles y sumas de comprobacion erroneas. Despues, el driver
+// dht_rmt sobre el RMT simulado de la HAL: la señal de inicio y la captura avanzan por fases
+// con dht_rmt_poll() y ninguna llamada espera (el reloj simulado solo avanza en la prueba).
+#include <Arduino.h>
+#include <chrono>
+#include <dht_frame.h>
+#include <dht_rmt.h>
+#include <fake_hal.h>
+#include <stdio.h>
+#include <unity.h>
+
+// Respuesta, 40 bits, pulso final y fin de captura: 85 pulsos en 43 elementos
+#define MAX_ELEMENTOS 44
+
+static const uint8_t PIN_DHT = 4;
+
+static uint32_t elementos[MAX_ELEMENTOS];
+static uint16_t numPulsos = 0;
+static uint32_t semilla = 1;
+
+// Duracion con un ruido uniforme de +-amplitud us
+static uint16_t jittered(uint16_t us, uint8_t amplitud) {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return amplitud == 0 ? us : (uint16_t)(us + (int32_t)((semilla >> 8) % (2 * amplitud + 1)) - amplitud);
+}
+
+// Añade un pulso: los pares se guardan en la mitad baja del elemento y los impares en la alta
+static void pulse(uint8_t nivel, uint16_t us) {
+  uint32_t mitad = (us & 0x7FFFUL) | ((uint32_t)nivel << 15);
+  if (numPulsos % 2 == 0) {
+    elementos[numPulsos / 2] = mitad;
+  } else {
+    elementos[numPulsos / 2] |= mitad << 16;
+  }
+  numPulsos++;
+}
+
+/**
+ * @brief Construye la captura de una trama en elementos[].
+ *
+ * @param datos Los 5 bytes de la trama.
+ * @param respuesta true si la captura incluye la respuesta del sensor; false si empieza tarde,
+ * en el ultimo pulso bajo de la respuesta.
+ * @param amplitud Ruido de cada pulso (+-us).
+ * @param bitLargo Bit con un pulso alto imposible, o -1.
+ * @return Numero de elementos.
+ */
+static size_t build_frame(const uint8_t datos[5], bool respuesta, uint8_t amplitud, int8_t bitLargo = -1) {
+  numPulsos = 0;
+  if (respuesta) {
+    pulse(1, jittered(20, amplitud));
+    pulse(0, jittered(80, amplitud));
+    pulse(1, jittered(80, amplitud));
+  } else {
+    pulse(0, jittered(30, amplitud));
+  }
+  for (int8_t bit = 0; bit < DHT_FRAME_BITS; bit++) {
+    bool uno = (datos[bit / 8] >> (7 - bit % 8)) & 1;
+    pulse(0, jittered(50, amplitud));
+    pulse(1, bit == bitLargo ? 300 : jittered(uno ? 70 : 27, amplitud));
+  }
+  pulse(0, jittered(50, amplitud));
+  pulse(1, 0);
+  return (numPulsos + 1) / 2;
+}
+
+// Trama de un DHT11 con 55 % de humedad y 22,3 ºC
+static void dht11_frame(uint8_t datos[5]) {
+  datos[0] = 55;
+  datos[1] = 0;
+  datos[2] = 22;
+  datos[3] = 3;
+  datos[4] = (uint8_t)(datos[0] + datos[1] + datos[2] + datos[3]);
+}
+
+// Consulta el driver cada paso ms hasta que termina la transaccion; devuelve las consultas
+static uint16_t poll_until_done(uint32_t paso) {
+  uint16_t consultas = 1;
+  while (!dht_rmt_poll()) {
+    hal_advance(paso);
+    consultas++;
+    TEST_ASSERT_TRUE(consultas < 1000);
+  }
+  return consultas;
+}
+
+void setUp() {
+  semilla = 1;
+  // Cada prueba del driver empieza fuera del intervalo minimo de la anterior
+  hal_advance(DHT_MIN_INTERVAL_MS);
+  hal_set_dht(4, 0);
+  hal_set_sensors(18.5f, 22.3f, 55.0f);
+}
+
+void tearDown() {}
+
+// Con hasta 15 us de ruido por pulso, y con la captura empezada antes o despues de la
+// respuesta, todas las tramas se decodifican bien
+void test_decode_with_jitter() {
+  uint8_t datos[5];
+  dht11_frame(datos);
+  for (uint8_t amplitud = 0; amplitud <= 15; amplitud += 5) {
+    for (uint16_t i = 0; i < 1000; i++) {
+      size_t n = build_frame(datos, i % 2 == 0, amplitud);
+      DhtReading lectura = {0, 0};
+      TEST_ASSERT_EQUAL(DHT_OK, dht_decode(elementos, n, DHT_MODEL_DHT11, &lectura));
+      TEST_ASSERT_EQUAL_FLOAT(22.3f, lectura.temperature);
+      TEST_ASSERT_EQUAL_FLOAT(55.0f, lectura.humidity);
+    }
+  }
+}
+
+// Tramas incompletas, con ruido o con la suma mal: error, y la lectura no cambia
+void test_decode_errors() {
+  uint8_t datos[5];
+  dht11_frame(datos);
+  DhtReading lectura = {1.0f, 2.0f};
+
+  size_t n = build_frame(datos, true, 0);
+  TEST_ASSERT_EQUAL(DHT_TIMEOUT, dht_decode(elementos, 15, DHT_MODEL_DHT11, &lectura));
+  TEST_ASSERT_EQUAL(DHT_TIMEOUT, dht_decode(elementos, 0, DHT_MODEL_DHT11, &lectura));
+
+  n = build_frame(datos, true, 0, 7);
+  TEST_ASSERT_EQUAL(DHT_BAD_PULSE, dht_decode(elementos, n, DHT_MODEL_DHT11, &lectura));
+
+  datos[4]++;
+  n = build_frame(datos, true, 0);
+  TEST_ASSERT_EQUAL(DHT_CHECKSUM, dht_decode(elementos, n, DHT_MODEL_DHT11, &lectura));
+
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, lectura.temperature);
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, lectura.humidity);
+}
+
+// Temperaturas bajo cero en los dos modelos y resolucion de decimas del DHT22
+void test_convert_models() {
+  DhtReading lectura;
+  // DHT11: parte entera desplazada en uno y signo en el bit alto de las decimas
+  uint8_t dht11[5] = {40, 0, 3, 0x85, 0};
+  dht11[4] = (uint8_t)(dht11[0] + dht11[1] + dht11[2] + dht11[3]);
+  TEST_ASSERT_EQUAL(DHT_OK, dht_convert(dht11, DHT_MODEL_DHT11, &lectura));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -3.5f, lectura.temperature);
+  TEST_ASSERT_EQUAL_FLOAT(40.0f, lectura.humidity);
+
+  // DHT22: decimas en 16 bits y signo en el bit alto de la temperatura
+  uint8_t dht22[5] = {0x02, 0x8C, 0x80, 0x65, 0};
+  dht22[4] = (uint8_t)(dht22[0] + dht22[1] + dht22[2] + dht22[3]);
+  TEST_ASSERT_EQUAL(DHT_OK, dht_convert(dht22, DHT_MODEL_DHT22, &lectura));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.1f, lectura.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.2f, lectura.humidity);
+}
+
+// Coste de decodificar una trama, fuera de la seccion critica que necesita Adafruit
+void test_decode_cost() {
+  uint8_t datos[5];
+  dht11_frame(datos);
+  size_t n = build_frame(datos, true, 5);
+  const uint32_t VUELTAS = 200000;
+  DhtReading lectura;
+  volatile float suma = 0;
+  auto inicio = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < VUELTAS; i++) {
+    dht_decode(elementos, n, DHT_MODEL_DHT11, &lectura);
+    suma = suma + lectura.temperature;
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  char mensaje[64];
+  snprintf(mensaje, sizeof(mensaje), "decodificacion: %.1f ns por trama", ns);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_TRUE(suma > 0);
+}
+
+// Ni el inicio ni las consultas esperan: la señal de inicio dura lo que tarda en pasar el
+// tiempo y la trama se recoge en la consulta siguiente a su llegada
+void test_driver_phases_do_not_block() {
+  dht_rmt_begin(PIN_DHT, DHT_MODEL_DHT11);
+  uint32_t transacciones = dht_rmt_stats().transactions;
+  unsigned long inicio = millis();
+
+  dht_rmt_start();
+  TEST_ASSERT_FALSE(dht_rmt_poll());
+  hal_advance(19);
+  TEST_ASSERT_FALSE(dht_rmt_poll());
+  // Fin de la señal de inicio: se libera la linea y empieza la captura
+  hal_advance(1);
+  TEST_ASSERT_FALSE(dht_rmt_poll());
+  hal_advance(5);
+  TEST_ASSERT_TRUE(dht_rmt_poll());
+  TEST_ASSERT_EQUAL_UINT32(inicio + 25, millis());
+
+  DhtReading lectura;
+  TEST_ASSERT_EQUAL(DHT_OK, dht_rmt_result(&lectura));
+  TEST_ASSERT_EQUAL_FLOAT(22.3f, lectura.temperature);
+  TEST_ASSERT_EQUAL_FLOAT(55.0f, lectura.humidity);
+  TEST_ASSERT_EQUAL(transacciones + 1, dht_rmt_stats().transactions);
+  // Sin transaccion en curso la consulta termina enseguida
+  TEST_ASSERT_TRUE(dht_rmt_poll());
+}
+
+// Con la tarea de adquisicion cada 50 ms la trama ya esta en el buffer del RMT al consultar
+void test_driver_with_scheduler_period() {
+  dht_rmt_begin(PIN_DHT, DHT_MODEL_DHT11);
+  hal_set_sensors(18.5f, 19.0f, 61.0f);
+  dht_rmt_start();
+  DhtReading lectura;
+  TEST_ASSERT_EQUAL(3, poll_until_done(50));
+  TEST_ASSERT_EQUAL(DHT_OK, dht_rmt_result(&lectura));
+  TEST_ASSERT_EQUAL_FLOAT(19.0f, lectura.temperature);
+  TEST_ASSERT_EQUAL_FLOAT(61.0f, lectura.humidity);
+}
+
+// Dentro del intervalo minimo no hay transaccion: se sirve la lectura anterior
+void test_driver_min_interval() {
+  dht_rmt_begin(PIN_DHT, DHT_MODEL_DHT11);
+  dht_rmt_start();
+  poll_until_done(1);
+  DhtStats antes = dht_rmt_stats();
+
+  hal_set_sensors(18.5f, 30.0f, 20.0f);
+  dht_rmt_start();
+  TEST_ASSERT_TRUE(dht_rmt_poll());
+  DhtReading lectura;
+  TEST_ASSERT_EQUAL(DHT_OK, dht_rmt_result(&lectura));
+  TEST_ASSERT_EQUAL_FLOAT(22.3f, lectura.temperature);
+  TEST_ASSERT_EQUAL(antes.transactions, dht_rmt_stats().transactions);
+  TEST_ASSERT_EQUAL(antes.cached + 1, dht_rmt_stats().cached);
+}
+
+// Una trama corrupta cuenta como error y conserva la ultima lectura valida
+void test_driver_corrupt_frame() {
+  dht_rmt_begin(PIN_DHT, DHT_MODEL_DHT11);
+  dht_rmt_start();
+  poll_until_done(1);
+  uint32_t errores = dht_rmt_stats().errors;
+
+  hal_advance(DHT_MIN_INTERVAL_MS);
+  hal_set_dht(4, 1);
+  hal_set_sensors(18.5f, 30.0f, 20.0f);
+  dht_rmt_start();
+  poll_until_done(1);
+  DhtReading lectura;
+  TEST_ASSERT_EQUAL(DHT_CHECKSUM, dht_rmt_result(&lectura));
+  TEST_ASSERT_EQUAL_FLOAT(22.3f, lectura.temperature);
+  TEST_ASSERT_EQUAL(errores + 1, dht_rmt_stats().errors);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_with_jitter);
+  RUN_TEST(test_decode_errors);
+  RUN_TEST(test_convert_models);
+  RUN_TEST(test_decode_cost);
+  RUN_TEST(test_driver_phases_do_not_block);
+  RUN_TEST(test_driver_with_scheduler_period);
+  RUN_TEST(test_driver_min_interval);
+  RUN_TEST(test_driver_corrupt_frame);
+  return UNITY_END();
+}
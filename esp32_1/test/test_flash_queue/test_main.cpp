@@ -0,0 +1,469 @@
+/*
+///////////////// PRUEBAS DE LA COLA PERSISTENTE \\\\\\\\\\\\\\\\\
+*/
+// La cola se guarda en un sistema de ficheros en RAM que cuenta las operaciones y puede
+// simular un corte de alimentacion: una escritura que se queda a medias o unos punteros
+// dañados. Un "reinicio" es otra FlashQueue sobre el mismo almacenamiento.
+#include <flash_queue.h>
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+class RamStorage : public QueueStorage {
+public:
+  std::map<std::string, std::vector<uint8_t>> files;
+  // Bytes que llegan a escribirse en el siguiente append() antes del corte (-1: sin corte)
+  long cutAfter = -1;
+  // Con cutAtRemove, copia de los ficheros al llegar al siguiente remove(): lo que queda si
+  // se corta la alimentacion justo antes de borrar
+  bool cutAtRemove = false;
+  std::map<std::string, std::vector<uint8_t>> beforeRemove;
+  uint32_t reads = 0;
+  uint32_t appends = 0;
+  uint32_t writes = 0;
+  uint32_t removes = 0;
+  uint64_t bytesWritten = 0;
+
+  long size(const char* path) override {
+    auto f = files.find(path);
+    return f == files.end() ? -1 : (long)f->second.size();
+  }
+
+  size_t read(const char* path, uint32_t offset, uint8_t* buffer, size_t len) override {
+    reads++;
+    auto f = files.find(path);
+    if (f == files.end() || offset >= f->second.size()) {
+      return 0;
+    }
+    size_t n = f->second.size() - offset < len ? f->second.size() - offset : len;
+    memcpy(buffer, f->second.data() + offset, n);
+    return n;
+  }
+
+  bool append(const char* path, const uint8_t* data, size_t len) override {
+    appends++;
+    std::vector<uint8_t>& f = files[path];
+    if (cutAfter >= 0) {
+      size_t n = (size_t)cutAfter < len ? (size_t)cutAfter : len;
+      f.insert(f.end(), data, data + n);
+      bytesWritten += n;
+      cutAfter = -1;
+      return false;
+    }
+    f.insert(f.end(), data, data + len);
+    bytesWritten += len;
+    return true;
+  }
+
+  bool write(const char* path, const uint8_t* data, size_t len) override {
+    writes++;
+    files[path].assign(data, data + len);
+    bytesWritten += len;
+    return true;
+  }
+
+  bool remove(const char* path) override {
+    if (cutAtRemove) {
+      beforeRemove = files;
+      cutAtRemove = false;
+    }
+    removes++;
+    return files.erase(path) > 0;
+  }
+
+  size_t segments() const {
+    size_t n = 0;
+    for (const auto& f : files) {
+      n += f.first.find("/meta") == std::string::npos;
+    }
+    return n;
+  }
+};
+
+static RamStorage* fs;
+static const char* TOPIC = "esp32_1/params";
+
+static bool push(FlashQueue& cola, uint32_t valor, uint32_t epoch = 0) {
+  char payload[32];
+  int len = snprintf(payload, sizeof(payload), "{\"v\":%lu}", (unsigned long)valor);
+  return cola.push(TOPIC, (const uint8_t*)payload, len, valor, epoch);
+}
+
+// Valor guardado en un registro por push()
+static uint32_t value_of(const QueueEntry& entrada) {
+  unsigned long valor = 0;
+  TEST_ASSERT_EQUAL(1, sscanf((const char*)entrada.payload, "{\"v\":%lu}", &valor));
+  return valor;
+}
+
+// Entrega y confirma todos los registros; devuelve los valores en orden
+static std::vector<uint32_t> drain(FlashQueue& cola) {
+  std::vector<uint32_t> valores;
+  QueueEntry entrada;
+  while (cola.peek(entrada)) {
+    valores.push_back(value_of(entrada));
+    cola.next();
+    cola.pop();
+  }
+  // Los entregados antes de llamar a drain()
+  while (cola.delivered() > 0) {
+    cola.pop();
+  }
+  return valores;
+}
+
+// Una sola escritura de los punteros en curso no tiene por que haber terminado: la copia
+// mas reciente es la del numero de secuencia mas alto
+static std::string newest_meta() {
+  uint32_t seq[2] = {0, 0};
+  for (int slot = 0; slot < 2; slot++) {
+    auto f = fs->files.find(std::string("/sf/meta") + (char)('0' + slot));
+    if (f != fs->files.end() && f->second.size() >= 8) {
+      memcpy(&seq[slot], f->second.data() + 4, sizeof(seq[slot]));
+    }
+  }
+  return std::string("/sf/meta") + (seq[1] > seq[0] ? '1' : '0');
+}
+
+void setUp() {
+  fs = new RamStorage();
+}
+
+void tearDown() {
+  delete fs;
+}
+
+// Los registros salen en orden; los entregados no se extraen hasta su pop()
+void test_fifo_and_ack_cursor() {
+  FlashQueue cola(*fs);
+  cola.begin();
+  for (uint32_t i = 0; i < 20; i++) {
+    TEST_ASSERT_TRUE(push(cola, i));
+  }
+
+  QueueEntry entrada;
+  for (uint32_t i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(cola.peek(entrada));
+    TEST_ASSERT_EQUAL_UINT32(i, value_of(entrada));
+    TEST_ASSERT_EQUAL_STRING(TOPIC, entrada.topic);
+    cola.next();
+  }
+  TEST_ASSERT_EQUAL(4, cola.delivered());
+  TEST_ASSERT_EQUAL(20, cola.size());
+
+  // Confirmadas las dos primeras, la lectura sigue donde estaba
+  cola.pop();
+  cola.pop();
+  TEST_ASSERT_EQUAL(18, cola.size());
+  TEST_ASSERT_EQUAL(2, cola.delivered());
+  TEST_ASSERT_TRUE(cola.peek(entrada));
+  TEST_ASSERT_EQUAL_UINT32(4, value_of(entrada));
+
+  // Sin registros entregados pop() no extrae el siguiente
+  cola.pop();
+  cola.pop();
+  cola.pop();
+  TEST_ASSERT_EQUAL(16, cola.size());
+  TEST_ASSERT_EQUAL(0, cola.delivered());
+  TEST_ASSERT_TRUE(cola.peek(entrada));
+  TEST_ASSERT_EQUAL_UINT32(4, value_of(entrada));
+}
+
+// Tras un reinicio se vuelven a entregar los registros enviados sin confirmar
+void test_unacked_records_survive_reboot() {
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    for (uint32_t i = 0; i < 30; i++) {
+      push(cola, i);
+    }
+    QueueEntry entrada;
+    for (uint32_t i = 0; i < 12; i++) {
+      cola.peek(entrada);
+      cola.next();
+    }
+    for (uint32_t i = 0; i < 10; i++) {
+      cola.pop();
+    }
+  }
+
+  FlashQueue cola(*fs);
+  cola.begin();
+  // Los punteros se guardan cada FLASH_QUEUE_COMMIT_EVERY registros: se repiten los
+  // confirmados despues del ultimo guardado, nunca se pierde uno
+  uint32_t guardados = 10 / FLASH_QUEUE_COMMIT_EVERY * FLASH_QUEUE_COMMIT_EVERY;
+  TEST_ASSERT_EQUAL(30 - guardados, cola.size());
+  std::vector<uint32_t> valores = drain(cola);
+  TEST_ASSERT_EQUAL(30 - guardados, valores.size());
+  for (size_t i = 0; i < valores.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(guardados + i, valores[i]);
+  }
+  TEST_ASSERT_TRUE(cola.empty());
+  TEST_ASSERT_EQUAL(0, fs->segments());
+}
+
+// Una escritura cortada a medias se salta: no se pierde lo anterior ni lo posterior
+void test_torn_write_recovery() {
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    for (uint32_t i = 0; i < 5; i++) {
+      push(cola, i);
+    }
+    fs->cutAfter = 10;
+    TEST_ASSERT_FALSE(push(cola, 99));
+    // Sin reiniciar, los registros nuevos van a otro segmento
+    push(cola, 5);
+    TEST_ASSERT_EQUAL(6, cola.size());
+  }
+
+  FlashQueue cola(*fs);
+  cola.begin();
+  TEST_ASSERT_EQUAL(6, cola.size());
+  push(cola, 6);
+  std::vector<uint32_t> valores = drain(cola);
+  TEST_ASSERT_EQUAL(7, valores.size());
+  for (uint32_t i = 0; i < 7; i++) {
+    TEST_ASSERT_EQUAL_UINT32(i, valores[i]);
+  }
+}
+
+// Corte de alimentacion durante el append, sin llegar a volver de push(): el arranque
+// encuentra el registro incompleto al final del ultimo segmento
+void test_power_loss_during_append() {
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    for (uint32_t i = 0; i < 3; i++) {
+      push(cola, i);
+    }
+  }
+  // Cualquier longitud del registro cortado: cabecera incompleta, sin payload, sin CRC
+  std::vector<uint8_t>& segmento = fs->files["/sf/0"];
+  std::vector<uint8_t> copia = segmento;
+  const size_t cortes[] = {1, 6, 16, 20, 30};
+  for (size_t corte : cortes) {
+    segmento = copia;
+    segmento.insert(segmento.end(), copia.begin(), copia.begin() + corte);
+
+    FlashQueue cola(*fs);
+    cola.begin();
+    TEST_ASSERT_EQUAL(3, cola.size());
+    push(cola, 3);
+    QueueEntry entrada;
+    for (uint32_t i = 0; i < 4; i++) {
+      TEST_ASSERT_TRUE(cola.peek(entrada));
+      TEST_ASSERT_EQUAL_UINT32(i, value_of(entrada));
+      cola.next();
+    }
+    TEST_ASSERT_FALSE(cola.peek(entrada));
+    // El registro de esta vuelta se descarta para la siguiente
+    fs->files.erase("/sf/1");
+  }
+}
+
+// Si la ultima copia de los punteros esta dañada se usa la anterior: se repiten registros,
+// no se pierden
+void test_meta_slot_fallback() {
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    for (uint32_t i = 0; i < 40; i++) {
+      push(cola, i);
+    }
+    QueueEntry entrada;
+    for (uint32_t i = 0; i < 2 * FLASH_QUEUE_COMMIT_EVERY; i++) {
+      cola.peek(entrada);
+      cola.next();
+      cola.pop();
+    }
+  }
+
+  // Escritura de los punteros cortada: CRC incorrecto
+  std::vector<uint8_t>& meta = fs->files[newest_meta()];
+  meta[12] ^= 0x5A;
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    TEST_ASSERT_EQUAL(40 - FLASH_QUEUE_COMMIT_EVERY, cola.size());
+    QueueEntry entrada;
+    TEST_ASSERT_TRUE(cola.peek(entrada));
+    TEST_ASSERT_EQUAL_UINT32(FLASH_QUEUE_COMMIT_EVERY, value_of(entrada));
+  }
+
+  // Copia truncada: tampoco se usa
+  fs->files[newest_meta()].resize(6);
+  FlashQueue cola(*fs);
+  cola.begin();
+  std::vector<uint32_t> valores = drain(cola);
+  TEST_ASSERT_EQUAL(40 - FLASH_QUEUE_COMMIT_EVERY, valores.size());
+  TEST_ASSERT_EQUAL_UINT32(FLASH_QUEUE_COMMIT_EVERY, valores.front());
+  TEST_ASSERT_EQUAL_UINT32(39, valores.back());
+}
+
+// Corte de alimentacion al consumir un segmento, entre guardar los punteros y borrarlo: el
+// arranque borra el segmento sobrante y no pierde ni repite registros. Si los punteros que se
+// recuperan apuntan a un segmento ya borrado, se sigue por el siguiente
+void test_power_loss_during_segment_release() {
+  uint8_t grande[FLASH_QUEUE_MAX_PAYLOAD];
+  memset(grande, ' ', sizeof(grande));
+  const uint32_t N = 43;
+  uint32_t extraidos = 0;
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    for (uint32_t i = 0; i < N; i++) {
+      // Registros grandes para que ocupen varios segmentos
+      int len = snprintf((char*)grande, sizeof(grande), "{\"v\":%lu}", (unsigned long)i);
+      grande[len] = ' ';
+      TEST_ASSERT_TRUE(cola.push(TOPIC, grande, sizeof(grande), i));
+    }
+    TEST_ASSERT_TRUE(fs->segments() > 2);
+    fs->cutAtRemove = true;
+    QueueEntry entrada;
+    while (fs->cutAtRemove && cola.peek(entrada)) {
+      cola.next();
+      cola.pop();
+      extraidos++;
+    }
+    TEST_ASSERT_FALSE(fs->cutAtRemove);
+  }
+  std::map<std::string, std::vector<uint8_t>> corte = fs->beforeRemove;
+  size_t segmentos = 0;
+  for (const auto& f : corte) {
+    segmentos += f.first.find("/meta") == std::string::npos;
+  }
+
+  fs->files = corte;
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    TEST_ASSERT_EQUAL(N - extraidos, cola.size());
+    TEST_ASSERT_EQUAL(segmentos - 1, fs->segments());
+    std::vector<uint32_t> valores = drain(cola);
+    TEST_ASSERT_EQUAL(N - extraidos, valores.size());
+    TEST_ASSERT_EQUAL_UINT32(extraidos, valores.front());
+    TEST_ASSERT_EQUAL_UINT32(N - 1, valores.back());
+  }
+
+  // Punteros anteriores al paso de segmento (la ultima copia dañada) con el segmento ya borrado
+  fs->files = corte;
+  fs->files.erase("/sf/0");
+  fs->files[newest_meta()][12] ^= 0x5A;
+  FlashQueue cola(*fs);
+  cola.begin();
+  TEST_ASSERT_EQUAL(N - extraidos, cola.size());
+  std::vector<uint32_t> valores = drain(cola);
+  TEST_ASSERT_EQUAL(N - extraidos, valores.size());
+  TEST_ASSERT_EQUAL_UINT32(extraidos, valores.front());
+  TEST_ASSERT_EQUAL_UINT32(N - 1, valores.back());
+  // Los registros nuevos no reutilizan los segmentos que siguen en la cola
+  TEST_ASSERT_TRUE(push(cola, N));
+  TEST_ASSERT_EQUAL(1, cola.size());
+}
+
+// Con el reloj sincronizado el registro guarda la hora UTC; si no, el instante local, que solo
+// vale en el mismo arranque
+void test_dated_records() {
+  {
+    FlashQueue cola(*fs);
+    cola.begin();
+    push(cola, 1000);
+    push(cola, 2000, 1760000000);
+    QueueEntry entrada;
+    TEST_ASSERT_TRUE(cola.peek(entrada));
+    TEST_ASSERT_EQUAL_UINT32(1000, entrada.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(0, entrada.epoch);
+    TEST_ASSERT_TRUE(entrada.sameBoot);
+  }
+
+  FlashQueue cola(*fs);
+  cola.begin();
+  QueueEntry entrada;
+  TEST_ASSERT_TRUE(cola.peek(entrada));
+  TEST_ASSERT_FALSE(entrada.sameBoot);
+  TEST_ASSERT_EQUAL_UINT32(0, entrada.epoch);
+  cola.next();
+  TEST_ASSERT_TRUE(cola.peek(entrada));
+  TEST_ASSERT_FALSE(entrada.sameBoot);
+  TEST_ASSERT_EQUAL_UINT32(1760000000, entrada.epoch);
+}
+
+// Al llenarse se descarta el segmento mas antiguo, tambien con registros entregados en el
+void test_capacity_drops_oldest_segment() {
+  FlashQueue cola(*fs);
+  cola.begin();
+  QueueEntry entrada;
+  push(cola, 0);
+  TEST_ASSERT_TRUE(cola.peek(entrada));
+  cola.next();
+
+  uint8_t grande[FLASH_QUEUE_MAX_PAYLOAD];
+  memset(grande, 'x', sizeof(grande));
+  uint32_t escritos = 1;
+  while (cola.dropped() == 0) {
+    TEST_ASSERT_TRUE(cola.push(TOPIC, grande, sizeof(grande), escritos++));
+  }
+  TEST_ASSERT_EQUAL(0, cola.delivered());
+  TEST_ASSERT_EQUAL(escritos - cola.dropped(), cola.size());
+  TEST_ASSERT_TRUE(fs->segments() <= FLASH_QUEUE_MAX_SEGMENTS);
+  // La confirmacion del registro descartado no extrae otro
+  cola.pop();
+  TEST_ASSERT_EQUAL(escritos - cola.dropped(), cola.size());
+}
+
+// Ritmo de escritura y de vaciado, y operaciones de flash por registro
+void test_throughput() {
+  const uint32_t N = 20000;
+  FlashQueue cola(*fs);
+  cola.begin();
+  uint32_t metaInicial = fs->writes;
+
+  auto inicio = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < N; i++) {
+    push(cola, i);
+    // Vaciado como mqtt_drain(): hasta 4 en vuelo y confirmacion en orden, con un retraso de
+    // unos pocos registros respecto a la escritura
+    QueueEntry entrada;
+    if (i >= 16) {
+      while (cola.delivered() < 4 && cola.peek(entrada)) {
+        cola.next();
+      }
+      cola.pop();
+    }
+  }
+  std::vector<uint32_t> resto = drain(cola);
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  TEST_ASSERT_TRUE(cola.empty());
+  TEST_ASSERT_EQUAL_UINT32(N - 1, resto.back());
+  TEST_ASSERT_EQUAL(0, cola.dropped());
+  // Un append por registro; los punteros, cada FLASH_QUEUE_COMMIT_EVERY o al cambiar de
+  // segmento
+  TEST_ASSERT_EQUAL_UINT32(N, fs->appends);
+  uint32_t metas = fs->writes - metaInicial;
+  TEST_ASSERT_TRUE(metas <= N / FLASH_QUEUE_COMMIT_EVERY + fs->removes + 1);
+
+  char mensaje[160];
+  snprintf(mensaje, sizeof(mensaje), "%lu registros en %.3f s (%.0f/s), %.2f lecturas y %.3f escrituras de punteros por registro",
+           (unsigned long)N, segundos, N / segundos, (double)fs->reads / N, (double)metas / N);
+  TEST_MESSAGE(mensaje);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_and_ack_cursor);
+  RUN_TEST(test_unacked_records_survive_reboot);
+  RUN_TEST(test_torn_write_recovery);
+  RUN_TEST(test_power_loss_during_append);
+  RUN_TEST(test_meta_slot_fallback);
+  RUN_TEST(test_power_loss_during_segment_release);
+  RUN_TEST(test_dated_records);
+  RUN_TEST(test_capacity_drops_oldest_segment);
+  RUN_TEST(test_throughput);
+  return UNITY_END();
+}
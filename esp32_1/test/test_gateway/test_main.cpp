@@ -0,0 +1,299 @@
+/*
+///////////////// PRUEBAS DE LA PASARELA ESP-NOW \\\\\\\\\\\\\\\\\
+*/
+// lib/sensor_link y lib/gateway sin radio: tramas codificadas por el nodo que la pasarela
+// decodifica igual, tramas mal formadas que se descartan sin crear nodos, y tramas
+// aleatorias o con bits cambiados que no deben leer fuera de la trama. Conviene ejecutarla
+// con el entorno native_asan (AddressSanitizer y UndefinedBehaviorSanitizer).
+#include <gateway.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+static uint32_t semilla = 1;
+
+static uint32_t next_random() {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return semilla;
+}
+
+static SensorSample make_sample(float sonda, float temperatura, int16_t capacitor, float humedad) {
+  SensorSample lectura;
+  lectura.timestamp = 0;
+  lectura.temperatureProbe = sonda;
+  lectura.temperatureDHT = temperatura;
+  lectura.humidityCapacitor = capacitor;
+  lectura.humidityDHT = humedad;
+  return lectura;
+}
+
+static LinkFrame make_frame(const char* nodo, uint32_t session, uint32_t seq, const SensorSample& lectura) {
+  LinkFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.session = session;
+  frame.seq = seq;
+  frame.age = 120;
+  frame.sample = lectura;
+  strncpy(frame.node, nodo, LINK_NODE_SIZE - 1);
+  return frame;
+}
+
+static LinkPacket make_packet(const LinkFrame& frame, uint32_t receivedAt) {
+  LinkPacket packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.mac[5] = 0x42;
+  packet.rssi = -61;
+  packet.receivedAt = receivedAt;
+  packet.len = (uint8_t)link_frame_encode(frame, packet.data, sizeof(packet.data));
+  return packet;
+}
+
+// Mismo valor, o los dos sin valor
+static void assert_channel(float esperado, float valor) {
+  if (isnan(esperado)) {
+    TEST_ASSERT_TRUE(isnan(valor));
+  } else {
+    TEST_ASSERT_FLOAT_WITHIN(0.051f, esperado, valor);
+  }
+}
+
+// Valor que admite la trama: decimas saturadas al rango de int16 (NAN sigue sin valor)
+static float saturated(float valor) {
+  return isnan(valor) ? NAN : fminf(fmaxf(valor, -3276.7f), 3276.7f);
+}
+
+void setUp() {
+  semilla = 1;
+}
+
+void tearDown() {}
+
+// Lo que codifica el nodo se decodifica igual en la pasarela, con canales ausentes,
+// temperaturas bajo cero y valores fuera del rango de int16 saturados
+void test_frame_round_trip() {
+  const SensorSample lecturas[] = {
+      make_sample(21.5f, 22.3f, 57, 48.0f),
+      make_sample(NAN, -7.4f, SAMPLE_NO_HUMIDITY, NAN),
+      make_sample(-12.25f, NAN, 0, 99.9f),
+      make_sample(5000.0f, -5000.0f, 1023, 0.0f),
+  };
+  uint32_t secuencia = 0xFFFFFFF0UL;
+  for (const SensorSample& lectura : lecturas) {
+    LinkFrame frame = make_frame("esp32_1", 0xA5A5F00DUL, secuencia++, lectura);
+    frame.attempt = 2;
+    uint8_t trama[LINK_FRAME_SIZE];
+    TEST_ASSERT_EQUAL(LINK_FRAME_SIZE, link_frame_encode(frame, trama, sizeof(trama)));
+
+    LinkFrame decodificada;
+    TEST_ASSERT_TRUE(link_frame_decode(trama, sizeof(trama), &decodificada));
+    TEST_ASSERT_EQUAL(2, decodificada.attempt);
+    TEST_ASSERT_EQUAL_UINT32(frame.session, decodificada.session);
+    TEST_ASSERT_EQUAL_UINT32(frame.seq, decodificada.seq);
+    TEST_ASSERT_EQUAL_UINT32(120, decodificada.age);
+    TEST_ASSERT_EQUAL_STRING("esp32_1", decodificada.node);
+    TEST_ASSERT_EQUAL_UINT32(0, decodificada.sample.timestamp);
+    assert_channel(saturated(lectura.temperatureProbe), decodificada.sample.temperatureProbe);
+    assert_channel(saturated(lectura.temperatureDHT), decodificada.sample.temperatureDHT);
+    assert_channel(lectura.humidityDHT, decodificada.sample.humidityDHT);
+    TEST_ASSERT_EQUAL(lectura.humidityCapacitor, decodificada.sample.humidityCapacitor);
+  }
+
+  // Nombre largo: se trunca y sigue terminado en NUL
+  LinkFrame largo = make_frame("", 1, 1, lecturas[0]);
+  memset(largo.node, 'n', LINK_NODE_SIZE);
+  uint8_t trama[LINK_FRAME_SIZE];
+  TEST_ASSERT_EQUAL(0, link_frame_encode(largo, trama, LINK_FRAME_SIZE - 1));
+  link_frame_encode(largo, trama, sizeof(trama));
+  LinkFrame decodificada;
+  TEST_ASSERT_TRUE(link_frame_decode(trama, sizeof(trama), &decodificada));
+  TEST_ASSERT_EQUAL(LINK_NODE_SIZE - 1, strlen(decodificada.node));
+}
+
+// Longitud, version, tipo o nombre invalidos: la trama se descarta y no crea ningun nodo
+void test_malformed_frames_rejected() {
+  Gateway pasarela;
+  gateway_init(&pasarela, 4, 60000);
+  LinkPacket valida = make_packet(make_frame("nodemcu_1", 7, 1, make_sample(NAN, 20.0f, 40, 50.0f)), 1000);
+
+  const uint8_t longitudes[] = {0, 1, LINK_FRAME_SIZE - 1, LINK_FRAME_SIZE + 1, 255};
+  for (uint8_t len : longitudes) {
+    LinkPacket packet = valida;
+    packet.len = len;
+    TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+  }
+
+  LinkPacket packet = valida;
+  packet.data[0] = 0xB1;
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+  packet = valida;
+  packet.data[1] = 2;
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+
+  // Nombre vacio, sin terminador o con caracteres que cambiarian el topic
+  packet = valida;
+  packet.data[24] = '\0';
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+  packet = valida;
+  memset(packet.data + 24, 'x', LINK_NODE_SIZE);
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+  const char prohibidos[] = {'/', '+', '#'};
+  for (char c : prohibidos) {
+    packet = valida;
+    packet.data[24 + 3] = (uint8_t)c;
+    TEST_ASSERT_NULL(gateway_accept(&pasarela, packet));
+  }
+
+  TEST_ASSERT_EQUAL(0, pasarela.count);
+  TEST_ASSERT_EQUAL(12, pasarela.stats.invalid);
+  TEST_ASSERT_EQUAL(0, pasarela.stats.accepted);
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, valida));
+  TEST_ASSERT_EQUAL(1, pasarela.count);
+}
+
+// Tramas aleatorias y tramas validas con bits cambiados: ninguna lee fuera de la trama ni
+// crea un nodo con un nombre que no sirva de prefijo de topic
+void test_random_and_corrupted_frames() {
+  Gateway pasarela;
+  gateway_init(&pasarela, 4, 60000);
+  LinkPacket valida = make_packet(make_frame("esp32_1", 99, 1, make_sample(18.5f, 22.0f, 57, 55.0f)), 0);
+  const uint32_t TRAMAS = 200000;
+
+  for (uint32_t i = 0; i < TRAMAS; i++) {
+    LinkPacket packet;
+    if (i % 2 == 0) {
+      packet = valida;
+      // Entre 1 y 8 bits cambiados en cualquier posicion
+      uint32_t cambios = 1 + next_random() % 8;
+      for (uint32_t k = 0; k < cambios; k++) {
+        uint32_t bit = next_random() % (LINK_FRAME_SIZE * 8);
+        packet.data[bit / 8] ^= (uint8_t)(1 << bit % 8);
+      }
+    } else {
+      memset(&packet, 0, sizeof(packet));
+      for (uint8_t k = 0; k < LINK_FRAME_SIZE; k++) {
+        packet.data[k] = (uint8_t)(next_random() >> 24);
+      }
+      // Casi siempre con la cabecera buena, para llegar al nombre y a la deduplicacion
+      if (next_random() % 4 != 0) {
+        packet.data[0] = LINK_FRAME_V1;
+        packet.data[1] = LINK_FRAME_SAMPLE;
+      }
+      packet.len = next_random() % 8 == 0 ? (uint8_t)(next_random() >> 24) : LINK_FRAME_SIZE;
+    }
+    packet.receivedAt = i;
+    GatewayLeaf* leaf = gateway_accept(&pasarela, packet);
+    if (leaf != nullptr && gateway_batch_ready(leaf, i)) {
+      uint8_t mensaje[256];
+      gateway_encode_batch(&pasarela, leaf, i, nullptr, mensaje, sizeof(mensaje));
+    }
+  }
+
+  const GatewayStats& stats = pasarela.stats;
+  TEST_ASSERT_EQUAL_UINT32(TRAMAS, stats.received);
+  TEST_ASSERT_EQUAL_UINT32(stats.received, stats.accepted + stats.duplicates + stats.stale + stats.invalid +
+                                               stats.rejected);
+  TEST_ASSERT_TRUE(stats.invalid > 0 && stats.accepted > 0);
+  TEST_ASSERT_EQUAL(GATEWAY_MAX_LEAVES, pasarela.count);
+  for (uint8_t i = 0; i < pasarela.count; i++) {
+    const char* nodo = pasarela.leaves[i].node;
+    size_t n = strnlen(nodo, LINK_NODE_SIZE);
+    TEST_ASSERT_TRUE(n > 0 && n < LINK_NODE_SIZE);
+    TEST_ASSERT_NULL(strpbrk(nodo, "/+#"));
+  }
+}
+
+// Reintentos con la misma secuencia, tramas fuera de orden, tramas demasiado antiguas y
+// un arranque en frio del nodo (sesion nueva)
+void test_dedup_and_batches() {
+  Gateway pasarela;
+  gateway_init(&pasarela, 3, 60000);
+  SensorSample lectura = make_sample(NAN, 21.0f, 60, 45.0f);
+
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 5, 40, lectura), 10000)));
+  LinkFrame reintento = make_frame("nodemcu_1", 5, 40, lectura);
+  reintento.attempt = 1;
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, make_packet(reintento, 10010)));
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 5, 42, lectura), 10020)));
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 5, 41, lectura), 10030)));
+  TEST_ASSERT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 5, 42 - LINK_DEDUP_WINDOW, lectura),
+                                                         10040)));
+  GatewayLeaf* leaf = &pasarela.leaves[0];
+  TEST_ASSERT_EQUAL(1, leaf->duplicates);
+  TEST_ASSERT_EQUAL(1, leaf->stale);
+  TEST_ASSERT_EQUAL(3, leaf->frames);
+
+  // Lote completo: se publica en el topic del nodo y se vacia
+  TEST_ASSERT_TRUE(gateway_batch_ready(leaf, 10050));
+  uint8_t mensaje[256];
+  TEST_ASSERT_TRUE(gateway_encode_batch(&pasarela, leaf, 10050, nullptr, mensaje, sizeof(mensaje)) > 0);
+  TEST_ASSERT_EQUAL(0, leaf->batch.count);
+  char topic[40];
+  TEST_ASSERT_TRUE(gateway_topic(leaf, "params", topic, sizeof(topic)));
+  TEST_ASSERT_EQUAL_STRING("nodemcu_1/params", topic);
+  TEST_ASSERT_FALSE(gateway_topic(leaf, "params", topic, 12));
+
+  // Sesion nueva: la secuencia vuelve a empezar y no se toma por antigua
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 6, 1, lectura), 20000)));
+  TEST_ASSERT_EQUAL(1, pasarela.count);
+  // Una lectura con una edad que la pondria antes que la anterior no retrocede
+  LinkFrame atrasada = make_frame("nodemcu_1", 6, 2, lectura);
+  atrasada.age = 50000;
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(atrasada, 20010)));
+  TEST_ASSERT_EQUAL_UINT32(leaf->batch.samples[0].timestamp, leaf->batch.samples[1].timestamp);
+}
+
+// Sin publicar, el lote lleno descarta la lectura mas antigua y lo cuenta. Un lote que no cabe
+// en el buffer no se vacia
+void test_batch_full_and_encode_failure() {
+  Gateway pasarela;
+  gateway_init(&pasarela, 2, 60000);
+  SensorSample lectura = make_sample(NAN, 21.0f, 60, 45.0f);
+  for (uint32_t seq = 1; seq <= 5; seq++) {
+    TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("nodemcu_1", 1, seq, lectura), 1000 + seq)));
+  }
+  GatewayLeaf* leaf = &pasarela.leaves[0];
+  TEST_ASSERT_EQUAL(2, leaf->batch.count);
+  TEST_ASSERT_EQUAL(3, leaf->evicted);
+  TEST_ASSERT_EQUAL(3, pasarela.stats.evicted);
+  // Quedan las dos ultimas (recepcion menos la edad de la trama)
+  TEST_ASSERT_EQUAL_UINT32(1004 - 120, leaf->batch.samples[0].timestamp);
+
+  uint8_t mensaje[256];
+  TEST_ASSERT_EQUAL(0, gateway_encode_batch(&pasarela, leaf, 1010, nullptr, mensaje, 4));
+  TEST_ASSERT_EQUAL(2, leaf->batch.count);
+  TEST_ASSERT_EQUAL(1, pasarela.stats.encodeFailures);
+  TEST_ASSERT_EQUAL(0, pasarela.stats.batches);
+  TEST_ASSERT_TRUE(gateway_encode_batch(&pasarela, leaf, 1010, nullptr, mensaje, sizeof(mensaje)) > 0);
+  TEST_ASSERT_EQUAL(0, leaf->batch.count);
+  TEST_ASSERT_EQUAL(1, pasarela.stats.batches);
+  // Un lote vacio no es un fallo
+  TEST_ASSERT_EQUAL(0, gateway_encode_batch(&pasarela, leaf, 1020, nullptr, mensaje, sizeof(mensaje)));
+  TEST_ASSERT_EQUAL(1, pasarela.stats.encodeFailures);
+}
+
+// Con la tabla llena las tramas de nodos nuevos se rechazan y las de los conocidos no
+void test_leaf_table_full() {
+  Gateway pasarela;
+  gateway_init(&pasarela, 4, 60000);
+  SensorSample lectura = make_sample(NAN, 21.0f, 60, 45.0f);
+  char nodo[LINK_NODE_SIZE];
+  for (uint8_t i = 0; i <= GATEWAY_MAX_LEAVES; i++) {
+    snprintf(nodo, sizeof(nodo), "hoja_%u", i);
+    GatewayLeaf* leaf = gateway_accept(&pasarela, make_packet(make_frame(nodo, 1, 1, lectura), 1000));
+    TEST_ASSERT_EQUAL(i < GATEWAY_MAX_LEAVES, leaf != nullptr);
+  }
+  TEST_ASSERT_EQUAL(1, pasarela.stats.rejected);
+  TEST_ASSERT_NOT_NULL(gateway_accept(&pasarela, make_packet(make_frame("hoja_0", 1, 2, lectura), 1100)));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_round_trip);
+  RUN_TEST(test_malformed_frames_rejected);
+  RUN_TEST(test_random_and_corrupted_frames);
+  RUN_TEST(test_dedup_and_batches);
+  RUN_TEST(test_batch_full_and_encode_failure);
+  RUN_TEST(test_leaf_table_full);
+  return UNITY_END();
+}
@@ -0,0 +1,361 @@
+/*
+///////////////// PRUEBAS DEL CLIENTE MQTT \\\\\\\\\\\\\\\\\
+*/
+// lib/mqtt frente a un socket falso que hace de broker: decodifica los paquetes que escribe el
+// cliente, responde al CONNECT y al PINGREQ, y confirma cada PUBLISH QoS 1 solo cuando la
+// prueba lo indica. Asi se puede cortar la sesion con mensajes en vuelo y comprobar que se
+// reenvian con DUP y el mismo identificador, y que nunca hay mas de MQTT_MAX_INFLIGHT sin
+// confirmar. El socket puede aceptar solo unos pocos bytes por escritura, como una pila TCP
+// con la ventana llena. El tiempo es un reloj falso en microsegundos.
+#include <mqtt.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define MAX_RECIBIDOS 256
+
+// PUBLISH recibido por el broker
+struct Recibido {
+  uint16_t id;
+  bool dup;
+  uint8_t qos;
+  // Primer byte del payload: numero del mensaje en la prueba
+  uint8_t valor;
+};
+
+static unsigned long relojUs = 0;
+
+static unsigned long fake_micros() {
+  return relojUs;
+}
+
+class FakeBroker : public MqttTransport {
+public:
+  bool activo;
+  bool conectado;
+  // Bytes que acepta el socket en cada write()
+  size_t limiteEscritura;
+  // Confirma cada PUBLISH QoS 1 en cuanto llega
+  bool confirmarSiempre;
+
+  Recibido recibidos[MAX_RECIBIDOS];
+  uint16_t numRecibidos;
+  uint16_t conexiones;
+  // PUBLISH QoS 1 de la sesion actual sin PUBACK, y el maximo observado
+  uint16_t sinConfirmar[MAX_RECIBIDOS];
+  uint8_t numSinConfirmar;
+  uint8_t maxSinConfirmar;
+
+  void reset() {
+    activo = true;
+    conectado = false;
+    limiteEscritura = 4096;
+    confirmarSiempre = false;
+    numRecibidos = 0;
+    conexiones = 0;
+    numSinConfirmar = 0;
+    maxSinConfirmar = 0;
+    entradaLen = 0;
+    salidaLen = 0;
+  }
+
+  bool connect(const char* host, uint16_t port) override {
+    (void)host;
+    (void)port;
+    conectado = activo;
+    entradaLen = 0;
+    salidaLen = 0;
+    // Sesion limpia: lo que no se confirmo en la anterior no cuenta en esta
+    numSinConfirmar = 0;
+    return conectado;
+  }
+
+  bool connected() override { return conectado; }
+
+  size_t write(const uint8_t* data, size_t len) override {
+    if (!conectado) {
+      return 0;
+    }
+    size_t aceptados = len < limiteEscritura ? len : limiteEscritura;
+    aceptados = aceptados < sizeof(entrada) - entradaLen ? aceptados : sizeof(entrada) - entradaLen;
+    memcpy(entrada + entradaLen, data, aceptados);
+    entradaLen += aceptados;
+    parse();
+    return aceptados;
+  }
+
+  size_t read(uint8_t* buffer, size_t len) override {
+    if (!conectado) {
+      return 0;
+    }
+    size_t leidos = len < salidaLen ? len : salidaLen;
+    memcpy(buffer, salida, leidos);
+    memmove(salida, salida + leidos, salidaLen - leidos);
+    salidaLen -= leidos;
+    return leidos;
+  }
+
+  void stop() override { conectado = false; }
+
+  // Corta la conexion desde el lado del broker
+  void drop() { conectado = false; }
+
+  // Envia el PUBACK del mensaje en vuelo mas antiguo
+  void ack_oldest() {
+    TEST_ASSERT_TRUE(numSinConfirmar > 0);
+    send_puback(sinConfirmar[0]);
+  }
+
+private:
+  uint8_t entrada[4096];
+  size_t entradaLen;
+  uint8_t salida[512];
+  size_t salidaLen;
+
+  void send(const uint8_t* packet, size_t len) {
+    TEST_ASSERT_TRUE(salidaLen + len <= sizeof(salida));
+    memcpy(salida + salidaLen, packet, len);
+    salidaLen += len;
+  }
+
+  void send_puback(uint16_t id) {
+    const uint8_t puback[4] = {0x40, 0x02, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF)};
+    send(puback, sizeof(puback));
+    for (uint8_t i = 0; i < numSinConfirmar; i++) {
+      if (sinConfirmar[i] == id) {
+        memmove(sinConfirmar + i, sinConfirmar + i + 1, (numSinConfirmar - i - 1) * sizeof(sinConfirmar[0]));
+        numSinConfirmar--;
+        return;
+      }
+    }
+  }
+
+  // Procesa los paquetes completos recibidos del cliente
+  void parse() {
+    while (entradaLen >= 2) {
+      size_t restante = 0;
+      size_t cabecera = 1;
+      uint32_t factor = 1;
+      uint8_t byte;
+      do {
+        if (cabecera >= entradaLen) {
+          return;
+        }
+        byte = entrada[cabecera++];
+        restante += (byte & 0x7F) * factor;
+        factor *= 128;
+      } while (byte & 0x80);
+      size_t total = cabecera + restante;
+      if (entradaLen < total) {
+        return;
+      }
+      handle(entrada, cabecera, restante);
+      memmove(entrada, entrada + total, entradaLen - total);
+      entradaLen -= total;
+    }
+  }
+
+  void handle(const uint8_t* packet, size_t cabecera, size_t restante) {
+    const uint8_t* cuerpo = packet + cabecera;
+    switch (packet[0] >> 4) {
+      case 1: {
+        conexiones++;
+        const uint8_t connack[4] = {0x20, 0x02, 0x00, 0x00};
+        send(connack, sizeof(connack));
+        break;
+      }
+      case 3: {
+        TEST_ASSERT_TRUE(numRecibidos < MAX_RECIBIDOS);
+        Recibido& recibido = recibidos[numRecibidos++];
+        size_t topicLen = (size_t)(cuerpo[0] << 8 | cuerpo[1]);
+        recibido.qos = (packet[0] >> 1) & 0x03;
+        recibido.dup = (packet[0] & 0x08) != 0;
+        size_t payload = 2 + topicLen;
+        recibido.id = 0;
+        if (recibido.qos > 0) {
+          recibido.id = (uint16_t)(cuerpo[payload] << 8 | cuerpo[payload + 1]);
+          payload += 2;
+        }
+        recibido.valor = payload < restante ? cuerpo[payload] : 0;
+        if (recibido.qos > 0) {
+          sinConfirmar[numSinConfirmar++] = recibido.id;
+          maxSinConfirmar = numSinConfirmar > maxSinConfirmar ? numSinConfirmar : maxSinConfirmar;
+          if (confirmarSiempre) {
+            send_puback(recibido.id);
+          }
+        }
+        break;
+      }
+      case 12: {
+        const uint8_t pingresp[2] = {0xD0, 0x00};
+        send(pingresp, sizeof(pingresp));
+        break;
+      }
+      default:
+        break;
+    }
+  }
+};
+
+static FakeBroker broker;
+
+// Varias pasadas de pump(), avanzando el reloj 1 ms en cada una
+static void pump(MqttClient& cliente, uint16_t veces) {
+  for (uint16_t i = 0; i < veces; i++) {
+    cliente.pump();
+    relojUs += 1000;
+  }
+}
+
+static void connect(MqttClient& cliente) {
+  cliente.setServer("broker", 1883);
+  TEST_ASSERT_TRUE(cliente.connect("esp32-1a2b3c"));
+  pump(cliente, 3);
+  TEST_ASSERT_TRUE(cliente.connected());
+}
+
+static bool publish(MqttClient& cliente, uint8_t valor, uint8_t qos = 1) {
+  const uint8_t payload[8] = {valor, 1, 2, 3, 4, 5, 6, 7};
+  return cliente.publish("esp32_1/data", payload, sizeof(payload), qos);
+}
+
+void setUp() {
+  relojUs = 1000000;
+  broker.reset();
+}
+
+void tearDown() {}
+
+// Sin PUBACK el cliente deja de enviar al llegar a MQTT_MAX_INFLIGHT; cada confirmacion
+// libera un hueco y el siguiente mensaje sale en el mismo pump()
+void test_inflight_bounded() {
+  static MqttClient cliente(broker, fake_micros);
+  connect(cliente);
+  const uint8_t MENSAJES = 12;
+  for (uint8_t i = 0; i < MENSAJES; i++) {
+    TEST_ASSERT_TRUE(publish(cliente, i));
+  }
+  pump(cliente, 5);
+  TEST_ASSERT_EQUAL(MQTT_MAX_INFLIGHT, broker.numRecibidos);
+  TEST_ASSERT_EQUAL(MQTT_MAX_INFLIGHT, cliente.inFlight());
+  TEST_ASSERT_EQUAL(MENSAJES, cliente.pending());
+
+  while (cliente.pending() > 0) {
+    broker.ack_oldest();
+    pump(cliente, 2);
+    TEST_ASSERT_TRUE(cliente.inFlight() <= MQTT_MAX_INFLIGHT);
+  }
+  TEST_ASSERT_EQUAL(MQTT_MAX_INFLIGHT, broker.maxSinConfirmar);
+  TEST_ASSERT_EQUAL(MENSAJES, broker.numRecibidos);
+  TEST_ASSERT_EQUAL(MENSAJES, cliente.stats().acked);
+  // En orden, sin reenvios
+  for (uint8_t i = 0; i < MENSAJES; i++) {
+    TEST_ASSERT_EQUAL(i, broker.recibidos[i].valor);
+    TEST_ASSERT_FALSE(broker.recibidos[i].dup);
+  }
+  TEST_ASSERT_EQUAL(0, cliente.pendingBytes());
+}
+
+// Los mensajes enviados sin PUBACK cuando cae la sesion se reenvian tras reconectar, con DUP
+// y su identificador original; los confirmados y los QoS 0 no se repiten
+void test_dup_after_reconnect() {
+  static MqttClient cliente(broker, fake_micros);
+  connect(cliente);
+  for (uint8_t i = 0; i < 6; i++) {
+    TEST_ASSERT_TRUE(publish(cliente, i, i == 2 ? 0 : 1));
+  }
+  pump(cliente, 3);
+  // 0, 1, 3 y 4 en vuelo (el 2 es QoS 0); el 5 espera hueco
+  TEST_ASSERT_EQUAL(5, broker.numRecibidos);
+  broker.ack_oldest();
+  pump(cliente, 2);
+  TEST_ASSERT_EQUAL(6, broker.numRecibidos);
+  Recibido antes[6];
+  memcpy(antes, broker.recibidos, sizeof(antes));
+
+  broker.drop();
+  pump(cliente, 2);
+  TEST_ASSERT_FALSE(cliente.connected());
+  TEST_ASSERT_EQUAL(4, cliente.stats().retransmitted);
+
+  broker.confirmarSiempre = true;
+  connect(cliente);
+  pump(cliente, 5);
+  TEST_ASSERT_EQUAL(2, broker.conexiones);
+  TEST_ASSERT_EQUAL(10, broker.numRecibidos);
+  const uint8_t reenviados[4] = {1, 3, 4, 5};
+  for (uint8_t k = 0; k < 4; k++) {
+    const Recibido& recibido = broker.recibidos[6 + k];
+    TEST_ASSERT_EQUAL(reenviados[k], recibido.valor);
+    TEST_ASSERT_TRUE(recibido.dup);
+    TEST_ASSERT_EQUAL(antes[reenviados[k]].id, recibido.id);
+  }
+  TEST_ASSERT_EQUAL(0, cliente.pending());
+  TEST_ASSERT_EQUAL(0, cliente.inFlight());
+  TEST_ASSERT_EQUAL(5, cliente.stats().acked);
+  TEST_ASSERT_TRUE(broker.maxSinConfirmar <= MQTT_MAX_INFLIGHT);
+}
+
+// Sin PUBACK en MQTT_ACK_TIMEOUT la sesion se da por perdida y el mensaje se reenvia
+void test_ack_timeout_retransmits() {
+  static MqttClient cliente(broker, fake_micros);
+  connect(cliente);
+  TEST_ASSERT_TRUE(publish(cliente, 7));
+  pump(cliente, 2);
+  TEST_ASSERT_EQUAL(1, cliente.inFlight());
+  relojUs += MQTT_ACK_TIMEOUT * 1000UL + 1000;
+  pump(cliente, 1);
+  TEST_ASSERT_FALSE(cliente.connecting());
+
+  broker.confirmarSiempre = true;
+  connect(cliente);
+  pump(cliente, 2);
+  TEST_ASSERT_EQUAL(2, broker.numRecibidos);
+  TEST_ASSERT_TRUE(broker.recibidos[1].dup);
+  TEST_ASSERT_EQUAL(broker.recibidos[0].id, broker.recibidos[1].id);
+  TEST_ASSERT_EQUAL(0, cliente.pending());
+}
+
+// Con el socket aceptando pocos bytes por escritura los paquetes llegan enteros y en orden,
+// y un corte a mitad de un PUBLISH lo reenvia completo
+void test_partial_writes() {
+  static MqttClient cliente(broker, fake_micros);
+  broker.limiteEscritura = 5;
+  broker.confirmarSiempre = true;
+  cliente.setServer("broker", 1883);
+  TEST_ASSERT_TRUE(cliente.connect("esp32-1a2b3c"));
+  pump(cliente, 20);
+  TEST_ASSERT_TRUE(cliente.connected());
+  for (uint8_t i = 0; i < 8; i++) {
+    TEST_ASSERT_TRUE(publish(cliente, i));
+  }
+  pump(cliente, 3);
+  TEST_ASSERT_TRUE(cliente.stats().stalls > 0);
+  uint16_t recibidos = broker.numRecibidos;
+  TEST_ASSERT_TRUE(recibidos < 8);
+
+  // Corte con un PUBLISH a medias: el broker descarta el fragmento
+  broker.drop();
+  pump(cliente, 1);
+  broker.limiteEscritura = 4096;
+  connect(cliente);
+  pump(cliente, 5);
+  TEST_ASSERT_EQUAL(0, cliente.pending());
+  for (uint8_t i = 0; i < 8; i++) {
+    bool visto = false;
+    for (uint16_t k = 0; k < broker.numRecibidos; k++) {
+      visto = visto || broker.recibidos[k].valor == i;
+    }
+    TEST_ASSERT_TRUE(visto);
+  }
+  TEST_ASSERT_TRUE(broker.maxSinConfirmar <= MQTT_MAX_INFLIGHT);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_inflight_bounded);
+  RUN_TEST(test_dup_after_reconnect);
+  RUN_TEST(test_ack_timeout_retransmits);
+  RUN_TEST(test_partial_writes);
+  return UNITY_END();
+}
@@ -0,0 +1,203 @@
+/*
+///////////////// PRUEBAS DEL CODIFICADOR DE MENSAJES \\\\\\\\\\\\\\\\\
+*/
+// Formato binario de lib/payload (cabecera, mascara y campos) y banco de pruebas frente a la
+// ruta anterior con ArduinoJson: StaticJsonDocument serializado en una cadena en memoria
+// dinamica (String en la placa, std::string en el PC) y, como en PAYLOAD_FORMAT_JSON, en un
+// buffer del llamante. Se mide el tiempo de codificacion, los bytes del mensaje y las
+// reservas de memoria dinamica.
+#include <ArduinoJson.h>
+#include <chrono>
+#include <math.h>
+#include <new>
+#include <payload.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unity.h>
+
+// Reservas de memoria dinamica: std::string y ArduinoJson pasan por operator new
+static uint32_t reservas = 0;
+
+void* operator new(size_t size) {
+  reservas++;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+static SensorSample sample() {
+  SensorSample lectura;
+  lectura.timestamp = 0;
+  lectura.temperatureProbe = 23.46f;
+  lectura.temperatureDHT = 24.1f;
+  lectura.humidityCapacitor = 57;
+  lectura.humidityDHT = 48.25f;
+  return lectura;
+}
+
+// Ruta anterior de main_esp32_1.cpp: documento de cinco campos serializado en una cadena
+static size_t encode_json_string(const SensorSample& lectura, std::string& salida) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(5)> params;
+  params["temperatura_sonda"] = lectura.temperatureProbe;
+  params["temperatura_dht"] = lectura.temperatureDHT;
+  params["humedad_capacitor"] = lectura.humidityCapacitor;
+  params["humedad_dht"] = lectura.humidityDHT;
+  salida.clear();
+  serializeJson(params, salida);
+  return salida.size();
+}
+
+// PAYLOAD_FORMAT_JSON: el mismo documento, en el buffer del llamante
+static size_t encode_json_buffer(const SensorSample& lectura, uint8_t* buffer, size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(5)> params;
+  params["temperatura_sonda"] = lectura.temperatureProbe;
+  params["temperatura_dht"] = lectura.temperatureDHT;
+  params["humedad_capacitor"] = lectura.humidityCapacitor;
+  params["humedad_dht"] = lectura.humidityDHT;
+  size_t len = serializeJson(params, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+static int16_t read_int16(const uint8_t* in) {
+  return (int16_t)(in[0] | in[1] << 8);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Cabecera, mascara y canales en decimas, little-endian
+void test_params_layout() {
+  uint8_t buffer[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_params(sample(), 0, 0, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL(11, len);
+  TEST_ASSERT_EQUAL_HEX8(PAYLOAD_BINARY_V1, buffer[0]);
+  TEST_ASSERT_EQUAL(PAYLOAD_TYPE_PARAMS, buffer[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x0F, buffer[2]);
+  TEST_ASSERT_EQUAL(235, read_int16(buffer + 3));
+  TEST_ASSERT_EQUAL(241, read_int16(buffer + 5));
+  TEST_ASSERT_EQUAL(57, read_int16(buffer + 7));
+  TEST_ASSERT_EQUAL(483, read_int16(buffer + 9));
+
+  // La edad va al final; la hora UTC la sustituye
+  len = payload_encode_params(sample(), 90, 0, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL(15, len);
+  TEST_ASSERT_EQUAL_HEX8(0x8F, buffer[2]);
+  len = payload_encode_params(sample(), 90, 1760000000000ULL, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL(19, len);
+  TEST_ASSERT_EQUAL_HEX8(0x4F, buffer[2]);
+}
+
+// Los canales sin valor no ocupan espacio
+void test_missing_channels_are_omitted() {
+  SensorSample lectura = sample();
+  lectura.temperatureProbe = NAN;
+  lectura.humidityCapacitor = SAMPLE_NO_HUMIDITY;
+  uint8_t buffer[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_params(lectura, 0, 0, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL(7, len);
+  TEST_ASSERT_EQUAL_HEX8(0x0A, buffer[2]);
+  TEST_ASSERT_EQUAL(241, read_int16(buffer + 3));
+  TEST_ASSERT_EQUAL(483, read_int16(buffer + 5));
+}
+
+// Valores fuera del rango de int16 se saturan en lugar de dar la vuelta
+void test_out_of_range_saturates() {
+  SensorSample lectura = sample();
+  lectura.temperatureProbe = 5000.0f;
+  lectura.temperatureDHT = -5000.0f;
+  uint8_t buffer[PAYLOAD_MAX_SIZE];
+  payload_encode_params(lectura, 0, 0, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL(32767, read_int16(buffer + 3));
+  TEST_ASSERT_EQUAL(-32768, read_int16(buffer + 5));
+}
+
+// Sin espacio para el peor caso no se escribe nada
+void test_small_buffer_rejected() {
+  uint8_t buffer[18];
+  TEST_ASSERT_EQUAL(0, payload_encode_params(sample(), 0, 0, buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL(0, payload_encode_coverage(-67, buffer, 2));
+}
+
+// El codificador no reserva memoria dinamica
+void test_no_heap_allocations() {
+  uint8_t buffer[PAYLOAD_MAX_SIZE];
+  uint32_t antes = reservas;
+  for (int i = 0; i < 1000; i++) {
+    payload_encode_params(sample(), i, 0, buffer, sizeof(buffer));
+    payload_encode_coverage(-60 - i % 30, buffer, sizeof(buffer));
+  }
+  TEST_ASSERT_EQUAL(antes, reservas);
+}
+
+// Banco de pruebas: tiempo medio, bytes y reservas por mensaje de cada ruta
+void test_benchmark_against_arduinojson() {
+  const int N = 200000;
+  SensorSample lectura = sample();
+  uint8_t buffer[PAYLOAD_MAX_SIZE];
+  std::string cadena;
+  // Evita que el compilador descarte los resultados
+  volatile size_t total = 0;
+
+  struct Resultado {
+    const char* nombre;
+    double ns;
+    size_t bytes;
+    double reservas;
+  } resultados[3];
+
+  for (int ruta = 0; ruta < 3; ruta++) {
+    uint32_t reservasAntes = reservas;
+    size_t bytes = 0;
+    auto inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+      // Lecturas distintas en cada iteracion, como en el nodo
+      lectura.temperatureProbe = 20.0f + (i % 100) / 10.0f;
+      if (ruta == 0) {
+        std::string nueva;
+        bytes = encode_json_string(lectura, nueva);
+      } else if (ruta == 1) {
+        bytes = encode_json_buffer(lectura, buffer, sizeof(buffer));
+      } else {
+        bytes = payload_encode_params(lectura, 0, 0, buffer, sizeof(buffer));
+      }
+      total = total + bytes;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / N;
+    static const char* const NOMBRES[3] = {"ArduinoJson + cadena", "ArduinoJson en buffer", "binario"};
+    resultados[ruta] = {NOMBRES[ruta], ns, bytes, (double)(reservas - reservasAntes) / N};
+  }
+
+  for (const Resultado& r : resultados) {
+    char mensaje[128];
+    snprintf(mensaje, sizeof(mensaje), "%-22s %8.1f ns/mensaje %4zu bytes %5.2f reservas/mensaje", r.nombre, r.ns,
+             r.bytes, r.reservas);
+    TEST_MESSAGE(mensaje);
+  }
+  TEST_ASSERT_EQUAL(0, resultados[1].reservas);
+  TEST_ASSERT_EQUAL(0, resultados[2].reservas);
+  TEST_ASSERT_TRUE(resultados[0].reservas >= 1);
+  TEST_ASSERT_TRUE(resultados[2].bytes * 4 < resultados[1].bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_params_layout);
+  RUN_TEST(test_missing_channels_are_omitted);
+  RUN_TEST(test_out_of_range_saturates);
+  RUN_TEST(test_small_buffer_rejected);
+  RUN_TEST(test_no_heap_allocations);
+  RUN_TEST(test_benchmark_against_arduinojson);
+  return UNITY_END();
+}
@@ -0,0 +1,149 @@
+/*
+///////////////// PRUEBAS DE LOS LOTES DE LECTURAS \\\\\\\\\\\\\\\\\
+*/
+// Condiciones de envio de lib/batch y recuento de mensajes y bytes de una hora de lecturas
+// cada 10 s publicadas una a una (BATCH_SIZE=1, el comportamiento anterior) frente a lotes de
+// K lecturas. Los bytes en la red incluyen la cabecera del PUBLISH con QoS 1 y el topic de
+// esp32_1.
+#include <math.h>
+#include <sample_batch.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+static const char* const TOPIC = "esp32_1/params";
+static const uint32_t PERIODO = 10000;
+
+static SensorSample sample_at(uint32_t i) {
+  // Canales que cambian despacio, con el ruido de cuantizacion de los sensores
+  SensorSample lectura;
+  lectura.timestamp = i * PERIODO;
+  lectura.temperatureProbe = 21.0f + 0.002f * i + ((i * 7) % 3) * 0.1f;
+  lectura.temperatureDHT = roundf(22.0f + 0.002f * i);
+  lectura.humidityCapacitor = (int16_t)(55 - i / 120);
+  lectura.humidityDHT = 48.0f + (i % 4);
+  return lectura;
+}
+
+// Paquete PUBLISH con QoS 1: cabecera fija, longitud restante, topic e identificador
+static size_t publish_size(size_t payload) {
+  size_t resto = 2 + strlen(TOPIC) + 2 + payload;
+  size_t longitud = resto < 128 ? 1 : resto < 16384 ? 2 : 3;
+  return 1 + longitud + resto;
+}
+
+struct Recuento {
+  uint32_t mensajes;
+  uint32_t payload;
+  uint32_t red;
+};
+
+static void publish(SampleBatch* lote, uint32_t ahora, Recuento* recuento) {
+  uint8_t payload[PAYLOAD_BATCH_MAX_SIZE];
+  size_t len = batch_encode(lote, ahora, nullptr, payload, sizeof(payload));
+  TEST_ASSERT_TRUE(len > 0);
+  recuento->mensajes++;
+  recuento->payload += len;
+  recuento->red += publish_size(len);
+  batch_clear(lote);
+}
+
+// Publica n lecturas con lotes de k como tarea_lotes(), revisando el lote tras cada lectura.
+// El ultimo lote, incompleto, sale al vencer su latencia maxima
+static Recuento run(uint8_t k, uint32_t n) {
+  SampleBatch lote;
+  batch_init(&lote, k, BATCH_MAX_LATENCY);
+  Recuento recuento = {0, 0, 0};
+  for (uint32_t i = 0; i < n; i++) {
+    batch_add(&lote, sample_at(i));
+    if (batch_ready(&lote, i * PERIODO)) {
+      publish(&lote, i * PERIODO, &recuento);
+    }
+  }
+  if (lote.count > 0) {
+    uint32_t vencido = lote.samples[0].timestamp + BATCH_MAX_LATENCY;
+    TEST_ASSERT_TRUE(batch_ready(&lote, vencido));
+    publish(&lote, vencido, &recuento);
+  }
+  return recuento;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// El lote se envia al completarse
+void test_ready_when_full() {
+  SampleBatch lote;
+  batch_init(&lote, 3, 60000);
+  TEST_ASSERT_FALSE(batch_ready(&lote, 0));
+  batch_add(&lote, sample_at(0));
+  batch_add(&lote, sample_at(1));
+  TEST_ASSERT_FALSE(batch_ready(&lote, 2 * PERIODO));
+  batch_add(&lote, sample_at(2));
+  TEST_ASSERT_TRUE(batch_ready(&lote, 2 * PERIODO));
+}
+
+// Un lote incompleto se envia cuando su lectura mas antigua supera la latencia maxima,
+// aunque no lleguen mas lecturas
+void test_ready_after_max_latency() {
+  SampleBatch lote;
+  batch_init(&lote, 10, 60000);
+  batch_add(&lote, sample_at(1));
+  TEST_ASSERT_FALSE(batch_ready(&lote, PERIODO + 59999));
+  TEST_ASSERT_TRUE(batch_ready(&lote, PERIODO + 60000));
+  // El desbordamiento de millis() no adelanta el envio
+  SensorSample lectura = sample_at(0);
+  lectura.timestamp = 0xFFFFF000UL;
+  batch_clear(&lote);
+  batch_add(&lote, lectura);
+  TEST_ASSERT_FALSE(batch_ready(&lote, 0x1000));
+  TEST_ASSERT_TRUE(batch_ready(&lote, 60000 - 0x1000));
+}
+
+// El tamaño se limita a lo que cabe en un mensaje y un lote lleno descarta la mas antigua
+void test_size_limits_and_overflow() {
+  SampleBatch lote;
+  batch_init(&lote, 0, 60000);
+  TEST_ASSERT_EQUAL(1, lote.size);
+  batch_init(&lote, 255, 60000);
+  TEST_ASSERT_EQUAL(PAYLOAD_BATCH_MAX_SAMPLES, lote.size);
+  batch_init(&lote, 2, 60000);
+  for (uint32_t i = 0; i < 5; i++) {
+    batch_add(&lote, sample_at(i));
+  }
+  TEST_ASSERT_EQUAL(2, lote.count);
+  TEST_ASSERT_EQUAL_UINT32(3 * PERIODO, lote.samples[0].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(4 * PERIODO, lote.samples[1].timestamp);
+}
+
+// Mensajes y bytes de una hora de lecturas, antes (K=1) y despues de agrupar
+void test_message_and_byte_counts() {
+  const uint32_t N = 360;
+  const uint8_t LOTES[] = {1, 5, 10, PAYLOAD_BATCH_MAX_SAMPLES};
+  Recuento antes = run(1, N);
+  TEST_ASSERT_EQUAL(N, antes.mensajes);
+
+  for (uint8_t k : LOTES) {
+    Recuento r = k == 1 ? antes : run(k, N);
+    char mensaje[128];
+    snprintf(mensaje, sizeof(mensaje), "K=%-2u %4u mensajes %6u bytes de payload %6u bytes en la red (%3u%%)", k,
+             r.mensajes, r.payload, r.red, 100 * r.red / antes.red);
+    TEST_MESSAGE(mensaje);
+    TEST_ASSERT_EQUAL((N + k - 1) / k, r.mensajes);
+    TEST_ASSERT_TRUE(r.payload <= antes.payload);
+  }
+
+  // Con BATCH_SIZE lecturas por mensaje se envian menos de la mitad de bytes
+  Recuento despues = run(BATCH_SIZE, N);
+  TEST_ASSERT_TRUE(despues.red * 2 < antes.red);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ready_when_full);
+  RUN_TEST(test_ready_after_max_latency);
+  RUN_TEST(test_size_limits_and_overflow);
+  RUN_TEST(test_message_and_byte_counts);
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+/*
+///////////////// PRUEBAS DEL BUFFER DE LECTURAS EN MEMORIA RTC \\\\\\\\\\\\\\\\\
+*/
+// Simula los ciclos de despertar del modo bajo consumo (esp32_1/src/sleep/duty_cycle.cpp)
+// sobre una variable que hace de memoria RTC: se conserva entre despertares y contiene basura
+// tras un arranque en frio.
+#include <sample_buffer.h>
+#include <string.h>
+#include <unity.h>
+
+static SampleBuffer rtc;
+
+static SensorSample sample_at(uint32_t timestamp) {
+  SensorSample lectura;
+  lectura.timestamp = timestamp;
+  lectura.temperatureProbe = 20.0f + timestamp / 1000.0f;
+  lectura.temperatureDHT = 21.0f;
+  lectura.humidityDHT = 50.0f;
+  lectura.humidityCapacitor = (int16_t)(timestamp % 1000);
+  return lectura;
+}
+
+// Contenido de la memoria RTC tras un arranque en frio
+static void cold_boot(uint8_t garbage) {
+  memset(&rtc, garbage, sizeof(rtc));
+}
+
+// Un despertar como duty_cycle_begin() + duty_cycle_store() + duty_cycle_sleep()
+static bool wake_cycle(uint32_t periodMs) {
+  bool conservado = sample_buffer_restore(&rtc);
+  rtc.wakeups++;
+  sample_buffer_push(&rtc, sample_at(rtc.elapsed));
+  rtc.elapsed += periodMs;
+  return conservado;
+}
+
+// Lecturas del buffer en orden, desde la mas antigua
+static void assert_timestamps(uint32_t first, uint32_t step, uint16_t count) {
+  TEST_ASSERT_EQUAL(count, rtc.count);
+  for (uint16_t i = 0; i < count; i++) {
+    const SensorSample* lectura = sample_buffer_at(&rtc, i);
+    TEST_ASSERT_NOT_NULL(lectura);
+    TEST_ASSERT_EQUAL_UINT32(first + i * step, lectura->timestamp);
+    TEST_ASSERT_EQUAL(sample_at(first + i * step).humidityCapacitor, lectura->humidityCapacitor);
+  }
+  TEST_ASSERT_NULL(sample_buffer_at(&rtc, count));
+}
+
+void setUp() {
+  cold_boot(0xA5);
+}
+
+void tearDown() {}
+
+// El primer despertar tras un arranque en frio descarta la basura y empieza de cero
+void test_cold_boot_resets() {
+  const uint8_t basuras[] = {0x00, 0xA5, 0xFF};
+  for (uint8_t basura : basuras) {
+    cold_boot(basura);
+    TEST_ASSERT_FALSE(sample_buffer_restore(&rtc));
+    TEST_ASSERT_EQUAL(0, rtc.count);
+    TEST_ASSERT_EQUAL(0, rtc.head);
+    TEST_ASSERT_EQUAL(0, rtc.wakeups);
+    TEST_ASSERT_EQUAL(0, rtc.elapsed);
+    TEST_ASSERT_EQUAL(0, rtc.dropped);
+  }
+}
+
+// Las lecturas, el numero de despertares y el tiempo acumulado sobreviven al deep sleep
+void test_state_survives_wake_cycles() {
+  TEST_ASSERT_FALSE(wake_cycle(30000));
+  for (int i = 1; i < 10; i++) {
+    TEST_ASSERT_TRUE(wake_cycle(30000));
+  }
+  TEST_ASSERT_EQUAL(10, rtc.wakeups);
+  TEST_ASSERT_EQUAL(300000, rtc.elapsed);
+  assert_timestamps(0, 30000, 10);
+}
+
+// Un envio cada 10 despertares vacia el buffer; uno sin confirmar conserva las lecturas
+void test_flush_every_n_wakeups() {
+  for (int i = 0; i < 10; i++) {
+    wake_cycle(30000);
+  }
+  // Envio sin confirmacion: no se consume nada
+  sample_buffer_consume(&rtc, 0);
+  for (int i = 0; i < 10; i++) {
+    wake_cycle(30000);
+  }
+  assert_timestamps(0, 30000, 20);
+
+  // Envio confirmado a medias: salen las 12 primeras, el resto espera en orden
+  sample_buffer_consume(&rtc, 12);
+  assert_timestamps(12 * 30000, 30000, 8);
+  wake_cycle(30000);
+  assert_timestamps(12 * 30000, 30000, 9);
+
+  sample_buffer_consume(&rtc, 100);
+  TEST_ASSERT_EQUAL(0, rtc.count);
+  TEST_ASSERT_TRUE(sample_buffer_restore(&rtc));
+}
+
+// Sin envios el buffer se llena y descarta la lectura mas antigua, manteniendo el orden
+void test_overflow_drops_oldest() {
+  const uint16_t extra = 5;
+  for (uint16_t i = 0; i < SAMPLE_BUFFER_CAPACITY + extra; i++) {
+    wake_cycle(1000);
+  }
+  TEST_ASSERT_EQUAL(extra, rtc.dropped);
+  assert_timestamps(extra * 1000, 1000, SAMPLE_BUFFER_CAPACITY);
+
+  // Tras dar la vuelta al anillo, un consumo parcial y nuevos despertares siguen en orden
+  sample_buffer_consume(&rtc, 3);
+  wake_cycle(1000);
+  assert_timestamps((extra + 3) * 1000, 1000, SAMPLE_BUFFER_CAPACITY - 2);
+}
+
+// Un buffer con indices fuera de rango o de otra capacidad no se reutiliza
+void test_corrupted_state_resets() {
+  for (int i = 0; i < 4; i++) {
+    wake_cycle(1000);
+  }
+  rtc.head = SAMPLE_BUFFER_CAPACITY;
+  TEST_ASSERT_FALSE(sample_buffer_restore(&rtc));
+  TEST_ASSERT_EQUAL(0, rtc.count);
+
+  for (int i = 0; i < 4; i++) {
+    wake_cycle(1000);
+  }
+  rtc.count = SAMPLE_BUFFER_CAPACITY + 1;
+  TEST_ASSERT_FALSE(sample_buffer_restore(&rtc));
+
+  for (int i = 0; i < 4; i++) {
+    wake_cycle(1000);
+  }
+  // La marca incluye la capacidad: un firmware con otro tamaño empieza de cero
+  rtc.magic ^= 1;
+  TEST_ASSERT_FALSE(sample_buffer_restore(&rtc));
+  TEST_ASSERT_EQUAL(0, rtc.wakeups);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_cold_boot_resets);
+  RUN_TEST(test_state_survives_wake_cycles);
+  RUN_TEST(test_flush_every_n_wakeups);
+  RUN_TEST(test_overflow_drops_oldest);
+  RUN_TEST(test_corrupted_state_resets);
+  return UNITY_END();
+}
@@ -0,0 +1,147 @@
+/*
+///////////////// PRUEBAS DEL PLANIFICADOR COOPERATIVO \\\\\\\\\\\\\\\\\
+*/
+// El planificador corre sobre un reloj falso que solo avanza cuando la prueba o las tareas
+// lo indican, asi que el retraso y la duracion de cada activacion se conocen de antemano.
+#include <scheduler.h>
+#include <unity.h>
+
+static unsigned long reloj = 0;
+// Duracion simulada de la siguiente ejecucion de cada tarea
+static unsigned long duracionLarga = 0;
+static unsigned long duracionCorta = 0;
+static char orden[16];
+static uint8_t ejecuciones = 0;
+
+static unsigned long fake_clock() {
+  return reloj;
+}
+
+static void record(char tarea) {
+  if (ejecuciones < sizeof(orden) - 1) {
+    orden[ejecuciones++] = tarea;
+    orden[ejecuciones] = '\0';
+  }
+}
+
+static void tarea_larga() {
+  record('L');
+  reloj += duracionLarga;
+}
+
+static void tarea_corta() {
+  record('C');
+  reloj += duracionCorta;
+}
+
+// Simula loop(): una pasada y la espera que devuelve, como delay(idle)
+static void run_loop(unsigned long hasta) {
+  while ((long)(reloj - hasta) < 0) {
+    unsigned long idle = scheduler_run();
+    unsigned long resto = hasta - reloj;
+    reloj += idle < resto ? idle : resto;
+  }
+}
+
+void setUp() {
+  reloj = 1000;
+  duracionLarga = 0;
+  duracionCorta = 0;
+  ejecuciones = 0;
+  orden[0] = '\0';
+  scheduler_init(fake_clock);
+}
+
+void tearDown() {}
+
+// Con dos tareas vencidas corre primero la de deadline mas antiguo, y una por pasada
+void test_edf_order() {
+  scheduler_add("larga", tarea_larga, 100, 10, 20);
+  scheduler_add("corta", tarea_corta, 100, 10, 10);
+  reloj += 50;
+
+  scheduler_run();
+  TEST_ASSERT_EQUAL_STRING("C", orden);
+  scheduler_run();
+  TEST_ASSERT_EQUAL_STRING("CL", orden);
+  TEST_ASSERT_EQUAL(30, scheduler_task(0)->lastJitter);
+  TEST_ASSERT_EQUAL(40, scheduler_task(1)->lastJitter);
+}
+
+// La espera de loop() sin tareas vencidas no cuenta como retraso
+void test_idle_sleep_is_not_latency() {
+  scheduler_add("larga", tarea_larga, 50, 10);
+  scheduler_add("corta", tarea_corta, 200, 10, 7);
+  run_loop(reloj + 10000);
+
+  TEST_ASSERT_EQUAL(200, scheduler_task(0)->runs);
+  TEST_ASSERT_EQUAL(0, scheduler_max_latency());
+  TEST_ASSERT_EQUAL(0, scheduler_task(0)->maxJitter);
+  TEST_ASSERT_EQUAL(0, scheduler_max_pass());
+}
+
+// Una tarea larga retrasa a la siguiente como mucho su propia duracion
+void test_worst_case_latency_is_longest_task() {
+  duracionLarga = 30;
+  duracionCorta = 2;
+  scheduler_add("larga", tarea_larga, 1000, 40);
+  Task* corta = scheduler_add("corta", tarea_corta, 20, 5, 5);
+  run_loop(reloj + 10000);
+
+  TEST_ASSERT_EQUAL(10, scheduler_task(0)->runs);
+  TEST_ASSERT_EQUAL(25, corta->maxJitter);
+  TEST_ASSERT_EQUAL(25, scheduler_max_latency());
+  TEST_ASSERT_EQUAL(30, scheduler_max_pass());
+  TEST_ASSERT_EQUAL(0, scheduler_task(0)->overruns);
+  TEST_ASSERT_EQUAL(0, corta->overruns);
+  // La fase se mantiene: no se pierden activaciones de la tarea corta
+  TEST_ASSERT_INT_WITHIN(1, 500, corta->runs);
+}
+
+// Con jitter en la duracion, se registran el retraso y la duracion maximos
+void test_jitter_statistics() {
+  Task* larga = scheduler_add("larga", tarea_larga, 100, 10);
+  Task* corta = scheduler_add("corta", tarea_corta, 100, 10, 1);
+  const unsigned long duraciones[] = {3, 12, 7, 0, 25, 4};
+  for (unsigned long duracion : duraciones) {
+    duracionLarga = duracion;
+    run_loop(reloj + 100);
+  }
+
+  TEST_ASSERT_EQUAL(24, corta->maxJitter);
+  TEST_ASSERT_EQUAL(25, larga->maxDuration);
+  TEST_ASSERT_EQUAL(2, larga->overruns);
+  TEST_ASSERT_EQUAL(24, scheduler_max_latency());
+}
+
+// Una tarea que se queda atras mas de un periodo se resincroniza en vez de encadenar
+// ejecuciones atrasadas
+void test_resync_after_long_stall() {
+  Task* corta = scheduler_add("corta", tarea_corta, 10, 5);
+  reloj += 100;
+  scheduler_run();
+  TEST_ASSERT_EQUAL(100, corta->lastJitter);
+  TEST_ASSERT_EQUAL(reloj + 10, corta->nextRun);
+  TEST_ASSERT_EQUAL(10, scheduler_run());
+}
+
+// El desbordamiento de millis() no adelanta ni atrasa las activaciones
+void test_millis_wrap() {
+  reloj = (unsigned long)-35;
+  Task* corta = scheduler_add("corta", tarea_corta, 20, 5);
+  run_loop(reloj + 100);
+
+  TEST_ASSERT_EQUAL(5, corta->runs);
+  TEST_ASSERT_EQUAL(0, scheduler_max_latency());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_edf_order);
+  RUN_TEST(test_idle_sleep_is_not_latency);
+  RUN_TEST(test_worst_case_latency_is_longest_task);
+  RUN_TEST(test_jitter_statistics);
+  RUN_TEST(test_resync_after_long_stall);
+  RUN_TEST(test_millis_wrap);
+  return UNITY_END();
+}
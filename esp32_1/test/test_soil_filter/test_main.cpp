@@ -0,0 +1,191 @@
+/*
+///////////////// PRUEBAS DEL FILTRO DEL SENSOR CAPACITIVO \\\\\\\\\\\\\\\\\
+*/
+// Filtros de rafaga y tabla de calibracion de lib/soil_adc, y banco de pruebas del nucleo
+// del filtro sobre una traza de rafagas de SOIL_ADC_BURST conversiones. La traza es
+// sintetica y reproducible: un nivel que deriva despacio, ruido de unas pocas cuentas y
+// picos aislados como los que mete la radio en el ADC del ESP32.
+#include <chrono>
+#include <math.h>
+#include <soil_filter.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define BURST 16
+#define TRAZA 4096
+
+static uint16_t traza[TRAZA][BURST];
+static uint16_t nivel[TRAZA];
+
+// Generador congruencial: la misma traza en cada ejecucion
+static uint32_t semilla = 1;
+
+static uint32_t next_random() {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return semilla >> 8;
+}
+
+static void build_trace() {
+  semilla = 1;
+  for (int r = 0; r < TRAZA; r++) {
+    nivel[r] = (uint16_t)(2200 + 300 * sinf(r / 500.0f));
+    for (int i = 0; i < BURST; i++) {
+      // Ruido triangular de +-8 cuentas
+      int32_t valor = nivel[r] + (int32_t)(next_random() % 9) + (int32_t)(next_random() % 9) - 8;
+      // Uno de cada 16 valores es un pico hacia cualquiera de los extremos
+      if (next_random() % 16 == 0) {
+        valor = next_random() % 2 ? 4095 : 0;
+      }
+      traza[r][i] = (uint16_t)valor;
+    }
+  }
+}
+
+static SoilCalibration table() {
+  // Sensor capacitivo: mas humedad, menos lectura
+  SoilCalibration calibration;
+  calibration.count = 3;
+  calibration.raw[0] = 1200;
+  calibration.raw[1] = 2000;
+  calibration.raw[2] = 3000;
+  calibration.humidity[0] = 10000;
+  calibration.humidity[1] = 4000;
+  calibration.humidity[2] = 0;
+  return calibration;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Mediana con numero par e impar de muestras; el buffer queda ordenado
+void test_median() {
+  uint16_t impar[] = {30, 10, 50, 20, 40};
+  TEST_ASSERT_EQUAL(30, soil_filter(impar, 5, SOIL_FILTER_MEDIAN, 0));
+  const uint16_t ordenado[] = {10, 20, 30, 40, 50};
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(ordenado, impar, 5);
+
+  // Con numero par, media de las dos centrales redondeada
+  uint16_t par[] = {4, 1, 3, 2};
+  TEST_ASSERT_EQUAL(3, soil_filter(par, 4, SOIL_FILTER_MEDIAN, 0));
+  uint16_t uno[] = {7};
+  TEST_ASSERT_EQUAL(7, soil_filter(uno, 1, SOIL_FILTER_MEDIAN, 0));
+  TEST_ASSERT_EQUAL(0, soil_filter(nullptr, 0, SOIL_FILTER_MEDIAN, 0));
+}
+
+// La media recortada descarta trim muestras por cada extremo y redondea
+void test_trimmed_mean() {
+  uint16_t muestras[] = {100, 0, 101, 4095, 102, 103, 4095, 0};
+  TEST_ASSERT_EQUAL(102, soil_filter(muestras, 8, SOIL_FILTER_TRIMMED_MEAN, 2));
+  uint16_t redondeo[] = {1, 2, 2, 9};
+  TEST_ASSERT_EQUAL(2, soil_filter(redondeo, 4, SOIL_FILTER_TRIMMED_MEAN, 1));
+  uint16_t sinRecorte[] = {1, 2, 4};
+  TEST_ASSERT_EQUAL(2, soil_filter(sinRecorte, 3, SOIL_FILTER_TRIMMED_MEAN, 0));
+
+  // Un recorte que no deja muestras equivale a la mediana
+  uint16_t excesivo[] = {5, 1, 9, 3};
+  TEST_ASSERT_EQUAL(4, soil_filter(excesivo, 4, SOIL_FILTER_TRIMMED_MEAN, 2));
+}
+
+// Interpolacion entre puntos, redondeo y saturacion fuera de la tabla
+void test_calibration() {
+  SoilCalibration calibration = table();
+  TEST_ASSERT_TRUE(soil_calibration_valid(calibration));
+  TEST_ASSERT_EQUAL(10000, soil_calibrate(calibration, 0));
+  TEST_ASSERT_EQUAL(10000, soil_calibrate(calibration, 1200));
+  TEST_ASSERT_EQUAL(7000, soil_calibrate(calibration, 1600));
+  TEST_ASSERT_EQUAL(4000, soil_calibrate(calibration, 2000));
+  TEST_ASSERT_EQUAL(2000, soil_calibrate(calibration, 2500));
+  // 1 cuenta en el primer tramo son 7.5 centesimas: se redondea
+  TEST_ASSERT_EQUAL(9992, soil_calibrate(calibration, 1201));
+  TEST_ASSERT_EQUAL(0, soil_calibrate(calibration, 4095));
+
+  // Toda la escala del ADC queda dentro del rango de la tabla
+  for (uint32_t raw = 0; raw <= 4095; raw++) {
+    int16_t humedad = soil_calibrate(calibration, raw);
+    TEST_ASSERT_TRUE(humedad >= 0 && humedad <= 10000);
+  }
+}
+
+// Tablas desordenadas, con puntos repetidos o de tamaño fuera de rango no se aceptan
+void test_calibration_validation() {
+  SoilCalibration calibration = table();
+  calibration.raw[1] = calibration.raw[0];
+  TEST_ASSERT_FALSE(soil_calibration_valid(calibration));
+  calibration = table();
+  calibration.raw[2] = 1500;
+  TEST_ASSERT_FALSE(soil_calibration_valid(calibration));
+  calibration = table();
+  calibration.count = 1;
+  TEST_ASSERT_FALSE(soil_calibration_valid(calibration));
+  calibration.count = SOIL_CAL_MAX_POINTS + 1;
+  TEST_ASSERT_FALSE(soil_calibration_valid(calibration));
+
+  SoilCalibration vacia;
+  vacia.count = 0;
+  TEST_ASSERT_EQUAL(0, soil_calibrate(vacia, 2000));
+}
+
+// Banco de pruebas: tiempo por rafaga y error respecto al nivel real con la traza
+void test_benchmark_on_trace() {
+  build_trace();
+  struct Filtro {
+    const char* nombre;
+    uint8_t filter;
+    uint8_t trim;
+  };
+  const Filtro filtros[] = {
+      {"primera conversion", 0xFF, 0},
+      {"mediana", SOIL_FILTER_MEDIAN, 0},
+      {"media recortada 4", SOIL_FILTER_TRIMMED_MEAN, 4},
+  };
+  const int REPETICIONES = 50;
+  double errores[3];
+  uint16_t rafaga[BURST];
+  // Evita que el compilador descarte los resultados
+  volatile uint32_t total = 0;
+
+  for (int f = 0; f < 3; f++) {
+    double cuadrados = 0;
+    auto inicio = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < REPETICIONES; rep++) {
+      for (int r = 0; r < TRAZA; r++) {
+        memcpy(rafaga, traza[r], sizeof(rafaga));
+        // Sin filtro: una sola analogRead(), como antes de la rafaga
+        uint16_t valor = rafaga[0];
+        if (filtros[f].filter != 0xFF) {
+          valor = soil_filter(rafaga, BURST, filtros[f].filter, filtros[f].trim);
+        }
+        total = total + valor;
+        if (rep == 0) {
+          double error = (double)valor - nivel[r];
+          cuadrados += error * error;
+        }
+      }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() /
+                (REPETICIONES * TRAZA);
+    errores[f] = sqrt(cuadrados / TRAZA);
+
+    char mensaje[128];
+    snprintf(mensaje, sizeof(mensaje), "%-20s %7.1f ns/rafaga error RMS %7.1f cuentas", filtros[f].nombre, ns,
+             errores[f]);
+    TEST_MESSAGE(mensaje);
+  }
+
+  // Los picos no llegan a la lectura filtrada
+  TEST_ASSERT_TRUE(errores[0] > 100);
+  TEST_ASSERT_TRUE(errores[1] < 5);
+  TEST_ASSERT_TRUE(errores[2] < 5);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_median);
+  RUN_TEST(test_trimmed_mean);
+  RUN_TEST(test_calibration);
+  RUN_TEST(test_calibration_validation);
+  RUN_TEST(test_benchmark_on_trace);
+  return UNITY_END();
+}
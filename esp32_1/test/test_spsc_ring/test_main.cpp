@@ -0,0 +1,173 @@
+/*
+///////////////// PRUEBAS DE LA COLA SIN CERROJOS \\\\\\\\\\\\\\\\\
+*/
+// lib/spsc_ring en un hilo y con un productor y un consumidor en hilos distintos, como las
+// tareas de sensores y de red del modo de doble nucleo. Cada registro lleva su numero de
+// secuencia y un contenido derivado de el, de modo que un registro leido antes de estar
+// escrito del todo, repetido o perdido se detecta en el consumidor. Conviene ejecutarla
+// tambien con -fsanitize=thread.
+#include <atomic>
+#include <chrono>
+#include <spsc_ring.h>
+#include <stdio.h>
+#include <thread>
+#include <unity.h>
+
+// Tamaño parecido a SampleRecord: varias palabras que no se copian de forma atomica
+struct Registro {
+  uint32_t seq;
+  uint32_t datos[7];
+};
+
+static Registro make_record(uint32_t seq) {
+  Registro registro;
+  registro.seq = seq;
+  for (uint32_t k = 0; k < 7; k++) {
+    registro.datos[k] = (uint32_t)(seq * 2654435761UL + k);
+  }
+  return registro;
+}
+
+static bool intact(const Registro& registro) {
+  for (uint32_t k = 0; k < 7; k++) {
+    if (registro.datos[k] != (uint32_t)(registro.seq * 2654435761UL + k)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// En un solo hilo: orden FIFO, descarte con la cola llena y maximo de ocupacion
+void test_fifo_and_overflow() {
+  SpscRing<int, 4> cola;
+  TEST_ASSERT_TRUE(cola.empty());
+  for (int i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL(i < 4, cola.push(i));
+  }
+  TEST_ASSERT_TRUE(cola.full());
+  TEST_ASSERT_EQUAL(2, cola.overflows());
+  TEST_ASSERT_EQUAL(4, cola.high_water());
+
+  int valor;
+  TEST_ASSERT_TRUE(cola.pop(valor));
+  TEST_ASSERT_EQUAL(0, valor);
+  TEST_ASSERT_TRUE(cola.push(10));
+  const int esperados[] = {1, 2, 3, 10};
+  for (int esperado : esperados) {
+    TEST_ASSERT_TRUE(cola.pop(valor));
+    TEST_ASSERT_EQUAL(esperado, valor);
+  }
+  TEST_ASSERT_FALSE(cola.pop(valor));
+  TEST_ASSERT_EQUAL(0, cola.size());
+
+  // Muchas vueltas al anillo sin perder el orden
+  for (int i = 0; i < 10000; i++) {
+    TEST_ASSERT_TRUE(cola.push(i));
+    TEST_ASSERT_TRUE(cola.pop(valor));
+    TEST_ASSERT_EQUAL(i, valor);
+  }
+  TEST_ASSERT_EQUAL(2, cola.overflows());
+}
+
+// Productor que reintenta con la cola llena: el consumidor recibe todos los registros, en
+// orden y completos
+void test_threads_lossless() {
+  const uint32_t N = 5000000;
+  static SpscRing<Registro, 64> cola;
+  auto inicio = std::chrono::steady_clock::now();
+
+  std::thread productor([] {
+    for (uint32_t seq = 0; seq < N;) {
+      if (cola.push(make_record(seq))) {
+        seq++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t esperado = 0;
+  uint32_t desordenados = 0;
+  uint32_t corruptos = 0;
+  Registro registro;
+  while (esperado < N) {
+    if (!cola.pop(registro)) {
+      std::this_thread::yield();
+      continue;
+    }
+    desordenados += registro.seq != esperado;
+    corruptos += !intact(registro);
+    esperado = registro.seq + 1;
+  }
+  productor.join();
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  char mensaje[128];
+  snprintf(mensaje, sizeof(mensaje), "%u registros en %.2f s (%.1f M/s), ocupacion maxima %u de %u", N, segundos,
+           N / segundos / 1e6, cola.high_water(), (unsigned)cola.capacity());
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_EQUAL(0, desordenados);
+  TEST_ASSERT_EQUAL(0, corruptos);
+  TEST_ASSERT_TRUE(cola.empty());
+  TEST_ASSERT_TRUE(cola.high_water() <= cola.capacity());
+}
+
+// Productor que descarta con la cola llena, como tarea_sensores() tras la contrapresion:
+// lo recibido mas lo descartado es lo producido, y lo recibido sigue en orden
+void test_threads_with_drops() {
+  const uint32_t N = 2000000;
+  static SpscRing<Registro, 8> cola;
+  static std::atomic<bool> terminado(false);
+
+  std::thread productor([] {
+    for (uint32_t seq = 0; seq < N; seq++) {
+      cola.push(make_record(seq));
+      // Ritmo parecido al del consumidor, para que haya tanto entregas como descartes
+      if (seq % 16 == 0) {
+        std::this_thread::yield();
+      }
+    }
+    terminado.store(true, std::memory_order_release);
+  });
+
+  uint32_t recibidos = 0;
+  uint32_t desordenados = 0;
+  uint32_t corruptos = 0;
+  int64_t anterior = -1;
+  Registro registro;
+  while (true) {
+    // Si el productor ya habia terminado antes de encontrar la cola vacia, no queda nada
+    bool fin = terminado.load(std::memory_order_acquire);
+    if (!cola.pop(registro)) {
+      if (fin) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    recibidos++;
+    desordenados += (int64_t)registro.seq <= anterior;
+    corruptos += !intact(registro);
+    anterior = registro.seq;
+  }
+  productor.join();
+
+  char mensaje[96];
+  snprintf(mensaje, sizeof(mensaje), "%u recibidos, %u descartados", recibidos, cola.overflows());
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_EQUAL(0, desordenados);
+  TEST_ASSERT_EQUAL(0, corruptos);
+  TEST_ASSERT_EQUAL(N, recibidos + cola.overflows());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_and_overflow);
+  RUN_TEST(test_threads_lossless);
+  RUN_TEST(test_threads_with_drops);
+  return UNITY_END();
+}
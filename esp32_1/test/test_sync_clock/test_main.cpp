@@ -0,0 +1,165 @@
+/*
+///////////////// PRUEBAS DEL RELOJ SINCRONIZADO \\\\\\\\\\\\\\\\\
+*/
+// lib/clock con un oscilador falso que adelanta o atrasa un numero fijo de ppm respecto a la
+// hora real, y sincronizaciones SNTP periodicas con un error de red acotado. Se comprueba la
+// deriva estimada, el error de la hora convertida entre sincronizaciones y sin ellas, y que
+// la hora corregida no retrocede nunca.
+#include <math.h>
+#include <stdio.h>
+#include <sync_clock.h>
+#include <unity.h>
+
+// Hora real al arrancar el nodo (ms UTC)
+static const uint64_t ARRANQUE = 1760000000000ULL;
+// Periodo de sincronizacion
+static const uint32_t PERIODO_SNTP = 600000;
+// Error maximo de cada medida SNTP (ms), por el retardo asimetrico de la red
+static const int32_t RUIDO_SNTP = 5;
+
+// Deriva del oscilador en ppm: positiva si el reloj local adelanta
+static double derivaPpm = 0;
+// Instante local del arranque: permite probar el desbordamiento de millis()
+static uint32_t localInicial = 0;
+static uint32_t semilla = 1;
+
+static int32_t network_noise() {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return (int32_t)((semilla >> 8) % (2 * RUIDO_SNTP + 1)) - RUIDO_SNTP;
+}
+
+// Reloj local (millis()) tras real ms de tiempo real
+static uint32_t local_at(uint64_t real) {
+  return localInicial + (uint32_t)llround(real * (1.0 + derivaPpm * 1e-6));
+}
+
+// Sincronizacion SNTP en el instante real indicado
+static void sync_at(SyncClock* reloj, uint64_t real) {
+  sync_clock_update(reloj, local_at(real), ARRANQUE + real + network_noise());
+}
+
+// Error (ms) de la hora convertida en el instante real indicado
+static int64_t error_at(const SyncClock* reloj, uint64_t real) {
+  return (int64_t)(sync_clock_epoch(reloj, local_at(real)) - (ARRANQUE + real));
+}
+
+// Sincroniza cada PERIODO_SNTP durante horas y devuelve el error maximo entre medidas,
+// a partir de la segunda hora
+static int64_t run_synced(SyncClock* reloj, uint32_t horas) {
+  int64_t maximo = 0;
+  for (uint64_t real = 0; real < horas * 3600000ULL; real += PERIODO_SNTP) {
+    sync_at(reloj, real);
+    for (uint64_t t = real; t < real + PERIODO_SNTP && real >= 3600000; t += 10000) {
+      int64_t error = llabs(error_at(reloj, t));
+      maximo = error > maximo ? error : maximo;
+    }
+  }
+  return maximo;
+}
+
+void setUp() {
+  derivaPpm = 0;
+  localInicial = 0;
+  semilla = 1;
+}
+
+void tearDown() {}
+
+// La deriva estimada converge a la del oscilador, con cristales que adelantan y que atrasan
+// y con el oscilador RC del deep sleep
+void test_drift_estimate_converges() {
+  const double derivas[] = {-40.0, 25.0, 3.0, 180.0};
+  for (double deriva : derivas) {
+    derivaPpm = deriva;
+    SyncClock reloj;
+    sync_clock_init(&reloj);
+    int64_t maximo = run_synced(&reloj, 12);
+
+    // driftPpb es la correccion, de signo contrario a la deriva del oscilador
+    double estimada = -reloj.driftPpb / 1000.0;
+    char mensaje[128];
+    snprintf(mensaje, sizeof(mensaje), "oscilador %+7.1f ppm: estimada %+7.2f ppm, error maximo %lld ms", deriva,
+             estimada, (long long)maximo);
+    TEST_MESSAGE(mensaje);
+    TEST_ASSERT_TRUE(reloj.driftValid);
+    // Cada medida tiene hasta 2 * RUIDO_SNTP ms de error en PERIODO_SNTP ms
+    TEST_ASSERT_FLOAT_WITHIN(2e6 * RUIDO_SNTP / PERIODO_SNTP, deriva, estimada);
+    // Entre sincronizaciones el error no pasa del ruido de la red mas lo que queda por absorber
+    TEST_ASSERT_TRUE(maximo <= 3 * RUIDO_SNTP);
+    TEST_ASSERT_EQUAL(1, reloj.steps);
+  }
+}
+
+// Sin sincronizaciones la deriva estimada mantiene la hora: el error crece mucho menos que
+// sin correccion
+void test_holdover_with_drift_correction() {
+  derivaPpm = 40;
+  SyncClock reloj;
+  sync_clock_init(&reloj);
+  run_synced(&reloj, 6);
+  uint64_t ultima = 6 * 3600000ULL - PERIODO_SNTP;
+
+  SyncClock sinDeriva = reloj;
+  sinDeriva.driftPpb = 0;
+  uint64_t despues = ultima + 6 * 3600000ULL;
+  int64_t corregido = llabs(error_at(&reloj, despues));
+  int64_t sinCorregir = llabs(error_at(&sinDeriva, despues));
+
+  char mensaje[128];
+  snprintf(mensaje, sizeof(mensaje), "6 h sin SNTP a 40 ppm: error %lld ms corregido, %lld ms sin corregir",
+           (long long)corregido, (long long)sinCorregir);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_TRUE(sinCorregir > 800);
+  TEST_ASSERT_TRUE(corregido < 100);
+}
+
+// El ajuste gradual no hace retroceder la hora, ni siquiera con el reloj local adelantado
+void test_monotonic_across_syncs() {
+  derivaPpm = 200;
+  SyncClock reloj;
+  sync_clock_init(&reloj);
+  uint64_t anterior = 0;
+  for (uint64_t real = 0; real < 4 * 3600000ULL; real += 250) {
+    if (real % PERIODO_SNTP == 0) {
+      sync_at(&reloj, real);
+    }
+    uint64_t hora = sync_clock_epoch(&reloj, local_at(real));
+    TEST_ASSERT_TRUE(hora >= anterior);
+    anterior = hora;
+  }
+  TEST_ASSERT_EQUAL(1, reloj.steps);
+}
+
+// Una deriva imposible para un oscilador se descarta y se vuelve a medir
+void test_excessive_drift_rejected() {
+  derivaPpm = SYNC_CLOCK_MAX_DRIFT_PPM * 3;
+  SyncClock reloj;
+  sync_clock_init(&reloj);
+  run_synced(&reloj, 2);
+  TEST_ASSERT_FALSE(reloj.driftValid);
+  TEST_ASSERT_EQUAL(0, reloj.driftPpb);
+}
+
+// El desbordamiento de millis() a los 49 dias no afecta a la conversion ni a la deriva
+void test_millis_wrap() {
+  derivaPpm = -30;
+  localInicial = 0xFFFFFFFFUL - 2 * 3600000UL;
+  SyncClock reloj;
+  sync_clock_init(&reloj);
+  int64_t maximo = run_synced(&reloj, 6);
+  TEST_ASSERT_TRUE(maximo <= 3 * RUIDO_SNTP);
+  TEST_ASSERT_FLOAT_WITHIN(2e6 * RUIDO_SNTP / PERIODO_SNTP, -30.0, -reloj.driftPpb / 1000.0);
+
+  // Lecturas anteriores a la ultima sincronizacion, al otro lado del desbordamiento
+  TEST_ASSERT_TRUE(llabs(error_at(&reloj, 3600000)) <= 3 * RUIDO_SNTP);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_drift_estimate_converges);
+  RUN_TEST(test_holdover_with_drift_correction);
+  RUN_TEST(test_monotonic_across_syncs);
+  RUN_TEST(test_excessive_drift_rejected);
+  RUN_TEST(test_millis_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,192 @@
+/*
+///////////////// PRUEBAS DE LAS ESTADISTICAS POR VENTANA \\\\\\\\\\\\\\\\\
+*/
+// lib/stats frente a la referencia de dos pasadas en double (media y despues suma de los
+// cuadrados de las desviaciones). Tambien se compara con la formula de la suma de cuadrados
+// en float, que es lo que evita Welford: con valores grandes y poca dispersion la resta
+// final se come la precision.
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include <window_stats.h>
+
+#define MAX_VALORES 1024
+
+// Generador congruencial: las mismas series en cada ejecucion
+static uint32_t semilla = 1;
+
+static float uniform() {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return (semilla >> 8) / 16777216.0f;
+}
+
+struct Referencia {
+  double mean;
+  double stddev;
+};
+
+static Referencia two_pass(const float* valores, int n) {
+  double suma = 0;
+  for (int i = 0; i < n; i++) {
+    suma += valores[i];
+  }
+  double media = suma / n;
+  double cuadrados = 0;
+  for (int i = 0; i < n; i++) {
+    cuadrados += (valores[i] - media) * (valores[i] - media);
+  }
+  return {media, n > 1 ? sqrt(cuadrados / (n - 1)) : 0};
+}
+
+// Suma de cuadrados en float en una pasada, sin Welford
+static float naive_stddev(const float* valores, int n) {
+  float suma = 0;
+  float cuadrados = 0;
+  for (int i = 0; i < n; i++) {
+    suma += valores[i];
+    cuadrados += valores[i] * valores[i];
+  }
+  float varianza = (cuadrados - suma * suma / n) / (n - 1);
+  return varianza > 0 ? sqrtf(varianza) : 0;
+}
+
+static void fill(float* valores, int n, float centro, float dispersion) {
+  for (int i = 0; i < n; i++) {
+    valores[i] = centro + dispersion * (uniform() - 0.5f);
+  }
+}
+
+void setUp() {
+  semilla = 1;
+}
+
+void tearDown() {}
+
+// Series de los rangos de cada canal: la media y la desviacion coinciden con la referencia
+void test_matches_two_pass_reference() {
+  struct Serie {
+    float centro;
+    float dispersion;
+    int n;
+  };
+  // Temperatura, humedad del suelo en cuentas, humedad relativa y ventanas muy cortas
+  const Serie series[] = {{21.5f, 4.0f, 30}, {2200.0f, 300.0f, 300}, {55.0f, 20.0f, 1000}, {18.0f, 0.5f, 2}};
+  static float valores[MAX_VALORES];
+
+  for (const Serie& serie : series) {
+    fill(valores, serie.n, serie.centro, serie.dispersion);
+    RunningStats stats;
+    running_reset(&stats);
+    float minimo = INFINITY;
+    float maximo = -INFINITY;
+    for (int i = 0; i < serie.n; i++) {
+      running_add(&stats, valores[i]);
+      minimo = fminf(minimo, valores[i]);
+      maximo = fmaxf(maximo, valores[i]);
+    }
+    Referencia ref = two_pass(valores, serie.n);
+    TEST_ASSERT_EQUAL(serie.n, stats.count);
+    TEST_ASSERT_EQUAL_FLOAT(minimo, stats.min);
+    TEST_ASSERT_EQUAL_FLOAT(maximo, stats.max);
+    TEST_ASSERT_FLOAT_WITHIN(fabs(ref.mean) * 1e-6 + 1e-6, ref.mean, stats.mean);
+    TEST_ASSERT_FLOAT_WITHIN(ref.stddev * 1e-4 + 1e-6, ref.stddev, running_stddev(stats));
+  }
+}
+
+// Valores grandes con poca dispersion: Welford sigue a la referencia y la suma de
+// cuadrados en float no
+void test_large_offset_without_cancellation() {
+  static float valores[MAX_VALORES];
+  fill(valores, MAX_VALORES, 10000.0f, 0.5f);
+  RunningStats stats;
+  running_reset(&stats);
+  for (int i = 0; i < MAX_VALORES; i++) {
+    running_add(&stats, valores[i]);
+  }
+  Referencia ref = two_pass(valores, MAX_VALORES);
+  double errorWelford = fabs(running_stddev(stats) - ref.stddev) / ref.stddev;
+  double errorIngenuo = fabs(naive_stddev(valores, MAX_VALORES) - ref.stddev) / ref.stddev;
+
+  char mensaje[128];
+  snprintf(mensaje, sizeof(mensaje), "desviacion %.5f: Welford %.5f (error %.2e), suma de cuadrados %.5f (error %.2e)",
+           ref.stddev, running_stddev(stats), errorWelford, naive_stddev(valores, MAX_VALORES), errorIngenuo);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_TRUE(errorWelford < 1e-3);
+  TEST_ASSERT_TRUE(errorIngenuo > 10 * errorWelford);
+}
+
+// Con menos de dos valores o valores constantes la varianza es 0, nunca negativa ni NAN
+void test_degenerate_windows() {
+  RunningStats stats;
+  running_reset(&stats);
+  TEST_ASSERT_EQUAL(0, running_variance(stats));
+  TEST_ASSERT_TRUE(isnan(stats.min));
+  running_add(&stats, 21.3f);
+  TEST_ASSERT_EQUAL(0, running_variance(stats));
+  TEST_ASSERT_EQUAL_FLOAT(21.3f, stats.mean);
+  for (int i = 0; i < 500; i++) {
+    running_add(&stats, 21.3f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0, running_stddev(stats));
+  TEST_ASSERT_EQUAL_FLOAT(21.3f, stats.mean);
+
+  // Los NAN no cuentan
+  running_add(&stats, NAN);
+  TEST_ASSERT_EQUAL(501, stats.count);
+}
+
+// El contador se satura en lugar de dar la vuelta
+void test_count_saturates() {
+  RunningStats stats;
+  running_reset(&stats);
+  for (uint32_t i = 0; i < UINT16_MAX + 10UL; i++) {
+    running_add(&stats, (float)(i % 2));
+  }
+  TEST_ASSERT_EQUAL(UINT16_MAX, stats.count);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.5f, stats.mean);
+}
+
+// La ventana reparte cada lectura por canales y omite los que no tienen valor
+void test_window_channels() {
+  WindowStats ventana;
+  stats_reset(&ventana, 1234);
+  TEST_ASSERT_EQUAL_UINT32(1234, ventana.start);
+  TEST_ASSERT_FALSE(stats_has_data(&ventana));
+
+  SensorSample lectura;
+  lectura.timestamp = 0;
+  lectura.temperatureProbe = NAN;
+  lectura.temperatureDHT = 22.0f;
+  lectura.humidityCapacitor = SAMPLE_NO_HUMIDITY;
+  lectura.humidityDHT = 40.0f;
+  stats_add(&ventana, lectura);
+  lectura.temperatureDHT = 24.0f;
+  lectura.humidityCapacitor = 57;
+  lectura.humidityDHT = 50.0f;
+  stats_add(&ventana, lectura);
+
+  TEST_ASSERT_TRUE(stats_has_data(&ventana));
+  TEST_ASSERT_EQUAL(0, ventana.channels[0].count);
+  TEST_ASSERT_EQUAL(2, ventana.channels[1].count);
+  TEST_ASSERT_EQUAL(1, ventana.channels[2].count);
+  TEST_ASSERT_EQUAL(2, ventana.channels[3].count);
+  TEST_ASSERT_EQUAL_FLOAT(23.0f, ventana.channels[1].mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, sqrtf(2.0f), running_stddev(ventana.channels[1]));
+  TEST_ASSERT_EQUAL_FLOAT(57.0f, ventana.channels[2].min);
+  TEST_ASSERT_EQUAL_FLOAT(40.0f, ventana.channels[3].min);
+  TEST_ASSERT_EQUAL_FLOAT(50.0f, ventana.channels[3].max);
+
+  // Una ventana nueva empieza vacia
+  stats_reset(&ventana, 301234);
+  TEST_ASSERT_FALSE(stats_has_data(&ventana));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_two_pass_reference);
+  RUN_TEST(test_large_offset_without_cancellation);
+  RUN_TEST(test_degenerate_windows);
+  RUN_TEST(test_count_saturates);
+  RUN_TEST(test_window_channels);
+  return UNITY_END();
+}
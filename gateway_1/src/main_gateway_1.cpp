@@ -0,0 +1,199 @@
+/*
+///////////////// IMPORTACION DE MODULOS \\\\\\\\\\\\\\\\\
+*/
+// Planificador cooperativo de tareas periodicas
+#include <scheduler.h>
+// Codificacion de los mensajes (binario compacto o JSON)
+#include <payload.h>
+// Sistema de ficheros con la cola persistente
+#include <LittleFS.h>
+// Pines de la placa (LED RGB)
+#include <board.h>
+// Instantes de cada fase del arranque hasta la primera publicacion
+#include <boot_timeline.h>
+// LED RGB, conexion WiFi y MQTT comunes a todos los nodos
+#include <rgb.h>
+#include <node_wifi.h>
+#include <node_mqtt.h>
+// Contadores e histogramas del camino critico, expuestos en /metrics
+#include <node_metrics.h>
+// Hora UTC por SNTP con correccion de deriva, para fechar las lecturas de los nodos hoja
+#include <node_time.h>
+// Tramas de los nodos hoja por ESP-NOW, agrupadas por nodo
+#include <node_espnow.h>
+
+/*
+///////////////// ASIGNACION DE VALORES \\\\\\\\\\\\\\\\\
+*/
+// Pasarela ESP-NOW: recibe las lecturas de los nodos hoja (entorno denky32_espnow de esp32_1)
+// y las publica en "<nodo>/params" y "<nodo>/coverage" por una unica sesion MQTT.
+// Se asocia al punto de acceso: los nodos hoja tienen que usar su canal (ESPNOW_CHANNEL)
+
+// Configurar conexión WiFi //
+const char* ssid = "LabCristjz";
+const char* password = "CasaArribaCrist";
+const char* ip = "192.168.1.27";
+const char* gateway = "192.168.1.1";
+const char* subnet = "255.255.255.0";
+
+// Configurar la conexión MQTT //
+const char* mqtt_server = "192.168.1.70";
+const int mqtt_port = 1883;
+const char* mqtt_topic_link = "gateway_1/link";
+const char* mqtt_topic_boot = "gateway_1/boot";
+
+// Servidor NTP de la red local (la Raspberry, junto al broker)
+const char* ntp_server = "192.168.1.70";
+
+// Periodo de supervision de las conexiones WiFi y MQTT
+const unsigned long periodoSupervision = 250;
+// Periodo de servicio del socket MQTT: envio del anillo de salida, PUBACK y keepalive
+const unsigned long periodoMqtt = 50;
+// Periodo de proceso de las tramas recibidas de los nodos hoja
+const unsigned long periodoPasarela = 50;
+// Periodo de comprobacion de la latencia maxima de los lotes
+const unsigned long periodoLotes = 1000;
+// Periodo de consulta de peticiones al servidor de metricas
+const unsigned long periodoMetricas = 200;
+
+// Reloj sincronizado con el que se fechan las lecturas recibidas
+SyncClock reloj;
+
+/*
+///////////////// DECLARACION DE FUNCIONES \\\\\\\\\\\\\\\\\
+*/
+void tarea_red() {
+  // Supervisa la red WiFi y la sesion MQTT sin bloquear
+  wifi_supervise();
+  // Sincroniza el reloj cuando toca (un intercambio SNTP de pocos ms en la red local)
+  time_sync_poll();
+  if (!mqtt_is_connected()) {
+    return;
+  }
+
+  // Se publica el estado del enlace tras cada conexion con el broker
+  static uint32_t conexionesPublicadas = 0;
+  if (conexion.stats.mqttConnects != conexionesPublicadas) {
+    conexionesPublicadas = conexion.stats.mqttConnects;
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_link(conexion.stats, payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_link, payload, len);
+  }
+
+  // Tiempos del arranque, una sola vez tras la primera publicacion
+  static bool arranquePublicado = false;
+  if (!arranquePublicado && boot_complete()) {
+    arranquePublicado = true;
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_boot(boot_timeline(), payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_boot, payload, len);
+  }
+}
+
+void publicar_lote(GatewayLeaf* nodo, uint32_t ahora) {
+  char topic[LINK_NODE_SIZE + 8];
+  if (!gateway_topic(nodo, "params", topic, sizeof(topic))) {
+    return;
+  }
+
+  // Buffer estatico: un lote completo no cabe con holgura en la pila del loop
+  static uint8_t payload[PAYLOAD_BATCH_MAX_SIZE];
+  uint32_t inicio = micros();
+  size_t len = gateway_encode_batch(&espnow_gateway(), nodo, ahora, &time_clock(), payload, sizeof(payload));
+  metrics_observe(&metricas.serializacion, micros() - inicio);
+
+  // publica los datos mediante protocolo MQTT; sin conexion se guarda en la cola persistente
+  if (len > 0) {
+    mqtt_publish(topic, payload, len);
+  }
+}
+
+void publicar_cobertura(GatewayLeaf* nodo, uint32_t ahora) {
+  char topic[LINK_NODE_SIZE + 10];
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = gateway_encode_coverage(&espnow_gateway(), nodo, ahora, payload, sizeof(payload));
+  if (len > 0 && gateway_topic(nodo, "coverage", topic, sizeof(topic))) {
+    mqtt_publish(topic, payload, len);
+  }
+}
+
+void tarea_pasarela() {
+  // Procesa las tramas que ha dejado la tarea de WiFi: cada lectura nueva entra en el lote de
+  // su nodo, que se publica en cuanto se completa
+  GatewayLeaf* nodo;
+  while (espnow_gateway_receive(&nodo)) {
+    if (nodo == nullptr) {
+      continue;
+    }
+    metrics_count(&metricas.lecturas);
+    uint32_t ahora = millis();
+    publicar_cobertura(nodo, ahora);
+    if (gateway_batch_ready(nodo, ahora)) {
+      publicar_lote(nodo, ahora);
+    }
+  }
+}
+
+void tarea_lotes() {
+  // Publica los lotes cuya lectura mas antigua ha superado la latencia maxima
+  Gateway& pasarela = espnow_gateway();
+  uint32_t ahora = millis();
+  for (uint8_t i = 0; i < pasarela.count; i++) {
+    if (gateway_batch_ready(&pasarela.leaves[i], ahora)) {
+      publicar_lote(&pasarela.leaves[i], ahora);
+    }
+  }
+}
+
+void tarea_reenvio() {
+  // Reenvia los mensajes guardados mientras no habia conexion
+  mqtt_drain();
+}
+
+void setup() {
+  // Configurar serial monitor
+  Serial.begin(9600);
+
+  // configura el LED RGB para que se pueda escribir
+  pinMode(Board::pinRojo, OUTPUT);
+  pinMode(Board::pinAzul, OUTPUT);
+  pinMode(Board::pinVerde, OUTPUT);
+
+  // apaga desde un inicio el LED RGB
+  turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+
+  // Montar el sistema de ficheros de la cola persistente
+  LittleFS.begin(true);
+
+  // Conectar a la red wifi local
+  setup_wifi(ssid, password, ip, gateway, subnet);
+
+  // ESP-NOW en el canal del punto de acceso, con un lote por nodo hoja
+  espnow_gateway_begin(GATEWAY_BATCH_SIZE, GATEWAY_MAX_LATENCY);
+
+  // Condifurar servidor mqtt para enviar datos
+  mqtt_init(mqtt_server, mqtt_port);
+
+  // Hora UTC por SNTP: las lecturas de los nodos hoja se fechan al recibirlas
+  sync_clock_init(&reloj);
+  time_sync_begin(ntp_server, &reloj, millis);
+
+  // Servidor HTTP con las metricas de la pasarela para Prometheus
+  metrics_server_begin();
+
+  // Registrar las tareas periodicas: nombre, funcion, periodo, presupuesto y desfase
+  scheduler_init(millis);
+  scheduler_add("red", tarea_red, periodoSupervision, 50);
+  scheduler_add("mqtt", mqtt_poll, periodoMqtt, 20);
+  scheduler_add("pasarela", tarea_pasarela, periodoPasarela, 50);
+  scheduler_add("lotes", tarea_lotes, periodoLotes, 50);
+  scheduler_add("reenvio", tarea_reenvio, 1000, 200);
+  scheduler_add("metricas", metrics_server_poll, periodoMetricas, 100);
+}
+
+void loop() {
+  // Ejecuta la tarea mas urgente y cede la CPU hasta el siguiente deadline
+  unsigned long idle = scheduler_run();
+  metrics_observe_loop();
+  delay(idle);
+}
@@ -0,0 +1,77 @@
+#include "acquisition.h"
+#include <math.h>
+
+void acquisition_init(Acquisition* acquisition, const SensorDrivers* drivers, ClockSource clock) {
+  acquisition->drivers = drivers;
+  acquisition->clock = clock;
+  acquisition->state = ADQ_REPOSO;
+  acquisition->start = 0;
+  acquisition->timeout = 0;
+  acquisition->dhtPending = false;
+  acquisition->lastDuration = 0;
+  acquisition->maxDuration = 0;
+}
+
+bool acquisition_start(Acquisition* acquisition) {
+  if (acquisition->state != ADQ_REPOSO) {
+    return false;
+  }
+
+  const SensorDrivers* drivers = acquisition->drivers;
+  SensorSample& sample = acquisition->sample;
+  acquisition->start = acquisition->clock();
+  sample.timestamp = acquisition->start;
+  sample.temperatureProbe = NAN;
+  sample.temperatureDHT = NAN;
+  sample.humidityDHT = NAN;
+  sample.humidityCapacitor = SAMPLE_NO_HUMIDITY;
+
+  // Primero la conversion de la sonda, que es la fase mas larga
+  acquisition->timeout = drivers->probeStart != nullptr ? drivers->probeStart() : 0;
+
+  // El resto de sensores se leen mientras la sonda convierte. El DHT11, si se puede, tambien
+  // por fases: su resultado se recoge en acquisition_poll()
+  acquisition->dhtPending = drivers->dhtStart != nullptr && drivers->readDht != nullptr;
+  if (acquisition->dhtPending) {
+    drivers->dhtStart();
+  } else if (drivers->readDht != nullptr) {
+    drivers->readDht(sample);
+  }
+  if (drivers->readSoil != nullptr) {
+    drivers->readSoil(sample);
+  }
+
+  acquisition->state = ADQ_CONVIRTIENDO;
+  return true;
+}
+
+bool acquisition_poll(Acquisition* acquisition) {
+  if (acquisition->state != ADQ_CONVIRTIENDO) {
+    return false;
+  }
+
+  const SensorDrivers* drivers = acquisition->drivers;
+  uint32_t now = acquisition->clock();
+  if (acquisition->dhtPending) {
+    if (!drivers->dhtReady()) {
+      return false;
+    }
+    drivers->readDht(acquisition->sample);
+    acquisition->dhtPending = false;
+  }
+  if (drivers->probeStart != nullptr) {
+    // Se espera a la sonda, como mucho el tiempo maximo de conversion
+    bool expired = now - acquisition->start >= acquisition->timeout;
+    if (!expired && !drivers->probeReady()) {
+      return false;
+    }
+    acquisition->sample.temperatureProbe = drivers->probeRead();
+  }
+
+  acquisition->lastDuration = now - acquisition->start;
+  if (acquisition->lastDuration > acquisition->maxDuration) {
+    acquisition->maxDuration = acquisition->lastDuration;
+  }
+  acquisition->state = ADQ_REPOSO;
+  return true;
+}
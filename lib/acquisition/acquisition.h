@@ -0,0 +1,86 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include <stdint.h>
+#include <sample.h>
+#include <scheduler.h>
+
+/*
+///////////////// ADQUISICION SOLAPADA DE LOS SENSORES \\\\\\\\\\\\\\\\\
+*/
+/**
+ * @brief Funciones de acceso a los sensores de un nodo. Las que el nodo no tiene se dejan a nullptr.
+ *
+ * La sonda se maneja en tres pasos para poder solapar su conversion (hasta 750 ms en el
+ * DS18B20 a 12 bits) con la lectura del resto de sensores. El DHT11 puede manejarse igual
+ * (dhtStart y dhtReady) para no bloquear durante su señal de inicio; sin ellos readDht()
+ * hace la transaccion completa.
+ */
+struct SensorDrivers {
+  // Inicia la conversion de la sonda sin esperar; devuelve el tiempo maximo de conversion (ms)
+  uint16_t (*probeStart)();
+  // Indica si la conversion de la sonda ha terminado
+  bool (*probeReady)();
+  // Lee el resultado de la conversion (NAN si la sonda no responde)
+  float (*probeRead)();
+  // Inicia la transaccion del DHT11 sin esperar
+  void (*dhtStart)();
+  // Avanza la transaccion del DHT11 e indica si ha terminado
+  bool (*dhtReady)();
+  // Lee temperatura y humedad del DHT11 en la lectura indicada
+  void (*readDht)(SensorSample& lectura);
+  // Lee la humedad del suelo en la lectura indicada
+  void (*readSoil)(SensorSample& lectura);
+};
+
+enum AcquisitionState {
+  ADQ_REPOSO,
+  ADQ_CONVIRTIENDO,
+};
+
+/**
+ * @brief Estado de una adquisicion en curso y metricas de duracion.
+ */
+struct Acquisition {
+  const SensorDrivers* drivers;
+  ClockSource clock;
+  AcquisitionState state;
+  uint32_t start;
+  uint16_t timeout;
+  // Transaccion del DHT11 iniciada y aun sin recoger
+  bool dhtPending;
+  SensorSample sample;
+
+  // Duracion (ms) de la ultima adquisicion completa y maxima observada
+  uint32_t lastDuration;
+  uint32_t maxDuration;
+};
+
+/**
+ * @brief Inicializa el motor de adquisicion.
+ *
+ * @param acquisition Estado a inicializar.
+ * @param drivers Funciones de acceso a los sensores del nodo.
+ * @param clock Fuente de tiempo en milisegundos.
+ */
+void acquisition_init(Acquisition* acquisition, const SensorDrivers* drivers, ClockSource clock);
+
+/**
+ * @brief Inicia una adquisicion: lanza la conversion de la sonda y la transaccion del DHT11 y,
+ * mientras tanto, lee el sensor de humedad del suelo.
+ *
+ * @param acquisition Motor de adquisicion.
+ * @return false si ya habia una adquisicion en curso.
+ */
+bool acquisition_start(Acquisition* acquisition);
+
+/**
+ * @brief Comprueba sin bloquear si la conversion de la sonda y la transaccion del DHT11 han
+ * terminado y, en ese caso, completa la lectura.
+ *
+ * @param acquisition Motor de adquisicion.
+ * @return true cuando la lectura esta completa en acquisition->sample.
+ */
+bool acquisition_poll(Acquisition* acquisition);
+
+#endif // ACQUISITION_H
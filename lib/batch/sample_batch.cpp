@@ -0,0 +1,33 @@
+#include "sample_batch.h"
+#include <string.h>
+
+void batch_init(SampleBatch* batch, uint8_t size, uint32_t maxLatency) {
+  batch->count = 0;
+  batch->size = size == 0 ? 1 : size > PAYLOAD_BATCH_MAX_SAMPLES ? PAYLOAD_BATCH_MAX_SAMPLES : size;
+  batch->maxLatency = maxLatency;
+}
+
+void batch_add(SampleBatch* batch, const SensorSample& lectura) {
+  if (batch->count == batch->size) {
+    memmove(&batch->samples[0], &batch->samples[1], (batch->count - 1) * sizeof(SensorSample));
+    batch->count--;
+  }
+  batch->samples[batch->count++] = lectura;
+}
+
+bool batch_ready(const SampleBatch* batch, uint32_t ahora) {
+  if (batch->count == 0) {
+    return false;
+  }
+  return batch->count >= batch->size || ahora - batch->samples[0].timestamp >= batch->maxLatency;
+}
+
+size_t batch_encode(const SampleBatch* batch, uint32_t ahora, const SyncClock* reloj, uint8_t* buffer, size_t size) {
+  // La hora UTC de las demas lecturas se deduce de las diferencias de tiempo del lote
+  uint64_t instante = reloj != nullptr && batch->count > 0 ? sync_clock_epoch(reloj, batch->samples[0].timestamp) : 0;
+  return payload_encode_batch(batch->samples, batch->count, ahora, instante, buffer, size);
+}
+
+void batch_clear(SampleBatch* batch) {
+  batch->count = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include <stdint.h>
+#include <sample.h>
+#include <payload.h>
+#include <sync_clock.h>
+
+// Lecturas por mensaje (K). Con 1 cada lectura se publica por separado
+#ifndef BATCH_SIZE
+#define BATCH_SIZE 10
+#endif
+
+// Latencia maxima (ms) de la lectura mas antigua antes de forzar el envio del lote
+#ifndef BATCH_MAX_LATENCY
+#define BATCH_MAX_LATENCY 300000UL
+#endif
+
+/**
+ * @brief Lote de lecturas pendientes de publicar en un unico mensaje.
+ */
+struct SampleBatch {
+  SensorSample samples[PAYLOAD_BATCH_MAX_SAMPLES];
+  uint8_t count;
+  uint8_t size;
+  uint32_t maxLatency;
+};
+
+/**
+ * @brief Inicializa un lote vacio.
+ *
+ * @param batch Lote a inicializar.
+ * @param size Numero de lecturas que completan el lote (como mucho PAYLOAD_BATCH_MAX_SAMPLES).
+ * @param maxLatency Edad maxima (ms) de la lectura mas antigua antes de enviar el lote.
+ */
+void batch_init(SampleBatch* batch, uint8_t size, uint32_t maxLatency);
+
+/**
+ * @brief Añade una lectura al lote. Si el lote ya esta completo se descarta la mas antigua.
+ */
+void batch_add(SampleBatch* batch, const SensorSample& lectura);
+
+/**
+ * @brief Indica si el lote esta completo o si su lectura mas antigua ha superado la latencia maxima.
+ *
+ * @param batch Lote a comprobar.
+ * @param ahora Instante actual en la base de tiempo del nodo.
+ */
+bool batch_ready(const SampleBatch* batch, uint32_t ahora);
+
+/**
+ * @brief Codifica el lote en el buffer indicado (ver payload_encode_batch()).
+ *
+ * @param batch Lote a codificar.
+ * @param ahora Instante actual en la base de tiempo del nodo.
+ * @param reloj Reloj sincronizado con el que se fechan las lecturas, o nullptr para enviar
+ * su edad.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si el lote esta vacio o no cabe.
+ */
+size_t batch_encode(const SampleBatch* batch, uint32_t ahora, const SyncClock* reloj, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Vacia el lote tras publicarlo.
+ */
+void batch_clear(SampleBatch* batch);
+
+#endif // SAMPLE_BATCH_H
@@ -0,0 +1,86 @@
+#include "sync_clock.h"
+#include <string.h>
+
+static const int64_t PPB = 1000000000LL;
+
+// Fija la referencia en una medida, sin ajuste gradual pendiente
+static void step_to(SyncClock* clock, uint32_t local, uint64_t epochMs) {
+  clock->anchorLocal = local;
+  clock->anchorEpoch = epochMs;
+  clock->slewError = 0;
+  clock->slewDuration = 0;
+  clock->steps++;
+}
+
+void sync_clock_init(SyncClock* clock) {
+  memset(clock, 0, sizeof(SyncClock));
+}
+
+void sync_clock_update(SyncClock* clock, uint32_t local, uint64_t epochMs) {
+  clock->syncs++;
+  if (!clock->synced) {
+    clock->synced = true;
+    clock->lastOffset = 0;
+    clock->baseLocal = local;
+    clock->baseEpoch = epochMs;
+    step_to(clock, local, epochMs);
+    return;
+  }
+
+  // Error del reloj corregido respecto a la medida
+  uint64_t previsto = sync_clock_epoch(clock, local);
+  int64_t error = (int64_t)(epochMs - previsto);
+  clock->lastOffset = error > INT32_MAX ? INT32_MAX : error < INT32_MIN ? INT32_MIN : (int32_t)error;
+
+  // Deriva: diferencia entre el tiempo transcurrido en UTC y en el reloj local, sobre las
+  // medidas sin corregir, para que el ajuste gradual no la contamine
+  uint32_t intervalo = local - clock->baseLocal;
+  if (intervalo >= SYNC_CLOCK_DRIFT_INTERVAL) {
+    int64_t diferencia = (int64_t)(epochMs - clock->baseEpoch) - (int64_t)intervalo;
+    int64_t medida = diferencia * PPB / intervalo;
+    const int64_t maxima = (int64_t)SYNC_CLOCK_MAX_DRIFT_PPM * 1000;
+    if (medida > maxima || medida < -maxima) {
+      // Ningun oscilador deriva tanto: la hora del servidor ha saltado. Se vuelve a medir
+      clock->driftValid = false;
+      clock->driftPpb = 0;
+    } else {
+      if (clock->driftValid) {
+        medida = clock->driftPpb + (medida - clock->driftPpb) / SYNC_CLOCK_DRIFT_GAIN;
+      }
+      clock->driftPpb = (int32_t)medida;
+      clock->driftValid = true;
+    }
+    clock->baseLocal = local;
+    clock->baseEpoch = epochMs;
+  }
+
+  // Los errores grandes se corrigen de golpe (antes de conocer la deriva, o si la hora del
+  // servidor salta); los demas se absorben poco a poco sin que la hora retroceda
+  if (error > SYNC_CLOCK_STEP_MS || error < -SYNC_CLOCK_STEP_MS) {
+    step_to(clock, local, epochMs);
+    return;
+  }
+
+  // La nueva referencia continua la conversion anterior y el error se reparte en el ajuste
+  clock->anchorLocal = local;
+  clock->anchorEpoch = previsto;
+  clock->slewError = (int32_t)error;
+  clock->slewDuration = (uint32_t)(error < 0 ? -error : error) * SYNC_CLOCK_SLEW_FACTOR;
+}
+
+uint64_t sync_clock_epoch(const SyncClock* clock, uint32_t local) {
+  if (!clock->synced) {
+    return 0;
+  }
+
+  // Con signo: admite instantes anteriores a la referencia
+  int64_t transcurrido = (int32_t)(local - clock->anchorLocal);
+  int64_t correccion = transcurrido * clock->driftPpb / PPB;
+  int64_t ajuste = 0;
+  if (transcurrido >= (int64_t)clock->slewDuration) {
+    ajuste = clock->slewError;
+  } else if (transcurrido > 0) {
+    ajuste = clock->slewError * transcurrido / (int64_t)clock->slewDuration;
+  }
+  return clock->anchorEpoch + transcurrido + correccion + ajuste;
+}
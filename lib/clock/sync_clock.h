@@ -0,0 +1,96 @@
+#ifndef SYNC_CLOCK_H
+#define SYNC_CLOCK_H
+
+#include <stdint.h>
+
+/*
+///////////////// RELOJ SINCRONIZADO CON CORRECCION DE DERIVA \\\\\\\\\\\\\\\\\
+*/
+// Convierte instantes del reloj local del nodo (millis(), en ms) en tiempo UTC (ms desde la
+// epoca Unix) a partir de las sincronizaciones SNTP. Entre dos sincronizaciones el reloj local
+// se corrige con la deriva estimada del oscilador; el error medido en cada sincronizacion se
+// absorbe de forma gradual, de modo que la hora convertida nunca retrocede. Solo un salto
+// mayor que SYNC_CLOCK_STEP_MS (primer ajuste, cambio de servidor) se aplica de golpe.
+// No depende de Arduino: el instante local y la medida los proporciona el llamante.
+
+// Error (ms) a partir del cual la hora se corrige de golpe en lugar de gradualmente
+#ifndef SYNC_CLOCK_STEP_MS
+#define SYNC_CLOCK_STEP_MS 1000
+#endif
+
+// El error se absorbe en SYNC_CLOCK_SLEW_FACTOR veces su valor: con 20 el reloj corregido
+// avanza como mucho un 5 % mas rapido o mas lento que el local mientras dura el ajuste
+#ifndef SYNC_CLOCK_SLEW_FACTOR
+#define SYNC_CLOCK_SLEW_FACTOR 20
+#endif
+
+// Intervalo minimo (ms) entre las dos sincronizaciones con que se mide la deriva: con
+// intervalos cortos el retardo de la red domina sobre la deriva del oscilador
+#ifndef SYNC_CLOCK_DRIFT_INTERVAL
+#define SYNC_CLOCK_DRIFT_INTERVAL 300000UL
+#endif
+
+// Peso de cada nueva medida de la deriva en su media movil (1/SYNC_CLOCK_DRIFT_GAIN)
+#ifndef SYNC_CLOCK_DRIFT_GAIN
+#define SYNC_CLOCK_DRIFT_GAIN 4
+#endif
+
+// Deriva maxima admitida en partes por millon. El cristal del ESP32 y del ESP8266 esta por
+// debajo de 50 ppm; el temporizador del deep sleep, que usa el oscilador RC, puede necesitar mas
+#ifndef SYNC_CLOCK_MAX_DRIFT_PPM
+#define SYNC_CLOCK_MAX_DRIFT_PPM 500
+#endif
+
+/**
+ * @brief Estado del reloj: referencia de la ultima sincronizacion, deriva estimada y ajuste
+ * gradual en curso. Estructura de tamaño fijo, sin punteros, para poder guardarla en memoria RTC.
+ */
+struct SyncClock {
+  bool synced;
+  bool driftValid;
+
+  // Referencia de la conversion: instante local y hora UTC (ms) que le corresponde
+  uint32_t anchorLocal;
+  uint64_t anchorEpoch;
+  // Deriva del reloj local en partes por mil millones (positiva si el reloj local atrasa)
+  int32_t driftPpb;
+  // Error que queda por absorber desde anchorLocal (ms) y duracion del ajuste (ms)
+  int32_t slewError;
+  uint32_t slewDuration;
+
+  // Sincronizacion desde la que se mide la siguiente estimacion de la deriva
+  uint32_t baseLocal;
+  uint64_t baseEpoch;
+
+  // estadisticas //
+  uint32_t syncs;
+  uint32_t steps;
+  // error del reloj corregido medido en la ultima sincronizacion (ms)
+  int32_t lastOffset;
+};
+
+/**
+ * @brief Inicializa el reloj sin sincronizar.
+ */
+void sync_clock_init(SyncClock* clock);
+
+/**
+ * @brief Incorpora una medida de la hora UTC.
+ *
+ * @param clock Reloj a actualizar.
+ * @param local Instante local de la medida en ms.
+ * @param epochMs Hora UTC en ese instante, en ms desde la epoca Unix.
+ */
+void sync_clock_update(SyncClock* clock, uint32_t local, uint64_t epochMs);
+
+/**
+ * @brief Convierte un instante local en hora UTC. Vale tambien para instantes anteriores a
+ * la ultima sincronizacion (lecturas adquiridas antes), hasta unos 24 dias atras.
+ *
+ * @param clock Reloj sincronizado.
+ * @param local Instante local en ms.
+ * @return Hora UTC en ms desde la epoca Unix, o 0 si el reloj no se ha sincronizado nunca.
+ */
+uint64_t sync_clock_epoch(const SyncClock* clock, uint32_t local);
+
+#endif // SYNC_CLOCK_H
@@ -0,0 +1,22 @@
+#include "boot_timeline.h"
+
+static BootTimeline timeline;
+
+void boot_mark(BootPhase fase, uint32_t ahora) {
+  // Un instante 0 se guarda como 1 ms para distinguirlo de una fase pendiente
+  if (fase < ARRANQUE_FASES && timeline.phases[fase] == 0) {
+    timeline.phases[fase] = ahora > 0 ? ahora : 1;
+  }
+}
+
+void boot_wifi_mode(BootWifiMode modo) {
+  timeline.wifiMode = modo;
+}
+
+bool boot_complete() {
+  return timeline.phases[ARRANQUE_PUBLICACION] != 0;
+}
+
+const BootTimeline& boot_timeline() {
+  return timeline;
+}
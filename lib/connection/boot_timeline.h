@@ -0,0 +1,58 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+/*
+///////////////// TIEMPOS DEL ARRANQUE \\\\\\\\\\\\\\\\\
+*/
+// Instante (ms desde el arranque) en que se completa cada fase, para medir cuanto tarda el
+// nodo en publicar su primer mensaje
+
+enum BootPhase {
+  ARRANQUE_SENSORES = 0,
+  ARRANQUE_WIFI = 1,
+  ARRANQUE_MQTT = 2,
+  ARRANQUE_PUBLICACION = 3,
+  ARRANQUE_FASES = 4,
+};
+
+// Como se ha asociado el nodo a la red WiFi
+enum BootWifiMode {
+  WIFI_ESCANEO = 0,
+  WIFI_RAPIDA = 1,
+  WIFI_RAPIDA_FALLIDA = 2,
+};
+
+/**
+ * @brief Instantes de cada fase del arranque (0 = fase no completada).
+ */
+struct BootTimeline {
+  uint32_t phases[ARRANQUE_FASES];
+  uint8_t wifiMode;
+};
+
+/**
+ * @brief Registra el final de una fase. Solo cuenta la primera vez que se completa.
+ *
+ * @param fase Fase completada.
+ * @param ahora Milisegundos desde el arranque.
+ */
+void boot_mark(BootPhase fase, uint32_t ahora);
+
+/**
+ * @brief Registra como se ha asociado el nodo a la red WiFi.
+ */
+void boot_wifi_mode(BootWifiMode modo);
+
+/**
+ * @brief Indica si se han completado todas las fases hasta la primera publicacion.
+ */
+bool boot_complete();
+
+/**
+ * @brief Tiempos del arranque en curso.
+ */
+const BootTimeline& boot_timeline();
+
+#endif // BOOT_TIMELINE_H
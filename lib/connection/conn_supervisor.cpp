@@ -0,0 +1,120 @@
+#include "conn_supervisor.h"
+
+// Comparacion tolerante al desbordamiento de millis()
+static inline bool is_due(uint32_t ahora, uint32_t instante) {
+  return (int32_t)(ahora - instante) >= 0;
+}
+
+static void backoff_reset(Backoff* backoff, uint32_t min, uint32_t base, uint32_t max) {
+  backoff->min = min;
+  backoff->base = base;
+  backoff->max = max;
+  backoff->attempt = 0;
+  backoff->next = 0;
+}
+
+uint32_t backoff_next(Backoff* backoff, uint32_t random) {
+  // Tope de la ventana: base * 2^intentos sin desbordar
+  uint32_t ceiling = backoff->max;
+  if (backoff->attempt < 31 && (backoff->base << backoff->attempt) >> backoff->attempt == backoff->base) {
+    uint32_t window = backoff->base << backoff->attempt;
+    if (window < ceiling) {
+      ceiling = window;
+    }
+  }
+  if (ceiling < backoff->min) {
+    ceiling = backoff->min;
+  }
+  if (backoff->attempt < 255) {
+    backoff->attempt++;
+  }
+  // Jitter completo: los nodos que pierden la conexion a la vez no reintentan a la vez
+  return backoff->min + random % (ceiling - backoff->min + 1);
+}
+
+void conn_init(ConnSupervisor* supervisor, uint32_t ahora, uint32_t (*random)()) {
+  supervisor->state = CONN_SIN_WIFI;
+  supervisor->random = random;
+  supervisor->downSince = ahora;
+  backoff_reset(&supervisor->wifi, CONN_WIFI_BACKOFF_MIN, CONN_WIFI_BACKOFF_BASE, CONN_WIFI_BACKOFF_MAX);
+  backoff_reset(&supervisor->mqtt, 0, CONN_MQTT_BACKOFF_BASE, CONN_MQTT_BACKOFF_MAX);
+  // La primera asociacion ya esta en marcha (setup_wifi): se le da el tiempo de un reintento
+  supervisor->wifi.next = ahora + backoff_next(&supervisor->wifi, random());
+
+  ConnStats& stats = supervisor->stats;
+  stats.mqttConnects = 0;
+  stats.mqttLosses = 0;
+  stats.mqttAttempts = 0;
+  stats.mqttFailures = 0;
+  stats.wifiLosses = 0;
+  stats.wifiRetries = 0;
+  stats.lastLatency = 0;
+  stats.maxLatency = 0;
+}
+
+bool conn_wifi_update(ConnSupervisor* supervisor, uint32_t ahora, bool conectado) {
+  if (conectado) {
+    if (supervisor->state == CONN_SIN_WIFI) {
+      // WiFi recuperada: el broker se intenta tras una espera corta y aleatoria
+      supervisor->state = CONN_SIN_BROKER;
+      supervisor->wifi.attempt = 0;
+      supervisor->mqtt.attempt = 0;
+      supervisor->mqtt.next = ahora + backoff_next(&supervisor->mqtt, supervisor->random());
+    }
+    return false;
+  }
+
+  if (supervisor->state != CONN_SIN_WIFI) {
+    if (supervisor->state == CONN_CONECTADO) {
+      supervisor->downSince = ahora;
+      supervisor->stats.mqttLosses++;
+    }
+    supervisor->state = CONN_SIN_WIFI;
+    supervisor->stats.wifiLosses++;
+    supervisor->wifi.next = ahora + backoff_next(&supervisor->wifi, supervisor->random());
+  }
+
+  if (!is_due(ahora, supervisor->wifi.next)) {
+    return false;
+  }
+  supervisor->stats.wifiRetries++;
+  supervisor->wifi.next = ahora + backoff_next(&supervisor->wifi, supervisor->random());
+  return true;
+}
+
+bool conn_mqtt_update(ConnSupervisor* supervisor, uint32_t ahora, bool conectado) {
+  if (supervisor->state == CONN_SIN_WIFI) {
+    return false;
+  }
+
+  if (conectado) {
+    return false;
+  }
+  if (supervisor->state == CONN_CONECTADO) {
+    // Sesion perdida con la WiFi activa (broker reiniciado, expulsion, keepalive)
+    supervisor->state = CONN_SIN_BROKER;
+    supervisor->downSince = ahora;
+    supervisor->stats.mqttLosses++;
+    supervisor->mqtt.attempt = 0;
+    supervisor->mqtt.next = ahora + backoff_next(&supervisor->mqtt, supervisor->random());
+  }
+  return is_due(ahora, supervisor->mqtt.next);
+}
+
+void conn_mqtt_result(ConnSupervisor* supervisor, uint32_t ahora, bool ok) {
+  ConnStats& stats = supervisor->stats;
+  stats.mqttAttempts++;
+  if (!ok) {
+    stats.mqttFailures++;
+    supervisor->mqtt.next = ahora + backoff_next(&supervisor->mqtt, supervisor->random());
+    return;
+  }
+
+  supervisor->state = CONN_CONECTADO;
+  supervisor->mqtt.attempt = 0;
+  stats.mqttConnects++;
+  stats.lastLatency = ahora - supervisor->downSince;
+  if (stats.lastLatency > stats.maxLatency) {
+    stats.maxLatency = stats.lastLatency;
+  }
+}
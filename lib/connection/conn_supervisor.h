@@ -0,0 +1,129 @@
+#ifndef CONN_SUPERVISOR_H
+#define CONN_SUPERVISOR_H
+
+#include <stdint.h>
+
+/*
+///////////////// SUPERVISOR DE LA CONEXION WIFI Y MQTT \\\\\\\\\\\\\\\\\
+*/
+// Espera entre reintentos: exponencial con jitter completo, acotada por un tope. Los fallos
+// de la red WiFi y del broker se cuentan y se esperan por separado: sin WiFi no se intenta
+// conectar con el broker, y al recuperar la WiFi el broker se reintenta desde cero.
+
+// Reintentos de asociacion WiFi (ms): la asociacion tarda unos segundos, por eso hay minimo
+#ifndef CONN_WIFI_BACKOFF_MIN
+#define CONN_WIFI_BACKOFF_MIN 5000UL
+#endif
+#ifndef CONN_WIFI_BACKOFF_BASE
+#define CONN_WIFI_BACKOFF_BASE 10000UL
+#endif
+#ifndef CONN_WIFI_BACKOFF_MAX
+#define CONN_WIFI_BACKOFF_MAX 300000UL
+#endif
+
+// Reintentos de conexion con el broker (ms)
+#ifndef CONN_MQTT_BACKOFF_BASE
+#define CONN_MQTT_BACKOFF_BASE 1000UL
+#endif
+#ifndef CONN_MQTT_BACKOFF_MAX
+#define CONN_MQTT_BACKOFF_MAX 60000UL
+#endif
+
+/**
+ * @brief Espera exponencial entre reintentos.
+ */
+struct Backoff {
+  uint32_t min;
+  uint32_t base;
+  uint32_t max;
+  uint8_t attempt;
+  uint32_t next;
+};
+
+enum ConnState {
+  CONN_SIN_WIFI,
+  CONN_SIN_BROKER,
+  CONN_CONECTADO,
+};
+
+/**
+ * @brief Contadores de la conexion, para publicarlos y medir la estabilidad del enlace.
+ */
+struct ConnStats {
+  // Conexiones establecidas con el broker y perdidas despues de establecerse
+  uint32_t mqttConnects;
+  uint32_t mqttLosses;
+  // Intentos de conexion con el broker y cuantos han fallado
+  uint32_t mqttAttempts;
+  uint32_t mqttFailures;
+  // Perdidas de la red WiFi y reintentos de asociacion
+  uint32_t wifiLosses;
+  uint32_t wifiRetries;
+  // Tiempo (ms) desde que se perdio la conexion hasta recuperarla: ultima y maxima
+  uint32_t lastLatency;
+  uint32_t maxLatency;
+};
+
+/**
+ * @brief Maquina de estados de la conexion de un nodo.
+ */
+struct ConnSupervisor {
+  ConnState state;
+  Backoff wifi;
+  Backoff mqtt;
+  // Instante en que se perdio la conexion con el broker (o arranque)
+  uint32_t downSince;
+  uint32_t (*random)();
+  ConnStats stats;
+};
+
+/**
+ * @brief Calcula la siguiente espera: aleatoria entre min y min(max, base * 2^intentos)
+ * (jitter completo) e incrementa el numero de intentos.
+ *
+ * @param backoff Estado de la espera.
+ * @param random Numero aleatorio de 32 bits.
+ * @return Espera en milisegundos.
+ */
+uint32_t backoff_next(Backoff* backoff, uint32_t random);
+
+/**
+ * @brief Inicializa el supervisor. Parte sin WiFi y con la conexion caida desde ahora.
+ *
+ * @param supervisor Supervisor a inicializar.
+ * @param ahora Instante actual en milisegundos.
+ * @param random Fuente de numeros aleatorios (hardware en la placa).
+ */
+void conn_init(ConnSupervisor* supervisor, uint32_t ahora, uint32_t (*random)());
+
+/**
+ * @brief Actualiza el estado de la red WiFi.
+ *
+ * @param supervisor Supervisor.
+ * @param ahora Instante actual en milisegundos.
+ * @param conectado Estado actual de la WiFi.
+ * @return true si toca reintentar la asociacion.
+ */
+bool conn_wifi_update(ConnSupervisor* supervisor, uint32_t ahora, bool conectado);
+
+/**
+ * @brief Actualiza el estado de la sesion con el broker.
+ *
+ * @param supervisor Supervisor.
+ * @param ahora Instante actual en milisegundos.
+ * @param conectado Estado actual de la sesion MQTT.
+ * @return true si toca intentar conectar con el broker; el resultado se notifica con
+ * conn_mqtt_result().
+ */
+bool conn_mqtt_update(ConnSupervisor* supervisor, uint32_t ahora, bool conectado);
+
+/**
+ * @brief Notifica el resultado de un intento de conexion con el broker.
+ *
+ * @param supervisor Supervisor.
+ * @param ahora Instante en que termina el intento.
+ * @param ok true si se ha establecido la sesion.
+ */
+void conn_mqtt_result(ConnSupervisor* supervisor, uint32_t ahora, bool ok);
+
+#endif // CONN_SUPERVISOR_H
@@ -0,0 +1,58 @@
+#include "dht_frame.h"
+
+DhtStatus dht_convert(const uint8_t data[5], DhtModel model, DhtReading* reading) {
+  if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+    return DHT_CHECKSUM;
+  }
+
+  if (model == DHT_MODEL_DHT22) {
+    // Decimas, con el signo de la temperatura en el bit alto
+    reading->humidity = ((data[0] << 8) | data[1]) * 0.1f;
+    float temperatura = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+    reading->temperature = (data[2] & 0x80) ? -temperatura : temperatura;
+  } else {
+    // Parte entera y decimas; bajo cero el bit alto de las decimas marca el signo y la parte
+    // entera esta desplazada en uno (igual que la libreria de Adafruit)
+    reading->humidity = data[0] + data[1] * 0.1f;
+    float temperatura = data[2];
+    if (data[3] & 0x80) {
+      temperatura = -1 - temperatura;
+    }
+    reading->temperature = temperatura + (data[3] & 0x0F) * 0.1f;
+  }
+  return DHT_OK;
+}
+
+DhtStatus dht_decode(const uint32_t* items, size_t count, DhtModel model, DhtReading* reading) {
+  // Ultimos DHT_FRAME_BITS pulsos altos, en un buffer circular
+  uint16_t altos[DHT_FRAME_BITS];
+  size_t total = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    for (uint8_t mitad = 0; mitad < 2; mitad++) {
+      uint16_t pulso = (uint16_t)(items[i] >> (16 * mitad));
+      uint16_t duracion = pulso & 0x7FFF;
+      if (duracion == 0) {
+        i = count;
+        break;
+      }
+      if (pulso & 0x8000) {
+        altos[total % DHT_FRAME_BITS] = duracion;
+        total++;
+      }
+    }
+  }
+  if (total < DHT_FRAME_BITS) {
+    return DHT_TIMEOUT;
+  }
+
+  uint8_t data[5] = {0, 0, 0, 0, 0};
+  for (uint8_t bit = 0; bit < DHT_FRAME_BITS; bit++) {
+    uint16_t duracion = altos[(total + bit) % DHT_FRAME_BITS];
+    if (duracion > DHT_BIT_MAX_US) {
+      return DHT_BAD_PULSE;
+    }
+    data[bit / 8] = (uint8_t)(data[bit / 8] << 1) | (duracion > DHT_BIT_THRESHOLD_US ? 1 : 0);
+  }
+  return dht_convert(data, model, reading);
+}
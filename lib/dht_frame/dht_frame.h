@@ -0,0 +1,84 @@
+#ifndef DHT_FRAME_H
+#define DHT_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+///////////////// DECODIFICACION DE LA TRAMA DEL DHT11/DHT22 \\\\\\\\\\\\\\\\\
+*/
+// Tras la señal de inicio, el sensor responde con un pulso bajo y uno alto de 80 us y envia
+// 40 bits, cada uno un pulso bajo de 50 us seguido de uno alto de 26-28 us (0) o 70 us (1):
+// humedad (2 bytes), temperatura (2 bytes) y suma de comprobacion. La decodificacion trabaja
+// sobre la duracion de los pulsos ya capturados (por el periferico RMT del ESP32, o grabados
+// en el PC), sin temporizacion propia, y no depende de Arduino.
+
+// Duracion (us) del pulso alto por encima de la cual el bit es un 1
+#ifndef DHT_BIT_THRESHOLD_US
+#define DHT_BIT_THRESHOLD_US 48
+#endif
+
+// Duracion maxima (us) de un pulso de bit: mas larga, la trama esta corrupta
+#ifndef DHT_BIT_MAX_US
+#define DHT_BIT_MAX_US 120
+#endif
+
+// Numero de bits de una trama
+#define DHT_FRAME_BITS 40
+
+/**
+ * @brief Modelo del sensor: determina como se interpretan los bytes de la trama.
+ */
+enum DhtModel : uint8_t {
+  DHT_MODEL_DHT11 = 11,
+  DHT_MODEL_DHT22 = 22,
+};
+
+/**
+ * @brief Resultado de una lectura.
+ */
+enum DhtStatus : uint8_t {
+  DHT_OK = 0,
+  // No se ha capturado la trama completa (sensor desconectado o sin respuesta)
+  DHT_TIMEOUT,
+  // Pulso con una duracion imposible (ruido en la linea)
+  DHT_BAD_PULSE,
+  // La suma de comprobacion no coincide
+  DHT_CHECKSUM,
+};
+
+/**
+ * @brief Lectura decodificada.
+ */
+struct DhtReading {
+  float temperature;
+  float humidity;
+};
+
+/**
+ * @brief Decodifica una trama capturada.
+ *
+ * Cada elemento describe dos pulsos con el formato de los elementos del RMT del ESP32
+ * (rmt_item32_t): bits 0-14 duracion del primero en us, bit 15 su nivel, bits 16-30 duracion
+ * del segundo y bit 31 su nivel. Una duracion 0 marca el final de la captura. Los bits son los
+ * 40 ultimos pulsos altos: la captura puede empezar antes o despues de la respuesta del sensor.
+ *
+ * @param items Pulsos capturados.
+ * @param count Numero de elementos.
+ * @param model Modelo del sensor.
+ * @param reading Lectura decodificada (solo se modifica si el resultado es DHT_OK).
+ * @return Resultado de la decodificacion.
+ */
+DhtStatus dht_decode(const uint32_t* items, size_t count, DhtModel model, DhtReading* reading);
+
+/**
+ * @brief Convierte los 5 bytes de una trama en la lectura, comprobando la suma.
+ *
+ * @param data Humedad (2 bytes), temperatura (2 bytes) y suma de comprobacion.
+ * @param model Modelo del sensor.
+ * @param reading Lectura resultante (solo se modifica si el resultado es DHT_OK).
+ * @return DHT_OK o DHT_CHECKSUM.
+ */
+DhtStatus dht_convert(const uint8_t data[5], DhtModel model, DhtReading* reading);
+
+#endif // DHT_FRAME_H
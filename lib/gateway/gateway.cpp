@@ -0,0 +1,116 @@
+#include "gateway.h"
+#include <payload.h>
+#include <stdio.h>
+#include <string.h>
+
+void gateway_init(Gateway* gateway, uint8_t batchSize, uint32_t maxLatency) {
+  memset(gateway, 0, sizeof(*gateway));
+  gateway->batchSize = batchSize;
+  gateway->maxLatency = maxLatency;
+}
+
+// Nodo con ese nombre, o uno nuevo si aun cabe en la tabla
+static GatewayLeaf* find_leaf(Gateway* gateway, const char* node, const uint8_t* mac) {
+  for (uint8_t i = 0; i < gateway->count; i++) {
+    if (strcmp(gateway->leaves[i].node, node) == 0) {
+      return &gateway->leaves[i];
+    }
+  }
+  if (gateway->count == GATEWAY_MAX_LEAVES) {
+    return nullptr;
+  }
+
+  GatewayLeaf* leaf = &gateway->leaves[gateway->count++];
+  memset(leaf, 0, sizeof(*leaf));
+  strcpy(leaf->node, node);
+  memcpy(leaf->mac, mac, sizeof(leaf->mac));
+  link_dedup_reset(&leaf->dedup);
+  batch_init(&leaf->batch, gateway->batchSize, gateway->maxLatency);
+  ReportPolicy defecto;
+  report_init(&defecto);
+  leaf->coverage = defecto.channels[CAMPO_DBM];
+  return leaf;
+}
+
+GatewayLeaf* gateway_accept(Gateway* gateway, const LinkPacket& packet) {
+  gateway->stats.received++;
+  LinkFrame frame;
+  if (!link_frame_decode(packet.data, packet.len, &frame)) {
+    gateway->stats.invalid++;
+    return nullptr;
+  }
+  GatewayLeaf* leaf = find_leaf(gateway, frame.node, packet.mac);
+  if (leaf == nullptr) {
+    gateway->stats.rejected++;
+    return nullptr;
+  }
+
+  switch (link_dedup_check(&leaf->dedup, frame.session, frame.seq)) {
+    case LINK_DUPLICATE:
+      leaf->duplicates++;
+      gateway->stats.duplicates++;
+      return nullptr;
+    case LINK_STALE:
+      leaf->stale++;
+      gateway->stats.stale++;
+      return nullptr;
+    case LINK_NEW:
+      break;
+  }
+
+  // La lectura se fecha en la base de tiempo de la pasarela. El lote envia diferencias sin
+  // signo: una lectura no puede quedar antes que la anterior del mismo nodo
+  SensorSample lectura = frame.sample;
+  lectura.timestamp = packet.receivedAt - frame.age;
+  SampleBatch& lote = leaf->batch;
+  if (lote.count > 0 && (int32_t)(lectura.timestamp - lote.samples[lote.count - 1].timestamp) < 0) {
+    lectura.timestamp = lote.samples[lote.count - 1].timestamp;
+  }
+  if (lote.count == lote.size) {
+    leaf->evicted++;
+    gateway->stats.evicted++;
+  }
+  batch_add(&lote, lectura);
+
+  memcpy(leaf->mac, packet.mac, sizeof(leaf->mac));
+  leaf->rssi = packet.rssi;
+  leaf->lastSeen = packet.receivedAt;
+  leaf->frames++;
+  gateway->stats.accepted++;
+  return leaf;
+}
+
+bool gateway_batch_ready(const GatewayLeaf* leaf, uint32_t ahora) {
+  return batch_ready(&leaf->batch, ahora);
+}
+
+size_t gateway_encode_batch(Gateway* gateway, GatewayLeaf* leaf, uint32_t ahora, const SyncClock* reloj,
+                            uint8_t* buffer, size_t size) {
+  if (leaf->batch.count == 0) {
+    return 0;
+  }
+  size_t len = batch_encode(&leaf->batch, ahora, reloj, buffer, size);
+  if (len == 0) {
+    gateway->stats.encodeFailures++;
+    return 0;
+  }
+  batch_clear(&leaf->batch);
+  gateway->stats.batches++;
+  return len;
+}
+
+size_t gateway_encode_coverage(Gateway* gateway, GatewayLeaf* leaf, uint32_t ahora, uint8_t* buffer, size_t size) {
+  if (leaf->frames == 0 || !report_channel_due(&leaf->coverage, leaf->rssi, ahora)) {
+    return 0;
+  }
+  size_t len = payload_encode_coverage(leaf->rssi, buffer, size);
+  if (len > 0) {
+    gateway->stats.coverage++;
+  }
+  return len;
+}
+
+bool gateway_topic(const GatewayLeaf* leaf, const char* suffix, char* topic, size_t size) {
+  int n = snprintf(topic, size, "%s/%s", leaf->node, suffix);
+  return n > 0 && (size_t)n < size;
+}
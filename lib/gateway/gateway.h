@@ -0,0 +1,136 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sensor_link.h>
+#include <sample_batch.h>
+#include <report_policy.h>
+
+/*
+///////////////// PASARELA DE LOS NODOS HOJA \\\\\\\\\\\\\\\\\
+*/
+// Recoge las tramas de lectura de los nodos hoja (ver sensor_link.h), descarta las repetidas
+// y agrupa las lecturas de cada nodo en un lote que se publica en "<nodo>/params" con el mismo
+// formato que usaria el propio nodo. La intensidad con la que llegan sus tramas se publica en
+// "<nodo>/coverage" con la politica de envio por cambio de la cobertura.
+// No depende de Arduino: el medio y la publicacion los aporta el llamante.
+
+// Nodos hoja distintos que atiende la pasarela; las tramas de los demas se descartan
+#ifndef GATEWAY_MAX_LEAVES
+#define GATEWAY_MAX_LEAVES 8
+#endif
+
+// Lecturas por lote de cada nodo y latencia maxima (ms) de su lectura mas antigua
+#ifndef GATEWAY_BATCH_SIZE
+#define GATEWAY_BATCH_SIZE BATCH_SIZE
+#endif
+#ifndef GATEWAY_MAX_LATENCY
+#define GATEWAY_MAX_LATENCY BATCH_MAX_LATENCY
+#endif
+
+/**
+ * @brief Estado de un nodo hoja en la pasarela.
+ */
+struct GatewayLeaf {
+  char node[LINK_NODE_SIZE];
+  uint8_t mac[6];
+  LinkDedup dedup;
+  SampleBatch batch;
+  // Cobertura: RSSI de la ultima trama y politica de envio
+  int8_t rssi;
+  ReportChannel coverage;
+  // Instante (ms) de la ultima trama nueva
+  uint32_t lastSeen;
+  // tramas nuevas, repetidas y demasiado antiguas
+  uint32_t frames;
+  uint32_t duplicates;
+  uint32_t stale;
+  // lecturas mas antiguas descartadas al llegar otra con el lote lleno (sin publicar)
+  uint32_t evicted;
+};
+
+/**
+ * @brief Contadores de toda la pasarela.
+ */
+struct GatewayStats {
+  uint32_t received;
+  uint32_t accepted;
+  uint32_t duplicates;
+  uint32_t stale;
+  // tramas con formato invalido y de nodos que no caben en la tabla
+  uint32_t invalid;
+  uint32_t rejected;
+  // mensajes de lecturas y de cobertura codificados para publicar
+  uint32_t batches;
+  uint32_t coverage;
+  // lecturas descartadas con el lote lleno y lotes que no se han podido codificar
+  uint32_t evicted;
+  uint32_t encodeFailures;
+};
+
+struct Gateway {
+  GatewayLeaf leaves[GATEWAY_MAX_LEAVES];
+  uint8_t count;
+  uint8_t batchSize;
+  uint32_t maxLatency;
+  GatewayStats stats;
+};
+
+/**
+ * @brief Inicializa la pasarela sin ningun nodo.
+ *
+ * @param gateway Pasarela a inicializar.
+ * @param batchSize Lecturas que completan el lote de un nodo.
+ * @param maxLatency Edad maxima (ms) de la lectura mas antigua de un lote antes de publicarlo.
+ */
+void gateway_init(Gateway* gateway, uint8_t batchSize, uint32_t maxLatency);
+
+/**
+ * @brief Procesa una trama recibida. Si es una lectura nueva la añade al lote de su nodo,
+ * fechada en la base de tiempo del receptor (recepcion menos edad). Con el lote lleno se
+ * descarta su lectura mas antigua y se cuenta en evicted.
+ *
+ * @param gateway Pasarela.
+ * @param packet Trama recibida.
+ * @return Nodo cuyo lote ha recibido la lectura, o nullptr si la trama se ha descartado.
+ */
+GatewayLeaf* gateway_accept(Gateway* gateway, const LinkPacket& packet);
+
+/**
+ * @brief Indica si el lote de un nodo esta completo o su lectura mas antigua ha superado la
+ * latencia maxima.
+ */
+bool gateway_batch_ready(const GatewayLeaf* leaf, uint32_t ahora);
+
+/**
+ * @brief Codifica el lote de un nodo (ver batch_encode()) y lo vacia. Si no se puede codificar
+ * el lote se conserva y se cuenta en encodeFailures.
+ *
+ * @param gateway Pasarela.
+ * @param leaf Nodo.
+ * @param ahora Instante actual en la base de tiempo del receptor.
+ * @param reloj Reloj sincronizado de la pasarela, o nullptr para enviar la edad.
+ * @param buffer Buffer destino (PAYLOAD_BATCH_MAX_SIZE bytes bastan).
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si el lote esta vacio o no cabe.
+ */
+size_t gateway_encode_batch(Gateway* gateway, GatewayLeaf* leaf, uint32_t ahora, const SyncClock* reloj,
+                            uint8_t* buffer, size_t size);
+
+/**
+ * @brief Codifica la cobertura de un nodo si toca publicarla (cambio mayor que la banda
+ * muerta o latido vencido).
+ *
+ * @return Numero de bytes escritos, o 0 si no toca.
+ */
+size_t gateway_encode_coverage(Gateway* gateway, GatewayLeaf* leaf, uint32_t ahora, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Escribe el topic "<nodo>/<sufijo>" de un nodo.
+ *
+ * @return false si no cabe.
+ */
+bool gateway_topic(const GatewayLeaf* leaf, const char* suffix, char* topic, size_t size);
+
+#endif // GATEWAY_H
@@ -0,0 +1,217 @@
+#include "gorilla.h"
+#include <math.h>
+#include <string.h>
+
+/*
+///////////////// BUFFER DE BITS \\\\\\\\\\\\\\\\\
+*/
+static void bits_init(BitWriter* out, uint8_t* data, size_t size) {
+  out->data = data;
+  out->size = size;
+  out->bits = 0;
+  out->overflow = false;
+}
+
+// Escribe los n bits menos significativos de value (n <= 32), el mas significativo primero
+static void bits_put(BitWriter* out, uint32_t value, uint8_t n) {
+  if (out->overflow || out->bits + n > out->size * 8) {
+    out->overflow = true;
+    return;
+  }
+  while (n > 0) {
+    uint8_t libres = 8 - (out->bits & 7);
+    uint8_t trozo = n < libres ? n : libres;
+    uint8_t valor = (value >> (n - trozo)) & ((1u << trozo) - 1);
+    uint8_t* byte = &out->data[out->bits >> 3];
+    if (libres == 8) {
+      *byte = 0;
+    }
+    *byte |= valor << (libres - trozo);
+    out->bits += trozo;
+    n -= trozo;
+  }
+}
+
+// Vuelve a dejar el flujo con los bits indicados, con los sobrantes del ultimo byte a 0
+static void bits_truncate(BitWriter* out, size_t bits) {
+  out->bits = bits;
+  out->overflow = false;
+  if (bits & 7) {
+    out->data[bits >> 3] &= 0xFF << (8 - (bits & 7));
+  }
+}
+
+/*
+///////////////// COMPRESOR \\\\\\\\\\\\\\\\\
+*/
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static uint8_t leading_zeros(uint32_t value) {
+  uint8_t n = 0;
+  for (uint32_t bit = 0x80000000u; bit != 0 && !(value & bit); bit >>= 1) {
+    n++;
+  }
+  return n;
+}
+
+static uint8_t trailing_zeros(uint32_t value) {
+  uint8_t n = 0;
+  for (uint32_t bit = 1; bit != 0 && !(value & bit); bit <<= 1) {
+    n++;
+  }
+  return n;
+}
+
+// humedad_capacitor: el unico canal entero de la lectura
+static const uint8_t CANAL_CAPACITOR = 2;
+
+// Valor en la escala del formato binario (decimas, o unidades en humedad_capacitor),
+// saturado al rango de int16
+static int32_t quantize(uint8_t canal, float value) {
+  float escalado = canal == CANAL_CAPACITOR ? roundf(value) : roundf(value * 10.0f);
+  if (escalado > 32767.0f) {
+    return 32767;
+  }
+  if (escalado < -32768.0f) {
+    return -32768;
+  }
+  return (int32_t)escalado;
+}
+
+static float channel_value(const SensorSample& lectura, uint8_t canal) {
+  switch (canal) {
+    case 0:
+      return lectura.temperatureProbe;
+    case 1:
+      return lectura.temperatureDHT;
+    case CANAL_CAPACITOR:
+      return lectura.humidityCapacitor == SAMPLE_NO_HUMIDITY ? NAN : lectura.humidityCapacitor;
+    default:
+      return lectura.humidityDHT;
+  }
+}
+
+static void put_timestamp(BitWriter* out, uint32_t dod) {
+  uint32_t z = zigzag((int32_t)dod);
+  if (z == 0) {
+    bits_put(out, 0, 1);
+  } else if (z < (1u << 7)) {
+    bits_put(out, 0x2, 2);
+    bits_put(out, z, 7);
+  } else if (z < (1u << 9)) {
+    bits_put(out, 0x6, 3);
+    bits_put(out, z, 9);
+  } else if (z < (1u << 12)) {
+    bits_put(out, 0xE, 4);
+    bits_put(out, z, 12);
+  } else {
+    bits_put(out, 0xF, 4);
+    bits_put(out, dod, 32);
+  }
+}
+
+static void put_integer(BitWriter* out, int32_t diferencia) {
+  if (diferencia == 0) {
+    bits_put(out, 0, 1);
+    return;
+  }
+  bits_put(out, 1, 1);
+  uint32_t valor = zigzag(diferencia) - 1;
+  do {
+    uint32_t grupo = valor & 0x7;
+    valor >>= 3;
+    bits_put(out, (valor != 0 ? 0x8 : 0) | grupo, 4);
+  } while (valor != 0);
+}
+
+static void put_float(GorillaEncoder* encoder, uint8_t canal, float value) {
+  BitWriter* out = &encoder->out;
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t cambio = bits ^ encoder->bits[canal];
+  encoder->bits[canal] = bits;
+  if (cambio == 0) {
+    bits_put(out, 0, 1);
+    return;
+  }
+
+  uint8_t ceros = leading_zeros(cambio);
+  uint8_t finales = trailing_zeros(cambio);
+  // Misma ventana que el XOR anterior: solo los bits significativos
+  if (encoder->leading[canal] != 0xFF && ceros >= encoder->leading[canal] && finales >= encoder->trailing[canal]) {
+    uint8_t longitud = 32 - encoder->leading[canal] - encoder->trailing[canal];
+    bits_put(out, 0x2, 2);
+    bits_put(out, cambio >> encoder->trailing[canal], longitud);
+    return;
+  }
+
+  uint8_t longitud = 32 - ceros - finales;
+  bits_put(out, 0x3, 2);
+  bits_put(out, ceros, 5);
+  bits_put(out, longitud - 1, 5);
+  bits_put(out, cambio >> finales, longitud);
+  encoder->leading[canal] = ceros;
+  encoder->trailing[canal] = finales;
+}
+
+void gorilla_begin(GorillaEncoder* encoder, uint8_t mode, uint32_t base, uint8_t* buffer, size_t size) {
+  memset(encoder, 0, sizeof(*encoder));
+  bits_init(&encoder->out, buffer, size);
+  encoder->mode = mode;
+  encoder->timestamp = base;
+  memset(encoder->leading, 0xFF, sizeof(encoder->leading));
+}
+
+bool gorilla_append(GorillaEncoder* encoder, const SensorSample& lectura) {
+  // Si la lectura no cabe se restaura el estado anterior completo
+  GorillaEncoder anterior = *encoder;
+  BitWriter* out = &encoder->out;
+
+  uint32_t delta = lectura.timestamp - encoder->timestamp;
+  put_timestamp(out, delta - encoder->delta);
+  encoder->timestamp = lectura.timestamp;
+  encoder->delta = delta;
+
+  uint8_t presentes = 0;
+  for (uint8_t canal = 0; canal < GORILLA_CHANNELS; canal++) {
+    if (!isnan(channel_value(lectura, canal))) {
+      presentes |= 1 << canal;
+    }
+  }
+  if (presentes == encoder->present) {
+    bits_put(out, 0, 1);
+  } else {
+    bits_put(out, 0x10 | presentes, 5);
+    encoder->present = presentes;
+  }
+
+  for (uint8_t canal = 0; canal < GORILLA_CHANNELS; canal++) {
+    if (!(presentes & (1 << canal))) {
+      continue;
+    }
+    float valor = channel_value(lectura, canal);
+    if (encoder->mode == GORILLA_XOR && canal != CANAL_CAPACITOR) {
+      put_float(encoder, canal, valor);
+    } else {
+      int32_t actual = quantize(canal, valor);
+      put_integer(out, actual - encoder->values[canal]);
+      encoder->values[canal] = actual;
+    }
+  }
+
+  if (out->overflow) {
+    size_t bits = anterior.out.bits;
+    *encoder = anterior;
+    bits_truncate(&encoder->out, bits);
+    return false;
+  }
+  encoder->count++;
+  encoder->channels |= presentes;
+  return true;
+}
+
+size_t gorilla_size(const GorillaEncoder* encoder) {
+  return (encoder->out.bits + 7) / 8;
+}
@@ -0,0 +1,111 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sample.h>
+
+/*
+///////////////// COMPRESION DE SERIES DE LECTURAS \\\\\\\\\\\\\\\\\
+*/
+// Compresor en flujo al estilo de Gorilla (Facebook, 2015) para lecturas que cambian despacio:
+// cada lectura se añade al flujo en cuanto llega y ocupa unos pocos bits. Escribe en un buffer
+// del llamante, sin memoria dinamica, y no depende de Arduino. El decodificador esta en la
+// Raspberry (raspberry/ingest/payload_decoder.cpp y func/payload.py).
+//
+// Los bits se escriben del mas significativo al menos significativo de cada byte. Por lectura:
+//
+// 1. Tiempo: diferencia de la diferencia (dod) con la lectura anterior, en ms y en zigzag (z):
+//
+// | codigo | bits siguientes | rango de z   |
+// |--------|-----------------|--------------|
+// | 0      | -               | 0            |
+// | 10     | 7               | 1..127       |
+// | 110    | 9               | 128..511     |
+// | 1110   | 12              | 512..4095    |
+// | 1111   | 32 (dod)        | el resto     |
+//
+//    La lectura anterior de la primera es la base indicada en gorilla_begin(), con diferencia 0.
+//
+// 2. Canales presentes: 0 si son los mismos que en la lectura anterior, o 1 y la mascara de
+//    4 bits (orden de PayloadField). Antes de la primera lectura no hay ninguno.
+//
+// 3. Cada canal presente, en el orden de la mascara:
+//    - Entero (GORILLA_QUANTIZED, y humedad_capacitor en GORILLA_XOR): valor en la escala del
+//      canal (x10, o x1 en humedad_capacitor) menos el anterior del canal (0 al principio).
+//      0 si no cambia, o 1 y zigzag(diferencia) - 1 en grupos de 4 bits: un bit de
+//      continuacion y 3 bits de valor, los menos significativos primero.
+//    - Real (GORILLA_XOR): XOR de los bits del float con los del valor anterior (0 al
+//      principio). 0 si es igual; 10 y los bits significativos si caben en la ventana de ceros
+//      iniciales y finales del XOR anterior; o 11, ceros iniciales (5 bits), longitud - 1
+//      (5 bits) y los bits significativos, que pasan a ser la nueva ventana.
+
+// Codificacion de los valores
+enum GorillaMode : uint8_t {
+  // Todos los canales en la escala del formato binario: misma precision que los lotes
+  GORILLA_QUANTIZED = 0,
+  // Temperaturas y humedad del DHT como float sin perdidas; humedad_capacitor como entero
+  GORILLA_XOR = 1,
+};
+
+// Canales de una lectura (temperatura_sonda, temperatura_dht, humedad_capacitor, humedad_dht)
+#define GORILLA_CHANNELS 4
+
+/**
+ * @brief Buffer de bits del llamante.
+ */
+struct BitWriter {
+  uint8_t* data;
+  size_t size;
+  // Bits escritos
+  size_t bits;
+  // Se ha intentado escribir mas alla del final
+  bool overflow;
+};
+
+/**
+ * @brief Estado del compresor: el flujo y los valores de la lectura anterior.
+ */
+struct GorillaEncoder {
+  BitWriter out;
+  uint8_t mode;
+  // Lecturas añadidas y canales presentes en alguna de ellas
+  uint16_t count;
+  uint8_t channels;
+  uint32_t timestamp;
+  uint32_t delta;
+  uint8_t present;
+  // Ultimo valor de cada canal: en su escala o, en GORILLA_XOR, los bits del float
+  int32_t values[GORILLA_CHANNELS];
+  uint32_t bits[GORILLA_CHANNELS];
+  // Ventana del ultimo XOR de cada canal (leading 0xFF: todavia no hay ninguna)
+  uint8_t leading[GORILLA_CHANNELS];
+  uint8_t trailing[GORILLA_CHANNELS];
+};
+
+/**
+ * @brief Empieza un flujo vacio en el buffer indicado.
+ *
+ * @param encoder Compresor a inicializar.
+ * @param mode Codificacion de los valores (GorillaMode).
+ * @param base Instante (ms) respecto al que se codifica el tiempo de la primera lectura.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ */
+void gorilla_begin(GorillaEncoder* encoder, uint8_t mode, uint32_t base, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Añade una lectura al flujo. Si no cabe, el flujo queda como estaba.
+ *
+ * @param encoder Compresor.
+ * @param lectura Lectura a añadir; los canales sin valor (NAN o SAMPLE_NO_HUMIDITY) se omiten.
+ * @return false si la lectura no cabe en el buffer.
+ */
+bool gorilla_append(GorillaEncoder* encoder, const SensorSample& lectura);
+
+/**
+ * @brief Bytes ocupados por el flujo; los bits que sobran del ultimo byte valen 0.
+ */
+size_t gorilla_size(const GorillaEncoder* encoder);
+
+#endif // GORILLA_H
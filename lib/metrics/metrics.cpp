@@ -0,0 +1,13 @@
+#include "metrics.h"
+
+// Escala aproximadamente logaritmica: mas resolucion en los tiempos cortos del camino critico
+const uint32_t METRICS_BOUNDS[METRICS_BUCKETS] = {
+  10, 50, 100, 500, 1000, 2000, 5000, 10000, 50000, 100000, 1000000, 5000000};
+
+uint32_t metrics_cumulative(const Histogram& histogram, uint8_t bucket) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i <= bucket && i <= METRICS_BUCKETS; i++) {
+    total += histogram.buckets[i];
+  }
+  return total;
+}
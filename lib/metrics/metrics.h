@@ -0,0 +1,73 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+/*
+///////////////// METRICAS DEL FIRMWARE \\\\\\\\\\\\\\\\\
+*/
+// Contadores e histogramas de cubetas fijas para instrumentar el camino critico. Registrar
+// una medida no reserva memoria ni usa cerrojos: cada metrica tiene un unico escritor (el
+// loop) y el lector (la exportacion) tolera ver una medida a medias entre dos cubetas.
+// Con -D NODE_METRICS=0 el registro desaparece y las medidas no cuestan nada.
+#ifndef NODE_METRICS
+#define NODE_METRICS 1
+#endif
+
+// Limites superiores de las cubetas en microsegundos, de 10 us a 5 s, comunes a todos los
+// histogramas. Una medida por encima del ultimo limite solo cuenta en +Inf
+#define METRICS_BUCKETS 12
+
+extern const uint32_t METRICS_BOUNDS[METRICS_BUCKETS];
+
+/**
+ * @brief Histograma de tiempos en microsegundos con las cubetas de METRICS_BOUNDS.
+ * Las cubetas no son acumulativas; la exportacion las acumula.
+ */
+struct Histogram {
+  uint32_t buckets[METRICS_BUCKETS + 1];
+  uint32_t count;
+  uint64_t sum;
+};
+
+/**
+ * @brief Registra una medida en el histograma.
+ *
+ * @param histogram Histograma destino.
+ * @param micros Duracion medida en microsegundos.
+ */
+inline void metrics_observe(Histogram* histogram, uint32_t micros) {
+#if NODE_METRICS
+  uint8_t cubeta = 0;
+  while (cubeta < METRICS_BUCKETS && micros > METRICS_BOUNDS[cubeta]) {
+    cubeta++;
+  }
+  histogram->buckets[cubeta]++;
+  histogram->count++;
+  histogram->sum += micros;
+#else
+  (void)histogram;
+  (void)micros;
+#endif
+}
+
+/**
+ * @brief Incrementa un contador.
+ */
+inline void metrics_count(uint32_t* counter) {
+#if NODE_METRICS
+  (*counter)++;
+#else
+  (void)counter;
+#endif
+}
+
+/**
+ * @brief Numero de medidas menores o iguales que el limite de la cubeta indicada.
+ *
+ * @param histogram Histograma a consultar.
+ * @param bucket Indice de la cubeta (METRICS_BUCKETS para +Inf).
+ */
+uint32_t metrics_cumulative(const Histogram& histogram, uint8_t bucket);
+
+#endif // METRICS_H
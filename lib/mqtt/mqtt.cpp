@@ -0,0 +1,533 @@
+#include "mqtt.h"
+#include <string.h>
+
+// Tipos de paquete (nibble alto de la cabecera fija)
+static const uint8_t MQTT_CONNECT = 1;
+static const uint8_t MQTT_CONNACK = 2;
+static const uint8_t MQTT_PUBLISH = 3;
+static const uint8_t MQTT_PUBACK = 4;
+static const uint8_t MQTT_SUBACK = 9;
+static const uint8_t MQTT_PINGRESP = 13;
+// Bit DUP de un PUBLISH reenviado
+static const uint8_t MQTT_DUP = 0x08;
+
+// Cabecera de cada registro del anillo: longitud del paquete (uint16, WRAP si el siguiente
+// registro empieza al principio del anillo), identificador del paquete (0 en QoS 0), instante
+// de publish() en us (uint32) y estado
+static const size_t RECORD_HEADER = 9;
+static const uint16_t RECORD_WRAP = 0xFFFF;
+enum RecordState : uint8_t {
+  // pendiente de enviar
+  RECORD_PENDING = 0,
+  // enviado, a la espera del PUBACK
+  RECORD_SENT = 1,
+  // confirmado, o QoS 0 ya enviado: se libera en cuanto llega al principio del anillo
+  RECORD_DONE = 2,
+};
+
+static uint16_t read_u16(const uint8_t* in) {
+  return (uint16_t)(in[0] << 8 | in[1]);
+}
+
+static uint8_t* put_u16(uint8_t* out, uint16_t value) {
+  out[0] = value >> 8;
+  out[1] = value & 0xFF;
+  return out + 2;
+}
+
+static uint8_t* put_string(uint8_t* out, const char* text, size_t len) {
+  out = put_u16(out, (uint16_t)len);
+  memcpy(out, text, len);
+  return out + len;
+}
+
+// Longitud restante de la cabecera fija: 7 bits por byte, el bit alto indica que sigue otro
+static uint8_t varint_size(size_t value) {
+  uint8_t size = 1;
+  while (value >= 128) {
+    value /= 128;
+    size++;
+  }
+  return size;
+}
+
+static uint8_t* put_varint(uint8_t* out, size_t value) {
+  do {
+    uint8_t byte = value % 128;
+    value /= 128;
+    *out++ = value > 0 ? byte | 0x80 : byte;
+  } while (value > 0);
+  return out;
+}
+
+MqttClient::MqttClient(MqttTransport& transport, unsigned long (*clockUs)())
+    : transport(transport), clock(clockUs), host(nullptr), port(1883), callback(nullptr), open(false),
+      session(false), openedAt(0), lastSent(0), pingPending(false), pingSentAt(0), ackWaitSince(0),
+      nextPacketId(1), busy(false), head(0), tail(0), sendPos(0), sendOffset(0), records(0), inflight(0),
+      controlLen(0), controlSent(0), inboundLen(0), discard(0) {
+  memset(&statistics, 0, sizeof(statistics));
+}
+
+void MqttClient::setServer(const char* host, uint16_t port) {
+  this->host = host;
+  this->port = port;
+}
+
+void MqttClient::setCallback(MqttCallback callback) {
+  this->callback = callback;
+}
+
+bool MqttClient::connect(const char* clientId) {
+  if (open) {
+    lost();
+  }
+  if (host == nullptr || !transport.connect(host, port)) {
+    return false;
+  }
+  open = true;
+  session = false;
+  openedAt = clock();
+  lastSent = openedAt;
+
+  // CONNECT con sesion limpia: nombre y nivel del protocolo, flags, keepalive e identificador
+  size_t idLen = strlen(clientId);
+  size_t restante = 10 + 2 + idLen;
+  uint8_t paquete[MQTT_CONTROL_SIZE];
+  if (1 + varint_size(restante) + restante > sizeof(paquete)) {
+    lost();
+    return false;
+  }
+  uint8_t* out = paquete;
+  *out++ = MQTT_CONNECT << 4;
+  out = put_varint(out, restante);
+  out = put_string(out, "MQTT", 4);
+  *out++ = 4;
+  *out++ = 0x02;
+  out = put_u16(out, MQTT_KEEPALIVE);
+  out = put_string(out, clientId, idLen);
+  queue_control(paquete, out - paquete);
+  return true;
+}
+
+bool MqttClient::publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos) {
+  size_t topicLen = strlen(topic);
+  size_t restante = 2 + topicLen + (qos > 0 ? 2 : 0) + len;
+  size_t paquete = 1 + varint_size(restante) + restante;
+  uint8_t* registro = paquete < RECORD_WRAP ? allocate(RECORD_HEADER + paquete) : nullptr;
+  if (registro == nullptr) {
+    statistics.dropped++;
+    return false;
+  }
+
+  uint16_t id = 0;
+  if (qos > 0) {
+    id = nextPacketId++;
+    if (nextPacketId == 0) {
+      nextPacketId = 1;
+    }
+  }
+  uint32_t ahora = clock();
+  put_u16(registro, (uint16_t)paquete);
+  put_u16(registro + 2, id);
+  memcpy(registro + 4, &ahora, sizeof(ahora));
+  registro[8] = RECORD_PENDING;
+
+  uint8_t* out = registro + RECORD_HEADER;
+  *out++ = MQTT_PUBLISH << 4 | (qos > 0 ? 1 << 1 : 0);
+  out = put_varint(out, restante);
+  out = put_string(out, topic, topicLen);
+  if (qos > 0) {
+    out = put_u16(out, id);
+  }
+  memcpy(out, payload, len);
+  statistics.queued++;
+  return true;
+}
+
+bool MqttClient::subscribe(const char* topic, uint8_t qos) {
+  if (!open) {
+    return false;
+  }
+  size_t topicLen = strlen(topic);
+  size_t restante = 2 + 2 + topicLen + 1;
+  uint8_t paquete[MQTT_CONTROL_SIZE];
+  if (1 + varint_size(restante) + restante > sizeof(paquete)) {
+    return false;
+  }
+  uint8_t* out = paquete;
+  *out++ = 0x82;
+  out = put_varint(out, restante);
+  out = put_u16(out, nextPacketId++);
+  if (nextPacketId == 0) {
+    nextPacketId = 1;
+  }
+  out = put_string(out, topic, topicLen);
+  *out++ = qos;
+  return queue_control(paquete, out - paquete);
+}
+
+void MqttClient::disconnect() {
+  if (!open) {
+    return;
+  }
+  // DISCONNECT solo si no corta un paquete a medio escribir y el socket lo acepta ya
+  if (session && sendOffset == 0 && controlSent == controlLen) {
+    const uint8_t paquete[2] = {0xE0, 0x00};
+    transport.write(paquete, sizeof(paquete));
+  }
+  lost();
+}
+
+void MqttClient::pump() {
+  // Un callback que publica puede volver a llamar a pump(): se ignora la llamada anidada
+  if (!open || busy) {
+    return;
+  }
+  if (!transport.connected()) {
+    lost();
+    return;
+  }
+  busy = true;
+  read_inbound();
+
+  unsigned long ahora = clock();
+  const unsigned long espera = MQTT_ACK_TIMEOUT * 1000UL;
+  if (open && !session && ahora - openedAt > espera) {
+    // Sin CONNACK
+    lost();
+  }
+  if (open && session) {
+    // Keepalive: un PINGREQ si no se ha enviado nada en el intervalo
+    if (!pingPending && ahora - lastSent >= MQTT_KEEPALIVE * 1000000UL) {
+      const uint8_t paquete[2] = {0xC0, 0x00};
+      if (queue_control(paquete, sizeof(paquete))) {
+        pingPending = true;
+        pingSentAt = ahora;
+      }
+    }
+    if ((pingPending && ahora - pingSentAt > espera) || (inflight > 0 && ahora - ackWaitSince > espera)) {
+      lost();
+    }
+  }
+
+  // Un PUBLISH a medio escribir se completa antes de intercalar paquetes de control
+  if (open && (sendOffset == 0 || write_outbound(true)) && write_control() && session) {
+    write_outbound(false);
+  }
+  release();
+  busy = false;
+}
+
+size_t MqttClient::pendingBytes() const {
+  if (records == 0) {
+    return 0;
+  }
+  return head > tail ? head - tail : MQTT_OUTBOUND_SIZE - tail + head;
+}
+
+/*
+///////////////// SESION \\\\\\\\\\\\\\\\\
+*/
+void MqttClient::lost() {
+  transport.stop();
+  open = false;
+  session = false;
+  pingPending = false;
+  controlLen = 0;
+  controlSent = 0;
+  inboundLen = 0;
+  discard = 0;
+  rewind();
+}
+
+bool MqttClient::queue_control(const uint8_t* packet, size_t len) {
+  if (controlLen + len > sizeof(control)) {
+    return false;
+  }
+  memcpy(control + controlLen, packet, len);
+  controlLen += len;
+  return true;
+}
+
+bool MqttClient::write_control() {
+  if (controlSent == controlLen) {
+    return true;
+  }
+  size_t escritos = transport.write(control + controlSent, controlLen - controlSent);
+  if (escritos > 0) {
+    lastSent = clock();
+  }
+  controlSent += escritos;
+  if (controlSent < controlLen) {
+    statistics.stalls++;
+    return false;
+  }
+  controlLen = 0;
+  controlSent = 0;
+  return true;
+}
+
+/*
+///////////////// ANILLO DE SALIDA \\\\\\\\\\\\\\\\\
+*/
+// Los registros no se parten: si no caben al final, se marca el hueco y empiezan en 0.
+// Con registros en el anillo, head == tail significa lleno
+
+size_t MqttClient::normalize(size_t pos) const {
+  if (pos + 2 > MQTT_OUTBOUND_SIZE || read_u16(outbound + pos) == RECORD_WRAP) {
+    return 0;
+  }
+  return pos;
+}
+
+size_t MqttClient::next_record(size_t pos) const {
+  // Las posiciones se guardan normalizadas: la marca del hueco final puede sobrescribirse
+  // cuando el anillo vuelve a dar la vuelta
+  size_t siguiente = pos + RECORD_HEADER + read_u16(outbound + pos);
+  return siguiente == head ? siguiente : normalize(siguiente);
+}
+
+uint8_t* MqttClient::allocate(size_t len) {
+  if (records == 0) {
+    head = tail = sendPos = 0;
+    sendOffset = 0;
+  } else if (sendPos != head) {
+    // sendPos puede seguir en la marca del hueco final, que esta reserva puede pisar
+    sendPos = normalize(sendPos);
+  }
+  size_t inicio;
+  if (records == 0) {
+    if (len > MQTT_OUTBOUND_SIZE) {
+      return nullptr;
+    }
+    inicio = 0;
+  } else if (head > tail) {
+    if (MQTT_OUTBOUND_SIZE - head >= len) {
+      inicio = head;
+    } else if (tail > len) {
+      if (head + 2 <= MQTT_OUTBOUND_SIZE) {
+        put_u16(outbound + head, RECORD_WRAP);
+      }
+      inicio = 0;
+    } else {
+      return nullptr;
+    }
+  } else if (head < tail && tail - head > len) {
+    inicio = head;
+  } else {
+    return nullptr;
+  }
+  head = inicio + len;
+  records++;
+  return outbound + inicio;
+}
+
+void MqttClient::release() {
+  // Libera por orden los registros terminados del principio del anillo
+  while (records > 0) {
+    size_t pos = normalize(tail);
+    if (outbound[pos + 8] != RECORD_DONE) {
+      tail = pos;
+      return;
+    }
+    // Tras reconectar, el primero por enviar puede estar ya confirmado
+    size_t siguiente = next_record(pos);
+    if (sendPos != head && normalize(sendPos) == pos) {
+      sendPos = siguiente;
+    }
+    tail = siguiente;
+    records--;
+  }
+  head = tail = sendPos = 0;
+  sendOffset = 0;
+}
+
+void MqttClient::rewind() {
+  // Los mensajes enviados sin PUBACK se reenvian desde el principio en la siguiente sesion
+  sendPos = tail;
+  sendOffset = 0;
+  inflight = 0;
+  size_t pos = tail;
+  for (uint16_t i = 0; i < records; i++) {
+    pos = normalize(pos);
+    if (outbound[pos + 8] == RECORD_SENT) {
+      outbound[pos + 8] = RECORD_PENDING;
+      outbound[pos + RECORD_HEADER] |= MQTT_DUP;
+      statistics.retransmitted++;
+    }
+    pos = next_record(pos);
+  }
+}
+
+bool MqttClient::write_outbound(bool current) {
+  while (records > 0 && sendPos != head) {
+    size_t pos = normalize(sendPos);
+    uint16_t len = read_u16(outbound + pos);
+    uint16_t id = read_u16(outbound + pos + 2);
+    if (outbound[pos + 8] != RECORD_PENDING) {
+      // Ya confirmado en una sesion anterior
+      sendPos = next_record(pos);
+      continue;
+    }
+    if (id != 0 && sendOffset == 0 && inflight >= MQTT_MAX_INFLIGHT) {
+      return false;
+    }
+
+    size_t escritos = transport.write(outbound + pos + RECORD_HEADER + sendOffset, len - sendOffset);
+    if (escritos > 0) {
+      lastSent = clock();
+    }
+    sendOffset += escritos;
+    if (sendOffset < len) {
+      statistics.stalls++;
+      return false;
+    }
+    sendOffset = 0;
+    statistics.sent++;
+    if (id != 0) {
+      if (inflight == 0) {
+        ackWaitSince = lastSent;
+      }
+      inflight++;
+      outbound[pos + 8] = RECORD_SENT;
+    } else {
+      outbound[pos + 8] = RECORD_DONE;
+    }
+    sendPos = next_record(pos);
+    if (current) {
+      return true;
+    }
+  }
+  return true;
+}
+
+void MqttClient::acknowledge(uint16_t packetId) {
+  size_t pos = tail;
+  for (uint16_t i = 0; i < records && pos != sendPos; i++) {
+    pos = normalize(pos);
+    if (read_u16(outbound + pos + 2) == packetId && outbound[pos + 8] == RECORD_SENT) {
+      uint32_t publicado;
+      memcpy(&publicado, outbound + pos + 4, sizeof(publicado));
+      unsigned long ahora = clock();
+      metrics_observe(&statistics.ackLatency, (uint32_t)(ahora - publicado));
+      statistics.acked++;
+      outbound[pos + 8] = RECORD_DONE;
+      inflight--;
+      ackWaitSince = ahora;
+      return;
+    }
+    pos = next_record(pos);
+  }
+}
+
+/*
+///////////////// RECEPCION \\\\\\\\\\\\\\\\\
+*/
+void MqttClient::read_inbound() {
+  while (open) {
+    size_t leidos = transport.read(inbound + inboundLen, sizeof(inbound) - inboundLen);
+    if (leidos == 0) {
+      return;
+    }
+    // Resto de un paquete demasiado grande
+    if (discard > 0) {
+      size_t descartados = leidos < discard ? leidos : discard;
+      memmove(inbound + inboundLen, inbound + inboundLen + descartados, leidos - descartados);
+      leidos -= descartados;
+      discard -= descartados;
+    }
+    inboundLen += leidos;
+
+    size_t offset = 0;
+    while (inboundLen - offset >= 2) {
+      uint8_t* paquete = inbound + offset;
+      size_t disponible = inboundLen - offset;
+      size_t restante = 0;
+      size_t cabecera = 1;
+      bool completa = false;
+      for (uint32_t factor = 1; cabecera < disponible && cabecera <= 4; factor *= 128) {
+        uint8_t byte = paquete[cabecera++];
+        restante += (byte & 0x7F) * factor;
+        if (!(byte & 0x80)) {
+          completa = true;
+          break;
+        }
+      }
+      if (!completa) {
+        if (cabecera > 4) {
+          // Longitud de mas de 4 bytes: el flujo esta corrupto
+          lost();
+          return;
+        }
+        break;
+      }
+      size_t total = cabecera + restante;
+      if (total > sizeof(inbound)) {
+        discard = total - disponible;
+        offset = inboundLen;
+        break;
+      }
+      if (disponible < total) {
+        break;
+      }
+      if (!handle_packet(paquete, total, cabecera)) {
+        lost();
+        return;
+      }
+      offset += total;
+    }
+    memmove(inbound, inbound + offset, inboundLen - offset);
+    inboundLen -= offset;
+  }
+}
+
+bool MqttClient::handle_packet(uint8_t* packet, size_t len, size_t bodyOffset) {
+  uint8_t* body = packet + bodyOffset;
+  size_t bodyLen = len - bodyOffset;
+  switch (packet[0] >> 4) {
+    case MQTT_CONNACK:
+      // Codigo de retorno distinto de 0: el broker rechaza la conexion
+      if (bodyLen < 2 || body[1] != 0) {
+        return false;
+      }
+      session = true;
+      statistics.connects++;
+      return true;
+    case MQTT_PUBACK:
+      if (bodyLen >= 2) {
+        acknowledge(read_u16(body));
+      }
+      return true;
+    case MQTT_PINGRESP:
+      pingPending = false;
+      return true;
+    case MQTT_SUBACK:
+      return true;
+    case MQTT_PUBLISH: {
+      uint8_t qos = (packet[0] >> 1) & 0x03;
+      if (bodyLen < 2) {
+        return false;
+      }
+      size_t topicLen = read_u16(body);
+      size_t cabecera = 2 + topicLen + (qos > 0 ? 2 : 0);
+      if (cabecera > bodyLen) {
+        return false;
+      }
+      uint16_t id = qos > 0 ? read_u16(body + 2 + topicLen) : 0;
+      // El topic se adelanta sobre su longitud para terminarlo en '\0' sin copiarlo
+      memmove(body, body + 2, topicLen);
+      body[topicLen] = '\0';
+      if (callback != nullptr) {
+        callback((const char*)body, body + cabecera, (unsigned int)(bodyLen - cabecera));
+      }
+      if (qos == 1) {
+        uint8_t puback[4] = {MQTT_PUBACK << 4, 0x02, 0, 0};
+        put_u16(puback + 2, id);
+        queue_control(puback, sizeof(puback));
+      }
+      return true;
+    }
+    default:
+      return true;
+  }
+}
@@ -0,0 +1,233 @@
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <metrics.h>
+
+/*
+///////////////// CLIENTE MQTT 3.1.1 SIN BLOQUEOS \\\\\\\\\\\\\\\\\
+*/
+// publish() codifica el PUBLISH directamente en un anillo de salida reservado de antemano y
+// vuelve sin tocar el socket. pump() escribe en el socket solo lo que acepta sin esperar,
+// lee lo que haya llegado, atiende el keepalive y detecta la perdida de la sesion. Los
+// mensajes QoS 1 siguen en el anillo hasta su PUBACK, con hasta MQTT_MAX_INFLIGHT en vuelo;
+// si la sesion cae antes, se reenvian (con DUP) tras reconectar.
+// No depende de Arduino: el socket lo aporta el llamante a traves de MqttTransport.
+
+// Tamaño (bytes) del anillo de salida: mensajes pendientes de enviar o de confirmar
+#ifndef MQTT_OUTBOUND_SIZE
+#define MQTT_OUTBOUND_SIZE 2048
+#endif
+
+// Mensajes QoS 1 enviados a la vez sin esperar su PUBACK
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 4
+#endif
+
+// Tamaño (bytes) del buffer de entrada: los paquetes recibidos mayores se descartan
+#ifndef MQTT_INBOUND_SIZE
+#define MQTT_INBOUND_SIZE 512
+#endif
+
+// Intervalo de keepalive (s) que se anuncia al broker
+#ifndef MQTT_KEEPALIVE
+#define MQTT_KEEPALIVE 15
+#endif
+
+// Espera maxima (ms) del CONNACK, del PINGRESP y de cada PUBACK antes de dar la sesion
+// por perdida
+#ifndef MQTT_ACK_TIMEOUT
+#define MQTT_ACK_TIMEOUT 10000UL
+#endif
+
+// Paquetes de control pendientes (CONNECT, SUBSCRIBE, PUBACK, PINGREQ): pasan por delante del
+// anillo. Un CONNECT o SUBSCRIBE lleva un identificador o un topic, ademas de la cabecera
+#define MQTT_CONTROL_SIZE 160
+
+/**
+ * @brief Socket TCP del cliente. Solo connect() puede bloquear (acotado); write() y read()
+ * devuelven de inmediato con lo que se ha podido transferir.
+ */
+class MqttTransport {
+public:
+  virtual ~MqttTransport() {}
+
+  virtual bool connect(const char* host, uint16_t port) = 0;
+  virtual bool connected() = 0;
+
+  /**
+   * @brief Escribe sin esperar.
+   *
+   * @return Bytes aceptados por la pila TCP (0 si el buffer de envio esta lleno).
+   */
+  virtual size_t write(const uint8_t* data, size_t len) = 0;
+
+  /**
+   * @brief Lee sin esperar.
+   *
+   * @return Bytes leidos (0 si no ha llegado nada).
+   */
+  virtual size_t read(uint8_t* buffer, size_t len) = 0;
+
+  virtual void stop() = 0;
+};
+
+/**
+ * @brief Funcion que recibe los mensajes de los topics suscritos. El payload pertenece al
+ * buffer de entrada y solo es valido durante la llamada (se puede modificar en el sitio).
+ */
+typedef void (*MqttCallback)(const char* topic, uint8_t* payload, unsigned int len);
+
+/**
+ * @brief Estadisticas del cliente.
+ */
+struct MqttStats {
+  // sesiones establecidas (CONNACK aceptado)
+  uint32_t connects;
+  // mensajes aceptados en el anillo, escritos completos en el socket y confirmados
+  uint32_t queued;
+  uint32_t sent;
+  uint32_t acked;
+  // mensajes rechazados por no caber en el anillo
+  uint32_t dropped;
+  // mensajes QoS 1 reenviados tras perder la sesion sin su PUBACK
+  uint32_t retransmitted;
+  // veces que el socket no ha aceptado todo lo pendiente (buffer de envio lleno)
+  uint32_t stalls;
+  // tiempo desde publish() hasta el PUBACK
+  Histogram ackLatency;
+};
+
+class MqttClient {
+public:
+  /**
+   * @param transport Socket del cliente.
+   * @param clockUs Base de tiempo en microsegundos (micros()).
+   */
+  MqttClient(MqttTransport& transport, unsigned long (*clockUs)());
+
+  void setServer(const char* host, uint16_t port);
+  void setCallback(MqttCallback callback);
+
+  /**
+   * @brief Abre el socket y deja el CONNECT (sesion limpia) pendiente de envio. La sesion
+   * queda establecida cuando pump() recibe el CONNACK.
+   *
+   * @param clientId Identificador del cliente.
+   * @return false si no se ha podido abrir el socket.
+   */
+  bool connect(const char* clientId);
+
+  /**
+   * @brief true si la sesion esta establecida (CONNACK recibido) y el socket sigue abierto.
+   */
+  bool connected() const { return session; }
+
+  /**
+   * @brief true mientras hay un socket abierto, con la sesion establecida o a la espera del
+   * CONNACK.
+   */
+  bool connecting() const { return open; }
+
+  /**
+   * @brief Copia el mensaje en el anillo de salida. No escribe en el socket.
+   *
+   * @param topic Topic en el que se publica.
+   * @param payload Contenido del mensaje.
+   * @param len Longitud del mensaje.
+   * @param qos 0 o 1.
+   * @return false si el mensaje no cabe en el anillo (se cuenta en dropped).
+   */
+  bool publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos = 1);
+
+  /**
+   * @brief Deja pendiente la suscripcion a un topic. Requiere un socket abierto; tras cada
+   * reconexion hay que repetirla (sesion limpia).
+   */
+  bool subscribe(const char* topic, uint8_t qos);
+
+  /**
+   * @brief Cierra la sesion (DISCONNECT si el socket lo acepta sin esperar). Los mensajes sin
+   * confirmar se conservan para la siguiente sesion.
+   */
+  void disconnect();
+
+  /**
+   * @brief Escribe lo pendiente que acepte el socket, procesa lo recibido y atiende el
+   * keepalive y los tiempos de espera. Nunca bloquea.
+   */
+  void pump();
+
+  /**
+   * @brief Mensajes en el anillo: pendientes de enviar o enviados sin confirmar.
+   */
+  uint16_t pending() const { return records; }
+
+  /**
+   * @brief Bytes ocupados del anillo.
+   */
+  size_t pendingBytes() const;
+
+  /**
+   * @brief Mensajes QoS 1 enviados a la espera de su PUBACK.
+   */
+  uint8_t inFlight() const { return inflight; }
+
+  const MqttStats& stats() const { return statistics; }
+
+private:
+  MqttTransport& transport;
+  unsigned long (*clock)();
+  const char* host;
+  uint16_t port;
+  MqttCallback callback;
+
+  bool open;
+  bool session;
+  unsigned long openedAt;
+  unsigned long lastSent;
+  bool pingPending;
+  unsigned long pingSentAt;
+  // ultimo PUBACK recibido o envio del primer mensaje en vuelo
+  unsigned long ackWaitSince;
+  uint16_t nextPacketId;
+  // dentro de pump(): un callback no puede volver a entrar
+  bool busy;
+
+  // Anillo de salida: registros contiguos (cabecera y paquete) desde tail hasta head;
+  // sendPos es el siguiente por enviar y sendOffset lo ya escrito de el
+  uint8_t outbound[MQTT_OUTBOUND_SIZE];
+  size_t head;
+  size_t tail;
+  size_t sendPos;
+  size_t sendOffset;
+  uint16_t records;
+  uint8_t inflight;
+
+  uint8_t control[MQTT_CONTROL_SIZE];
+  size_t controlLen;
+  size_t controlSent;
+
+  uint8_t inbound[MQTT_INBOUND_SIZE];
+  size_t inboundLen;
+  // bytes que quedan por descartar de un paquete recibido demasiado grande
+  uint32_t discard;
+
+  MqttStats statistics;
+
+  void lost();
+  bool queue_control(const uint8_t* packet, size_t len);
+  uint8_t* allocate(size_t len);
+  size_t normalize(size_t pos) const;
+  size_t next_record(size_t pos) const;
+  void release();
+  void rewind();
+  bool write_control();
+  bool write_outbound(bool current);
+  void read_inbound();
+  bool handle_packet(uint8_t* packet, size_t len, size_t bodyOffset);
+  void acknowledge(uint16_t packetId);
+};
+
+#endif // MQTT_H
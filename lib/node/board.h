@@ -0,0 +1,87 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <Arduino.h>
+
+/*
+///////////////// CARACTERISTICAS DE CADA PLACA \\\\\\\\\\\\\\\\\
+*/
+// Cada placa es un tipo con sus pines y constantes como constexpr: el compilador las
+// sustituye en cada uso y los drivers que no se usan no llegan a instanciarse.
+
+#if defined(ESP32)
+/**
+ * @brief Nodo esp32_1 (denky32): sonda DS18B20, DHT11, sensor capacitivo y LED RGB.
+ */
+struct Esp32Board {
+  // Prefijo del identificador del nodo (cliente MQTT)
+  static const char* prefijo() { return "esp32"; }
+  // Identificador unico del chip: los 3 ultimos bytes de la MAC de fabrica
+  static uint32_t chipId() { return (uint32_t)(ESP.getEfuseMac() >> 24) & 0xFFFFFF; }
+  // Numero aleatorio del generador hardware
+  static uint32_t aleatorio() { return esp_random(); }
+  // Memoria dinamica libre y mayor bloque que se puede reservar de una vez
+  static uint32_t heapLibre() { return ESP.getFreeHeap(); }
+  static uint32_t bloqueLibreMaximo() { return ESP.getMaxAllocHeap(); }
+
+  // LED RGB //
+  static constexpr uint8_t pinRojo = 23;
+  static constexpr uint8_t pinVerde = 21;
+  static constexpr uint8_t pinAzul = 22;
+  // LED de la placa (-1 si no se usa)
+  static constexpr int8_t pinLedPlaca = -1;
+
+  // Sensores //
+  static constexpr uint8_t pinDht = 32;
+  static constexpr uint8_t pinSonda = 33;
+  static constexpr uint8_t pinSuelo = 35;
+
+  // ADC de 12 bits con referencia de 3.3V
+  static constexpr uint16_t adcMax = 4095;
+  static constexpr float adcVref = 3.3f;
+  // Calibracion por defecto del sensor capacitivo: lectura en aire y en agua
+  static constexpr uint16_t sueloAire = 990;
+  static constexpr uint16_t sueloAgua = 2870;
+};
+typedef Esp32Board Board;
+
+#elif defined(ESP8266)
+/**
+ * @brief Nodo nodemcu_1: DHT11, sensor capacitivo y LED RGB, sin sonda DS18B20.
+ */
+struct NodeMcuBoard {
+  // Prefijo del identificador del nodo (cliente MQTT)
+  static const char* prefijo() { return "nodemcu"; }
+  // Identificador unico del chip: los 3 ultimos bytes de la MAC de fabrica
+  static uint32_t chipId() { return ESP.getChipId(); }
+  // Numero aleatorio del generador hardware
+  static uint32_t aleatorio() { return RANDOM_REG32; }
+  // Memoria dinamica libre y mayor bloque que se puede reservar de una vez
+  static uint32_t heapLibre() { return ESP.getFreeHeap(); }
+  static uint32_t bloqueLibreMaximo() { return ESP.getMaxFreeBlockSize(); }
+
+  // LED RGB //
+  static constexpr uint8_t pinRojo = D7;
+  static constexpr uint8_t pinVerde = D6;
+  static constexpr uint8_t pinAzul = D5;
+  // LED de la placa, se enciende durante la lectura del DHT11
+  static constexpr int8_t pinLedPlaca = LED_BUILTIN;
+
+  // Sensores //
+  static constexpr uint8_t pinDht = D4;
+  static constexpr uint8_t pinSuelo = A0;
+
+  // ADC de 10 bits con referencia de 3.3V
+  static constexpr uint16_t adcMax = 1023;
+  static constexpr float adcVref = 3.3f;
+  // Calibracion por defecto del sensor capacitivo: lectura en aire y en agua
+  static constexpr uint16_t sueloAire = 257;
+  static constexpr uint16_t sueloAgua = 646;
+};
+typedef NodeMcuBoard Board;
+
+#else
+#error "Placa no soportada: se esperaba ESP32 o ESP8266"
+#endif
+
+#endif // BOARD_H
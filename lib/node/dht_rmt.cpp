@@ -0,0 +1,148 @@
+#if defined(ESP32)
+
+#include "dht_rmt.h"
+#include <Arduino.h>
+#include <driver/gpio.h>
+#include <driver/rmt.h>
+
+// Con el reloj APB de 80 MHz, un tick del RMT es 1 us
+static const uint8_t RMT_CLK_DIV = 80;
+// Una linea en reposo mas de 200 us marca el final de la trama (el pulso mas largo dura 80 us)
+static const uint16_t RMT_IDLE_US = 200;
+// Filtro de glitches en ciclos de APB (1,25 us)
+static const uint8_t RMT_FILTER_TICKS = 100;
+// Buffer de recepcion del driver: una trama son 42 elementos de 4 bytes
+static const size_t RMT_RX_BUFFER = 512;
+// Duracion de la señal de inicio (ms): al menos 18 ms en el DHT11 y 1 ms en el DHT22
+static const uint8_t START_DHT11_MS = 20;
+static const uint8_t START_DHT22_MS = 2;
+
+static const rmt_channel_t canal = (rmt_channel_t)DHT_RMT_CHANNEL;
+static gpio_num_t pinDatos;
+static DhtModel modelo;
+static RingbufHandle_t anillo = nullptr;
+
+// Fases de una transaccion: la señal de inicio y la captura de la trama se reparten en
+// varias llamadas a dht_rmt_poll() para no bloquear la tarea que lee
+enum DhtPhase {
+  FASE_REPOSO,
+  FASE_INICIO,
+  FASE_CAPTURA,
+};
+
+static DhtPhase fase = FASE_REPOSO;
+// Comienzo de la fase en curso (ms)
+static uint32_t inicioFase = 0;
+
+// Resultado de la ultima transaccion
+static DhtReading ultima;
+static uint32_t ultimaTransaccion = 0;
+static bool leido = false;
+
+static DhtStats stats = {0, 0, 0, DHT_TIMEOUT};
+
+void dht_rmt_begin(uint8_t pin, DhtModel model) {
+  pinDatos = (gpio_num_t)pin;
+  modelo = model;
+
+  rmt_config_t config = RMT_DEFAULT_CONFIG_RX(pinDatos, canal);
+  config.clk_div = RMT_CLK_DIV;
+  config.rx_config.filter_en = true;
+  config.rx_config.filter_ticks_thresh = RMT_FILTER_TICKS;
+  config.rx_config.idle_threshold = RMT_IDLE_US;
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(canal, RMT_RX_BUFFER, 0) != ESP_OK ||
+      rmt_get_ringbuf_handle(canal, &anillo) != ESP_OK) {
+    anillo = nullptr;
+    return;
+  }
+
+  // rmt_config() deja el pin como entrada: se añade la salida en colector abierto para la
+  // señal de inicio, sin desconectar la entrada del RMT. En reposo la linea queda alta
+  gpio_set_pull_mode(pinDatos, GPIO_PULLUP_ONLY);
+  gpio_set_direction(pinDatos, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_set_level(pinDatos, 1);
+}
+
+static void finish(DhtStatus estado) {
+  rmt_rx_stop(canal);
+  stats.lastStatus = estado;
+  stats.transactions++;
+  if (estado != DHT_OK) {
+    stats.errors++;
+  }
+  fase = FASE_REPOSO;
+}
+
+void dht_rmt_start() {
+  uint32_t ahora = millis();
+  if (fase != FASE_REPOSO) {
+    return;
+  }
+  if (leido && ahora - ultimaTransaccion < DHT_MIN_INTERVAL_MS) {
+    stats.cached++;
+    return;
+  }
+  ultimaTransaccion = ahora;
+  leido = true;
+  if (anillo == nullptr) {
+    stats.lastStatus = DHT_TIMEOUT;
+    stats.transactions++;
+    stats.errors++;
+    return;
+  }
+
+  // Descarta capturas atrasadas de una transaccion anterior
+  size_t size;
+  void* pendiente;
+  while ((pendiente = xRingbufferReceive(anillo, &size, 0)) != nullptr) {
+    vRingbufferReturnItem(anillo, pendiente);
+  }
+
+  // Señal de inicio: linea baja hasta que dht_rmt_poll() la libere. Si la tarea se retrasa la
+  // señal se alarga, y el sensor solo exige una duracion minima
+  gpio_set_level(pinDatos, 0);
+  fase = FASE_INICIO;
+  inicioFase = ahora;
+}
+
+bool dht_rmt_poll() {
+  uint32_t ahora = millis();
+  if (fase == FASE_INICIO) {
+    if (ahora - inicioFase < (modelo == DHT_MODEL_DHT11 ? START_DHT11_MS : START_DHT22_MS)) {
+      return false;
+    }
+    // Se libera la linea y el RMT captura la respuesta; los bits que se pierdan al principio
+    // son los del pulso de respuesta, que la decodificacion no necesita
+    gpio_set_level(pinDatos, 1);
+    rmt_rx_start(canal, true);
+    fase = FASE_CAPTURA;
+    inicioFase = ahora;
+  }
+  if (fase == FASE_CAPTURA) {
+    // Sin espera: si la trama no ha llegado se vuelve a mirar en la siguiente llamada
+    size_t size;
+    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(anillo, &size, 0);
+    if (items == nullptr) {
+      if (ahora - inicioFase < DHT_RMT_TIMEOUT_MS) {
+        return false;
+      }
+      finish(DHT_TIMEOUT);
+    } else {
+      DhtStatus estado = dht_decode(&items[0].val, size / sizeof(rmt_item32_t), modelo, &ultima);
+      vRingbufferReturnItem(anillo, items);
+      finish(estado);
+    }
+  }
+  return true;
+}
+
+DhtStatus dht_rmt_result(DhtReading* reading) {
+  *reading = ultima;
+  return stats.lastStatus;
+}
+
+const DhtStats& dht_rmt_stats() {
+  return stats;
+}
+
+#endif // ESP32
@@ -0,0 +1,80 @@
+#ifndef DHT_RMT_H
+#define DHT_RMT_H
+
+#include <stdint.h>
+#include <dht_frame.h>
+
+/*
+///////////////// DHT11/DHT22 CON EL PERIFERICO RMT DEL ESP32 \\\\\\\\\\\\\\\\\
+*/
+// La libreria de Adafruit mide los 40 bits por software con las interrupciones desactivadas
+// durante unos 5 ms, lo que retrasa la pila WiFi. Aqui el canal RMT captura la duracion de
+// los pulsos en hardware y la trama se decodifica despues desde el buffer (dht_frame), con
+// las interrupciones activas. Una transaccion da temperatura y humedad a la vez.
+
+// Canal RMT de recepcion
+#ifndef DHT_RMT_CHANNEL
+#define DHT_RMT_CHANNEL 4
+#endif
+
+// Intervalo minimo (ms) entre transacciones: el sensor no admite lecturas mas frecuentes.
+// Dentro del intervalo se devuelve el resultado de la ultima
+#ifndef DHT_MIN_INTERVAL_MS
+#define DHT_MIN_INTERVAL_MS 2000UL
+#endif
+
+// Espera maxima (ms) de la trama tras la señal de inicio (la trama completa dura unos 5 ms)
+#ifndef DHT_RMT_TIMEOUT_MS
+#define DHT_RMT_TIMEOUT_MS 10
+#endif
+
+/**
+ * @brief Estadisticas del driver.
+ */
+struct DhtStats {
+  // transacciones con el sensor y cuantas han fallado
+  uint32_t transactions;
+  uint32_t errors;
+  // lecturas servidas con el resultado anterior por no haber pasado DHT_MIN_INTERVAL_MS
+  uint32_t cached;
+  DhtStatus lastStatus;
+};
+
+/**
+ * @brief Configura el canal RMT y el pin del sensor (en colector abierto, con pull-up).
+ *
+ * @param pin Pin de datos del sensor.
+ * @param model Modelo del sensor.
+ */
+void dht_rmt_begin(uint8_t pin, DhtModel model);
+
+/**
+ * @brief Inicia una transaccion sin esperar: baja la linea para la señal de inicio. El resto
+ * de la transaccion avanza con dht_rmt_poll(). Si no ha pasado DHT_MIN_INTERVAL_MS desde la
+ * anterior no se inicia ninguna y dht_rmt_result() devuelve el resultado anterior.
+ */
+void dht_rmt_start();
+
+/**
+ * @brief Avanza la transaccion en curso sin bloquear. Pasada la señal de inicio (20 ms en el
+ * DHT11) libera la linea y arranca la captura; despues recoge la trama del RMT y la decodifica.
+ * Se llama periodicamente desde el planificador.
+ *
+ * @return true cuando no queda transaccion en curso y el resultado esta disponible.
+ */
+bool dht_rmt_poll();
+
+/**
+ * @brief Resultado de la ultima transaccion terminada.
+ *
+ * @param reading Lectura (la ultima valida si no ha pasado DHT_MIN_INTERVAL_MS).
+ * @return DHT_OK si la lectura es valida.
+ */
+DhtStatus dht_rmt_result(DhtReading* reading);
+
+/**
+ * @brief Estadisticas del driver, para informes.
+ */
+const DhtStats& dht_rmt_stats();
+
+#endif // DHT_RMT_H
@@ -0,0 +1,122 @@
+#include "node_config.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include "node_mqtt.h"
+#include <stddef.h>
+#include <string.h>
+
+// Copia en flash de la ultima configuracion recibida
+struct StoredConfig {
+  uint32_t magic;
+  NodeConfig config;
+  uint32_t crc;
+};
+
+static const uint32_t CONFIG_MAGIC = 0x4e434631;
+static const char* const CONFIG_PATH = "/config.bin";
+
+// Limites de la cobertura en milisegundos
+static const uint32_t COBERTURA_MINIMA = 1000UL;
+static const uint32_t COBERTURA_MAXIMA = 3600000UL;
+
+static NodeConfig* actual = nullptr;
+static NodeConfigCallback alAplicar = nullptr;
+
+// FNV-1a: protege el contenido del fichero
+static uint32_t fnv1a(const uint8_t* data, size_t len) {
+  uint32_t hash = 2166136261u;
+  while (len--) {
+    hash ^= *data++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool load_config(NodeConfig* config) {
+  File fichero = LittleFS.open(CONFIG_PATH, "r");
+  if (!fichero) {
+    return false;
+  }
+  StoredConfig guardada;
+  bool leido = fichero.read((uint8_t*)&guardada, sizeof(guardada)) == sizeof(guardada);
+  fichero.close();
+  if (!leido || guardada.magic != CONFIG_MAGIC ||
+      guardada.crc != fnv1a((const uint8_t*)&guardada, offsetof(StoredConfig, crc)) ||
+      !sampler_config_valid(guardada.config.sampler)) {
+    return false;
+  }
+  *config = guardada.config;
+  return true;
+}
+
+static void store_config(const NodeConfig& config) {
+  StoredConfig guardada;
+  memset(&guardada, 0, sizeof(guardada));
+  guardada.magic = CONFIG_MAGIC;
+  guardada.config = config;
+  guardada.crc = fnv1a((const uint8_t*)&guardada, offsetof(StoredConfig, crc));
+  File fichero = LittleFS.open(CONFIG_PATH, "w");
+  if (fichero) {
+    fichero.write((const uint8_t*)&guardada, sizeof(guardada));
+    fichero.close();
+  }
+}
+
+// Convierte un periodo en segundos a milisegundos si esta dentro de los limites
+static bool period_ms(float segundos, uint32_t minimo, uint32_t maximo, uint32_t* ms) {
+  if (!(segundos * 1000.0f >= minimo && segundos * 1000.0f <= maximo)) {
+    return false;
+  }
+  *ms = (uint32_t)(segundos * 1000.0f + 0.5f);
+  return true;
+}
+
+bool node_config_parse(char* json, size_t len, NodeConfig* config) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(8)> documento;
+  // Entrada modificable: ArduinoJson no copia las claves
+  if (deserializeJson(documento, json, len)) {
+    return false;
+  }
+
+  NodeConfig nueva = *config;
+  bool ok = period_ms(documento["periodo_min"] | nueva.sampler.minPeriod / 1000.0f, SAMPLER_LIMIT_MIN,
+                      SAMPLER_LIMIT_MAX, &nueva.sampler.minPeriod) &&
+            period_ms(documento["periodo_max"] | nueva.sampler.maxPeriod / 1000.0f, SAMPLER_LIMIT_MIN,
+                      SAMPLER_LIMIT_MAX, &nueva.sampler.maxPeriod) &&
+            period_ms(documento["cobertura"] | nueva.coveragePeriod / 1000.0f, COBERTURA_MINIMA, COBERTURA_MAXIMA,
+                      &nueva.coveragePeriod);
+  nueva.sampler.rateTemperature = documento["velocidad_temperatura"] | nueva.sampler.rateTemperature;
+  nueva.sampler.rateHumidity = documento["velocidad_humedad"] | nueva.sampler.rateHumidity;
+
+  if (!ok || !sampler_config_valid(nueva.sampler)) {
+    return false;
+  }
+  *config = nueva;
+  return true;
+}
+
+static void on_config(const char* topic, uint8_t* payload, unsigned int len) {
+  NodeConfig nueva = *actual;
+  if (!node_config_parse((char*)payload, len, &nueva)) {
+    Serial.print("Configuracion no valida en ");
+    Serial.println(topic);
+    return;
+  }
+  // El mensaje retenido se vuelve a recibir en cada reconexion: solo cuenta si cambia algo
+  if (memcmp(&nueva, actual, sizeof(nueva)) == 0) {
+    return;
+  }
+  *actual = nueva;
+  store_config(nueva);
+  if (alAplicar != nullptr) {
+    alAplicar(nueva);
+  }
+}
+
+void node_config_begin(const char* topic, NodeConfig* config, NodeConfigCallback applied) {
+  actual = config;
+  alAplicar = applied;
+  load_config(config);
+  mqtt_subscribe(topic, on_config);
+}
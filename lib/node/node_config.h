@@ -0,0 +1,52 @@
+#ifndef NODE_CONFIG_H
+#define NODE_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <adaptive_sampler.h>
+
+/*
+///////////////// CONFIGURACION REMOTA DEL NODO \\\\\\\\\\\\\\\\\
+*/
+// El nodo se suscribe a "<nodo>/config", donde se publica un mensaje JSON retenido con los
+// parametros que se quieren cambiar (los que faltan conservan su valor):
+//   {"periodo_min": 10, "periodo_max": 300, "velocidad_temperatura": 0.2,
+//    "velocidad_humedad": 1.0, "cobertura": 60}
+// Periodos en segundos y velocidades en unidades por minuto. La configuracion se aplica sin
+// reiniciar y se guarda en LittleFS para el siguiente arranque.
+
+/**
+ * @brief Parametros configurables del nodo.
+ */
+struct NodeConfig {
+  SamplerConfig sampler;
+  // periodo de la medida de cobertura en milisegundos
+  uint32_t coveragePeriod;
+};
+
+/**
+ * @brief Funcion que aplica una configuracion nueva (ya validada y guardada).
+ */
+typedef void (*NodeConfigCallback)(const NodeConfig& config);
+
+/**
+ * @brief Recupera la configuracion guardada y se suscribe al topic de configuracion.
+ * Requiere LittleFS montado y mqtt_init() hecho.
+ *
+ * @param topic Topic de configuracion ("<nodo>/config").
+ * @param config Valores por defecto a la entrada; configuracion guardada a la salida, si la hay.
+ * @param applied Funcion que se llama con cada configuracion nueva recibida.
+ */
+void node_config_begin(const char* topic, NodeConfig* config, NodeConfigCallback applied);
+
+/**
+ * @brief Interpreta un mensaje de configuracion sobre la configuracion actual.
+ *
+ * @param json Mensaje JSON (se modifica en el sitio).
+ * @param len Longitud del mensaje.
+ * @param config Configuracion actual; se actualiza solo si el mensaje es valido.
+ * @return false si el mensaje no es JSON o los valores no son coherentes.
+ */
+bool node_config_parse(char* json, size_t len, NodeConfig* config);
+
+#endif // NODE_CONFIG_H
@@ -0,0 +1,158 @@
+#include "node_espnow.h"
+
+#if defined(ESP32)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <spsc_ring.h>
+#include <atomic>
+#include <string.h>
+
+// Resultado del ultimo envio, escrito por la tarea de WiFi
+enum EspNowSendState : uint8_t {
+  ENVIO_PENDIENTE = 0,
+  ENVIO_CONFIRMADO = 1,
+  ENVIO_FALLIDO = 2,
+};
+
+static std::atomic<uint8_t> estadoEnvio(ENVIO_CONFIRMADO);
+static uint8_t destino[6];
+static bool hayDestino = false;
+
+// Unico productor: on_received() en la tarea de WiFi. Unico consumidor: espnow_gateway_receive()
+static SpscRing<LinkPacket, ESPNOW_RX_QUEUE> recibidas;
+// RSSI de la ultima trama de accion capturada; la escribe y la lee la tarea de WiFi
+static int8_t ultimoRssi = 0;
+
+static Gateway pasarela;
+
+static void on_sent(const uint8_t* mac, esp_now_send_status_t status) {
+  (void)mac;
+  estadoEnvio.store(status == ESP_NOW_SEND_SUCCESS ? ENVIO_CONFIRMADO : ENVIO_FALLIDO, std::memory_order_release);
+}
+
+static void on_received(const uint8_t* mac, const uint8_t* data, int len) {
+  if (len <= 0 || len > LINK_FRAME_SIZE) {
+    return;
+  }
+  LinkPacket packet;
+  memcpy(packet.mac, mac, sizeof(packet.mac));
+  packet.rssi = ultimoRssi;
+  packet.len = len;
+  packet.receivedAt = millis();
+  memcpy(packet.data, data, len);
+  recibidas.push(packet);
+}
+
+// ESP-NOW no informa del RSSI: se toma de la trama de accion (subtipo 0xD0, categoria 127 del
+// fabricante) que llega justo antes del callback de recepcion, en la misma tarea de WiFi
+static void on_sniffed(void* buffer, wifi_promiscuous_pkt_type_t type) {
+  if (type != WIFI_PKT_MGMT) {
+    return;
+  }
+  const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buffer;
+  if (pkt->rx_ctrl.sig_len > 24 && pkt->payload[0] == 0xD0 && pkt->payload[24] == 127) {
+    ultimoRssi = pkt->rx_ctrl.rssi;
+  }
+}
+
+/**
+ * @brief LinkTransport sobre ESP-NOW: un envio cada vez, con la confirmacion de la capa MAC.
+ */
+class EspNowTransport : public LinkTransport {
+public:
+  bool send(const uint8_t* frame, size_t len) override {
+    estadoEnvio.store(ENVIO_PENDIENTE, std::memory_order_relaxed);
+    if (esp_now_send(hayDestino ? destino : nullptr, frame, len) != ESP_OK) {
+      return false;
+    }
+    unsigned long inicio = millis();
+    uint8_t estado;
+    while ((estado = estadoEnvio.load(std::memory_order_acquire)) == ENVIO_PENDIENTE) {
+      if (millis() - inicio >= ESPNOW_ACK_TIMEOUT) {
+        return false;
+      }
+      delay(1);
+    }
+    return estado == ENVIO_CONFIRMADO;
+  }
+
+  bool receive(LinkPacket& packet) override {
+    return recibidas.pop(packet);
+  }
+};
+
+static EspNowTransport transporte;
+
+static bool espnow_start() {
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("ESP-NOW init failed");
+    return false;
+  }
+  esp_now_register_send_cb(on_sent);
+  esp_now_register_recv_cb(on_received);
+  return true;
+}
+
+bool espnow_leaf_begin(const uint8_t* gateway) {
+  // Modo estacion sin asociarse: la radio queda en el canal de la pasarela
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  if (!espnow_start()) {
+    return false;
+  }
+
+  esp_now_peer_info_t peer;
+  memset(&peer, 0, sizeof(peer));
+  memcpy(peer.peer_addr, gateway, sizeof(peer.peer_addr));
+  peer.channel = ESPNOW_CHANNEL;
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  if (esp_now_add_peer(&peer) != ESP_OK) {
+    Serial.println("ESP-NOW gateway peer not added");
+    return false;
+  }
+  memcpy(destino, gateway, sizeof(destino));
+  hayDestino = true;
+  return true;
+}
+
+bool espnow_gateway_begin(uint8_t batchSize, uint32_t maxLatency) {
+  gateway_init(&pasarela, batchSize, maxLatency);
+
+  // Con el ahorro de energia la radio duerme entre balizas y las tramas se pierden
+  WiFi.setSleep(false);
+  if (!espnow_start()) {
+    return false;
+  }
+
+  wifi_promiscuous_filter_t filtro;
+  filtro.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+  esp_wifi_set_promiscuous_filter(&filtro);
+  esp_wifi_set_promiscuous_rx_cb(on_sniffed);
+  esp_wifi_set_promiscuous(true);
+  return true;
+}
+
+LinkTransport& espnow_transport() {
+  return transporte;
+}
+
+bool espnow_gateway_receive(GatewayLeaf** leaf) {
+  LinkPacket packet;
+  if (!recibidas.pop(packet)) {
+    return false;
+  }
+  *leaf = gateway_accept(&pasarela, packet);
+  return true;
+}
+
+Gateway& espnow_gateway() {
+  return pasarela;
+}
+
+uint32_t espnow_rx_overflows() {
+  return recibidas.overflows();
+}
+#endif
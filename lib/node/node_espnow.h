@@ -0,0 +1,75 @@
+#ifndef NODE_ESPNOW_H
+#define NODE_ESPNOW_H
+
+#include <stdint.h>
+#include <sensor_link.h>
+#include <gateway.h>
+
+/*
+///////////////// ENLACE ESP-NOW CON LA PASARELA \\\\\\\\\\\\\\\\\
+*/
+// Medio de sensor_link sobre ESP-NOW (solo ESP32). El nodo hoja no se asocia al punto de
+// acceso: envia cada trama en unicast a la pasarela, que la confirma en la capa MAC. La
+// pasarela si esta asociada y publica por MQTT, asi que ESP-NOW funciona en el canal del punto
+// de acceso: el de los nodos hoja (ESPNOW_CHANNEL) tiene que coincidir con el.
+
+// Canal WiFi de los nodos hoja: el del punto de acceso al que se asocia la pasarela
+#ifndef ESPNOW_CHANNEL
+#define ESPNOW_CHANNEL 1
+#endif
+
+// Espera maxima (ms) de la confirmacion de cada envio; ESP-NOW la da en pocos ms
+#ifndef ESPNOW_ACK_TIMEOUT
+#define ESPNOW_ACK_TIMEOUT 30
+#endif
+
+// Tramas recibidas pendientes de procesar en la pasarela (potencia de dos). Las recibe la
+// tarea de WiFi y las consume el bucle del planificador
+#ifndef ESPNOW_RX_QUEUE
+#define ESPNOW_RX_QUEUE 32
+#endif
+
+/**
+ * @brief Inicia ESP-NOW en un nodo hoja: modo estacion sin asociarse, en ESPNOW_CHANNEL, con
+ * la pasarela como unico destino.
+ *
+ * @param gateway MAC de la pasarela.
+ * @return false si no se ha podido iniciar.
+ */
+bool espnow_leaf_begin(const uint8_t* gateway);
+
+/**
+ * @brief Inicia ESP-NOW en la pasarela, con la WiFi ya iniciada (setup_wifi()). Desactiva el
+ * ahorro de energia de la radio, que haria perder tramas, y mide el RSSI de cada trama.
+ *
+ * @param batchSize Lecturas por lote de cada nodo.
+ * @param maxLatency Latencia maxima (ms) de la lectura mas antigua de un lote.
+ * @return false si no se ha podido iniciar.
+ */
+bool espnow_gateway_begin(uint8_t batchSize, uint32_t maxLatency);
+
+/**
+ * @brief Medio ESP-NOW: send() espera como mucho ESPNOW_ACK_TIMEOUT ms a la confirmacion.
+ */
+LinkTransport& espnow_transport();
+
+/**
+ * @brief Procesa la trama recibida mas antigua (ver gateway_accept()).
+ *
+ * @param leaf Nodo cuyo lote ha recibido una lectura nueva, o nullptr si la trama se ha
+ * descartado.
+ * @return false si no quedaban tramas por procesar.
+ */
+bool espnow_gateway_receive(GatewayLeaf** leaf);
+
+/**
+ * @brief Estado de la pasarela: nodos, lotes y contadores.
+ */
+Gateway& espnow_gateway();
+
+/**
+ * @brief Tramas perdidas por encontrar llena la cola de recepcion.
+ */
+uint32_t espnow_rx_overflows();
+
+#endif // NODE_ESPNOW_H
@@ -0,0 +1,313 @@
+#include "node_metrics.h"
+#include "board.h"
+#include "node_wifi.h"
+#include "node_time.h"
+#include "node_mqtt.h"
+#ifdef ESPNOW_GATEWAY
+#include "node_espnow.h"
+#endif
+#include <scheduler.h>
+#if defined(ESP32)
+#include <lwip/sockets.h>
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+NodeMetrics metricas;
+
+#if NODE_METRICS
+static WiFiServer servidor(METRICS_PORT);
+#endif
+
+// Limites de las cubetas en segundos, tal como los espera Prometheus
+static const char* const LIMITES[METRICS_BUCKETS] = {
+  "1e-05", "5e-05", "0.0001", "0.0005", "0.001", "0.002", "0.005", "0.01", "0.05", "0.1", "1", "5"};
+
+void metrics_observe_loop() {
+  const Task* tarea = scheduler_last_run();
+  if (tarea != nullptr) {
+    metrics_observe(&metricas.retraso, tarea->lastJitter * 1000UL);
+  }
+}
+
+// Escribe una linea con formato en el destino, sin memoria dinamica
+static void write_line(Print& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static void write_line(Print& out, const char* format, ...) {
+  char linea[128];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(linea, sizeof(linea), format, args);
+  va_end(args);
+  if (n > 0) {
+    out.write((const uint8_t*)linea, (size_t)n < sizeof(linea) ? n : sizeof(linea) - 1);
+  }
+}
+
+static void write_header(Print& out, const char* nombre, const char* tipo, const char* ayuda) {
+  write_line(out, "# HELP %s %s\n", nombre, ayuda);
+  write_line(out, "# TYPE %s %s\n", nombre, tipo);
+}
+
+static void write_histogram(Print& out, const char* nombre, const char* ayuda, const Histogram& histograma) {
+  write_header(out, nombre, "histogram", ayuda);
+  for (uint8_t cubeta = 0; cubeta < METRICS_BUCKETS; cubeta++) {
+    write_line(out, "%s_bucket{le=\"%s\"} %lu\n", nombre, LIMITES[cubeta],
+               (unsigned long)metrics_cumulative(histograma, cubeta));
+  }
+  write_line(out, "%s_bucket{le=\"+Inf\"} %lu\n", nombre, (unsigned long)metrics_cumulative(histograma, METRICS_BUCKETS));
+  // Suma en segundos con seis decimales, sin pasar por coma flotante
+  write_line(out, "%s_sum %lu.%06lu\n", nombre, (unsigned long)(histograma.sum / 1000000),
+             (unsigned long)(histograma.sum % 1000000));
+  write_line(out, "%s_count %lu\n", nombre, (unsigned long)histograma.count);
+}
+
+static void write_value(Print& out, const char* nombre, const char* tipo, const char* ayuda, unsigned long valor) {
+  write_header(out, nombre, tipo, ayuda);
+  write_line(out, "%s %lu\n", nombre, valor);
+}
+
+static void write_signed(Print& out, const char* nombre, const char* ayuda, long valor) {
+  write_header(out, nombre, "gauge", ayuda);
+  write_line(out, "%s %ld\n", nombre, valor);
+}
+
+void metrics_write(Print& out) {
+  write_histogram(out, "nodo_lectura_segundos", "Tiempo de adquisicion de los sensores", metricas.lectura);
+  write_histogram(out, "nodo_serializacion_segundos", "Tiempo de codificacion de los mensajes de lecturas",
+                  metricas.serializacion);
+  write_histogram(out, "nodo_publicacion_segundos", "Tiempo de entrega de un mensaje al cliente MQTT",
+                  metricas.publicacion);
+  write_histogram(out, "nodo_mqtt_confirmacion_segundos", "Tiempo desde la publicacion hasta el PUBACK",
+                  mqtt_client().stats().ackLatency);
+  write_histogram(out, "nodo_reconexion_segundos", "Duracion de cada intento de conexion con el broker",
+                  metricas.reconexion);
+  write_histogram(out, "nodo_retraso_tareas_segundos", "Retraso de cada tarea respecto a su deadline",
+                  metricas.retraso);
+
+  write_value(out, "nodo_lecturas_total", "counter", "Adquisiciones completadas", metricas.lecturas);
+  write_value(out, "nodo_publicados_total", "counter", "Mensajes entregados al broker", metricas.publicados);
+  write_value(out, "nodo_encolados_total", "counter", "Mensajes guardados en la cola persistente", metricas.encolados);
+  write_value(out, "nodo_lecturas_descartadas_total", "counter", "Lecturas descartadas por la cola entre nucleos llena",
+              metricas.descartadas);
+  write_value(out, "nodo_conexiones_mqtt_total", "counter", "Sesiones MQTT establecidas", conexion.stats.mqttConnects);
+  write_value(out, "nodo_fallos_mqtt_total", "counter", "Intentos de conexion MQTT fallidos", conexion.stats.mqttFailures);
+  const MqttClient& mqtt = mqtt_client();
+  write_value(out, "nodo_mqtt_cola_mensajes", "gauge", "Mensajes en el anillo de salida sin enviar o sin confirmar",
+              mqtt.pending());
+  write_value(out, "nodo_mqtt_cola_bytes", "gauge", "Bytes ocupados del anillo de salida", mqtt.pendingBytes());
+  write_value(out, "nodo_mqtt_en_vuelo", "gauge", "Mensajes QoS 1 a la espera del PUBACK", mqtt.inFlight());
+  write_value(out, "nodo_mqtt_descartados_total", "counter", "Mensajes que no caben en el anillo (van a flash)",
+              mqtt.stats().dropped);
+  write_value(out, "nodo_mqtt_reenvios_total", "counter", "Mensajes QoS 1 reenviados tras perder la sesion",
+              mqtt.stats().retransmitted);
+  write_value(out, "nodo_mqtt_bloqueos_total", "counter", "Escrituras en las que el socket no acepta todo lo pendiente",
+              mqtt.stats().stalls);
+  write_value(out, "nodo_perdidas_wifi_total", "counter", "Perdidas de la conexion WiFi", conexion.stats.wifiLosses);
+  write_value(out, "nodo_sincronizaciones_sntp_total", "counter", "Sincronizaciones SNTP del reloj",
+              time_clock().syncs);
+
+  write_header(out, "nodo_tarea_excesos_total", "counter", "Activaciones que superan el presupuesto de la tarea");
+  for (uint8_t i = 0; i < scheduler_task_count(); i++) {
+    const Task* tarea = scheduler_task(i);
+    write_line(out, "nodo_tarea_excesos_total{tarea=\"%s\"} %lu\n", tarea->name, tarea->overruns);
+  }
+
+#ifdef ESPNOW_GATEWAY
+  // Pasarela: tramas de los nodos hoja segun su destino y estado de cada nodo
+  const Gateway& pasarela = espnow_gateway();
+  write_header(out, "nodo_pasarela_tramas_total", "counter", "Tramas recibidas de los nodos hoja por resultado");
+  write_line(out, "nodo_pasarela_tramas_total{resultado=\"nueva\"} %lu\n", (unsigned long)pasarela.stats.accepted);
+  write_line(out, "nodo_pasarela_tramas_total{resultado=\"repetida\"} %lu\n", (unsigned long)pasarela.stats.duplicates);
+  write_line(out, "nodo_pasarela_tramas_total{resultado=\"antigua\"} %lu\n", (unsigned long)pasarela.stats.stale);
+  write_line(out, "nodo_pasarela_tramas_total{resultado=\"invalida\"} %lu\n", (unsigned long)pasarela.stats.invalid);
+  write_line(out, "nodo_pasarela_tramas_total{resultado=\"rechazada\"} %lu\n", (unsigned long)pasarela.stats.rejected);
+  write_value(out, "nodo_pasarela_cola_descartadas_total", "counter", "Tramas perdidas por la cola de recepcion llena",
+              espnow_rx_overflows());
+  write_value(out, "nodo_pasarela_lotes_total", "counter", "Lotes de lecturas de los nodos hoja publicados",
+              pasarela.stats.batches);
+  write_value(out, "nodo_pasarela_lotes_fallidos_total", "counter", "Lotes que no se han podido codificar",
+              pasarela.stats.encodeFailures);
+  write_value(out, "nodo_pasarela_nodos", "gauge", "Nodos hoja atendidos", pasarela.count);
+  write_header(out, "nodo_pasarela_lecturas_descartadas_total", "counter",
+               "Lecturas mas antiguas descartadas con el lote del nodo hoja lleno");
+  for (uint8_t i = 0; i < pasarela.count; i++) {
+    write_line(out, "nodo_pasarela_lecturas_descartadas_total{nodo=\"%s\"} %lu\n", pasarela.leaves[i].node,
+               (unsigned long)pasarela.leaves[i].evicted);
+  }
+  write_header(out, "nodo_pasarela_rssi_dbm", "gauge", "Intensidad de la ultima trama de cada nodo hoja");
+  for (uint8_t i = 0; i < pasarela.count; i++) {
+    write_line(out, "nodo_pasarela_rssi_dbm{nodo=\"%s\"} %d\n", pasarela.leaves[i].node, pasarela.leaves[i].rssi);
+  }
+#endif
+  write_value(out, "nodo_periodo_muestreo_ms", "gauge", "Periodo de muestreo actual", metricas.periodoMuestreo);
+  write_signed(out, "nodo_reloj_deriva_ppb", "Deriva estimada del reloj local", time_clock().driftPpb);
+  write_signed(out, "nodo_reloj_error_ms", "Error del reloj medido en la ultima sincronizacion", time_clock().lastOffset);
+  write_value(out, "nodo_heap_libre_bytes", "gauge", "Memoria dinamica libre", Board::heapLibre());
+  write_value(out, "nodo_heap_bloque_maximo_bytes", "gauge", "Mayor bloque de memoria dinamica reservable",
+              Board::bloqueLibreMaximo());
+  write_value(out, "nodo_retraso_tarea_maximo_ms", "gauge", "Retraso maximo de una tarea respecto a su deadline",
+              scheduler_max_latency());
+  write_value(out, "nodo_pasada_maxima_ms", "gauge", "Duracion maxima de una pasada del planificador",
+              scheduler_max_pass());
+}
+
+#if NODE_METRICS
+/*
+///////////////// SERVIDOR HTTP \\\\\\\\\\\\\\\\\
+*/
+// Se atiende un cliente cada vez sin bloquear la tarea. La linea de peticion se lee con lo que
+// haya llegado y se sigue en la pasada siguiente si esta incompleta. La respuesta se entrega
+// por tramos (cada llamada a write(), una linea completa): en cada pasada se vuelven a generar
+// las metricas, se saltan los tramos ya enviados y se escribe solo lo que acepta el socket,
+// hasta METRICS_HTTP_CHUNK bytes. Una respuesta larga puede mezclar lineas de pasadas distintas
+static WiFiClient cliente;
+static bool atendiendo = false;
+static uint32_t inicioCliente = 0;
+// Linea de peticion recibida hasta ahora; solo interesa su principio
+static char peticion[32];
+static uint8_t recibidos = 0;
+static bool peticionCompleta = false;
+static bool pideMetricas = false;
+// Tramos ya entregados al socket y final pendiente del ultimo, si el socket solo acepto parte
+static uint16_t tramosEnviados = 0;
+static uint8_t resto[128];
+static uint8_t restoLen = 0;
+static uint8_t restoPos = 0;
+
+// Escribe sin esperar lo que acepta el socket, como el transporte MQTT
+static size_t socket_write(const uint8_t* data, size_t len) {
+#if defined(ESP32)
+  ssize_t n = lwip_send(cliente.fd(), data, len, MSG_DONTWAIT);
+  return n > 0 ? (size_t)n : 0;
+#else
+  size_t libre = cliente.availableForWrite();
+  return libre > 0 ? cliente.write(data, len < libre ? len : libre) : 0;
+#endif
+}
+
+/**
+ * @brief Destino de una pasada de la respuesta: descarta los tramos ya enviados y deja de
+ * escribir al llenarse el socket o agotarse el presupuesto de bytes.
+ */
+class ResponseChunk : public Print {
+public:
+  explicit ResponseChunk(size_t presupuesto) : presupuesto(presupuesto), tramo(0), lleno(false) {}
+
+  using Print::write;
+  size_t write(uint8_t c) { return write(&c, 1); }
+
+  size_t write(const uint8_t* data, size_t len) override {
+    if (tramo++ < tramosEnviados || lleno) {
+      return len;
+    }
+    size_t n = len <= presupuesto ? socket_write(data, len) : 0;
+    if (n < len) {
+      lleno = true;
+      if (n == 0) {
+        return len;
+      }
+      // Un tramo es una linea de write_line(): el final cabe en resto
+      restoLen = (uint8_t)(len - n < sizeof(resto) ? len - n : sizeof(resto));
+      restoPos = 0;
+      memcpy(resto, data + n, restoLen);
+    }
+    tramosEnviados++;
+    presupuesto -= n;
+    return len;
+  }
+
+  bool complete() const { return !lleno; }
+
+private:
+  size_t presupuesto;
+  uint16_t tramo;
+  bool lleno;
+};
+
+static void close_client() {
+#if defined(ESP32)
+  cliente.stop();
+#else
+  // Sin esperar al ACK de lo escrito: lwIP lo sigue enviando despues de cerrar
+  cliente.stop(1);
+#endif
+  atendiendo = false;
+}
+
+// Lee lo que haya llegado de la linea de peticion. Devuelve true al completarla
+static bool read_request() {
+  int disponible = cliente.available();
+  uint8_t c;
+  while (disponible-- > 0 && cliente.read(&c, 1) == 1) {
+    if (c == '\n' || recibidos == sizeof(peticion) - 1) {
+      peticion[recibidos] = '\0';
+      return true;
+    }
+    peticion[recibidos++] = (char)c;
+  }
+  return false;
+}
+
+// Entrega el siguiente tramo de la respuesta. Devuelve true al terminarla
+static bool send_response() {
+  if (restoPos < restoLen) {
+    restoPos += socket_write(resto + restoPos, restoLen - restoPos);
+    if (restoPos < restoLen) {
+      return false;
+    }
+  }
+  ResponseChunk respuesta(METRICS_HTTP_CHUNK);
+  if (pideMetricas) {
+    respuesta.print("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+    metrics_write(respuesta);
+  } else {
+    respuesta.print("HTTP/1.0 404 Not Found\r\nConnection: close\r\n\r\n");
+  }
+  return respuesta.complete();
+}
+#endif
+
+void metrics_server_begin() {
+#if NODE_METRICS
+  servidor.begin();
+#endif
+}
+
+void metrics_server_poll() {
+#if NODE_METRICS
+  if (!atendiendo) {
+    cliente = servidor.available();
+    if (!cliente) {
+      return;
+    }
+#if !defined(ESP32)
+    // write() no espera al ACK de cada segmento
+    cliente.setSync(false);
+#endif
+    atendiendo = true;
+    inicioCliente = millis();
+    recibidos = 0;
+    peticionCompleta = false;
+    tramosEnviados = 0;
+    restoLen = 0;
+    restoPos = 0;
+  }
+
+  if (!cliente.connected() || millis() - inicioCliente > METRICS_HTTP_TIMEOUT) {
+    close_client();
+    return;
+  }
+  if (!peticionCompleta) {
+    if (!read_request()) {
+      return;
+    }
+    peticionCompleta = true;
+    pideMetricas = strncmp(peticion, "GET /metrics", 12) == 0;
+  }
+  // El resto de cabeceras se descarta al cerrar
+  if (send_response()) {
+    close_client();
+  }
+#endif
+}
@@ -0,0 +1,76 @@
+#ifndef NODE_METRICS_H
+#define NODE_METRICS_H
+
+#include <Arduino.h>
+#include <metrics.h>
+
+/*
+///////////////// METRICAS DEL NODO \\\\\\\\\\\\\\\\\
+*/
+// Puerto del servidor HTTP que expone /metrics en formato de texto de Prometheus
+#ifndef METRICS_PORT
+#define METRICS_PORT 80
+#endif
+
+// Tiempo maximo (ms) para atender a un cliente: recibir la peticion y entregar la respuesta
+#ifndef METRICS_HTTP_TIMEOUT
+#define METRICS_HTTP_TIMEOUT 5000
+#endif
+
+// Bytes de la respuesta que se escriben como mucho en cada pasada del servidor
+#ifndef METRICS_HTTP_CHUNK
+#define METRICS_HTTP_CHUNK 1460
+#endif
+
+/**
+ * @brief Metricas del camino critico del nodo. Los tiempos se registran en microsegundos.
+ */
+struct NodeMetrics {
+  // adquisicion completa de los sensores
+  Histogram lectura;
+  // codificacion de los mensajes de lecturas
+  Histogram serializacion;
+  // entrega de un mensaje al cliente MQTT (copia en su anillo de salida)
+  Histogram publicacion;
+  // intento de conexion con el broker, hasta el CONNACK
+  Histogram reconexion;
+  // retraso de cada tarea respecto a su deadline
+  Histogram retraso;
+
+  uint32_t lecturas;
+  uint32_t publicados;
+  uint32_t encolados;
+  // lecturas perdidas por encontrar llena la cola entre nucleos (modo de doble nucleo)
+  uint32_t descartadas;
+  // periodo de muestreo actual en ms (muestreo adaptativo)
+  uint32_t periodoMuestreo;
+};
+
+extern NodeMetrics metricas;
+
+/**
+ * @brief Registra el retraso de la tarea ejecutada en la ultima pasada del planificador.
+ * Se llama en loop() justo despues de scheduler_run().
+ */
+void metrics_observe_loop();
+
+/**
+ * @brief Arranca el servidor HTTP de las metricas. Requiere la WiFi iniciada.
+ */
+void metrics_server_begin();
+
+/**
+ * @brief Avanza la peticion en curso sin bloquear: lee lo que haya llegado de la peticion y
+ * escribe hasta METRICS_HTTP_CHUNK bytes de la respuesta. Un cliente que no termina en
+ * METRICS_HTTP_TIMEOUT se cierra. Se registra como tarea periodica del planificador.
+ */
+void metrics_server_poll();
+
+/**
+ * @brief Escribe todas las metricas en formato de texto de Prometheus.
+ *
+ * @param out Destino (cliente HTTP, puerto serie...).
+ */
+void metrics_write(Print& out);
+
+#endif // NODE_METRICS_H
@@ -0,0 +1,330 @@
+#include <mqtt.h>
+#include <LittleFS.h>
+#include <flash_queue.h>
+#include <littlefs_storage.h>
+#include <payload.h>
+#include <boot_timeline.h>
+#include <stdio.h>
+#include <string.h>
+#include "board.h"
+#include "rgb.h"
+#include "node_wifi.h"
+#include "node_mqtt.h"
+#include "node_metrics.h"
+#include "node_time.h"
+#if defined(ESP32)
+#include <lwip/sockets.h>
+#endif
+
+/**
+ * @brief Socket TCP del cliente MQTT sobre WiFiClient, sin esperas al escribir ni al leer.
+ */
+class WiFiTransport : public MqttTransport {
+public:
+    bool connect(const char* host, uint16_t port) override {
+#if defined(ESP32)
+        if (!socket.connect(host, port, MQTT_CONNECT_TIMEOUT)) {
+            return false;
+        }
+#else
+        socket.setTimeout(MQTT_CONNECT_TIMEOUT);
+        if (!socket.connect(host, port)) {
+            return false;
+        }
+        // write() no espera al ACK de cada segmento
+        socket.setSync(false);
+#endif
+        socket.setNoDelay(true);
+        return true;
+    }
+
+    bool connected() override {
+        return socket.connected();
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+#if defined(ESP32)
+        // WiFiClient::write() reintenta hasta que cabe todo: se escribe en el socket de lwIP
+        ssize_t n = lwip_send(socket.fd(), data, len, MSG_DONTWAIT);
+        return n > 0 ? (size_t)n : 0;
+#else
+        // Solo lo que cabe en la ventana de envio, para que write() no espere
+        size_t libre = socket.availableForWrite();
+        return libre > 0 ? socket.write(data, len < libre ? len : libre) : 0;
+#endif
+    }
+
+    size_t read(uint8_t* buffer, size_t len) override {
+        int disponible = socket.available();
+        if (disponible <= 0) {
+            return 0;
+        }
+        int n = socket.read(buffer, len < (size_t)disponible ? len : (size_t)disponible);
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    void stop() override {
+        socket.stop();
+    }
+
+private:
+    WiFiClient socket;
+};
+
+static WiFiTransport transporte;
+static MqttClient client(transporte, micros);
+
+// Intento de conexion en curso (socket abierto, a la espera del CONNACK) y su inicio (us)
+static bool intentando = false;
+static uint32_t inicioIntento = 0;
+
+// Identificador del cliente, unico por nodo: prefijo de la placa y chip ID.
+// Dos nodos con el mismo identificador se expulsan mutuamente del broker
+static char clientId[24];
+
+// Cola persistente con las lecturas tomadas sin conexion con el broker
+static LittleFsStorage almacenamiento(LittleFS);
+static FlashQueue cola(almacenamiento);
+static bool colaDisponible = false;
+static QueueEntry pendiente;
+
+// Mensajes de la cola copiados en el anillo y aun sin confirmar, en orden: numero de cada uno
+// entre los aceptados por el anillo (MqttStats::queued). El anillo los libera en orden tras su
+// PUBACK y solo entonces salen de la flash. Como el reenvio no deja mas de MQTT_MAX_INFLIGHT
+// mensajes en el anillo, no puede haber mas en vuelo
+static uint32_t enVuelo[MQTT_MAX_INFLIGHT];
+static uint8_t enVueloCount = 0;
+
+// Unico topic suscrito (la configuracion del nodo) y funcion que recibe sus mensajes
+static const char* suscripcion = nullptr;
+static MqttMessageCallback alRecibir = nullptr;
+
+// Reenvio de la cola: mensajes por llamada y periodo de reposicion de cada mensaje (ms)
+static const uint8_t MQTT_DRAIN_BATCH = 5;
+static const unsigned long MQTT_DRAIN_RATE = 200;
+static uint8_t drainTokens = MQTT_DRAIN_BATCH;
+static unsigned long drainRefill = 0;
+
+static void on_message(const char* topic, uint8_t* payload, unsigned int len) {
+    if (alRecibir != nullptr && suscripcion != nullptr && strcmp(topic, suscripcion) == 0) {
+        alRecibir(topic, payload, len);
+    }
+}
+
+void mqtt_init(const char* mqtt_server, const int mqtt_port) {
+    snprintf(clientId, sizeof(clientId), "%s-%06lx", Board::prefijo(), (unsigned long)Board::chipId());
+
+    // Inicia servidor MQTT
+    client.setServer(mqtt_server, mqtt_port);
+    client.setCallback(on_message);
+
+    // Monta el sistema de ficheros y recupera la cola de un arranque anterior
+#ifdef ESP32
+    colaDisponible = LittleFS.begin(true);
+#else
+    colaDisponible = LittleFS.begin();
+#endif
+    if (colaDisponible) {
+        LittleFS.mkdir("/sf");
+        cola.begin();
+    } else {
+        Serial.println("LittleFS not available, offline samples will be lost");
+    }
+}
+
+static void report_failure() {
+    Serial.print("Failed to connect to MQTT broker as ");
+    Serial.print(clientId);
+    Serial.print(", retry in ");
+    Serial.print(conexion.mqtt.next - millis());
+    Serial.println(" ms");
+}
+
+// Resuelve el intento de conexion en curso: CONNACK recibido, o socket cerrado (rechazo del
+// broker, tiempo agotado o perdida de la red)
+static void attempt_update() {
+    if (!intentando) {
+        return;
+    }
+    if (client.connected()) {
+        intentando = false;
+        metrics_observe(&metricas.reconexion, micros() - inicioIntento);
+        conn_mqtt_result(&conexion, millis(), true);
+        boot_mark(ARRANQUE_MQTT, millis());
+        // Sesion limpia: el broker no recuerda la suscripcion anterior
+        if (suscripcion != nullptr) {
+            client.subscribe(suscripcion, 1);
+        }
+        turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+        commandLED(0, 20, 0, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+    } else if (!client.connecting()) {
+        intentando = false;
+        metrics_observe(&metricas.reconexion, micros() - inicioIntento);
+        conn_mqtt_result(&conexion, millis(), false);
+        report_failure();
+    }
+}
+
+bool mqtt_reconnect() {
+    // Realiza un unico intento; el supervisor decide cuando toca el siguiente
+    inicioIntento = micros();
+    if (client.connect(clientId)) {
+        intentando = true;
+        return true;
+    }
+    metrics_observe(&metricas.reconexion, micros() - inicioIntento);
+    conn_mqtt_result(&conexion, millis(), false);
+    report_failure();
+    return false;
+}
+
+void mqtt_poll() {
+    client.pump();
+    attempt_update();
+}
+
+bool mqtt_connected() {
+    return client.connected();
+}
+
+bool mqtt_is_connected() {
+    mqtt_poll();
+    if (intentando) {
+        return false;
+    }
+    if (!client.connected()) {
+        turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+        commandLED(1023, 0, 0, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+
+        // Sin red WiFi o antes de que venza la espera no se intenta conectar con el broker
+        if (conn_mqtt_update(&conexion, millis(), false)) {
+            mqtt_reconnect();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool mqtt_publish(const char* topic, const uint8_t* payload, size_t len) {
+    if (client.connected()) {
+        // Solo copia el mensaje en el anillo; lo envia mqtt_poll()
+        uint32_t inicio = micros();
+        bool ok = client.publish(topic, payload, len);
+        metrics_observe(&metricas.publicacion, micros() - inicio);
+        if (ok) {
+            metrics_count(&metricas.publicados);
+            boot_mark(ARRANQUE_PUBLICACION, millis());
+            return true;
+        }
+    }
+
+    // Sin conexion o con el anillo lleno: se guarda en flash para reenviarlo mas tarde
+    if (!colaDisponible) {
+        return false;
+    }
+    metrics_count(&metricas.encolados);
+    return cola.push(topic, payload, len, millis(), (uint32_t)(time_now() / 1000));
+}
+
+// Extrae de la flash los mensajes reenviados que el broker ya ha confirmado
+static void drain_release() {
+    uint32_t liberados = client.stats().queued - client.pending();
+    uint8_t confirmados = 0;
+    while (confirmados < enVueloCount && (int32_t)(liberados - enVuelo[confirmados]) >= 0) {
+        cola.pop();
+        confirmados++;
+    }
+    if (confirmados > 0) {
+        enVueloCount -= confirmados;
+        memmove(enVuelo, enVuelo + confirmados, enVueloCount * sizeof(enVuelo[0]));
+    }
+}
+
+// Edad (s) con la que se reenvia un mensaje de la cola, o PAYLOAD_AGE_UNKNOWN si no se conoce
+static uint32_t entry_age(const QueueEntry& entrada) {
+    if (entrada.epoch > 0) {
+        uint64_t ahora = time_now() / 1000;
+        if (ahora > 0) {
+            return ahora > entrada.epoch ? (uint32_t)(ahora - entrada.epoch) : 0;
+        }
+    } else if (entrada.sameBoot) {
+        return (millis() - entrada.timestamp) / 1000;
+    }
+    // Guardado en otro arranque y sin hora UTC con la que compararlo: el suscriptor lo marca
+    // como sin fecha en lugar de fecharlo al recibirlo
+    return PAYLOAD_AGE_UNKNOWN;
+}
+
+void mqtt_drain() {
+    // Repone el cupo de mensajes segun el tiempo transcurrido
+    unsigned long now = millis();
+    while (now - drainRefill >= MQTT_DRAIN_RATE && drainTokens < MQTT_DRAIN_BATCH) {
+        drainTokens++;
+        drainRefill += MQTT_DRAIN_RATE;
+    }
+    if (drainTokens == MQTT_DRAIN_BATCH) {
+        drainRefill = now;
+    }
+
+    if (!colaDisponible) {
+        return;
+    }
+    drain_release();
+    if (!client.connected()) {
+        return;
+    }
+
+    // Sin adelantarse al enlace: la cola avanza mientras el anillo tiene poco pendiente. Los
+    // mensajes siguen en la flash hasta su PUBACK: si el nodo se reinicia antes, se reenvian
+    uint8_t buffer[FLASH_QUEUE_MAX_PAYLOAD + 24];
+    while (drainTokens > 0 && client.pending() < MQTT_MAX_INFLIGHT && enVueloCount < MQTT_MAX_INFLIGHT &&
+           cola.peek(pendiente)) {
+        // Añade la edad del mensaje para que el suscriptor lo feche correctamente
+        memcpy(buffer, pendiente.payload, pendiente.payloadLen);
+        size_t len = payload_add_age(buffer, pendiente.payloadLen, sizeof(buffer), entry_age(pendiente));
+        if (!client.publish(pendiente.topic, buffer, len)) {
+            break;
+        }
+        cola.next();
+        enVuelo[enVueloCount++] = client.stats().queued;
+        metrics_count(&metricas.publicados);
+        drainTokens--;
+    }
+}
+
+bool mqtt_flush(unsigned long timeout) {
+    unsigned long inicio = millis();
+    while (client.pending() > 0 && client.connecting()) {
+        if (millis() - inicio >= timeout) {
+            return false;
+        }
+        delay(10);
+        mqtt_poll();
+    }
+    return client.pending() == 0;
+}
+
+void mqtt_disconnect() {
+    intentando = false;
+    client.disconnect();
+}
+
+void mqtt_subscribe(const char* topic, MqttMessageCallback callback) {
+    suscripcion = topic;
+    alRecibir = callback;
+    if (client.connected()) {
+        client.subscribe(suscripcion, 1);
+    }
+}
+
+const char* mqtt_client_id() {
+    return clientId;
+}
+
+uint32_t mqtt_queue_size() {
+    return colaDisponible ? cola.size() : 0;
+}
+
+const MqttClient& mqtt_client() {
+    return client;
+}
@@ -0,0 +1,122 @@
+#ifndef NODE_MQTT_H
+#define NODE_MQTT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mqtt.h>
+
+// Tiempo maximo (ms) que puede bloquear la apertura del socket con el broker; el resto de la
+// sesion (CONNECT, publicaciones, keepalive) no bloquea
+#ifndef MQTT_CONNECT_TIMEOUT
+#define MQTT_CONNECT_TIMEOUT 2000
+#endif
+
+/**
+ * @brief Inicializa la conexión MQTT con el servidor especificado.
+ *
+ * @param mqtt_server Dirección IP del servidor MQTT.
+ * @param mqtt_port Puerto utilizado por el servidor MQTT.
+ */
+void mqtt_init(const char* mqtt_server, const int mqtt_port);
+
+/**
+ * @brief Verifica si el cliente MQTT está conectado. Si no está conectado, se intenta reconectar.
+ *
+ * Esta función no bloquea más allá de la apertura del socket: si el cliente no está conectado
+ * inicia, como mucho, un intento de conexión mediante mqtt_reconnect(), que se completa al
+ * recibir el CONNACK en una llamada posterior. Si está conectado atiende el socket con
+ * mqtt_poll(). Se debe llamar periódicamente desde la tarea de supervisión de red.
+ *
+ * @return true si la sesión con el broker está establecida.
+ * @see mqtt_reconnect()
+ */
+bool mqtt_is_connected();
+
+/**
+ * @brief Función que se encarga de reconectar al servidor MQTT si no se encuentra conectado.
+ *
+ * Abre el socket con el identificador del nodo y deja el CONNECT pendiente de envío. El
+ * resultado (CONNACK, rechazo o tiempo agotado) se notifica al supervisor, que fija la espera
+ * (exponencial con jitter) hasta el siguiente intento.
+ *
+ * @return true si se ha abierto el socket y el intento sigue en curso.
+ */
+bool mqtt_reconnect();
+
+/**
+ * @brief Escribe en el socket lo que acepte sin esperar, procesa lo recibido y atiende el
+ * keepalive. Se registra como tarea periódica del planificador.
+ */
+void mqtt_poll();
+
+/**
+ * @brief true si la sesión con el broker está establecida, sin intentar reconectar.
+ */
+bool mqtt_connected();
+
+/**
+ * @brief Publica un mensaje en el broker (QoS 1). Con la sesión establecida el mensaje se
+ * copia en el anillo de salida del cliente y el socket lo envía en segundo plano; sin
+ * conexión, o con el anillo lleno, se guarda en una cola persistente en flash (LittleFS) y se
+ * reenvía más tarde mediante mqtt_drain(). Nunca espera al socket.
+ *
+ * @param topic Topic en el que se publica.
+ * @param payload Contenido del mensaje (JSON o binario).
+ * @param len Longitud del mensaje en bytes.
+ * @return true si el mensaje se ha publicado o se ha guardado en la cola.
+ */
+bool mqtt_publish(const char* topic, const uint8_t* payload, size_t len);
+
+/**
+ * @brief Reenvía por lotes los mensajes guardados en la cola persistente.
+ *
+ * El reenvío está limitado en ritmo para no saturar el enlace ni retrasar las lecturas
+ * nuevas, que se publican directamente. Se debe llamar periódicamente.
+ */
+void mqtt_drain();
+
+/**
+ * @brief Espera, atendiendo el socket, a que el broker confirme todo lo publicado. Para
+ * cerrar la sesión sin perder mensajes antes de apagar la radio (modo bajo consumo).
+ *
+ * @param timeout Espera máxima en milisegundos.
+ * @return true si no queda ningún mensaje sin confirmar.
+ */
+bool mqtt_flush(unsigned long timeout);
+
+/**
+ * @brief Cierra la sesión con el broker.
+ */
+void mqtt_disconnect();
+
+/**
+ * @brief Funcion que recibe los mensajes de un topic suscrito. El payload pertenece al buffer
+ * del cliente y solo es valido durante la llamada (se puede modificar en el sitio).
+ */
+typedef void (*MqttMessageCallback)(const char* topic, uint8_t* payload, unsigned int len);
+
+/**
+ * @brief Suscribe el nodo a un topic (QoS 1). La suscripcion se repite tras cada reconexion,
+ * por lo que un mensaje retenido se recibe tambien al recuperar la sesion.
+ *
+ * @param topic Topic (debe seguir existiendo mientras dure la suscripcion).
+ * @param callback Funcion que recibe los mensajes.
+ */
+void mqtt_subscribe(const char* topic, MqttMessageCallback callback);
+
+/**
+ * @brief Identificador del cliente MQTT del nodo ("<placa>-<chip ID>").
+ */
+const char* mqtt_client_id();
+
+/**
+ * @brief Número de mensajes pendientes de reenvío en la cola persistente.
+ */
+uint32_t mqtt_queue_size();
+
+/**
+ * @brief Cliente MQTT del nodo, para consultar su cola de salida y sus estadísticas.
+ */
+const MqttClient& mqtt_client();
+
+#endif // NODE_MQTT_H
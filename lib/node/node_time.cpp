@@ -0,0 +1,139 @@
+#include "node_time.h"
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <string.h>
+#include "node_wifi.h"
+
+// Paquete SNTP (RFC 4330): cabecera de 48 bytes con las marcas de tiempo en formato NTP
+// (segundos desde 1900 y fraccion de segundo en 32 bits, big-endian)
+static const size_t NTP_PACKET_SIZE = 48;
+static const uint8_t NTP_ORIGINATE = 24;
+static const uint8_t NTP_RECEIVE = 32;
+static const uint8_t NTP_TRANSMIT = 40;
+// Segundos entre 1900 (epoca NTP) y 1970 (epoca Unix)
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+// Puerto UDP local desde el que se consulta
+static const uint16_t NTP_LOCAL_PORT = 2390;
+
+static WiFiUDP udp;
+static bool udpAbierto = false;
+static const char* servidor = nullptr;
+static ClockSource relojLocal = nullptr;
+static SyncClock* reloj = nullptr;
+// Reloj vacio para time_clock() antes de time_sync_begin()
+static SyncClock sinSincronizar;
+
+// Instante de la proxima consulta en la base de tiempo local
+static uint32_t siguienteConsulta = 0;
+
+static uint64_t read_ntp_ms(const uint8_t* in) {
+  uint32_t segundos = (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+  uint32_t fraccion = (uint32_t)in[4] << 24 | (uint32_t)in[5] << 16 | (uint32_t)in[6] << 8 | in[7];
+  // Los segundos NTP dan la vuelta en 2036: por debajo de 1970 corresponden a la era siguiente
+  uint64_t desdeUnix = segundos < NTP_UNIX_OFFSET ? segundos + (1ULL << 32) - NTP_UNIX_OFFSET : segundos - NTP_UNIX_OFFSET;
+  return desdeUnix * 1000ULL + (((uint64_t)fraccion * 1000 + (1ULL << 31)) >> 32);
+}
+
+// Un intercambio completo: devuelve false si no hay respuesta valida a tiempo
+static bool query() {
+  if (!udpAbierto) {
+    udpAbierto = udp.begin(NTP_LOCAL_PORT);
+    if (!udpAbierto) {
+      return false;
+    }
+  }
+  // Descarta respuestas atrasadas de consultas anteriores
+  while (udp.parsePacket() > 0) {
+  }
+
+  // Cliente, version 4. El instante local de envio viaja como marca de transmision y el
+  // servidor lo devuelve como marca de origen: identifica la respuesta a esta consulta
+  uint8_t paquete[NTP_PACKET_SIZE];
+  memset(paquete, 0, sizeof(paquete));
+  paquete[0] = 0x23;
+  uint32_t envio = relojLocal();
+  memcpy(paquete + NTP_TRANSMIT, &envio, sizeof(envio));
+  if (!udp.beginPacket(servidor, TIME_SYNC_PORT) || udp.write(paquete, sizeof(paquete)) != sizeof(paquete) ||
+      !udp.endPacket()) {
+    return false;
+  }
+
+  while (relojLocal() - envio < TIME_SYNC_TIMEOUT) {
+    if (udp.parsePacket() < (int)NTP_PACKET_SIZE) {
+      delay(1);
+      continue;
+    }
+    uint32_t llegada = relojLocal();
+    if (udp.read(paquete, sizeof(paquete)) != (int)NTP_PACKET_SIZE) {
+      continue;
+    }
+
+    // Respuesta de servidor (modo 4), sincronizado (aviso distinto de 3 y estrato 1-15)
+    // y a esta consulta
+    uint8_t modo = paquete[0] & 0x07;
+    uint8_t aviso = paquete[0] >> 6;
+    uint8_t estrato = paquete[1];
+    uint32_t origen;
+    memcpy(&origen, paquete + NTP_ORIGINATE, sizeof(origen));
+    if (modo != 4 || aviso == 3 || estrato == 0 || estrato > 15 || origen != envio) {
+      continue;
+    }
+
+    // Retardo de la red: ida y vuelta menos el tiempo que el servidor retuvo la consulta.
+    // Se supone simetrico, asi que la hora a la llegada es la de transmision mas la mitad
+    uint64_t recepcion = read_ntp_ms(paquete + NTP_RECEIVE);
+    uint64_t transmision = read_ntp_ms(paquete + NTP_TRANSMIT);
+    int64_t retardo = (int64_t)(llegada - envio) - (int64_t)(transmision - recepcion);
+    if (retardo < 0) {
+      retardo = 0;
+    }
+    sync_clock_update(reloj, llegada, transmision + retardo / 2);
+    return true;
+  }
+  return false;
+}
+
+void time_sync_begin(const char* server, SyncClock* clock, ClockSource local) {
+  servidor = server;
+  reloj = clock;
+  relojLocal = local;
+  siguienteConsulta = local();
+}
+
+bool time_sync_now() {
+  if (reloj == nullptr || WiFi.status() != WL_CONNECTED) {
+    return false;
+  }
+  bool ok = query();
+
+  // Hasta tener estimada la deriva se sincroniza con el intervalo minimo para medirla
+  uint32_t espera = !ok ? TIME_SYNC_RETRY : reloj->driftValid ? TIME_SYNC_PERIOD : SYNC_CLOCK_DRIFT_INTERVAL;
+  siguienteConsulta = relojLocal() + espera;
+  if (ok) {
+    Serial.print("SNTP: error ");
+    Serial.print(reloj->lastOffset);
+    Serial.print(" ms, deriva ");
+    Serial.print(reloj->driftPpb / 1000.0f, 2);
+    Serial.println(" ppm");
+  }
+  return ok;
+}
+
+bool time_sync_poll() {
+  if (reloj == nullptr || (int32_t)(relojLocal() - siguienteConsulta) < 0) {
+    return false;
+  }
+  return time_sync_now();
+}
+
+uint64_t time_epoch(uint32_t local) {
+  return reloj == nullptr ? 0 : sync_clock_epoch(reloj, local);
+}
+
+uint64_t time_now() {
+  return reloj == nullptr ? 0 : sync_clock_epoch(reloj, relojLocal());
+}
+
+const SyncClock& time_clock() {
+  return reloj == nullptr ? sinSincronizar : *reloj;
+}
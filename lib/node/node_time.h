@@ -0,0 +1,84 @@
+#ifndef NODE_TIME_H
+#define NODE_TIME_H
+
+#include <stdint.h>
+#include <scheduler.h>
+#include <sync_clock.h>
+
+/*
+///////////////// HORA DEL NODO POR SNTP \\\\\\\\\\\\\\\\\
+*/
+// Cliente SNTP minimo contra el servidor de la red local (la Raspberry). Cada consulta es un
+// intercambio UDP de 48 bytes; la respuesta se espera en un bucle corto para conocer con
+// precision el instante de llegada, y la medida se corrige con la mitad del retardo de ida y
+// vuelta. El reloj resultante (sync_clock) fecha las lecturas en el instante de adquisicion.
+
+// Puerto del servidor NTP
+#ifndef TIME_SYNC_PORT
+#define TIME_SYNC_PORT 123
+#endif
+
+// Periodo (ms) entre sincronizaciones una vez estimada la deriva; hasta entonces se
+// sincroniza cada SYNC_CLOCK_DRIFT_INTERVAL
+#ifndef TIME_SYNC_PERIOD
+#define TIME_SYNC_PERIOD 900000UL
+#endif
+
+// Espera (ms) antes de repetir una consulta sin respuesta o descartada
+#ifndef TIME_SYNC_RETRY
+#define TIME_SYNC_RETRY 15000UL
+#endif
+
+// Espera maxima (ms) de la respuesta. En la red local llega en pocos ms; si tarda mas, el
+// retardo haria la medida poco precisa y se descarta
+#ifndef TIME_SYNC_TIMEOUT
+#define TIME_SYNC_TIMEOUT 40
+#endif
+
+/**
+ * @brief Configura el cliente SNTP. La primera consulta se hace en cuanto haya WiFi.
+ *
+ * @param server Direccion IP del servidor NTP.
+ * @param clock Reloj que se actualiza con cada sincronizacion (lo conserva el llamante, p. ej.
+ * en memoria RTC para que sobreviva al deep sleep).
+ * @param local Base de tiempo local del nodo en ms (millis(), o una que siga contando durante
+ * el deep sleep).
+ */
+void time_sync_begin(const char* server, SyncClock* clock, ClockSource local);
+
+/**
+ * @brief Lanza una consulta si le toca y hay WiFi. Bloquea como mucho TIME_SYNC_TIMEOUT ms.
+ * Se llama periodicamente desde la tarea de supervision de red.
+ *
+ * @return true si se ha sincronizado el reloj en esta llamada.
+ */
+bool time_sync_poll();
+
+/**
+ * @brief Realiza una consulta inmediata, sin esperar a que le toque (modo deep sleep).
+ *
+ * @return true si se ha sincronizado el reloj.
+ */
+bool time_sync_now();
+
+/**
+ * @brief Hora UTC de un instante de la base de tiempo local.
+ *
+ * @param local Instante local en ms (por ejemplo, el de adquisicion de una lectura).
+ * @return ms desde la epoca Unix, o 0 si el reloj aun no se ha sincronizado.
+ */
+uint64_t time_epoch(uint32_t local);
+
+/**
+ * @brief Hora UTC actual.
+ *
+ * @return ms desde la epoca Unix, o 0 si el reloj aun no se ha sincronizado.
+ */
+uint64_t time_now();
+
+/**
+ * @brief Reloj del nodo, para informes.
+ */
+const SyncClock& time_clock();
+
+#endif // NODE_TIME_H
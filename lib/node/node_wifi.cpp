@@ -0,0 +1,191 @@
+#include "node_wifi.h"
+#include "board.h"
+#include <LittleFS.h>
+#include <boot_timeline.h>
+#include <stddef.h>
+#include <string.h>
+
+// Estado de la conexion WiFi y MQTT del nodo, compartido con node_mqtt
+ConnSupervisor conexion;
+
+static bool wifiWasConnected = false;
+
+// Ultimo punto de acceso y configuracion IP con los que se conecto el nodo
+struct WifiCache {
+  uint32_t magic;
+  uint32_t config;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t crc;
+};
+
+static const uint32_t WIFI_CACHE_MAGIC = 0x57464331;
+static const char* const WIFI_CACHE_PATH = "/wifi_cache.bin";
+
+// En el ESP32 la cache se conserva tambien en memoria RTC: tras un despertar del modo bajo
+// consumo no hace falta leer la flash. El ESP8266 solo la guarda en LittleFS
+#if defined(ESP32)
+RTC_DATA_ATTR static WifiCache rtcCache;
+#endif
+
+static WifiCache cache;
+static bool cacheValid = false;
+
+// Credenciales para repetir la asociacion con escaneo completo si falla la rapida
+static const char* wifiSsid = nullptr;
+static const char* wifiPassword = nullptr;
+static bool fastConnect = false;
+static unsigned long fastConnectStart = 0;
+
+// FNV-1a: identifica la configuracion (SSID y direcciones) y protege el contenido de la cache
+static uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len) {
+  while (len--) {
+    hash ^= *data++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t config_hash(const char* ssid, const char* ip_str, const char* gateway_str, const char* subnet_str) {
+  uint32_t hash = 2166136261u;
+  const char* campos[] = {ssid, ip_str, gateway_str, subnet_str};
+  for (const char* campo : campos) {
+    // Se incluye el terminador para separar los campos
+    hash = fnv1a(hash, (const uint8_t*)campo, strlen(campo) + 1);
+  }
+  return hash;
+}
+
+static uint32_t cache_crc(const WifiCache& entrada) {
+  return fnv1a(2166136261u, (const uint8_t*)&entrada, offsetof(WifiCache, crc));
+}
+
+static bool cache_valid(const WifiCache& entrada, uint32_t config) {
+  return entrada.magic == WIFI_CACHE_MAGIC && entrada.config == config && entrada.crc == cache_crc(entrada) &&
+         entrada.channel != 0;
+}
+
+static bool load_cache(uint32_t config) {
+#if defined(ESP32)
+  if (cache_valid(rtcCache, config)) {
+    cache = rtcCache;
+    return true;
+  }
+#endif
+  File fichero = LittleFS.open(WIFI_CACHE_PATH, "r");
+  if (!fichero) {
+    return false;
+  }
+  bool leido = fichero.read((uint8_t*)&cache, sizeof(cache)) == sizeof(cache);
+  fichero.close();
+  return leido && cache_valid(cache, config);
+}
+
+static void store_cache() {
+  cache.magic = WIFI_CACHE_MAGIC;
+  cache.reserved = 0;
+  cache.crc = cache_crc(cache);
+#if defined(ESP32)
+  rtcCache = cache;
+#endif
+  File fichero = LittleFS.open(WIFI_CACHE_PATH, "w");
+  if (fichero) {
+    fichero.write((const uint8_t*)&cache, sizeof(cache));
+    fichero.close();
+  }
+}
+
+// Guarda el punto de acceso actual; solo se escribe en flash si ha cambiado
+static void update_cache() {
+  const uint8_t* bssid = WiFi.BSSID();
+  uint8_t channel = WiFi.channel();
+  if (bssid == nullptr || channel == 0) {
+    return;
+  }
+  if (cacheValid && cache.channel == channel && memcmp(cache.bssid, bssid, sizeof(cache.bssid)) == 0) {
+    return;
+  }
+  memcpy(cache.bssid, bssid, sizeof(cache.bssid));
+  cache.channel = channel;
+  store_cache();
+  cacheValid = true;
+}
+
+void setup_wifi(const char* ssid, const char* password, const char* ip_str, const char* gateway_str,
+                const char* subnet_str) {
+  Serial.println("Connecting to WiFi network...");
+  wifiSsid = ssid;
+  wifiPassword = password;
+
+  // La cache solo vale si se creo con el mismo SSID y las mismas direcciones
+  uint32_t config = config_hash(ssid, ip_str, gateway_str, subnet_str);
+  cacheValid = load_cache(config);
+  if (!cacheValid) {
+    // Convirte de str a tuple(int) los parametros WiFi del NodeMCU
+    IPAddress ip;
+    ip.fromString(ip_str);
+
+    IPAddress gateway;
+    gateway.fromString(gateway_str);
+
+    IPAddress subnet;
+    subnet.fromString(subnet_str);
+
+    memset(&cache, 0, sizeof(cache));
+    cache.config = config;
+    cache.ip = (uint32_t)ip;
+    cache.gateway = (uint32_t)gateway;
+    cache.subnet = (uint32_t)subnet;
+  }
+
+  // Inicia la configuracion WiFi
+  WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet));
+
+  // Conecta con la red WiFi sin esperar: wifi_supervise() comprueba el estado.
+  // Con la cache se asocia directamente al ultimo punto de acceso, sin escanear los canales
+  if (cacheValid) {
+    WiFi.begin(ssid, password, cache.channel, cache.bssid);
+    fastConnect = true;
+    fastConnectStart = millis();
+    boot_wifi_mode(WIFI_RAPIDA);
+  } else {
+    WiFi.begin(ssid, password);
+    boot_wifi_mode(WIFI_ESCANEO);
+  }
+  conn_init(&conexion, millis(), Board::aleatorio);
+}
+
+bool wifi_supervise() {
+  bool connected = WiFi.status() == WL_CONNECTED;
+
+  // Si el punto de acceso ha cambiado de canal o ya no existe, la asociacion rapida no
+  // termina: se repite con escaneo completo
+  if (fastConnect && !connected && millis() - fastConnectStart >= WIFI_FAST_CONNECT_TIMEOUT) {
+    Serial.println("WiFi fast connect failed, scanning...");
+    fastConnect = false;
+    cacheValid = false;
+    boot_wifi_mode(WIFI_RAPIDA_FALLIDA);
+    WiFi.disconnect();
+    WiFi.begin(wifiSsid, wifiPassword);
+  }
+
+  if (connected && !wifiWasConnected) {
+    Serial.print("Connected to WiFi network with IP address: ");
+    Serial.println(WiFi.localIP());
+    fastConnect = false;
+    boot_mark(ARRANQUE_WIFI, millis());
+    update_cache();
+  }
+
+  // Reintenta la asociacion cuando vence la espera, sin bloquear el resto de tareas
+  if (conn_wifi_update(&conexion, millis(), connected)) {
+    Serial.println("WiFi not connected, retrying...");
+    WiFi.reconnect();
+  }
+  wifiWasConnected = connected;
+  return connected;
+}
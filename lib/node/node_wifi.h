@@ -0,0 +1,48 @@
+#ifndef NODE_WIFI_H
+#define NODE_WIFI_H
+
+#if defined(ESP32)
+#include <WiFi.h>
+#else
+#include <ESP8266WiFi.h>
+#endif
+#include <conn_supervisor.h>
+
+// Tiempo maximo de la asociacion rapida con el punto de acceso guardado antes de repetirla
+// con escaneo completo de canales
+#ifndef WIFI_FAST_CONNECT_TIMEOUT
+#define WIFI_FAST_CONNECT_TIMEOUT 3000UL
+#endif
+
+/**
+ * Configura la conexión WiFi del NodeMCU con la dirección IP, gateway y máscara de subred especificadas.
+ * Inicia la conexión del NodeMCU a la red WiFi con el SSID y contraseña proporcionados,
+ * sin esperar a que se complete. El estado se comprueba con wifi_supervise().
+ *
+ * Si hay una cache valida del ultimo arranque (BSSID, canal y direcciones ya convertidas,
+ * en memoria RTC o en LittleFS) se asocia directamente a ese punto de acceso sin escanear.
+ * Si no se conecta en WIFI_FAST_CONNECT_TIMEOUT ms se repite con escaneo completo.
+ * Requiere LittleFS montado.
+ *
+ * @param ssid El SSID de la red WiFi a la que se desea conectar.
+ * @param password La contraseña de la red WiFi a la que se desea conectar.
+ * @param ip_str La dirección IP deseada para el NodeMCU en formato de cadena de caracteres.
+ * @param gateway_str La dirección IP del router en formato de cadena de caracteres.
+ * @param subnet_str La máscara de subred en formato de cadena de caracteres.
+ */
+void setup_wifi(const char* ssid, const char* password, const char* ip_str, const char* gateway_str, const char* subnet_str);
+
+/**
+ * Comprueba el estado de la conexión WiFi sin bloquear. Si la conexión está caída, lanza
+ * un nuevo intento de asociación cuando vence la espera exponencial del supervisor.
+ *
+ * @return true si el nodo está conectado a la red WiFi.
+ */
+bool wifi_supervise();
+
+/**
+ * @brief Supervisor de la conexión WiFi y MQTT del nodo: estado, esperas y contadores.
+ */
+extern ConnSupervisor conexion;
+
+#endif // NODE_WIFI_H
@@ -1,4 +1,3 @@
-#include "main.h"
 #include "rgb.h"
 #include <Arduino.h>
 
@@ -0,0 +1,97 @@
+#ifndef SENSOR_DHT11_H
+#define SENSOR_DHT11_H
+
+#include <Arduino.h>
+#include <acquisition.h>
+#if defined(ESP32)
+#include <dht_rmt.h>
+#else
+#include <DHT.h>
+#endif
+
+/**
+ * @brief Sensor DHT11 de temperatura y humedad ambiente, conectado a Board::pinDht.
+ *
+ * En el ESP32 la trama se captura con el periferico RMT (dht_rmt), sin desactivar las
+ * interrupciones, y la transaccion avanza por fases (start() y ready()) sin bloquear la tarea
+ * de adquisicion; en el ESP8266, que no lo tiene, read() la hace completa con la libreria de
+ * Adafruit. En ambos casos temperatura y humedad salen de una misma transaccion.
+ */
+template <class Board>
+struct Dht11Sensor {
+#if !defined(ESP32)
+  // Driver del sensor: solo se instancia si el nodo incluye el DHT11
+  static DHT dht;
+#endif
+
+  static void begin() {
+#if defined(ESP32)
+    dht_rmt_begin(Board::pinDht, DHT_MODEL_DHT11);
+#else
+    dht.begin();
+#endif
+    if (Board::pinLedPlaca >= 0) {
+      pinMode(Board::pinLedPlaca, OUTPUT);
+    }
+  }
+
+  // El LED de la placa (activo a nivel bajo) indica la lectura en curso
+  static void led_on() {
+    if (Board::pinLedPlaca >= 0) {
+      digitalWrite(Board::pinLedPlaca, LOW);
+    }
+  }
+
+#if defined(ESP32)
+  static void start() {
+    led_on();
+    dht_rmt_start();
+  }
+
+  static bool ready() {
+    return dht_rmt_poll();
+  }
+#endif
+
+  static void read(SensorSample& lectura) {
+#if !defined(ESP32)
+    led_on();
+#endif
+    // Sin respuesta valida los dos canales quedan a NAN y se omiten del mensaje
+    lectura.temperatureDHT = NAN;
+    lectura.humidityDHT = NAN;
+#if defined(ESP32)
+    DhtReading dht;
+    if (dht_rmt_result(&dht) == DHT_OK) {
+      lectura.temperatureDHT = dht.temperature;
+      lectura.humidityDHT = dht.humidity;
+    }
+#else
+    // read() hace la transaccion; las dos consultas siguientes usan su resultado
+    if (dht.read()) {
+      lectura.temperatureDHT = dht.readTemperature();
+      lectura.humidityDHT = dht.readHumidity();
+    }
+#endif
+    if (Board::pinLedPlaca >= 0) {
+      digitalWrite(Board::pinLedPlaca, HIGH);
+    }
+  }
+
+  static constexpr SensorDrivers bind(SensorDrivers drivers) {
+#if defined(ESP32)
+    return SensorDrivers{drivers.probeStart, drivers.probeReady, drivers.probeRead, start, ready, read,
+                         drivers.readSoil};
+#else
+    return SensorDrivers{drivers.probeStart, drivers.probeReady, drivers.probeRead, nullptr, nullptr, read,
+                         drivers.readSoil};
+#endif
+  }
+};
+
+#if !defined(ESP32)
+template <class Board>
+DHT Dht11Sensor<Board>::dht(Board::pinDht, DHT11);
+#endif
+
+#endif // SENSOR_DHT11_H
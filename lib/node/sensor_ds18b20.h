@@ -0,0 +1,52 @@
+#ifndef SENSOR_DS18B20_H
+#define SENSOR_DS18B20_H
+
+#include <math.h>
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <acquisition.h>
+
+/**
+ * @brief Sonda de temperatura del suelo DS18B20 en el bus OneWire de Board::pinSonda.
+ *
+ * La conversion se lanza sin esperar para que el motor de adquisicion lea el resto de
+ * sensores mientras tanto.
+ */
+template <class Board>
+struct Ds18b20Probe {
+  // Bus y driver: solo se instancian si el nodo incluye la sonda
+  static OneWire bus;
+  static DallasTemperature sonda;
+
+  static void begin() {
+    sonda.begin();
+    sonda.setWaitForConversion(false);
+  }
+
+  static uint16_t start() {
+    sonda.requestTemperatures();
+    return sonda.millisToWaitForConversion(sonda.getResolution());
+  }
+
+  static bool ready() {
+    return sonda.isConversionComplete();
+  }
+
+  static float read() {
+    float temperatura = sonda.getTempCByIndex(0);
+    // Sonda desconectada: el canal se omite en el mensaje
+    return temperatura == DEVICE_DISCONNECTED_C ? NAN : temperatura;
+  }
+
+  static constexpr SensorDrivers bind(SensorDrivers drivers) {
+    return SensorDrivers{start, ready, read, drivers.dhtStart, drivers.dhtReady, drivers.readDht, drivers.readSoil};
+  }
+};
+
+template <class Board>
+OneWire Ds18b20Probe<Board>::bus(Board::pinSonda);
+
+template <class Board>
+DallasTemperature Ds18b20Probe<Board>::sonda(&Ds18b20Probe<Board>::bus);
+
+#endif // SENSOR_DS18B20_H
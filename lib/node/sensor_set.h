@@ -0,0 +1,48 @@
+#ifndef SENSOR_SET_H
+#define SENSOR_SET_H
+
+#include <acquisition.h>
+
+/*
+///////////////// CONJUNTO DE SENSORES DE UN NODO \\\\\\\\\\\\\\\\\
+*/
+/**
+ * @brief Lista de sensores de un nodo como parametros de plantilla.
+ *
+ * Cada sensor es un tipo con dos funciones estaticas: begin(), que inicia el driver, y
+ * bind(), que rellena sus huecos en SensorDrivers. La tabla de drivers se calcula en tiempo
+ * de compilacion, y los sensores que no aparecen en la lista no se compilan ni ocupan memoria.
+ *
+ * Ejemplo: typedef SensorSet<Dht11Sensor<Board>, SoilSensor<Board>> Sensores;
+ */
+template <class... Sensores>
+struct SensorSet;
+
+template <>
+struct SensorSet<> {
+  static void begin() {}
+
+  static constexpr SensorDrivers drivers() {
+    return SensorDrivers{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+  }
+};
+
+template <class Sensor, class... Resto>
+struct SensorSet<Sensor, Resto...> {
+  /**
+   * @brief Inicia todos los sensores de la lista, en orden.
+   */
+  static void begin() {
+    Sensor::begin();
+    SensorSet<Resto...>::begin();
+  }
+
+  /**
+   * @brief Tabla de drivers para el motor de adquisicion (constante de compilacion).
+   */
+  static constexpr SensorDrivers drivers() {
+    return Sensor::bind(SensorSet<Resto...>::drivers());
+  }
+};
+
+#endif // SENSOR_SET_H
@@ -0,0 +1,53 @@
+#ifndef SENSOR_SOIL_H
+#define SENSOR_SOIL_H
+
+#include <LittleFS.h>
+#include <soil_adc.h>
+#include <acquisition.h>
+
+/**
+ * @brief Sensor capacitivo de humedad del suelo en el pin analogico Board::pinSuelo.
+ *
+ * La calibracion por defecto son los dos puntos Aire-Agua de la placa; si existe
+ * /soil_cal.bin en flash se sustituye por la tabla propia del dispositivo.
+ */
+template <class Board>
+struct SoilSensor {
+  // Calibracion: lectura del ADC -> humedad en centesimas de %
+  static SoilCalibration calibracion;
+  // Ultima lectura filtrada del ADC
+  static uint16_t adc;
+
+  // Requiere LittleFS montado para cargar la calibracion
+  static void begin() {
+    soil_calibration_load(LittleFS, "/soil_cal.bin", calibracion);
+  }
+
+  static void read(SensorSample& lectura) {
+    // Rafaga de conversiones filtrada y calibracion lineal a tramos (centesimas -> %)
+    adc = soil_adc_sample(Board::pinSuelo);
+    lectura.humidityCapacitor = (soil_calibrate(calibracion, adc) + 50) / 100;
+  }
+
+  /**
+   * @brief Voltaje de una lectura del ADC, segun la resolucion del ADC de la placa.
+   *
+   * @param muestra Lectura filtrada del ADC (por defecto, la ultima).
+   */
+  static float voltaje(uint16_t muestra = adc) {
+    return muestra * (Board::adcVref / Board::adcMax);
+  }
+
+  static constexpr SensorDrivers bind(SensorDrivers drivers) {
+    return SensorDrivers{drivers.probeStart, drivers.probeReady, drivers.probeRead, drivers.dhtStart, drivers.dhtReady,
+                         drivers.readDht, read};
+  }
+};
+
+template <class Board>
+SoilCalibration SoilSensor<Board>::calibracion = {2, {Board::sueloAire, Board::sueloAgua}, {10000, 0}};
+
+template <class Board>
+uint16_t SoilSensor<Board>::adc = 0;
+
+#endif // SENSOR_SOIL_H
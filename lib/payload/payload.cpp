@@ -0,0 +1,573 @@
+#include "payload.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef PAYLOAD_FORMAT_JSON
+#include <ArduinoJson.h>
+#endif
+
+// Escritura little-endian byte a byte: el buffer no tiene por que estar alineado
+static uint8_t* put_uint32(uint8_t* out, uint32_t value) {
+  for (uint8_t i = 0; i < 4; i++) {
+    out[i] = value >> (8 * i);
+  }
+  return out + 4;
+}
+
+static uint32_t get_uint32(const uint8_t* in) {
+  return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+// Canales de una lectura en el orden de la mascara del formato binario
+static const uint8_t CANALES_LECTURA = 4;
+static const char* const NOMBRES_CANALES[CANALES_LECTURA] = {
+  "temperatura_sonda", "temperatura_dht", "humedad_capacitor", "humedad_dht"};
+
+static float channel_value(const SensorSample& lectura, uint8_t canal) {
+  switch (canal) {
+    case CAMPO_TEMPERATURA_SONDA:
+      return lectura.temperatureProbe;
+    case CAMPO_TEMPERATURA_DHT:
+      return lectura.temperatureDHT;
+    case CAMPO_HUMEDAD_CAPACITOR:
+      return lectura.humidityCapacitor == SAMPLE_NO_HUMIDITY ? NAN : lectura.humidityCapacitor;
+    default:
+      return lectura.humidityDHT;
+  }
+}
+
+// Campos del mensaje de estado del enlace en el orden de LinkField
+static const uint8_t CAMPOS_ENLACE = 7;
+static const char* const NOMBRES_ENLACE[CAMPOS_ENLACE] = {
+  "conexiones", "perdidas", "intentos", "fallos", "perdidas_wifi", "reintentos_wifi", "latencia_ms"};
+
+static void link_values(const ConnStats& stats, uint32_t* valores) {
+  valores[CAMPO_CONEXIONES] = stats.mqttConnects;
+  valores[CAMPO_PERDIDAS] = stats.mqttLosses;
+  valores[CAMPO_INTENTOS] = stats.mqttAttempts;
+  valores[CAMPO_FALLOS] = stats.mqttFailures;
+  valores[CAMPO_PERDIDAS_WIFI] = stats.wifiLosses;
+  valores[CAMPO_REINTENTOS_WIFI] = stats.wifiRetries;
+  valores[CAMPO_LATENCIA] = stats.lastLatency;
+}
+
+// Campos del mensaje de tiempos del arranque: las fases de BootPhase y el modo WiFi
+static const uint8_t CAMPOS_ARRANQUE = ARRANQUE_FASES + 1;
+static const char* const NOMBRES_ARRANQUE[CAMPOS_ARRANQUE] = {
+  "sensores_ms", "wifi_ms", "mqtt_ms", "publicacion_ms", "modo_wifi"};
+
+static void boot_values(const BootTimeline& timeline, uint32_t* valores) {
+  for (uint8_t fase = 0; fase < ARRANQUE_FASES; fase++) {
+    valores[fase] = timeline.phases[fase];
+  }
+  valores[ARRANQUE_FASES] = timeline.wifiMode;
+}
+
+// Campos del mensaje del muestreo adaptativo
+static const uint8_t CAMPOS_MUESTREO = 5;
+static const char* const NOMBRES_MUESTREO[CAMPOS_MUESTREO] = {
+  "periodo_ms", "lecturas", "tiempo_s", "periodo_min_ms", "periodo_max_ms"};
+
+static void sampler_values(const AdaptiveSampler& sampler, uint32_t ahora, uint32_t* valores) {
+  valores[0] = sampler.period;
+  valores[1] = sampler.samples;
+  valores[2] = (ahora - sampler.start) / 1000;
+  valores[3] = sampler.config.minPeriod;
+  valores[4] = sampler.config.maxPeriod;
+}
+
+// Busca una cadena dentro de un mensaje que no tiene por que acabar en '\0'
+static bool contains(const uint8_t* buffer, size_t len, const char* text) {
+  size_t n = strlen(text);
+  for (size_t i = 0; i + n <= len; i++) {
+    if (memcmp(buffer + i, text, n) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef PAYLOAD_FORMAT_JSON
+
+size_t payload_encode_params(const SensorSample& lectura, uint32_t edad, uint64_t instante, uint8_t* buffer,
+                             size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(5)> params;
+  if (!isnan(lectura.temperatureProbe)) {
+    params["temperatura_sonda"] = lectura.temperatureProbe;
+  }
+  if (!isnan(lectura.temperatureDHT)) {
+    params["temperatura_dht"] = lectura.temperatureDHT;
+  }
+  if (lectura.humidityCapacitor != SAMPLE_NO_HUMIDITY) {
+    params["humedad_capacitor"] = lectura.humidityCapacitor;
+  }
+  if (!isnan(lectura.humidityDHT)) {
+    params["humedad_dht"] = lectura.humidityDHT;
+  }
+  if (instante > 0) {
+    params["ts"] = instante;
+  } else if (edad > 0) {
+    params["edad"] = edad;
+  }
+  // Serializa directamente en el buffer del llamante, sin String intermedio
+  size_t len = serializeJson(params, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_coverage(int rssi, uint8_t* buffer, size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(1)> coverage;
+  coverage["dBm"] = rssi;
+  size_t len = serializeJson(coverage, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_link(const ConnStats& stats, uint8_t* buffer, size_t size) {
+  uint32_t valores[CAMPOS_ENLACE];
+  link_values(stats, valores);
+  StaticJsonDocument<JSON_OBJECT_SIZE(CAMPOS_ENLACE)> enlace;
+  for (uint8_t campo = 0; campo < CAMPOS_ENLACE; campo++) {
+    enlace[NOMBRES_ENLACE[campo]] = valores[campo];
+  }
+  size_t len = serializeJson(enlace, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_boot(const BootTimeline& timeline, uint8_t* buffer, size_t size) {
+  uint32_t valores[CAMPOS_ARRANQUE];
+  boot_values(timeline, valores);
+  StaticJsonDocument<JSON_OBJECT_SIZE(CAMPOS_ARRANQUE)> arranque;
+  for (uint8_t campo = 0; campo < CAMPOS_ARRANQUE; campo++) {
+    arranque[NOMBRES_ARRANQUE[campo]] = valores[campo];
+  }
+  size_t len = serializeJson(arranque, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_sampler(const AdaptiveSampler& sampler, uint32_t ahora, uint8_t* buffer, size_t size) {
+  uint32_t valores[CAMPOS_MUESTREO];
+  sampler_values(sampler, ahora, valores);
+  StaticJsonDocument<JSON_OBJECT_SIZE(CAMPOS_MUESTREO)> muestreo;
+  for (uint8_t campo = 0; campo < CAMPOS_MUESTREO; campo++) {
+    muestreo[NOMBRES_MUESTREO[campo]] = valores[campo];
+  }
+  size_t len = serializeJson(muestreo, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_summary(const WindowStats& window, uint32_t duracion, uint64_t instante, uint8_t* buffer,
+                              size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(2 + 5 * STATS_CHANNELS)> resumen;
+  // Nombres compuestos de los campos. ArduinoJson guarda solo el puntero de las claves
+  // const char*, por eso el buffer es estatico y no se copian al documento
+  static char nombres[STATS_CHANNELS * 5][28];
+  static const char* const SUFIJOS[5] = {"n", "min", "max", "media", "desv"};
+  resumen["ventana_ms"] = duracion;
+  for (uint8_t canal = 0; canal < STATS_CHANNELS; canal++) {
+    const RunningStats& stats = window.channels[canal];
+    if (stats.count == 0) {
+      continue;
+    }
+    float valores[5] = {(float)stats.count, stats.min, stats.max, stats.mean, running_stddev(stats)};
+    for (uint8_t campo = 0; campo < 5; campo++) {
+      char* nombre = nombres[canal * 5 + campo];
+      snprintf(nombre, sizeof(nombres[0]), "%s_%s", NOMBRES_CANALES[canal], SUFIJOS[campo]);
+      resumen[(const char*)nombre] = valores[campo];
+    }
+  }
+  if (instante > 0) {
+    resumen["ts"] = instante;
+  }
+  size_t len = serializeJson(resumen, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+size_t payload_encode_batch(const SensorSample* lecturas, uint8_t n, uint32_t ahora, uint64_t instante, uint8_t* buffer,
+                            size_t size) {
+  if (n == 1) {
+    return payload_encode_params(lecturas[0], (ahora - lecturas[0].timestamp) / 1000, instante, buffer, size);
+  }
+  if (n == 0 || n > PAYLOAD_BATCH_MAX_SAMPLES) {
+    return 0;
+  }
+
+  // Documento estatico: demasiado grande para la pila del loop en el ESP8266
+  static StaticJsonDocument<JSON_OBJECT_SIZE(6) + 5 * JSON_ARRAY_SIZE(PAYLOAD_BATCH_MAX_SAMPLES)> lote;
+  lote.clear();
+  // "t0" va siempre primero: payload_add_age() lo busca al principio del documento
+  if (instante > 0) {
+    lote["ts"] = instante;
+  } else {
+    lote["t0"] = ahora - lecturas[0].timestamp;
+  }
+  JsonArray dt = lote.createNestedArray("dt");
+  for (uint8_t i = 1; i < n; i++) {
+    dt.add(lecturas[i].timestamp - lecturas[i - 1].timestamp);
+  }
+  for (uint8_t canal = 0; canal < CANALES_LECTURA; canal++) {
+    JsonArray valores = lote.createNestedArray(NOMBRES_CANALES[canal]);
+    for (uint8_t i = 0; i < n; i++) {
+      float valor = channel_value(lecturas[i], canal);
+      if (isnan(valor)) {
+        valores.add(nullptr);
+      } else {
+        valores.add(valor);
+      }
+    }
+  }
+  size_t len = serializeJson(lote, (char*)buffer, size);
+  return len < size ? len : 0;
+}
+
+#else
+
+static uint8_t* put_int16(uint8_t* out, int16_t value) {
+  out[0] = (uint16_t)value & 0xFF;
+  out[1] = (uint16_t)value >> 8;
+  return out + 2;
+}
+
+static uint8_t* put_uint64(uint8_t* out, uint64_t value) {
+  out = put_uint32(out, (uint32_t)value);
+  return put_uint32(out, (uint32_t)(value >> 32));
+}
+
+// Valor en decimas, saturado al rango de int16
+static int16_t tenths(float value) {
+  float scaled = roundf(value * 10.0f);
+  if (scaled > 32767.0f) {
+    return 32767;
+  }
+  if (scaled < -32768.0f) {
+    return -32768;
+  }
+  return (int16_t)scaled;
+}
+
+size_t payload_encode_params(const SensorSample& lectura, uint32_t edad, uint64_t instante, uint8_t* buffer,
+                             size_t size) {
+  // cabecera (3) + cuatro canales (8) + instante (8) o edad (4)
+  if (size < 19) {
+    return 0;
+  }
+
+  uint8_t mask = 0;
+  uint8_t* out = buffer + 3;
+  if (!isnan(lectura.temperatureProbe)) {
+    mask |= 1 << CAMPO_TEMPERATURA_SONDA;
+    out = put_int16(out, tenths(lectura.temperatureProbe));
+  }
+  if (!isnan(lectura.temperatureDHT)) {
+    mask |= 1 << CAMPO_TEMPERATURA_DHT;
+    out = put_int16(out, tenths(lectura.temperatureDHT));
+  }
+  if (lectura.humidityCapacitor != SAMPLE_NO_HUMIDITY) {
+    mask |= 1 << CAMPO_HUMEDAD_CAPACITOR;
+    out = put_int16(out, lectura.humidityCapacitor);
+  }
+  if (!isnan(lectura.humidityDHT)) {
+    mask |= 1 << CAMPO_HUMEDAD_DHT;
+    out = put_int16(out, tenths(lectura.humidityDHT));
+  }
+  if (instante > 0) {
+    mask |= 1 << CAMPO_INSTANTE;
+    out = put_uint64(out, instante);
+  } else if (edad > 0) {
+    mask |= 1 << CAMPO_EDAD;
+    out = put_uint32(out, edad);
+  }
+
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_PARAMS;
+  buffer[2] = mask;
+  return out - buffer;
+}
+
+size_t payload_encode_coverage(int rssi, uint8_t* buffer, size_t size) {
+  if (size < 5) {
+    return 0;
+  }
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_COVERAGE;
+  buffer[2] = 1 << CAMPO_DBM;
+  put_int16(buffer + 3, rssi);
+  return 5;
+}
+
+size_t payload_encode_link(const ConnStats& stats, uint8_t* buffer, size_t size) {
+  // cabecera (3) + campos (4 cada uno)
+  if (size < 3 + 4u * CAMPOS_ENLACE) {
+    return 0;
+  }
+  uint32_t valores[CAMPOS_ENLACE];
+  link_values(stats, valores);
+  uint8_t* out = buffer + 3;
+  for (uint8_t campo = 0; campo < CAMPOS_ENLACE; campo++) {
+    out = put_uint32(out, valores[campo]);
+  }
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_LINK;
+  buffer[2] = (1 << CAMPOS_ENLACE) - 1;
+  return out - buffer;
+}
+
+size_t payload_encode_boot(const BootTimeline& timeline, uint8_t* buffer, size_t size) {
+  if (size < 3 + 4u * CAMPOS_ARRANQUE) {
+    return 0;
+  }
+  uint32_t valores[CAMPOS_ARRANQUE];
+  boot_values(timeline, valores);
+  uint8_t* out = buffer + 3;
+  for (uint8_t campo = 0; campo < CAMPOS_ARRANQUE; campo++) {
+    out = put_uint32(out, valores[campo]);
+  }
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_BOOT;
+  buffer[2] = (1 << CAMPOS_ARRANQUE) - 1;
+  return out - buffer;
+}
+
+size_t payload_encode_sampler(const AdaptiveSampler& sampler, uint32_t ahora, uint8_t* buffer, size_t size) {
+  if (size < 3 + 4u * CAMPOS_MUESTREO) {
+    return 0;
+  }
+  uint32_t valores[CAMPOS_MUESTREO];
+  sampler_values(sampler, ahora, valores);
+  uint8_t* out = buffer + 3;
+  for (uint8_t campo = 0; campo < CAMPOS_MUESTREO; campo++) {
+    out = put_uint32(out, valores[campo]);
+  }
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_SAMPLER;
+  buffer[2] = (1 << CAMPOS_MUESTREO) - 1;
+  return out - buffer;
+}
+
+// Valor con la escala del canal (decimas, o unidades para la humedad del capacitor) y
+// opcionalmente un decimal mas, saturado al rango de int16
+static int16_t scaled(uint8_t canal, float value, bool decimalExtra) {
+  if (decimalExtra) {
+    value *= 10.0f;
+  }
+  if (canal != CAMPO_HUMEDAD_CAPACITOR) {
+    return tenths(value);
+  }
+  float rounded = roundf(value);
+  return rounded > 32767.0f ? 32767 : rounded < -32768.0f ? -32768 : (int16_t)rounded;
+}
+
+size_t payload_encode_summary(const WindowStats& window, uint32_t duracion, uint64_t instante, uint8_t* buffer,
+                              size_t size) {
+  // cabecera (3) + duracion (4) + 10 bytes por canal + instante (8) o edad (4)
+  if (size < 15 + 10u * STATS_CHANNELS) {
+    return 0;
+  }
+
+  uint8_t mask = 0;
+  uint8_t* out = put_uint32(buffer + 3, duracion);
+  for (uint8_t canal = 0; canal < STATS_CHANNELS; canal++) {
+    const RunningStats& stats = window.channels[canal];
+    if (stats.count == 0) {
+      continue;
+    }
+    mask |= 1 << canal;
+    out = put_int16(out, (int16_t)stats.count);
+    out = put_int16(out, scaled(canal, stats.min, false));
+    out = put_int16(out, scaled(canal, stats.max, false));
+    out = put_int16(out, scaled(canal, stats.mean, true));
+    // Desviacion sin signo: hasta 65535 en su escala
+    float desviacion = roundf(running_stddev(stats) * (canal == CAMPO_HUMEDAD_CAPACITOR ? 10.0f : 100.0f));
+    out = put_int16(out, (int16_t)(uint16_t)(desviacion > 65535.0f ? 65535.0f : desviacion));
+  }
+  if (instante > 0) {
+    mask |= 1 << CAMPO_INSTANTE;
+    out = put_uint64(out, instante);
+  }
+
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_SUMMARY;
+  buffer[2] = mask;
+  return out - buffer;
+}
+
+// Entero sin signo de longitud variable: 7 bits por byte, bit alto como continuacion
+static uint8_t* put_varint(uint8_t* out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  *out++ = value;
+  return out;
+}
+
+// Zigzag: las diferencias pequeñas, positivas o negativas, ocupan un solo byte
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+size_t payload_encode_gorilla(const SensorSample* lecturas, uint8_t n, uint32_t ahora, uint64_t instante, uint8_t mode,
+                              uint8_t* buffer, size_t size) {
+  // cabecera (4), instante (8) o edad (4) y codificacion (1)
+  if (n == 0 || size < 13) {
+    return 0;
+  }
+
+  uint8_t* out = buffer + 4;
+  uint8_t mask = 0;
+  if (instante > 0) {
+    mask |= 1 << CAMPO_INSTANTE;
+    out = put_uint64(out, instante);
+  } else {
+    out = put_uint32(out, ahora - lecturas[0].timestamp);
+  }
+  *out++ = mode;
+
+  GorillaEncoder flujo;
+  gorilla_begin(&flujo, mode, lecturas[0].timestamp, out, size - (out - buffer));
+  for (uint8_t i = 0; i < n; i++) {
+    if (!gorilla_append(&flujo, lecturas[i])) {
+      return 0;
+    }
+  }
+
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_GORILLA;
+  buffer[2] = mask | flujo.channels;
+  buffer[3] = n;
+  return (out - buffer) + gorilla_size(&flujo);
+}
+
+size_t payload_encode_batch(const SensorSample* lecturas, uint8_t n, uint32_t ahora, uint64_t instante, uint8_t* buffer,
+                            size_t size) {
+  if (n == 1) {
+    return payload_encode_params(lecturas[0], (ahora - lecturas[0].timestamp) / 1000, instante, buffer, size);
+  }
+#ifdef PAYLOAD_BATCH_GORILLA
+  // Si el flujo no cabe (valores que cambian mucho en GORILLA_XOR) se envia sin comprimir
+  size_t comprimido = payload_encode_gorilla(lecturas, n, ahora, instante, PAYLOAD_GORILLA_MODE, buffer, size);
+  if (comprimido > 0) {
+    return comprimido;
+  }
+#endif
+  // Peor caso: cabecera e instante (12), tiempos (5 por lectura) y canales (mapa + 3 por lectura)
+  size_t bitmap = (n + 7) / 8;
+  if (n == 0 || n > PAYLOAD_BATCH_MAX_SAMPLES || size < 12 + 5u * n + CANALES_LECTURA * (bitmap + 3u * n)) {
+    return 0;
+  }
+
+  uint8_t* out = buffer + 4;
+  uint8_t mask = 0;
+  if (instante > 0) {
+    mask |= 1 << CAMPO_INSTANTE;
+    out = put_uint64(out, instante);
+  } else {
+    out = put_uint32(out, ahora - lecturas[0].timestamp);
+  }
+  for (uint8_t i = 1; i < n; i++) {
+    out = put_varint(out, lecturas[i].timestamp - lecturas[i - 1].timestamp);
+  }
+
+  for (uint8_t canal = 0; canal < CANALES_LECTURA; canal++) {
+    // Mapa de lecturas presentes; el canal se omite si no tiene ningun valor
+    uint8_t* presentes = out;
+    memset(presentes, 0, bitmap);
+    uint8_t* valores = out + bitmap;
+    bool primero = true;
+    int16_t anterior = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+      float valor = channel_value(lecturas[i], canal);
+      if (isnan(valor)) {
+        continue;
+      }
+      presentes[i / 8] |= 1 << (i % 8);
+      int16_t actual = canal == CAMPO_HUMEDAD_CAPACITOR ? (int16_t)valor : tenths(valor);
+      if (primero) {
+        valores = put_int16(valores, actual);
+        primero = false;
+      } else {
+        valores = put_varint(valores, zigzag((int32_t)actual - anterior));
+      }
+      anterior = actual;
+    }
+
+    if (!primero) {
+      mask |= 1 << canal;
+      out = valores;
+    }
+  }
+
+  buffer[0] = PAYLOAD_BINARY_V1;
+  buffer[1] = PAYLOAD_TYPE_BATCH;
+  buffer[2] = mask;
+  buffer[3] = n;
+  return out - buffer;
+}
+
+#endif
+
+size_t payload_add_age(uint8_t* buffer, size_t len, size_t size, uint32_t edad) {
+  if (len < 3) {
+    return len;
+  }
+
+  // Lecturas, lotes y resumenes fechados con la hora UTC no necesitan la edad. En los demas
+  // tipos el bit 6 es un campo propio
+  uint8_t tipo = buffer[1];
+  if (buffer[0] == PAYLOAD_BINARY_V1 && (buffer[2] & (1 << CAMPO_INSTANTE)) &&
+      (tipo == PAYLOAD_TYPE_PARAMS || tipo == PAYLOAD_TYPE_BATCH || tipo == PAYLOAD_TYPE_GORILLA ||
+       tipo == PAYLOAD_TYPE_SUMMARY)) {
+    return len;
+  }
+
+  // Lote binario: la edad de la primera lectura esta en la cabecera
+  if (buffer[0] == PAYLOAD_BINARY_V1 && (tipo == PAYLOAD_TYPE_BATCH || tipo == PAYLOAD_TYPE_GORILLA)) {
+    if (len >= 8) {
+      put_uint32(buffer + 4, edad == PAYLOAD_AGE_UNKNOWN ? PAYLOAD_AGE_UNKNOWN : get_uint32(buffer + 4) + edad * 1000);
+    }
+    return len;
+  }
+
+  // Binario: la edad es siempre el ultimo campo, basta con añadirla al final
+  if (buffer[0] == PAYLOAD_BINARY_V1) {
+    if ((buffer[2] & (1 << CAMPO_EDAD)) || len + 4 > size) {
+      return len;
+    }
+    buffer[2] |= 1 << CAMPO_EDAD;
+    put_uint32(buffer + len, edad);
+    return len + 4;
+  }
+
+  // Lote JSON: se suma la edad a "t0", que siempre es el primer campo del documento
+  static const char T0[] = "{\"t0\":";
+  if (len > sizeof(T0) && memcmp(buffer, T0, sizeof(T0) - 1) == 0) {
+    uint8_t* inicio = buffer + sizeof(T0) - 1;
+    uint8_t* fin = inicio;
+    unsigned long t0 = 0;
+    while (fin < buffer + len && *fin >= '0' && *fin <= '9') {
+      t0 = t0 * 10 + (*fin++ - '0');
+    }
+    char numero[12];
+    unsigned long total = edad == PAYLOAD_AGE_UNKNOWN ? PAYLOAD_AGE_UNKNOWN : t0 + (unsigned long)edad * 1000;
+    int n = snprintf(numero, sizeof(numero), "%lu", total);
+    size_t resto = buffer + len - fin;
+    if (n <= 0 || (inicio - buffer) + n + resto > size) {
+      return len;
+    }
+    memmove(inicio + n, fin, resto);
+    memcpy(inicio, numero, n);
+    return (inicio - buffer) + n + resto;
+  }
+
+  // JSON: se inserta el campo antes de la llave de cierre
+  if (buffer[len - 1] != '}' || contains(buffer, len, "\"edad\"") || contains(buffer, len, "\"ts\"")) {
+    return len;
+  }
+  char field[24];
+  int n = snprintf(field, sizeof(field), ",\"edad\":%lu}", (unsigned long)edad);
+  if (n <= 0 || len - 1 + n > size) {
+    return len;
+  }
+  memcpy(buffer + len - 1, field, n);
+  return len - 1 + n;
+}
@@ -0,0 +1,239 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sample.h>
+#include <conn_supervisor.h>
+#include <boot_timeline.h>
+#include <window_stats.h>
+#include <adaptive_sampler.h>
+#include <gorilla.h>
+
+/*
+///////////////// CODIFICACION DE LOS MENSAJES MQTT \\\\\\\\\\\\\\\\\
+*/
+// Por defecto se usa el formato binario compacto; PAYLOAD_FORMAT_JSON recupera el formato JSON
+// Tamaño de buffer suficiente para cualquier mensaje en cualquiera de los dos formatos
+#define PAYLOAD_MAX_SIZE 128
+
+// Primer byte de un mensaje binario: marca (0xB0) y version del formato (1).
+// Un mensaje JSON siempre empieza por '{', lo que permite distinguir ambos formatos
+#define PAYLOAD_BINARY_V1 0xB1
+
+// Tipo de mensaje binario
+#define PAYLOAD_TYPE_PARAMS 1
+#define PAYLOAD_TYPE_COVERAGE 2
+#define PAYLOAD_TYPE_BATCH 3
+#define PAYLOAD_TYPE_LINK 4
+#define PAYLOAD_TYPE_BOOT 5
+#define PAYLOAD_TYPE_SUMMARY 6
+#define PAYLOAD_TYPE_SAMPLER 7
+#define PAYLOAD_TYPE_GORILLA 8
+
+// Numero maximo de lecturas en un lote y tamaño de buffer suficiente para codificarlo
+#ifndef PAYLOAD_BATCH_MAX_SAMPLES
+#define PAYLOAD_BATCH_MAX_SAMPLES 16
+#endif
+#ifdef PAYLOAD_FORMAT_JSON
+#define PAYLOAD_BATCH_MAX_SIZE 1024
+#else
+#define PAYLOAD_BATCH_MAX_SIZE 320
+#endif
+
+// PAYLOAD_BATCH_GORILLA: en formato binario los lotes se envian comprimidos (ver
+// payload_encode_gorilla()), con los valores codificados segun PAYLOAD_GORILLA_MODE
+#ifndef PAYLOAD_GORILLA_MODE
+#define PAYLOAD_GORILLA_MODE GORILLA_QUANTIZED
+#endif
+
+/**
+ * @brief Campos del formato binario, en el orden en que se escriben. Cada campo presente
+ * se marca en la mascara del mensaje; los valores decimales se envian en decimas.
+ *
+ * | campo              | tipo    | escala |
+ * |--------------------|---------|--------|
+ * | temperatura_sonda  | int16   | x10    |
+ * | temperatura_dht    | int16   | x10    |
+ * | humedad_capacitor  | int16   | x1     |
+ * | humedad_dht        | int16   | x10    |
+ * | dBm                | int16   | x1     |
+ * | instante           | uint64  | ms     |
+ * | edad               | uint32  | s      |
+ *
+ * instante es la hora UTC de la adquisicion en ms desde la epoca Unix ("ts" en JSON). Solo la
+ * llevan los nodos con el reloj sincronizado; los demas indican la edad y el suscriptor los
+ * fecha al recibirlos. Una edad PAYLOAD_AGE_UNKNOWN indica que no se conoce: el suscriptor
+ * marca la lectura como sin fecha.
+ */
+// Edad de un mensaje guardado en un arranque anterior del nodo sin la hora UTC. En los lotes
+// ocupa el lugar de la edad en ms de la primera lectura ("t0" en JSON)
+#define PAYLOAD_AGE_UNKNOWN 0xFFFFFFFFUL
+
+enum PayloadField {
+  CAMPO_TEMPERATURA_SONDA = 0,
+  CAMPO_TEMPERATURA_DHT = 1,
+  CAMPO_HUMEDAD_CAPACITOR = 2,
+  CAMPO_HUMEDAD_DHT = 3,
+  CAMPO_DBM = 4,
+  CAMPO_INSTANTE = 6,
+  CAMPO_EDAD = 7,
+};
+
+/**
+ * @brief Codifica una lectura de los sensores en el buffer indicado, sin memoria dinamica.
+ * Los canales sin valor (NAN o SAMPLE_NO_HUMIDITY) se omiten.
+ *
+ * @param lectura Lectura a codificar.
+ * @param edad Segundos transcurridos desde la adquisicion (0 para lecturas en tiempo real).
+ * @param instante Hora UTC de la adquisicion en ms, o 0 si el reloj no esta sincronizado.
+ * Si se indica, sustituye a la edad.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_params(const SensorSample& lectura, uint32_t edad, uint64_t instante, uint8_t* buffer,
+                             size_t size);
+
+/**
+ * @brief Codifica la intensidad de la señal WiFi en el buffer indicado.
+ *
+ * @param rssi Intensidad de la señal en dBm.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_coverage(int rssi, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Campos del mensaje de estado del enlace (PAYLOAD_TYPE_LINK), todos uint32. El bit 7
+ * de la mascara sigue reservado para la edad.
+ */
+enum LinkField {
+  CAMPO_CONEXIONES = 0,
+  CAMPO_PERDIDAS = 1,
+  CAMPO_INTENTOS = 2,
+  CAMPO_FALLOS = 3,
+  CAMPO_PERDIDAS_WIFI = 4,
+  CAMPO_REINTENTOS_WIFI = 5,
+  CAMPO_LATENCIA = 6,
+};
+
+/**
+ * @brief Codifica los contadores de la conexion: conexiones y perdidas de la sesion MQTT,
+ * intentos y fallos de conexion, perdidas y reintentos de la WiFi, y tiempo (ms) que tardo
+ * en recuperarse la ultima conexion.
+ *
+ * @param stats Contadores del supervisor de la conexion.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_link(const ConnStats& stats, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Codifica los tiempos del arranque: instante (ms desde el arranque) en que quedan
+ * listos los sensores, la WiFi, la sesion MQTT y la primera publicacion, y el modo de
+ * asociacion WiFi (BootWifiMode). Mismo formato que el estado del enlace: campos uint32
+ * en el orden de BootPhase seguidos del modo.
+ *
+ * @param timeline Tiempos del arranque.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_boot(const BootTimeline& timeline, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Codifica el estado del muestreo adaptativo: periodo actual, lecturas tomadas y
+ * segundos transcurridos desde que empezo a contar (su cociente es la frecuencia efectiva) y
+ * limites del periodo. Mismo formato que el estado del enlace, con campos uint32.
+ *
+ * @param sampler Estado del muestreo.
+ * @param ahora Instante actual en milisegundos.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_sampler(const AdaptiveSampler& sampler, uint32_t ahora, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Codifica el resumen de una ventana de lecturas.
+ *
+ * Formato binario: cabecera (marca, tipo, mascara de canales con lecturas), duracion de la
+ * ventana en ms (uint32) y, por cada canal presente, numero de lecturas (uint16), minimo y
+ * maximo (int16, con la escala del canal), media (int16) y desviacion tipica (uint16) con un
+ * decimal mas que el canal, y el instante de cierre (uint64, bit 6 de la mascara) si el reloj
+ * esta sincronizado. En JSON los campos son "<canal>_n", "_min", "_max", "_media" y "_desv",
+ * junto a "ventana_ms" y "ts".
+ *
+ * @param window Ventana cerrada.
+ * @param duracion Duracion real de la ventana en milisegundos.
+ * @param instante Hora UTC del cierre de la ventana en ms, o 0 si el reloj no esta sincronizado.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_summary(const WindowStats& window, uint32_t duracion, uint64_t instante, uint8_t* buffer,
+                              size_t size);
+
+/**
+ * @brief Codifica un lote de lecturas en un unico mensaje.
+ *
+ * Formato binario: cabecera (marca, tipo, mascara de canales, numero de lecturas), edad en
+ * ms de la primera lectura (uint32), diferencias de tiempo entre lecturas consecutivas
+ * (varint, ms) y, por cada canal, un mapa de bits de lecturas presentes, el primer valor
+ * (int16) y las diferencias respecto al valor anterior (varint zigzag). En JSON se envia
+ * {"t0": edad_ms, "dt": [...], "<canal>": [...]}. Con el reloj sincronizado la edad se sustituye
+ * por la hora UTC de la primera lectura: uint64 en ms con el bit 6 de la mascara en binario,
+ * y "ts" en lugar de "t0" en JSON. Un lote de una sola lectura se codifica como una lectura
+ * individual.
+ *
+ * @param lecturas Lecturas ordenadas de la mas antigua a la mas reciente.
+ * @param n Numero de lecturas (como mucho PAYLOAD_BATCH_MAX_SAMPLES).
+ * @param ahora Instante actual en la base de tiempo del nodo.
+ * @param instante Hora UTC de la primera lectura en ms, o 0 si el reloj no esta sincronizado.
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_batch(const SensorSample* lecturas, uint8_t n, uint32_t ahora, uint64_t instante, uint8_t* buffer,
+                            size_t size);
+
+#ifndef PAYLOAD_FORMAT_JSON
+/**
+ * @brief Codifica un lote de lecturas comprimido con gorilla.h.
+ *
+ * Formato binario: cabecera (marca, tipo PAYLOAD_TYPE_GORILLA, mascara de canales, numero de
+ * lecturas), edad en ms de la primera lectura (uint32) o su hora UTC (uint64, bit 6 de la
+ * mascara), codificacion de los valores (GorillaMode, uint8) y el flujo de bits hasta el final
+ * del mensaje, con la primera lectura como base de tiempo. Con lecturas cada pocos segundos y
+ * canales que cambian despacio, cada lectura ocupa unos pocos bits.
+ *
+ * @param lecturas Lecturas ordenadas de la mas antigua a la mas reciente.
+ * @param n Numero de lecturas.
+ * @param ahora Instante actual en la base de tiempo del nodo.
+ * @param instante Hora UTC de la primera lectura en ms, o 0 si el reloj no esta sincronizado.
+ * @param mode Codificacion de los valores (GorillaMode).
+ * @param buffer Buffer destino proporcionado por el llamante.
+ * @param size Tamaño del buffer.
+ * @return Numero de bytes escritos, o 0 si no cabe.
+ */
+size_t payload_encode_gorilla(const SensorSample* lecturas, uint8_t n, uint32_t ahora, uint64_t instante, uint8_t mode,
+                              uint8_t* buffer, size_t size);
+#endif
+
+/**
+ * @brief Añade la edad a un mensaje ya codificado (en cualquiera de los dos formatos) si
+ * todavia no la lleva. Los mensajes fechados con la hora UTC no se modifican.
+ *
+ * @param buffer Mensaje codificado.
+ * @param len Longitud del mensaje.
+ * @param size Tamaño total del buffer.
+ * @param edad Segundos transcurridos desde la adquisicion, o PAYLOAD_AGE_UNKNOWN si no se
+ * conocen.
+ * @return Nueva longitud del mensaje.
+ */
+size_t payload_add_age(uint8_t* buffer, size_t len, size_t size, uint32_t edad);
+
+#endif // PAYLOAD_H
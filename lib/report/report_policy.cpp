@@ -0,0 +1,95 @@
+#include "report_policy.h"
+#include <math.h>
+
+static const char* const NOMBRES_CANALES[REPORT_CHANNELS] = {
+  "temperatura_sonda", "temperatura_dht", "humedad_capacitor", "humedad_dht", "dBm"};
+
+const char* report_channel_name(uint8_t campo) {
+  return campo < REPORT_CHANNELS ? NOMBRES_CANALES[campo] : "";
+}
+
+void report_configure(ReportPolicy* policy, PayloadField campo, float deadBand, float rate, uint32_t heartbeat) {
+  if (campo >= REPORT_CHANNELS) {
+    return;
+  }
+  ReportChannel& channel = policy->channels[campo];
+  channel.deadBand = deadBand;
+  channel.rate = rate;
+  channel.heartbeat = heartbeat;
+}
+
+void report_init(ReportPolicy* policy) {
+  for (uint8_t i = 0; i < REPORT_CHANNELS; i++) {
+    ReportChannel& channel = policy->channels[i];
+    channel.hasSent = false;
+    channel.hasLast = false;
+    channel.sent = 0;
+    channel.suppressed = 0;
+  }
+  report_configure(policy, CAMPO_TEMPERATURA_SONDA, REPORT_DEADBAND_TEMPERATURE, REPORT_RATE_TEMPERATURE, REPORT_HEARTBEAT);
+  report_configure(policy, CAMPO_TEMPERATURA_DHT, REPORT_DEADBAND_TEMPERATURE, REPORT_RATE_TEMPERATURE, REPORT_HEARTBEAT);
+  report_configure(policy, CAMPO_HUMEDAD_CAPACITOR, REPORT_DEADBAND_HUMIDITY, REPORT_RATE_HUMIDITY, REPORT_HEARTBEAT);
+  report_configure(policy, CAMPO_HUMEDAD_DHT, REPORT_DEADBAND_HUMIDITY, REPORT_RATE_HUMIDITY, REPORT_HEARTBEAT);
+  // La cobertura no tiene umbral de velocidad: el RSSI oscila mucho entre lecturas
+  report_configure(policy, CAMPO_DBM, REPORT_DEADBAND_DBM, 0, REPORT_HEARTBEAT);
+}
+
+bool report_channel_due(ReportChannel* channel, float value, uint32_t ahora) {
+  if (isnan(value)) {
+    return false;
+  }
+
+  bool due = !channel->hasSent;
+  if (!due && channel->heartbeat > 0 && ahora - channel->sentTime >= channel->heartbeat) {
+    due = true;
+  }
+  if (!due && fabsf(value - channel->sentValue) > channel->deadBand) {
+    due = true;
+  }
+  // Cambio rapido entre dos lecturas seguidas (riego, apertura de ventanas...)
+  if (!due && channel->rate > 0 && channel->hasLast && ahora != channel->lastTime) {
+    float perMinute = fabsf(value - channel->lastValue) * 60000.0f / (uint32_t)(ahora - channel->lastTime);
+    due = perMinute > channel->rate;
+  }
+
+  channel->lastValue = value;
+  channel->lastTime = ahora;
+  channel->hasLast = true;
+  if (!due) {
+    channel->suppressed++;
+    return false;
+  }
+  channel->sentValue = value;
+  channel->sentTime = ahora;
+  channel->hasSent = true;
+  channel->sent++;
+  return true;
+}
+
+bool report_filter(ReportPolicy* policy, SensorSample& lectura) {
+  ReportChannel* channels = policy->channels;
+  bool any = false;
+
+  if (!report_channel_due(&channels[CAMPO_TEMPERATURA_SONDA], lectura.temperatureProbe, lectura.timestamp)) {
+    lectura.temperatureProbe = NAN;
+  } else {
+    any = true;
+  }
+  if (!report_channel_due(&channels[CAMPO_TEMPERATURA_DHT], lectura.temperatureDHT, lectura.timestamp)) {
+    lectura.temperatureDHT = NAN;
+  } else {
+    any = true;
+  }
+  float capacitor = lectura.humidityCapacitor == SAMPLE_NO_HUMIDITY ? NAN : lectura.humidityCapacitor;
+  if (!report_channel_due(&channels[CAMPO_HUMEDAD_CAPACITOR], capacitor, lectura.timestamp)) {
+    lectura.humidityCapacitor = SAMPLE_NO_HUMIDITY;
+  } else {
+    any = true;
+  }
+  if (!report_channel_due(&channels[CAMPO_HUMEDAD_DHT], lectura.humidityDHT, lectura.timestamp)) {
+    lectura.humidityDHT = NAN;
+  } else {
+    any = true;
+  }
+  return any;
+}
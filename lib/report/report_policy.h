@@ -0,0 +1,115 @@
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <stdint.h>
+#include <sample.h>
+#include <payload.h>
+
+/*
+///////////////// POLITICA DE ENVIO POR CAMBIO (BANDA MUERTA) \\\\\\\\\\\\\\\\\
+*/
+// Un canal se envia cuando se aleja mas de la banda muerta del ultimo valor enviado, cuando
+// cambia mas rapido que el umbral de velocidad, o cuando pasa el latido sin enviar nada.
+// Los valores por defecto se pueden cambiar con build_flags.
+
+// Latido: tiempo maximo (ms) sin enviar un canal aunque no cambie
+#ifndef REPORT_HEARTBEAT
+#define REPORT_HEARTBEAT 1800000UL
+#endif
+
+// Bandas muertas en las unidades de cada canal
+#ifndef REPORT_DEADBAND_TEMPERATURE
+#define REPORT_DEADBAND_TEMPERATURE 0.5f
+#endif
+#ifndef REPORT_DEADBAND_HUMIDITY
+#define REPORT_DEADBAND_HUMIDITY 2.0f
+#endif
+#ifndef REPORT_DEADBAND_DBM
+#define REPORT_DEADBAND_DBM 6.0f
+#endif
+
+// Velocidad de cambio (unidades por minuto entre dos lecturas seguidas) que fuerza el envio
+#ifndef REPORT_RATE_TEMPERATURE
+#define REPORT_RATE_TEMPERATURE 0.5f
+#endif
+#ifndef REPORT_RATE_HUMIDITY
+#define REPORT_RATE_HUMIDITY 3.0f
+#endif
+
+// Canales con politica propia: los cuatro de la lectura y la cobertura, en el orden de
+// PayloadField (CAMPO_TEMPERATURA_SONDA ... CAMPO_DBM)
+#define REPORT_CHANNELS 5
+
+/**
+ * @brief Configuracion, estado y contadores de un canal.
+ */
+struct ReportChannel {
+  // Configuracion (0 desactiva el criterio)
+  float deadBand;
+  float rate;
+  uint32_t heartbeat;
+
+  // Ultimo valor enviado y ultima lectura recibida
+  float sentValue;
+  uint32_t sentTime;
+  float lastValue;
+  uint32_t lastTime;
+  bool hasSent;
+  bool hasLast;
+
+  // Contadores: mensajes (o campos de un lote) enviados y suprimidos
+  uint32_t sent;
+  uint32_t suppressed;
+};
+
+/**
+ * @brief Politica de envio de todos los canales de un nodo.
+ */
+struct ReportPolicy {
+  ReportChannel channels[REPORT_CHANNELS];
+};
+
+/**
+ * @brief Inicializa la politica con los valores por defecto de cada canal.
+ *
+ * @param policy Politica a inicializar.
+ */
+void report_init(ReportPolicy* policy);
+
+/**
+ * @brief Cambia la configuracion de un canal.
+ *
+ * @param policy Politica del nodo.
+ * @param campo Canal (CAMPO_TEMPERATURA_SONDA ... CAMPO_DBM).
+ * @param deadBand Banda muerta en las unidades del canal (0 = enviar cualquier cambio).
+ * @param rate Velocidad de cambio por minuto que fuerza el envio (0 = desactivada).
+ * @param heartbeat Tiempo maximo (ms) sin enviar el canal.
+ */
+void report_configure(ReportPolicy* policy, PayloadField campo, float deadBand, float rate, uint32_t heartbeat);
+
+/**
+ * @brief Decide si se envia un valor de un canal y actualiza su estado y contadores.
+ *
+ * @param channel Canal.
+ * @param value Valor leido. NAN no se envia ni cuenta como suprimido.
+ * @param ahora Instante de la lectura en milisegundos.
+ * @return true si el valor se debe enviar.
+ */
+bool report_channel_due(ReportChannel* channel, float value, uint32_t ahora);
+
+/**
+ * @brief Nombre del canal, el mismo que usa el mensaje JSON.
+ */
+const char* report_channel_name(uint8_t campo);
+
+/**
+ * @brief Aplica la politica a una lectura: los canales que no se envian se marcan sin valor
+ * (NAN o SAMPLE_NO_HUMIDITY) para que el codificador los omita.
+ *
+ * @param policy Politica del nodo.
+ * @param lectura Lectura a filtrar; se modifica en el sitio.
+ * @return true si queda algun canal por enviar.
+ */
+bool report_filter(ReportPolicy* policy, SensorSample& lectura);
+
+#endif // REPORT_POLICY_H
@@ -0,0 +1,24 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stdint.h>
+
+// Valor de humidityCapacitor cuando el canal no tiene lectura (los demas canales usan NAN)
+#define SAMPLE_NO_HUMIDITY INT16_MIN
+
+/**
+ * @brief Lectura de todos los sensores de un nodo en un instante dado.
+ *
+ * Estructura de tamaño fijo, sin punteros, para poder copiarla a memoria RTC, a flash
+ * o entre tareas sin serializar. Los canales que un nodo no tiene se dejan a NAN.
+ */
+struct SensorSample {
+  // Instante de adquisicion en milisegundos, en la base de tiempo del nodo
+  uint32_t timestamp;
+  float temperatureProbe;
+  float temperatureDHT;
+  float humidityDHT;
+  int16_t humidityCapacitor;
+};
+
+#endif // SAMPLE_H
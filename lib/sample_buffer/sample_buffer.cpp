@@ -0,0 +1,49 @@
+#include "sample_buffer.h"
+
+// Marca de validez; incluye la capacidad para invalidar el buffer si cambia su tamaño
+static const uint32_t SAMPLE_BUFFER_MAGIC = 0x5342u << 16 | SAMPLE_BUFFER_CAPACITY;
+
+bool sample_buffer_restore(SampleBuffer* buffer) {
+  if (buffer->magic == SAMPLE_BUFFER_MAGIC && buffer->head < SAMPLE_BUFFER_CAPACITY &&
+      buffer->count <= SAMPLE_BUFFER_CAPACITY) {
+    return true;
+  }
+
+  buffer->magic = SAMPLE_BUFFER_MAGIC;
+  buffer->head = 0;
+  buffer->count = 0;
+  buffer->wakeups = 0;
+  buffer->elapsed = 0;
+  buffer->dropped = 0;
+  return false;
+}
+
+bool sample_buffer_push(SampleBuffer* buffer, const SensorSample& sample) {
+  uint16_t tail = (buffer->head + buffer->count) % SAMPLE_BUFFER_CAPACITY;
+  buffer->samples[tail] = sample;
+
+  if (buffer->count < SAMPLE_BUFFER_CAPACITY) {
+    buffer->count++;
+    return true;
+  }
+
+  // Buffer lleno: se sobrescribe la lectura mas antigua
+  buffer->head = (buffer->head + 1) % SAMPLE_BUFFER_CAPACITY;
+  buffer->dropped++;
+  return false;
+}
+
+const SensorSample* sample_buffer_at(const SampleBuffer* buffer, uint16_t index) {
+  if (index >= buffer->count) {
+    return nullptr;
+  }
+  return &buffer->samples[(buffer->head + index) % SAMPLE_BUFFER_CAPACITY];
+}
+
+void sample_buffer_consume(SampleBuffer* buffer, uint16_t n) {
+  if (n > buffer->count) {
+    n = buffer->count;
+  }
+  buffer->head = (buffer->head + n) % SAMPLE_BUFFER_CAPACITY;
+  buffer->count -= n;
+}
@@ -0,0 +1,66 @@
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <stdint.h>
+#include <sample.h>
+
+// Numero de lecturas que caben en el buffer circular
+#ifndef SAMPLE_BUFFER_CAPACITY
+#define SAMPLE_BUFFER_CAPACITY 32
+#endif
+
+/**
+ * @brief Buffer circular de lecturas pensado para vivir en memoria RTC.
+ *
+ * El contenido de la memoria RTC es aleatorio tras un arranque en frio, por lo que
+ * el buffer incluye una marca que permite detectar si los datos son validos.
+ */
+struct SampleBuffer {
+  uint32_t magic;
+  uint16_t head;
+  uint16_t count;
+  // Numero de despertares desde el ultimo arranque en frio
+  uint32_t wakeups;
+  // Tiempo acumulado (ms) desde el ultimo arranque en frio, incluido el tiempo dormido
+  uint32_t elapsed;
+  // Lecturas perdidas por desbordamiento del buffer
+  uint32_t dropped;
+  SensorSample samples[SAMPLE_BUFFER_CAPACITY];
+};
+
+/**
+ * @brief Valida el buffer tras un despertar. Si el contenido no es valido (arranque en
+ * frio) lo deja vacio.
+ *
+ * @param buffer Buffer a validar.
+ * @return true si se han conservado los datos de un ciclo anterior.
+ */
+bool sample_buffer_restore(SampleBuffer* buffer);
+
+/**
+ * @brief Añade una lectura al buffer. Si esta lleno se descarta la lectura mas antigua.
+ *
+ * @param buffer Buffer destino.
+ * @param sample Lectura a guardar.
+ * @return false si se ha tenido que descartar una lectura.
+ */
+bool sample_buffer_push(SampleBuffer* buffer, const SensorSample& sample);
+
+/**
+ * @brief Devuelve la lectura en la posicion indicada, contando desde la mas antigua.
+ *
+ * @param buffer Buffer origen.
+ * @param index Posicion (0 es la lectura mas antigua).
+ * @return Puntero a la lectura o nullptr si la posicion no existe.
+ */
+const SensorSample* sample_buffer_at(const SampleBuffer* buffer, uint16_t index);
+
+/**
+ * @brief Elimina las lecturas mas antiguas del buffer.
+ *
+ * @param buffer Buffer a modificar.
+ * @param n Numero de lecturas a eliminar.
+ */
+void sample_buffer_consume(SampleBuffer* buffer, uint16_t n);
+
+#endif // SAMPLE_BUFFER_H
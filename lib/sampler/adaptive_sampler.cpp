@@ -0,0 +1,113 @@
+#include "adaptive_sampler.h"
+#include <math.h>
+
+SamplerConfig sampler_default_config() {
+  SamplerConfig config;
+  config.minPeriod = SAMPLER_MIN_PERIOD;
+  config.maxPeriod = SAMPLER_MAX_PERIOD;
+  config.rateTemperature = SAMPLER_RATE_TEMPERATURE;
+  config.rateHumidity = SAMPLER_RATE_HUMIDITY;
+  return config;
+}
+
+bool sampler_config_valid(const SamplerConfig& config) {
+  return config.minPeriod >= SAMPLER_LIMIT_MIN && config.minPeriod <= config.maxPeriod &&
+         config.maxPeriod <= SAMPLER_LIMIT_MAX && config.rateTemperature > 0 && config.rateHumidity > 0;
+}
+
+static uint32_t clamp_period(const SamplerConfig& config, uint32_t period) {
+  if (period < config.minPeriod) {
+    return config.minPeriod;
+  }
+  return period > config.maxPeriod ? config.maxPeriod : period;
+}
+
+// Banda de ruido de cada canal en el orden de SAMPLER_CHANNELS
+static const float RUIDO[SAMPLER_CHANNELS] = {SAMPLER_NOISE_PROBE, SAMPLER_NOISE_DHT_TEMPERATURE, SAMPLER_NOISE_HUMIDITY,
+                                              SAMPLER_NOISE_HUMIDITY};
+
+static float channel_value(const SensorSample& lectura, uint8_t canal) {
+  switch (canal) {
+    case 0:
+      return lectura.temperatureProbe;
+    case 1:
+      return lectura.temperatureDHT;
+    case 2:
+      return lectura.humidityCapacitor == SAMPLE_NO_HUMIDITY ? NAN : lectura.humidityCapacitor;
+    default:
+      return lectura.humidityDHT;
+  }
+}
+
+void sampler_init(AdaptiveSampler* sampler, const SamplerConfig& config, uint32_t period, uint32_t ahora) {
+  sampler->config = config;
+  sampler->period = clamp_period(config, period);
+  sampler->stableReadings = 0;
+  for (uint8_t canal = 0; canal < SAMPLER_CHANNELS; canal++) {
+    sampler->reference[canal] = NAN;
+    sampler->referenceTime[canal] = 0;
+  }
+  sampler->samples = 0;
+  sampler->start = ahora;
+}
+
+bool sampler_configure(AdaptiveSampler* sampler, const SamplerConfig& config) {
+  uint32_t anterior = sampler->period;
+  sampler->config = config;
+  sampler->period = clamp_period(config, sampler->period);
+  sampler->stableReadings = 0;
+  return sampler->period != anterior;
+}
+
+bool sampler_update(AdaptiveSampler* sampler, const SensorSample& lectura) {
+  sampler->samples++;
+  const SamplerConfig& config = sampler->config;
+
+  // Velocidad del canal mas rapido respecto a su umbral (1 = justo en el umbral). Solo
+  // cuentan los canales que se han alejado de su referencia mas que la banda de ruido
+  float maximo = 0;
+  for (uint8_t canal = 0; canal < SAMPLER_CHANNELS; canal++) {
+    float valor = channel_value(lectura, canal);
+    if (isnan(valor)) {
+      continue;
+    }
+    float& referencia = sampler->reference[canal];
+    uint32_t& instante = sampler->referenceTime[canal];
+    if (isnan(referencia) || lectura.timestamp == instante) {
+      referencia = valor;
+      instante = lectura.timestamp;
+      continue;
+    }
+    float cambio = fabsf(valor - referencia);
+    if (cambio <= RUIDO[canal]) {
+      continue;
+    }
+    float umbral = canal < 2 ? config.rateTemperature : config.rateHumidity;
+    float relativa = cambio * 60000.0f / (uint32_t)(lectura.timestamp - instante) / umbral;
+    if (relativa > maximo) {
+      maximo = relativa;
+    }
+    referencia = valor;
+    instante = lectura.timestamp;
+  }
+
+  uint32_t periodo = sampler->period;
+  if (maximo >= 1.0f) {
+    // Cambio rapido: se reacciona enseguida
+    periodo /= 2;
+    sampler->stableReadings = 0;
+  } else if (maximo < SAMPLER_STABLE_FRACTION) {
+    // Señal estable: se alarga el periodo poco a poco
+    if (++sampler->stableReadings >= SAMPLER_STABLE_READINGS) {
+      periodo += periodo / 2;
+      sampler->stableReadings = 0;
+    }
+  } else {
+    sampler->stableReadings = 0;
+  }
+
+  periodo = clamp_period(config, periodo);
+  bool cambiado = periodo != sampler->period;
+  sampler->period = periodo;
+  return cambiado;
+}
@@ -0,0 +1,127 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <stdint.h>
+#include <sample.h>
+
+/*
+///////////////// MUESTREO ADAPTATIVO \\\\\\\\\\\\\\\\\
+*/
+// El periodo de muestreo sigue a la dinamica de la señal: si algun canal cambia mas rapido que
+// su umbral (riego, sol directo sobre el sensor) el periodo se reduce a la mitad; tras varias
+// lecturas estables seguidas crece un 50 %. Siempre dentro de [minPeriod, maxPeriod].
+// Los valores por defecto se pueden cambiar con build_flags o por MQTT (node_config).
+
+// Limites del periodo de muestreo en milisegundos
+#ifndef SAMPLER_MIN_PERIOD
+#define SAMPLER_MIN_PERIOD 10000UL
+#endif
+#ifndef SAMPLER_MAX_PERIOD
+#define SAMPLER_MAX_PERIOD 300000UL
+#endif
+
+// Limites absolutos de cualquier configuracion (1 s a 1 h)
+#define SAMPLER_LIMIT_MIN 1000UL
+#define SAMPLER_LIMIT_MAX 3600000UL
+
+// Velocidad de cambio (unidades por minuto) a partir de la cual se acelera el muestreo
+#ifndef SAMPLER_RATE_TEMPERATURE
+#define SAMPLER_RATE_TEMPERATURE 0.2f
+#endif
+#ifndef SAMPLER_RATE_HUMIDITY
+#define SAMPLER_RATE_HUMIDITY 1.0f
+#endif
+
+// Cambio minimo de cada canal para tenerlo en cuenta: por debajo se considera ruido o
+// cuantizacion del sensor (el DHT11 da grados y porcentajes enteros). Cada canal mide su
+// velocidad desde la ultima vez que supero esta banda, no entre lecturas consecutivas, para
+// que las derivas lentas se detecten aunque el periodo sea corto
+#ifndef SAMPLER_NOISE_PROBE
+#define SAMPLER_NOISE_PROBE 0.25f
+#endif
+#ifndef SAMPLER_NOISE_DHT_TEMPERATURE
+#define SAMPLER_NOISE_DHT_TEMPERATURE 1.0f
+#endif
+#ifndef SAMPLER_NOISE_HUMIDITY
+#define SAMPLER_NOISE_HUMIDITY 2.0f
+#endif
+
+// Canales de una lectura, en el orden de PayloadField (CAMPO_TEMPERATURA_SONDA ... CAMPO_HUMEDAD_DHT)
+#define SAMPLER_CHANNELS 4
+
+// Una lectura es estable si ningun canal supera esta fraccion de su umbral de velocidad
+#ifndef SAMPLER_STABLE_FRACTION
+#define SAMPLER_STABLE_FRACTION 0.25f
+#endif
+// Lecturas estables seguidas necesarias para alargar el periodo
+#ifndef SAMPLER_STABLE_READINGS
+#define SAMPLER_STABLE_READINGS 3
+#endif
+
+/**
+ * @brief Limites y umbrales del muestreo adaptativo.
+ */
+struct SamplerConfig {
+  uint32_t minPeriod;
+  uint32_t maxPeriod;
+  // unidades por minuto (°C/min y %/min)
+  float rateTemperature;
+  float rateHumidity;
+};
+
+/**
+ * @brief Estado del muestreo: periodo actual, referencia de cada canal y contadores.
+ */
+struct AdaptiveSampler {
+  SamplerConfig config;
+  uint32_t period;
+  uint8_t stableReadings;
+
+  // Valor e instante en que cada canal supero por ultima vez su banda de ruido (NAN sin valor)
+  float reference[SAMPLER_CHANNELS];
+  uint32_t referenceTime[SAMPLER_CHANNELS];
+
+  // Lecturas tomadas desde start, para calcular la frecuencia efectiva
+  uint32_t samples;
+  uint32_t start;
+};
+
+/**
+ * @brief Configuracion por defecto (SAMPLER_*).
+ */
+SamplerConfig sampler_default_config();
+
+/**
+ * @brief Comprueba que una configuracion es coherente: 1 s <= min <= max <= 1 h y umbrales
+ * positivos.
+ */
+bool sampler_config_valid(const SamplerConfig& config);
+
+/**
+ * @brief Inicializa el muestreo. El periodo inicial se ajusta a los limites.
+ *
+ * @param sampler Estado a inicializar.
+ * @param config Configuracion (valida).
+ * @param period Periodo inicial en milisegundos.
+ * @param ahora Instante actual en milisegundos.
+ */
+void sampler_init(AdaptiveSampler* sampler, const SamplerConfig& config, uint32_t period, uint32_t ahora);
+
+/**
+ * @brief Cambia la configuracion sin perder el historial; el periodo actual se ajusta a los
+ * nuevos limites.
+ *
+ * @return true si ha cambiado el periodo.
+ */
+bool sampler_configure(AdaptiveSampler* sampler, const SamplerConfig& config);
+
+/**
+ * @brief Registra una lectura y recalcula el periodo.
+ *
+ * @param sampler Estado del muestreo.
+ * @param lectura Lectura completa (timestamp en ms).
+ * @return true si ha cambiado el periodo.
+ */
+bool sampler_update(AdaptiveSampler* sampler, const SensorSample& lectura);
+
+#endif // ADAPTIVE_SAMPLER_H
@@ -0,0 +1,135 @@
+#include "scheduler.h"
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t taskCount = 0;
+static ClockSource clockSource = nullptr;
+
+// Peor retraso de una activacion respecto a su deadline y pasada mas larga del planificador.
+// El tiempo entre dos llamadas no sirve: incluye la espera intencionada de loop() sin tareas
+static unsigned long maxLatency = 0;
+static unsigned long maxPass = 0;
+static const Task* lastTask = nullptr;
+
+// Comparacion tolerante al desbordamiento de millis() (cada ~49 dias)
+static inline bool is_due(unsigned long now, unsigned long deadline) {
+  return (long)(now - deadline) >= 0;
+}
+
+void scheduler_init(ClockSource clock) {
+  clockSource = clock;
+  taskCount = 0;
+  maxLatency = 0;
+  maxPass = 0;
+  lastTask = nullptr;
+}
+
+Task* scheduler_add(const char* name, TaskCallback callback, unsigned long period, unsigned long budget, unsigned long offset) {
+  if (taskCount >= SCHEDULER_MAX_TASKS || clockSource == nullptr) {
+    return nullptr;
+  }
+
+  Task* task = &tasks[taskCount++];
+  task->name = name;
+  task->callback = callback;
+  task->period = period;
+  task->budget = budget;
+  task->nextRun = clockSource() + offset;
+  task->runs = 0;
+  task->overruns = 0;
+  task->maxJitter = 0;
+  task->maxDuration = 0;
+  task->lastJitter = 0;
+  task->lastDuration = 0;
+  return task;
+}
+
+void scheduler_set_period(Task* task, unsigned long period) {
+  if (task == nullptr) {
+    return;
+  }
+  task->period = period;
+  task->nextRun = clockSource() + period;
+}
+
+unsigned long scheduler_run() {
+  unsigned long now = clockSource();
+  unsigned long start = now;
+
+  // Selecciona la tarea vencida con el deadline mas antiguo
+  Task* due = nullptr;
+  lastTask = nullptr;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (is_due(now, tasks[i].nextRun) && (due == nullptr || (long)(tasks[i].nextRun - due->nextRun) < 0)) {
+      due = &tasks[i];
+    }
+  }
+
+  if (due != nullptr) {
+    unsigned long jitter = now - due->nextRun;
+    if (jitter > due->maxJitter) {
+      due->maxJitter = jitter;
+    }
+    due->lastJitter = jitter;
+    if (jitter > maxLatency) {
+      maxLatency = jitter;
+    }
+
+    due->callback();
+
+    unsigned long end = clockSource();
+    unsigned long duration = end - now;
+    if (duration > due->maxDuration) {
+      due->maxDuration = duration;
+    }
+    due->lastDuration = duration;
+    lastTask = due;
+    if (duration > due->budget) {
+      due->overruns++;
+    }
+    due->runs++;
+
+    // Mantiene la fase del periodo; si la tarea se ha quedado atras mas de un periodo
+    // se resincroniza en lugar de encadenar ejecuciones atrasadas
+    due->nextRun += due->period;
+    if (is_due(end, due->nextRun + due->period)) {
+      due->nextRun = end + due->period;
+    }
+    now = end;
+  }
+  if (now - start > maxPass) {
+    maxPass = now - start;
+  }
+
+  // Tiempo libre hasta el siguiente deadline
+  unsigned long idle = (unsigned long)-1;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (is_due(now, tasks[i].nextRun)) {
+      return 0;
+    }
+    unsigned long remaining = tasks[i].nextRun - now;
+    if (remaining < idle) {
+      idle = remaining;
+    }
+  }
+  return taskCount == 0 ? 0 : idle;
+}
+
+const Task* scheduler_last_run() {
+  return lastTask;
+}
+
+unsigned long scheduler_max_latency() {
+  return maxLatency;
+}
+
+unsigned long scheduler_max_pass() {
+  return maxPass;
+}
+
+const Task* scheduler_task(uint8_t index) {
+  return index < taskCount ? &tasks[index] : nullptr;
+}
+
+uint8_t scheduler_task_count() {
+  return taskCount;
+}
@@ -0,0 +1,116 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/*
+///////////////// PLANIFICADOR COOPERATIVO \\\\\\\\\\\\\\\\\
+*/
+// Numero maximo de tareas periodicas registradas. Los nodos registran hasta 8: se deja margen
+// para tareas nuevas sin que scheduler_add() se quede sin hueco
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 12
+#endif
+
+/**
+ * @brief Funcion que ejecuta el trabajo de una tarea. No debe bloquear.
+ */
+typedef void (*TaskCallback)();
+
+/**
+ * @brief Fuente de tiempo en milisegundos (millis() en la placa, reloj falso en el host).
+ */
+typedef unsigned long (*ClockSource)();
+
+/**
+ * @brief Tarea periodica con su periodo, presupuesto de tiempo y estadisticas de ejecucion.
+ */
+struct Task {
+  const char* name;
+  TaskCallback callback;
+  unsigned long period;
+  unsigned long budget;
+  unsigned long nextRun;
+
+  // estadisticas de ejecucion //
+  unsigned long runs;
+  unsigned long overruns;
+  unsigned long maxJitter;
+  unsigned long maxDuration;
+  // retraso y duracion de la ultima activacion
+  unsigned long lastJitter;
+  unsigned long lastDuration;
+};
+
+/**
+ * @brief Inicializa el planificador con la fuente de tiempo indicada.
+ *
+ * @param clock Funcion que devuelve el tiempo actual en milisegundos.
+ */
+void scheduler_init(ClockSource clock);
+
+/**
+ * @brief Registra una tarea periodica.
+ *
+ * @param name Nombre de la tarea (para trazas).
+ * @param callback Funcion que se ejecuta en cada activacion.
+ * @param period Periodo de activacion en milisegundos.
+ * @param budget Tiempo maximo de ejecucion esperado en milisegundos.
+ * @param offset Retardo de la primera activacion respecto al instante actual.
+ * @return Puntero a la tarea registrada o nullptr si no quedan huecos.
+ */
+Task* scheduler_add(const char* name, TaskCallback callback, unsigned long period, unsigned long budget, unsigned long offset = 0);
+
+/**
+ * @brief Modifica el periodo de una tarea. La siguiente activacion se recalcula desde ahora.
+ *
+ * @param task Tarea devuelta por scheduler_add(); si es nullptr (no se pudo registrar) no hace
+ * nada.
+ * @param period Nuevo periodo en milisegundos.
+ */
+void scheduler_set_period(Task* task, unsigned long period);
+
+/**
+ * @brief Ejecuta, como mucho, la tarea vencida con el deadline mas proximo (EDF).
+ *
+ * Se llama en cada iteracion de loop(). Ejecutar una sola tarea por pasada acota la
+ * latencia del bucle a la duracion de la tarea mas larga.
+ *
+ * @return Milisegundos hasta el siguiente deadline (0 si hay tareas pendientes).
+ */
+unsigned long scheduler_run();
+
+/**
+ * @brief Tarea ejecutada en la ultima llamada a scheduler_run(), para registrar su retraso y
+ * su duracion.
+ *
+ * @return Puntero a la tarea o nullptr si la ultima pasada no ejecuto ninguna.
+ */
+const Task* scheduler_last_run();
+
+/**
+ * @brief Retraso maximo con el que ha empezado una activacion respecto a su deadline, en
+ * todas las tareas (peor caso de maxJitter).
+ */
+unsigned long scheduler_max_latency();
+
+/**
+ * @brief Duracion maxima de una pasada de scheduler_run(), con la tarea que ejecuta. No
+ * incluye el tiempo que loop() duerme entre pasadas.
+ */
+unsigned long scheduler_max_pass();
+
+/**
+ * @brief Devuelve la tarea registrada en la posicion indicada (para informes).
+ *
+ * @param index Posicion de la tarea.
+ * @return Puntero a la tarea o nullptr si no existe.
+ */
+const Task* scheduler_task(uint8_t index);
+
+/**
+ * @brief Numero de tareas registradas.
+ */
+uint8_t scheduler_task_count();
+
+#endif // SCHEDULER_H
@@ -0,0 +1,153 @@
+#include "sensor_link.h"
+#include <math.h>
+#include <string.h>
+
+// Escritura little-endian byte a byte: el buffer no tiene por que estar alineado
+static uint8_t* put_uint32(uint8_t* out, uint32_t value) {
+  for (uint8_t i = 0; i < 4; i++) {
+    out[i] = value >> (8 * i);
+  }
+  return out + 4;
+}
+
+static uint32_t get_uint32(const uint8_t* in) {
+  return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static uint8_t* put_int16(uint8_t* out, int16_t value) {
+  out[0] = (uint16_t)value & 0xFF;
+  out[1] = (uint16_t)value >> 8;
+  return out + 2;
+}
+
+static int16_t get_int16(const uint8_t* in) {
+  return (int16_t)((uint16_t)in[0] | (uint16_t)in[1] << 8);
+}
+
+// Valor escalado y saturado al rango de int16, sin llegar a LINK_NO_VALUE
+static int16_t scaled(float value, float scale) {
+  if (isnan(value)) {
+    return LINK_NO_VALUE;
+  }
+  float rounded = roundf(value * scale);
+  return rounded > 32767.0f ? 32767 : rounded < -32767.0f ? -32767 : (int16_t)rounded;
+}
+
+static float unscaled(int16_t value, float scale) {
+  return value == LINK_NO_VALUE ? NAN : value / scale;
+}
+
+size_t link_frame_encode(const LinkFrame& frame, uint8_t* buffer, size_t size) {
+  if (size < LINK_FRAME_SIZE) {
+    return 0;
+  }
+  uint8_t* out = buffer;
+  *out++ = LINK_FRAME_V1;
+  *out++ = LINK_FRAME_SAMPLE;
+  *out++ = frame.attempt;
+  *out++ = 0;
+  out = put_uint32(out, frame.session);
+  out = put_uint32(out, frame.seq);
+  out = put_uint32(out, frame.age);
+  out = put_int16(out, scaled(frame.sample.temperatureProbe, 10.0f));
+  out = put_int16(out, scaled(frame.sample.temperatureDHT, 10.0f));
+  out = put_int16(out, frame.sample.humidityCapacitor == SAMPLE_NO_HUMIDITY ? LINK_NO_VALUE
+                                                                           : frame.sample.humidityCapacitor);
+  out = put_int16(out, scaled(frame.sample.humidityDHT, 10.0f));
+  // Nombre truncado y relleno con NUL: la trama siempre tiene el mismo tamaño
+  memset(out, 0, LINK_NODE_SIZE);
+  size_t nombre = strnlen(frame.node, LINK_NODE_SIZE - 1);
+  memcpy(out, frame.node, nombre);
+  return LINK_FRAME_SIZE;
+}
+
+bool link_frame_decode(const uint8_t* data, size_t len, LinkFrame* frame) {
+  if (len != LINK_FRAME_SIZE || data[0] != LINK_FRAME_V1 || data[1] != LINK_FRAME_SAMPLE) {
+    return false;
+  }
+  // El nombre es el prefijo de los topics: no puede estar vacio ni contener separadores
+  const char* nombre = (const char*)data + 24;
+  size_t n = strnlen(nombre, LINK_NODE_SIZE);
+  if (n == 0 || n == LINK_NODE_SIZE || memchr(nombre, '/', n) != nullptr || memchr(nombre, '+', n) != nullptr ||
+      memchr(nombre, '#', n) != nullptr) {
+    return false;
+  }
+
+  frame->attempt = data[2];
+  frame->session = get_uint32(data + 4);
+  frame->seq = get_uint32(data + 8);
+  frame->age = get_uint32(data + 12);
+  frame->sample.timestamp = 0;
+  frame->sample.temperatureProbe = unscaled(get_int16(data + 16), 10.0f);
+  frame->sample.temperatureDHT = unscaled(get_int16(data + 18), 10.0f);
+  int16_t capacitor = get_int16(data + 20);
+  frame->sample.humidityCapacitor = capacitor == LINK_NO_VALUE ? SAMPLE_NO_HUMIDITY : capacitor;
+  frame->sample.humidityDHT = unscaled(get_int16(data + 22), 10.0f);
+  memcpy(frame->node, nombre, n + 1);
+  return true;
+}
+
+void link_sender_init(LinkSender* sender, uint32_t session) {
+  memset(sender, 0, sizeof(*sender));
+  sender->session = session;
+}
+
+bool link_send(LinkTransport& transport, LinkSender* sender, const char* node, const SensorSample& lectura,
+               uint32_t ahora) {
+  LinkFrame frame;
+  frame.session = sender->session;
+  frame.seq = ++sender->seq;
+  frame.age = ahora - lectura.timestamp;
+  frame.sample = lectura;
+  strncpy(frame.node, node, LINK_NODE_SIZE - 1);
+  frame.node[LINK_NODE_SIZE - 1] = '\0';
+
+  // Si se pierde la confirmacion la trama ya puede haber llegado: el reintento lleva la misma
+  // secuencia y la pasarela lo descarta
+  uint8_t trama[LINK_FRAME_SIZE];
+  for (uint8_t intento = 0; intento < LINK_MAX_ATTEMPTS; intento++) {
+    frame.attempt = intento;
+    link_frame_encode(frame, trama, sizeof(trama));
+    if (intento > 0) {
+      sender->retries++;
+    }
+    if (transport.send(trama, sizeof(trama))) {
+      sender->delivered++;
+      return true;
+    }
+  }
+  sender->failures++;
+  return false;
+}
+
+void link_dedup_reset(LinkDedup* dedup) {
+  memset(dedup, 0, sizeof(*dedup));
+}
+
+LinkVerdict link_dedup_check(LinkDedup* dedup, uint32_t session, uint32_t seq) {
+  if (!dedup->valid || dedup->session != session) {
+    dedup->valid = true;
+    dedup->session = session;
+    dedup->top = seq;
+    dedup->window = 1;
+    return LINK_NEW;
+  }
+
+  // Diferencia con signo: sigue funcionando cuando la secuencia da la vuelta
+  int32_t adelanto = (int32_t)(seq - dedup->top);
+  if (adelanto > 0) {
+    dedup->window = adelanto >= LINK_DEDUP_WINDOW ? 1 : dedup->window << adelanto | 1;
+    dedup->top = seq;
+    return LINK_NEW;
+  }
+  uint32_t atraso = dedup->top - seq;
+  if (atraso >= LINK_DEDUP_WINDOW) {
+    return LINK_STALE;
+  }
+  uint32_t bit = 1UL << atraso;
+  if (dedup->window & bit) {
+    return LINK_DUPLICATE;
+  }
+  dedup->window |= bit;
+  return LINK_NEW;
+}
@@ -0,0 +1,180 @@
+#ifndef SENSOR_LINK_H
+#define SENSOR_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sample.h>
+
+/*
+///////////////// ENLACE DIRECTO NODO-PASARELA \\\\\\\\\\\\\\\\\
+*/
+// Un nodo hoja envia cada lectura a la pasarela en una trama de tamaño fijo, sin asociarse al
+// punto de acceso ni abrir una sesion MQTT. La pasarela publica las lecturas en nombre del
+// nodo. No depende de Arduino: el medio (ESP-NOW en el nodo) lo aporta LinkTransport.
+//
+// Trama (little-endian, LINK_FRAME_SIZE bytes):
+//
+// | bytes | campo             | tipo       |                                            |
+// |-------|-------------------|------------|--------------------------------------------|
+// | 0     | version           | uint8      | LINK_FRAME_V1                              |
+// | 1     | tipo              | uint8      | LINK_FRAME_SAMPLE                          |
+// | 2     | intento           | uint8      | 0 en el primer envio, 1.. en los reintentos |
+// | 3     | reservado         | uint8      | 0                                          |
+// | 4     | sesion            | uint32     | aleatoria en cada arranque en frio del nodo |
+// | 8     | secuencia         | uint32     | 1, 2, ... dentro de la sesion              |
+// | 12    | edad              | uint32     | ms desde la adquisicion hasta el envio     |
+// | 16    | temperatura_sonda | int16      | x10                                        |
+// | 18    | temperatura_dht   | int16      | x10                                        |
+// | 20    | humedad_capacitor | int16      | x1                                         |
+// | 22    | humedad_dht       | int16      | x10                                        |
+// | 24    | nodo              | char[16]   | prefijo de los topics, terminado en NUL    |
+//
+// Los canales sin lectura valen LINK_NO_VALUE. Un reintento repite la trama con la misma
+// secuencia: la pasarela descarta los duplicados con una ventana de LINK_DEDUP_WINDOW tramas.
+
+#define LINK_FRAME_V1 0xC1
+#define LINK_FRAME_SAMPLE 1
+#define LINK_FRAME_SIZE 40
+#define LINK_NODE_SIZE 16
+#define LINK_NO_VALUE INT16_MIN
+
+// Envios de una trama (el primero y los reintentos) antes de darla por no entregada
+#ifndef LINK_MAX_ATTEMPTS
+#define LINK_MAX_ATTEMPTS 3
+#endif
+
+// Tramas por detras de la mas reciente en las que aun se detectan duplicados
+#define LINK_DEDUP_WINDOW 32
+
+/**
+ * @brief Contenido de una trama de lectura.
+ */
+struct LinkFrame {
+  uint8_t attempt;
+  uint32_t session;
+  uint32_t seq;
+  // ms desde la adquisicion hasta el envio
+  uint32_t age;
+  // timestamp no viaja: el receptor lo deduce de la edad
+  SensorSample sample;
+  char node[LINK_NODE_SIZE];
+};
+
+/**
+ * @brief Trama recibida por el medio, con su origen y la intensidad de la señal.
+ */
+struct LinkPacket {
+  uint8_t mac[6];
+  int8_t rssi;
+  uint8_t len;
+  // Instante de la recepcion en ms, en la base de tiempo del receptor
+  uint32_t receivedAt;
+  uint8_t data[LINK_FRAME_SIZE];
+};
+
+/**
+ * @brief Medio entre el nodo y la pasarela. send() puede esperar (acotado) a la confirmacion
+ * de la capa de enlace; receive() nunca espera.
+ */
+class LinkTransport {
+public:
+  virtual ~LinkTransport() {}
+
+  /**
+   * @brief Envia una trama a la pasarela.
+   *
+   * @return true si el receptor ha confirmado la recepcion.
+   */
+  virtual bool send(const uint8_t* frame, size_t len) = 0;
+
+  /**
+   * @brief Extrae la trama recibida mas antigua.
+   *
+   * @return false si no hay ninguna.
+   */
+  virtual bool receive(LinkPacket& packet) = 0;
+};
+
+/**
+ * @brief Estado del emisor de un nodo: sesion y ultima secuencia. Tamaño fijo, sin punteros,
+ * para poder conservarlo en memoria RTC entre despertares.
+ */
+struct LinkSender {
+  uint32_t session;
+  uint32_t seq;
+  // tramas confirmadas, reintentos y tramas no entregadas tras LINK_MAX_ATTEMPTS envios
+  uint32_t delivered;
+  uint32_t retries;
+  uint32_t failures;
+};
+
+/**
+ * @brief Ventana de secuencias ya recibidas de un emisor.
+ */
+struct LinkDedup {
+  uint32_t session;
+  // secuencia mas alta recibida y mapa de bits de las LINK_DEDUP_WINDOW anteriores (bit 0: top)
+  uint32_t top;
+  uint32_t window;
+  bool valid;
+};
+
+/**
+ * @brief Veredicto sobre una trama recibida.
+ */
+enum LinkVerdict {
+  LINK_NEW = 0,
+  LINK_DUPLICATE = 1,
+  // mas antigua que la ventana: no se puede saber si es un duplicado y se descarta
+  LINK_STALE = 2,
+};
+
+/**
+ * @brief Codifica una trama.
+ *
+ * @return LINK_FRAME_SIZE, o 0 si no cabe en el buffer.
+ */
+size_t link_frame_encode(const LinkFrame& frame, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Decodifica una trama.
+ *
+ * @param frame Trama decodificada; sample.timestamp queda a 0.
+ * @return false si la longitud, la version, el tipo o el nombre del nodo no son validos.
+ */
+bool link_frame_decode(const uint8_t* data, size_t len, LinkFrame* frame);
+
+/**
+ * @brief Inicia el emisor tras un arranque en frio.
+ *
+ * @param session Identificador aleatorio de la sesion: distingue las secuencias de este
+ * arranque de las de uno anterior.
+ */
+void link_sender_init(LinkSender* sender, uint32_t session);
+
+/**
+ * @brief Envia una lectura con la siguiente secuencia, reintentando hasta LINK_MAX_ATTEMPTS
+ * veces si el receptor no la confirma.
+ *
+ * @param transport Medio hasta la pasarela.
+ * @param sender Estado del emisor.
+ * @param node Nombre del nodo (prefijo de sus topics, menos de LINK_NODE_SIZE caracteres).
+ * @param lectura Lectura a enviar.
+ * @param ahora Instante actual en la base de tiempo de lectura.timestamp.
+ * @return true si la lectura se ha entregado.
+ */
+bool link_send(LinkTransport& transport, LinkSender* sender, const char* node, const SensorSample& lectura,
+               uint32_t ahora);
+
+/**
+ * @brief Olvida todas las secuencias recibidas.
+ */
+void link_dedup_reset(LinkDedup* dedup);
+
+/**
+ * @brief Decide si una trama es nueva y la anota en la ventana. Una sesion distinta de la
+ * anotada (el emisor ha arrancado en frio) reinicia la ventana.
+ */
+LinkVerdict link_dedup_check(LinkDedup* dedup, uint32_t session, uint32_t seq);
+
+#endif // SENSOR_LINK_H
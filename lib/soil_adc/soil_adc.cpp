@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include "soil_adc.h"
+
+uint16_t soil_adc_sample(uint8_t pin) {
+  // Conversiones consecutivas: cada una dura unas decenas de microsegundos
+  uint16_t samples[SOIL_ADC_BURST];
+  for (uint8_t i = 0; i < SOIL_ADC_BURST; i++) {
+    samples[i] = analogRead(pin);
+  }
+  return soil_filter(samples, SOIL_ADC_BURST, SOIL_ADC_FILTER, SOIL_ADC_TRIM);
+}
+
+bool soil_calibration_load(fs::FS& fs, const char* path, SoilCalibration& calibration) {
+  if (!fs.exists(path)) {
+    return false;
+  }
+  File file = fs.open(path, "r");
+  if (!file) {
+    return false;
+  }
+
+  uint8_t data[1 + 4 * SOIL_CAL_MAX_POINTS];
+  size_t len = file.read(data, sizeof(data));
+  file.close();
+  if (len < 1 || data[0] > SOIL_CAL_MAX_POINTS || len != 1u + 4u * data[0]) {
+    return false;
+  }
+
+  SoilCalibration loaded;
+  loaded.count = data[0];
+  for (uint8_t i = 0; i < loaded.count; i++) {
+    const uint8_t* point = data + 1 + 4 * i;
+    loaded.raw[i] = point[0] | point[1] << 8;
+    loaded.humidity[i] = (int16_t)(point[2] | point[3] << 8);
+  }
+  if (!soil_calibration_valid(loaded)) {
+    return false;
+  }
+  calibration = loaded;
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef SOIL_ADC_H
+#define SOIL_ADC_H
+
+#include <FS.h>
+#include "soil_filter.h"
+
+/*
+///////////////// ADQUISICION DEL SENSOR CAPACITIVO \\\\\\\\\\\\\\\\\
+*/
+// Numero de conversiones por lectura
+#ifndef SOIL_ADC_BURST
+#define SOIL_ADC_BURST 16
+#endif
+
+// Filtro aplicado a la rafaga (SOIL_FILTER_MEDIAN o SOIL_FILTER_TRIMMED_MEAN)
+#ifndef SOIL_ADC_FILTER
+#define SOIL_ADC_FILTER SOIL_FILTER_TRIMMED_MEAN
+#endif
+
+// Muestras descartadas por cada extremo en la media recortada
+#ifndef SOIL_ADC_TRIM
+#define SOIL_ADC_TRIM 4
+#endif
+
+/**
+ * @brief Toma una rafaga de SOIL_ADC_BURST conversiones y devuelve el valor filtrado.
+ *
+ * @param pin Pin analogico del sensor.
+ * @return Lectura filtrada del ADC.
+ */
+uint16_t soil_adc_sample(uint8_t pin);
+
+/**
+ * @brief Carga la tabla de calibracion propia del dispositivo desde el sistema de ficheros.
+ * Si el fichero no existe o no es valido, la tabla no se modifica.
+ *
+ * Formato del fichero: numero de puntos (uint8) seguido de los pares lectura (uint16) y
+ * humedad en centesimas de % (int16), en little-endian.
+ *
+ * @param fs Sistema de ficheros (ya montado).
+ * @param path Ruta del fichero de calibracion.
+ * @param calibration Tabla a sustituir.
+ * @return true si se ha cargado la tabla del fichero.
+ */
+bool soil_calibration_load(fs::FS& fs, const char* path, SoilCalibration& calibration);
+
+#endif // SOIL_ADC_H
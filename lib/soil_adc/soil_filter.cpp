@@ -0,0 +1,66 @@
+#include "soil_filter.h"
+
+uint16_t soil_filter(uint16_t* samples, uint8_t n, uint8_t filter, uint8_t trim) {
+  if (n == 0) {
+    return 0;
+  }
+
+  // Ordenacion por insercion: rapida para rafagas cortas y sin memoria adicional
+  for (uint8_t i = 1; i < n; i++) {
+    uint16_t value = samples[i];
+    uint8_t j = i;
+    while (j > 0 && samples[j - 1] > value) {
+      samples[j] = samples[j - 1];
+      j--;
+    }
+    samples[j] = value;
+  }
+
+  if (filter == SOIL_FILTER_MEDIAN || 2 * trim >= n) {
+    return n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2] + 1) / 2;
+  }
+
+  // Media recortada: descarta trim muestras por cada extremo
+  uint32_t sum = 0;
+  for (uint8_t i = trim; i < n - trim; i++) {
+    sum += samples[i];
+  }
+  uint8_t count = n - 2 * trim;
+  return (sum + count / 2) / count;
+}
+
+int16_t soil_calibrate(const SoilCalibration& calibration, uint16_t raw) {
+  if (calibration.count == 0) {
+    return 0;
+  }
+  if (raw <= calibration.raw[0]) {
+    return calibration.humidity[0];
+  }
+  uint8_t last = calibration.count - 1;
+  if (raw >= calibration.raw[last]) {
+    return calibration.humidity[last];
+  }
+
+  // Tramo que contiene la lectura e interpolacion entera con redondeo
+  uint8_t i = 1;
+  while (raw > calibration.raw[i]) {
+    i++;
+  }
+  int32_t dx = calibration.raw[i] - calibration.raw[i - 1];
+  int32_t dy = calibration.humidity[i] - calibration.humidity[i - 1];
+  int32_t offset = (int32_t)(raw - calibration.raw[i - 1]) * dy;
+  offset += offset >= 0 ? dx / 2 : -dx / 2;
+  return calibration.humidity[i - 1] + offset / dx;
+}
+
+bool soil_calibration_valid(const SoilCalibration& calibration) {
+  if (calibration.count < 2 || calibration.count > SOIL_CAL_MAX_POINTS) {
+    return false;
+  }
+  for (uint8_t i = 1; i < calibration.count; i++) {
+    if (calibration.raw[i] <= calibration.raw[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef SOIL_FILTER_H
+#define SOIL_FILTER_H
+
+#include <stdint.h>
+
+/*
+///////////////// FILTRADO Y CALIBRACION DEL SENSOR CAPACITIVO \\\\\\\\\\\\\\\\\
+*/
+#define SOIL_FILTER_MEDIAN 0
+#define SOIL_FILTER_TRIMMED_MEAN 1
+
+// Numero maximo de puntos de la tabla de calibracion
+#define SOIL_CAL_MAX_POINTS 8
+
+/**
+ * @brief Tabla de calibracion lineal a tramos: lectura del ADC -> humedad en centesimas de %.
+ *
+ * Los puntos deben estar ordenados por lectura del ADC creciente. Fuera de la tabla se
+ * satura al valor del extremo, por lo que el resultado nunca sale del rango de la tabla.
+ */
+struct SoilCalibration {
+  uint8_t count;
+  uint16_t raw[SOIL_CAL_MAX_POINTS];
+  int16_t humidity[SOIL_CAL_MAX_POINTS];
+};
+
+/**
+ * @brief Reduce una rafaga de lecturas del ADC a un unico valor descartando los atipicos.
+ * Ordena las muestras en el propio buffer.
+ *
+ * @param samples Lecturas del ADC (se reordenan).
+ * @param n Numero de lecturas.
+ * @param filter SOIL_FILTER_MEDIAN o SOIL_FILTER_TRIMMED_MEAN.
+ * @param trim Muestras descartadas por cada extremo en la media recortada.
+ * @return Valor filtrado.
+ */
+uint16_t soil_filter(uint16_t* samples, uint8_t n, uint8_t filter, uint8_t trim);
+
+/**
+ * @brief Convierte una lectura del ADC en humedad mediante interpolacion lineal en punto fijo.
+ *
+ * @param calibration Tabla de calibracion del dispositivo.
+ * @param raw Lectura filtrada del ADC.
+ * @return Humedad en centesimas de % (0-10000 con una tabla dentro de ese rango).
+ */
+int16_t soil_calibrate(const SoilCalibration& calibration, uint16_t raw);
+
+/**
+ * @brief Comprueba que una tabla de calibracion es utilizable (puntos ordenados y sin repetir).
+ */
+bool soil_calibration_valid(const SoilCalibration& calibration);
+
+#endif // SOIL_FILTER_H
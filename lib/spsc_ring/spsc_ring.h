@@ -0,0 +1,107 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+///////////////// COLA SIN CERROJOS DE UN PRODUCTOR Y UN CONSUMIDOR \\\\\\\\\\\\\\\\\
+*/
+// Alineacion de los indices: cada uno en su propia linea de cache para que el productor y
+// el consumidor no se invaliden mutuamente
+#ifndef SPSC_RING_ALIGN
+#define SPSC_RING_ALIGN 64
+#endif
+
+/**
+ * @brief Cola circular de registros de tamaño fijo entre exactamente dos tareas: una que
+ * escribe (push) y otra que lee (pop), que pueden estar en nucleos distintos.
+ *
+ * Los indices crecen sin limite y se reducen con una mascara, por lo que la capacidad debe
+ * ser potencia de dos y no hace falta dejar un hueco libre para distinguir llena de vacia.
+ * Si la cola esta llena push() no sobrescribe nada: el registro se descarta y se cuenta.
+ *
+ * @tparam T Registro (copiable, sin punteros a memoria del productor).
+ * @tparam N Capacidad en registros, potencia de dos.
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "La capacidad de SpscRing debe ser potencia de dos");
+
+public:
+  SpscRing() : head(0), tail(0), dropped(0), highWater(0) {}
+
+  /**
+   * @brief Añade un registro. Solo la llama el productor.
+   *
+   * @return false si la cola esta llena (el registro se descarta y se cuenta en overflows()).
+   */
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t ocupados = h - tail.load(std::memory_order_acquire);
+    if (ocupados >= N) {
+      dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    // El registro queda visible para el consumidor antes que el nuevo indice
+    head.store(h + 1, std::memory_order_release);
+    if (ocupados + 1 > highWater.load(std::memory_order_relaxed)) {
+      highWater.store(ocupados + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Extrae el registro mas antiguo. Solo la llama el consumidor.
+   *
+   * @return false si la cola esta vacia.
+   */
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) {
+      return false;
+    }
+    item = items[t & (N - 1)];
+    // El hueco se libera despues de copiar el registro
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Registros pendientes. Exacto desde el productor o el consumidor; desde otra tarea
+   * es solo una estimacion.
+   */
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  bool full() const { return size() >= N; }
+
+  bool empty() const { return size() == 0; }
+
+  static constexpr size_t capacity() { return N; }
+
+  /**
+   * @brief Registros descartados por encontrar la cola llena.
+   */
+  uint32_t overflows() const { return dropped.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Maximo de registros pendientes observado.
+   */
+  uint32_t high_water() const { return highWater.load(std::memory_order_relaxed); }
+
+private:
+  // Escrito solo por el productor
+  alignas(SPSC_RING_ALIGN) std::atomic<uint32_t> head;
+  // Escrito solo por el consumidor
+  alignas(SPSC_RING_ALIGN) std::atomic<uint32_t> tail;
+  // Estadisticas, escritas solo por el productor
+  alignas(SPSC_RING_ALIGN) std::atomic<uint32_t> dropped;
+  std::atomic<uint32_t> highWater;
+  T items[N];
+};
+
+#endif // SPSC_RING_H
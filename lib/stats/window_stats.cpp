@@ -0,0 +1,68 @@
+#include "window_stats.h"
+#include <math.h>
+
+void running_reset(RunningStats* stats) {
+  stats->count = 0;
+  stats->min = NAN;
+  stats->max = NAN;
+  stats->mean = 0;
+  stats->m2 = 0;
+}
+
+void running_add(RunningStats* stats, float value) {
+  if (isnan(value) || stats->count == UINT16_MAX) {
+    return;
+  }
+  if (stats->count == 0) {
+    stats->min = value;
+    stats->max = value;
+  } else {
+    stats->min = value < stats->min ? value : stats->min;
+    stats->max = value > stats->max ? value : stats->max;
+  }
+
+  // Welford: se actualiza la media y se acumula el producto de las desviaciones respecto a
+  // la media anterior y a la nueva
+  stats->count++;
+  float delta = value - stats->mean;
+  stats->mean += delta / stats->count;
+  stats->m2 += delta * (value - stats->mean);
+}
+
+float running_variance(const RunningStats& stats) {
+  if (stats.count < 2) {
+    return 0;
+  }
+  // El redondeo puede dejar m2 ligeramente negativo con valores constantes
+  return stats.m2 > 0 ? stats.m2 / (stats.count - 1) : 0;
+}
+
+float running_stddev(const RunningStats& stats) {
+  return sqrtf(running_variance(stats));
+}
+
+void stats_reset(WindowStats* window, uint32_t now) {
+  for (uint8_t canal = 0; canal < STATS_CHANNELS; canal++) {
+    running_reset(&window->channels[canal]);
+  }
+  window->start = now;
+}
+
+void stats_add(WindowStats* window, const SensorSample& lectura) {
+  // Mismo orden que PayloadField
+  running_add(&window->channels[0], lectura.temperatureProbe);
+  running_add(&window->channels[1], lectura.temperatureDHT);
+  if (lectura.humidityCapacitor != SAMPLE_NO_HUMIDITY) {
+    running_add(&window->channels[2], lectura.humidityCapacitor);
+  }
+  running_add(&window->channels[3], lectura.humidityDHT);
+}
+
+bool stats_has_data(const WindowStats* window) {
+  for (uint8_t canal = 0; canal < STATS_CHANNELS; canal++) {
+    if (window->channels[canal].count > 0) {
+      return true;
+    }
+  }
+  return false;
+}
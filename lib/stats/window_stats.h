@@ -0,0 +1,82 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include <sample.h>
+
+/*
+///////////////// ESTADISTICAS POR VENTANA \\\\\\\\\\\\\\\\\
+*/
+// En lugar de cada lectura se publica un resumen por ventana fija (tumbling) con el numero de
+// lecturas, minimo, maximo, media y desviacion tipica de cada canal. La media y la varianza se
+// acumulan con el algoritmo de Welford: memoria constante por canal y sin la cancelacion de
+// la formula de la suma de cuadrados.
+
+// Duracion de cada ventana en milisegundos
+#ifndef STATS_WINDOW
+#define STATS_WINDOW 300000UL
+#endif
+
+// Canales de una lectura, en el orden de PayloadField (CAMPO_TEMPERATURA_SONDA ... CAMPO_HUMEDAD_DHT)
+#define STATS_CHANNELS 4
+
+/**
+ * @brief Estadisticos acumulados de un canal.
+ */
+struct RunningStats {
+  uint16_t count;
+  float min;
+  float max;
+  float mean;
+  // Suma de los cuadrados de las desviaciones respecto a la media
+  float m2;
+};
+
+/**
+ * @brief Ventana en curso: estadisticos de cada canal e instante de inicio.
+ */
+struct WindowStats {
+  RunningStats channels[STATS_CHANNELS];
+  uint32_t start;
+};
+
+/**
+ * @brief Vacia los estadisticos de un canal.
+ */
+void running_reset(RunningStats* stats);
+
+/**
+ * @brief Añade un valor a los estadisticos de un canal. Los valores NAN se ignoran.
+ */
+void running_add(RunningStats* stats, float value);
+
+/**
+ * @brief Varianza muestral (n - 1) del canal, o 0 con menos de dos valores.
+ */
+float running_variance(const RunningStats& stats);
+
+/**
+ * @brief Desviacion tipica muestral del canal.
+ */
+float running_stddev(const RunningStats& stats);
+
+/**
+ * @brief Empieza una ventana nueva, vacia.
+ *
+ * @param window Ventana a reiniciar.
+ * @param now Instante de inicio en la base de tiempo del nodo.
+ */
+void stats_reset(WindowStats* window, uint32_t now);
+
+/**
+ * @brief Añade una lectura a la ventana. Los canales sin valor (NAN o SAMPLE_NO_HUMIDITY)
+ * no cuentan.
+ */
+void stats_add(WindowStats* window, const SensorSample& lectura);
+
+/**
+ * @brief Indica si algun canal de la ventana tiene lecturas.
+ */
+bool stats_has_data(const WindowStats* window);
+
+#endif // WINDOW_STATS_H
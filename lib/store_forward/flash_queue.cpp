@@ -0,0 +1,363 @@
+#include "flash_queue.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint16_t RECORD_MAGIC = 0x5146;
+static const uint32_t META_MAGIC = 0x51464d31;
+// El registro esta fechado: timestamp es la hora UTC en segundos
+static const uint8_t RECORD_DATED = 0x01;
+
+// Cabecera de cada registro en flash, seguida del topic y del payload
+struct RecordHeader {
+  uint16_t magic;
+  uint8_t topicLen;
+  uint8_t flags;
+  uint16_t payloadLen;
+  uint16_t boot;
+  uint32_t timestamp;
+  uint32_t crc;
+};
+
+// Punteros de lectura persistidos (dos copias alternas)
+struct QueueMeta {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t headSegment;
+  uint32_t headOffset;
+  uint16_t boot;
+  uint16_t reserved;
+  uint32_t crc;
+};
+
+static const size_t MAX_RECORD = sizeof(RecordHeader) + FLASH_QUEUE_MAX_TOPIC + FLASH_QUEUE_MAX_PAYLOAD;
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+// Lee y valida un registro completo; devuelve su longitud o 0 si no es valido
+static size_t read_record(QueueStorage& storage, const char* path, uint32_t offset, uint8_t* record) {
+  RecordHeader header;
+  if (storage.read(path, offset, (uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != RECORD_MAGIC || header.topicLen > FLASH_QUEUE_MAX_TOPIC ||
+      header.payloadLen > FLASH_QUEUE_MAX_PAYLOAD) {
+    return 0;
+  }
+
+  size_t length = sizeof(header) + header.topicLen + header.payloadLen;
+  if (storage.read(path, offset, record, length) != length) {
+    return 0;
+  }
+
+  uint32_t crc = header.crc;
+  ((RecordHeader*)record)->crc = 0;
+  if (crc32(0, record, length) != crc) {
+    return 0;
+  }
+  ((RecordHeader*)record)->crc = crc;
+  return length;
+}
+
+FlashQueue::FlashQueue(QueueStorage& storage, const char* dir)
+    : storage(storage), dir(dir), headSegment(0), headOffset(0), tailSegment(0), tailSize(0), readSegment(0),
+      readOffset(0), boot(0), metaSeq(0), records(0), outstanding(0), droppedRecords(0), pendingAcks(0),
+      peekedLength(0) {}
+
+void FlashQueue::segment_path(uint32_t segment, char* path) const {
+  snprintf(path, 24, "%s/%lu", dir, (unsigned long)segment);
+}
+
+size_t FlashQueue::read_entry(uint32_t segment, uint32_t offset, uint8_t* record) {
+  char path[24];
+  segment_path(segment, path);
+  return read_record(storage, path, offset, record);
+}
+
+bool FlashQueue::load_meta() {
+  char path[24];
+  bool found = false;
+
+  // Se queda con la copia valida de mayor numero de secuencia
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    snprintf(path, sizeof(path), "%s/meta%u", dir, slot);
+    QueueMeta meta;
+    if (storage.read(path, 0, (uint8_t*)&meta, sizeof(meta)) != sizeof(meta) || meta.magic != META_MAGIC) {
+      continue;
+    }
+    uint32_t crc = meta.crc;
+    meta.crc = 0;
+    if (crc32(0, (const uint8_t*)&meta, sizeof(meta)) != crc) {
+      continue;
+    }
+    if (!found || (int32_t)(meta.seq - metaSeq) > 0) {
+      metaSeq = meta.seq;
+      headSegment = meta.headSegment;
+      headOffset = meta.headOffset;
+      boot = meta.boot;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void FlashQueue::commit() {
+  QueueMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  meta.magic = META_MAGIC;
+  meta.seq = ++metaSeq;
+  meta.headSegment = headSegment;
+  meta.headOffset = headOffset;
+  meta.boot = boot;
+  meta.crc = crc32(0, (const uint8_t*)&meta, sizeof(meta));
+
+  // Alterna la copia: si se corta la alimentacion queda la anterior intacta
+  char path[24];
+  snprintf(path, sizeof(path), "%s/meta%u", dir, (unsigned)(meta.seq & 1));
+  storage.write(path, (const uint8_t*)&meta, sizeof(meta));
+  pendingAcks = 0;
+}
+
+uint32_t FlashQueue::scan_segment(uint32_t segment, uint32_t offset, bool* torn) {
+  char path[24];
+  segment_path(segment, path);
+  long length = storage.size(path);
+  uint8_t record[MAX_RECORD];
+  uint32_t count = 0;
+
+  while (length >= 0 && offset < (uint32_t)length) {
+    size_t recordLength = read_record(storage, path, offset, record);
+    if (recordLength == 0) {
+      break;
+    }
+    offset += recordLength;
+    count++;
+  }
+  if (torn != nullptr) {
+    *torn = length >= 0 && offset < (uint32_t)length;
+  }
+  return count;
+}
+
+void FlashQueue::begin() {
+  if (!load_meta()) {
+    headSegment = 0;
+    headOffset = 0;
+    boot = 0;
+  }
+  boot++;
+
+  // Segmentos ya consumidos que no llegaron a borrarse: los punteros se guardan antes de
+  // borrar, asi que un corte entre las dos cosas solo deja segmentos sobrantes
+  char path[24];
+  for (uint32_t segment = headSegment; segment > 0 && headSegment - segment < FLASH_QUEUE_MAX_SEGMENTS; segment--) {
+    segment_path(segment - 1, path);
+    if (storage.size(path) >= 0) {
+      storage.remove(path);
+    }
+  }
+
+  // Localiza el ultimo segmento existente y cuenta los registros pendientes. Se salta los que
+  // falten (un append que no llego a crear el fichero) en vez de parar en el primero
+  records = 0;
+  tailSegment = headSegment;
+  tailSize = 0;
+  bool torn = false;
+  for (uint32_t segment = headSegment; segment < headSegment + FLASH_QUEUE_MAX_SEGMENTS; segment++) {
+    segment_path(segment, path);
+    long length = storage.size(path);
+    if (length < 0) {
+      continue;
+    }
+    records += scan_segment(segment, segment == headSegment ? headOffset : 0, &torn);
+    tailSegment = segment;
+    tailSize = length;
+  }
+
+  // Si la ultima escritura quedo a medias se continua en un segmento nuevo: el lector
+  // descarta el resto del segmento dañado al llegar a el
+  if (torn) {
+    tailSegment++;
+    tailSize = 0;
+  }
+  readSegment = headSegment;
+  readOffset = headOffset;
+  outstanding = 0;
+  peekedLength = 0;
+  commit();
+}
+
+void FlashQueue::drop_oldest_segment() {
+  uint32_t lost = scan_segment(headSegment, headOffset, nullptr);
+  droppedRecords += lost;
+  records -= lost;
+  // Los registros entregados que quedaban en el segmento se pierden con el
+  outstanding -= lost < outstanding ? lost : outstanding;
+  uint32_t first = headSegment;
+  advance_segment();
+  commit();
+  remove_segments(first);
+}
+
+void FlashQueue::advance_segment() {
+  headSegment++;
+  headOffset = 0;
+  if (readSegment < headSegment) {
+    readSegment = headSegment;
+    readOffset = 0;
+    peekedLength = 0;
+  }
+}
+
+void FlashQueue::remove_segments(uint32_t first) {
+  char path[24];
+  for (uint32_t segment = first; segment < headSegment; segment++) {
+    segment_path(segment, path);
+    storage.remove(path);
+  }
+}
+
+bool FlashQueue::push(const char* topic, const uint8_t* payload, size_t len, uint32_t timestamp, uint32_t epoch) {
+  size_t topicLen = strlen(topic);
+  if (topicLen > FLASH_QUEUE_MAX_TOPIC || len > FLASH_QUEUE_MAX_PAYLOAD) {
+    return false;
+  }
+
+  uint8_t record[MAX_RECORD];
+  size_t length = sizeof(RecordHeader) + topicLen + len;
+  RecordHeader* header = (RecordHeader*)record;
+  header->magic = RECORD_MAGIC;
+  header->topicLen = topicLen;
+  header->flags = epoch > 0 ? RECORD_DATED : 0;
+  header->payloadLen = len;
+  header->boot = boot;
+  header->timestamp = epoch > 0 ? epoch : timestamp;
+  header->crc = 0;
+  memcpy(record + sizeof(RecordHeader), topic, topicLen);
+  memcpy(record + sizeof(RecordHeader) + topicLen, payload, len);
+  header->crc = crc32(0, record, length);
+
+  // Rota al siguiente segmento cuando el actual esta lleno
+  if (tailSize + length > FLASH_QUEUE_SEGMENT_SIZE) {
+    tailSegment++;
+    tailSize = 0;
+  }
+  // Limite de espacio: se descartan los datos mas antiguos
+  while (tailSegment - headSegment >= FLASH_QUEUE_MAX_SEGMENTS) {
+    drop_oldest_segment();
+  }
+
+  char path[24];
+  segment_path(tailSegment, path);
+  if (!storage.append(path, record, length)) {
+    // Escritura parcial: el segmento queda sellado y se continua en uno nuevo
+    tailSegment++;
+    tailSize = 0;
+    return false;
+  }
+  tailSize += length;
+  records++;
+  return true;
+}
+
+bool FlashQueue::peek(QueueEntry& entry) {
+  uint8_t record[MAX_RECORD];
+
+  while (records > outstanding) {
+    size_t length = read_entry(readSegment, readOffset, record);
+    if (length > 0) {
+      const RecordHeader* header = (const RecordHeader*)record;
+      bool fechado = header->flags & RECORD_DATED;
+      entry.timestamp = fechado ? 0 : header->timestamp;
+      entry.epoch = fechado ? header->timestamp : 0;
+      entry.sameBoot = header->boot == boot;
+      memcpy(entry.topic, record + sizeof(RecordHeader), header->topicLen);
+      entry.topic[header->topicLen] = '\0';
+      memcpy(entry.payload, record + sizeof(RecordHeader) + header->topicLen, header->payloadLen);
+      entry.payloadLen = header->payloadLen;
+      peekedLength = length;
+      return true;
+    }
+
+    // Fin del segmento o registro dañado: se pasa al siguiente
+    if (readSegment == tailSegment) {
+      // El resto del ultimo segmento no es valido: los registros nuevos van a otro
+      records = outstanding;
+      tailSegment++;
+      tailSize = 0;
+      break;
+    }
+    readSegment++;
+    readOffset = 0;
+  }
+  return false;
+}
+
+void FlashQueue::next() {
+  if (peekedLength == 0) {
+    return;
+  }
+  readOffset += peekedLength;
+  peekedLength = 0;
+  outstanding++;
+}
+
+void FlashQueue::pop() {
+  uint8_t record[MAX_RECORD];
+  size_t length = 0;
+  while (outstanding > 0) {
+    length = read_entry(headSegment, headOffset, record);
+    if (length > 0) {
+      break;
+    }
+    // Fin del segmento o registro dañado, que la lectura ya ha saltado
+    if (headSegment == readSegment) {
+      outstanding = 0;
+      return;
+    }
+    uint32_t first = headSegment;
+    advance_segment();
+    commit();
+    remove_segments(first);
+  }
+  if (length == 0) {
+    return;
+  }
+  headOffset += length;
+  outstanding--;
+  records--;
+  pendingAcks++;
+
+  // Cola vacia: se liberan los segmentos consumidos y se empieza uno nuevo
+  if (records == 0) {
+    if (headSegment == tailSegment) {
+      tailSegment++;
+      tailSize = 0;
+    }
+    uint32_t first = headSegment;
+    while (headSegment < tailSegment) {
+      advance_segment();
+    }
+    commit();
+    remove_segments(first);
+    return;
+  }
+
+  char path[24];
+  segment_path(headSegment, path);
+  long size = storage.size(path);
+  if (headSegment != tailSegment && size >= 0 && headOffset >= (uint32_t)size) {
+    uint32_t first = headSegment;
+    advance_segment();
+    commit();
+    remove_segments(first);
+  } else if (pendingAcks >= FLASH_QUEUE_COMMIT_EVERY) {
+    commit();
+  }
+}
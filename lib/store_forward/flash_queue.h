@@ -0,0 +1,175 @@
+#ifndef FLASH_QUEUE_H
+#define FLASH_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+///////////////// COLA PERSISTENTE STORE-AND-FORWARD \\\\\\\\\\\\\\\\\
+*/
+// Tamaño maximo de cada segmento (fichero) de la cola en bytes
+#ifndef FLASH_QUEUE_SEGMENT_SIZE
+#define FLASH_QUEUE_SEGMENT_SIZE 4096
+#endif
+
+// Numero maximo de segmentos: acota el espacio total ocupado en flash
+#ifndef FLASH_QUEUE_MAX_SEGMENTS
+#define FLASH_QUEUE_MAX_SEGMENTS 16
+#endif
+
+// Registros confirmados entre dos escrituras de los punteros (limita el desgaste)
+#ifndef FLASH_QUEUE_COMMIT_EVERY
+#define FLASH_QUEUE_COMMIT_EVERY 8
+#endif
+
+// Tamaño maximo del topic y del payload de un registro
+#define FLASH_QUEUE_MAX_TOPIC 48
+#ifndef FLASH_QUEUE_MAX_PAYLOAD
+#define FLASH_QUEUE_MAX_PAYLOAD 320
+#endif
+
+/**
+ * @brief Acceso minimo a un sistema de ficheros. Permite usar LittleFS en la placa y un
+ * sistema de ficheros en RAM en el host.
+ */
+class QueueStorage {
+public:
+  virtual ~QueueStorage() {}
+
+  /**
+   * @brief Tamaño del fichero en bytes, o -1 si no existe.
+   */
+  virtual long size(const char* path) = 0;
+
+  /**
+   * @brief Lee hasta len bytes a partir de offset.
+   *
+   * @return Numero de bytes leidos.
+   */
+  virtual size_t read(const char* path, uint32_t offset, uint8_t* buffer, size_t len) = 0;
+
+  /**
+   * @brief Añade datos al final del fichero, creandolo si no existe.
+   */
+  virtual bool append(const char* path, const uint8_t* data, size_t len) = 0;
+
+  /**
+   * @brief Sustituye el contenido completo del fichero.
+   */
+  virtual bool write(const char* path, const uint8_t* data, size_t len) = 0;
+
+  /**
+   * @brief Elimina el fichero.
+   */
+  virtual bool remove(const char* path) = 0;
+};
+
+/**
+ * @brief Registro extraido de la cola.
+ */
+struct QueueEntry {
+  // Instante en que se guardo el registro (ms) en la base de tiempo del nodo
+  uint32_t timestamp;
+  // Hora UTC (s) en que se guardo el registro, o 0 si el reloj no estaba sincronizado. Si se
+  // conoce, sustituye a timestamp
+  uint32_t epoch;
+  // true si el registro se guardo durante el arranque actual (timestamp comparable con millis())
+  bool sameBoot;
+  char topic[FLASH_QUEUE_MAX_TOPIC + 1];
+  uint8_t payload[FLASH_QUEUE_MAX_PAYLOAD];
+  uint16_t payloadLen;
+};
+
+/**
+ * @brief Cola FIFO persistente, de solo escritura al final, repartida en segmentos.
+ *
+ * Cada registro lleva un CRC, de modo que una escritura interrumpida por un corte de
+ * alimentacion se detecta y se salta al recuperar la cola. Los punteros de lectura se
+ * guardan alternando entre dos copias con numero de secuencia y CRC. Los segmentos se
+ * escriben siempre en ficheros nuevos y se borran completos al consumirse, repartiendo
+ * el desgaste de la flash. Si se alcanza el limite de segmentos se descarta el mas antiguo.
+ *
+ * La lectura avanza por delante de los punteros guardados: peek() y next() entregan los
+ * registros en orden sin extraerlos, y pop() extrae el mas antiguo de los entregados cuando
+ * se confirma su envio. Tras un corte de alimentacion se vuelven a entregar los que no se
+ * hubieran extraido.
+ */
+class FlashQueue {
+public:
+  FlashQueue(QueueStorage& storage, const char* dir = "/sf");
+
+  /**
+   * @brief Recupera los punteros y el estado de la cola tras un arranque.
+   */
+  void begin();
+
+  /**
+   * @brief Añade un registro al final de la cola.
+   *
+   * @param timestamp Instante actual (ms) en la base de tiempo del nodo.
+   * @param epoch Hora UTC actual (s), o 0 si el reloj no esta sincronizado.
+   * @return false si el registro no cabe o no se ha podido escribir.
+   */
+  bool push(const char* topic, const uint8_t* payload, size_t len, uint32_t timestamp, uint32_t epoch = 0);
+
+  /**
+   * @brief Lee el siguiente registro por entregar sin extraerlo.
+   *
+   * @return false si no queda ninguno por entregar.
+   */
+  bool peek(QueueEntry& entry);
+
+  /**
+   * @brief Da por entregado el registro devuelto por el ultimo peek(): el siguiente peek()
+   * devuelve el posterior. El registro sigue en la cola hasta su pop().
+   */
+  void next();
+
+  /**
+   * @brief Extrae el registro entregado mas antiguo. Sin registros entregados no hace nada.
+   */
+  void pop();
+
+  /**
+   * @brief Guarda los punteros de lectura en flash.
+   */
+  void commit();
+
+  bool empty() const { return records == 0; }
+  uint32_t size() const { return records; }
+  // Registros entregados con next() y aun sin extraer
+  uint32_t delivered() const { return outstanding; }
+  uint32_t dropped() const { return droppedRecords; }
+
+private:
+  void segment_path(uint32_t segment, char* path) const;
+  bool load_meta();
+  void drop_oldest_segment();
+  // Pasa al segmento siguiente sin borrar el consumido: se borra con remove_segments() una
+  // vez guardados los punteros
+  void advance_segment();
+  void remove_segments(uint32_t first);
+  uint32_t scan_segment(uint32_t segment, uint32_t offset, bool* torn);
+  size_t read_entry(uint32_t segment, uint32_t offset, uint8_t* record);
+
+  QueueStorage& storage;
+  const char* dir;
+
+  uint32_t headSegment;
+  uint32_t headOffset;
+  uint32_t tailSegment;
+  uint32_t tailSize;
+  // Siguiente registro por entregar (no se guarda en flash)
+  uint32_t readSegment;
+  uint32_t readOffset;
+  uint16_t boot;
+  uint32_t metaSeq;
+
+  uint32_t records;
+  uint32_t outstanding;
+  uint32_t droppedRecords;
+  uint16_t pendingAcks;
+  uint16_t peekedLength;
+};
+
+#endif // FLASH_QUEUE_H
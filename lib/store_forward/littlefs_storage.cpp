@@ -0,0 +1,52 @@
+#include "littlefs_storage.h"
+
+long LittleFsStorage::size(const char* path) {
+  if (!fs.exists(path)) {
+    return -1;
+  }
+  File file = fs.open(path, "r");
+  if (!file) {
+    return -1;
+  }
+  long length = file.size();
+  file.close();
+  return length;
+}
+
+size_t LittleFsStorage::read(const char* path, uint32_t offset, uint8_t* buffer, size_t len) {
+  if (!fs.exists(path)) {
+    return 0;
+  }
+  File file = fs.open(path, "r");
+  if (!file || !file.seek(offset)) {
+    return 0;
+  }
+  size_t count = file.read(buffer, len);
+  file.close();
+  return count;
+}
+
+bool LittleFsStorage::append(const char* path, const uint8_t* data, size_t len) {
+  File file = fs.open(path, "a");
+  if (!file) {
+    return false;
+  }
+  // LittleFS confirma los datos al cerrar el fichero
+  size_t count = file.write(data, len);
+  file.close();
+  return count == len;
+}
+
+bool LittleFsStorage::write(const char* path, const uint8_t* data, size_t len) {
+  File file = fs.open(path, "w");
+  if (!file) {
+    return false;
+  }
+  size_t count = file.write(data, len);
+  file.close();
+  return count == len;
+}
+
+bool LittleFsStorage::remove(const char* path) {
+  return fs.remove(path);
+}
@@ -0,0 +1,24 @@
+#ifndef LITTLEFS_STORAGE_H
+#define LITTLEFS_STORAGE_H
+
+#include <FS.h>
+#include "flash_queue.h"
+
+/**
+ * @brief Implementacion de QueueStorage sobre un sistema de ficheros de Arduino (LittleFS).
+ */
+class LittleFsStorage : public QueueStorage {
+public:
+  explicit LittleFsStorage(fs::FS& fs) : fs(fs) {}
+
+  long size(const char* path) override;
+  size_t read(const char* path, uint32_t offset, uint8_t* buffer, size_t len) override;
+  bool append(const char* path, const uint8_t* data, size_t len) override;
+  bool write(const char* path, const uint8_t* data, size_t len) override;
+  bool remove(const char* path) override;
+
+private:
+  fs::FS& fs;
+};
+
+#endif // LITTLEFS_STORAGE_H
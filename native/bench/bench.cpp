@@ -0,0 +1,413 @@
+/*
+///////////////// BANCO DE PRUEBAS DEL FIRMWARE EN EL PC \\\\\\\\\\\\\\\\\
+*/
+// Ejecuta el setup() y el loop() reales del nodo sobre la HAL simulada, con el tiempo
+// simulado, y mide en cada iteracion del bucle: tiempo de CPU del PC, bytes publicados,
+// reservas de memoria dinamica y pico de pila. Como cada pasada de loop() ejecuta como
+// mucho una tarea del planificador, cada iteracion se atribuye a la tarea que ha corrido.
+//
+// Uso: program [segundos_simulados] [segundos_sin_red] [fichero.csv]
+//
+// Las pruebas unitarias (pio test -e native) tienen su propio main() y no compilan el
+// firmware, asi que el banco solo se incluye en pio run.
+#ifndef PIO_UNIT_TESTING
+#include <Arduino.h>
+#include <fake_hal.h>
+#include <scheduler.h>
+#include <board.h>
+#include <node_mqtt.h>
+#include <node_metrics.h>
+#include <boot_timeline.h>
+#include <node_time.h>
+#if defined(ESP32)
+#include <dht_rmt.h>
+#endif
+#ifdef ESPNOW_GATEWAY
+#include <node_espnow.h>
+#endif
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void setup();
+void loop();
+
+// Reloj del nodo en el escenario: adelanta BENCH_SKEW_PPM respecto al servidor NTP
+static const uint64_t BENCH_EPOCH_MS = 1760000000000ULL;
+static const int32_t BENCH_SKEW_PPM = 120;
+// Tramas del DHT11 con ruido en los pulsos y un bit erroneo cada BENCH_DHT_CORRUPT_EVERY
+static const uint8_t BENCH_DHT_JITTER_US = 8;
+static const uint32_t BENCH_DHT_CORRUPT_EVERY = 10;
+// Enlace con el broker: ritmo (bytes/ms) y retardo de ida y vuelta (ms); a mitad del escenario
+// queda bloqueado BENCH_STALL_S segundos (el broker deja de leer y el socket se llena)
+static const uint32_t BENCH_LINK_RATE = 250;
+static const uint32_t BENCH_LINK_LATENCY_MS = 8;
+static const unsigned long BENCH_STALL_S = 60;
+
+#ifdef ESPNOW_GATEWAY
+/*
+///////////////// NODOS HOJA SIMULADOS (PASARELA) \\\\\\\\*/
+// Con la pasarela, el banco hace de BENCH_LEAVES nodos hoja que envian una lectura cada
+// BENCH_LEAF_PERIOD_MS por el aire simulado, con link_send() sobre el mismo medio ESP-NOW que
+// escucha la pasarela. Se pierde una trama de cada BENCH_AIR_LOSS_EVERY y la confirmacion de
+// una de cada BENCH_AIR_ACK_LOSS_EVERY entregadas (la hoja la repite y llega duplicada). Un nodo
+// rearranca en frio a mitad del escenario: nueva sesion y secuencia desde 1.
+static const uint8_t BENCH_LEAVES = 6;
+static const unsigned long BENCH_LEAF_PERIOD_MS = 30000;
+static const uint32_t BENCH_AIR_LOSS_EVERY = 25;
+static const uint32_t BENCH_AIR_ACK_LOSS_EVERY = 9;
+
+struct BenchLeaf {
+  char name[LINK_NODE_SIZE];
+  uint8_t mac[6];
+  LinkSender sender;
+  unsigned long next;
+  uint32_t readings;
+};
+
+static BenchLeaf leaves[BENCH_LEAVES];
+
+static void leaves_begin() {
+  for (uint8_t i = 0; i < BENCH_LEAVES; i++) {
+    BenchLeaf& leaf = leaves[i];
+    snprintf(leaf.name, sizeof(leaf.name), "hoja_%u", i + 1);
+    const uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x10, 0x00, (uint8_t)(i + 1)};
+    memcpy(leaf.mac, mac, sizeof(mac));
+    link_sender_init(&leaf.sender, esp_random());
+    // Los despertares de las hojas no estan alineados
+    leaf.next = 5000 + i * (BENCH_LEAF_PERIOD_MS / BENCH_LEAVES);
+    leaf.readings = 0;
+  }
+}
+
+static void leaves_run(unsigned long duration) {
+  static bool rebooted = false;
+  if (!rebooted && millis() >= duration / 2) {
+    rebooted = true;
+    // Los contadores se conservan para el informe
+    leaves[0].sender.session = esp_random();
+    leaves[0].sender.seq = 0;
+  }
+  for (uint8_t i = 0; i < BENCH_LEAVES; i++) {
+    BenchLeaf& leaf = leaves[i];
+    if (millis() < leaf.next) {
+      continue;
+    }
+    leaf.next += BENCH_LEAF_PERIOD_MS;
+    leaf.readings++;
+    SensorSample lectura = {(uint32_t)millis(), 20.0f + i + (leaf.readings % 20) * 0.1f, 21.0f + i, 55.0f,
+                            (int16_t)(40 + i)};
+    // RSSI distinto por hoja, con una oscilacion que a ratos supera la banda muerta
+    hal_set_espnow_source(leaf.mac, (int8_t)(-50 - 6 * i - (leaf.readings % 16 < 8 ? 0 : 8)));
+    link_send(espnow_transport(), &leaf.sender, leaf.name, lectura, millis());
+  }
+}
+#endif
+
+/*
+///////////////// RESERVAS DE MEMORIA DINAMICA \\\\\\\\\\\\\\\\\
+*/
+static bool counting = false;
+static uint32_t allocations = 0;
+static uint64_t allocatedBytes = 0;
+
+static inline void count_allocation(size_t size) {
+  if (counting) {
+    allocations++;
+    allocatedBytes += size;
+  }
+}
+
+#if defined(__GLIBC__)
+// Con glibc se intercepta malloc: cubre tambien new, que se apoya en el
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+extern "C" void* malloc(size_t size) {
+  count_allocation(size);
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  count_allocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+  count_allocation(size);
+  return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) {
+  __libc_free(pointer);
+}
+#else
+#include <new>
+
+void* operator new(size_t size) {
+  count_allocation(size);
+  void* pointer = malloc(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+#endif
+
+/*
+///////////////// PICO DE PILA \\\\\\\\\\\\\\\\\
+*/
+// Se rellena una zona de la pila con un patron antes de cada iteracion; al terminar, la
+// parte sobrescrita da la profundidad maxima alcanzada por loop()
+static const size_t STACK_PAINT_SIZE = 64 * 1024;
+static const uint8_t STACK_PATTERN = 0xA5;
+static uintptr_t stackBottom = 0;
+
+__attribute__((noinline)) static void stack_paint() {
+  volatile uint8_t area[STACK_PAINT_SIZE];
+  for (size_t i = 0; i < STACK_PAINT_SIZE; i++) {
+    area[i] = STACK_PATTERN;
+  }
+  stackBottom = (uintptr_t)area;
+}
+
+__attribute__((noinline)) static size_t stack_peak() {
+  const volatile uint8_t* area = (const volatile uint8_t*)stackBottom;
+  size_t untouched = 0;
+  while (untouched < STACK_PAINT_SIZE && area[untouched] == STACK_PATTERN) {
+    untouched++;
+  }
+  return STACK_PAINT_SIZE - untouched;
+}
+
+/*
+///////////////// ESTADISTICAS POR FASE \\\\\\\\\\\\\\\\\
+*/
+// Una fase por tarea del planificador y una mas para las pasadas sin tarea
+struct PhaseStats {
+  const char* name;
+  uint32_t iterations;
+  uint64_t totalNs;
+  uint64_t maxNs;
+  uint64_t publishedBytes;
+  uint32_t allocations;
+  size_t peakStack;
+};
+
+static PhaseStats phases[SCHEDULER_MAX_TASKS + 1];
+
+static uint64_t host_ns() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Indice de la tarea que ha corrido en la ultima pasada (o la fase de reposo)
+static uint8_t phase_of_iteration(const unsigned long* runsBefore) {
+  uint8_t count = scheduler_task_count();
+  for (uint8_t i = 0; i < count; i++) {
+    if (scheduler_task(i)->runs != runsBefore[i]) {
+      return i;
+    }
+  }
+  return count;
+}
+
+// Error maximo (ms) de la hora del nodo una vez estimada la deriva
+static int64_t clockMaxError = 0;
+
+static void print_report(unsigned long simulated, uint32_t iterations) {
+  const HalMqttStats& mqtt = hal_mqtt_stats();
+  uint8_t count = scheduler_task_count();
+
+  printf("%-12s %8s %10s %10s %8s %10s %8s %8s\n", "fase", "iter", "media(us)", "max(us)", "max(ms)",
+         "publicado", "reservas", "pila(B)");
+  for (uint8_t i = 0; i <= count; i++) {
+    const PhaseStats& phase = phases[i];
+    if (phase.iterations == 0) {
+      continue;
+    }
+    // max(ms): duracion maxima en tiempo simulado, incluye las esperas de los sensores
+    unsigned long simulatedMax = i < count ? scheduler_task(i)->maxDuration : 0;
+    printf("%-12s %8lu %10.2f %10.2f %8lu %10llu %8lu %8zu\n", phase.name, (unsigned long)phase.iterations,
+           phase.totalNs / 1000.0 / phase.iterations, phase.maxNs / 1000.0, simulatedMax,
+           (unsigned long long)phase.publishedBytes, (unsigned long)phase.allocations, phase.peakStack);
+  }
+
+  printf("\ntiempo simulado: %lu s, iteraciones: %lu, retraso maximo de una tarea: %lu ms, pasada maxima: %lu ms\n",
+         simulated / 1000, (unsigned long)iterations, scheduler_max_latency(), scheduler_max_pass());
+  printf("mqtt: %lu conexiones, %lu mensajes (%lu reenviados), %llu bytes de payload, %llu bytes en el enlace, "
+         "%lu rechazadas\n",
+         (unsigned long)mqtt.connects, (unsigned long)mqtt.published, (unsigned long)mqtt.duplicates,
+         (unsigned long long)mqtt.payloadBytes, (unsigned long long)mqtt.wireBytes, (unsigned long)mqtt.refused);
+  const MqttClient& cliente = mqtt_client();
+  const MqttStats& envio = cliente.stats();
+  // Mediana de la confirmacion: limite de la primera cubeta que acumula la mitad de las medidas
+  uint8_t mediana = 0;
+  while (mediana < METRICS_BUCKETS && 2 * metrics_cumulative(envio.ackLatency, mediana) < envio.ackLatency.count) {
+    mediana++;
+  }
+  printf("mqtt (cliente): %lu encolados, %lu confirmados, %lu fuera del anillo, %lu bloqueos del socket, "
+         "%u pendientes, confirmacion mediana <= %.0f ms, media %.1f ms\n",
+         (unsigned long)envio.queued, (unsigned long)envio.acked, (unsigned long)envio.dropped,
+         (unsigned long)envio.stalls, cliente.pending(),
+         mediana < METRICS_BUCKETS ? METRICS_BOUNDS[mediana] / 1000.0 : INFINITY,
+         envio.ackLatency.count > 0 ? envio.ackLatency.sum / 1000.0 / envio.ackLatency.count : 0.0);
+  const BootTimeline& boot = boot_timeline();
+  printf("arranque: sensores %lu ms, wifi %lu ms, mqtt %lu ms, primera publicacion %lu ms (modo wifi %u)\n",
+         (unsigned long)boot.phases[ARRANQUE_SENSORES], (unsigned long)boot.phases[ARRANQUE_WIFI],
+         (unsigned long)boot.phases[ARRANQUE_MQTT], (unsigned long)boot.phases[ARRANQUE_PUBLICACION],
+         boot.wifiMode);
+  printf("cola persistente: %lu mensajes pendientes\n", (unsigned long)mqtt_queue_size());
+#ifndef ESPNOW_GATEWAY
+  printf("muestreo: %lu lecturas (%.1f por hora), periodo actual %lu ms\n", (unsigned long)metricas.lecturas,
+         metricas.lecturas * 3600000.0 / simulated, (unsigned long)metricas.periodoMuestreo);
+#endif
+  printf("memoria dinamica en el bucle: %lu reservas, %llu bytes\n", (unsigned long)allocations,
+         (unsigned long long)allocatedBytes);
+  const SyncClock& reloj = time_clock();
+  printf("reloj: %lu sincronizaciones, %lu saltos, deriva %.2f ppm (real %ld), error maximo %lld ms\n",
+         (unsigned long)reloj.syncs, (unsigned long)reloj.steps, reloj.driftPpb / 1000.0, (long)-BENCH_SKEW_PPM,
+         (long long)clockMaxError);
+#ifdef ESPNOW_GATEWAY
+  const HalEspNowStats& aire = hal_espnow_stats();
+  uint32_t entregadas = 0, reintentos = 0, fallidas = 0;
+  for (uint8_t i = 0; i < BENCH_LEAVES; i++) {
+    entregadas += leaves[i].sender.delivered;
+    reintentos += leaves[i].sender.retries;
+    fallidas += leaves[i].sender.failures;
+  }
+  printf("espnow: %lu tramas en el aire, %lu perdidas, %lu confirmaciones perdidas; hojas: %lu lecturas "
+         "confirmadas, %lu reintentos, %lu sin confirmar\n",
+         (unsigned long)aire.sent, (unsigned long)aire.lost, (unsigned long)aire.acksLost, (unsigned long)entregadas,
+         (unsigned long)reintentos, (unsigned long)fallidas);
+  const Gateway& pasarela = espnow_gateway();
+  uint32_t enLotes = 0;
+  for (uint8_t i = 0; i < pasarela.count; i++) {
+    enLotes += pasarela.leaves[i].batch.count;
+  }
+  uint32_t publicadas = pasarela.stats.accepted - enLotes - pasarela.stats.evicted;
+  printf("pasarela: %u nodos, %lu tramas, %lu nuevas, %lu repetidas, %lu antiguas, %lu invalidas; %lu lotes "
+         "(%.1f lecturas por mensaje, %lu fallidos), %lu de cobertura, %lu lecturas en lotes sin publicar, "
+         "%lu descartadas con el lote lleno, %lu fuera de la cola\n",
+         pasarela.count, (unsigned long)pasarela.stats.received, (unsigned long)pasarela.stats.accepted,
+         (unsigned long)pasarela.stats.duplicates, (unsigned long)pasarela.stats.stale,
+         (unsigned long)pasarela.stats.invalid, (unsigned long)pasarela.stats.batches,
+         pasarela.stats.batches > 0 ? (double)publicadas / pasarela.stats.batches : 0.0,
+         (unsigned long)pasarela.stats.encodeFailures, (unsigned long)pasarela.stats.coverage, (unsigned long)enLotes,
+         (unsigned long)pasarela.stats.evicted, (unsigned long)espnow_rx_overflows());
+#elif defined(ESP32)
+  const DhtStats& dht = dht_rmt_stats();
+  printf("dht (rmt): %lu transacciones, %lu errores, %lu lecturas repetidas por el intervalo minimo\n",
+         (unsigned long)dht.transactions, (unsigned long)dht.errors, (unsigned long)dht.cached);
+#endif
+}
+
+int main(int argc, char** argv) {
+  unsigned long duration = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 3600) * 1000;
+  unsigned long offline = (argc > 2 ? strtoul(argv[2], nullptr, 10) : 0) * 1000;
+  FILE* csv = argc > 3 ? fopen(argv[3], "w") : nullptr;
+  if (csv != nullptr) {
+    fprintf(csv, "iteracion,tiempo_ms,fase,ns,bytes,reservas,pila\n");
+  }
+
+  // Escenario: sensor de suelo a media escala con ruido y red caida los primeros segundos
+  hal_set_analog(Board::pinSuelo, Board::adcMax / 2, 8);
+  hal_set_network(offline == 0);
+  hal_set_ntp(BENCH_EPOCH_MS, BENCH_SKEW_PPM);
+  hal_set_dht(BENCH_DHT_JITTER_US, BENCH_DHT_CORRUPT_EVERY);
+  hal_set_mqtt_link(BENCH_LINK_RATE, BENCH_LINK_LATENCY_MS);
+#ifdef ESPNOW_GATEWAY
+  hal_set_espnow_air(BENCH_AIR_LOSS_EVERY, BENCH_AIR_ACK_LOSS_EVERY);
+#endif
+  unsigned long stallStart = duration / 2;
+  unsigned long stallEnd = stallStart + BENCH_STALL_S * 1000;
+
+  setup();
+#ifdef ESPNOW_GATEWAY
+  leaves_begin();
+#endif
+
+  uint8_t count = scheduler_task_count();
+  for (uint8_t i = 0; i < count; i++) {
+    phases[i].name = scheduler_task(i)->name;
+  }
+  phases[count].name = "reposo";
+
+  unsigned long runsBefore[SCHEDULER_MAX_TASKS];
+  uint32_t iterations = 0;
+  while (millis() < duration) {
+    if (offline > 0 && millis() >= offline) {
+      hal_set_network(true);
+      offline = 0;
+    }
+    if (millis() >= stallStart && stallStart > 0) {
+      hal_set_mqtt_link(0, BENCH_LINK_LATENCY_MS);
+      stallStart = 0;
+    }
+    if (millis() >= stallEnd && stallEnd > 0) {
+      hal_set_mqtt_link(BENCH_LINK_RATE, BENCH_LINK_LATENCY_MS);
+      stallEnd = 0;
+    }
+#ifdef ESPNOW_GATEWAY
+    // Las hojas transmiten entre dos pasadas del bucle, como la tarea de WiFi de la pasarela
+    leaves_run(duration);
+#endif
+
+    for (uint8_t i = 0; i < count; i++) {
+      runsBefore[i] = scheduler_task(i)->runs;
+    }
+    uint64_t bytesBefore = hal_mqtt_stats().wireBytes;
+    uint32_t allocationsBefore = allocations;
+
+    stack_paint();
+    counting = true;
+    uint64_t start = host_ns();
+    loop();
+    uint64_t elapsed = host_ns() - start;
+    counting = false;
+    size_t stack = stack_peak();
+
+    PhaseStats& phase = phases[phase_of_iteration(runsBefore)];
+    uint64_t bytes = hal_mqtt_stats().wireBytes - bytesBefore;
+    uint32_t allocated = allocations - allocationsBefore;
+    phase.iterations++;
+    phase.totalNs += elapsed;
+    if (elapsed > phase.maxNs) {
+      phase.maxNs = elapsed;
+    }
+    phase.publishedBytes += bytes;
+    phase.allocations += allocated;
+    if (stack > phase.peakStack) {
+      phase.peakStack = stack;
+    }
+
+    if (time_clock().driftValid) {
+      int64_t error = (int64_t)(time_epoch(millis()) - hal_true_epoch(millis()));
+      error = error < 0 ? -error : error;
+      clockMaxError = error > clockMaxError ? error : clockMaxError;
+    }
+
+    if (csv != nullptr) {
+      fprintf(csv, "%lu,%lu,%s,%llu,%llu,%lu,%zu\n", (unsigned long)iterations, millis(), phase.name,
+              (unsigned long long)elapsed, (unsigned long long)bytes, (unsigned long)allocated, stack);
+    }
+    iterations++;
+  }
+
+  if (csv != nullptr) {
+    fclose(csv);
+  }
+  print_report(millis(), iterations);
+  return 0;
+}
+
+#endif // PIO_UNIT_TESTING
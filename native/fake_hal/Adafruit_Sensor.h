@@ -0,0 +1,6 @@
+#ifndef ADAFRUIT_SENSOR_H
+#define ADAFRUIT_SENSOR_H
+
+// Sin contenido: el DHT simulado no necesita la capa unificada de sensores
+
+#endif // ADAFRUIT_SENSOR_H
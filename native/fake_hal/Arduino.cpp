@@ -0,0 +1,152 @@
+#include "Arduino.h"
+#include "fake_hal.h"
+#include <stdio.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// Identificador del chip simulado y estado del generador aleatorio
+static uint32_t chipId = 0x00C0FFEE & 0xFFFFFF;
+static uint32_t randomState = 0x9E3779B9;
+
+// Reloj simulado en microsegundos
+static uint64_t clockUs = 0;
+static bool serialEcho = false;
+
+// Estado de los pines: salida digital/PWM y lectura analogica con ruido
+static const uint8_t PIN_COUNT = 48;
+static int pinValue[PIN_COUNT];
+static uint16_t analogValue[PIN_COUNT];
+static uint16_t analogNoise[PIN_COUNT];
+static uint32_t noiseState = 12345;
+
+unsigned long millis() {
+  return (unsigned long)(clockUs / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)clockUs;
+}
+
+void delay(unsigned long ms) {
+  hal_advance(ms);
+}
+
+void yield() {}
+
+void hal_advance(uint32_t ms) {
+  clockUs += (uint64_t)ms * 1000;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < PIN_COUNT) {
+    pinValue[pin] = value;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < PIN_COUNT ? pinValue[pin] : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin < PIN_COUNT) {
+    pinValue[pin] = value;
+  }
+}
+
+int analogRead(uint8_t pin) {
+  if (pin >= PIN_COUNT) {
+    return 0;
+  }
+  // Cada conversion del ADC real tarda unos 10 us
+  clockUs += 10;
+  int value = analogValue[pin];
+  if (analogNoise[pin] > 0) {
+    // Generador congruencial: ruido reproducible entre ejecuciones
+    noiseState = noiseState * 1103515245u + 12345u;
+    value += (int)((noiseState >> 16) % (2u * analogNoise[pin] + 1)) - analogNoise[pin];
+  }
+  return value < 0 ? 0 : value;
+}
+
+void hal_set_analog(uint8_t pin, uint16_t value, uint16_t noise) {
+  if (pin < PIN_COUNT) {
+    analogValue[pin] = value;
+    analogNoise[pin] = noise;
+  }
+}
+
+void hal_set_chip_id(uint32_t id) {
+  chipId = id & 0xFFFFFF;
+  // Cada chip con su propia secuencia aleatoria, como el generador hardware
+  randomState = 0x9E3779B9 ^ (id * 2654435761u);
+}
+
+uint64_t EspClass::getEfuseMac() {
+  // MAC 24:0A:C4:xx:xx:xx en el orden de bytes del eFuse (primer byte en los bits bajos)
+  return 0x24ull | 0x0Aull << 8 | 0xC4ull << 16 | (uint64_t)chipId << 24;
+}
+
+uint32_t EspClass::getChipId() {
+  return chipId;
+}
+
+uint32_t esp_random() {
+  // xorshift32
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void hal_set_serial_echo(bool echo) {
+  serialEcho = echo;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (serialEcho) {
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+size_t Print::print(long value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%ld", value);
+  return print(text);
+}
+
+size_t Print::print(unsigned long value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%lu", value);
+  return print(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+size_t Print::print(const IPAddress& address) {
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", address[0], address[1], address[2], address[3]);
+  return print(text);
+}
+
+bool IPAddress::fromString(const char* text) {
+  unsigned a, b, c, d;
+  if (sscanf(text, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+    return false;
+  }
+  bytes[0] = a;
+  bytes[1] = b;
+  bytes[2] = c;
+  bytes[3] = d;
+  return true;
+}
@@ -0,0 +1,121 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Subconjunto del nucleo de Arduino que usa el firmware, para compilar en el PC
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#if defined(ESP8266)
+// Pines de la NodeMCU
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define A0 17
+#define LED_BUILTIN 2
+#endif
+
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+/**
+ * @brief Datos del chip simulado (subconjunto de EspClass).
+ */
+class EspClass {
+public:
+  uint64_t getEfuseMac();
+  uint32_t getChipId();
+  // Memoria fija: el PC no tiene las limitaciones del heap del chip
+  uint32_t getFreeHeap() { return 180000; }
+  uint32_t getMaxAllocHeap() { return 110000; }
+  uint32_t getMaxFreeBlockSize() { return 110000; }
+};
+
+extern EspClass ESP;
+
+// Generador de numeros aleatorios hardware
+uint32_t esp_random();
+#if defined(ESP8266)
+#define RANDOM_REG32 esp_random()
+#endif
+
+class IPAddress;
+
+/**
+ * @brief Salida de texto con la interfaz de Print de Arduino.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value) { return print((long)value); }
+  size_t print(unsigned int value) { return print((unsigned long)value); }
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t print(double value, int digits = 2);
+  size_t print(const IPAddress& address);
+
+  template <class T>
+  size_t println(const T& value) { return print(value) + println(); }
+  size_t println(double value, int digits) { return print(value, digits) + println(); }
+  size_t println() { return print("\r\n"); }
+};
+
+/**
+ * @brief Puerto serie simulado: descarta el texto salvo que se active el eco.
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief Direccion IPv4.
+ */
+class IPAddress {
+public:
+  IPAddress() : bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+  IPAddress(uint32_t address) { memcpy(bytes, &address, sizeof(bytes)); }
+
+  bool fromString(const char* text);
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, bytes, sizeof(address));
+    return address;
+  }
+  uint8_t operator[](int index) const { return bytes[index]; }
+
+private:
+  uint8_t bytes[4];
+};
+
+#endif // ARDUINO_H
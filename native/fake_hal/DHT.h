@@ -0,0 +1,26 @@
+#ifndef DHT_H
+#define DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+/**
+ * @brief DHT simulado. Como el real, una lectura nueva bloquea unos milisegundos y se
+ * reutiliza durante 2 segundos.
+ */
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type) { (void)pin; (void)type; }
+  void begin() {}
+  bool read(bool force = false);
+  float readTemperature();
+  float readHumidity();
+
+private:
+  unsigned long lastRead = 0;
+  bool valid = false;
+};
+
+#endif // DHT_H
@@ -0,0 +1,30 @@
+#ifndef DALLAS_TEMPERATURE_H
+#define DALLAS_TEMPERATURE_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+/**
+ * @brief Sonda DS18B20 simulada con el tiempo de conversion real de cada resolucion.
+ */
+class DallasTemperature {
+public:
+  explicit DallasTemperature(OneWire* bus) { (void)bus; }
+  void begin() {}
+  void setWaitForConversion(bool wait) { waitForConversion = wait; }
+  void setResolution(uint8_t bits) { resolution = bits; }
+  uint8_t getResolution() { return resolution; }
+  int16_t millisToWaitForConversion(uint8_t bits);
+  void requestTemperatures();
+  bool isConversionComplete();
+  float getTempCByIndex(uint8_t index);
+
+private:
+  bool waitForConversion = true;
+  uint8_t resolution = 12;
+  unsigned long conversionStart = 0;
+};
+
+#endif // DALLAS_TEMPERATURE_H
@@ -0,0 +1,7 @@
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+// En la HAL simulada la interfaz WiFi es comun a las dos placas
+#include <WiFi.h>
+
+#endif // ESP8266WIFI_H
@@ -0,0 +1,111 @@
+#include "FS.h"
+#include "LittleFS.h"
+#include "fake_hal.h"
+
+fs::FS LittleFS;
+
+namespace fs {
+
+struct FakeFile {
+  bool used;
+  char path[32];
+  uint32_t length;
+  uint8_t data[FAKE_FS_FILE_SIZE];
+};
+
+static FakeFile files[FAKE_FS_MAX_FILES];
+
+static FakeFile* find(const char* path) {
+  for (FakeFile& file : files) {
+    if (file.used && strcmp(file.path, path) == 0) {
+      return &file;
+    }
+  }
+  return nullptr;
+}
+
+size_t File::size() const {
+  return file != nullptr ? file->length : 0;
+}
+
+bool File::seek(uint32_t offset) {
+  if (file == nullptr || offset > file->length) {
+    return false;
+  }
+  position = offset;
+  return true;
+}
+
+size_t File::read(uint8_t* buffer, size_t len) {
+  if (file == nullptr || position >= file->length) {
+    return 0;
+  }
+  size_t count = file->length - position < len ? file->length - position : len;
+  memcpy(buffer, file->data + position, count);
+  position += count;
+  return count;
+}
+
+size_t File::write(const uint8_t* data, size_t len) {
+  if (file == nullptr || !writable) {
+    return 0;
+  }
+  // Como en la flash real, una escritura que no cabe queda a medias
+  size_t count = FAKE_FS_FILE_SIZE - position < len ? FAKE_FS_FILE_SIZE - position : len;
+  memcpy(file->data + position, data, count);
+  position += count;
+  if (position > file->length) {
+    file->length = position;
+  }
+  return count;
+}
+
+bool FS::exists(const char* path) {
+  return find(path) != nullptr;
+}
+
+File FS::open(const char* path, const char* mode) {
+  FakeFile* file = find(path);
+  if (mode[0] == 'r') {
+    return file != nullptr ? File(file, 0, false) : File();
+  }
+
+  if (file == nullptr) {
+    if (strlen(path) >= sizeof(file->path)) {
+      return File();
+    }
+    for (FakeFile& slot : files) {
+      if (!slot.used) {
+        file = &slot;
+        break;
+      }
+    }
+    if (file == nullptr) {
+      return File();
+    }
+    file->used = true;
+    strcpy(file->path, path);
+    file->length = 0;
+  }
+  if (mode[0] == 'w') {
+    file->length = 0;
+  }
+  return File(file, mode[0] == 'a' ? file->length : 0, true);
+}
+
+bool FS::remove(const char* path) {
+  FakeFile* file = find(path);
+  if (file == nullptr) {
+    return false;
+  }
+  file->used = false;
+  return true;
+}
+
+} // namespace fs
+
+void hal_fs_format() {
+  for (fs::FakeFile& file : fs::files) {
+    file.used = false;
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+
+// Limites del sistema de ficheros simulado, en memoria estatica para no contar como
+// reservas de memoria dinamica del firmware
+#ifndef FAKE_FS_MAX_FILES
+#define FAKE_FS_MAX_FILES 48
+#endif
+#ifndef FAKE_FS_FILE_SIZE
+#define FAKE_FS_FILE_SIZE 8192
+#endif
+
+namespace fs {
+
+struct FakeFile;
+
+/**
+ * @brief Fichero abierto del sistema de ficheros simulado.
+ */
+class File {
+public:
+  File() : file(nullptr), position(0), writable(false) {}
+  File(FakeFile* file, uint32_t position, bool writable) : file(file), position(position), writable(writable) {}
+
+  explicit operator bool() const { return file != nullptr; }
+  size_t size() const;
+  bool seek(uint32_t offset);
+  size_t read(uint8_t* buffer, size_t len);
+  size_t write(const uint8_t* data, size_t len);
+  void close() { file = nullptr; }
+
+private:
+  FakeFile* file;
+  uint32_t position;
+  bool writable;
+};
+
+/**
+ * @brief Sistema de ficheros plano en memoria con la interfaz de fs::FS.
+ */
+class FS {
+public:
+  bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+  bool exists(const char* path);
+  File open(const char* path, const char* mode);
+  bool remove(const char* path);
+  bool mkdir(const char* path) { (void)path; return true; }
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // FS_H
@@ -0,0 +1,17 @@
+#ifndef ONEWIRE_H
+#define ONEWIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Bus OneWire simulado: solo guarda el pin.
+ */
+class OneWire {
+public:
+  explicit OneWire(uint8_t pin) : pin(pin) {}
+
+private:
+  uint8_t pin;
+};
+
+#endif // ONEWIRE_H
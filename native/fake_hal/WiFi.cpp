@@ -0,0 +1,197 @@
+#include "WiFi.h"
+#include "fake_hal.h"
+#include "mqtt_broker.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+#include <string.h>
+
+WiFiClass WiFi;
+
+// Tiempo simulado que tarda la asociacion con el punto de acceso
+static const unsigned long WIFI_FAKE_ASSOCIATION_MS = 1500;
+// Asociacion directa con canal y BSSID conocidos
+static const unsigned long WIFI_FAKE_FAST_MS = 300;
+
+static bool networkAvailable = true;
+static bool associating = false;
+static unsigned long associationStart = 0;
+static IPAddress address;
+static unsigned long associationTime = WIFI_FAKE_ASSOCIATION_MS;
+static bool wrongAccessPoint = false;
+
+// Punto de acceso simulado
+static uint8_t apBssid[6] = {0x02, 0x1a, 0x11, 0x00, 0x00, 0x01};
+static int32_t apChannel = 6;
+
+void hal_set_access_point(int32_t channel, uint8_t lastByte) {
+  apChannel = channel;
+  apBssid[5] = lastByte;
+}
+
+// Peticion HTTP pendiente y destino de su respuesta
+static const char* pendingRequest = nullptr;
+static Print* pendingOutput = nullptr;
+// Bytes que acepta cada escritura en una conexion del servidor (un segmento)
+static const size_t WIFI_FAKE_HTTP_WINDOW = 1460;
+// Salida de la conexion del servidor en curso, para lwip_send()
+static Print* httpOutput = nullptr;
+
+void hal_http_request(const char* request, Print& output) {
+  pendingRequest = request;
+  pendingOutput = &output;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout) {
+  (void)host;
+  (void)port;
+  (void)timeout;
+  stop();
+  socket = broker_open();
+  return socket >= 0;
+}
+
+uint8_t WiFiClient::connected() {
+  if (output != nullptr) {
+    return 1;
+  }
+  if (socket >= 0 && !broker_connected(socket)) {
+    socket = -1;
+  }
+  return socket >= 0;
+}
+
+int WiFiClient::availableForWrite() {
+  return output != nullptr ? (int)WIFI_FAKE_HTTP_WINDOW : (int)broker_writable(socket);
+}
+
+int WiFiClient::available() {
+  if (output != nullptr) {
+    return request != nullptr ? (int)strlen(request) : 0;
+  }
+  return (int)broker_available(socket);
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+  if (output != nullptr) {
+    size_t n = request != nullptr ? strnlen(request, size) : 0;
+    memcpy(buffer, request, n);
+    request += n;
+    return (int)n;
+  }
+  return socket >= 0 ? (int)broker_read(socket, buffer, size) : -1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  if (socket >= 0) {
+    return broker_write(socket, buffer, size);
+  }
+  if (output == nullptr) {
+    return 0;
+  }
+  return output->write(buffer, size < WIFI_FAKE_HTTP_WINDOW ? size : WIFI_FAKE_HTTP_WINDOW);
+}
+
+void WiFiClient::stop(unsigned int maxWaitMs) {
+  (void)maxWaitMs;
+  if (output != nullptr && output == httpOutput) {
+    httpOutput = nullptr;
+  }
+  request = nullptr;
+  output = nullptr;
+  broker_close(socket);
+  socket = -1;
+}
+
+WiFiClient WiFiServer::available() {
+  if (pendingRequest == nullptr || !networkAvailable) {
+    return WiFiClient();
+  }
+  WiFiClient client(pendingRequest, pendingOutput);
+  httpOutput = pendingOutput;
+  pendingRequest = nullptr;
+  return client;
+}
+
+ssize_t lwip_send(int s, const void* data, size_t size, int flags) {
+  (void)flags;
+  if (s == WiFiClient::HTTP_FD && httpOutput != nullptr) {
+    size_t n = size < WIFI_FAKE_HTTP_WINDOW ? size : WIFI_FAKE_HTTP_WINDOW;
+    return (ssize_t)httpOutput->write((const uint8_t*)data, n);
+  }
+  if (!broker_connected(s)) {
+    errno = ENOTCONN;
+    return -1;
+  }
+  size_t n = broker_write(s, (const uint8_t*)data, size);
+  if (n == 0 && size > 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  return (ssize_t)n;
+}
+
+void hal_set_network(bool available) {
+  networkAvailable = available;
+}
+
+bool WiFiClass::mode(WiFiMode_t mode) {
+  if (mode == WIFI_OFF) {
+    associating = false;
+  }
+  return true;
+}
+
+bool WiFiClass::config(IPAddress ip, IPAddress gateway, IPAddress subnet) {
+  (void)gateway;
+  (void)subnet;
+  address = ip;
+  return true;
+}
+
+int WiFiClass::begin(const char* ssid, const char* password, int32_t channel, const uint8_t* bssid, bool connect) {
+  (void)ssid;
+  (void)password;
+  bool direct = channel != 0 && bssid != nullptr;
+  wrongAccessPoint = direct && (channel != apChannel || memcmp(bssid, apBssid, sizeof(apBssid)) != 0);
+  associationTime = direct ? WIFI_FAKE_FAST_MS : WIFI_FAKE_ASSOCIATION_MS;
+  associating = connect;
+  associationStart = millis();
+  return status();
+}
+
+bool WiFiClass::reconnect() {
+  wrongAccessPoint = false;
+  associationTime = WIFI_FAKE_ASSOCIATION_MS;
+  associating = true;
+  associationStart = millis();
+  return true;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  (void)wifiOff;
+  associating = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!associating || !networkAvailable || wrongAccessPoint) {
+    return WL_DISCONNECTED;
+  }
+  return millis() - associationStart >= associationTime ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+  return address;
+}
+
+uint8_t* WiFiClass::BSSID() {
+  return status() == WL_CONNECTED ? apBssid : nullptr;
+}
+
+int32_t WiFiClass::channel() {
+  return status() == WL_CONNECTED ? apChannel : 0;
+}
+
+int WiFiClass::RSSI() {
+  return status() == WL_CONNECTED ? -61 : 0;
+}
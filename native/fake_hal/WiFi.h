@@ -0,0 +1,87 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+} WiFiMode_t;
+
+/**
+ * @brief Conexion TCP simulada. Como cliente, connect() abre una conexion con el broker MQTT
+ * simulado (mqtt_broker.h); el servidor simulado la entrega con la peticion inyectada por
+ * hal_http_request() para leer y escribe la respuesta en su salida, como mucho
+ * WIFI_FAKE_HTTP_WINDOW bytes en cada escritura.
+ */
+class WiFiClient : public Print {
+public:
+  // Descriptor de las conexiones del servidor simulado, para lwip_send()
+  static const int HTTP_FD = 2;
+
+  WiFiClient() : request(nullptr), output(nullptr), socket(-1) {}
+  WiFiClient(const char* request, Print* output) : request(request), output(output), socket(-1) {}
+
+  int connect(const char* host, uint16_t port, int32_t timeout = 0);
+  uint8_t connected();
+  int fd() const { return output != nullptr ? HTTP_FD : socket; }
+  void setNoDelay(bool noDelay) { (void)noDelay; }
+  void setSync(bool sync) { (void)sync; }
+  int availableForWrite();
+  int available();
+  int read(uint8_t* buffer, size_t size);
+
+  using Print::write;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void setTimeout(unsigned long timeout) { (void)timeout; }
+  void stop(unsigned int maxWaitMs = 0);
+  explicit operator bool() const { return output != nullptr || socket >= 0; }
+
+private:
+  const char* request;
+  Print* output;
+  int socket;
+};
+
+/**
+ * @brief Servidor TCP simulado: solo entrega las peticiones inyectadas con hal_http_request().
+ */
+class WiFiServer {
+public:
+  explicit WiFiServer(uint16_t port) { (void)port; }
+  void begin() {}
+  WiFiClient available();
+};
+
+/**
+ * @brief Interfaz WiFi simulada. La asociacion se completa WIFI_FAKE_ASSOCIATION_MS despues
+ * de begin() o reconnect(), si la red simulada esta disponible. Con canal y BSSID no hay
+ * escaneo y tarda WIFI_FAKE_FAST_MS, pero solo si coinciden con los del punto de acceso.
+ */
+class WiFiClass {
+public:
+  bool mode(WiFiMode_t mode);
+  bool config(IPAddress ip, IPAddress gateway, IPAddress subnet);
+  int begin(const char* ssid, const char* password, int32_t channel = 0, const uint8_t* bssid = nullptr,
+            bool connect = true);
+  bool reconnect();
+  bool disconnect(bool wifiOff = false);
+  wl_status_t status();
+  IPAddress localIP();
+  int RSSI();
+  uint8_t* BSSID();
+  int32_t channel();
+  void setSleep(bool enabled) { (void)enabled; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // WIFI_H
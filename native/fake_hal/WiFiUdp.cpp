@@ -0,0 +1,102 @@
+#include "WiFiUdp.h"
+#include "WiFi.h"
+#include "fake_hal.h"
+#include <string.h>
+
+// Servidor NTP simulado: hora UTC (ms) cuando millis() vale 0, adelanto del reloj del nodo
+// respecto a la hora real (ppm) y retardo de ida y vuelta de la red
+static uint64_t ntpEpoch = 1760000000000ULL;
+static int32_t ntpSkewPpm = 0;
+static uint32_t ntpRoundTrip = 4;
+static bool ntpAvailable = true;
+
+void hal_set_ntp(uint64_t epochMs, int32_t skewPpm, uint32_t roundTripMs, bool available) {
+  ntpEpoch = epochMs;
+  ntpSkewPpm = skewPpm;
+  ntpRoundTrip = roundTripMs;
+  ntpAvailable = available;
+}
+
+// Hora real en el instante local indicado: un reloj que adelanta skew ppm ha contado
+// skew ppm de mas
+static uint64_t true_epoch(unsigned long local) {
+  return ntpEpoch + local - (int64_t)local * ntpSkewPpm / 1000000;
+}
+
+uint64_t hal_true_epoch(unsigned long local) {
+  return true_epoch(local);
+}
+
+static void put_ntp(uint8_t* out, uint64_t epochMs) {
+  uint32_t segundos = (uint32_t)(epochMs / 1000 + 2208988800ULL);
+  uint32_t fraccion = (uint32_t)(((epochMs % 1000) << 32) / 1000);
+  for (uint8_t i = 0; i < 4; i++) {
+    out[i] = segundos >> (24 - 8 * i);
+    out[4 + i] = fraccion >> (24 - 8 * i);
+  }
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  (void)port;
+  open = true;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port) {
+  (void)host;
+  outLength = 0;
+  toServer = port == 123;
+  return open ? 1 : 0;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size) {
+  size_t n = size < sizeof(outgoing) - outLength ? size : sizeof(outgoing) - outLength;
+  memcpy(outgoing + outLength, buffer, n);
+  outLength += n;
+  return n;
+}
+
+int WiFiUDP::endPacket() {
+  // Sin red o sin servidor la consulta se pierde
+  if (!toServer || outLength != sizeof(outgoing) || WiFi.status() != WL_CONNECTED || !ntpAvailable) {
+    return 1;
+  }
+
+  // Servidor de estrato 2 que responde al instante del punto medio del viaje
+  memset(response, 0, sizeof(response));
+  response[0] = 0x24;
+  response[1] = 2;
+  memcpy(response + 24, outgoing + 40, 8);
+  sentAt = millis();
+  uint64_t hora = true_epoch(sentAt + ntpRoundTrip / 2);
+  put_ntp(response + 32, hora);
+  put_ntp(response + 40, hora);
+  pending = true;
+  return 1;
+}
+
+int WiFiUDP::parsePacket() {
+  received = false;
+  if (!pending || millis() - sentAt < ntpRoundTrip) {
+    return 0;
+  }
+  pending = false;
+  received = true;
+  return sizeof(response);
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t length) {
+  if (!received) {
+    return 0;
+  }
+  size_t n = length < sizeof(response) ? length : sizeof(response);
+  memcpy(buffer, response, n);
+  received = false;
+  return n;
+}
+
+void WiFiUDP::stop() {
+  open = false;
+  pending = false;
+  received = false;
+}
@@ -0,0 +1,35 @@
+#ifndef WIFIUDP_H
+#define WIFIUDP_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Socket UDP simulado. Solo atiende consultas SNTP (48 bytes al puerto 123): las
+ * responde un servidor NTP simulado cuya hora fija hal_set_ntp(). La respuesta llega medio
+ * retardo de ida y vuelta despues de la consulta y se lee con parsePacket()/read().
+ */
+class WiFiUDP {
+public:
+  WiFiUDP() : open(false), outLength(0), pending(false), sentAt(0), received(false), toServer(false) {}
+
+  uint8_t begin(uint16_t port);
+  int beginPacket(const char* host, uint16_t port);
+  size_t write(const uint8_t* buffer, size_t size);
+  int endPacket();
+  int parsePacket();
+  int read(uint8_t* buffer, size_t length);
+  void stop();
+
+private:
+  bool open;
+  uint8_t outgoing[48];
+  size_t outLength;
+  // Respuesta en camino y respuesta entregada por parsePacket()
+  bool pending;
+  unsigned long sentAt;
+  uint8_t response[48];
+  bool received;
+  bool toServer;
+};
+
+#endif // WIFIUDP_H
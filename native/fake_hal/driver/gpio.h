@@ -0,0 +1,43 @@
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+#include <stdint.h>
+
+// Subconjunto del driver GPIO del ESP-IDF que usa el firmware. Los pines no tienen efecto
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef int gpio_num_t;
+
+typedef enum {
+  GPIO_MODE_INPUT,
+  GPIO_MODE_OUTPUT,
+  GPIO_MODE_INPUT_OUTPUT_OD,
+} gpio_mode_t;
+
+typedef enum {
+  GPIO_PULLUP_ONLY,
+  GPIO_FLOATING,
+} gpio_pull_mode_t;
+
+inline esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode) {
+  (void)pin;
+  (void)mode;
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_set_pull_mode(gpio_num_t pin, gpio_pull_mode_t pull) {
+  (void)pin;
+  (void)pull;
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+  (void)pin;
+  (void)level;
+  return ESP_OK;
+}
+
+#endif // DRIVER_GPIO_H
@@ -0,0 +1,67 @@
+#ifndef DRIVER_RMT_H
+#define DRIVER_RMT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gpio.h"
+
+// Subconjunto del driver RMT del ESP-IDF (API anterior a la 5.0) para la recepcion. El canal
+// simulado solo tiene conectado un DHT11: al arrancar la recepcion genera la trama con las
+// lecturas de hal_set_sensors() y el ruido de hal_set_dht(), y la entrega por el buffer
+// circular cuando ha pasado su duracion en el reloj simulado.
+
+typedef uint32_t TickType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef enum {
+  RMT_CHANNEL_0,
+  RMT_CHANNEL_1,
+  RMT_CHANNEL_2,
+  RMT_CHANNEL_3,
+  RMT_CHANNEL_4,
+  RMT_CHANNEL_5,
+  RMT_CHANNEL_6,
+  RMT_CHANNEL_7,
+} rmt_channel_t;
+
+typedef struct {
+  union {
+    struct {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+typedef struct {
+  uint16_t idle_threshold;
+  uint8_t filter_ticks_thresh;
+  bool filter_en;
+} rmt_rx_config_t;
+
+typedef struct {
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  rmt_rx_config_t rx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_RX(gpio, channel_id) \
+  { channel_id, gpio, 80, 1, {12000, 100, true} }
+
+typedef void* RingbufHandle_t;
+
+esp_err_t rmt_config(const rmt_config_t* config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_get_ringbuf_handle(rmt_channel_t channel, RingbufHandle_t* buf_handle);
+esp_err_t rmt_rx_start(rmt_channel_t channel, bool rx_idx_rst);
+esp_err_t rmt_rx_stop(rmt_channel_t channel);
+
+void* xRingbufferReceive(RingbufHandle_t handle, size_t* item_size, TickType_t ticks);
+void vRingbufferReturnItem(RingbufHandle_t handle, void* item);
+
+#endif // DRIVER_RMT_H
@@ -0,0 +1,43 @@
+#ifndef ESP_NOW_H
+#define ESP_NOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_wifi.h"
+
+// Subconjunto de ESP-NOW del ESP-IDF 4.x (core de Arduino 2.x). El aire simulado es un bucle:
+// cada trama enviada llega al callback de recepcion del propio dispositivo, como si la
+// enviara el nodo fijado con hal_set_espnow_source(), con las perdidas de hal_set_espnow_air().
+// El callback de envio se llama antes de volver de esp_now_send().
+
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_KEY_LEN 16
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_ERR_ESPNOW_NOT_INIT 0x3065
+#define ESP_ERR_ESPNOW_ARG 0x3066
+
+typedef enum {
+  ESP_NOW_SEND_SUCCESS = 0,
+  ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef struct {
+  uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+  uint8_t lmk[ESP_NOW_KEY_LEN];
+  uint8_t channel;
+  wifi_interface_t ifidx;
+  bool encrypt;
+  void* priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac_addr, esp_now_send_status_t status);
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac_addr, const uint8_t* data, int data_len);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_deinit();
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
+
+#endif // ESP_NOW_H
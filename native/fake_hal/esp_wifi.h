@@ -0,0 +1,53 @@
+#ifndef ESP_WIFI_H
+#define ESP_WIFI_H
+
+#include <stdint.h>
+#include "driver/gpio.h"
+
+// Subconjunto de esp_wifi del ESP-IDF que usa ESP-NOW: canal de la radio y captura en modo
+// promiscuo, con la que se mide el RSSI de las tramas. Las tramas las genera el aire simulado
+// de esp_now.h.
+
+typedef enum {
+  WIFI_SECOND_CHAN_NONE = 0,
+  WIFI_SECOND_CHAN_ABOVE,
+  WIFI_SECOND_CHAN_BELOW,
+} wifi_second_chan_t;
+
+typedef enum {
+  WIFI_IF_STA = 0,
+  WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+  WIFI_PKT_MGMT,
+  WIFI_PKT_CTRL,
+  WIFI_PKT_DATA,
+  WIFI_PKT_MISC,
+} wifi_promiscuous_pkt_type_t;
+
+#define WIFI_PROMIS_FILTER_MASK_MGMT (1 << 0)
+
+typedef struct {
+  uint32_t filter_mask;
+} wifi_promiscuous_filter_t;
+
+typedef struct {
+  signed rssi : 8;
+  unsigned channel : 4;
+  unsigned sig_len : 12;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+  wifi_pkt_rx_ctrl_t rx_ctrl;
+  uint8_t payload[];
+} wifi_promiscuous_pkt_t;
+
+typedef void (*wifi_promiscuous_cb_t)(void* buf, wifi_promiscuous_pkt_type_t type);
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_set_promiscuous(bool enable);
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t* filter);
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb);
+
+#endif // ESP_WIFI_H
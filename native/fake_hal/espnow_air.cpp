@@ -0,0 +1,132 @@
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "fake_hal.h"
+#include <string.h>
+
+static HalEspNowStats stats;
+
+// Perdidas deterministas: cada lossEvery tramas no llega una, y de las que llegan, cada
+// ackLossEvery se pierde la confirmacion (el emisor la da por fallida y la repite)
+static uint32_t lossEvery = 0;
+static uint32_t ackLossEvery = 0;
+
+// Nodo que transmite las siguientes tramas
+static uint8_t sourceMac[ESP_NOW_ETH_ALEN] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+static int8_t sourceRssi = -60;
+
+static bool initialized = false;
+static esp_now_send_cb_t sendCallback = nullptr;
+static esp_now_recv_cb_t recvCallback = nullptr;
+static bool promiscuous = false;
+static uint32_t promiscuousFilter = 0;
+static wifi_promiscuous_cb_t promiscuousCallback = nullptr;
+
+void hal_set_espnow_air(uint32_t lossEveryFrames, uint32_t ackLossEveryFrames) {
+  lossEvery = lossEveryFrames;
+  ackLossEvery = ackLossEveryFrames;
+}
+
+void hal_set_espnow_source(const uint8_t* mac, int8_t rssi) {
+  memcpy(sourceMac, mac, sizeof(sourceMac));
+  sourceRssi = rssi;
+}
+
+const HalEspNowStats& hal_espnow_stats() {
+  return stats;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) {
+  (void)primary;
+  (void)second;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous(bool enable) {
+  promiscuous = enable;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t* filter) {
+  promiscuousFilter = filter->filter_mask;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb) {
+  promiscuousCallback = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_init() {
+  initialized = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_deinit() {
+  initialized = false;
+  sendCallback = nullptr;
+  recvCallback = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  sendCallback = cb;
+  return initialized ? ESP_OK : ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  recvCallback = cb;
+  return initialized ? ESP_OK : ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+  return initialized && peer != nullptr ? ESP_OK : ESP_ERR_ESPNOW_ARG;
+}
+
+// Trama de accion tal como la captura el modo promiscuo: cabecera 802.11 de 24 bytes,
+// categoria 127 (fabricante) y el contenido
+static void sniff(const uint8_t* data, size_t len) {
+  if (!promiscuous || promiscuousCallback == nullptr || !(promiscuousFilter & WIFI_PROMIS_FILTER_MASK_MGMT)) {
+    return;
+  }
+  static uint8_t buffer[sizeof(wifi_promiscuous_pkt_t) + 25 + ESP_NOW_MAX_DATA_LEN];
+  wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buffer;
+  memset(buffer, 0, sizeof(buffer));
+  pkt->rx_ctrl.rssi = sourceRssi;
+  pkt->rx_ctrl.sig_len = 25 + len;
+  pkt->payload[0] = 0xD0;
+  memcpy(pkt->payload + 10, sourceMac, ESP_NOW_ETH_ALEN);
+  pkt->payload[24] = 127;
+  memcpy(pkt->payload + 25, data, len);
+  promiscuousCallback(pkt, WIFI_PKT_MGMT);
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len) {
+  if (!initialized) {
+    return ESP_ERR_ESPNOW_NOT_INIT;
+  }
+  if (data == nullptr || len == 0 || len > ESP_NOW_MAX_DATA_LEN) {
+    return ESP_ERR_ESPNOW_ARG;
+  }
+  stats.sent++;
+
+  bool delivered = lossEvery == 0 || stats.sent % lossEvery != 0;
+  bool acked = delivered;
+  if (delivered) {
+    stats.delivered++;
+    sniff(data, len);
+    if (recvCallback != nullptr) {
+      recvCallback(sourceMac, data, (int)len);
+    }
+    if (ackLossEvery > 0 && stats.delivered % ackLossEvery == 0) {
+      stats.acksLost++;
+      acked = false;
+    }
+  } else {
+    stats.lost++;
+  }
+
+  if (sendCallback != nullptr) {
+    sendCallback(peer_addr != nullptr ? peer_addr : sourceMac, acked ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+  }
+  return ESP_OK;
+}
@@ -0,0 +1,164 @@
+#ifndef FAKE_HAL_H
+#define FAKE_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+/*
+///////////////// CONTROL DE LA HAL SIMULADA \\\\\\\\\\\\\\\\\
+*/
+// La HAL simulada sustituye a Arduino, WiFi (TCP y UDP) con un broker MQTT, ESP-NOW, LittleFS y las
+// librerias de los sensores para ejecutar el firmware en el PC (entorno native de PlatformIO). El tiempo es
+// simulado: delay() avanza el reloj sin esperar, y millis() solo cambia cuando el codigo o
+// la propia HAL lo avanzan.
+
+/**
+ * @brief Estadisticas acumuladas del broker MQTT simulado.
+ */
+struct HalMqttStats {
+  // sesiones (CONNECT) y conexiones rechazadas por falta de red
+  uint32_t connects;
+  uint32_t refused;
+  // PUBLISH recibidos, y cuantos de ellos son reenvios (DUP)
+  uint32_t published;
+  uint32_t duplicates;
+  uint64_t payloadBytes;
+  // Bytes en el enlace: cabecera fija, topic y payload de cada PUBLISH
+  uint64_t wireBytes;
+};
+
+/**
+ * @brief Estadisticas acumuladas del aire ESP-NOW simulado.
+ */
+struct HalEspNowStats {
+  // tramas enviadas, entregadas al receptor y perdidas
+  uint32_t sent;
+  uint32_t delivered;
+  uint32_t lost;
+  // tramas entregadas cuya confirmacion se ha perdido
+  uint32_t acksLost;
+};
+
+/**
+ * @brief Avanza el reloj simulado.
+ *
+ * @param ms Milisegundos a avanzar.
+ */
+void hal_advance(uint32_t ms);
+
+/**
+ * @brief Fija el valor que devuelve analogRead() en un pin.
+ *
+ * @param pin Pin analogico.
+ * @param value Lectura del ADC. Se le suma un ruido determinista de +-noise cuentas.
+ * @param noise Amplitud del ruido.
+ */
+void hal_set_analog(uint8_t pin, uint16_t value, uint16_t noise = 0);
+
+/**
+ * @brief Activa o desactiva la red WiFi simulada. Sin red, el broker no es alcanzable.
+ */
+void hal_set_network(bool available);
+
+/**
+ * @brief Inyecta una peticion HTTP para el siguiente WiFiServer::available(); la respuesta
+ * se escribe en la salida indicada.
+ */
+void hal_http_request(const char* request, Print& output);
+
+/**
+ * @brief Cambia el canal y el ultimo byte del BSSID del punto de acceso simulado, para
+ * probar que la asociacion rapida con una cache antigua recurre al escaneo completo.
+ */
+void hal_set_access_point(int32_t channel, uint8_t lastByte);
+
+/**
+ * @brief Fija las lecturas de los sensores simulados.
+ */
+void hal_set_sensors(float probe, float temperature, float humidity);
+
+/**
+ * @brief Fija el ruido de las tramas que captura el canal RMT del DHT11 simulado.
+ *
+ * @param jitterUs Desviacion maxima (us) de la duracion de cada pulso.
+ * @param corruptEvery Cada cuantas tramas se invierte un bit (0 para ninguna).
+ */
+void hal_set_dht(uint8_t jitterUs, uint32_t corruptEvery = 0);
+
+/**
+ * @brief Fija el identificador del chip (3 ultimos bytes de la MAC) y la semilla del
+ * generador aleatorio hardware.
+ */
+void hal_set_chip_id(uint32_t id);
+
+/**
+ * @brief Copia el texto escrito en Serial a la salida estandar (desactivado por defecto).
+ */
+void hal_set_serial_echo(bool echo);
+
+/**
+ * @brief Estadisticas del broker MQTT simulado.
+ */
+const HalMqttStats& hal_mqtt_stats();
+
+/**
+ * @brief Publica un mensaje retenido en el broker simulado. Se envia al nodo en cuanto esta
+ * suscrito al topic, y de nuevo en cada nueva suscripcion.
+ */
+void hal_mqtt_retain(const char* topic, const char* payload);
+
+/**
+ * @brief Configura el enlace TCP con el broker simulado.
+ *
+ * @param bytesPerMs Bytes por ms que salen del buffer de envio del nodo (0: enlace bloqueado,
+ * el broker no recibe nada y el buffer se llena).
+ * @param latencyMs Retardo de ida y vuelta: las respuestas del broker llegan este tiempo
+ * despues de recibir el paquete.
+ * @param sendBufferSize Tamaño del buffer de envio del socket (2920 bytes por defecto, dos
+ * segmentos como en el ESP8266).
+ */
+void hal_set_mqtt_link(uint32_t bytesPerMs, uint32_t latencyMs, size_t sendBufferSize = 2920);
+
+/**
+ * @brief Configura el servidor NTP simulado.
+ *
+ * @param epochMs Hora UTC (ms desde la epoca Unix) cuando millis() vale 0.
+ * @param skewPpm Partes por millon que adelanta el reloj del nodo respecto a la hora real
+ * (negativo si atrasa).
+ * @param roundTripMs Retardo de ida y vuelta de la consulta.
+ * @param available false para que el servidor no responda.
+ */
+void hal_set_ntp(uint64_t epochMs, int32_t skewPpm, uint32_t roundTripMs = 4, bool available = true);
+
+/**
+ * @brief Hora UTC real (segun el servidor NTP simulado) en un instante del reloj del nodo.
+ */
+uint64_t hal_true_epoch(unsigned long local);
+
+/**
+ * @brief Configura las perdidas del aire ESP-NOW simulado.
+ *
+ * @param lossEvery Cada cuantas tramas se pierde una (0 para ninguna).
+ * @param ackLossEvery Cada cuantas tramas entregadas se pierde la confirmacion (0 para ninguna).
+ */
+void hal_set_espnow_air(uint32_t lossEvery, uint32_t ackLossEvery = 0);
+
+/**
+ * @brief Fija el nodo que transmite las siguientes tramas ESP-NOW: su MAC y el RSSI con el
+ * que llegan.
+ */
+void hal_set_espnow_source(const uint8_t* mac, int8_t rssi);
+
+/**
+ * @brief Estadisticas del aire ESP-NOW simulado.
+ */
+const HalEspNowStats& hal_espnow_stats();
+
+/**
+ * @brief Borra el sistema de ficheros simulado (equivale a flashear una imagen vacia).
+ */
+void hal_fs_format();
+
+#endif // FAKE_HAL_H
@@ -0,0 +1,22 @@
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Subconjunto de la API de sockets de lwIP que usa el firmware: el descriptor es el de una
+// conexion de WiFiClient con el broker simulado o con un cliente del servidor HTTP simulado
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0x08
+#endif
+
+/**
+ * @brief Escribe en el buffer de envio de la conexion sin esperar.
+ *
+ * @return Bytes aceptados, o -1 con errno EAGAIN si el buffer esta lleno (ENOTCONN si la
+ * conexion esta cerrada).
+ */
+ssize_t lwip_send(int s, const void* data, size_t size, int flags);
+
+#endif // LWIP_SOCKETS_H
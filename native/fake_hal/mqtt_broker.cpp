@@ -0,0 +1,308 @@
+#include "mqtt_broker.h"
+#include "Arduino.h"
+#include "WiFi.h"
+#include "fake_hal.h"
+#include <stdio.h>
+#include <string.h>
+
+static HalMqttStats stats;
+
+// Enlace: bytes por ms que salen del buffer de envio (0: bloqueado), retardo de ida y vuelta
+// de las respuestas y tamaño del buffer de envio
+static uint32_t linkRate = 250;
+static uint32_t linkLatency = 8;
+static size_t linkBuffer = 2920;
+
+// Conexion abierta (-1 ninguna) y siguiente descriptor
+static int openFd = -1;
+static int nextFd = 3;
+static bool sessionUp = false;
+static unsigned long lastUpdate = 0;
+// Bytes que el enlace puede entregar ya: crece con el tiempo, hasta un buffer de envio
+static uint64_t linkCredit = 0;
+
+// Buffer de envio del nodo y paquetes recibidos a medias por el broker
+static uint8_t sendBuffer[8192];
+static size_t sendLen = 0;
+static uint8_t inbound[4096];
+static size_t inboundLen = 0;
+
+// Respuestas en camino: cada tramo llega en su instante
+static uint8_t replies[4096];
+static size_t repliesLen = 0;
+struct ReplyMark {
+  unsigned long readyAt;
+  size_t end;
+};
+static ReplyMark marks[64];
+static uint8_t markCount = 0;
+
+// Suscripcion de la sesion y unico mensaje retenido
+static char subscribed[64];
+static char retainedTopic[64];
+static char retainedPayload[256];
+static bool retainedPending = false;
+static uint16_t brokerPacketId = 1;
+
+void hal_mqtt_retain(const char* topic, const char* payload) {
+  snprintf(retainedTopic, sizeof(retainedTopic), "%s", topic);
+  snprintf(retainedPayload, sizeof(retainedPayload), "%s", payload);
+  retainedPending = true;
+}
+
+void hal_set_mqtt_link(uint32_t bytesPerMs, uint32_t latencyMs, size_t sendBufferSize) {
+  linkRate = bytesPerMs;
+  linkLatency = latencyMs;
+  linkBuffer = sendBufferSize < sizeof(sendBuffer) ? sendBufferSize : sizeof(sendBuffer);
+}
+
+const HalMqttStats& hal_mqtt_stats() {
+  return stats;
+}
+
+static void drop() {
+  openFd = -1;
+  sessionUp = false;
+  sendLen = 0;
+  inboundLen = 0;
+  repliesLen = 0;
+  markCount = 0;
+  subscribed[0] = '\0';
+}
+
+static void reply(const uint8_t* packet, size_t len) {
+  if (repliesLen + len > sizeof(replies) || markCount == sizeof(marks) / sizeof(marks[0])) {
+    // El nodo no lee: el broker cierra la conexion
+    drop();
+    return;
+  }
+  memcpy(replies + repliesLen, packet, len);
+  repliesLen += len;
+  marks[markCount].readyAt = millis() + linkLatency;
+  marks[markCount].end = repliesLen;
+  markCount++;
+}
+
+static void deliver_retained() {
+  // QoS 1, como lo entrega mosquitto a una suscripcion QoS 1; el PUBACK del nodo se ignora
+  size_t topicLen = strlen(retainedTopic);
+  size_t payloadLen = strlen(retainedPayload);
+  size_t restante = 2 + topicLen + 2 + payloadLen;
+  uint8_t paquete[sizeof(retainedTopic) + sizeof(retainedPayload) + 8];
+  size_t n = 0;
+  paquete[n++] = 0x32;
+  do {
+    uint8_t byte = restante % 128;
+    restante /= 128;
+    paquete[n++] = restante > 0 ? byte | 0x80 : byte;
+  } while (restante > 0);
+  paquete[n++] = topicLen >> 8;
+  paquete[n++] = topicLen & 0xFF;
+  memcpy(paquete + n, retainedTopic, topicLen);
+  n += topicLen;
+  paquete[n++] = brokerPacketId >> 8;
+  paquete[n++] = brokerPacketId & 0xFF;
+  brokerPacketId++;
+  memcpy(paquete + n, retainedPayload, payloadLen);
+  n += payloadLen;
+  reply(paquete, n);
+  retainedPending = false;
+}
+
+// Atiende un paquete completo del nodo. false si viola el protocolo
+static bool handle(const uint8_t* packet, size_t len, size_t body) {
+  uint8_t tipo = packet[0] >> 4;
+  if (!sessionUp && tipo != 1) {
+    return false;
+  }
+  switch (tipo) {
+    case 1: {
+      // CONNECT: sesion limpia
+      sessionUp = true;
+      subscribed[0] = '\0';
+      stats.connects++;
+      const uint8_t connack[4] = {0x20, 0x02, 0x00, 0x00};
+      reply(connack, sizeof(connack));
+      return true;
+    }
+    case 3: {
+      uint8_t qos = (packet[0] >> 1) & 0x03;
+      size_t topicLen = packet[body] << 8 | packet[body + 1];
+      size_t cabecera = 2 + topicLen + (qos > 0 ? 2 : 0);
+      if (body + cabecera > len) {
+        return false;
+      }
+      stats.published++;
+      stats.payloadBytes += len - body - cabecera;
+      stats.wireBytes += len;
+      if (packet[0] & 0x08) {
+        stats.duplicates++;
+      }
+      if (qos == 1) {
+        const uint8_t puback[4] = {0x40, 0x02, packet[body + 2 + topicLen], packet[body + 3 + topicLen]};
+        reply(puback, sizeof(puback));
+      }
+      return true;
+    }
+    case 8: {
+      // SUBSCRIBE de un unico topic
+      size_t topicLen = packet[body + 2] << 8 | packet[body + 3];
+      if (body + 4 + topicLen + 1 > len || topicLen >= sizeof(subscribed)) {
+        return false;
+      }
+      memcpy(subscribed, packet + body + 4, topicLen);
+      subscribed[topicLen] = '\0';
+      const uint8_t suback[5] = {0x90, 0x03, packet[body], packet[body + 1], packet[body + 4 + topicLen]};
+      reply(suback, sizeof(suback));
+      // Cada suscripcion recibe de nuevo el mensaje retenido
+      if (retainedTopic[0] != '\0') {
+        retainedPending = true;
+      }
+      return true;
+    }
+    case 12: {
+      const uint8_t pingresp[2] = {0xD0, 0x00};
+      reply(pingresp, sizeof(pingresp));
+      return true;
+    }
+    case 14:
+      drop();
+      return true;
+    default:
+      // PUBACK del mensaje retenido
+      return true;
+  }
+}
+
+// Avanza el enlace hasta el instante actual: el broker procesa lo que ha salido del buffer
+static void update() {
+  if (openFd < 0) {
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    // La conexion cae con la red
+    drop();
+    return;
+  }
+
+  unsigned long ahora = millis();
+  linkCredit += (uint64_t)(ahora - lastUpdate) * linkRate;
+  linkCredit = linkRate == 0 ? 0 : linkCredit < linkBuffer ? linkCredit : linkBuffer;
+  lastUpdate = ahora;
+  size_t salen = linkCredit < sendLen ? (size_t)linkCredit : sendLen;
+  if (salen > sizeof(inbound) - inboundLen) {
+    salen = sizeof(inbound) - inboundLen;
+  }
+  linkCredit -= salen;
+  memcpy(inbound + inboundLen, sendBuffer, salen);
+  memmove(sendBuffer, sendBuffer + salen, sendLen - salen);
+  sendLen -= salen;
+  inboundLen += salen;
+
+  size_t offset = 0;
+  while (openFd >= 0 && inboundLen - offset >= 2) {
+    size_t restante = 0;
+    size_t cabecera = 1;
+    uint32_t factor = 1;
+    bool completa = false;
+    while (offset + cabecera < inboundLen && cabecera <= 4) {
+      uint8_t byte = inbound[offset + cabecera++];
+      restante += (byte & 0x7F) * factor;
+      factor *= 128;
+      if (!(byte & 0x80)) {
+        completa = true;
+        break;
+      }
+    }
+    if (!completa || inboundLen - offset < cabecera + restante) {
+      if (cabecera + restante > sizeof(inbound)) {
+        drop();
+      }
+      break;
+    }
+    if (!handle(inbound + offset, cabecera + restante, cabecera)) {
+      drop();
+      break;
+    }
+    offset += cabecera + restante;
+  }
+  if (openFd < 0) {
+    return;
+  }
+  memmove(inbound, inbound + offset, inboundLen - offset);
+  inboundLen -= offset;
+
+  if (retainedPending && sessionUp && strcmp(subscribed, retainedTopic) == 0) {
+    deliver_retained();
+  }
+}
+
+int broker_open() {
+  update();
+  if (WiFi.status() != WL_CONNECTED) {
+    stats.refused++;
+    return -1;
+  }
+  drop();
+  openFd = nextFd++;
+  lastUpdate = millis();
+  linkCredit = 0;
+  return openFd;
+}
+
+bool broker_connected(int fd) {
+  update();
+  return fd >= 0 && fd == openFd;
+}
+
+size_t broker_writable(int fd) {
+  update();
+  return fd >= 0 && fd == openFd ? linkBuffer - sendLen : 0;
+}
+
+size_t broker_write(int fd, const uint8_t* data, size_t len) {
+  size_t libre = broker_writable(fd);
+  size_t n = len < libre ? len : libre;
+  memcpy(sendBuffer + sendLen, data, n);
+  sendLen += n;
+  // Con el enlace libre, lo escrito sale en el acto
+  update();
+  return n;
+}
+
+size_t broker_available(int fd) {
+  update();
+  if (fd < 0 || fd != openFd) {
+    return 0;
+  }
+  size_t listos = 0;
+  unsigned long ahora = millis();
+  for (uint8_t i = 0; i < markCount && (long)(ahora - marks[i].readyAt) >= 0; i++) {
+    listos = marks[i].end;
+  }
+  return listos;
+}
+
+size_t broker_read(int fd, uint8_t* buffer, size_t len) {
+  size_t listos = broker_available(fd);
+  size_t n = len < listos ? len : listos;
+  memcpy(buffer, replies, n);
+  memmove(replies, replies + n, repliesLen - n);
+  repliesLen -= n;
+  uint8_t quedan = 0;
+  for (uint8_t i = 0; i < markCount; i++) {
+    if (marks[i].end > n) {
+      marks[quedan].readyAt = marks[i].readyAt;
+      marks[quedan].end = marks[i].end - n;
+      quedan++;
+    }
+  }
+  markCount = quedan;
+  return n;
+}
+
+void broker_close(int fd) {
+  if (fd >= 0 && fd == openFd) {
+    drop();
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef MQTT_BROKER_H
+#define MQTT_BROKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+///////////////// BROKER MQTT SIMULADO \\\\\\\\\\\\\\\\\
+*/
+// Extremo remoto de la conexion TCP de WiFiClient: interpreta los paquetes MQTT 3.1.1 que
+// escribe el nodo y responde como el broker. Entre los dos hay un buffer de envio que el
+// enlace vacia a un ritmo fijo, y las respuestas llegan con el retardo de ida y vuelta (ver
+// hal_set_mqtt_link()). Solo hay una conexion: abrir otra cierra la anterior, y cae con la red.
+// Uso interno de la HAL simulada.
+
+/**
+ * @brief Abre una conexion con el broker.
+ *
+ * @return Descriptor de la conexion, o -1 sin red.
+ */
+int broker_open();
+
+/**
+ * @brief true mientras la conexion sigue abierta.
+ */
+bool broker_connected(int fd);
+
+/**
+ * @brief Escribe en el buffer de envio lo que quepa, sin esperar.
+ *
+ * @return Bytes aceptados.
+ */
+size_t broker_write(int fd, const uint8_t* data, size_t len);
+
+/**
+ * @brief Espacio libre en el buffer de envio.
+ */
+size_t broker_writable(int fd);
+
+/**
+ * @brief Bytes de las respuestas que ya han llegado.
+ */
+size_t broker_available(int fd);
+
+/**
+ * @brief Lee las respuestas que ya han llegado, sin esperar.
+ *
+ * @return Bytes leidos.
+ */
+size_t broker_read(int fd, uint8_t* buffer, size_t len);
+
+void broker_close(int fd);
+
+#endif // MQTT_BROKER_H
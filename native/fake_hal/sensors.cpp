@@ -0,0 +1,202 @@
+#include "DHT.h"
+#include "DallasTemperature.h"
+#include "fake_hal.h"
+#include <driver/rmt.h>
+
+// Lecturas que devuelven los sensores simulados
+static float probeValue = 18.5f;
+static float temperatureValue = 22.0f;
+static float humidityValue = 55.0f;
+
+void hal_set_sensors(float probe, float temperature, float humidity) {
+  probeValue = probe;
+  temperatureValue = temperature;
+  humidityValue = humidity;
+}
+
+bool DHT::read(bool force) {
+  // Una trama del DHT11 tarda unos 5 ms; el sensor no admite mas de una lectura cada 2 s
+  if (!force && valid && millis() - lastRead < 2000) {
+    return true;
+  }
+  // Señal de inicio y trama, con las interrupciones desactivadas en la libreria real
+  hal_advance(25);
+  lastRead = millis();
+  valid = true;
+  return true;
+}
+
+float DHT::readTemperature() {
+  read();
+  return temperatureValue;
+}
+
+float DHT::readHumidity() {
+  read();
+  return humidityValue;
+}
+
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+  switch (bits) {
+    case 9:
+      return 94;
+    case 10:
+      return 188;
+    case 11:
+      return 375;
+    default:
+      return 750;
+  }
+}
+
+void DallasTemperature::requestTemperatures() {
+  conversionStart = millis();
+  if (waitForConversion) {
+    delay(millisToWaitForConversion(resolution));
+  }
+}
+
+bool DallasTemperature::isConversionComplete() {
+  return millis() - conversionStart >= (unsigned long)millisToWaitForConversion(resolution);
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+  return index == 0 ? probeValue : DEVICE_DISCONNECTED_C;
+}
+
+/*
+///////////////// CANAL RMT CON UN DHT11 \\\\\\\\\\\\\\\\\
+*/
+// Ruido de los pulsos (+-us), cada cuantas tramas se corrompe un bit y numero de tramas
+static uint8_t dhtJitter = 4;
+static uint32_t dhtCorruptEvery = 0;
+static uint32_t dhtFrames = 0;
+static uint32_t dhtNoise = 12345;
+
+// Trama capturada: 84 pulsos en 42 elementos mas el de fin
+static rmt_item32_t dhtCapture[43];
+static bool dhtPending = false;
+static bool dhtDelivered = false;
+static unsigned long dhtStart = 0;
+static int dhtRingbuf = 0;
+
+// La trama completa dura unos 5 ms desde rmt_rx_start()
+static const unsigned long DHT_FRAME_MS = 5;
+
+void hal_set_dht(uint8_t jitterUs, uint32_t corruptEvery) {
+  dhtJitter = jitterUs;
+  dhtCorruptEvery = corruptEvery;
+}
+
+static uint16_t jittered(uint16_t us) {
+  dhtNoise = dhtNoise * 1103515245u + 12345u;
+  int32_t ruido = dhtJitter == 0 ? 0 : (int32_t)((dhtNoise >> 16) % (2 * dhtJitter + 1)) - dhtJitter;
+  return (uint16_t)(us + ruido);
+}
+
+// Codifica las lecturas simuladas como el DHT11: parte entera y decimas
+static void dht11_bytes(uint8_t data[5]) {
+  int32_t humedad = humidityValue < 0 ? 0 : (int32_t)(humidityValue * 10 + 0.5f);
+  data[0] = (uint8_t)(humedad / 10);
+  data[1] = (uint8_t)(humedad % 10);
+  if (temperatureValue >= 0) {
+    int32_t decimas = (int32_t)(temperatureValue * 10 + 0.5f);
+    data[2] = (uint8_t)(decimas / 10);
+    data[3] = (uint8_t)(decimas % 10);
+  } else {
+    // Bajo cero: la parte entera va desplazada en uno y el bit alto de las decimas es el signo
+    int32_t decimas = (int32_t)(-temperatureValue * 10 + 0.5f);
+    data[2] = (uint8_t)((decimas - 1) / 10);
+    data[3] = 0x80 | (uint8_t)((data[2] + 1) * 10 - decimas);
+  }
+  data[4] = (uint8_t)(data[0] + data[1] + data[2] + data[3]);
+}
+
+static void put_pulse(uint16_t index, uint8_t level, uint16_t us) {
+  rmt_item32_t& item = dhtCapture[index / 2];
+  if (index % 2 == 0) {
+    item.duration0 = us;
+    item.level0 = level;
+  } else {
+    item.duration1 = us;
+    item.level1 = level;
+  }
+}
+
+esp_err_t rmt_config(const rmt_config_t* config) {
+  (void)config;
+  return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+  (void)channel;
+  (void)rx_buf_size;
+  (void)intr_alloc_flags;
+  return ESP_OK;
+}
+
+esp_err_t rmt_get_ringbuf_handle(rmt_channel_t channel, RingbufHandle_t* buf_handle) {
+  (void)channel;
+  *buf_handle = &dhtRingbuf;
+  return ESP_OK;
+}
+
+esp_err_t rmt_rx_start(rmt_channel_t channel, bool rx_idx_rst) {
+  (void)channel;
+  (void)rx_idx_rst;
+  uint8_t data[5];
+  dht11_bytes(data);
+  dhtFrames++;
+  if (dhtCorruptEvery > 0 && dhtFrames % dhtCorruptEvery == 0) {
+    data[dhtFrames % 4] ^= 0x10;
+  }
+
+  // Final del nivel alto de la liberacion, respuesta (80 us bajo y 80 us alto), 40 bits,
+  // pulso bajo final y fin de captura (duracion 0) al quedar la linea en reposo
+  uint16_t pulso = 0;
+  put_pulse(pulso++, 1, jittered(20));
+  put_pulse(pulso++, 0, jittered(80));
+  put_pulse(pulso++, 1, jittered(80));
+  for (uint8_t bit = 0; bit < 40; bit++) {
+    put_pulse(pulso++, 0, jittered(50));
+    put_pulse(pulso++, 1, jittered((data[bit / 8] >> (7 - bit % 8)) & 1 ? 70 : 27));
+  }
+  put_pulse(pulso++, 0, jittered(50));
+  put_pulse(pulso++, 1, 0);
+  dhtPending = true;
+  dhtStart = millis();
+  return ESP_OK;
+}
+
+esp_err_t rmt_rx_stop(rmt_channel_t channel) {
+  (void)channel;
+  dhtPending = false;
+  return ESP_OK;
+}
+
+void* xRingbufferReceive(RingbufHandle_t handle, size_t* item_size, TickType_t ticks) {
+  (void)handle;
+  if (!dhtPending || dhtDelivered) {
+    hal_advance(ticks);
+    return nullptr;
+  }
+  // La captura llega al terminar la trama; hasta entonces se espera como mucho ticks ms
+  if (millis() - dhtStart < DHT_FRAME_MS) {
+    unsigned long falta = DHT_FRAME_MS - (millis() - dhtStart);
+    if (ticks < falta) {
+      hal_advance(ticks);
+      return nullptr;
+    }
+    hal_advance(falta);
+  }
+  dhtDelivered = true;
+  *item_size = sizeof(dhtCapture);
+  return dhtCapture;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t handle, void* item) {
+  (void)handle;
+  (void)item;
+  dhtDelivered = false;
+  dhtPending = false;
+}
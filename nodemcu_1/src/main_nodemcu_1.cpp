@@ -1,15 +1,26 @@
 /*
 ///////////////// IMPORTACION DE MODULOS \\\\\\\\\\\\\\\\\
 */
-#include <ArduinoJson.h>
-#include <PubSubClient.h> // ofrece una interfaz MQTT
-#include <Adafruit_Sensor.h> //permite leer sensores a traves de distintas plataformas y librerias
-#include <DHT.h> // permite leer datos del sensor DHT11
-
-#include "main.h"
-#include "led/rgb.h"
-#include "wifi/wifi.h"
-#include "mqtt/mqtt.h"
+#include <scheduler.h> // planificador cooperativo de tareas periodicas
+#include <sample.h> // lectura de todos los sensores del nodo
+#include <payload.h> // codificacion de los mensajes (binario compacto o JSON)
+#include <sample_batch.h> // agrupacion de varias lecturas en un unico mensaje
+#include <report_policy.h> // envio por cambio (banda muerta) con latido
+#include <window_stats.h> // resumen por ventana en lugar de cada lectura
+#include <LittleFS.h> // sistema de ficheros con la calibracion del sensor de humedad
+#include <acquisition.h> // motor de adquisicion comun a los nodos
+#include <board.h> // pines y constantes de la placa
+#include <sensor_set.h> // drivers de los sensores del nodo
+#include <sensor_dht11.h>
+#include <sensor_soil.h>
+#include <boot_timeline.h> // instantes de cada fase del arranque
+#include <rgb.h> // LED RGB
+#include <node_wifi.h> // conexion WiFi comun a todos los nodos
+#include <node_mqtt.h> // conexion MQTT y cola persistente comunes a todos los nodos
+#include <node_metrics.h> // contadores e histogramas del camino critico, expuestos en /metrics
+#include <node_time.h> // hora UTC por SNTP con correccion de deriva
+#include <adaptive_sampler.h> // periodo de muestreo adaptativo
+#include <node_config.h> // configuracion remota por MQTT
 
 /*
 ///////////////// ASIGNACION DE VALORES \\\\\\\\\\\\\\\\\
@@ -26,123 +37,308 @@ const char* mqtt_server = "192.168.1.70";
 const int mqtt_port = 1883;
 const char* mqtt_topic_params = "nodemcu_1/params";
 const char* mqtt_topic_coverage = "nodemcu_1/coverage";
+const char* mqtt_topic_link = "nodemcu_1/link";
+const char* mqtt_topic_boot = "nodemcu_1/boot";
+const char* mqtt_topic_summary = "nodemcu_1/summary";
+const char* mqtt_topic_config = "nodemcu_1/config";
+const char* mqtt_topic_sampler = "nodemcu_1/sampler";
+
+// servidor NTP de la red local (la Raspberry, junto al broker)
+const char* ntp_server = "192.168.1.70";
 
-// Variable para almacenar el tiempo anterior
-unsigned long tiempoAnterior = 0;
 // Intervalo de tiempo deseado para "Intensidad de señal"
 // Cada 10s se monitoriza la intensidad de la señal
 const unsigned long intervalo = 60000;
 
-// configura los pines del sensor DHT11 //
-const int DHTTYPE = DHT11;
-const int DHTPIN = D4;
-DHT dht(DHTPIN, DHTTYPE);
+// periodo inicial de muestreo y publicacion de los sensores (despues lo ajusta el muestreo adaptativo)
+const unsigned long periodoMuestreo = 30000;
+// periodo de supervision de las conexiones WiFi y MQTT
+const unsigned long periodoSupervision = 250;
+// periodo de consulta de peticiones al servidor de metricas
+const unsigned long periodoMetricas = 200;
+// periodo de servicio del socket MQTT: envio del anillo de salida, PUBACK y keepalive
+const unsigned long periodoMqtt = 50;
 
-// Pin analógico conectado al sensor de humedad del suelo (ejemplo: GPIO32)
-const int analogPin = A0;
-// Calibracion del sensor capacitivo: Aire-Agua
-const int HumedityMin = 257;
-const int Humeditymax = 646;
+// sensores del nodo: DHT11 y sensor capacitivo de humedad del suelo, sin sonda DS18B20.
+// los pines y la calibracion por defecto estan en NodeMcuBoard (board.h)
+typedef SensorSet<Dht11Sensor<Board>, SoilSensor<Board>> Sensores;
+constexpr SensorDrivers sensores = Sensores::drivers();
 
-// configura los pines del LED RGB //
-const int pinRojo = D7;
-const int pinVerde = D6;
-const int pinAzul = D5;
+// ultima lectura de los sensores, pendiente de publicar
+SensorSample ultimaLectura;
+bool lecturaPendiente = false;
+// lecturas acumuladas hasta completar el lote
+SampleBatch lote;
+// politica de envio de cada canal
+ReportPolicy politica;
+// motor de adquisicion de los sensores
+Acquisition adquisicion;
+// estadisticos de la ventana en curso (PUBLISH_RAW_SAMPLES publica las lecturas en su lugar)
+WindowStats ventana;
+// periodo de muestreo adaptativo y configuracion recibida por MQTT
+AdaptiveSampler muestreo;
+NodeConfig configuracion;
+Task* tareaMuestreo = nullptr;
+Task* tareaPublicacion = nullptr;
+Task* tareaCobertura = nullptr;
+// reloj sincronizado con el que se fechan las lecturas
+SyncClock reloj;
 
 /*
 ///////////////// DECLARACION DE FUNCIONES \\\\\\\\\\\\\\\\\
 */
-void setup() {
-  // configura el serial monitor
-  Serial.begin(9600);
-
-  // configura el LED RGB para que se pueda escribir
-  pinMode(pinRojo, OUTPUT);
-  pinMode(pinAzul, OUTPUT);
-  pinMode(pinVerde, OUTPUT);
-
-  // apaga desde un inicio el LED RGB
-  turnOffLED(pinRojo, pinVerde, pinAzul);
-
-  // configura el LED del nodemcu para que se pueda escribir
-  pinMode(LED_BUILTIN, OUTPUT);
+void tarea_red() {
+  // supervisa la red WiFi y la sesion MQTT sin bloquear
+  wifi_supervise();
+  // sincroniza el reloj cuando toca (un intercambio SNTP de pocos ms en la red local)
+  time_sync_poll();
+  if (!mqtt_is_connected()) {
+    return;
+  }
 
-  // inicia el sensor DHT11
-  dht.begin();
+  // se publica el estado del enlace tras cada conexion con el broker
+  static uint32_t conexionesPublicadas = 0;
+  if (conexion.stats.mqttConnects != conexionesPublicadas) {
+    conexionesPublicadas = conexion.stats.mqttConnects;
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_link(conexion.stats, payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_link, payload, len);
+  }
 
-  // conecta a la red wifi local
-  setup_wifi(ssid, password, ip, gateway, subnet);
+  // tiempos del arranque, una sola vez tras la primera publicacion
+  static bool arranquePublicado = false;
+  if (!arranquePublicado && boot_complete()) {
+    arranquePublicado = true;
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    size_t len = payload_encode_boot(boot_timeline(), payload, sizeof(payload));
+    mqtt_publish(mqtt_topic_boot, payload, len);
+  }
+}
 
-  // configura el servidor mqtt para enviar datos
-  mqtt_init(mqtt_server, mqtt_port);
+void publicar_muestreo() {
+  // estado del muestreo adaptativo: la frecuencia efectiva es lecturas / tiempo_s
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_sampler(muestreo, millis(), payload, sizeof(payload));
+  mqtt_publish(mqtt_topic_sampler, payload, len);
+}
 
+void aplicar_periodo() {
+  // la publicacion sigue al muestreo con su mismo periodo
+  metricas.periodoMuestreo = muestreo.period;
+  if (tareaMuestreo != nullptr && tareaPublicacion != nullptr) {
+    scheduler_set_period(tareaMuestreo, muestreo.period);
+    scheduler_set_period(tareaPublicacion, muestreo.period);
+  }
+  publicar_muestreo();
 }
 
-void loop() {
+void aplicar_configuracion(const NodeConfig& config) {
+  // configuracion nueva recibida por MQTT, ya guardada en flash
+  sampler_configure(&muestreo, config.sampler);
+  if (tareaCobertura != nullptr) {
+    scheduler_set_period(tareaCobertura, config.coveragePeriod);
+  }
+  aplicar_periodo();
+}
 
-  // comprueba si esta conectado o no
-  mqtt_is_connected();
+Task* agregar_tarea(const char* nombre, TaskCallback funcion, unsigned long periodo, unsigned long presupuesto,
+                    unsigned long desfase = 0) {
+  // registra la tarea y avisa si el planificador no tiene hueco: la tarea no se ejecutaria
+  Task* tarea = scheduler_add(nombre, funcion, periodo, presupuesto, desfase);
+  if (tarea == nullptr) {
+    Serial.print("Sin hueco en el planificador para la tarea ");
+    Serial.print(nombre);
+    Serial.println(": aumentar SCHEDULER_MAX_TASKS");
+  }
+  return tarea;
+}
 
-  turnOffLED(pinRojo, pinVerde, pinAzul);
-  commandLED(1023, 0, 1023, pinRojo, pinVerde, pinAzul);
-  digitalWrite(LED_BUILTIN, LOW);
-  // lee la temperatura del sensor
-  float temperatureDHT = dht.readTemperature();
+void tarea_reenvio() {
+  // reenvia las lecturas guardadas mientras no habia conexion
+  mqtt_drain();
+}
 
-  // lee la humedad del sensor
-  float humidityDHT = dht.readHumidity();
-  digitalWrite(LED_BUILTIN, HIGH);
+void tarea_muestreo() {
+  // sin sonda DS18B20 la adquisicion termina en la primera consulta
+  turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  commandLED(1023, 0, 1023, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  acquisition_start(&adquisicion);
+  if (!acquisition_poll(&adquisicion)) {
+    return;
+  }
+  ultimaLectura = adquisicion.sample;
+  commandLED(0, 20, 0, Board::pinRojo, Board::pinVerde, Board::pinAzul);
+  metrics_observe(&metricas.lectura, adquisicion.lastDuration * 1000UL);
+  metrics_count(&metricas.lecturas);
+  lecturaPendiente = true;
 
-  // Lectura de la humedad del suelo
-  int sensorValue = analogRead(analogPin);
-  int humidityCapacitor = 100 - map(sensorValue, HumedityMin, Humeditymax, 0, 100);
-  // Conversión a voltaje (rango de 0 a 3.3V)
-  float voltage = sensorValue * (3.3 / 1023.0);
-  commandLED(0, 20, 0, pinRojo, pinVerde, pinAzul);
+  // ajusta el periodo a la velocidad de cambio de las lecturas
+  if (sampler_update(&muestreo, ultimaLectura)) {
+    aplicar_periodo();
+  }
 
   // Serial.print("Temperatura: ");
-  // Serial.print(temperatureDHT);
+  // Serial.print(ultimaLectura.temperatureDHT);
   // Serial.print(" °C, Humedad: ");
-  // Serial.print(humidityDHT);
+  // Serial.print(ultimaLectura.humidityDHT);
   // Serial.println(" %");
 
   // Serial.print("% humedad: ");
-  // Serial.print(humidityCapacitor);
-  // Serial.print("%");
-  // Serial.print(", Voltaje: ");
-  // Serial.print(voltage, 2);
-  // Serial.println("V");
+  // Serial.print(ultimaLectura.humidityCapacitor);
+  // Serial.println("%");
 
-  // usa el formato json para enviar datos
-  StaticJsonDocument<64> params;
-  params["temperatura_dht"] = temperatureDHT;
-  params["humedad_dht"] = humidityDHT;
-  params["humedad_capacitor"] = humidityCapacitor;
+  // Serial.print("Tiempo de adquisicion: ");
+  // Serial.print(adquisicion.lastDuration);
+  // Serial.println(" ms");
+}
 
-  String jsonStringParams;
-  serializeJson(params, jsonStringParams);
+#ifdef PUBLISH_RAW_SAMPLES
+void tarea_lotes() {
+  // se publica cuando el lote esta completo o la lectura mas antigua es demasiado vieja. tambien
+  // corre como tarea periodica: si la politica de envio descarta las lecturas siguientes el
+  // lote no se revisaria al vencer BATCH_MAX_LATENCY
+  uint32_t ahora = millis();
+  if (!batch_ready(&lote, ahora)) {
+    return;
+  }
 
-  // publica los datos mediante protocolo MQTT
-  client.publish(mqtt_topic_params, (char*)jsonStringParams.c_str());
+  // buffer estatico: un lote completo no cabe con holgura en la pila del loop
+  static uint8_t payload[PAYLOAD_BATCH_MAX_SIZE];
+  uint32_t inicio = micros();
+  size_t len = batch_encode(&lote, ahora, &time_clock(), payload, sizeof(payload));
+  metrics_observe(&metricas.serializacion, micros() - inicio);
 
-  if (millis() - tiempoAnterior >= intervalo) {
-    tiempoAnterior = millis();
+  // publica los datos mediante protocolo MQTT; sin conexion se guarda en la cola persistente
+  mqtt_publish(mqtt_topic_params, payload, len);
+  batch_clear(&lote);
+}
+#endif
 
-    int rssi = WiFi.RSSI();
-    // Serial.print("Intensidad de señal: ");
-    // Serial.print(rssi);
-    // Serial.println(" dBm");
+void tarea_publicacion() {
+  if (!lecturaPendiente) {
+    return;
+  }
+  lecturaPendiente = false;
 
-    StaticJsonDocument<64> coverage;
-    coverage["dBm"] = rssi;
+#ifndef PUBLISH_RAW_SAMPLES
+  // la lectura se acumula en la ventana; tarea_resumen() publica al cerrarla
+  stats_add(&ventana, ultimaLectura);
+#else
+  // solo entran en el lote los canales que han cambiado o cuyo latido ha vencido
+  SensorSample lectura = ultimaLectura;
+  if (report_filter(&politica, lectura)) {
+    batch_add(&lote, lectura);
+  }
 
-    String jsonStringCoverage;
-    serializeJson(coverage, jsonStringCoverage);
+  tarea_lotes();
+#endif
+}
 
-    // publica los datos mediante protocolo MQTT
-    client.publish(mqtt_topic_coverage, (char*)jsonStringCoverage.c_str());
+void tarea_resumen() {
+  // cierra la ventana en curso y publica un unico mensaje con sus estadisticos
+  uint32_t ahora = millis();
+  if (stats_has_data(&ventana)) {
+    uint8_t payload[PAYLOAD_MAX_SIZE];
+    uint32_t inicio = micros();
+    size_t len = payload_encode_summary(ventana, ahora - ventana.start, time_epoch(ahora), payload, sizeof(payload));
+    metrics_observe(&metricas.serializacion, micros() - inicio);
+    mqtt_publish(mqtt_topic_summary, payload, len);
   }
+  stats_reset(&ventana, ahora);
+}
 
-  // espera 30 segundos
-  delay(30000);
+void tarea_cobertura() {
+  if (!mqtt_connected()) {
+    return;
+  }
+
+  int rssi = WiFi.RSSI();
+  // Serial.print("Intensidad de señal: ");
+  // Serial.print(rssi);
+  // Serial.println(" dBm");
+
+  // la cobertura solo se publica si cambia mas que su banda muerta o vence el latido
+  if (!report_channel_due(&politica.channels[CAMPO_DBM], rssi, millis())) {
+    return;
+  }
+
+  uint8_t payload[PAYLOAD_MAX_SIZE];
+  size_t len = payload_encode_coverage(rssi, payload, sizeof(payload));
+
+  // publica los datos mediante protocolo MQTT
+  mqtt_publish(mqtt_topic_coverage, payload, len);
+}
+
+void setup() {
+  // configura el serial monitor
+  Serial.begin(9600);
+
+  // configura el LED RGB para que se pueda escribir
+  pinMode(Board::pinRojo, OUTPUT);
+  pinMode(Board::pinAzul, OUTPUT);
+  pinMode(Board::pinVerde, OUTPUT);
+
+  // apaga desde un inicio el LED RGB
+  turnOffLED(Board::pinRojo, Board::pinVerde, Board::pinAzul);
+
+  // monta el sistema de ficheros con la calibracion propia del sensor de humedad del suelo
+  LittleFS.begin();
+
+  // inicia los sensores del nodo
+  Sensores::begin();
+  boot_mark(ARRANQUE_SENSORES, millis());
+
+  // conecta a la red wifi local
+  setup_wifi(ssid, password, ip, gateway, subnet);
+
+  // configura el servidor mqtt para enviar datos
+  mqtt_init(mqtt_server, mqtt_port);
+
+  // hora UTC por SNTP: la primera consulta se hace en cuanto hay WiFi
+  sync_clock_init(&reloj);
+  time_sync_begin(ntp_server, &reloj, millis);
+
+  // configuracion guardada y suscripcion a la configuracion remota (mensaje retenido)
+  configuracion.sampler = sampler_default_config();
+  configuracion.coveragePeriod = intervalo;
+  node_config_begin(mqtt_topic_config, &configuracion, aplicar_configuracion);
+  sampler_init(&muestreo, configuracion.sampler, periodoMuestreo, millis());
+  metricas.periodoMuestreo = muestreo.period;
+
+  // servidor HTTP con las metricas del nodo para Prometheus
+  metrics_server_begin();
+
+  // agrupa BATCH_SIZE lecturas por mensaje
+  batch_init(&lote, BATCH_SIZE, BATCH_MAX_LATENCY);
+
+  // motor de adquisicion con los sensores del nodo
+  acquisition_init(&adquisicion, &sensores, millis);
+
+  // politica de envio por cambio con los umbrales por defecto
+  report_init(&politica);
+
+  // primera ventana de estadisticos
+  stats_reset(&ventana, millis());
+
+  // registra las tareas periodicas: nombre, funcion, periodo, presupuesto y desfase
+  scheduler_init(millis);
+  agregar_tarea("red", tarea_red, periodoSupervision, 50);
+  agregar_tarea("mqtt", mqtt_poll, periodoMqtt, 20);
+  tareaMuestreo = agregar_tarea("muestreo", tarea_muestreo, muestreo.period, 100);
+  tareaPublicacion = agregar_tarea("publicacion", tarea_publicacion, muestreo.period, 100, 1000);
+  tareaCobertura = agregar_tarea("cobertura", tarea_cobertura, configuracion.coveragePeriod, 50);
+  agregar_tarea("reenvio", tarea_reenvio, 1000, 200);
+  agregar_tarea("metricas", metrics_server_poll, periodoMetricas, 100);
+#ifndef PUBLISH_RAW_SAMPLES
+  agregar_tarea("resumen", tarea_resumen, STATS_WINDOW, 50, STATS_WINDOW);
+#else
+  agregar_tarea("lotes", tarea_lotes, 1000, 50);
+#endif
+}
+
+void loop() {
+  // ejecuta la tarea mas urgente y cede la CPU hasta el siguiente deadline
+  unsigned long idle = scheduler_run();
+  metrics_observe_loop();
+  delay(idle);
 }
\ No newline at end of file
@@ -0,0 +1,369 @@
+"""
+Decodificacion de los mensajes publicados por los nodos. Acepta tanto el formato
+JSON como el formato binario compacto (lib/payload en el firmware).
+"""
+import json
+import struct
+
+# Primer byte de un mensaje binario: marca (0xB0) y version del formato (1)
+PAYLOAD_BINARY_V1 = 0xB1
+
+# Tipos de mensaje binario
+PAYLOAD_TYPE_BATCH = 3
+PAYLOAD_TYPE_LINK = 4
+PAYLOAD_TYPE_BOOT = 5
+PAYLOAD_TYPE_SUMMARY = 6
+PAYLOAD_TYPE_SAMPLER = 7
+PAYLOAD_TYPE_GORILLA = 8
+
+# Codificacion de los valores de un lote comprimido (GorillaMode en lib/gorilla/gorilla.h)
+GORILLA_QUANTIZED = 0
+GORILLA_XOR = 1
+
+# Bit de la mascara que indica que el mensaje lleva la hora UTC de la adquisicion (uint64, ms)
+# en lecturas, lotes y resumenes; en ellos el nodo tiene el reloj sincronizado por SNTP
+BIT_INSTANTE = 6
+
+# Edad (s, o ms en los lotes) de un mensaje guardado por el nodo en un arranque anterior sin la
+# hora UTC: no se sabe cuando se tomo (PAYLOAD_AGE_UNKNOWN en lib/payload/payload.h)
+EDAD_DESCONOCIDA = 0xFFFFFFFF
+
+# Instante de las lecturas sin fecha conocida en decode_points
+SIN_FECHA = -1
+
+# Canales de un lote en el orden de la mascara: (nombre, escala)
+CANALES_LOTE = [
+    ("temperatura_sonda", 10),
+    ("temperatura_dht", 10),
+    ("humedad_capacitor", 1),
+    ("humedad_dht", 10),
+]
+
+# Campos del formato binario en el orden en que se escriben: (bit, nombre, formato, escala)
+CAMPOS_V1 = [
+    (0, "temperatura_sonda", "<h", 10),
+    (1, "temperatura_dht", "<h", 10),
+    (2, "humedad_capacitor", "<h", 1),
+    (3, "humedad_dht", "<h", 10),
+    (4, "dBm", "<h", 1),
+    (6, "ts", "<Q", 1),
+    (7, "edad", "<I", 1),
+]
+
+# Campos del mensaje de estado del enlace (contadores de la conexion WiFi y MQTT)
+CAMPOS_ENLACE = [
+    (0, "conexiones", "<I", 1),
+    (1, "perdidas", "<I", 1),
+    (2, "intentos", "<I", 1),
+    (3, "fallos", "<I", 1),
+    (4, "perdidas_wifi", "<I", 1),
+    (5, "reintentos_wifi", "<I", 1),
+    (6, "latencia_ms", "<I", 1),
+    (7, "edad", "<I", 1),
+]
+
+# Campos del mensaje de tiempos del arranque (ms desde el arranque y modo de asociacion WiFi)
+CAMPOS_ARRANQUE = [
+    (0, "sensores_ms", "<I", 1),
+    (1, "wifi_ms", "<I", 1),
+    (2, "mqtt_ms", "<I", 1),
+    (3, "publicacion_ms", "<I", 1),
+    (4, "modo_wifi", "<I", 1),
+    (7, "edad", "<I", 1),
+]
+
+# Campos del mensaje del muestreo adaptativo (periodo actual, lecturas y segundos desde el
+# arranque, y limites del periodo)
+CAMPOS_MUESTREO = [
+    (0, "periodo_ms", "<I", 1),
+    (1, "lecturas", "<I", 1),
+    (2, "tiempo_s", "<I", 1),
+    (3, "periodo_min_ms", "<I", 1),
+    (4, "periodo_max_ms", "<I", 1),
+    (7, "edad", "<I", 1),
+]
+
+# Tabla de campos de cada tipo de mensaje binario (por defecto, lecturas y cobertura)
+CAMPOS_POR_TIPO = {
+    PAYLOAD_TYPE_LINK: CAMPOS_ENLACE,
+    PAYLOAD_TYPE_BOOT: CAMPOS_ARRANQUE,
+    PAYLOAD_TYPE_SAMPLER: CAMPOS_MUESTREO,
+}
+
+
+def decode_points(payload: bytes, ahora: int) -> list:
+    """
+    Convierte el payload recibido en una lista de lecturas. Un mensaje individual produce
+    una sola lectura; un lote produce una lectura por cada muestra.
+
+    :param payload: Contenido del mensaje MQTT.
+    :type payload: bytes
+    :param ahora: Hora de recepcion en ms desde la epoca Unix, para fechar las lecturas que
+        solo indican su edad.
+    :type ahora: int
+    :return: Lista de tuplas (instante_ms, campos). instante_ms es la hora UTC de la adquisicion
+        en ms, None si la lectura es en tiempo real y se fecha al recibirla, o SIN_FECHA si es
+        diferida y no se sabe cuando se tomo.
+    :rtype: list[tuple[int | None, dict]]
+    """
+    if len(payload) > 1 and payload[0] == PAYLOAD_BINARY_V1 and payload[1] == PAYLOAD_TYPE_BATCH:
+        return _decode_binary_batch(payload, ahora)
+    if len(payload) > 1 and payload[0] == PAYLOAD_BINARY_V1 and payload[1] == PAYLOAD_TYPE_GORILLA:
+        return _decode_binary_gorilla(payload, ahora)
+
+    value = decode(payload)
+    if "t0" in value or "dt" in value:
+        return _expand_json_batch(value, ahora)
+
+    # Los nodos con el reloj sincronizado indican en "ts" la hora de la adquisicion; las
+    # lecturas diferidas de los demas, en "edad", los segundos transcurridos desde ella
+    instante = value.pop("ts", None)
+    edad = value.pop("edad", None)
+    if instante is not None:
+        return [(int(instante), value)]
+    if edad is None:
+        return [(None, value)]
+    if int(edad) == EDAD_DESCONOCIDA:
+        return [(SIN_FECHA, value)]
+    return [(ahora - int(float(edad) * 1000), value)]
+
+
+def decode(payload: bytes) -> dict:
+    """
+    Convierte el payload recibido en un diccionario {campo: valor}.
+
+    :param payload: Contenido del mensaje MQTT.
+    :type payload: bytes
+    :return: Diccionario con los campos presentes en el mensaje.
+    :rtype: dict
+    """
+    if payload and payload[0] == PAYLOAD_BINARY_V1:
+        if len(payload) > 1 and payload[1] == PAYLOAD_TYPE_SUMMARY:
+            return _decode_binary_summary(payload)
+        return _decode_binary_v1(payload)
+
+    # '{"temperatura":29.79999924,"humedad":48}' -> {"temperatura":29.79999924,"humedad":48}
+    return json.loads(payload.decode())
+
+
+def _decode_binary_v1(payload: bytes) -> dict:
+    """Decodifica un mensaje binario version 1: marca, tipo, mascara y campos presentes"""
+    if len(payload) < 3:
+        raise ValueError(f"Mensaje binario incompleto: {payload!r}")
+
+    mascara = payload[2]
+    posicion = 3
+    value = {}
+    campos = CAMPOS_POR_TIPO.get(payload[1], CAMPOS_V1)
+    for bit, nombre, formato, escala in campos:
+        if not mascara & (1 << bit):
+            continue
+        (valor,) = struct.unpack_from(formato, payload, posicion)
+        posicion += struct.calcsize(formato)
+        value[nombre] = valor / escala if escala != 1 else valor
+    return value
+
+
+def _decode_binary_summary(payload: bytes) -> dict:
+    """
+    Decodifica el resumen de una ventana: duracion y, por canal, numero de lecturas, minimo,
+    maximo, media y desviacion tipica (estas dos con un decimal mas que el canal)
+    """
+    mascara = payload[2]
+    (ventana,) = struct.unpack_from("<I", payload, 3)
+    posicion = 7
+    value = {"ventana_ms": ventana}
+    for canal, (nombre, escala) in enumerate(CANALES_LOTE):
+        if not mascara & (1 << canal):
+            continue
+        n, minimo, maximo, media, desviacion = struct.unpack_from("<HhhhH", payload, posicion)
+        posicion += 10
+        value[f"{nombre}_n"] = n
+        value[f"{nombre}_min"] = minimo / escala
+        value[f"{nombre}_max"] = maximo / escala
+        value[f"{nombre}_media"] = media / (escala * 10)
+        value[f"{nombre}_desv"] = desviacion / (escala * 10)
+    if mascara & (1 << BIT_INSTANTE):
+        (value["ts"],) = struct.unpack_from("<Q", payload, posicion)
+        posicion += 8
+    if mascara & 0x80:
+        (value["edad"],) = struct.unpack_from("<I", payload, posicion)
+    return value
+
+
+def _read_varint(payload: bytes, posicion: int) -> tuple:
+    """Lee un entero de longitud variable (7 bits por byte)"""
+    valor = 0
+    desplazamiento = 0
+    while True:
+        byte = payload[posicion]
+        posicion += 1
+        valor |= (byte & 0x7F) << desplazamiento
+        desplazamiento += 7
+        if not byte & 0x80:
+            return valor, posicion
+
+
+def _decode_binary_batch(payload: bytes, ahora: int) -> list:
+    """Decodifica un lote binario: tiempos y valores codificados como diferencias"""
+    mascara = payload[2]
+    n = payload[3]
+    if mascara & (1 << BIT_INSTANTE):
+        (instante,) = struct.unpack_from("<Q", payload, 4)
+        posicion = 12
+    else:
+        (edad,) = struct.unpack_from("<I", payload, 4)
+        instante = SIN_FECHA if edad == EDAD_DESCONOCIDA else ahora - edad
+        posicion = 8
+
+    # Hora de cada lectura a partir de la de la primera y de las diferencias de tiempo
+    instantes = [instante]
+    for _ in range(n - 1):
+        delta, posicion = _read_varint(payload, posicion)
+        instantes.append(SIN_FECHA if instante == SIN_FECHA else instantes[-1] + delta)
+
+    lecturas = [{} for _ in range(n)]
+    mapa_bytes = (n + 7) // 8
+    for canal, (nombre, escala) in enumerate(CANALES_LOTE):
+        if not mascara & (1 << canal):
+            continue
+        presentes = payload[posicion : posicion + mapa_bytes]
+        posicion += mapa_bytes
+
+        valor = None
+        for i in range(n):
+            if not presentes[i // 8] & (1 << (i % 8)):
+                continue
+            if valor is None:
+                (valor,) = struct.unpack_from("<h", payload, posicion)
+                posicion += 2
+            else:
+                zigzag, posicion = _read_varint(payload, posicion)
+                valor += (zigzag >> 1) ^ -(zigzag & 1)
+            lecturas[i][nombre] = valor / escala if escala != 1 else valor
+
+    return list(zip(instantes, lecturas))
+
+
+class _BitReader:
+    """Flujo de bits de lib/gorilla: el bit mas significativo de cada byte primero"""
+
+    def __init__(self, data: bytes) -> None:
+        self.data = data
+        self.posicion = 0
+
+    def get(self, n: int) -> int:
+        if self.posicion + n > len(self.data) * 8:
+            raise ValueError("Lote comprimido incompleto")
+        valor = 0
+        for _ in range(n):
+            byte = self.data[self.posicion >> 3]
+            valor = valor << 1 | (byte >> (7 - (self.posicion & 7))) & 1
+            self.posicion += 1
+        return valor
+
+
+def _unzigzag(valor: int) -> int:
+    return (valor >> 1) ^ -(valor & 1)
+
+
+def _read_dod(bits: _BitReader) -> int:
+    """Diferencia de la diferencia de tiempo: codigo 0, 10, 110, 1110 o 1111 y su zigzag"""
+    if not bits.get(1):
+        return 0
+    for longitud in (7, 9, 12):
+        if not bits.get(1):
+            return _unzigzag(bits.get(longitud))
+    dod = bits.get(32)
+    return dod - (1 << 32) if dod & 0x80000000 else dod
+
+
+def _read_integer(bits: _BitReader) -> int:
+    """0 si no cambia; 1 y zigzag - 1 en grupos de 3 bits con bit de continuacion"""
+    if not bits.get(1):
+        return 0
+    valor = 0
+    desplazamiento = 0
+    while True:
+        grupo = bits.get(4)
+        valor |= (grupo & 0x7) << desplazamiento
+        desplazamiento += 3
+        if not grupo & 0x8:
+            return _unzigzag(valor + 1)
+
+
+def _read_float(bits: _BitReader, canal: list) -> float:
+    """XOR con el float anterior del canal ([bits, ceros iniciales, ceros finales])"""
+    if bits.get(1):
+        if bits.get(1):
+            canal[1] = bits.get(5)
+            canal[2] = 32 - canal[1] - (bits.get(5) + 1)
+        canal[0] ^= bits.get(32 - canal[1] - canal[2]) << canal[2]
+    # Valor mas corto que vuelve a dar el mismo float (23.4 y no 23.399999618530273)
+    crudo = struct.pack("<I", canal[0])
+    (valor,) = struct.unpack("<f", crudo)
+    for digitos in range(1, 10):
+        corto = float(f"{valor:.{digitos}g}")
+        if struct.pack("<f", corto) == crudo:
+            return corto
+    return valor
+
+
+def _decode_binary_gorilla(payload: bytes, ahora: int) -> list:
+    """Decodifica un lote comprimido: tiempos con diferencia de la diferencia y valores como
+    diferencias de enteros o XOR de floats"""
+    mascara = payload[2]
+    n = payload[3]
+    if mascara & (1 << BIT_INSTANTE):
+        (instante,) = struct.unpack_from("<Q", payload, 4)
+        posicion = 12
+    else:
+        (edad,) = struct.unpack_from("<I", payload, 4)
+        instante = SIN_FECHA if edad == EDAD_DESCONOCIDA else ahora - edad
+        posicion = 8
+    modo = payload[posicion]
+    bits = _BitReader(payload[posicion + 1 :])
+
+    lecturas = []
+    delta = 0
+    presentes = 0
+    enteros = [0] * len(CANALES_LOTE)
+    reales = [[0, 0, 0] for _ in CANALES_LOTE]
+    for _ in range(n):
+        # La primera lectura es la base de tiempo; las diferencias son int32
+        delta = (delta + _read_dod(bits)) & 0xFFFFFFFF
+        if instante != SIN_FECHA:
+            instante += delta - (1 << 32) if delta & 0x80000000 else delta
+        if bits.get(1):
+            presentes = bits.get(4)
+        lectura = {}
+        for canal, (nombre, escala) in enumerate(CANALES_LOTE):
+            if not presentes & (1 << canal):
+                continue
+            # humedad_capacitor (escala 1) es entero tambien en GORILLA_XOR
+            if modo == GORILLA_XOR and escala != 1:
+                lectura[nombre] = _read_float(bits, reales[canal])
+            else:
+                enteros[canal] += _read_integer(bits)
+                lectura[nombre] = enteros[canal] / escala if escala != 1 else enteros[canal]
+        lecturas.append((instante, lectura))
+    return lecturas
+
+
+def _expand_json_batch(value: dict, ahora: int) -> list:
+    """Expande un lote JSON {"t0": edad_ms | "ts": instante_ms, "dt": [...], "<canal>": [...]}"""
+    if "ts" in value:
+        instantes = [int(value.pop("ts"))]
+    else:
+        edad = int(value.pop("t0"))
+        instantes = [SIN_FECHA if edad == EDAD_DESCONOCIDA else ahora - edad]
+    for delta in value.pop("dt", []):
+        instantes.append(SIN_FECHA if instantes[0] == SIN_FECHA else instantes[-1] + int(delta))
+
+    lecturas = [{} for _ in instantes]
+    for nombre, valores in value.items():
+        for i, valor in enumerate(valores):
+            if valor is not None:
+                lecturas[i][nombre] = valor
+
+    return list(zip(instantes, lecturas))
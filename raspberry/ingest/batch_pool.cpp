@@ -0,0 +1,62 @@
+#include "batch_pool.h"
+
+BatchPool::BatchPool(int count, size_t capacity) : batches(count), full(count) {
+  for (Batch& batch : batches) {
+    // Holgura para la ultima linea, que puede pasar del umbral de envio
+    batch.data.reserve(capacity + 4096);
+    batch.arrivals.reserve(capacity / 16);
+    freeList.push_back(&batch);
+  }
+}
+
+Batch* BatchPool::acquire(std::chrono::milliseconds wait) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!freeReady.wait_for(lock, wait, [this] { return !freeList.empty(); })) {
+    return nullptr;
+  }
+  Batch* batch = freeList.back();
+  freeList.pop_back();
+  batch->clear();
+  batch->opened = std::chrono::steady_clock::now();
+  return batch;
+}
+
+void BatchPool::submit(Batch* batch) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    full[(fullHead + fullCount++) % full.size()] = batch;
+  }
+  fullReady.notify_one();
+}
+
+Batch* BatchPool::next(std::chrono::milliseconds wait) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!fullReady.wait_for(lock, wait, [this] { return fullCount > 0 || closed; }) || fullCount == 0) {
+    return nullptr;
+  }
+  Batch* batch = full[fullHead];
+  fullHead = (fullHead + 1) % full.size();
+  fullCount--;
+  return batch;
+}
+
+void BatchPool::release(Batch* batch) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeList.push_back(batch);
+  }
+  freeReady.notify_one();
+}
+
+void BatchPool::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+  }
+  fullReady.notify_all();
+}
+
+size_t BatchPool::pending() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return fullCount;
+}
@@ -0,0 +1,92 @@
+#ifndef INGEST_BATCH_POOL_H
+#define INGEST_BATCH_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+///////////////// BLOQUES DE LINEAS REUTILIZABLES \\\\\\\\\\\\\\\\\
+*/
+// Numero fijo de bloques que circulan entre el hilo MQTT (los llena) y el hilo escritor (los
+// envia a InfluxDB y los devuelve vacios). La memoria se reserva una sola vez al arrancar.
+// Si el escritor se atrasa se acaban los bloques libres: el hilo MQTT espera un tiempo acotado
+// y despues descarta mensajes, en lugar de acumular memoria sin limite.
+
+/**
+ * @brief Bloque de lineas pendiente de escribir.
+ */
+struct Batch {
+  std::vector<char> data;
+  uint32_t lines = 0;
+  // Instante de llegada de cada mensaje del bloque (ns, reloj monotono) para medir latencias
+  std::vector<uint64_t> arrivals;
+  std::chrono::steady_clock::time_point opened;
+  // Politica de retencion destino; vacia para la de por defecto de la base de datos
+  std::string retention;
+
+  void clear() {
+    data.clear();
+    lines = 0;
+    arrivals.clear();
+    retention.clear();
+  }
+};
+
+class BatchPool {
+public:
+  /**
+   * @param count Numero de bloques.
+   * @param capacity Capacidad reservada de cada bloque en bytes.
+   */
+  BatchPool(int count, size_t capacity);
+
+  /**
+   * @brief Obtiene un bloque vacio, esperando como mucho el tiempo indicado.
+   * @return Bloque vacio o nullptr si no queda ninguno libre.
+   */
+  Batch* acquire(std::chrono::milliseconds wait);
+
+  /**
+   * @brief Entrega un bloque lleno al escritor.
+   */
+  void submit(Batch* batch);
+
+  /**
+   * @brief Siguiente bloque lleno, en orden de entrega.
+   * @return Bloque o nullptr si vence la espera o el pool esta cerrado y vacio.
+   */
+  Batch* next(std::chrono::milliseconds wait);
+
+  /**
+   * @brief Devuelve al pool un bloque ya escrito (o descartado).
+   */
+  void release(Batch* batch);
+
+  /**
+   * @brief Despierta al escritor para que termine cuando no queden bloques llenos.
+   */
+  void close();
+
+  /**
+   * @brief Numero de bloques llenos pendientes de escribir.
+   */
+  size_t pending();
+
+private:
+  std::vector<Batch> batches;
+  std::vector<Batch*> freeList;
+  // Cola circular de bloques llenos, del mismo tamaño que el pool: nunca reserva memoria
+  std::vector<Batch*> full;
+  size_t fullHead = 0;
+  size_t fullCount = 0;
+  std::mutex mutex;
+  std::condition_variable freeReady;
+  std::condition_variable fullReady;
+  bool closed = false;
+};
+
+#endif // INGEST_BATCH_POOL_H
@@ -0,0 +1,398 @@
+/*
+ * Banco de pruebas de la compresion de los lotes: compara el tamaño y el coste de cada
+ * formato de los nodos sobre una traza de lecturas, con el codificador del firmware
+ * (lib/payload y lib/gorilla) y el decodificador del puente, y comprueba que cada lectura
+ * se recupera igual.
+ *
+ * La traza es una exportacion CSV de InfluxDB 1.x, por ejemplo:
+ *   influx -database plantas -precision ms -format csv \
+ *     -execute 'SELECT temperatura_sonda, temperatura_dht, humedad_capacitor, humedad_dht FROM esp32_1'
+ * Sin traza se usa una sintetica de 7 dias de un nodo como esp32_1 (una lectura cada 30 s).
+ *
+ * Uso: codec_bench [traza.csv] [lecturas por lote]
+ */
+#include <chrono>
+#include <functional>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <payload.h>
+#include <gorilla.h>
+#include "../payload_decoder.h"
+
+/*
+///////////////// TRAZA \\\\\\\\\\\\\\\\\
+*/
+struct Trace {
+  std::string name;
+  // Hora UTC de cada lectura (ms) y lectura con el timestamp relativo a la primera
+  std::vector<int64_t> times;
+  std::vector<SensorSample> samples;
+};
+
+static SensorSample empty_sample() {
+  SensorSample s;
+  s.timestamp = 0;
+  s.temperatureProbe = NAN;
+  s.temperatureDHT = NAN;
+  s.humidityDHT = NAN;
+  s.humidityCapacitor = SAMPLE_NO_HUMIDITY;
+  return s;
+}
+
+static void split_csv(const std::string& linea, std::vector<std::string>& campos) {
+  campos.clear();
+  size_t inicio = 0;
+  while (true) {
+    size_t coma = linea.find(',', inicio);
+    campos.push_back(linea.substr(inicio, coma == std::string::npos ? std::string::npos : coma - inicio));
+    if (coma == std::string::npos) {
+      return;
+    }
+    inicio = coma + 1;
+  }
+}
+
+// Una serie por medicion ("name"); las columnas que no son canales se ignoran
+static bool load_influx_csv(const char* path, std::vector<Trace>& trazas) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) {
+    return false;
+  }
+  std::map<std::string, size_t> indice;
+  std::vector<std::string> cabecera, campos;
+  char buffer[1024];
+  while (fgets(buffer, sizeof(buffer), f) != nullptr) {
+    std::string linea(buffer);
+    while (!linea.empty() && (linea.back() == '\n' || linea.back() == '\r')) {
+      linea.pop_back();
+    }
+    if (cabecera.empty()) {
+      split_csv(linea, cabecera);
+      continue;
+    }
+    split_csv(linea, campos);
+    if (campos.size() != cabecera.size()) {
+      continue;
+    }
+
+    SensorSample s = empty_sample();
+    int64_t instante = -1;
+    std::string nombre = "traza";
+    for (size_t i = 0; i < campos.size(); i++) {
+      const std::string& columna = cabecera[i];
+      const std::string& valor = campos[i];
+      if (columna == "name") {
+        nombre = valor;
+      } else if (columna == "time") {
+        instante = strtoll(valor.c_str(), nullptr, 10);
+        // Sin -precision ms la exportacion va en ns
+        if (instante > 100000000000000LL) {
+          instante /= 1000000;
+        }
+      } else if (!valor.empty() && columna == "temperatura_sonda") {
+        s.temperatureProbe = strtof(valor.c_str(), nullptr);
+      } else if (!valor.empty() && columna == "temperatura_dht") {
+        s.temperatureDHT = strtof(valor.c_str(), nullptr);
+      } else if (!valor.empty() && columna == "humedad_dht") {
+        s.humidityDHT = strtof(valor.c_str(), nullptr);
+      } else if (!valor.empty() && columna == "humedad_capacitor") {
+        s.humidityCapacitor = (int16_t)lroundf(strtof(valor.c_str(), nullptr));
+      }
+    }
+    if (instante < 0) {
+      continue;
+    }
+    if (indice.find(nombre) == indice.end()) {
+      indice[nombre] = trazas.size();
+      trazas.push_back(Trace{nombre, {}, {}});
+    }
+    Trace& t = trazas[indice[nombre]];
+    s.timestamp = t.times.empty() ? 0 : (uint32_t)(instante - t.times[0]);
+    t.times.push_back(instante);
+    t.samples.push_back(s);
+  }
+  fclose(f);
+  return !trazas.empty();
+}
+
+// Generador congruencial: la traza sintetica es siempre la misma
+static uint32_t semilla = 12345;
+static double uniform() {
+  semilla = semilla * 1664525u + 1013904223u;
+  return (semilla >> 8) / 16777216.0;
+}
+
+static Trace synthetic_trace() {
+  Trace t;
+  t.name = "sintetica";
+  const double dia = 86400000.0;
+  double deriva = 0;
+  double capacitor = 480;
+  int64_t instante = 1700000000000LL;
+  for (int i = 0; i < 7 * 2880; i++) {
+    // Periodo de 30 s con el retraso del planificador y de la lectura de los sensores
+    instante += 30000 + (int64_t)(uniform() * 20) - 10;
+    double fase = 2 * M_PI * fmod((double)instante, dia) / dia;
+    deriva += (uniform() - 0.5) * 0.02;
+    double temperatura = 22 + 3 * sin(fase) + deriva;
+
+    SensorSample s = empty_sample();
+    // DS18B20 a 12 bits: pasos de 1/16 de grado
+    s.temperatureProbe = roundf((float)(temperatura + (uniform() - 0.5) * 0.1) * 16) / 16;
+    // DHT11: grados y % enteros, con un 1% de lecturas fallidas
+    if (uniform() >= 0.01) {
+      s.temperatureDHT = roundf((float)(temperatura - 0.5 + (uniform() - 0.5)));
+      s.humidityDHT = roundf((float)(55 - 10 * sin(fase) + (uniform() - 0.5) * 2));
+    }
+    // Sensor capacitivo: se seca despacio y sube de golpe con cada riego
+    capacitor -= 0.002;
+    if (i % 2880 == 1000) {
+      capacitor += 40;
+    }
+    s.humidityCapacitor = (int16_t)lround(capacitor + (uniform() - 0.5) * 4);
+
+    s.timestamp = t.times.empty() ? 0 : (uint32_t)(instante - t.times[0]);
+    t.times.push_back(instante);
+    t.samples.push_back(s);
+  }
+  return t;
+}
+
+/*
+///////////////// FORMATOS \\\\\\\\\\\\\\\\\
+*/
+// Lectura JSON como la publicaba el firmware con ArduinoJson (floats con 8 decimales)
+static size_t json_reading(const SensorSample& s, char* buffer, size_t size) {
+  const char* nombres[] = {"temperatura_sonda", "temperatura_dht", "humedad_capacitor", "humedad_dht"};
+  float valores[] = {s.temperatureProbe, s.temperatureDHT,
+                     s.humidityCapacitor == SAMPLE_NO_HUMIDITY ? NAN : (float)s.humidityCapacitor, s.humidityDHT};
+  size_t len = 0;
+  buffer[len++] = '{';
+  for (int canal = 0; canal < 4; canal++) {
+    if (isnan(valores[canal])) {
+      continue;
+    }
+    char numero[32];
+    snprintf(numero, sizeof(numero), "%.8f", (double)valores[canal]);
+    char* fin = numero + strlen(numero) - 1;
+    while (*fin == '0') {
+      *fin-- = 0;
+    }
+    if (*fin == '.') {
+      *fin = 0;
+    }
+    len += snprintf(buffer + len, size - len, "%s\"%s\":%s", len > 1 ? "," : "", nombres[canal], numero);
+  }
+  buffer[len++] = '}';
+  return len;
+}
+
+// Codifica las lecturas [inicio, inicio + n) de la traza; la primera lleva la hora UTC
+typedef std::function<size_t(const Trace&, size_t, uint8_t, uint8_t*, size_t)> Encoder;
+
+struct Format {
+  const char* name;
+  Encoder encode;
+  // Valores que recupera el decodificador: en la escala del canal o el float exacto
+  bool exact;
+};
+
+static size_t encode_batch(const Trace& t, size_t inicio, uint8_t n, uint8_t* buffer, size_t size) {
+  // En el nodo "ahora" es el instante de la ultima lectura
+  const SensorSample* lecturas = &t.samples[inicio];
+  return payload_encode_batch(lecturas, n, lecturas[n - 1].timestamp, t.times[inicio], buffer, size);
+}
+
+static Encoder encode_gorilla(uint8_t mode) {
+  return [mode](const Trace& t, size_t inicio, uint8_t n, uint8_t* buffer, size_t size) {
+    const SensorSample* lecturas = &t.samples[inicio];
+    return payload_encode_gorilla(lecturas, n, lecturas[n - 1].timestamp, t.times[inicio], mode, buffer, size);
+  };
+}
+
+/*
+///////////////// COMPROBACION \\\\\\\\\\\\\\\\\
+*/
+struct Point {
+  int64_t time;
+  std::map<std::string, double> values;
+};
+
+class Collector : public PointSink {
+public:
+  void point(int64_t timestampMs, const FieldView* fields, size_t count) override {
+    Point p;
+    p.time = timestampMs;
+    for (size_t i = 0; i < count; i++) {
+      p.values[std::string(fields[i].name, fields[i].nameLen)] = fields[i].value;
+    }
+    points.push_back(p);
+  }
+
+  std::vector<Point> points;
+};
+
+class Counter : public PointSink {
+public:
+  void point(int64_t, const FieldView*, size_t count) override { fields += count; }
+  size_t fields = 0;
+};
+
+// Valor que deberia recuperar el decodificador de una lectura
+static double expected(const SensorSample& s, const char* canal, bool exact) {
+  if (strcmp(canal, "humedad_capacitor") == 0) {
+    return s.humidityCapacitor;
+  }
+  float valor = strcmp(canal, "temperatura_sonda") == 0 ? s.temperatureProbe
+                : strcmp(canal, "temperatura_dht") == 0 ? s.temperatureDHT
+                                                         : s.humidityDHT;
+  return exact ? valor : roundf(valor * 10.0f) / 10.0;
+}
+
+static bool same(const Point& p, int64_t time, const SensorSample& s, bool exact) {
+  const char* canales[] = {"temperatura_sonda", "temperatura_dht", "humedad_capacitor", "humedad_dht"};
+  size_t presentes = 0;
+  for (const char* canal : canales) {
+    double valor = expected(s, canal, exact);
+    if (isnan(valor) || (strcmp(canal, "humedad_capacitor") == 0 && s.humidityCapacitor == SAMPLE_NO_HUMIDITY)) {
+      continue;
+    }
+    presentes++;
+    auto it = p.values.find(canal);
+    if (it == p.values.end() || (exact ? (float)it->second != (float)valor : fabs(it->second - valor) > 1e-9)) {
+      return false;
+    }
+  }
+  return p.time == time && p.values.size() == presentes;
+}
+
+/*
+///////////////// MEDIDA \\\\\\\\\\\\\\\\\
+*/
+static double seconds_since(std::chrono::steady_clock::time_point inicio) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+static void run(const Trace& t, uint8_t lote) {
+  size_t lecturas = t.samples.size();
+  uint8_t buffer[PAYLOAD_BATCH_MAX_SIZE];
+  char texto[PAYLOAD_MAX_SIZE * 2];
+
+  // JSON y binario por lectura: la referencia de lo que se publicaba antes de los lotes
+  size_t json = 0;
+  for (const SensorSample& s : t.samples) {
+    json += json_reading(s, texto, sizeof(texto));
+  }
+  size_t individual = 0;
+  for (size_t i = 0; i < lecturas; i++) {
+    individual += payload_encode_params(t.samples[i], 0, t.times[i], buffer, sizeof(buffer));
+  }
+
+  printf("\ntraza %s: %zu lecturas, lotes de %u\n", t.name.c_str(), lecturas, lote);
+  printf("%-26s %12s %10s %10s %12s %12s %10s\n", "formato", "bytes", "B/lectura", "vs JSON", "codif(ns/l)",
+         "decod(ns/l)", "iguales");
+  printf("%-26s %12zu %10.2f %10.2f %12s %12s %10s\n", "JSON por lectura", json, (double)json / lecturas, 1.0, "-",
+         "-", "-");
+  printf("%-26s %12zu %10.2f %10.2f %12s %12s %10s\n", "SensorSample (buffer RTC)", lecturas * sizeof(SensorSample),
+         (double)sizeof(SensorSample), (double)json / (lecturas * sizeof(SensorSample)), "-", "-", "-");
+  printf("%-26s %12zu %10.2f %10.2f %12s %12s %10s\n", "binario por lectura", individual,
+         (double)individual / lecturas, (double)json / individual, "-", "-", "-");
+
+  Format formatos[] = {
+    {"lote (diferencias)", encode_batch, false},
+    {"lote gorilla (enteros)", encode_gorilla(GORILLA_QUANTIZED), false},
+    {"lote gorilla (xor)", encode_gorilla(GORILLA_XOR), true},
+  };
+  for (const Format& formato : formatos) {
+    // Tamaño y comprobacion de cada lote decodificado
+    std::vector<std::vector<uint8_t>> mensajes;
+    size_t bytes = 0;
+    size_t iguales = 0;
+    for (size_t inicio = 0; inicio + lote <= lecturas; inicio += lote) {
+      size_t len = formato.encode(t, inicio, lote, buffer, sizeof(buffer));
+      if (len == 0) {
+        printf("%s: el lote %zu no cabe\n", formato.name, inicio / lote);
+        continue;
+      }
+      bytes += len;
+      mensajes.emplace_back(buffer, buffer + len);
+      Collector decodificado;
+      payload_decode(buffer, len, 0, decodificado);
+      for (size_t i = 0, p = 0; i < lote && p < decodificado.points.size(); i++) {
+        // Las lecturas sin ningun canal no se entregan
+        if (same(decodificado.points[p], t.times[inicio + i], t.samples[inicio + i], formato.exact)) {
+          iguales++;
+          p++;
+        }
+      }
+    }
+    size_t codificadas = mensajes.size() * lote;
+
+    // Coste: se repite hasta medir al menos 0.2 s
+    size_t repeticiones = 0;
+    auto inicio = std::chrono::steady_clock::now();
+    do {
+      for (size_t l = 0; l + lote <= lecturas; l += lote) {
+        formato.encode(t, l, lote, buffer, sizeof(buffer));
+      }
+      repeticiones++;
+    } while (seconds_since(inicio) < 0.2);
+    double codificacion = seconds_since(inicio) * 1e9 / (repeticiones * codificadas);
+
+    Counter contador;
+    repeticiones = 0;
+    inicio = std::chrono::steady_clock::now();
+    do {
+      for (const std::vector<uint8_t>& m : mensajes) {
+        payload_decode(m.data(), m.size(), 0, contador);
+      }
+      repeticiones++;
+    } while (seconds_since(inicio) < 0.2);
+    double decodificacion = seconds_since(inicio) * 1e9 / (repeticiones * codificadas);
+
+    printf("%-26s %12zu %10.2f %10.2f %12.1f %12.1f %4zu/%-5zu\n", formato.name, bytes, (double)bytes / codificadas,
+           (double)json * codificadas / lecturas / bytes, codificacion, decodificacion, iguales, codificadas);
+  }
+
+  // Flujo continuo: lecturas que caben en el espacio del buffer RTC (SAMPLE_BUFFER_CAPACITY = 32)
+  size_t espacio = 32 * sizeof(SensorSample);
+  for (uint8_t mode : {GORILLA_QUANTIZED, GORILLA_XOR}) {
+    std::vector<uint8_t> flujo(espacio);
+    GorillaEncoder encoder;
+    gorilla_begin(&encoder, mode, t.samples[0].timestamp, flujo.data(), flujo.size());
+    size_t i = 0;
+    while (i < lecturas && gorilla_append(&encoder, t.samples[i])) {
+      i++;
+    }
+    printf("flujo gorilla (%s) en %zu bytes: %zu lecturas (32 sin comprimir)\n",
+           mode == GORILLA_XOR ? "xor" : "enteros", espacio, i);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trace> trazas;
+  if (argc > 1 && strcmp(argv[1], "-") != 0) {
+    if (!load_influx_csv(argv[1], trazas)) {
+      fprintf(stderr, "no se ha podido leer la traza %s\n", argv[1]);
+      return 1;
+    }
+  } else {
+    trazas.push_back(synthetic_trace());
+  }
+  int lote = argc > 2 ? atoi(argv[2]) : 10;
+  if (lote < 2 || lote > PAYLOAD_BATCH_MAX_SAMPLES) {
+    fprintf(stderr, "lecturas por lote entre 2 y %d\n", PAYLOAD_BATCH_MAX_SAMPLES);
+    return 1;
+  }
+  for (const Trace& t : trazas) {
+    if (t.samples.size() >= (size_t)lote) {
+      run(t, (uint8_t)lote);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,792 @@
+/*
+ * Generador de carga: una flota de nodos virtuales que publican en <nodo>/params y
+ * <nodo>/coverage los mismos mensajes que esp32_1 y nodemcu_1 (codificados con lib/payload),
+ * para comprobar si el broker y el suscriptor (mqtt_ingest o mqtt_sub.py) con InfluxDB
+ * aguantan cientos de nodos.
+ *
+ * Cada nodo tiene su propia conexion MQTT y publica con el periodo indicado mas un jitter
+ * aleatorio; las lecturas van fechadas con la hora UTC, como un nodo con el reloj
+ * sincronizado. Los nodos se reparten entre varios hilos. Se mide:
+ *  - Publicacion: mensajes/s conseguidos y retraso respecto al plan (si crece, el generador o
+ *    el broker no dan abasto).
+ *  - Broker (-s): un suscriptor propio mide la latencia hasta la entrega y los mensajes perdidos.
+ *  - Base de datos (-i): cada SONDA_MS se busca con SELECT la fila de la ultima lectura
+ *    publicada hasta que aparece (latencia publicacion -> fila visible), y al final se cuentan
+ *    las filas de la flota frente a las lecturas publicadas.
+ *
+ * Los nodos se llaman <prefijo>0001, <prefijo>0002... para no mezclarse con los reales:
+ *   DROP SERIES FROM /^carga_/   borra lo escrito por la prueba.
+ *
+ * Uso: fleet_load [opciones]
+ *   -n nodos (100)              -r lecturas/s por nodo (0.2)    -j jitter, 0 a 1 (0.1)
+ *   -v periodo de cobertura, s (30)                             -q QoS, 0 o 1 (0)
+ *   -e codificacion: json, binary, batch o gorilla (binary)     -b lecturas por lote (8)
+ *   -c segundos medios entre reconexiones de cada nodo (0: ninguna)
+ *   -d duracion, s (60)         -t hilos (4)                    -p prefijo (carga_)
+ *   -m broker[:puerto] (127.0.0.1:1883)                         -s suscriptor de control
+ *   -i influx[:puerto] (sin base de datos)                      -D base (plant_monitoring)
+ */
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <payload.h>
+#include "../latency.h"
+#include "../mqtt_client.h"
+#include "../payload_decoder.h"
+#include "../socket_util.h"
+
+// Espera maxima de cada pasada de un hilo de publicacion
+static const uint64_t PASADA_NS = 20 * 1000000ULL;
+// Espera antes de reintentar la conexion de un nodo
+static const uint64_t REINTENTO_NS = 1000 * 1000000ULL;
+// Periodo de las sondas de la base de datos y de las consultas que las buscan
+static const int SONDA_MS = 500;
+static const int CONSULTA_MS = 20;
+// Una sonda sin fila pasado este tiempo cuenta como perdida
+static const uint64_t SONDA_MAXIMA_NS = 60 * 1000000000ULL;
+// Espera maxima al final para que el suscriptor y la base de datos terminen de recibir
+static const int DRENAJE_MS = 60000;
+// Mensajes recientes de cada nodo que el suscriptor de control puede emparejar
+static const int RECIENTES = 64;
+
+enum Encoding { ENCODING_JSON, ENCODING_BINARY, ENCODING_BATCH, ENCODING_GORILLA };
+static const char* const CODIFICACIONES[] = {"json", "binary", "batch", "gorilla"};
+
+struct Options {
+  int nodes = 100;
+  double rate = 0.2;
+  double jitter = 0.1;
+  double coverageS = 30;
+  int qos = 0;
+  Encoding encoding = ENCODING_BINARY;
+  int batch = 8;
+  double churnS = 0;
+  int durationS = 60;
+  int threads = 4;
+  std::string prefix = "carga_";
+  std::string broker = "127.0.0.1";
+  int brokerPort = 1883;
+  bool subscriber = false;
+  std::string influx;
+  int influxPort = 8086;
+  std::string database = "plant_monitoring";
+};
+
+static uint64_t monotonic_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static int64_t unix_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/*
+///////////////// ESTADO COMPARTIDO \\\\\\\\\\\\\\\\\
+*/
+// Publicacion de una lectura: instante UTC con el que se escribe la fila y momento del envio
+struct Sent {
+  int64_t instant;
+  uint64_t ns;
+};
+
+// Ultimos mensajes de un nodo, para calcular la latencia en el suscriptor de control
+struct Recent {
+  std::mutex mutex;
+  Sent ring[RECIENTES] = {};
+  uint32_t head = 0;
+};
+
+struct Fleet {
+  Options options;
+  // Arranque de la carga: hora UTC y reloj monotono. El reloj de los nodos (millis) cuenta
+  // desde aqui y esta sincronizado: la hora UTC de una lectura es startMs + millis
+  int64_t startMs;
+  uint64_t startNs;
+  std::atomic<bool> running{true};
+  std::atomic<uint64_t> published{0}, readings{0}, coverages{0}, bytes{0}, failures{0};
+  std::atomic<uint64_t> reconnects{0}, connectFailures{0}, pubacks{0};
+  std::atomic<uint64_t> receivedParams{0}, receivedCoverage{0};
+  std::atomic<uint64_t> probes{0}, lostProbes{0};
+  // Retraso de cada publicacion respecto a su momento previsto
+  LatencyHistogram lag;
+  LatencyHistogram broker;
+  LatencyHistogram database;
+  std::unique_ptr<Recent[]> recent;
+  // Ultima lectura publicada de toda la flota: la siguiente sonda
+  std::mutex lastMutex;
+  int lastNode = -1;
+  Sent last;
+};
+
+static std::string node_name(const Options& options, int node) {
+  char numero[16];
+  snprintf(numero, sizeof(numero), "%04d", node + 1);
+  return options.prefix + numero;
+}
+
+/*
+///////////////// NODOS VIRTUALES \\\\\\\\\\\\\\\\\
+*/
+struct VirtualNode {
+  int index;
+  std::string topicParams;
+  std::string topicCoverage;
+  MqttClient client;
+  uint64_t nextReading;
+  uint64_t nextCoverage;
+  uint64_t nextChurn;
+  uint64_t nextRetry;
+  // Mensajes con QoS 1 enviados y confirmados
+  uint64_t sent;
+  uint64_t acked;
+  // millis de la ultima lectura
+  int64_t lastMillis;
+  // Lote en curso: timestamp en ms desde el arranque del generador, como millis()
+  SensorSample batch[PAYLOAD_BATCH_MAX_SAMPLES];
+  int64_t batchInstant;
+  uint8_t pending;
+  double phase;
+};
+
+// Lectura que cambia despacio a lo largo del dia, con el ruido de los sensores
+static SensorSample take_reading(VirtualNode& node, uint32_t millis, int64_t instant, std::mt19937& rng) {
+  std::normal_distribution<float> ruido(0.0f, 0.05f);
+  double dia = fmod(instant / 86400000.0, 1.0) * 2 * M_PI + node.phase;
+  SensorSample s;
+  s.timestamp = millis;
+  s.temperatureProbe = roundf((21 + 3 * sin(dia) + ruido(rng)) * 10) / 10;
+  s.temperatureDHT = roundf((22 + 4 * sin(dia + 0.3) + ruido(rng)) * 10) / 10;
+  s.humidityDHT = roundf((55 + 10 * cos(dia) + ruido(rng)) * 10) / 10;
+  s.humidityCapacitor = (int16_t)(480 + 30 * cos(dia) + 2 * ruido(rng));
+  return s;
+}
+
+// Mismo formato que PAYLOAD_FORMAT_JSON (el firmware compilado aqui es el binario)
+static size_t encode_json(const SensorSample& s, int64_t instant, uint8_t* buffer, size_t size) {
+  int n = snprintf((char*)buffer, size,
+                   "{\"temperatura_sonda\":%.1f,\"temperatura_dht\":%.1f,\"humedad_capacitor\":%d,"
+                   "\"humedad_dht\":%.1f,\"ts\":%lld}",
+                   s.temperatureProbe, s.temperatureDHT, s.humidityCapacitor, s.humidityDHT, (long long)instant);
+  return n > 0 && (size_t)n < size ? n : 0;
+}
+
+static void record_sent(Fleet& fleet, int node, int64_t instant, uint64_t ns) {
+  if (fleet.options.subscriber) {
+    Recent& r = fleet.recent[node];
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.ring[r.head++ % RECIENTES] = {instant, ns};
+  }
+  if (!fleet.options.influx.empty()) {
+    std::lock_guard<std::mutex> lock(fleet.lastMutex);
+    fleet.lastNode = node;
+    fleet.last = {instant, ns};
+  }
+}
+
+static bool publish(Fleet& fleet, VirtualNode& node, const std::string& topic, const uint8_t* payload, size_t len) {
+  if (len == 0 || !node.client.publish(topic.data(), topic.size(), payload, len, fleet.options.qos)) {
+    fleet.failures++;
+    return false;
+  }
+  fleet.published++;
+  node.sent++;
+  fleet.bytes += len;
+  return true;
+}
+
+static void publish_readings(Fleet& fleet, VirtualNode& node, uint32_t millis) {
+  static thread_local uint8_t payload[2048];
+  const Options& o = fleet.options;
+  size_t len = 0;
+  if (o.encoding == ENCODING_JSON) {
+    len = encode_json(node.batch[0], node.batchInstant, payload, sizeof(payload));
+  } else if (o.encoding == ENCODING_BINARY) {
+    len = payload_encode_params(node.batch[0], 0, node.batchInstant, payload, sizeof(payload));
+  } else if (o.encoding == ENCODING_BATCH) {
+    len = payload_encode_batch(node.batch, node.pending, millis, node.batchInstant, payload, sizeof(payload));
+  } else {
+    len = payload_encode_gorilla(node.batch, node.pending, millis, node.batchInstant, GORILLA_QUANTIZED, payload,
+                                 sizeof(payload));
+  }
+  // Antes de publicar: el suscriptor de control puede recibir el mensaje antes de que vuelva publish()
+  record_sent(fleet, node.index, fleet.startMs + node.lastMillis, monotonic_ns());
+  if (publish(fleet, node, node.topicParams, payload, len)) {
+    fleet.readings += node.pending;
+  }
+  node.pending = 0;
+}
+
+static bool connect_node(Fleet& fleet, VirtualNode& node, const std::string& id) {
+  const Options& o = fleet.options;
+  if (node.client.connect(o.broker, o.brokerPort, id, 60, 5000)) {
+    return true;
+  }
+  fleet.connectFailures++;
+  return false;
+}
+
+static void publisher(Fleet& fleet, std::vector<VirtualNode>& nodes, size_t first, size_t last, uint32_t seed) {
+  const Options& o = fleet.options;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniforme(0.0, 1.0);
+  uint64_t periodo = (uint64_t)(1e9 / o.rate);
+  uint64_t cobertura = (uint64_t)(o.coverageS * 1e9);
+  auto siguiente = [&](uint64_t base) { return base + (uint64_t)(periodo * (1 + o.jitter * (2 * uniforme(rng) - 1))); };
+  auto reconexion = [&](uint64_t base) { return base + (uint64_t)(-log(1 - uniforme(rng)) * o.churnS * 1e9); };
+  std::vector<std::string> ids;
+
+  // Arranque escalonado: cada nodo empieza en un punto aleatorio de su periodo
+  for (size_t i = first; i < last; i++) {
+    VirtualNode& n = nodes[i];
+    ids.push_back("fleet-" + node_name(o, n.index) + "-" + std::to_string(getpid()));
+    n.nextReading = fleet.startNs + (uint64_t)(periodo * uniforme(rng));
+    n.nextCoverage = fleet.startNs + (uint64_t)(cobertura * uniforme(rng));
+    n.nextChurn = o.churnS > 0 ? reconexion(fleet.startNs) : UINT64_MAX;
+    n.nextRetry = 0;
+    connect_node(fleet, n, ids.back());
+  }
+
+  struct : MqttHandler {
+    void message(const char*, size_t, const uint8_t*, size_t) override {}
+  } ignorar;
+
+  while (fleet.running) {
+    uint64_t ahora = monotonic_ns();
+    uint64_t despertar = ahora + PASADA_NS;
+    for (size_t i = first; i < last; i++) {
+      VirtualNode& n = nodes[i];
+      const std::string& id = ids[i - first];
+      if (!n.client.connected()) {
+        if (ahora >= n.nextRetry) {
+          fleet.reconnects++;
+          if (!connect_node(fleet, n, id)) {
+            n.nextRetry = ahora + REINTENTO_NS;
+          }
+        }
+      } else if (ahora >= n.nextChurn) {
+        // Caida de la WiFi: se cierra el socket sin DISCONNECT y se vuelve a conectar
+        n.client.disconnect();
+        fleet.reconnects++;
+        if (!connect_node(fleet, n, id)) {
+          n.nextRetry = ahora + REINTENTO_NS;
+        }
+        n.nextChurn = reconexion(ahora);
+      }
+
+      // Sin conexion las lecturas se pierden: el nodo real las guardaria en su cola
+      while (ahora >= n.nextReading) {
+        fleet.lag.record((ahora - n.nextReading) / 1000);
+        // Una fila por instante y nodo: dos lecturas en el mismo ms se pisarian en InfluxDB
+        int64_t millis = (int64_t)((n.nextReading - fleet.startNs) / 1000000);
+        millis = millis > n.lastMillis ? millis : n.lastMillis + 1;
+        n.lastMillis = millis;
+        int64_t instante = fleet.startMs + millis;
+        if (n.pending == 0) {
+          n.batchInstant = instante;
+        }
+        n.batch[n.pending++] = take_reading(n, (uint32_t)millis, instante, rng);
+        bool lote = o.encoding == ENCODING_BATCH || o.encoding == ENCODING_GORILLA;
+        if (!lote || n.pending >= o.batch) {
+          if (n.client.connected()) {
+            publish_readings(fleet, n, (uint32_t)millis);
+          } else {
+            fleet.failures++;
+            n.pending = 0;
+          }
+        }
+        n.nextReading = siguiente(n.nextReading);
+      }
+      if (ahora >= n.nextCoverage) {
+        uint8_t payload[PAYLOAD_MAX_SIZE];
+        int rssi = -55 - (int)(20 * uniforme(rng));
+        size_t len = o.encoding == ENCODING_JSON ? snprintf((char*)payload, sizeof(payload), "{\"dBm\":%d}", rssi)
+                                                 : payload_encode_coverage(rssi, payload, sizeof(payload));
+        if (n.client.connected() && publish(fleet, n, n.topicCoverage, payload, len)) {
+          fleet.coverages++;
+        } else if (!n.client.connected()) {
+          fleet.failures++;
+        }
+        n.nextCoverage += cobertura;
+      }
+
+      // PUBACK y keepalive
+      if (n.client.connected() && !n.client.poll(0, ignorar)) {
+        n.nextRetry = ahora;
+      }
+      fleet.pubacks += n.client.acknowledged() - n.acked;
+      n.acked = n.client.acknowledged();
+      despertar = n.nextReading < despertar ? n.nextReading : despertar;
+      despertar = n.nextCoverage < despertar ? n.nextCoverage : despertar;
+    }
+    uint64_t fin = monotonic_ns();
+    if (despertar > fin) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(despertar - fin));
+    }
+  }
+
+  // Lotes a medias: el nodo los enviaria al vencer su edad maxima
+  for (size_t i = first; i < last; i++) {
+    VirtualNode& n = nodes[i];
+    if (n.pending > 0 && n.client.connected()) {
+      publish_readings(fleet, n, (uint32_t)((monotonic_ns() - fleet.startNs) / 1000000));
+    }
+  }
+  // Con QoS 1, los PUBACK que falten (como mucho 2 s)
+  auto limite = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  bool faltan = o.qos > 0;
+  while (faltan && std::chrono::steady_clock::now() < limite) {
+    faltan = false;
+    for (size_t i = first; i < last; i++) {
+      VirtualNode& n = nodes[i];
+      if (n.client.connected() && n.client.acknowledged() < n.sent) {
+        n.client.poll(0, ignorar);
+        faltan = true;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  for (size_t i = first; i < last; i++) {
+    VirtualNode& n = nodes[i];
+    fleet.pubacks += n.client.acknowledged() - n.acked;
+    n.client.disconnect();
+  }
+}
+
+/*
+///////////////// SUSCRIPTOR DE CONTROL \\\\\\\\\\\\\\\\\
+*/
+// Empareja cada mensaje recibido con su publicacion por el instante de su ultima lectura
+class ControlSubscriber : public MqttHandler, private PointSink {
+public:
+  explicit ControlSubscriber(Fleet& fleet) : fleet(fleet) {}
+
+  void message(const char* topic, size_t topicLen, const uint8_t* payload, size_t len) override {
+    uint64_t llegada = monotonic_ns();
+    const std::string& prefijo = fleet.options.prefix;
+    if (topicLen <= prefijo.size() || memcmp(topic, prefijo.data(), prefijo.size()) != 0) {
+      return;
+    }
+    int nodo = atoi(topic + prefijo.size()) - 1;
+    const char* barra = (const char*)memchr(topic, '/', topicLen);
+    if (nodo < 0 || nodo >= fleet.options.nodes || barra == nullptr) {
+      return;
+    }
+    if ((size_t)(topic + topicLen - barra) == 9 && memcmp(barra, "/coverage", 9) == 0) {
+      fleet.receivedCoverage++;
+      return;
+    }
+    fleet.receivedParams++;
+    ultimo = -1;
+    if (!payload_decode(payload, len, unix_ms(), *this)) {
+      return;
+    }
+    Recent& r = fleet.recent[nodo];
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (int i = 0; i < RECIENTES; i++) {
+      if (r.ring[i].instant == ultimo) {
+        fleet.broker.record((llegada - r.ring[i].ns) / 1000);
+        break;
+      }
+    }
+  }
+
+private:
+  Fleet& fleet;
+  int64_t ultimo;
+
+  void point(int64_t timestampMs, const FieldView*, size_t) override {
+    ultimo = timestampMs > ultimo ? timestampMs : ultimo;
+  }
+};
+
+static void subscriber(Fleet& fleet, MqttClient& client, std::atomic<bool>& stop) {
+  ControlSubscriber control(fleet);
+  while (!stop && client.connected()) {
+    client.poll(50, control);
+  }
+}
+
+/*
+///////////////// CONSULTAS A INFLUXDB \\\\\\\\\\\\\\\\\
+*/
+static std::string url_encode(const std::string& text) {
+  static const char HEX[] = "0123456789ABCDEF";
+  std::string salida;
+  for (unsigned char c : text) {
+    if (isalnum(c) || c == '-' || c == '_' || c == '.') {
+      salida += c;
+    } else {
+      salida += '%';
+      salida += HEX[c >> 4];
+      salida += HEX[c & 15];
+    }
+  }
+  return salida;
+}
+
+// GET /query con HTTP/1.0: la respuesta termina al cerrar la conexion, sin trozos
+static bool influx_query(const Options& o, const std::string& statement, std::string& body) {
+  int fd = tcp_connect(o.influx, o.influxPort, 5000);
+  if (fd < 0) {
+    return false;
+  }
+  std::string peticion = "GET /query?db=" + url_encode(o.database) + "&epoch=ms&q=" + url_encode(statement) +
+                         " HTTP/1.0\r\nHost: " + o.influx + "\r\n\r\n";
+  bool ok = send_all(fd, peticion.data(), peticion.size());
+  std::string respuesta;
+  char buffer[4096];
+  ssize_t n;
+  while (ok && (n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    respuesta.append(buffer, n);
+  }
+  close(fd);
+  size_t cuerpo = respuesta.find("\r\n\r\n");
+  int status = 0;
+  if (!ok || cuerpo == std::string::npos || sscanf(respuesta.c_str(), "HTTP/1.%*d %d", &status) != 1 ||
+      status != 200) {
+    return false;
+  }
+  body = respuesta.substr(cuerpo + 4);
+  return true;
+}
+
+// Texto del resultado de la sentencia indicada en una respuesta de varias
+static std::string statement_result(const std::string& body, int id) {
+  std::string marca = "\"statement_id\":" + std::to_string(id);
+  size_t inicio = body.find(marca);
+  if (inicio == std::string::npos) {
+    return "";
+  }
+  size_t fin = body.find("\"statement_id\":", inicio + marca.size());
+  return body.substr(inicio, fin == std::string::npos ? std::string::npos : fin - inicio);
+}
+
+// Suma de los valores de count() de todas las series: [[0,<n>]]
+static uint64_t sum_counts(const std::string& body) {
+  uint64_t total = 0;
+  for (size_t pos = body.find("\"values\":[["); pos != std::string::npos; pos = body.find("\"values\":[[", pos + 1)) {
+    size_t fin = body.find("]]", pos);
+    size_t coma = body.rfind(',', fin);
+    if (fin != std::string::npos && coma != std::string::npos && coma > pos) {
+      total += strtoull(body.c_str() + coma + 1, nullptr, 10);
+    }
+  }
+  return total;
+}
+
+struct Probe {
+  int node;
+  Sent sent;
+};
+
+// Busca las sondas pendientes en una sola peticion, una sentencia por sonda
+static void check_probes(Fleet& fleet, std::vector<Probe>& pending) {
+  std::string consulta;
+  for (const Probe& p : pending) {
+    if (!consulta.empty()) {
+      consulta += ';';
+    }
+    consulta += "SELECT count(\"temperatura_sonda\") FROM \"" + node_name(fleet.options, p.node) +
+                "\" WHERE time = " + std::to_string(p.sent.instant) + "ms";
+  }
+  std::string respuesta;
+  if (!influx_query(fleet.options, consulta, respuesta)) {
+    return;
+  }
+  uint64_t ahora = monotonic_ns();
+  std::vector<Probe> quedan;
+  for (size_t i = 0; i < pending.size(); i++) {
+    if (statement_result(respuesta, (int)i).find("\"values\"") != std::string::npos) {
+      fleet.database.record((ahora - pending[i].sent.ns) / 1000);
+    } else if (ahora - pending[i].sent.ns > SONDA_MAXIMA_NS) {
+      fleet.lostProbes++;
+    } else {
+      quedan.push_back(pending[i]);
+    }
+  }
+  pending.swap(quedan);
+}
+
+static void prober(Fleet& fleet, std::atomic<bool>& stop) {
+  std::vector<Probe> pendientes;
+  uint64_t ultimaSonda = 0;
+  int64_t ultimoInstante = 0;
+  while (!stop || !pendientes.empty()) {
+    uint64_t ahora = monotonic_ns();
+    if (!stop && ahora - ultimaSonda >= SONDA_MS * 1000000ULL) {
+      std::lock_guard<std::mutex> lock(fleet.lastMutex);
+      if (fleet.lastNode >= 0 && fleet.last.instant != ultimoInstante) {
+        pendientes.push_back({fleet.lastNode, fleet.last});
+        ultimoInstante = fleet.last.instant;
+        fleet.probes++;
+      }
+      ultimaSonda = ahora;
+    }
+    if (!pendientes.empty()) {
+      check_probes(fleet, pendientes);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(CONSULTA_MS));
+  }
+}
+
+// Filas de la flota desde el arranque: hasta que dejan de aumentar o llegan a lo publicado
+static void count_rows(const Fleet& fleet, int64_t startMs, uint64_t& params, uint64_t& coverage) {
+  std::string desde = " FROM /^" + fleet.options.prefix + "[0-9]+$/ WHERE time >= " + std::to_string(startMs) + "ms";
+  std::string consulta = "SELECT count(\"temperatura_sonda\")" + desde + ";SELECT count(\"dBm\")" + desde;
+  params = coverage = 0;
+  auto limite = std::chrono::steady_clock::now() + std::chrono::milliseconds(DRENAJE_MS);
+  while (std::chrono::steady_clock::now() < limite) {
+    std::string respuesta;
+    uint64_t p = params, c = coverage;
+    if (influx_query(fleet.options, consulta, respuesta)) {
+      p = sum_counts(statement_result(respuesta, 0));
+      c = sum_counts(statement_result(respuesta, 1));
+    }
+    bool estable = p == params && c == coverage && p > 0;
+    params = p;
+    coverage = c;
+    if (estable || (params >= fleet.readings && coverage >= fleet.coverages)) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+  }
+}
+
+/*
+///////////////// INFORME \\\\\\\\\\\\\\\\\
+*/
+static double percent(uint64_t part, uint64_t total) {
+  return total > 0 ? 100.0 * part / total : 0;
+}
+
+static void print_latency(const char* nombre, const LatencyHistogram& h) {
+  printf("%s: %llu muestras, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms\n", nombre,
+         (unsigned long long)h.count(), h.percentile(50) / 1000.0, h.percentile(90) / 1000.0,
+         h.percentile(99) / 1000.0, h.percentile(99.9) / 1000.0);
+}
+
+static bool parse_host(const char* text, std::string& host, int& port) {
+  std::string valor = text;
+  size_t dos = valor.rfind(':');
+  host = valor.substr(0, dos);
+  if (dos != std::string::npos) {
+    port = atoi(valor.c_str() + dos + 1);
+  }
+  return !host.empty() && port > 0;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  int opcion;
+  bool ok = true;
+  while ((opcion = getopt(argc, argv, "n:r:j:v:q:e:b:c:d:t:p:m:si:D:")) != -1) {
+    switch (opcion) {
+      case 'n':
+        o.nodes = atoi(optarg);
+        break;
+      case 'r':
+        o.rate = atof(optarg);
+        break;
+      case 'j':
+        o.jitter = atof(optarg);
+        break;
+      case 'v':
+        o.coverageS = atof(optarg);
+        break;
+      case 'q':
+        o.qos = atoi(optarg) > 0 ? 1 : 0;
+        break;
+      case 'b':
+        o.batch = atoi(optarg);
+        break;
+      case 'c':
+        o.churnS = atof(optarg);
+        break;
+      case 'd':
+        o.durationS = atoi(optarg);
+        break;
+      case 't':
+        o.threads = atoi(optarg);
+        break;
+      case 'p':
+        o.prefix = optarg;
+        break;
+      case 'm':
+        ok = parse_host(optarg, o.broker, o.brokerPort);
+        break;
+      case 's':
+        o.subscriber = true;
+        break;
+      case 'i':
+        ok = parse_host(optarg, o.influx, o.influxPort);
+        break;
+      case 'D':
+        o.database = optarg;
+        break;
+      case 'e':
+        ok = false;
+        for (int e = ENCODING_JSON; e <= ENCODING_GORILLA; e++) {
+          if (strcmp(optarg, CODIFICACIONES[e]) == 0) {
+            o.encoding = (Encoding)e;
+            ok = true;
+          }
+        }
+        break;
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+      break;
+    }
+  }
+  if (!ok || o.nodes < 1 || o.rate <= 0 || o.coverageS <= 0 || o.durationS < 1 || o.jitter < 0 || o.jitter > 1 ||
+      o.batch < 1 || o.batch > PAYLOAD_BATCH_MAX_SAMPLES) {
+    fprintf(stderr, "Uso: %s [-n nodos] [-r lecturas/s] [-j jitter] [-v cobertura_s] [-q qos] "
+                    "[-e json|binary|batch|gorilla] [-b lote] [-c reconexion_s] [-d duracion_s] [-t hilos] "
+                    "[-p prefijo] [-m broker[:puerto]] [-s] [-i influx[:puerto]] [-D base]\n",
+            argv[0]);
+    return 1;
+  }
+  o.threads = o.threads < 1 ? 1 : (o.threads > o.nodes ? o.nodes : o.threads);
+
+  Fleet fleet;
+  fleet.options = o;
+  fleet.recent.reset(new Recent[o.nodes]);
+  std::vector<VirtualNode> nodos(o.nodes);
+  std::mt19937 semilla(getpid());
+  for (int i = 0; i < o.nodes; i++) {
+    VirtualNode& n = nodos[i];
+    n.index = i;
+    n.topicParams = node_name(o, i) + "/params";
+    n.topicCoverage = node_name(o, i) + "/coverage";
+    n.sent = 0;
+    n.acked = 0;
+    n.lastMillis = -1;
+    n.pending = 0;
+    n.phase = std::uniform_real_distribution<double>(0, 2 * M_PI)(semilla);
+  }
+
+  // El suscriptor de control se conecta antes de que empiece la carga
+  MqttClient control;
+  std::atomic<bool> pararControl(false);
+  std::thread hiloControl;
+  if (o.subscriber) {
+    if (!control.connect(o.broker, o.brokerPort, "fleet-control-" + std::to_string(getpid()), 60, 5000) ||
+        !control.subscribe({"+/params", "+/coverage"}, o.qos)) {
+      fprintf(stderr, "No se puede conectar el suscriptor de control con %s:%d\n", o.broker.c_str(), o.brokerPort);
+      return 1;
+    }
+    hiloControl = std::thread(subscriber, std::ref(fleet), std::ref(control), std::ref(pararControl));
+  }
+  std::atomic<bool> pararSondas(false);
+  std::thread hiloSondas;
+  if (!o.influx.empty()) {
+    hiloSondas = std::thread(prober, std::ref(fleet), std::ref(pararSondas));
+  }
+
+  printf("%d nodos en %d hilos, %.2f lecturas/s por nodo (%.0f mensajes/s previstos), codificacion %s, QoS %d\n",
+         o.nodes, o.threads, o.rate,
+         o.nodes * (o.rate / (o.encoding >= ENCODING_BATCH ? o.batch : 1) + 1 / o.coverageS),
+         CODIFICACIONES[o.encoding], o.qos);
+  fleet.startMs = unix_ms();
+  fleet.startNs = monotonic_ns();
+  int64_t inicioMs = fleet.startMs;
+  uint64_t inicioNs = fleet.startNs;
+  std::vector<std::thread> hilos;
+  for (int t = 0; t < o.threads; t++) {
+    size_t primero = (size_t)o.nodes * t / o.threads;
+    size_t ultimo = (size_t)o.nodes * (t + 1) / o.threads;
+    hilos.emplace_back(publisher, std::ref(fleet), std::ref(nodos), primero, ultimo, semilla() + t);
+  }
+
+  // Progreso cada 10 s
+  uint64_t previos = 0;
+  for (int s = 1; s <= o.durationS; s++) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(inicioNs + s * 1000000000ULL - monotonic_ns()));
+    if (s % 10 == 0 || s == o.durationS) {
+      uint64_t publicados = fleet.published;
+      int segundos = s % 10 == 0 ? 10 : s % 10;
+      fprintf(stderr, "%4d s: %.0f msg/s, retraso p99 %.1f ms, fallos %llu, reconexiones %llu\n", s,
+              (double)(publicados - previos) / segundos, fleet.lag.percentile(99) / 1000.0,
+              (unsigned long long)fleet.failures, (unsigned long long)fleet.reconnects);
+      previos = publicados;
+    }
+  }
+  double segundos = (monotonic_ns() - inicioNs) / 1e9;
+  fleet.running = false;
+  for (std::thread& t : hilos) {
+    t.join();
+  }
+
+  if (o.subscriber) {
+    // Hasta que llega todo lo publicado o deja de llegar durante 2 s
+    uint64_t recibidos = 0;
+    for (int espera = 0; espera < DRENAJE_MS / 100; espera++) {
+      uint64_t ahora = fleet.receivedParams + fleet.receivedCoverage;
+      if (ahora >= fleet.published || (espera % 20 == 19 && ahora == recibidos)) {
+        break;
+      }
+      if (espera % 20 == 19) {
+        recibidos = ahora;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    pararControl = true;
+    hiloControl.join();
+    control.disconnect();
+  }
+  uint64_t filas = 0, filasCobertura = 0;
+  if (!o.influx.empty()) {
+    pararSondas = true;
+    hiloSondas.join();
+    count_rows(fleet, inicioMs, filas, filasCobertura);
+  }
+
+  uint64_t mensajesParams = fleet.published - fleet.coverages;
+  printf("publicados: %llu mensajes en %.1f s (%.0f msg/s, %.1f KB/s), %llu lecturas, %llu de cobertura\n",
+         (unsigned long long)fleet.published.load(), segundos, fleet.published / segundos, fleet.bytes / segundos / 1024,
+         (unsigned long long)fleet.readings.load(), (unsigned long long)fleet.coverages.load());
+  printf("fallos de publicacion %llu, reconexiones %llu (fallidas %llu)", (unsigned long long)fleet.failures.load(),
+         (unsigned long long)fleet.reconnects.load(), (unsigned long long)fleet.connectFailures.load());
+  if (o.qos > 0) {
+    printf(", PUBACK %llu/%llu", (unsigned long long)fleet.pubacks.load(), (unsigned long long)fleet.published.load());
+  }
+  printf("\n");
+  print_latency("retraso sobre el plan", fleet.lag);
+  if (o.subscriber) {
+    uint64_t recibidos = fleet.receivedParams + fleet.receivedCoverage;
+    printf("broker: recibidos %llu/%llu (params %llu/%llu, cobertura %llu/%llu), perdidos %.2f %%\n",
+           (unsigned long long)recibidos, (unsigned long long)fleet.published.load(),
+           (unsigned long long)fleet.receivedParams.load(), (unsigned long long)mensajesParams,
+           (unsigned long long)fleet.receivedCoverage.load(), (unsigned long long)fleet.coverages.load(),
+           percent(fleet.published > recibidos ? fleet.published - recibidos : 0, fleet.published));
+    print_latency("publicacion -> suscriptor", fleet.broker);
+  }
+  if (!o.influx.empty()) {
+    printf("base de datos: filas de lecturas %llu/%llu, de cobertura %llu/%llu, perdidas %.2f %%, "
+           "sondas sin fila %llu/%llu\n",
+           (unsigned long long)filas, (unsigned long long)fleet.readings.load(), (unsigned long long)filasCobertura,
+           (unsigned long long)fleet.coverages.load(),
+           percent(fleet.readings + fleet.coverages > filas + filasCobertura
+                       ? fleet.readings + fleet.coverages - filas - filasCobertura
+                       : 0,
+                   fleet.readings + fleet.coverages),
+           (unsigned long long)fleet.lostProbes.load(), (unsigned long long)fleet.probes.load());
+    print_latency("publicacion -> fila visible", fleet.database);
+  }
+  return 0;
+}
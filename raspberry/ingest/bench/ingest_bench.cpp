@@ -0,0 +1,250 @@
+/*
+ * Banco de pruebas del puente: mide mensajes/s y la latencia (llegada -> confirmacion HTTP)
+ * contra un servidor local que imita el endpoint /write de InfluxDB.
+ *
+ * Compara el envio por bloques con una escritura por mensaje, que es lo que hace
+ * mqtt_sub.py con write_points().
+ *
+ * Uso: ingest_bench [mensajes] [retardo_us por peticion]
+ */
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../ingest.h"
+#include "../socket_util.h"
+
+/*
+///////////////// SERVIDOR HTTP DE PRUEBA \\\\\\\\\\\\\\\\\
+*/
+// Acepta conexiones persistentes, lee cada peticion completa (Content-Length), cuenta las
+// lineas recibidas y responde 204 tras el retardo indicado, como un InfluxDB ocupado.
+class FakeInflux {
+public:
+  explicit FakeInflux(int delayUs) : delayUs(delayUs), lines(0), requests(0) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    int uno = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &uno, sizeof(uno));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    listen(listener, 8);
+    acceptor = std::thread(&FakeInflux::accept_loop, this);
+  }
+
+  ~FakeInflux() {
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    acceptor.join();
+    for (std::thread& t : clients) {
+      t.join();
+    }
+  }
+
+  int port;
+  int delayUs;
+  std::atomic<uint64_t> lines;
+  std::atomic<uint64_t> requests;
+
+private:
+  int listener;
+  std::thread acceptor;
+  std::vector<std::thread> clients;
+
+  void accept_loop() {
+    while (true) {
+      int fd = accept(listener, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      clients.emplace_back(&FakeInflux::serve, this, fd);
+    }
+  }
+
+  void serve(int fd) {
+    std::vector<char> buffer(1 << 20);
+    size_t len = 0;
+    static const char RESPUESTA[] = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+    while (true) {
+      // Cabeceras completas
+      char* fin = nullptr;
+      while ((fin = (char*)memmem(buffer.data(), len, "\r\n\r\n", 4)) == nullptr) {
+        ssize_t n = recv(fd, buffer.data() + len, buffer.size() - len, 0);
+        if (n <= 0) {
+          close(fd);
+          return;
+        }
+        len += n;
+      }
+      size_t cabeceras = fin + 4 - buffer.data();
+      size_t cuerpo = 0;
+      char* cl = (char*)memmem(buffer.data(), cabeceras, "Content-Length:", 15);
+      if (cl != nullptr) {
+        cuerpo = strtoul(cl + 15, nullptr, 10);
+      }
+      while (len < cabeceras + cuerpo) {
+        if (len == buffer.size()) {
+          buffer.resize(buffer.size() * 2);
+        }
+        ssize_t n = recv(fd, buffer.data() + len, buffer.size() - len, 0);
+        if (n <= 0) {
+          close(fd);
+          return;
+        }
+        len += n;
+      }
+
+      uint64_t n = 0;
+      for (size_t i = cabeceras; i < cabeceras + cuerpo; i++) {
+        n += buffer[i] == '\n';
+      }
+      lines += n;
+      requests++;
+      if (delayUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+      }
+      if (!send_all(fd, RESPUESTA, sizeof(RESPUESTA) - 1)) {
+        close(fd);
+        return;
+      }
+      memmove(buffer.data(), buffer.data() + cabeceras + cuerpo, len - cabeceras - cuerpo);
+      len -= cabeceras + cuerpo;
+    }
+  }
+};
+
+/*
+///////////////// MENSAJES SINTETICOS \\\\\\\\\\\\\\\\\
+*/
+struct Message {
+  std::string topic;
+  std::vector<uint8_t> payload;
+};
+
+static void put(std::vector<uint8_t>& out, uint32_t value, int size) {
+  for (int i = 0; i < size; i++) {
+    out.push_back((value >> (8 * i)) & 0xFF);
+  }
+}
+
+static std::vector<uint8_t> text(const std::string& s) {
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Mezcla de lo que publican los nodos: lecturas binarias y JSON, lotes y resumenes
+static std::vector<Message> synthetic_messages() {
+  std::vector<Message> mezcla;
+
+  std::vector<uint8_t> lectura = {0xB1, 1, 0x1F};
+  put(lectura, 231, 2);
+  put(lectura, 228, 2);
+  put(lectura, 47, 2);
+  put(lectura, 512, 2);
+  put(lectura, (uint16_t)-61, 2);
+  mezcla.push_back({"esp32_1/params", lectura});
+
+  // Lote de 8 lecturas de dos canales, una cada 5 s
+  std::vector<uint8_t> lote = {0xB1, 3, 0x03, 8};
+  put(lote, 40, 4);
+  for (int i = 1; i < 8; i++) {
+    lote.push_back(5);
+  }
+  for (int canal = 0; canal < 2; canal++) {
+    lote.push_back(0xFF);
+    put(lote, 230 + canal, 2);
+    for (int i = 1; i < 8; i++) {
+      lote.push_back(i % 2 ? 2 : 1);  // zigzag +1 / -1
+    }
+  }
+  mezcla.push_back({"nodemcu_1/params", lote});
+
+  std::vector<uint8_t> resumen = {0xB1, 6, 0x05};
+  put(resumen, 300000, 4);
+  for (int canal = 0; canal < 2; canal++) {
+    put(resumen, 300, 2);
+    put(resumen, 220, 2);
+    put(resumen, 240, 2);
+    put(resumen, 2305, 2);
+    put(resumen, 41, 2);
+  }
+  mezcla.push_back({"esp32_1/summary", resumen});
+
+  mezcla.push_back({"nodemcu_1/params", text("{\"temperatura_sonda\":23.1,\"humedad_capacitor\":47,\"dBm\":-61}")});
+  mezcla.push_back({"esp32_1/params", text("{\"temperatura_dht\":22.8,\"humedad_dht\":51.2,\"edad\":12}")});
+  mezcla.push_back(
+      {"esp32_1/params", text("{\"t0\":20000,\"dt\":[5000,5000,5000],\"temperatura_sonda\":[23.1,23.2,null,23.0]}")});
+  return mezcla;
+}
+
+/*
+///////////////// MEDIDA \\\\\\\\\\\\\\\\\
+*/
+static void run(const char* nombre, IngestConfig config, const std::vector<Message>& mezcla, uint64_t mensajes,
+                int delayUs) {
+  FakeInflux servidor(delayUs);
+  config.influxHost = "127.0.0.1";
+  config.influxPort = servidor.port;
+  config.statsEvery = 0;
+  config.rollupState.clear();
+
+  uint64_t lineas;
+  double segundos;
+  uint64_t p50, p99;
+  IngestStats s;
+  {
+    Ingest ingest(config);
+    ingest.start();
+    auto inicio = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < mensajes; i++) {
+      const Message& m = mezcla[i % mezcla.size()];
+      ingest.message(m.topic.data(), m.topic.size(), m.payload.data(), m.payload.size());
+      if ((i & 63) == 0) {
+        ingest.tick();
+      }
+    }
+    ingest.stop();
+    segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    s = ingest.stats();
+    p50 = ingest.latency().percentile(50);
+    p99 = ingest.latency().percentile(99);
+    lineas = servidor.lines;
+  }
+
+  printf("%-14s %10.0f msg/s %10.0f lineas/s  peticiones %8llu  p50 %8.2f ms  p99 %8.2f ms  "
+         "descartados %llu  recibidas %llu/%llu\n",
+         nombre, s.messages / segundos, s.lines / segundos, (unsigned long long)s.requests, p50 / 1000.0,
+         p99 / 1000.0, (unsigned long long)s.dropped, (unsigned long long)lineas, (unsigned long long)s.lines);
+}
+
+int main(int argc, char** argv) {
+  uint64_t mensajes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+  int delayUs = argc > 2 ? atoi(argv[2]) : 200;
+  std::vector<Message> mezcla = synthetic_messages();
+
+  IngestConfig bloques;
+  run("bloques", bloques, mezcla, mensajes, delayUs);
+
+  // El mismo envio sin los agregados por minuto, hora y dia, para ver lo que cuestan
+  IngestConfig sinAgregados;
+  sinAgregados.rollup = false;
+  run("sin agregados", sinAgregados, mezcla, mensajes, delayUs);
+
+  // Una peticion por mensaje: un solo bloque que se envia en cuanto tiene una linea
+  IngestConfig unoAUno;
+  unoAUno.flushBytes = 1;
+  unoAUno.buffers = 1;
+  run("por mensaje", unoAUno, mezcla, mensajes / 20, delayUs);
+  return 0;
+}
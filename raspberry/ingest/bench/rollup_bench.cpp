@@ -0,0 +1,161 @@
+/*
+ * Banco de pruebas de los agregados por minuto, hora y dia: memoria por serie, valores/s
+ * agregados y coste de la pasada de escritura de las ventanas cerradas, sobre lecturas
+ * sinteticas de nodos como esp32_1 (params cada 5 s y coverage cada 30 s) en tiempo simulado.
+ *
+ * Compara tambien el volumen escrito en InfluxDB con el de las lineas sin agregar.
+ *
+ * Uso: rollup_bench [nodos] [dias]
+ */
+#include <chrono>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "../line_protocol.h"
+#include "../rollup.h"
+
+// Periodo de publicacion de cada sensor (ms)
+static const int64_t PARAMS_MS = 5000;
+static const int64_t COVERAGE_MS = 30000;
+// Pasada de escritura, como Ingest::tick()
+static const int64_t PASADA_MS = 1000;
+// 2026-01-01T00:00:00Z
+static const int64_t INICIO_MS = 1767225600000LL;
+
+struct Reading {
+  int node;
+  int64_t timestampMs;
+  bool coverage;
+  double values[4];
+};
+
+static size_t heap_used() {
+  return mallinfo2().uordblks;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point inicio) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+int main(int argc, char** argv) {
+  int nodos = argc > 1 ? atoi(argv[1]) : 50;
+  int dias = argc > 2 ? atoi(argv[2]) : 3;
+
+  std::vector<std::string> nombres;
+  for (int i = 0; i < nodos; i++) {
+    nombres.push_back("esp32_" + std::to_string(i + 1));
+  }
+  const char* PARAMS = "params";
+  const char* COVERAGE = "coverage";
+  FieldView params[4] = {{"temperatura_sonda", 17, 0},
+                         {"temperatura_dht", 15, 0},
+                         {"humedad_capacitor", 17, 0},
+                         {"humedad_dht", 11, 0}};
+  FieldView cobertura[1] = {{"dBm", 3, 0}};
+
+  RollupConfig config;
+  config.maxSeries = nodos * 5;
+  size_t antes = heap_used();
+  RollupEngine motor(config);
+  size_t vacio = heap_used() - antes;
+
+  std::vector<Reading> lecturas;
+  std::vector<char> salida;
+  salida.reserve(1 << 20);
+  std::vector<char> crudas;
+  crudas.reserve(1 << 20);
+  uint64_t bytesAgregados = 0, bytesCrudos = 0, lineasCrudas = 0;
+  uint64_t lineas[ROLLUP_TIERS] = {};
+  double segundosAdd = 0, segundosFlush = 0, peorPasada = 0;
+  uint64_t pasadas = 0;
+  size_t conSeries = 0;
+
+  int64_t fin = INICIO_MS + dias * 86400000LL;
+  for (int64_t ahora = INICIO_MS; ahora < fin; ahora += PASADA_MS) {
+    // Lecturas del ultimo segundo: cada nodo publica desfasado segun su indice
+    lecturas.clear();
+    for (int n = 0; n < nodos; n++) {
+      int64_t t = ahora + n * 97;
+      double fase = (t - INICIO_MS) / 86400000.0 * 2 * M_PI + n;
+      if ((t / 1000) % (PARAMS_MS / 1000) == 0) {
+        lecturas.push_back({n, t, false,
+                            {21 + 3 * sin(fase), 22 + 4 * sin(fase + 0.3), round(480 + 30 * cos(fase)),
+                             55 + 10 * cos(fase)}});
+      }
+      if ((t / 1000) % (COVERAGE_MS / 1000) == 0) {
+        lecturas.push_back({n, t, true, {-60.0 - n % 20}});
+      }
+    }
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (const Reading& r : lecturas) {
+      const std::string& nodo = nombres[r.node];
+      if (r.coverage) {
+        cobertura[0].value = r.values[0];
+        motor.add(nodo.data(), nodo.size(), COVERAGE, 8, cobertura, 1, r.timestampMs);
+      } else {
+        for (int i = 0; i < 4; i++) {
+          params[i].value = r.values[i];
+        }
+        motor.add(nodo.data(), nodo.size(), PARAMS, 6, params, 4, r.timestampMs);
+      }
+    }
+    segundosAdd += seconds_since(inicio);
+
+    // Lo que se escribiria sin agregar, fuera de la medida
+    for (const Reading& r : lecturas) {
+      const std::string& nodo = nombres[r.node];
+      if (r.coverage) {
+        cobertura[0].value = r.values[0];
+        line_append(crudas, nodo.data(), nodo.size(), COVERAGE, 8, cobertura, 1, r.timestampMs, config.decimals);
+      } else {
+        for (int i = 0; i < 4; i++) {
+          params[i].value = r.values[i];
+        }
+        line_append(crudas, nodo.data(), nodo.size(), PARAMS, 6, params, 4, r.timestampMs, config.decimals);
+      }
+    }
+    lineasCrudas += lecturas.size();
+    bytesCrudos += crudas.size();
+    crudas.clear();
+    if (conSeries == 0 && motor.series() == (size_t)nodos * 5) {
+      conSeries = heap_used() - antes;
+    }
+
+    inicio = std::chrono::steady_clock::now();
+    for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+      lineas[nivel] += motor.flush((RollupTier)nivel, ahora, false, salida, SIZE_MAX);
+    }
+    double pasada = seconds_since(inicio);
+    segundosFlush += pasada;
+    peorPasada = pasada > peorPasada ? pasada : peorPasada;
+    pasadas++;
+    bytesAgregados += salida.size();
+    salida.clear();
+  }
+  for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+    lineas[nivel] += motor.flush((RollupTier)nivel, fin, true, salida, SIZE_MAX);
+  }
+  bytesAgregados += salida.size();
+
+  RollupStats s = motor.stats();
+  size_t series = motor.series();
+  printf("%d nodos, %d dias simulados, %zu series, ventanas por serie %d/%d/%d\n", nodos, dias, series,
+         config.slots[0], config.slots[1], config.slots[2]);
+  printf("memoria: %zu bytes con %zu series, %.0f bytes por serie (motor vacio %zu bytes)\n", conSeries, series,
+         (double)(conSeries - vacio) / series, vacio);
+  printf("agregar:  %llu valores, %.0f valores/s, %.1f ns por valor\n", (unsigned long long)s.values,
+         s.values / segundosAdd, segundosAdd * 1e9 / s.values);
+  printf("escribir: %llu pasadas, media %.1f us, peor %.1f us, %.1f ns por serie y pasada\n",
+         (unsigned long long)pasadas, segundosFlush * 1e6 / pasadas, peorPasada * 1e6,
+         segundosFlush * 1e9 / pasadas / series);
+  printf("lineas:   crudas %llu (%.1f MB), agregadas 1m %llu / 1h %llu / 1d %llu (%.1f MB), "
+         "atrasados %llu, reescrituras %llu\n",
+         (unsigned long long)lineasCrudas, bytesCrudos / 1e6, (unsigned long long)lineas[ROLLUP_MINUTE],
+         (unsigned long long)lineas[ROLLUP_HOUR], (unsigned long long)lineas[ROLLUP_DAY], bytesAgregados / 1e6,
+         (unsigned long long)s.late, (unsigned long long)s.rewrites);
+  return 0;
+}
@@ -0,0 +1,319 @@
+#include "capture_log.h"
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MARCA[8] = {'M', 'Q', 'T', 'T', 'C', 'A', 'P', '1'};
+static const uint32_t VERSION = 1;
+// Separacion minima entre entradas del indice dentro de un segmento: un mes de captura son
+// unos 4 MB de indice
+static const int64_t INDICE_US = 10000000;
+
+static size_t align8(size_t n) {
+  return (n + 7) & ~(size_t)7;
+}
+
+static std::string segment_path(const std::string& directory, uint32_t segment) {
+  char nombre[32];
+  snprintf(nombre, sizeof(nombre), "/seg_%06u.log", segment);
+  return directory + nombre;
+}
+
+// Numeros de los segmentos del directorio (seg_NNNNNN.log), ordenados
+static bool list_segments(const std::string& directory, std::vector<uint32_t>& segments) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return false;
+  }
+  while (dirent* entrada = readdir(dir)) {
+    const char* nombre = entrada->d_name;
+    if (strlen(nombre) == 14 && strncmp(nombre, "seg_", 4) == 0 && strcmp(nombre + 10, ".log") == 0) {
+      segments.push_back((uint32_t)strtoul(nombre + 4, nullptr, 10));
+    }
+  }
+  closedir(dir);
+  std::sort(segments.begin(), segments.end());
+  return true;
+}
+
+static bool read_topics(const std::string& directory, std::vector<std::string>& topics) {
+  FILE* fichero = fopen((directory + "/topics").c_str(), "r");
+  if (fichero == nullptr) {
+    return errno == ENOENT;
+  }
+  char* linea = nullptr;
+  size_t capacidad = 0;
+  ssize_t n;
+  while ((n = getline(&linea, &capacidad, fichero)) > 0) {
+    topics.emplace_back(linea, linea[n - 1] == '\n' ? n - 1 : n);
+  }
+  free(linea);
+  fclose(fichero);
+  return true;
+}
+
+/*
+///////////////// ESCRITURA \\\\\\\\\\\\\\\\\
+*/
+CaptureWriter::CaptureWriter(const std::string& directory, size_t segmentBytes)
+    : directory(directory), segmentBytes(align8(segmentBytes)), topicsFile(nullptr), indexFile(nullptr), fd(-1),
+      map(nullptr), offset(0), segment(0), indexedUs(0), written(0), writtenBytes(0), segmentCount(0) {}
+
+CaptureWriter::~CaptureWriter() {
+  close();
+}
+
+bool CaptureWriter::open() {
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+  std::vector<std::string> topics;
+  std::vector<uint32_t> segmentos;
+  if (!read_topics(directory, topics) || !list_segments(directory, segmentos)) {
+    return false;
+  }
+  for (size_t i = 0; i < topics.size(); i++) {
+    topicIds.emplace(topics[i], (uint16_t)i);
+  }
+  segment = segmentos.empty() ? 0 : segmentos.back();
+
+  topicsFile = fopen((directory + "/topics").c_str(), "a");
+  indexFile = fopen((directory + "/index").c_str(), "ab");
+  return topicsFile != nullptr && indexFile != nullptr;
+}
+
+bool CaptureWriter::open_segment() {
+  segment++;
+  fd = ::open(segment_path(directory, segment).c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  // El fichero se reserva entero: lo que no se ha escrito esta a cero
+  void* p = MAP_FAILED;
+  if (ftruncate(fd, segmentBytes) == 0) {
+    p = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (p == MAP_FAILED) {
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+  map = (uint8_t*)p;
+  memcpy(map, MARCA, sizeof(MARCA));
+  memcpy(map + 8, &VERSION, sizeof(VERSION));
+  memcpy(map + 12, &segment, sizeof(segment));
+  offset = CAPTURE_HEADER_SIZE;
+  segmentCount++;
+  return true;
+}
+
+void CaptureWriter::close_segment() {
+  if (map == nullptr) {
+    return;
+  }
+  munmap(map, segmentBytes);
+  map = nullptr;
+  // Se recorta a lo escrito; si falla, el resto sigue a cero y el lector lo trata como el final
+  if (ftruncate(fd, offset) != 0) {
+    perror("ftruncate");
+  }
+  ::close(fd);
+  fd = -1;
+}
+
+bool CaptureWriter::append(const char* topic, size_t topicLen, const uint8_t* payload, size_t len,
+                           int64_t timeUs) {
+  size_t tamaño = CAPTURE_RECORD_HEADER + len;
+  if (topicsFile == nullptr || topicLen == 0 || memchr(topic, '\n', topicLen) != nullptr ||
+      tamaño > segmentBytes - CAPTURE_HEADER_SIZE || tamaño > UINT32_MAX) {
+    return false;
+  }
+
+  key.assign(topic, topicLen);
+  auto it = topicIds.find(key);
+  if (it == topicIds.end()) {
+    if (topicIds.size() > UINT16_MAX) {
+      return false;
+    }
+    fwrite(topic, 1, topicLen, topicsFile);
+    fputc('\n', topicsFile);
+    fflush(topicsFile);
+    it = topicIds.emplace(key, (uint16_t)topicIds.size()).first;
+  }
+
+  if (map == nullptr || offset + align8(tamaño) > segmentBytes) {
+    close_segment();
+    if (!open_segment()) {
+      return false;
+    }
+  }
+  if (offset == CAPTURE_HEADER_SIZE || timeUs >= indexedUs + INDICE_US) {
+    CaptureIndexEntry entrada = {timeUs, segment, (uint32_t)offset};
+    fwrite(&entrada, sizeof(entrada), 1, indexFile);
+    fflush(indexFile);
+    indexedUs = timeUs;
+  }
+
+  // El tamaño se escribe el ultimo: quien lea un segmento abierto no ve un registro a medias
+  uint8_t* registro = map + offset;
+  uint16_t id = it->second;
+  uint16_t reservado = 0;
+  memcpy(registro + 4, &id, sizeof(id));
+  memcpy(registro + 6, &reservado, sizeof(reservado));
+  memcpy(registro + 8, &timeUs, sizeof(timeUs));
+  memcpy(registro + CAPTURE_RECORD_HEADER, payload, len);
+  __atomic_store_n((uint32_t*)registro, (uint32_t)tamaño, __ATOMIC_RELEASE);
+  offset += align8(tamaño);
+  written++;
+  writtenBytes += tamaño;
+  return true;
+}
+
+void CaptureWriter::close() {
+  close_segment();
+  if (topicsFile != nullptr) {
+    fclose(topicsFile);
+    topicsFile = nullptr;
+  }
+  if (indexFile != nullptr) {
+    fclose(indexFile);
+    indexFile = nullptr;
+  }
+}
+
+/*
+///////////////// LECTURA \\\\\\\\\\\\\\\\\
+*/
+CaptureReader::CaptureReader(const std::string& directory)
+    : directory(directory), position(0), fd(-1), map(nullptr), size(0), offset(0), fromUs(INT64_MIN),
+      corrupted(0) {}
+
+CaptureReader::~CaptureReader() {
+  unmap();
+}
+
+bool CaptureReader::open() {
+  FILE* fichero = fopen((directory + "/index").c_str(), "rb");
+  if (fichero == nullptr || !read_topics(directory, topics) || !list_segments(directory, segments)) {
+    if (fichero != nullptr) {
+      fclose(fichero);
+    }
+    return false;
+  }
+  CaptureIndexEntry entrada;
+  while (fread(&entrada, sizeof(entrada), 1, fichero) == 1) {
+    index.push_back(entrada);
+  }
+  fclose(fichero);
+  seek(INT64_MIN);
+  return true;
+}
+
+void CaptureReader::unmap() {
+  if (map != nullptr) {
+    munmap((void*)map, size);
+    map = nullptr;
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+bool CaptureReader::map_segment(size_t position, size_t offset) {
+  unmap();
+  this->position = position;
+  if (position >= segments.size()) {
+    return false;
+  }
+  fd = ::open(segment_path(directory, segments[position]).c_str(), O_RDONLY);
+  struct stat datos;
+  if (fd < 0 || fstat(fd, &datos) != 0 || (size_t)datos.st_size < CAPTURE_HEADER_SIZE) {
+    unmap();
+    return false;
+  }
+  size = datos.st_size;
+  void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    unmap();
+    return false;
+  }
+  map = (const uint8_t*)p;
+  if (memcmp(map, MARCA, sizeof(MARCA)) != 0) {
+    unmap();
+    return false;
+  }
+  madvise((void*)map, size, MADV_SEQUENTIAL);
+  this->offset = offset > CAPTURE_HEADER_SIZE ? offset : CAPTURE_HEADER_SIZE;
+  return true;
+}
+
+void CaptureReader::seek(int64_t timeUs) {
+  fromUs = timeUs;
+  // Ultima entrada anterior al instante: los registros previos son todos anteriores
+  auto entrada = std::lower_bound(index.begin(), index.end(), timeUs,
+                                  [](const CaptureIndexEntry& e, int64_t t) { return e.timeUs < t; });
+  size_t posicion = 0;
+  size_t desplazamiento = CAPTURE_HEADER_SIZE;
+  if (entrada != index.begin()) {
+    --entrada;
+    posicion = std::lower_bound(segments.begin(), segments.end(), entrada->segment) - segments.begin();
+    desplazamiento = entrada->offset;
+  }
+  unmap();
+  position = posicion;
+  offset = desplazamiento;
+}
+
+bool CaptureReader::next(CaptureMessage& message) {
+  while (true) {
+    if (map == nullptr) {
+      if (position >= segments.size()) {
+        return false;
+      }
+      if (!map_segment(position, offset)) {
+        corrupted++;
+        position++;
+        offset = CAPTURE_HEADER_SIZE;
+        continue;
+      }
+    }
+
+    uint32_t tamaño = 0;
+    if (offset + CAPTURE_RECORD_HEADER <= size) {
+      tamaño = __atomic_load_n((const uint32_t*)(map + offset), __ATOMIC_ACQUIRE);
+    }
+    if (tamaño == 0) {
+      // Final del segmento
+      unmap();
+      position++;
+      offset = CAPTURE_HEADER_SIZE;
+      continue;
+    }
+    const uint8_t* registro = map + offset;
+    uint16_t topic;
+    memcpy(&topic, registro + 4, sizeof(topic));
+    if (tamaño < CAPTURE_RECORD_HEADER || offset + tamaño > size || topic >= topics.size()) {
+      corrupted++;
+      unmap();
+      position++;
+      offset = CAPTURE_HEADER_SIZE;
+      continue;
+    }
+
+    memcpy(&message.timeUs, registro + 8, sizeof(message.timeUs));
+    message.topic = topics[topic].data();
+    message.topicLen = topics[topic].size();
+    message.payload = registro + CAPTURE_RECORD_HEADER;
+    message.len = tamaño - CAPTURE_RECORD_HEADER;
+    offset += align8(tamaño);
+    if (message.timeUs >= fromUs) {
+      return true;
+    }
+  }
+}
@@ -0,0 +1,167 @@
+#ifndef INGEST_CAPTURE_LOG_H
+#define INGEST_CAPTURE_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+///////////////// REGISTRO DE MENSAJES CAPTURADOS \\\\\\\\\\\\\\\\\
+*/
+// Directorio con el trafico MQTT capturado, para reproducirlo despues (tools/mqtt_replay):
+//
+//   seg_000001.log ...  Segmentos de tamaño fijo, proyectados en memoria (mmap) al escribir y
+//                       al leer. Al cerrar un segmento se recorta a lo escrito.
+//   topics              Un topic por linea; el identificador de un topic es su numero de linea
+//                       empezando en 0.
+//   index               Entradas {int64 timeUs, uint32 segment, uint32 offset} (16 bytes, little
+//                       endian): el primer registro de cada segmento y uno cada 10 s de captura,
+//                       para empezar a reproducir en un instante sin recorrer los segmentos.
+//
+// Un segmento empieza con una cabecera de CAPTURE_HEADER_SIZE bytes (marca "MQTTCAP1", version,
+// numero de segmento) seguida de los registros, alineados a 8 bytes:
+//
+// | campo    | tipo   | descripcion                                              |
+// |----------|--------|----------------------------------------------------------|
+// | size     | uint32 | bytes del registro con la cabecera, sin relleno (0: fin) |
+// | topic    | uint16 | identificador del topic                                  |
+// | reserved | uint16 | 0                                                        |
+// | timeUs   | int64  | llegada del mensaje en us desde la epoca Unix            |
+// | payload  | -      | size - 16 bytes, sin modificar                           |
+//
+// Un segmento sin cerrar (captura interrumpida) termina en el primer registro con size 0: el
+// resto del fichero esta a cero porque se reserva entero al crearlo.
+
+#define CAPTURE_HEADER_SIZE 32
+#define CAPTURE_RECORD_HEADER 16
+
+/**
+ * @brief Mensaje leido del registro. Los punteros son validos hasta la siguiente lectura.
+ */
+struct CaptureMessage {
+  const char* topic;
+  size_t topicLen;
+  const uint8_t* payload;
+  size_t len;
+  int64_t timeUs;
+};
+
+struct CaptureIndexEntry {
+  int64_t timeUs;
+  uint32_t segment;
+  uint32_t offset;
+};
+
+class CaptureWriter {
+public:
+  /**
+   * @param directory Directorio del registro (se crea si no existe).
+   * @param segmentBytes Tamaño de cada segmento.
+   */
+  CaptureWriter(const std::string& directory, size_t segmentBytes);
+  ~CaptureWriter();
+
+  /**
+   * @brief Abre el registro. Si ya tiene segmentos, la captura sigue en uno nuevo.
+   * @return false si no se puede crear el directorio o leer sus ficheros.
+   */
+  bool open();
+
+  /**
+   * @brief Añade un mensaje.
+   *
+   * @param topic Topic del mensaje.
+   * @param topicLen Longitud del topic.
+   * @param payload Contenido del mensaje.
+   * @param len Longitud del contenido.
+   * @param timeUs Instante de llegada en us desde la epoca Unix.
+   * @return false si no se ha podido guardar (mensaje mayor que un segmento, demasiados
+   * topics o error de E/S).
+   */
+  bool append(const char* topic, size_t topicLen, const uint8_t* payload, size_t len, int64_t timeUs);
+
+  /**
+   * @brief Cierra el segmento en curso recortandolo a lo escrito.
+   */
+  void close();
+
+  uint64_t records() const { return written; }
+  // Bytes de los registros escritos, con sus cabeceras
+  uint64_t bytes() const { return writtenBytes; }
+  uint32_t segments() const { return segmentCount; }
+
+private:
+  std::string directory;
+  size_t segmentBytes;
+  std::unordered_map<std::string, uint16_t> topicIds;
+  // Clave de busqueda reutilizada
+  std::string key;
+  FILE* topicsFile;
+  FILE* indexFile;
+  int fd;
+  uint8_t* map;
+  size_t offset;
+  uint32_t segment;
+  int64_t indexedUs;
+  uint64_t written;
+  uint64_t writtenBytes;
+  uint32_t segmentCount;
+
+  bool open_segment();
+  void close_segment();
+};
+
+class CaptureReader {
+public:
+  explicit CaptureReader(const std::string& directory);
+  ~CaptureReader();
+
+  /**
+   * @brief Lee los topics, el indice y la lista de segmentos, y se situa al principio.
+   * @return false si el directorio no es un registro.
+   */
+  bool open();
+
+  /**
+   * @brief Se situa en el primer mensaje recibido en el instante indicado o despues.
+   */
+  void seek(int64_t timeUs);
+
+  /**
+   * @brief Siguiente mensaje.
+   * @return false al llegar al final del registro.
+   */
+  bool next(CaptureMessage& message);
+
+  /**
+   * @brief Instante del primer y del ultimo mensaje segun el indice (el ultimo, con 10 s de margen).
+   */
+  int64_t first() const { return index.empty() ? 0 : index.front().timeUs; }
+  int64_t last() const { return index.empty() ? 0 : index.back().timeUs; }
+
+  /**
+   * @brief Registros danados que se han saltado (se pasa al segmento siguiente).
+   */
+  uint64_t corrupt() const { return corrupted; }
+
+private:
+  std::string directory;
+  std::vector<std::string> topics;
+  std::vector<CaptureIndexEntry> index;
+  std::vector<uint32_t> segments;
+  size_t position;
+  int fd;
+  const uint8_t* map;
+  size_t size;
+  size_t offset;
+  int64_t fromUs;
+  uint64_t corrupted;
+
+  bool map_segment(size_t position, size_t offset);
+  void unmap();
+};
+
+#endif // INGEST_CAPTURE_LOG_H
@@ -0,0 +1,131 @@
+#include "config.h"
+#include <fstream>
+
+// Elimina los espacios de los extremos
+static std::string trim(const std::string& text) {
+  size_t inicio = text.find_first_not_of(" \t\r");
+  if (inicio == std::string::npos) {
+    return "";
+  }
+  size_t fin = text.find_last_not_of(" \t\r");
+  return text.substr(inicio, fin - inicio + 1);
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+  std::vector<std::string> partes;
+  size_t inicio = 0;
+  while (inicio <= text.size()) {
+    size_t fin = text.find(separator, inicio);
+    if (fin == std::string::npos) {
+      fin = text.size();
+    }
+    std::string parte = trim(text.substr(inicio, fin - inicio));
+    if (!parte.empty()) {
+      partes.push_back(parte);
+    }
+    inicio = fin + 1;
+  }
+  return partes;
+}
+
+// Asigna un valor entero solo si la clave tiene contenido
+static void set_int(const std::string& valor, int& destino) {
+  if (!valor.empty()) {
+    destino = std::stoi(valor);
+  }
+}
+
+bool config_load(const char* path, IngestConfig& config) {
+  std::ifstream fichero(path);
+  if (!fichero) {
+    return false;
+  }
+
+  std::string seccion;
+  std::string linea;
+  while (std::getline(fichero, linea)) {
+    linea = trim(linea);
+    if (linea.empty() || linea[0] == '#' || linea[0] == ';') {
+      continue;
+    }
+    if (linea.front() == '[' && linea.back() == ']') {
+      seccion = linea.substr(1, linea.size() - 2);
+      continue;
+    }
+    size_t igual = linea.find('=');
+    if (igual == std::string::npos) {
+      continue;
+    }
+    std::string clave = trim(linea.substr(0, igual));
+    std::string valor = trim(linea.substr(igual + 1));
+
+    if (seccion == "MQTT") {
+      if (clave == "broker" && !valor.empty()) {
+        // broker o broker:puerto
+        std::vector<std::string> partes = split(valor, ':');
+        config.broker = partes[0];
+        if (partes.size() > 1) {
+          config.brokerPort = std::stoi(partes[1]);
+        }
+      } else if (clave == "topic" && !valor.empty()) {
+        config.topics = split(valor, ',');
+      } else if (clave == "qos") {
+        set_int(valor, config.qos);
+      } else if (clave == "database" && !valor.empty()) {
+        config.database = valor;
+      } else if (clave == "timeout") {
+        set_int(valor, config.timeout);
+      }
+    } else if (seccion == "INGEST") {
+      int entero = -1;
+      if (clave == "influx_host" && !valor.empty()) {
+        config.influxHost = valor;
+      } else if (clave == "influx_port") {
+        set_int(valor, config.influxPort);
+      } else if (clave == "flush_bytes") {
+        set_int(valor, entero);
+        if (entero > 0) {
+          config.flushBytes = entero;
+        }
+      } else if (clave == "flush_ms") {
+        set_int(valor, config.flushMs);
+      } else if (clave == "buffers") {
+        set_int(valor, config.buffers);
+      } else if (clave == "backpressure_ms") {
+        set_int(valor, config.backpressureMs);
+      } else if (clave == "decimals") {
+        set_int(valor, config.decimals);
+      } else if (clave == "stats_every") {
+        set_int(valor, config.statsEvery);
+      } else if (clave == "rollup" && !valor.empty()) {
+        config.rollup = valor == "1" || valor == "true" || valor == "yes" || valor == "on";
+      } else if (clave == "rollup_sensors" && !valor.empty()) {
+        config.rollupSensors = split(valor, ',');
+      } else if (clave == "rollup_minutes") {
+        set_int(valor, config.rollupMinutes);
+      } else if (clave == "rollup_hours") {
+        set_int(valor, config.rollupHours);
+      } else if (clave == "rollup_days") {
+        set_int(valor, config.rollupDays);
+      } else if (clave == "rollup_grace_s") {
+        set_int(valor, config.rollupGrace);
+      } else if (clave == "rollup_max_series") {
+        set_int(valor, config.rollupMaxSeries);
+      } else if (clave == "rollup_state" && !valor.empty()) {
+        config.rollupState = valor == "none" ? "" : valor;
+      } else if (clave == "retention_1m" && !valor.empty()) {
+        config.retention1m = valor;
+      } else if (clave == "retention_1h" && !valor.empty()) {
+        config.retention1h = valor;
+      } else if (clave == "retention_1d" && !valor.empty()) {
+        config.retention1d = valor;
+      } else if (clave == "raw_retention") {
+        config.rawRetention = valor;
+      }
+    }
+  }
+  if (config.buffers < 2) {
+    config.buffers = 2;
+  }
+  return true;
+}
@@ -0,0 +1,71 @@
+#ifndef INGEST_CONFIG_H
+#define INGEST_CONFIG_H
+
+#include <string>
+#include <vector>
+
+/*
+///////////////// CONFIGURACION DEL PUENTE MQTT -> INFLUXDB \\\\\\\\\\\\\\\\\
+*/
+// Se lee el mismo main.conf que usa mqtt_sub.py: la seccion [MQTT] con el broker, los topics
+// y la base de datos, y una seccion [INGEST] opcional con los parametros propios del puente.
+
+/**
+ * @brief Parametros del puente. Los valores por defecto son los de una Raspberry con
+ * InfluxDB y Mosquitto en la misma maquina.
+ */
+struct IngestConfig {
+  // [MQTT]
+  std::string broker = "127.0.0.1";
+  int brokerPort = 1883;
+  std::vector<std::string> topics = {"+/+"};
+  int qos = 0;
+  std::string database = "plant_monitoring";
+  int timeout = 10;
+
+  // [INGEST]
+  std::string influxHost = "127.0.0.1";
+  int influxPort = 8086;
+  // Se envia el bloque al alcanzar este tamaño (bytes) o esta edad (ms)
+  size_t flushBytes = 64 * 1024;
+  int flushMs = 1000;
+  // Numero de bloques: uno se llena mientras los demas esperan o se escriben
+  int buffers = 4;
+  // Tiempo maximo (ms) que el hilo MQTT espera un bloque libre antes de descartar mensajes
+  int backpressureMs = 2000;
+  // Decimales de los valores (como round(valor, 1) en mqtt_sub.py); -1 no redondea
+  int decimals = 1;
+  // Periodo (s) del resumen de rendimiento en el log; 0 lo desactiva
+  int statsEvery = 60;
+
+  // Agregados por minuto, hora y dia (rollup.h) de los sensores indicados: summary es lo que
+  // publica el firmware por defecto y params el modo de una lectura por mensaje
+  bool rollup = true;
+  std::vector<std::string> rollupSensors = {"summary", "params", "coverage"};
+  // Ventanas que se guardan en memoria de cada nivel y espera (s) antes de escribir una cerrada
+  int rollupMinutes = 120;
+  int rollupHours = 48;
+  int rollupDays = 35;
+  int rollupGrace = 300;
+  int rollupMaxSeries = 4096;
+  // Fichero con las ventanas entre un arranque y el siguiente; vacio (none en main.conf) no
+  // las guarda
+  std::string rollupState = "/var/tmp/mqtt_ingest.rollups";
+  // Duracion de las politicas de retencion rollup_1m, rollup_1h y rollup_1d
+  std::string retention1m = "30d";
+  std::string retention1h = "730d";
+  std::string retention1d = "INF";
+  // Duracion de los datos sin agregar (politica autogen); vacia no la cambia
+  std::string rawRetention;
+};
+
+/**
+ * @brief Lee la configuracion de un fichero INI. Las claves ausentes conservan su valor.
+ *
+ * @param path Ruta del fichero.
+ * @param config Configuracion a completar.
+ * @return false si no se puede abrir el fichero.
+ */
+bool config_load(const char* path, IngestConfig& config);
+
+#endif // INGEST_CONFIG_H
@@ -0,0 +1,148 @@
+#include "influx_writer.h"
+#include "socket_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+InfluxWriter::InfluxWriter(const std::string& host, int port, const std::string& database, int timeoutMs)
+    : host(host), port(port), database(database), timeoutMs(timeoutMs), fd(-1) {}
+
+InfluxWriter::~InfluxWriter() {
+  disconnect();
+}
+
+void InfluxWriter::disconnect() {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+int InfluxWriter::write(const char* body, size_t len, const std::string& retention) {
+  std::string ruta = "/write?db=" + database + "&precision=ms";
+  if (!retention.empty()) {
+    ruta += "&rp=" + retention;
+  }
+  return request("POST", ruta, body, len);
+}
+
+int InfluxWriter::query(const std::string& statement) {
+  // Formulario q=...: espacios como + y comillas como %22 (el resto son nombres y duraciones)
+  std::string consulta = "q=";
+  for (char c : statement) {
+    if (c == ' ') {
+      consulta += '+';
+    } else if (c == '"') {
+      consulta += "%22";
+    } else {
+      consulta += c;
+    }
+  }
+  return request("POST", "/query", consulta.data(), consulta.size());
+}
+
+int InfluxWriter::create_database() {
+  return query("CREATE DATABASE \"" + database + "\"");
+}
+
+int InfluxWriter::create_retention_policy(const std::string& name, const std::string& duration) {
+  // CREATE falla si ya existe con otra duracion: ALTER la deja como indica la configuracion
+  int status = query("CREATE RETENTION POLICY \"" + name + "\" ON \"" + database + "\" DURATION " + duration +
+                     " REPLICATION 1");
+  if (status / 100 != 2) {
+    return status;
+  }
+  return query("ALTER RETENTION POLICY \"" + name + "\" ON \"" + database + "\" DURATION " + duration);
+}
+
+int InfluxWriter::alter_default_retention(const std::string& duration) {
+  return query("ALTER RETENTION POLICY \"autogen\" ON \"" + database + "\" DURATION " + duration);
+}
+
+int InfluxWriter::request(const char* method, const std::string& path, const char* body, size_t len) {
+  // Un reintento con una conexion nueva si el servidor ha cerrado la persistente
+  for (int intento = 0; intento < 2; intento++) {
+    if (fd < 0) {
+      fd = tcp_connect(host, port, timeoutMs);
+      if (fd < 0) {
+        return 0;
+      }
+    }
+
+    char cabecera[256];
+    int n = snprintf(cabecera, sizeof(cabecera),
+                     "%s %s HTTP/1.1\r\nHost: %s:%d\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n", method,
+                     path.c_str(), host.c_str(), port,
+                     path == "/query" ? "application/x-www-form-urlencoded" : "text/plain; charset=utf-8", len);
+
+    // Cabecera y cuerpo en una sola llamada, sin copiar el bloque
+    iovec partes[2] = {{cabecera, (size_t)n}, {(void*)body, len}};
+    size_t total = n + len;
+    ssize_t enviado = writev(fd, partes, 2);
+    bool ok = enviado > 0;
+    if (ok && (size_t)enviado < total) {
+      size_t resto = enviado;
+      ok = resto < (size_t)n ? send_all(fd, cabecera + resto, n - resto) && send_all(fd, body, len)
+                             : send_all(fd, body + (resto - n), total - resto);
+    }
+    int status = ok ? read_response() : 0;
+    if (status > 0) {
+      return status;
+    }
+    disconnect();
+  }
+  return 0;
+}
+
+int InfluxWriter::read_response() {
+  // Cabeceras completas; el cuerpo (errores de InfluxDB) se lee y se descarta
+  char buffer[4096];
+  size_t len = 0;
+  char* fin = nullptr;
+  while (fin == nullptr) {
+    if (len == sizeof(buffer) - 1) {
+      return 0;
+    }
+    ssize_t n = recv(fd, buffer + len, sizeof(buffer) - 1 - len, 0);
+    if (n <= 0) {
+      return 0;
+    }
+    len += n;
+    buffer[len] = '\0';
+    fin = strstr(buffer, "\r\n\r\n");
+  }
+
+  int status = 0;
+  if (sscanf(buffer, "HTTP/1.%*d %d", &status) != 1) {
+    return 0;
+  }
+  size_t contenido = 0;
+  bool cerrar = false;
+  for (char* linea = strstr(buffer, "\r\n"); linea != nullptr && linea < fin; linea = strstr(linea + 2, "\r\n")) {
+    if (strncasecmp(linea + 2, "Content-Length:", 15) == 0) {
+      contenido = strtoul(linea + 17, nullptr, 10);
+    } else if (strncasecmp(linea + 2, "Connection: close", 17) == 0) {
+      cerrar = true;
+    }
+  }
+
+  size_t leido = len - (fin + 4 - buffer);
+  if (status != 204 && leido > 0) {
+    fprintf(stderr, "InfluxDB %d: %.*s\n", status, (int)leido, fin + 4);
+  }
+  while (leido < contenido) {
+    ssize_t n = recv(fd, buffer, sizeof(buffer) < contenido - leido ? sizeof(buffer) : contenido - leido, 0);
+    if (n <= 0) {
+      return 0;
+    }
+    leido += n;
+  }
+  if (cerrar) {
+    disconnect();
+  }
+  return status;
+}
@@ -0,0 +1,61 @@
+#ifndef INGEST_INFLUX_WRITER_H
+#define INGEST_INFLUX_WRITER_H
+
+#include <stddef.h>
+#include <string>
+
+/*
+///////////////// ESCRITURA EN INFLUXDB \\\\\\\\\\\\\\\\\
+*/
+// Cliente HTTP/1.1 minimo para POST /write (InfluxDB 1.x) sobre una conexion persistente.
+
+class InfluxWriter {
+public:
+  InfluxWriter(const std::string& host, int port, const std::string& database, int timeoutMs);
+  ~InfluxWriter();
+
+  /**
+   * @brief Envia un bloque de lineas con precision de milisegundos.
+   *
+   * @param body Lineas en el protocolo de InfluxDB.
+   * @param len Longitud del bloque.
+   * @param retention Politica de retencion destino; vacia para la de por defecto.
+   * @return Codigo HTTP de la respuesta (204 si se ha escrito), o 0 si falla la conexion.
+   */
+  int write(const char* body, size_t len, const std::string& retention = "");
+
+  /**
+   * @brief Crea la base de datos si no existe (CREATE DATABASE es idempotente).
+   * @return Codigo HTTP de la respuesta, o 0 si falla la conexion.
+   */
+  int create_database();
+
+  /**
+   * @brief Crea una politica de retencion si no existe y le aplica la duracion indicada.
+   *
+   * @param name Nombre de la politica.
+   * @param duration Duracion en la sintaxis de InfluxQL (30d, 52w, INF...).
+   * @return Codigo HTTP de la ultima respuesta, o 0 si falla la conexion.
+   */
+  int create_retention_policy(const std::string& name, const std::string& duration);
+
+  /**
+   * @brief Cambia la duracion de la politica de retencion por defecto (autogen).
+   * @return Codigo HTTP de la respuesta, o 0 si falla la conexion.
+   */
+  int alter_default_retention(const std::string& duration);
+
+private:
+  std::string host;
+  int port;
+  std::string database;
+  int timeoutMs;
+  int fd;
+
+  int query(const std::string& statement);
+  int request(const char* method, const std::string& path, const char* body, size_t len);
+  int read_response();
+  void disconnect();
+};
+
+#endif // INGEST_INFLUX_WRITER_H
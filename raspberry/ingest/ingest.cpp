@@ -0,0 +1,306 @@
+#include "ingest.h"
+#include "line_protocol.h"
+#include <stdio.h>
+#include <string.h>
+
+// Espera entre reintentos de escritura: empieza en 100 ms y se dobla hasta 5 s
+static const int REINTENTO_INICIAL = 100;
+static const int REINTENTO_MAXIMO = 5000;
+// Reintentos de un bloque durante la parada antes de darlo por perdido
+static const int REINTENTOS_PARADA = 3;
+// Periodo de envio de las ventanas agregadas cerradas
+static const int AGREGADOS_MS = 1000;
+// Politica de retencion de cada nivel de agregados
+static const char* const RETENCIONES[ROLLUP_TIERS] = {"rollup_1m", "rollup_1h", "rollup_1d"};
+
+static uint64_t monotonic_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static int64_t unix_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static RollupConfig rollup_config(const IngestConfig& config) {
+  RollupConfig r;
+  r.slots[ROLLUP_MINUTE] = config.rollupMinutes;
+  r.slots[ROLLUP_HOUR] = config.rollupHours;
+  r.slots[ROLLUP_DAY] = config.rollupDays;
+  r.graceMs = config.rollupGrace * 1000LL;
+  r.maxSeries = config.rollupMaxSeries > 0 ? config.rollupMaxSeries : 0;
+  r.decimals = config.decimals;
+  return r;
+}
+
+static bool ends_with(const FieldView& campo, const char* sufijo) {
+  size_t n = strlen(sufijo);
+  return campo.nameLen >= n && memcmp(campo.name + campo.nameLen - n, sufijo, n) == 0;
+}
+
+Ingest::Ingest(const IngestConfig& config)
+    : config(config), pool(config.buffers, config.flushBytes),
+      writer(config.influxHost, config.influxPort, config.database, config.timeout * 1000), stopping(false),
+      current(nullptr), saturated(false), measurement(nullptr), measurementLen(0), sensor(nullptr), sensorLen(0),
+      messageMs(0), aggregate(false), summary(false), rollups(rollup_config(config)), rollupFlushedMs(0),
+      rollupLines(0), messages(0), lines(0), written(0), dropped(0), rejected(0), malformed(0), requests(0),
+      retries(0) {}
+
+Ingest::~Ingest() {
+  stop();
+}
+
+void Ingest::start() {
+  if (writer.create_database() / 100 != 2) {
+    fprintf(stderr, "No se ha podido crear la base de datos %s\n", config.database.c_str());
+  }
+  if (config.rollup && !config.rollupState.empty() && rollups.load(config.rollupState.c_str())) {
+    fprintf(stderr, "Agregados recuperados de %s: %zu series\n", config.rollupState.c_str(), rollups.series());
+  }
+  if (config.rollup) {
+    const std::string* duraciones[ROLLUP_TIERS] = {&config.retention1m, &config.retention1h, &config.retention1d};
+    for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+      if (writer.create_retention_policy(RETENCIONES[nivel], *duraciones[nivel]) / 100 != 2) {
+        fprintf(stderr, "No se ha podido crear la politica de retencion %s\n", RETENCIONES[nivel]);
+      }
+    }
+  }
+  if (!config.rawRetention.empty() && writer.alter_default_retention(config.rawRetention) / 100 != 2) {
+    fprintf(stderr, "No se ha podido cambiar la retencion de los datos sin agregar\n");
+  }
+  writerThread = std::thread(&Ingest::writer_loop, this);
+}
+
+void Ingest::stop() {
+  if (!writerThread.joinable()) {
+    return;
+  }
+  flush();
+  // Las ventanas abiertas solo si se guarda su estado: al arrancar de nuevo se recuperan y se
+  // siguen acumulando. Sin el, se escribirian de nuevo solo con las lecturas posteriores y
+  // sustituirian a las escritas ahora
+  if (config.rollup) {
+    bool guardar = !config.rollupState.empty();
+    flush_rollups(unix_ms(), guardar, config.backpressureMs);
+    if (guardar && !rollups.save(config.rollupState.c_str())) {
+      fprintf(stderr, "No se han podido guardar los agregados en %s\n", config.rollupState.c_str());
+    }
+  }
+  stopping = true;
+  pool.close();
+  writerThread.join();
+}
+
+void Ingest::message(const char* topic, size_t topicLen, const uint8_t* payload, size_t len) {
+  handle(topic, topicLen, payload, len, monotonic_ns(), unix_ms());
+}
+
+void Ingest::handle(const char* topic, size_t topicLen, const uint8_t* payload, size_t len, uint64_t arrivalNs,
+                    int64_t nowMs) {
+  // measurement = topic[0], sensor = topic[1] (los niveles siguientes se ignoran)
+  const char* barra = (const char*)memchr(topic, '/', topicLen);
+  if (barra == nullptr || barra == topic) {
+    malformed++;
+    return;
+  }
+  measurement = topic;
+  measurementLen = barra - topic;
+  sensor = barra + 1;
+  const char* fin = (const char*)memchr(sensor, '/', topic + topicLen - sensor);
+  sensorLen = (fin != nullptr ? fin : topic + topicLen) - sensor;
+  if (sensorLen == 0) {
+    malformed++;
+    return;
+  }
+  aggregate = false;
+  for (size_t i = 0; config.rollup && i < config.rollupSensors.size() && !aggregate; i++) {
+    aggregate = config.rollupSensors[i].compare(0, std::string::npos, sensor, sensorLen) == 0;
+  }
+  summary = sensorLen == 7 && memcmp(sensor, "summary", 7) == 0;
+
+  if (current == nullptr) {
+    current = pool.acquire(std::chrono::milliseconds(saturated ? 0 : config.backpressureMs));
+    saturated = current == nullptr;
+    if (saturated) {
+      dropped++;
+      return;
+    }
+  }
+
+  // Si el mensaje esta mal formado se deshacen las lineas que ya se hubieran añadido, igual
+  // que mqtt_sub.py descarta el mensaje completo
+  size_t bytesPrevios = current->data.size();
+  uint32_t lineasPrevias = current->lines;
+  messageMs = nowMs;
+  pendingFields.clear();
+  pendingPoints.clear();
+  if (!payload_decode(payload, len, nowMs, *this)) {
+    current->data.resize(bytesPrevios);
+    current->lines = lineasPrevias;
+    malformed++;
+    return;
+  }
+  for (const PendingPoint& p : pendingPoints) {
+    rollups.add(measurement, measurementLen, sensor, sensorLen, &pendingFields[p.first], p.count, p.timestampMs);
+  }
+  if (current->lines == lineasPrevias) {
+    return;
+  }
+
+  if (lineasPrevias == 0) {
+    current->opened = std::chrono::steady_clock::now();
+  }
+  current->arrivals.push_back(arrivalNs);
+  messages++;
+  lines += current->lines - lineasPrevias;
+  if (current->data.size() >= config.flushBytes) {
+    flush();
+  }
+}
+
+void Ingest::point(int64_t timestampMs, const FieldView* fields, size_t count) {
+  bool sinFecha = timestampMs == DECODER_UNDATED;
+  int64_t instante = timestampMs < 0 ? messageMs : timestampMs;
+  // Una lectura sin ningun valor finito (NaN en GORILLA_XOR) no genera linea
+  if (!line_append(current->data, measurement, measurementLen, sensor, sensorLen, fields, count, instante,
+                   config.decimals, sinFecha)) {
+    return;
+  }
+  current->lines++;
+  // Sin fecha conocida no se sabe a que ventana pertenece
+  if (!aggregate || sinFecha) {
+    return;
+  }
+  PendingPoint p = {instante, pendingFields.size(), 0};
+  for (size_t i = 0; i < count; i++) {
+    if (!summary || ends_with(fields[i], "_media") || ends_with(fields[i], "_min") || ends_with(fields[i], "_max")) {
+      pendingFields.push_back(fields[i]);
+    }
+  }
+  p.count = pendingFields.size() - p.first;
+  if (p.count > 0) {
+    pendingPoints.push_back(p);
+  }
+}
+
+void Ingest::tick() {
+  flush_batch_if_due();
+  int64_t ahora = unix_ms();
+  // Tambien si el reloj del sistema va hacia atras
+  if (config.rollup && (ahora - rollupFlushedMs >= AGREGADOS_MS || ahora < rollupFlushedMs)) {
+    flush_rollups(ahora, false, 0);
+    rollupFlushedMs = ahora;
+  }
+}
+
+void Ingest::tick(int64_t nowMs) {
+  flush_batch_if_due();
+  if (config.rollup && (nowMs - rollupFlushedMs >= AGREGADOS_MS || nowMs < rollupFlushedMs)) {
+    flush_rollups(nowMs, false, config.backpressureMs);
+    rollupFlushedMs = nowMs;
+  }
+}
+
+void Ingest::flush_batch_if_due() {
+  if (current != nullptr && current->lines > 0 &&
+      std::chrono::steady_clock::now() - current->opened >= std::chrono::milliseconds(config.flushMs)) {
+    flush();
+  }
+}
+
+void Ingest::flush_rollups(int64_t nowMs, bool force, int waitMs) {
+  for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+    while (true) {
+      // Sin bloques libres las ventanas siguen pendientes; al parar se espera como los mensajes
+      Batch* bloque = pool.acquire(std::chrono::milliseconds(waitMs));
+      if (bloque == nullptr) {
+        return;
+      }
+      uint32_t n = rollups.flush((RollupTier)nivel, nowMs, force, bloque->data, config.flushBytes);
+      if (n == 0) {
+        pool.release(bloque);
+        break;
+      }
+      bloque->lines = n;
+      bloque->retention = RETENCIONES[nivel];
+      bool completo = bloque->data.size() < config.flushBytes;
+      lines += n;
+      rollupLines += n;
+      pool.submit(bloque);
+      if (completo) {
+        break;
+      }
+    }
+  }
+}
+
+void Ingest::flush() {
+  if (current != nullptr && current->lines > 0) {
+    pool.submit(current);
+    current = nullptr;
+  }
+}
+
+void Ingest::writer_loop() {
+  while (true) {
+    Batch* batch = pool.next(std::chrono::milliseconds(200));
+    if (batch == nullptr) {
+      if (stopping) {
+        break;
+      }
+      continue;
+    }
+    write_batch(batch);
+    pool.release(batch);
+  }
+}
+
+void Ingest::write_batch(Batch* batch) {
+  int espera = REINTENTO_INICIAL;
+  int intentosParada = 0;
+  while (true) {
+    int status = writer.write(batch->data.data(), batch->data.size(), batch->retention);
+    if (status / 100 == 2) {
+      break;
+    }
+    if (status / 100 == 4) {
+      // Datos que InfluxDB no acepta: repetir no sirve de nada
+      fprintf(stderr, "InfluxDB ha rechazado %u lineas (HTTP %d)\n", batch->lines, status);
+      rejected += batch->lines;
+      return;
+    }
+    if (stopping && ++intentosParada > REINTENTOS_PARADA) {
+      fprintf(stderr, "Se pierden %u lineas al parar sin conexion con InfluxDB\n", batch->lines);
+      rejected += batch->lines;
+      return;
+    }
+    retries++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+    espera = espera * 2 < REINTENTO_MAXIMO ? espera * 2 : REINTENTO_MAXIMO;
+  }
+
+  uint64_t ahora = monotonic_ns();
+  for (uint64_t llegada : batch->arrivals) {
+    latencies.record((ahora - llegada) / 1000);
+  }
+  written += batch->lines;
+  requests++;
+}
+
+IngestStats Ingest::stats() const {
+  IngestStats s;
+  s.messages = messages;
+  s.lines = lines;
+  s.written = written;
+  s.dropped = dropped;
+  s.rejected = rejected;
+  s.malformed = malformed;
+  s.requests = requests;
+  s.retries = retries;
+  s.rollups = rollupLines;
+  RollupStats r = rollups.stats();
+  s.late = r.late;
+  s.series = rollups.series();
+  return s;
+}
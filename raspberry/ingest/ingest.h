@@ -0,0 +1,157 @@
+#ifndef INGEST_INGEST_H
+#define INGEST_INGEST_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "batch_pool.h"
+#include "config.h"
+#include "influx_writer.h"
+#include "latency.h"
+#include "mqtt_client.h"
+#include "payload_decoder.h"
+#include "rollup.h"
+
+/*
+///////////////// PUENTE MQTT -> INFLUXDB \\\\\\\\\\\\\\\\\
+*/
+// Cada mensaje <measurement>/<sensor> se decodifica sobre el propio buffer de recepcion y se
+// convierte en lineas del protocolo de InfluxDB dentro del bloque abierto. El bloque se entrega
+// al hilo escritor al llegar a flushBytes o al cumplir flushMs, de modo que una sola peticion
+// HTTP escribe cientos de mensajes.
+//
+// Las lecturas de los sensores de config.rollupSensors alimentan ademas los agregados por
+// minuto, hora y dia (rollup.h). Cada segundo, las ventanas cerradas de cada nivel se envian en
+// un bloque propio a su politica de retencion (rollup_1m, rollup_1h, rollup_1d); si no hay
+// bloques libres se quedan pendientes para la siguiente vez. Del resumen (<nodo>/summary) solo
+// se agregan la media, el minimo y el maximo de cada canal: el numero de lecturas y la
+// desviacion de la ventana del nodo no se pueden combinar como un valor mas.
+
+/**
+ * @brief Contadores acumulados desde el arranque.
+ */
+struct IngestStats {
+  uint64_t messages;   // mensajes convertidos en lineas
+  uint64_t lines;      // lineas generadas
+  uint64_t written;    // lineas confirmadas por InfluxDB
+  uint64_t dropped;    // mensajes descartados por falta de bloques libres
+  uint64_t rejected;   // lineas rechazadas por InfluxDB (error 4xx)
+  uint64_t malformed;  // mensajes o topics que no se pueden decodificar
+  uint64_t requests;   // peticiones de escritura con exito
+  uint64_t retries;    // peticiones repetidas por errores de conexion o 5xx
+  uint64_t rollups;    // ventanas agregadas enviadas (incluidas en lines y written)
+  uint64_t late;       // valores que llegan cuando su ventana ya ha salido del anillo
+  uint64_t series;     // series agregadas
+};
+
+class Ingest : public MqttHandler, private PointSink {
+public:
+  explicit Ingest(const IngestConfig& config);
+  ~Ingest();
+
+  /**
+   * @brief Arranca el hilo escritor (crea antes la base de datos si no existe).
+   */
+  void start();
+
+  /**
+   * @brief Envia el bloque abierto, espera a que se escriban los pendientes y detiene el
+   * hilo escritor.
+   */
+  void stop();
+
+  /**
+   * @brief Procesa un mensaje recibido.
+   *
+   * @param topic Topic del mensaje (sin terminador).
+   * @param topicLen Longitud del topic.
+   * @param payload Contenido del mensaje.
+   * @param len Longitud del contenido.
+   * @param arrivalNs Instante de llegada (ns, reloj monotono) para medir la latencia.
+   * @param nowMs Instante de llegada en ms desde la epoca Unix.
+   */
+  void handle(const char* topic, size_t topicLen, const uint8_t* payload, size_t len, uint64_t arrivalNs,
+              int64_t nowMs);
+
+  // MqttHandler: toma los instantes de llegada y llama a handle()
+  void message(const char* topic, size_t topicLen, const uint8_t* payload, size_t len) override;
+
+  /**
+   * @brief Envia el bloque abierto si ha superado flushMs y las ventanas agregadas ya
+   * cerradas. Se llama periodicamente desde el hilo MQTT.
+   */
+  void tick();
+
+  /**
+   * @brief Como tick(), con el reloj de los agregados indicado en lugar de la hora del sistema.
+   * Para reproducir trafico capturado (tools/mqtt_replay): las ventanas se cierran segun la
+   * hora de los mensajes y, sin bloques libres, se espera hasta backpressureMs como con ellos.
+   *
+   * @param nowMs Instante en ms desde la epoca Unix.
+   */
+  void tick(int64_t nowMs);
+
+  /**
+   * @brief Envia el bloque abierto aunque no este lleno.
+   */
+  void flush();
+
+  /**
+   * @brief Contadores. Los de los agregados son del hilo MQTT: se llama desde ese hilo o con
+   * el puente parado.
+   */
+  IngestStats stats() const;
+
+  /**
+   * @brief Latencia desde la llegada del mensaje hasta la confirmacion de InfluxDB (us).
+   */
+  LatencyHistogram& latency() { return latencies; }
+
+private:
+  IngestConfig config;
+  BatchPool pool;
+  InfluxWriter writer;
+  std::thread writerThread;
+  std::atomic<bool> stopping;
+  LatencyHistogram latencies;
+
+  // Estado del hilo MQTT //
+  Batch* current;
+  // Sin bloques libres en el ultimo intento: no se vuelve a esperar hasta que se libere uno
+  bool saturated;
+  // Mensaje en curso, para point()
+  const char* measurement;
+  size_t measurementLen;
+  const char* sensor;
+  size_t sensorLen;
+  int64_t messageMs;
+  // El sensor del mensaje en curso se agrega, y es el resumen del nodo
+  bool aggregate;
+  bool summary;
+  // Lecturas del mensaje en curso para los agregados: se añaden cuando se ha decodificado
+  // entero, para no agregar las de un mensaje mal formado. Los nombres de los campos apuntan
+  // a tablas estaticas o al mensaje, validos hasta el final de handle()
+  struct PendingPoint {
+    int64_t timestampMs;
+    size_t first;
+    size_t count;
+  };
+  std::vector<FieldView> pendingFields;
+  std::vector<PendingPoint> pendingPoints;
+  RollupEngine rollups;
+  // Ultimo envio de los agregados, en el reloj de tick()
+  int64_t rollupFlushedMs;
+
+  std::atomic<uint64_t> rollupLines;
+  std::atomic<uint64_t> messages, lines, written, dropped, rejected, malformed, requests, retries;
+
+  void point(int64_t timestampMs, const FieldView* fields, size_t count) override;
+  void flush_batch_if_due();
+  void flush_rollups(int64_t nowMs, bool force, int waitMs);
+  void writer_loop();
+  void write_batch(Batch* batch);
+};
+
+#endif // INGEST_INGEST_H
@@ -0,0 +1,79 @@
+#ifndef INGEST_LATENCY_H
+#define INGEST_LATENCY_H
+
+#include <atomic>
+#include <stdint.h>
+
+/*
+///////////////// HISTOGRAMA DE LATENCIAS \\\\\\\\\\\\\\\\\
+*/
+// Cubetas logaritmicas con cuatro subdivisiones por potencia de dos (error maximo ~19 %),
+// de 1 us a ~4 min. Se registra desde el hilo escritor y se lee desde cualquier otro sin
+// cerrojos: cada cubeta es un contador atomico independiente.
+
+class LatencyHistogram {
+public:
+  static const int BUCKETS = 4 * 27;
+
+  LatencyHistogram() { reset(); }
+
+  void record(uint64_t micros) {
+    counts[index(micros)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+  // Limite superior (us) de la cubeta que contiene el percentil indicado (0-100)
+  uint64_t percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) {
+      return 0;
+    }
+    uint64_t objetivo = (uint64_t)(n * p / 100.0);
+    if (objetivo >= n) {
+      objetivo = n - 1;
+    }
+    uint64_t acumulado = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      acumulado += counts[i].load(std::memory_order_relaxed);
+      if (acumulado > objetivo) {
+        return upper(i);
+      }
+    }
+    return upper(BUCKETS - 1);
+  }
+
+  void reset() {
+    for (int i = 0; i < BUCKETS; i++) {
+      counts[i].store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint64_t> counts[BUCKETS];
+  std::atomic<uint64_t> total;
+
+  // Indice: 4 * log2(valor) mas los dos bits siguientes al mas significativo
+  static int index(uint64_t micros) {
+    if (micros < 4) {
+      return (int)micros;
+    }
+    int exponente = 63 - __builtin_clzll(micros);
+    int sub = (int)((micros >> (exponente - 2)) & 3);
+    int i = 4 * (exponente - 1) + sub;
+    return i < BUCKETS ? i : BUCKETS - 1;
+  }
+
+  static uint64_t upper(int i) {
+    if (i < 4) {
+      return (uint64_t)i;
+    }
+    int exponente = i / 4 + 1;
+    uint64_t base = 1ull << exponente;
+    return base + (base >> 2) * (uint64_t)(i % 4 + 1) - 1;
+  }
+};
+
+#endif // INGEST_LATENCY_H
@@ -0,0 +1,112 @@
+#include "line_protocol.h"
+#include <charconv>
+#include <math.h>
+
+// Copia un identificador escapando los caracteres especiales del protocolo de lineas
+static void append_escaped(std::vector<char>& out, const char* text, size_t len, bool escapeEquals) {
+  for (size_t i = 0; i < len; i++) {
+    char c = text[i];
+    if (c == ',' || c == ' ' || (escapeEquals && c == '=')) {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+}
+
+static void append_number(std::vector<char>& out, double value) {
+  char numero[32];
+  std::to_chars_result r = std::to_chars(numero, numero + sizeof(numero), value);
+  out.insert(out.end(), numero, r.ptr);
+}
+
+static void append_integer(std::vector<char>& out, int64_t value) {
+  char numero[24];
+  std::to_chars_result r = std::to_chars(numero, numero + sizeof(numero), value);
+  out.insert(out.end(), numero, r.ptr);
+}
+
+static double rounded(double value, int decimals) {
+  static const double POTENCIAS[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  if (decimals < 0 || decimals > 6) {
+    return value;
+  }
+  return round(value * POTENCIAS[decimals]) / POTENCIAS[decimals];
+}
+
+// min, max y ultimo valor de una ventana: redondeados a decimals como las lineas sin agregar,
+// o sin redondear (decimals fuera de 0..6) el float mas corto que se lee igual
+static void append_float(std::vector<char>& out, float value, int decimals) {
+  if (decimals >= 0 && decimals <= 6) {
+    append_number(out, rounded(value, decimals));
+    return;
+  }
+  char numero[32];
+  std::to_chars_result r = std::to_chars(numero, numero + sizeof(numero), value);
+  out.insert(out.end(), numero, r.ptr);
+}
+
+bool line_append(std::vector<char>& out, const char* measurement, size_t measurementLen, const char* sensor,
+                 size_t sensorLen, const FieldView* fields, size_t count, int64_t timestampMs, int decimals,
+                 bool undated) {
+  static const double POTENCIAS[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  double escala = decimals >= 0 && decimals <= 6 ? POTENCIAS[decimals] : 0;
+  size_t finitos = 0;
+  for (size_t i = 0; i < count; i++) {
+    finitos += isfinite(fields[i].value);
+  }
+  if (finitos == 0) {
+    return false;
+  }
+
+  append_escaped(out, measurement, measurementLen, false);
+  out.insert(out.end(), {',', 's', 'e', 'n', 's', 'o', 'r', '='});
+  append_escaped(out, sensor, sensorLen, true);
+  if (undated) {
+    out.insert(out.end(), {',', 's', 'i', 'n', '_', 'f', 'e', 'c', 'h', 'a', '=', '1'});
+  }
+  out.push_back(' ');
+
+  size_t escritos = 0;
+  for (size_t i = 0; i < count; i++) {
+    double valor = fields[i].value;
+    if (!isfinite(valor)) {
+      continue;
+    }
+    if (escala > 0) {
+      valor = round(valor * escala) / escala;
+    }
+    if (escritos++ > 0) {
+      out.push_back(',');
+    }
+    append_escaped(out, fields[i].name, fields[i].nameLen, true);
+    out.push_back('=');
+    append_number(out, valor);
+  }
+  out.push_back(' ');
+  append_integer(out, timestampMs);
+  out.push_back('\n');
+  return true;
+}
+
+void line_append_window(std::vector<char>& out, const std::string& measurement, const std::string& sensor,
+                        const std::string& field, const RollupWindow& window, int decimals) {
+  append_escaped(out, measurement.data(), measurement.size(), false);
+  out.insert(out.end(), {',', 's', 'e', 'n', 's', 'o', 'r', '='});
+  append_escaped(out, sensor.data(), sensor.size(), true);
+  out.insert(out.end(), {',', 'c', 'a', 'm', 'p', 'o', '='});
+  append_escaped(out, field.data(), field.size(), true);
+
+  out.insert(out.end(), {' ', 'c', 'o', 'u', 'n', 't', '='});
+  append_integer(out, window.count);
+  out.insert(out.end(), {'i', ',', 'm', 'i', 'n', '='});
+  append_float(out, window.min, decimals);
+  out.insert(out.end(), {',', 'm', 'a', 'x', '='});
+  append_float(out, window.max, decimals);
+  out.insert(out.end(), {',', 's', 'u', 'm', '='});
+  append_number(out, rounded(window.sum, decimals));
+  out.insert(out.end(), {',', 'l', 'a', 's', 't', '='});
+  append_float(out, window.last, decimals);
+  out.push_back(' ');
+  append_integer(out, window.startMs);
+  out.push_back('\n');
+}
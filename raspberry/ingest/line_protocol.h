@@ -0,0 +1,52 @@
+#ifndef INGEST_LINE_PROTOCOL_H
+#define INGEST_LINE_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include "payload_decoder.h"
+#include "rollup.h"
+
+/*
+///////////////// PROTOCOLO DE LINEAS DE INFLUXDB \\\\\\\\\\\\\\\\\
+*/
+// measurement,sensor=<tag>[,sin_fecha=1] campo=valor,... <instante en ms>
+// Todos los campos se escriben como float (sin sufijo i), igual que hacia mqtt_sub.py.
+
+/**
+ * @brief Añade una linea al final del buffer sin reservar memoria si tiene capacidad.
+ *
+ * @param out Buffer destino.
+ * @param measurement Nombre de la medida (primer nivel del topic).
+ * @param measurementLen Longitud del nombre.
+ * @param sensor Valor de la etiqueta sensor (segundo nivel del topic).
+ * @param sensorLen Longitud de la etiqueta.
+ * @param fields Campos de la lectura.
+ * @param count Numero de campos.
+ * @param timestampMs Instante de la lectura en ms desde la epoca Unix.
+ * @param decimals Decimales a los que se redondean los valores, o -1 para no redondear.
+ * @param undated Lectura diferida sin fecha conocida, fechada al recibirla: se marca con la
+ * etiqueta sin_fecha=1 (como mqtt_sub.py).
+ * @return false si ningun valor es finito: no se añade nada (InfluxDB rechaza una linea sin
+ * campos, y con ella todo el bloque).
+ */
+bool line_append(std::vector<char>& out, const char* measurement, size_t measurementLen, const char* sensor,
+                 size_t sensorLen, const FieldView* fields, size_t count, int64_t timestampMs, int decimals,
+                 bool undated = false);
+
+/**
+ * @brief Añade la linea de una ventana agregada (ver rollup.h): etiquetas sensor y campo, y
+ * los campos count (entero), min, max, sum y last, fechada en el inicio de la ventana.
+ *
+ * @param out Buffer destino.
+ * @param measurement Nombre de la medida.
+ * @param sensor Valor de la etiqueta sensor.
+ * @param field Valor de la etiqueta campo (el campo agregado).
+ * @param window Ventana.
+ * @param decimals Decimales a los que se redondean los valores, o -1 para no redondear.
+ */
+void line_append_window(std::vector<char>& out, const std::string& measurement, const std::string& sensor,
+                        const std::string& field, const RollupWindow& window, int decimals);
+
+#endif // INGEST_LINE_PROTOCOL_H
@@ -0,0 +1,123 @@
+/*
+ * Puente MQTT -> InfluxDB en C++: sustituye a scripts/dir_mqtt/mqtt_sub.py cuando el numero de
+ * nodos o la frecuencia de publicacion saturan la Raspberry.
+ *
+ * Uso: mqtt_ingest [main.conf]   (por defecto $PATH_MGB/conf/main.conf)
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include "config.h"
+#include "ingest.h"
+#include "mqtt_client.h"
+
+// Keepalive MQTT (s), como el valor por defecto de paho
+static const uint16_t KEEPALIVE = 60;
+// Espera entre intentos de conexion con el broker: de 1 s a 30 s
+static const int RECONEXION_INICIAL = 1000;
+static const int RECONEXION_MAXIMA = 30000;
+// Espera maxima de cada pasada del bucle (cadencia de tick())
+static const int PASADA_MS = 50;
+
+static volatile sig_atomic_t parar = 0;
+
+static void on_signal(int) {
+  parar = 1;
+}
+
+static std::string client_id() {
+  char host[64] = "raspberry";
+  gethostname(host, sizeof(host) - 1);
+  return std::string("ingest-") + host + "-" + std::to_string(getpid());
+}
+
+static void log_stats(Ingest& ingest, IngestStats& previas, double segundos) {
+  IngestStats s = ingest.stats();
+  fprintf(stderr,
+          "%.0f msg/s, %.0f lineas/s, p50 %.1f ms, p99 %.1f ms | escritas %llu, descartados %llu, "
+          "rechazadas %llu, mal formados %llu, peticiones %llu, reintentos %llu | agregados %llu, "
+          "atrasados %llu, series %llu\n",
+          (s.messages - previas.messages) / segundos, (s.lines - previas.lines) / segundos,
+          ingest.latency().percentile(50) / 1000.0, ingest.latency().percentile(99) / 1000.0,
+          (unsigned long long)s.written, (unsigned long long)s.dropped, (unsigned long long)s.rejected,
+          (unsigned long long)s.malformed, (unsigned long long)s.requests, (unsigned long long)s.retries,
+          (unsigned long long)s.rollups, (unsigned long long)s.late, (unsigned long long)s.series);
+  ingest.latency().reset();
+  previas = s;
+}
+
+int main(int argc, char** argv) {
+  std::string ruta;
+  if (argc > 1) {
+    ruta = argv[1];
+  } else if (getenv("PATH_MGB") != nullptr) {
+    ruta = std::string(getenv("PATH_MGB")) + "/conf/main.conf";
+  } else {
+    fprintf(stderr, "Uso: %s [main.conf]\n", argv[0]);
+    return 1;
+  }
+
+  IngestConfig config;
+  try {
+    if (!config_load(ruta.c_str(), config)) {
+      fprintf(stderr, "No se puede leer %s\n", ruta.c_str());
+      return 1;
+    }
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Configuracion no valida en %s: %s\n", ruta.c_str(), e.what());
+    return 1;
+  }
+
+  struct sigaction accion = {};
+  accion.sa_handler = on_signal;
+  sigaction(SIGINT, &accion, nullptr);
+  sigaction(SIGTERM, &accion, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  Ingest ingest(config);
+  ingest.start();
+
+  MqttClient client;
+  std::string id = client_id();
+  int espera = RECONEXION_INICIAL;
+  IngestStats previas = ingest.stats();
+  auto ultimoInforme = std::chrono::steady_clock::now();
+
+  while (!parar) {
+    if (!client.connected()) {
+      if (client.connect(config.broker, config.brokerPort, id, KEEPALIVE, config.timeout * 1000) &&
+          client.subscribe(config.topics, config.qos)) {
+        fprintf(stderr, "Conectado con el broker %s, esperando datos...\n", config.broker.c_str());
+        espera = RECONEXION_INICIAL;
+      } else {
+        fprintf(stderr, "Sin conexion con el broker %s, reintento en %d ms\n", config.broker.c_str(), espera);
+        // Mientras tanto se envia lo que quede en el bloque abierto
+        ingest.flush();
+        for (int t = 0; t < espera && !parar; t += PASADA_MS) {
+          usleep(PASADA_MS * 1000);
+        }
+        espera = espera * 2 < RECONEXION_MAXIMA ? espera * 2 : RECONEXION_MAXIMA;
+        continue;
+      }
+    }
+
+    if (!client.poll(PASADA_MS, ingest)) {
+      fprintf(stderr, "Conexion con el broker perdida\n");
+    }
+    ingest.tick();
+
+    auto ahora = std::chrono::steady_clock::now();
+    double segundos = std::chrono::duration<double>(ahora - ultimoInforme).count();
+    if (config.statsEvery > 0 && segundos >= config.statsEvery) {
+      log_stats(ingest, previas, segundos);
+      ultimoInforme = ahora;
+    }
+  }
+
+  client.disconnect();
+  ingest.stop();
+  log_stats(ingest, previas, std::chrono::duration<double>(std::chrono::steady_clock::now() - ultimoInforme).count());
+  return 0;
+}
@@ -0,0 +1,258 @@
+#include "mqtt_client.h"
+#include "socket_util.h"
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Tipos de paquete (nibble alto de la cabecera fija)
+static const uint8_t CONNECT = 0x10;
+static const uint8_t CONNACK = 0x20;
+static const uint8_t PUBLISH = 0x30;
+static const uint8_t PUBACK = 0x40;
+static const uint8_t SUBSCRIBE = 0x82;
+static const uint8_t SUBACK = 0x90;
+static const uint8_t PINGREQ = 0xC0;
+static const uint8_t PINGRESP = 0xD0;
+
+// Tamaño inicial del buffer de recepcion y maximo de un paquete
+static const size_t RX_INICIAL = 64 * 1024;
+static const size_t RX_MAXIMO = 1024 * 1024;
+
+static void put_string(std::vector<uint8_t>& out, const std::string& text) {
+  out.push_back(text.size() >> 8);
+  out.push_back(text.size() & 0xFF);
+  out.insert(out.end(), text.begin(), text.end());
+}
+
+MqttClient::MqttClient() : fd(-1), rx(RX_INICIAL), rxLen(0), keepAlive(60), packetId(0), pubacks(0) {}
+
+MqttClient::~MqttClient() {
+  disconnect();
+}
+
+void MqttClient::disconnect() {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+  rxLen = 0;
+}
+
+bool MqttClient::send_packet(uint8_t type, const uint8_t* body, size_t len) {
+  uint8_t cabecera[5];
+  size_t n = 0;
+  cabecera[n++] = type;
+  size_t resto = len;
+  do {
+    uint8_t byte = resto & 0x7F;
+    resto >>= 7;
+    cabecera[n++] = byte | (resto > 0 ? 0x80 : 0);
+  } while (resto > 0);
+
+  if (!send_all(fd, cabecera, n) || (len > 0 && !send_all(fd, body, len))) {
+    disconnect();
+    return false;
+  }
+  lastSent = std::chrono::steady_clock::now();
+  return true;
+}
+
+bool MqttClient::connect(const std::string& host, int port, const std::string& clientId, uint16_t keepAlive,
+                         int timeoutMs) {
+  disconnect();
+  fd = tcp_connect(host, port, timeoutMs);
+  if (fd < 0) {
+    return false;
+  }
+  this->keepAlive = keepAlive;
+
+  std::vector<uint8_t> cuerpo;
+  put_string(cuerpo, "MQTT");
+  cuerpo.push_back(4);     // version 3.1.1
+  cuerpo.push_back(0x02);  // sesion limpia
+  cuerpo.push_back(keepAlive >> 8);
+  cuerpo.push_back(keepAlive & 0xFF);
+  put_string(cuerpo, clientId);
+  if (!send_packet(CONNECT, cuerpo.data(), cuerpo.size())) {
+    return false;
+  }
+
+  bool connack = false;
+  auto limite = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!connack && std::chrono::steady_clock::now() < limite) {
+    if (!receive(timeoutMs) || !process(nullptr, &connack)) {
+      disconnect();
+      return false;
+    }
+  }
+  if (!connack) {
+    disconnect();
+  }
+  lastReceived = std::chrono::steady_clock::now();
+  return connack;
+}
+
+bool MqttClient::subscribe(const std::vector<std::string>& topics, int qos) {
+  std::vector<uint8_t> cuerpo;
+  packetId = packetId == 0xFFFF ? 1 : packetId + 1;
+  cuerpo.push_back(packetId >> 8);
+  cuerpo.push_back(packetId & 0xFF);
+  for (const std::string& topic : topics) {
+    put_string(cuerpo, topic);
+    cuerpo.push_back(qos > 0 ? 1 : 0);
+  }
+  return send_packet(SUBSCRIBE, cuerpo.data(), cuerpo.size());
+}
+
+bool MqttClient::publish(const char* topic, size_t topicLen, const uint8_t* payload, size_t len, int qos) {
+  if (fd < 0) {
+    return false;
+  }
+  tx.clear();
+  tx.push_back(topicLen >> 8);
+  tx.push_back(topicLen & 0xFF);
+  tx.insert(tx.end(), topic, topic + topicLen);
+  if (qos > 0) {
+    packetId = packetId == 0xFFFF ? 1 : packetId + 1;
+    tx.push_back(packetId >> 8);
+    tx.push_back(packetId & 0xFF);
+  }
+  tx.insert(tx.end(), payload, payload + len);
+  return send_packet(PUBLISH | (qos > 0 ? 0x02 : 0), tx.data(), tx.size());
+}
+
+bool MqttClient::receive(int timeoutMs) {
+  pollfd p = {fd, POLLIN, 0};
+  int r = ::poll(&p, 1, timeoutMs);
+  if (r < 0) {
+    return errno == EINTR;
+  }
+  if (r == 0) {
+    return true;
+  }
+  if (rxLen == rx.size()) {
+    if (rx.size() >= RX_MAXIMO) {
+      return false;
+    }
+    rx.resize(rx.size() * 2);
+  }
+  ssize_t n = recv(fd, rx.data() + rxLen, rx.size() - rxLen, 0);
+  if (n <= 0) {
+    return n < 0 && (errno == EAGAIN || errno == EINTR);
+  }
+  rxLen += n;
+  lastReceived = std::chrono::steady_clock::now();
+  return true;
+}
+
+bool MqttClient::process(MqttHandler* handler, bool* connack) {
+  size_t pos = 0;
+  while (rxLen - pos >= 2) {
+    // Longitud restante: hasta cuatro bytes de 7 bits
+    size_t longitud = 0;
+    size_t cabecera = 1;
+    bool completa = false;
+    for (uint8_t desplazamiento = 0; cabecera < 5 && pos + cabecera < rxLen; desplazamiento += 7) {
+      uint8_t byte = rx[pos + cabecera++];
+      longitud |= (size_t)(byte & 0x7F) << desplazamiento;
+      if (!(byte & 0x80)) {
+        completa = true;
+        break;
+      }
+    }
+    if (!completa) {
+      if (cabecera >= 5) {
+        return false;
+      }
+      break;
+    }
+    if (cabecera + longitud > RX_MAXIMO) {
+      return false;
+    }
+    if (pos + cabecera + longitud > rxLen) {
+      break;
+    }
+
+    uint8_t tipo = rx[pos];
+    const uint8_t* cuerpo = rx.data() + pos + cabecera;
+    switch (tipo & 0xF0) {
+      case CONNACK:
+        if (longitud < 2 || cuerpo[1] != 0) {
+          return false;
+        }
+        if (connack != nullptr) {
+          *connack = true;
+        }
+        break;
+      case PUBLISH: {
+        if (longitud < 2) {
+          return false;
+        }
+        uint8_t qos = (tipo >> 1) & 3;
+        size_t topicLen = (size_t)cuerpo[0] << 8 | cuerpo[1];
+        size_t inicio = 2 + topicLen + (qos > 0 ? 2 : 0);
+        if (inicio > longitud) {
+          return false;
+        }
+        if (handler != nullptr) {
+          handler->message((const char*)cuerpo + 2, topicLen, cuerpo + inicio, longitud - inicio);
+        }
+        if (qos == 1) {
+          uint8_t id[2] = {cuerpo[2 + topicLen], cuerpo[3 + topicLen]};
+          if (!send_packet(PUBACK, id, 2)) {
+            return false;
+          }
+        }
+        break;
+      }
+      case PUBACK:
+        pubacks++;
+        break;
+      case SUBACK:
+        // 0x80 en el codigo de retorno: suscripcion rechazada
+        for (size_t i = 2; i < longitud; i++) {
+          if (cuerpo[i] == 0x80) {
+            return false;
+          }
+        }
+        break;
+      default:
+        // PINGRESP y cualquier otro paquete no necesitan respuesta
+        break;
+    }
+    pos += cabecera + longitud;
+  }
+
+  // Se conserva el paquete incompleto al principio del buffer
+  if (pos > 0) {
+    memmove(rx.data(), rx.data() + pos, rxLen - pos);
+    rxLen -= pos;
+  }
+  return true;
+}
+
+bool MqttClient::poll(int timeoutMs, MqttHandler& handler) {
+  if (fd < 0) {
+    return false;
+  }
+  if (!receive(timeoutMs) || !process(&handler, nullptr)) {
+    disconnect();
+    return false;
+  }
+
+  // Keepalive: PINGREQ a mitad del intervalo; sin noticias del broker en 1,5 intervalos se
+  // da la conexion por perdida
+  auto ahora = std::chrono::steady_clock::now();
+  if (keepAlive > 0) {
+    if (ahora - lastSent >= std::chrono::milliseconds(keepAlive * 500) && !send_packet(PINGREQ, nullptr, 0)) {
+      return false;
+    }
+    if (ahora - lastReceived >= std::chrono::milliseconds(keepAlive * 1500)) {
+      disconnect();
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,103 @@
+#ifndef INGEST_MQTT_CLIENT_H
+#define INGEST_MQTT_CLIENT_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+///////////////// CLIENTE MQTT 3.1.1 DE SUSCRIPCION \\\\\\\\\\\\\\\\\
+*/
+// Lo justo para suscribirse y recibir mensajes con QoS 0 o 1: CONNECT, SUBSCRIBE, PUBLISH,
+// PUBACK y PINGREQ. Los mensajes se entregan apuntando al buffer de recepcion, sin copiarlos.
+// Tambien publica con QoS 0 o 1, para las herramientas de carga y reproduccion (bench/).
+
+/**
+ * @brief Destino de los mensajes recibidos.
+ */
+class MqttHandler {
+public:
+  virtual ~MqttHandler() {}
+
+  /**
+   * @brief Recibe un mensaje. topic y payload solo son validos durante la llamada.
+   */
+  virtual void message(const char* topic, size_t topicLen, const uint8_t* payload, size_t len) = 0;
+};
+
+class MqttClient {
+public:
+  MqttClient();
+  ~MqttClient();
+
+  /**
+   * @brief Conecta con el broker con sesion limpia y espera el CONNACK.
+   *
+   * @param host Direccion del broker.
+   * @param port Puerto del broker.
+   * @param clientId Identificador del cliente.
+   * @param keepAlive Intervalo de keepalive en segundos.
+   * @param timeoutMs Timeout de la conexion.
+   * @return false si no se conecta o el broker la rechaza.
+   */
+  bool connect(const std::string& host, int port, const std::string& clientId, uint16_t keepAlive, int timeoutMs);
+
+  /**
+   * @brief Envia la suscripcion a los topics (la confirmacion llega en poll()).
+   *
+   * @param topics Filtros de topic.
+   * @param qos QoS maximo solicitado (0 o 1).
+   */
+  bool subscribe(const std::vector<std::string>& topics, int qos);
+
+  /**
+   * @brief Publica un mensaje. Con QoS 1 no espera el PUBACK: llega en poll() y se cuenta
+   * en acknowledged().
+   *
+   * @param topic Topic del mensaje.
+   * @param topicLen Longitud del topic.
+   * @param payload Contenido del mensaje.
+   * @param len Longitud del contenido.
+   * @param qos QoS (0 o 1).
+   * @return false si se ha perdido la conexion.
+   */
+  bool publish(const char* topic, size_t topicLen, const uint8_t* payload, size_t len, int qos);
+
+  /**
+   * @brief PUBACK recibidos desde que se creo el cliente.
+   */
+  uint64_t acknowledged() const { return pubacks; }
+
+  /**
+   * @brief Espera datos como mucho timeoutMs y entrega los mensajes completos recibidos.
+   * Envia el keepalive cuando corresponde.
+   *
+   * @return false si se ha perdido la conexion.
+   */
+  bool poll(int timeoutMs, MqttHandler& handler);
+
+  void disconnect();
+
+  bool connected() const { return fd >= 0; }
+
+private:
+  int fd;
+  std::vector<uint8_t> rx;
+  size_t rxLen;
+  uint16_t keepAlive;
+  uint16_t packetId;
+  uint64_t pubacks;
+  // Cabecera variable de PUBLISH, reutilizada entre mensajes
+  std::vector<uint8_t> tx;
+  std::chrono::steady_clock::time_point lastSent;
+  std::chrono::steady_clock::time_point lastReceived;
+
+  bool send_packet(uint8_t type, const uint8_t* body, size_t len);
+  bool receive(int timeoutMs);
+  // Procesa los paquetes completos del buffer; devuelve false si hay un error de protocolo
+  bool process(MqttHandler* handler, bool* connack);
+};
+
+#endif // INGEST_MQTT_CLIENT_H
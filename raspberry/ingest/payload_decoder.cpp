@@ -0,0 +1,614 @@
+#include "payload_decoder.h"
+#include <charconv>
+#include <initializer_list>
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// Campo de un mensaje binario: (bit de la mascara, nombre, tamaño, con signo, escala)
+struct BinaryField {
+  uint8_t bit;
+  const char* name;
+  uint8_t size;
+  bool isSigned;
+  double scale;
+};
+
+// Bit de la mascara reservado para la edad (segundos, uint32) en todos los tipos
+const uint8_t BIT_EDAD = 7;
+// Bit de la hora UTC de la adquisicion (ms, uint64) en lecturas, lotes y resumenes
+const uint8_t BIT_INSTANTE = 6;
+
+const BinaryField CAMPOS_V1[] = {
+  {0, "temperatura_sonda", 2, true, 10},
+  {1, "temperatura_dht", 2, true, 10},
+  {2, "humedad_capacitor", 2, true, 1},
+  {3, "humedad_dht", 2, true, 10},
+  {4, "dBm", 2, true, 1},
+};
+
+const BinaryField CAMPOS_ENLACE[] = {
+  {0, "conexiones", 4, false, 1},
+  {1, "perdidas", 4, false, 1},
+  {2, "intentos", 4, false, 1},
+  {3, "fallos", 4, false, 1},
+  {4, "perdidas_wifi", 4, false, 1},
+  {5, "reintentos_wifi", 4, false, 1},
+  {6, "latencia_ms", 4, false, 1},
+};
+
+const BinaryField CAMPOS_ARRANQUE[] = {
+  {0, "sensores_ms", 4, false, 1},
+  {1, "wifi_ms", 4, false, 1},
+  {2, "mqtt_ms", 4, false, 1},
+  {3, "publicacion_ms", 4, false, 1},
+  {4, "modo_wifi", 4, false, 1},
+};
+
+const BinaryField CAMPOS_MUESTREO[] = {
+  {0, "periodo_ms", 4, false, 1},
+  {1, "lecturas", 4, false, 1},
+  {2, "tiempo_s", 4, false, 1},
+  {3, "periodo_min_ms", 4, false, 1},
+  {4, "periodo_max_ms", 4, false, 1},
+};
+
+// Canales de un lote o de un resumen en el orden de la mascara, con su escala
+const uint8_t CANALES = 4;
+const char* const NOMBRES_CANALES[CANALES] = {"temperatura_sonda", "temperatura_dht", "humedad_capacitor", "humedad_dht"};
+const double ESCALAS_CANALES[CANALES] = {10, 10, 1, 10};
+
+// Campos del resumen de una ventana, por canal
+const char* const NOMBRES_RESUMEN[CANALES][5] = {
+  {"temperatura_sonda_n", "temperatura_sonda_min", "temperatura_sonda_max", "temperatura_sonda_media",
+   "temperatura_sonda_desv"},
+  {"temperatura_dht_n", "temperatura_dht_min", "temperatura_dht_max", "temperatura_dht_media", "temperatura_dht_desv"},
+  {"humedad_capacitor_n", "humedad_capacitor_min", "humedad_capacitor_max", "humedad_capacitor_media",
+   "humedad_capacitor_desv"},
+  {"humedad_dht_n", "humedad_dht_min", "humedad_dht_max", "humedad_dht_media", "humedad_dht_desv"},
+};
+
+FieldView field(const char* name, double value) {
+  return FieldView{name, (uint16_t)strlen(name), value};
+}
+
+/*
+///////////////// FORMATO BINARIO \\\\\\\\\\\\\\\\\
+*/
+// Lector little-endian con comprobacion de limites
+class Reader {
+public:
+  Reader(const uint8_t* data, size_t len) : data(data), len(len), pos(0), failed(false) {}
+
+  uint32_t uint(uint8_t size) {
+    if (pos + size > len) {
+      failed = true;
+      return 0;
+    }
+    uint32_t valor = 0;
+    for (uint8_t i = 0; i < size; i++) {
+      valor |= (uint32_t)data[pos + i] << (8 * i);
+    }
+    pos += size;
+    return valor;
+  }
+
+  int16_t int16() { return (int16_t)uint(2); }
+
+  uint64_t uint64() {
+    uint64_t bajo = uint(4);
+    return bajo | (uint64_t)uint(4) << 32;
+  }
+
+  uint32_t varint() {
+    uint32_t valor = 0;
+    for (uint8_t desplazamiento = 0; desplazamiento < 35; desplazamiento += 7) {
+      uint8_t byte = (uint8_t)uint(1);
+      if (failed) {
+        return 0;
+      }
+      valor |= (uint32_t)(byte & 0x7F) << desplazamiento;
+      if (!(byte & 0x80)) {
+        return valor;
+      }
+    }
+    failed = true;
+    return 0;
+  }
+
+  const uint8_t* bytes(size_t n) {
+    if (pos + n > len) {
+      failed = true;
+      return nullptr;
+    }
+    const uint8_t* inicio = data + pos;
+    pos += n;
+    return inicio;
+  }
+
+  size_t remaining() const { return failed ? 0 : len - pos; }
+
+  bool ok() const { return !failed; }
+
+private:
+  const uint8_t* data;
+  size_t len;
+  size_t pos;
+  bool failed;
+};
+
+// Hora de la lectura a partir de los campos opcionales del final del mensaje: la hora UTC
+// (solo en los tipos que la admiten) o la edad
+int64_t read_time(Reader& in, uint8_t mask, bool fechado, int64_t nowMs) {
+  int64_t instante = -1;
+  if (fechado && (mask & (1 << BIT_INSTANTE))) {
+    instante = (int64_t)in.uint64();
+  }
+  if (mask & (1 << BIT_EDAD)) {
+    uint32_t edad = in.uint(4);
+    if (instante < 0) {
+      instante = edad == PAYLOAD_AGE_UNKNOWN ? DECODER_UNDATED : nowMs - (int64_t)edad * 1000;
+    }
+  }
+  return instante;
+}
+
+bool decode_fields(Reader& in, uint8_t mask, const BinaryField* tabla, size_t n, bool fechado, int64_t nowMs,
+                   PointSink& sink) {
+  FieldView campos[DECODER_MAX_FIELDS];
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!(mask & (1 << tabla[i].bit))) {
+      continue;
+    }
+    uint32_t crudo = in.uint(tabla[i].size);
+    double valor = tabla[i].isSigned ? (double)(int16_t)crudo : (double)crudo;
+    campos[count++] = field(tabla[i].name, valor / tabla[i].scale);
+  }
+  int64_t instante = read_time(in, mask, fechado, nowMs);
+  if (!in.ok()) {
+    return false;
+  }
+  if (count > 0) {
+    sink.point(instante, campos, count);
+  }
+  return true;
+}
+
+bool decode_batch(Reader& in, uint8_t mask, int64_t nowMs, PointSink& sink) {
+  uint8_t n = (uint8_t)in.uint(1);
+  int64_t instantes[DECODER_MAX_POINTS];
+  if (mask & (1 << BIT_INSTANTE)) {
+    instantes[0] = (int64_t)in.uint64();
+  } else {
+    uint32_t edad = in.uint(4);
+    instantes[0] = edad == PAYLOAD_AGE_UNKNOWN ? DECODER_UNDATED : nowMs - (int64_t)edad;
+  }
+  for (uint16_t i = 1; i < n; i++) {
+    int64_t delta = in.varint();
+    instantes[i] = instantes[0] == DECODER_UNDATED ? DECODER_UNDATED : instantes[i - 1] + delta;
+  }
+
+  static thread_local FieldView lecturas[DECODER_MAX_POINTS][CANALES];
+  uint8_t campos[DECODER_MAX_POINTS] = {0};
+  size_t mapa = (n + 7) / 8;
+  for (uint8_t canal = 0; canal < CANALES; canal++) {
+    if (!(mask & (1 << canal))) {
+      continue;
+    }
+    const uint8_t* presentes = in.bytes(mapa);
+    if (presentes == nullptr) {
+      return false;
+    }
+    bool primero = true;
+    int32_t valor = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      if (!(presentes[i / 8] & (1 << (i % 8)))) {
+        continue;
+      }
+      if (primero) {
+        valor = in.int16();
+        primero = false;
+      } else {
+        uint32_t zigzag = in.varint();
+        valor += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+      }
+      lecturas[i][campos[i]++] = field(NOMBRES_CANALES[canal], valor / ESCALAS_CANALES[canal]);
+    }
+  }
+  if (!in.ok()) {
+    return false;
+  }
+  for (uint16_t i = 0; i < n; i++) {
+    if (campos[i] > 0) {
+      sink.point(instantes[i], lecturas[i], campos[i]);
+    }
+  }
+  return true;
+}
+
+/*
+///////////////// LOTES COMPRIMIDOS \\\\\\\\\\\\\\\\\
+*/
+// Flujo de bits de lib/gorilla: el bit mas significativo de cada byte primero
+class BitReader {
+public:
+  BitReader(const uint8_t* data, size_t len) : data(data), bits(len * 8), pos(0), failed(false) {}
+
+  uint32_t get(uint8_t n) {
+    if (pos + n > bits) {
+      failed = true;
+      return 0;
+    }
+    uint32_t valor = 0;
+    for (uint8_t i = 0; i < n; i++, pos++) {
+      valor = valor << 1 | ((data[pos >> 3] >> (7 - (pos & 7))) & 1);
+    }
+    return valor;
+  }
+
+  bool ok() const { return !failed; }
+
+private:
+  const uint8_t* data;
+  size_t bits;
+  size_t pos;
+  bool failed;
+};
+
+// Codificacion de los valores (GorillaMode en lib/gorilla/gorilla.h)
+const uint8_t GORILLA_QUANTIZED = 0;
+const uint8_t GORILLA_XOR = 1;
+// humedad_capacitor es entero tambien en GORILLA_XOR
+const uint8_t CANAL_CAPACITOR = 2;
+
+int32_t unzigzag(uint32_t valor) {
+  return (int32_t)(valor >> 1) ^ -(int32_t)(valor & 1);
+}
+
+// Diferencia de la diferencia de tiempo, con el codigo de longitud de su zigzag
+uint32_t read_dod(BitReader& in) {
+  if (in.get(1) == 0) {
+    return 0;
+  }
+  if (in.get(1) == 0) {
+    return (uint32_t)unzigzag(in.get(7));
+  }
+  if (in.get(1) == 0) {
+    return (uint32_t)unzigzag(in.get(9));
+  }
+  if (in.get(1) == 0) {
+    return (uint32_t)unzigzag(in.get(12));
+  }
+  return in.get(32);
+}
+
+// 0 si no cambia; 1 y zigzag - 1 en grupos de 3 bits con bit de continuacion
+int32_t read_integer(BitReader& in) {
+  if (in.get(1) == 0) {
+    return 0;
+  }
+  uint32_t valor = 0;
+  for (uint8_t desplazamiento = 0; desplazamiento < 33; desplazamiento += 3) {
+    uint32_t grupo = in.get(4);
+    valor |= (grupo & 0x7) << desplazamiento;
+    if (!(grupo & 0x8)) {
+      return unzigzag(valor + 1);
+    }
+  }
+  return 0;
+}
+
+struct XorChannel {
+  uint32_t bits;
+  uint8_t leading;
+  uint8_t trailing;
+};
+
+// Bits del float: XOR con el anterior dentro de su ventana o con una ventana nueva
+uint32_t read_float(BitReader& in, XorChannel& canal) {
+  if (in.get(1) == 0) {
+    return canal.bits;
+  }
+  if (in.get(1) == 1) {
+    canal.leading = (uint8_t)in.get(5);
+    uint8_t longitud = (uint8_t)in.get(5) + 1;
+    canal.trailing = canal.leading + longitud > 32 ? 0 : 32 - canal.leading - longitud;
+  }
+  uint8_t longitud = 32 - canal.leading - canal.trailing;
+  canal.bits ^= in.get(longitud) << canal.trailing;
+  return canal.bits;
+}
+
+// Valor mas corto que vuelve a dar el mismo float (23.4 y no 23.399999618530273)
+double shortest(uint32_t bits) {
+  float valor;
+  memcpy(&valor, &bits, sizeof(valor));
+  char texto[32];
+  std::to_chars_result r = std::to_chars(texto, texto + sizeof(texto), valor);
+  double corto = valor;
+  std::from_chars(texto, r.ptr, corto);
+  return corto;
+}
+
+bool decode_gorilla(Reader& in, uint8_t mask, int64_t nowMs, PointSink& sink) {
+  uint8_t n = (uint8_t)in.uint(1);
+  int64_t instante;
+  if (mask & (1 << BIT_INSTANTE)) {
+    instante = (int64_t)in.uint64();
+  } else {
+    uint32_t edad = in.uint(4);
+    instante = edad == PAYLOAD_AGE_UNKNOWN ? DECODER_UNDATED : nowMs - (int64_t)edad;
+  }
+  bool sinFecha = instante == DECODER_UNDATED;
+  uint8_t modo = (uint8_t)in.uint(1);
+  if (!in.ok() || modo > GORILLA_XOR) {
+    return false;
+  }
+  size_t resto = in.remaining();
+  BitReader bits(in.bytes(resto), resto);
+
+  static thread_local FieldView lecturas[DECODER_MAX_POINTS][CANALES];
+  uint8_t campos[DECODER_MAX_POINTS] = {0};
+  int64_t instantes[DECODER_MAX_POINTS];
+  uint32_t delta = 0;
+  uint8_t presentes = 0;
+  int32_t enteros[CANALES] = {0};
+  XorChannel reales[CANALES] = {};
+  for (uint16_t i = 0; i < n; i++) {
+    // La primera lectura es la base de tiempo; las diferencias tienen signo
+    delta += read_dod(bits);
+    if (!sinFecha) {
+      instante += (int32_t)delta;
+    }
+    instantes[i] = instante;
+    if (bits.get(1) == 1) {
+      presentes = (uint8_t)bits.get(4);
+    }
+    for (uint8_t canal = 0; canal < CANALES; canal++) {
+      if (!(presentes & (1 << canal))) {
+        continue;
+      }
+      double valor;
+      if (modo == GORILLA_XOR && canal != CANAL_CAPACITOR) {
+        valor = shortest(read_float(bits, reales[canal]));
+      } else {
+        enteros[canal] += read_integer(bits);
+        valor = enteros[canal] / ESCALAS_CANALES[canal];
+      }
+      lecturas[i][campos[i]++] = field(NOMBRES_CANALES[canal], valor);
+    }
+  }
+  if (!bits.ok()) {
+    return false;
+  }
+  for (uint16_t i = 0; i < n; i++) {
+    if (campos[i] > 0) {
+      sink.point(instantes[i], lecturas[i], campos[i]);
+    }
+  }
+  return true;
+}
+
+bool decode_summary(Reader& in, uint8_t mask, int64_t nowMs, PointSink& sink) {
+  FieldView campos[1 + 5 * CANALES];
+  size_t count = 0;
+  campos[count++] = field("ventana_ms", in.uint(4));
+  for (uint8_t canal = 0; canal < CANALES; canal++) {
+    if (!(mask & (1 << canal))) {
+      continue;
+    }
+    double escala = ESCALAS_CANALES[canal];
+    campos[count++] = field(NOMBRES_RESUMEN[canal][0], in.uint(2));
+    campos[count++] = field(NOMBRES_RESUMEN[canal][1], in.int16() / escala);
+    campos[count++] = field(NOMBRES_RESUMEN[canal][2], in.int16() / escala);
+    campos[count++] = field(NOMBRES_RESUMEN[canal][3], in.int16() / (escala * 10));
+    campos[count++] = field(NOMBRES_RESUMEN[canal][4], in.uint(2) / (escala * 10));
+  }
+  int64_t instante = read_time(in, mask, true, nowMs);
+  if (!in.ok()) {
+    return false;
+  }
+  sink.point(instante, campos, count);
+  return true;
+}
+
+bool decode_binary(const uint8_t* data, size_t len, int64_t nowMs, PointSink& sink) {
+  if (len < 3) {
+    return false;
+  }
+  Reader in(data + 3, len - 3);
+  uint8_t mask = data[2];
+  switch (data[1]) {
+    case PAYLOAD_TYPE_BATCH:
+      return decode_batch(in, mask, nowMs, sink);
+    case PAYLOAD_TYPE_GORILLA:
+      return decode_gorilla(in, mask, nowMs, sink);
+    case PAYLOAD_TYPE_SUMMARY:
+      return decode_summary(in, mask, nowMs, sink);
+    case PAYLOAD_TYPE_LINK:
+      return decode_fields(in, mask, CAMPOS_ENLACE, sizeof(CAMPOS_ENLACE) / sizeof(CAMPOS_ENLACE[0]), false, nowMs,
+                           sink);
+    case PAYLOAD_TYPE_BOOT:
+      return decode_fields(in, mask, CAMPOS_ARRANQUE, sizeof(CAMPOS_ARRANQUE) / sizeof(CAMPOS_ARRANQUE[0]), false,
+                           nowMs, sink);
+    case PAYLOAD_TYPE_SAMPLER:
+      return decode_fields(in, mask, CAMPOS_MUESTREO, sizeof(CAMPOS_MUESTREO) / sizeof(CAMPOS_MUESTREO[0]), false,
+                           nowMs, sink);
+    default:
+      return decode_fields(in, mask, CAMPOS_V1, sizeof(CAMPOS_V1) / sizeof(CAMPOS_V1[0]), true, nowMs, sink);
+  }
+}
+
+/*
+///////////////// FORMATO JSON \\\\\\\\\\\\\\\\\
+*/
+// Analizador minimo para los documentos de los nodos: un objeto plano con numeros, o un lote
+// {"t0" | "ts": ..., "dt": [...], "<canal>": [numero | null, ...]}. Las claves no llevan escapes.
+
+class JsonScanner {
+public:
+  JsonScanner(const char* data, size_t len) : p(data), end(data + len) {}
+
+  void skip_spaces() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+      p++;
+    }
+  }
+
+  bool consume(char c) {
+    skip_spaces();
+    if (p < end && *p == c) {
+      p++;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    skip_spaces();
+    return p < end && *p == c;
+  }
+
+  // Cadena entre comillas; devuelve su contenido sin copiarlo
+  bool string(const char** inicio, uint16_t* len) {
+    if (!consume('"')) {
+      return false;
+    }
+    const char* s = p;
+    while (p < end && *p != '"') {
+      p += *p == '\\' ? 2 : 1;
+    }
+    if (p >= end) {
+      return false;
+    }
+    *inicio = s;
+    *len = (uint16_t)(p - s);
+    p++;
+    return true;
+  }
+
+  // Numero, o null (valor NAN). Las cadenas y los booleanos se saltan como NAN
+  bool value(double* valor) {
+    skip_spaces();
+    if (p >= end) {
+      return false;
+    }
+    if (*p == '"') {
+      const char* s;
+      uint16_t n;
+      *valor = NAN;
+      return string(&s, &n);
+    }
+    for (const char* literal : {"null", "true", "false"}) {
+      size_t n = strlen(literal);
+      if ((size_t)(end - p) >= n && memcmp(p, literal, n) == 0) {
+        p += n;
+        *valor = NAN;
+        return true;
+      }
+    }
+    std::from_chars_result r = std::from_chars(p, end, *valor);
+    if (r.ec != std::errc()) {
+      return false;
+    }
+    p = r.ptr;
+    return true;
+  }
+
+private:
+  const char* p;
+  const char* end;
+};
+
+bool key_is(const char* nombre, uint16_t len, const char* clave) {
+  return strlen(clave) == len && memcmp(nombre, clave, len) == 0;
+}
+
+bool decode_json(const char* data, size_t len, int64_t nowMs, PointSink& sink) {
+  JsonScanner json(data, len);
+  if (!json.consume('{')) {
+    return false;
+  }
+
+  FieldView campos[DECODER_MAX_FIELDS];
+  size_t count = 0;
+  int64_t instante = -1;
+
+  // Lote: una columna por canal
+  static thread_local FieldView lecturas[DECODER_MAX_POINTS][DECODER_MAX_FIELDS];
+  uint8_t camposLectura[DECODER_MAX_POINTS] = {0};
+  int64_t instantes[DECODER_MAX_POINTS] = {0};
+  size_t puntos = 0;
+  bool lote = false;
+
+  while (!json.consume('}')) {
+    const char* nombre;
+    uint16_t nombreLen;
+    if (!json.string(&nombre, &nombreLen) || !json.consume(':')) {
+      return false;
+    }
+
+    if (json.consume('[')) {
+      // "dt": diferencias de tiempo; cualquier otra lista es la columna de un canal
+      bool tiempos = key_is(nombre, nombreLen, "dt");
+      size_t i = tiempos ? 1 : 0;
+      while (!json.consume(']')) {
+        double valor;
+        if (!json.value(&valor) || i >= DECODER_MAX_POINTS) {
+          return false;
+        }
+        if (tiempos) {
+          instantes[i] = instantes[0] == DECODER_UNDATED ? DECODER_UNDATED : instantes[i - 1] + (int64_t)valor;
+        } else if (!isnan(valor) && camposLectura[i] < DECODER_MAX_FIELDS) {
+          lecturas[i][camposLectura[i]++] = FieldView{nombre, nombreLen, valor};
+        }
+        i++;
+        json.consume(',');
+      }
+      lote = lote || tiempos;
+      puntos = i > puntos ? i : puntos;
+    } else {
+      double valor;
+      if (!json.value(&valor)) {
+        return false;
+      }
+      if (key_is(nombre, nombreLen, "t0")) {
+        lote = true;
+        instantes[0] = valor == PAYLOAD_AGE_UNKNOWN ? DECODER_UNDATED : nowMs - (int64_t)valor;
+      } else if (key_is(nombre, nombreLen, "ts")) {
+        instantes[0] = (int64_t)valor;
+        instante = instantes[0];
+      } else if (key_is(nombre, nombreLen, "edad")) {
+        if (instante < 0) {
+          instante = valor == PAYLOAD_AGE_UNKNOWN ? DECODER_UNDATED : nowMs - (int64_t)(valor * 1000);
+        }
+      } else if (!isnan(valor) && count < DECODER_MAX_FIELDS) {
+        campos[count++] = FieldView{nombre, nombreLen, valor};
+      }
+    }
+    json.consume(',');
+  }
+
+  if (lote) {
+    // "t0" o "ts" siempre preceden a "dt" en los lotes del firmware
+    for (size_t i = 0; i < puntos; i++) {
+      if (camposLectura[i] > 0) {
+        sink.point(instantes[i], lecturas[i], camposLectura[i]);
+      }
+    }
+  } else if (count > 0) {
+    sink.point(instante, campos, count);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool payload_decode(const uint8_t* data, size_t len, int64_t nowMs, PointSink& sink) {
+  if (len > 0 && data[0] == PAYLOAD_BINARY_V1) {
+    return decode_binary(data, len, nowMs, sink);
+  }
+  return decode_json((const char*)data, len, nowMs, sink);
+}
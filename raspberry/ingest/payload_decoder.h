@@ -0,0 +1,75 @@
+#ifndef INGEST_PAYLOAD_DECODER_H
+#define INGEST_PAYLOAD_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+///////////////// DECODIFICACION DE LOS MENSAJES DE LOS NODOS \\\\\\\\\\\\\\\\\
+*/
+// Version en C++ de func/payload.py (decode_points): acepta el formato binario compacto de
+// lib/payload y el JSON. No copia el mensaje: los nombres de los campos apuntan a tablas
+// estaticas o al propio buffer recibido.
+
+// Primer byte de un mensaje binario y tipos de mensaje (lib/payload/payload.h)
+#define PAYLOAD_BINARY_V1 0xB1
+#define PAYLOAD_TYPE_BATCH 3
+#define PAYLOAD_TYPE_LINK 4
+#define PAYLOAD_TYPE_BOOT 5
+#define PAYLOAD_TYPE_SUMMARY 6
+#define PAYLOAD_TYPE_SAMPLER 7
+#define PAYLOAD_TYPE_GORILLA 8
+
+// Edad de un mensaje guardado por el nodo en un arranque anterior sin la hora UTC (s, o ms en
+// los lotes): no se sabe cuando se tomo
+#define PAYLOAD_AGE_UNKNOWN 0xFFFFFFFFUL
+
+// Instante de las lecturas diferidas sin fecha conocida en PointSink::point()
+#define DECODER_UNDATED -2
+
+// Numero maximo de campos de una lectura y de lecturas de un lote
+#define DECODER_MAX_FIELDS 24
+#define DECODER_MAX_POINTS 256
+
+/**
+ * @brief Campo de una lectura: nombre (sin terminador) y valor.
+ */
+struct FieldView {
+  const char* name;
+  uint16_t nameLen;
+  double value;
+};
+
+/**
+ * @brief Destino de las lecturas decodificadas.
+ */
+class PointSink {
+public:
+  virtual ~PointSink() {}
+
+  /**
+   * @brief Recibe una lectura.
+   *
+   * @param timestampMs Hora UTC de la adquisicion en ms desde la epoca Unix (fechada en el
+   * nodo, o deducida de su edad), -1 si es en tiempo real, o DECODER_UNDATED si es diferida y
+   * no se sabe cuando se tomo.
+   * @param fields Campos de la lectura (validos solo durante la llamada).
+   * @param count Numero de campos (al menos uno).
+   */
+  virtual void point(int64_t timestampMs, const FieldView* fields, size_t count) = 0;
+};
+
+/**
+ * @brief Decodifica un mensaje y entrega cada lectura al destino. Las lecturas sin ningun
+ * campo no se entregan.
+ *
+ * @param data Contenido del mensaje MQTT.
+ * @param len Longitud del mensaje.
+ * @param nowMs Hora de recepcion en ms desde la epoca Unix, para fechar las lecturas que solo
+ * indican su edad.
+ * @param sink Destino de las lecturas.
+ * @return false si el mensaje esta mal formado (puede haber entregado lecturas anteriores).
+ */
+bool payload_decode(const uint8_t* data, size_t len, int64_t nowMs, PointSink& sink);
+
+#endif // INGEST_PAYLOAD_DECODER_H
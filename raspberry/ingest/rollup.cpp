@@ -0,0 +1,250 @@
+#include "rollup.h"
+#include "line_protocol.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+const int64_t RollupEngine::WINDOW_MS[ROLLUP_TIERS] = {60 * 1000LL, 3600 * 1000LL, 86400 * 1000LL};
+
+static const char MARCA[8] = {'R', 'O', 'L', 'L', 'U', 'P', 'S', '1'};
+
+// Inicio de la ventana que contiene el instante (tambien para instantes negativos)
+static int64_t window_start(int64_t timestampMs, int64_t length) {
+  int64_t inicio = timestampMs - timestampMs % length;
+  return timestampMs % length < 0 ? inicio - length : inicio;
+}
+
+RollupEngine::RollupEngine(const RollupConfig& config) : config(config), slotsPerSeries(0), counters() {
+  for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+    if (this->config.slots[nivel] < 1) {
+      this->config.slots[nivel] = 1;
+    }
+    offsets[nivel] = slotsPerSeries;
+    due[nivel] = INT64_MAX;
+    slotsPerSeries += this->config.slots[nivel];
+  }
+  static const double POTENCIAS[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  scale = config.decimals >= 0 && config.decimals <= 6 ? POTENCIAS[config.decimals] : 0;
+  index.reserve(config.maxSeries);
+}
+
+RollupEngine::Series* RollupEngine::find(const char* measurement, size_t measurementLen, const char* sensor,
+                                         size_t sensorLen, const FieldView& field) {
+  // medicion, sensor y campo separados por un caracter que no puede aparecer en un topic
+  key.assign(measurement, measurementLen);
+  key.push_back('\0');
+  key.append(sensor, sensorLen);
+  key.push_back('\0');
+  key.append(field.name, field.nameLen);
+
+  auto it = index.find(key);
+  if (it != index.end()) {
+    return &all[it->second];
+  }
+  if (all.size() >= config.maxSeries) {
+    return nullptr;
+  }
+
+  Series nueva;
+  nueva.measurement.assign(measurement, measurementLen);
+  nueva.sensor.assign(sensor, sensorLen);
+  nueva.field.assign(field.name, field.nameLen);
+  nueva.windows.reset(new RollupWindow[slotsPerSeries]);
+  for (size_t i = 0; i < slotsPerSeries; i++) {
+    nueva.windows[i].startMs = -1;
+    nueva.windows[i].dirty = false;
+    nueva.windows[i].written = false;
+  }
+  index.emplace(key, (uint32_t)all.size());
+  all.push_back(std::move(nueva));
+  return &all.back();
+}
+
+void RollupEngine::add(const char* measurement, size_t measurementLen, const char* sensor, size_t sensorLen,
+                       const FieldView* fields, size_t count, int64_t timestampMs) {
+  for (size_t i = 0; i < count; i++) {
+    double valor = fields[i].value;
+    if (!isfinite(valor)) {
+      continue;
+    }
+    if (scale > 0) {
+      valor = round(valor * scale) / scale;
+    }
+    Series* serie = find(measurement, measurementLen, sensor, sensorLen, fields[i]);
+    if (serie == nullptr) {
+      counters.overflow++;
+      continue;
+    }
+    counters.values++;
+
+    for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+      int64_t longitud = WINDOW_MS[nivel];
+      int64_t inicio = window_start(timestampMs, longitud);
+      int64_t huecos = config.slots[nivel];
+      int64_t numero = inicio / longitud;
+      RollupWindow& ventana = serie->windows[offsets[nivel] + (size_t)(((numero % huecos) + huecos) % huecos)];
+
+      if (ventana.startMs != inicio) {
+        // El hueco tiene una ventana mas reciente: la lectura ya ha salido del anillo
+        if (ventana.startMs > inicio) {
+          counters.late++;
+          continue;
+        }
+        // La ventana anterior del hueco ya estaba cerrada; si no se ha escrito, se pierde
+        if (ventana.dirty) {
+          counters.late += ventana.count;
+        }
+        ventana.startMs = inicio;
+        ventana.lastMs = 0;
+        ventana.min = valor;
+        ventana.max = valor;
+        ventana.sum = 0;
+        ventana.last = valor;
+        ventana.count = 0;
+        ventana.written = false;
+      }
+
+      int32_t desplazamiento = (int32_t)(timestampMs - inicio);
+      ventana.count++;
+      ventana.sum += valor;
+      ventana.min = valor < ventana.min ? valor : ventana.min;
+      ventana.max = valor > ventana.max ? valor : ventana.max;
+      if (desplazamiento >= ventana.lastMs) {
+        ventana.lastMs = desplazamiento;
+        ventana.last = valor;
+      }
+      ventana.dirty = true;
+      int64_t cierre = inicio + longitud + config.graceMs;
+      due[nivel] = cierre < due[nivel] ? cierre : due[nivel];
+    }
+  }
+}
+
+uint32_t RollupEngine::flush(RollupTier tier, int64_t nowMs, bool force, std::vector<char>& out, size_t maxBytes) {
+  uint32_t lineas = 0;
+  if (!force && nowMs < due[tier]) {
+    return lineas;
+  }
+  int64_t longitud = WINDOW_MS[tier];
+  int64_t siguiente = INT64_MAX;
+  for (Series& serie : all) {
+    RollupWindow* anillo = &serie.windows[offsets[tier]];
+    for (int i = 0; i < config.slots[tier]; i++) {
+      RollupWindow& ventana = anillo[i];
+      if (!ventana.dirty) {
+        continue;
+      }
+      int64_t cierre = ventana.startMs + longitud + config.graceMs;
+      if (!force && cierre > nowMs) {
+        siguiente = cierre < siguiente ? cierre : siguiente;
+        continue;
+      }
+      if (out.size() >= maxBytes) {
+        // Quedan ventanas sin recorrer: la proxima llamada vuelve a empezar
+        due[tier] = nowMs;
+        return lineas;
+      }
+      line_append_window(out, serie.measurement, serie.sensor, serie.field, ventana, config.decimals);
+      lineas++;
+      counters.windows++;
+      if (ventana.written) {
+        counters.rewrites++;
+      }
+      ventana.dirty = false;
+      ventana.written = true;
+    }
+  }
+  due[tier] = siguiente;
+  return lineas;
+}
+
+/*
+///////////////// ESTADO ENTRE ARRANQUES \\\\\\\\\\\\\\\\\
+*/
+// Formato: marca, huecos de cada nivel y numero de series; por serie, las longitudes y los
+// textos de medicion, sensor y campo y sus ventanas tal como estan en memoria (el fichero solo
+// se lee en la misma maquina)
+bool RollupEngine::save(const char* path) const {
+  std::string temporal = std::string(path) + ".tmp";
+  FILE* fichero = fopen(temporal.c_str(), "wb");
+  if (fichero == nullptr) {
+    return false;
+  }
+  int32_t huecos[ROLLUP_TIERS];
+  for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+    huecos[nivel] = config.slots[nivel];
+  }
+  uint32_t n = (uint32_t)all.size();
+  bool ok = fwrite(MARCA, sizeof(MARCA), 1, fichero) == 1 && fwrite(huecos, sizeof(huecos), 1, fichero) == 1 &&
+            fwrite(&n, sizeof(n), 1, fichero) == 1;
+  for (size_t i = 0; ok && i < all.size(); i++) {
+    const Series& serie = all[i];
+    uint16_t longitudes[3] = {(uint16_t)serie.measurement.size(), (uint16_t)serie.sensor.size(),
+                              (uint16_t)serie.field.size()};
+    ok = fwrite(longitudes, sizeof(longitudes), 1, fichero) == 1 &&
+         fwrite(serie.measurement.data(), 1, longitudes[0], fichero) == longitudes[0] &&
+         fwrite(serie.sensor.data(), 1, longitudes[1], fichero) == longitudes[1] &&
+         fwrite(serie.field.data(), 1, longitudes[2], fichero) == longitudes[2] &&
+         fwrite(serie.windows.get(), sizeof(RollupWindow), slotsPerSeries, fichero) == slotsPerSeries;
+  }
+  ok = fclose(fichero) == 0 && ok;
+  if (!ok || rename(temporal.c_str(), path) != 0) {
+    remove(temporal.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool RollupEngine::load(const char* path) {
+  FILE* fichero = fopen(path, "rb");
+  if (fichero == nullptr) {
+    return false;
+  }
+  char marca[sizeof(MARCA)];
+  int32_t huecos[ROLLUP_TIERS];
+  uint32_t n = 0;
+  bool ok = fread(marca, sizeof(marca), 1, fichero) == 1 && memcmp(marca, MARCA, sizeof(MARCA)) == 0 &&
+            fread(huecos, sizeof(huecos), 1, fichero) == 1 && fread(&n, sizeof(n), 1, fichero) == 1;
+  for (int nivel = 0; ok && nivel < ROLLUP_TIERS; nivel++) {
+    ok = huecos[nivel] == config.slots[nivel];
+  }
+
+  std::string texto;
+  std::unique_ptr<RollupWindow[]> ventanas(new RollupWindow[slotsPerSeries]);
+  for (uint32_t i = 0; ok && i < n; i++) {
+    uint16_t longitudes[3];
+    ok = fread(longitudes, sizeof(longitudes), 1, fichero) == 1;
+    texto.resize(ok ? (size_t)longitudes[0] + longitudes[1] + longitudes[2] : 0);
+    ok = ok && fread(&texto[0], 1, texto.size(), fichero) == texto.size() &&
+         fread(ventanas.get(), sizeof(RollupWindow), slotsPerSeries, fichero) == slotsPerSeries;
+    if (!ok) {
+      break;
+    }
+    FieldView campo = {texto.data() + longitudes[0] + longitudes[1], longitudes[2], 0};
+    Series* serie = find(texto.data(), longitudes[0], texto.data() + longitudes[0], longitudes[1], campo);
+    if (serie != nullptr) {
+      memcpy(serie->windows.get(), ventanas.get(), sizeof(RollupWindow) * slotsPerSeries);
+    }
+  }
+  fclose(fichero);
+  if (!ok) {
+    all.clear();
+    index.clear();
+    return false;
+  }
+
+  // Ventanas con lecturas sin escribir: se escriben cuando toque, como si acabaran de llegar
+  for (int nivel = 0; nivel < ROLLUP_TIERS; nivel++) {
+    for (const Series& serie : all) {
+      const RollupWindow* anillo = &serie.windows[offsets[nivel]];
+      for (int i = 0; i < config.slots[nivel]; i++) {
+        if (anillo[i].dirty) {
+          int64_t cierre = anillo[i].startMs + WINDOW_MS[nivel] + config.graceMs;
+          due[nivel] = cierre < due[nivel] ? cierre : due[nivel];
+        }
+      }
+    }
+  }
+  return true;
+}
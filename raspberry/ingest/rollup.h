@@ -0,0 +1,163 @@
+#ifndef INGEST_ROLLUP_H
+#define INGEST_ROLLUP_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "payload_decoder.h"
+
+/*
+///////////////// AGREGADOS POR MINUTO, HORA Y DIA \\\\\\\\\\\\\\\\\
+*/
+// Cada campo de cada medicion y sensor (una serie) acumula, segun llegan las lecturas, el
+// numero, minimo, maximo, suma y ultimo valor de sus ventanas de 1 min, 1 h y 1 dia (UTC).
+// Cada nivel es un anillo de tamaño fijo con las ultimas ventanas de la serie: una lectura
+// atrasada (lotes, cola persistente de los nodos) cae en su ventana mientras siga en el anillo.
+//
+// Una ventana se escribe cuando ha pasado su final mas el margen graceMs, y solo si ha cambiado
+// desde la ultima vez. Si despues llega una lectura atrasada, la ventana se vuelve a escribir con
+// el mismo instante y InfluxDB sustituye el punto anterior.
+//
+// El estado de las ventanas solo esta en memoria: save() lo guarda al parar y load() lo
+// recupera al arrancar, para que una ventana abierta durante el reinicio se siga acumulando
+// con las lecturas anteriores en vez de reescribirse solo con las nuevas.
+//
+// Cada nivel va a su politica de retencion, con la misma medicion y las etiquetas sensor y campo:
+//   esp32_1,sensor=params,campo=temperatura_sonda count=60i,min=21.5,max=22,sum=1305.2,last=21.8 <inicio>
+
+enum RollupTier {
+  ROLLUP_MINUTE = 0,
+  ROLLUP_HOUR = 1,
+  ROLLUP_DAY = 2,
+  ROLLUP_TIERS = 3,
+};
+
+/**
+ * @brief Ventana de una serie en un nivel.
+ */
+struct RollupWindow {
+  // Inicio de la ventana (ms desde la epoca Unix), o -1 si el hueco esta libre
+  int64_t startMs;
+  double sum;
+  // Los nodos miden en float: min, max y ultimo valor no necesitan mas precision
+  float min;
+  float max;
+  float last;
+  // Instante de la lectura mas reciente (la del ultimo valor), en ms desde startMs
+  int32_t lastMs;
+  uint32_t count;
+  // Tiene lecturas que aun no se han escrito
+  bool dirty;
+  // Ya se ha escrito alguna vez (una nueva escritura es una correccion)
+  bool written;
+};
+
+struct RollupConfig {
+  // Ventanas que guarda cada nivel: 2 h de minutos, 2 dias de horas y 5 semanas de dias
+  int slots[ROLLUP_TIERS] = {120, 48, 35};
+  // Espera tras el final de una ventana antes de escribirla (los lotes llegan con retraso)
+  int64_t graceMs = 5 * 60 * 1000;
+  // Series como mucho; las lecturas de series nuevas por encima se ignoran
+  size_t maxSeries = 4096;
+  // Decimales a los que se redondean los valores, como las lineas sin agregar
+  int decimals = 1;
+};
+
+/**
+ * @brief Contadores acumulados desde el arranque.
+ */
+struct RollupStats {
+  uint64_t values;     // valores agregados (un campo de una lectura)
+  uint64_t late;       // valores de ventanas que ya han salido del anillo, por nivel
+  uint64_t overflow;   // valores de series nuevas que no caben
+  uint64_t windows;    // ventanas escritas
+  uint64_t rewrites;   // ventanas escritas de nuevo por lecturas atrasadas
+};
+
+class RollupEngine {
+public:
+  explicit RollupEngine(const RollupConfig& config);
+
+  /**
+   * @brief Añade los campos de una lectura a sus ventanas. Solo reserva memoria la primera
+   * vez que aparece una serie.
+   *
+   * @param measurement Medicion (primer nivel del topic).
+   * @param measurementLen Longitud de la medicion.
+   * @param sensor Etiqueta sensor (segundo nivel del topic).
+   * @param sensorLen Longitud de la etiqueta.
+   * @param fields Campos de la lectura.
+   * @param count Numero de campos.
+   * @param timestampMs Instante de la lectura en ms desde la epoca Unix.
+   */
+  void add(const char* measurement, size_t measurementLen, const char* sensor, size_t sensorLen,
+           const FieldView* fields, size_t count, int64_t timestampMs);
+
+  /**
+   * @brief Escribe como lineas las ventanas de un nivel con cambios pendientes que ya se
+   * pueden escribir.
+   *
+   * @param tier Nivel.
+   * @param nowMs Instante actual en ms desde la epoca Unix.
+   * @param force Escribe tambien las ventanas que siguen abiertas (al parar).
+   * @param out Buffer al que se añaden las lineas.
+   * @param maxBytes Se deja de escribir al superar este tamaño de out; el resto queda pendiente.
+   * @return Numero de lineas añadidas.
+   */
+  uint32_t flush(RollupTier tier, int64_t nowMs, bool force, std::vector<char>& out, size_t maxBytes);
+
+  /**
+   * @brief Guarda las series y sus ventanas en un fichero (se escribe aparte y se renombra,
+   * de modo que un corte deja el fichero anterior).
+   *
+   * @param path Ruta del fichero.
+   * @return false si no se ha podido escribir.
+   */
+  bool save(const char* path) const;
+
+  /**
+   * @brief Recupera las ventanas guardadas con save(). Solo se llama antes de la primera
+   * lectura; un fichero de otra configuracion de huecos se ignora.
+   *
+   * @param path Ruta del fichero.
+   * @return false si no existe o no es valido (el motor queda vacio).
+   */
+  bool load(const char* path);
+
+  RollupStats stats() const { return counters; }
+
+  size_t series() const { return all.size(); }
+
+  // Duracion de las ventanas de cada nivel (ms)
+  static const int64_t WINDOW_MS[ROLLUP_TIERS];
+
+private:
+  struct Series {
+    std::string measurement;
+    std::string sensor;
+    std::string field;
+    // Anillos de todos los niveles seguidos: config.slots[0] + slots[1] + slots[2] ventanas
+    std::unique_ptr<RollupWindow[]> windows;
+  };
+
+  RollupConfig config;
+  size_t slotsPerSeries;
+  size_t offsets[ROLLUP_TIERS];
+  double scale;
+  std::vector<Series> all;
+  std::unordered_map<std::string, uint32_t> index;
+  // Clave de busqueda reutilizada: no reserva memoria tras las primeras lecturas
+  std::string key;
+  RollupStats counters;
+  // Por nivel, instante a partir del cual alguna ventana pendiente se puede escribir: flush()
+  // no recorre las series hasta entonces
+  int64_t due[ROLLUP_TIERS];
+
+  Series* find(const char* measurement, size_t measurementLen, const char* sensor, size_t sensorLen,
+               const FieldView& field);
+};
+
+#endif // INGEST_ROLLUP_H
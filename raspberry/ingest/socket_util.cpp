@@ -0,0 +1,74 @@
+#include "socket_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+int tcp_connect(const std::string& host, int port, int timeoutMs) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* direcciones = nullptr;
+  char puerto[8];
+  snprintf(puerto, sizeof(puerto), "%d", port);
+  if (getaddrinfo(host.c_str(), puerto, &hints, &direcciones) != 0) {
+    return -1;
+  }
+
+  int fd = -1;
+  for (addrinfo* a = direcciones; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    // Conexion no bloqueante para poder acotar el tiempo de espera
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int r = connect(fd, a->ai_addr, a->ai_addrlen);
+    if (r < 0 && errno == EINPROGRESS) {
+      pollfd p = {fd, POLLOUT, 0};
+      int error = 0;
+      socklen_t len = sizeof(error);
+      r = poll(&p, 1, timeoutMs) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0 ? 0 : -1;
+    }
+    if (r < 0) {
+      close(fd);
+      fd = -1;
+      continue;
+    }
+    fcntl(fd, F_SETFL, flags);
+  }
+  freeaddrinfo(direcciones);
+  if (fd < 0) {
+    return -1;
+  }
+
+  timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int uno = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &uno, sizeof(uno));
+  return fd;
+}
+
+bool send_all(int fd, const void* data, size_t len) {
+  const char* p = (const char*)data;
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
@@ -0,0 +1,27 @@
+#ifndef INGEST_SOCKET_UTIL_H
+#define INGEST_SOCKET_UTIL_H
+
+#include <stddef.h>
+#include <string>
+
+/*
+///////////////// SOCKETS TCP \\\\\\\\\\\\\\\\\
+*/
+
+/**
+ * @brief Abre una conexion TCP con timeout de envio y recepcion.
+ *
+ * @param host Nombre o direccion del servidor.
+ * @param port Puerto.
+ * @param timeoutMs Timeout de conexion, envio y recepcion.
+ * @return Descriptor del socket o -1 si falla.
+ */
+int tcp_connect(const std::string& host, int port, int timeoutMs);
+
+/**
+ * @brief Envia todo el buffer, repitiendo los envios parciales.
+ * @return false si se cierra la conexion o vence el timeout.
+ */
+bool send_all(int fd, const void* data, size_t len);
+
+#endif // INGEST_SOCKET_UTIL_H
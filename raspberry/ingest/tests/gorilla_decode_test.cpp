@@ -0,0 +1,290 @@
+/*
+ * Pruebas de los lotes Gorilla: el codificador del firmware (lib/payload y lib/gorilla) frente
+ * al decodificador del puente. Cada lote se recupera igual en los dos modos, y los mensajes
+ * truncados, con bits cambiados o aleatorios se rechazan o se decodifican sin salirse del
+ * buffer. Se registra en ctest; con -DINGEST_SANITIZE=ON se ejecuta con ASan y UBSan.
+ *
+ * Uso: gorilla_decode_test
+ */
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <gorilla.h>
+#include <payload.h>
+#include "../payload_decoder.h"
+
+static int fallos = 0;
+
+#define CHECK(condicion)                                                  \
+  do {                                                                    \
+    if (!(condicion)) {                                                   \
+      printf("  FALLO %s:%d: %s\n", __FILE__, __LINE__, #condicion);      \
+      fallos++;                                                           \
+    }                                                                     \
+  } while (0)
+
+static uint32_t semilla = 1;
+
+static uint32_t next_random() {
+  semilla = semilla * 1664525UL + 1013904223UL;
+  return semilla >> 8;
+}
+
+// Hora de recepcion y hora UTC de la primera lectura (ms)
+static const int64_t AHORA_MS = 1760000000000LL;
+static const uint64_t INSTANTE = 1759999000000ULL;
+
+/*
+///////////////// LOTES \\\\\\\\\\\\\\\\\
+*/
+static SensorSample sample(uint32_t timestamp, float sonda, float dht, float humedad, int16_t capacitor) {
+  SensorSample s;
+  s.timestamp = timestamp;
+  s.temperatureProbe = sonda;
+  s.temperatureDHT = dht;
+  s.humidityDHT = humedad;
+  s.humidityCapacitor = capacitor;
+  return s;
+}
+
+// Serie lenta parecida a la de un nodo, una lectura cada 30 s con algo de jitter
+static std::vector<SensorSample> slow_batch(uint8_t n) {
+  std::vector<SensorSample> lote;
+  uint32_t t = 5000;
+  for (uint8_t i = 0; i < n; i++) {
+    float ruido = (float)(next_random() % 9) - 4;
+    lote.push_back(sample(t, roundf((21.5f + i * 0.05f + ruido * 0.0625f) * 16) / 16, 22.0f + (i / 8),
+                          55.0f - (float)(next_random() % 3), (int16_t)(1800 + ruido * 3)));
+    t += 30000 + (next_random() % 200) - 100;
+  }
+  return lote;
+}
+
+// Canales que aparecen y desaparecen (NaN, SAMPLE_NO_HUMIDITY), saltos grandes de valor y
+// diferencias de tiempo negativas y de mas de 12 bits
+static std::vector<SensorSample> irregular_batch() {
+  std::vector<SensorSample> lote;
+  lote.push_back(sample(100, 20.0f, NAN, NAN, 1500));
+  lote.push_back(sample(100, 20.0f, NAN, NAN, 1500));
+  lote.push_back(sample(90, -40.0f, 30.0f, 60.0f, SAMPLE_NO_HUMIDITY));
+  lote.push_back(sample(5000000, 125.0f, 30.0f, 60.0f, -1200));
+  lote.push_back(sample(5000001, NAN, NAN, NAN, SAMPLE_NO_HUMIDITY));
+  lote.push_back(sample(5000600, 3276.7f, -3276.8f, 0.0f, 32767));
+  lote.push_back(sample(4000000, -0.1f, 0.1f, 99.9f, -32767));
+  lote.push_back(sample(4000000 + 86400000, 18.75f, NAN, 45.5f, 0));
+  return lote;
+}
+
+static size_t encode(const std::vector<SensorSample>& lote, uint64_t instante, uint8_t mode, uint8_t* buffer,
+                     size_t size) {
+  return payload_encode_gorilla(lote.data(), (uint8_t)lote.size(), lote.back().timestamp, instante, mode, buffer,
+                                size);
+}
+
+/*
+///////////////// COMPROBACION \\\\\\\\\\\\\\\\\
+*/
+struct Point {
+  int64_t time;
+  std::map<std::string, double> values;
+};
+
+class Collector : public PointSink {
+public:
+  void point(int64_t timestampMs, const FieldView* fields, size_t count) override {
+    Point p;
+    p.time = timestampMs;
+    for (size_t i = 0; i < count; i++) {
+      p.values[std::string(fields[i].name, fields[i].nameLen)] = fields[i].value;
+    }
+    points.push_back(p);
+  }
+
+  std::vector<Point> points;
+};
+
+// Valor que deberia recuperar el decodificador: el float exacto en GORILLA_XOR o la decima
+// saturada a int16 en GORILLA_QUANTIZED
+static double expected(float valor, bool exact) {
+  if (exact) {
+    return valor;
+  }
+  float decimas = fminf(fmaxf(roundf(valor * 10.0f), -32768.0f), 32767.0f);
+  return decimas / 10.0;
+}
+
+static bool same(const Point& p, int64_t time, const SensorSample& s, bool exact) {
+  const char* canales[] = {"temperatura_sonda", "temperatura_dht", "humedad_dht"};
+  const float valores[] = {s.temperatureProbe, s.temperatureDHT, s.humidityDHT};
+  std::map<std::string, double> esperados;
+  for (size_t i = 0; i < 3; i++) {
+    if (!isnan(valores[i])) {
+      esperados[canales[i]] = expected(valores[i], exact);
+    }
+  }
+  if (s.humidityCapacitor != SAMPLE_NO_HUMIDITY) {
+    esperados["humedad_capacitor"] = s.humidityCapacitor;
+  }
+  if (p.time != time || p.values.size() != esperados.size()) {
+    return false;
+  }
+  for (const auto& campo : esperados) {
+    auto it = p.values.find(campo.first);
+    if (it == p.values.end() || (exact ? (float)it->second != (float)campo.second
+                                       : fabs(it->second - campo.second) > 1e-9)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool empty(const SensorSample& s) {
+  return isnan(s.temperatureProbe) && isnan(s.temperatureDHT) && isnan(s.humidityDHT) &&
+         s.humidityCapacitor == SAMPLE_NO_HUMIDITY;
+}
+
+// Codifica y decodifica el lote, con la hora UTC o con la edad, y compara cada lectura
+static void check_round_trip(const std::vector<SensorSample>& lote, uint8_t mode) {
+  for (bool conInstante : {true, false}) {
+    uint8_t buffer[PAYLOAD_BATCH_MAX_SIZE];
+    size_t len = encode(lote, conInstante ? INSTANTE : 0, mode, buffer, sizeof(buffer));
+    CHECK(len > 0);
+    if (len == 0) {
+      continue;
+    }
+    Collector destino;
+    CHECK(payload_decode(buffer, len, AHORA_MS, destino));
+
+    // Sin la hora UTC, la primera lectura tiene la edad respecto a la ultima
+    int64_t base = conInstante ? (int64_t)INSTANTE : AHORA_MS - (lote.back().timestamp - lote[0].timestamp);
+    size_t j = 0;
+    for (const SensorSample& s : lote) {
+      if (empty(s)) {
+        continue;
+      }
+      CHECK(j < destino.points.size());
+      if (j < destino.points.size()) {
+        CHECK(same(destino.points[j], base + (int32_t)(s.timestamp - lote[0].timestamp), s, mode == GORILLA_XOR));
+      }
+      j++;
+    }
+    CHECK(j == destino.points.size());
+  }
+}
+
+/*
+///////////////// PRUEBAS \\\\\\\\\\\\\\\\\
+*/
+static void test_round_trip() {
+  for (uint8_t mode : {GORILLA_QUANTIZED, GORILLA_XOR}) {
+    check_round_trip(slow_batch(1), mode);
+    check_round_trip(slow_batch(2), mode);
+    check_round_trip(slow_batch(PAYLOAD_BATCH_MAX_SAMPLES), mode);
+    check_round_trip(irregular_batch(), mode);
+  }
+}
+
+// Un lote que no cabe en el buffer no se codifica, y nunca escribe fuera de el
+static void test_encoder_overflow() {
+  std::vector<SensorSample> lote = slow_batch(PAYLOAD_BATCH_MAX_SAMPLES);
+  uint8_t completo[PAYLOAD_BATCH_MAX_SIZE];
+  size_t len = encode(lote, INSTANTE, GORILLA_XOR, completo, sizeof(completo));
+  CHECK(len > 0);
+  for (size_t size = 0; size < len; size++) {
+    // Buffer exacto en el heap, para que ASan detecte cualquier escritura de mas
+    std::vector<uint8_t> buffer(size);
+    CHECK(encode(lote, INSTANTE, GORILLA_XOR, buffer.data(), size) == 0);
+  }
+}
+
+// Cualquier mensaje mas corto que el codificado se rechaza
+static void test_truncated_rejected() {
+  for (uint8_t mode : {GORILLA_QUANTIZED, GORILLA_XOR}) {
+    for (bool conInstante : {true, false}) {
+      uint8_t completo[PAYLOAD_BATCH_MAX_SIZE];
+      size_t len = encode(irregular_batch(), conInstante ? INSTANTE : 0, mode, completo, sizeof(completo));
+      CHECK(len > 0);
+      for (size_t corto = 0; corto < len; corto++) {
+        // Copia exacta en el heap: una lectura de mas es un error de ASan
+        std::vector<uint8_t> mensaje(completo, completo + corto);
+        Collector destino;
+        CHECK(!payload_decode(mensaje.data(), mensaje.size(), AHORA_MS, destino));
+      }
+    }
+  }
+}
+
+// Un modo desconocido o una cabecera incompleta se rechazan
+static void test_bad_header_rejected() {
+  uint8_t completo[PAYLOAD_BATCH_MAX_SIZE];
+  size_t len = encode(slow_batch(8), 0, GORILLA_XOR, completo, sizeof(completo));
+  CHECK(len > 9);
+  // Cabecera (4) y edad (4): el byte siguiente es el modo
+  completo[8] = GORILLA_XOR + 1;
+  Collector destino;
+  CHECK(!payload_decode(completo, len, AHORA_MS, destino));
+  CHECK(destino.points.empty());
+}
+
+// Mensajes con bits cambiados o aleatorios: el resultado da igual, pero no se lee fuera del
+// mensaje, no hay comportamiento indefinido y no se entregan mas lecturas de las anunciadas
+static void test_corrupted_messages() {
+  const uint32_t RONDAS = 200000;
+  uint32_t aceptados = 0;
+  for (uint32_t ronda = 0; ronda < RONDAS; ronda++) {
+    uint8_t lecturas = (uint8_t)(1 + next_random() % PAYLOAD_BATCH_MAX_SAMPLES);
+    std::vector<SensorSample> lote = ronda % 2 ? irregular_batch() : slow_batch(lecturas);
+    uint8_t completo[PAYLOAD_BATCH_MAX_SIZE];
+    uint8_t mode = ronda % 3 == 0 ? GORILLA_QUANTIZED : GORILLA_XOR;
+    size_t len = encode(lote, ronda % 5 == 0 ? INSTANTE : 0, mode, completo, sizeof(completo));
+    std::vector<uint8_t> mensaje(completo, completo + len);
+
+    if (ronda % 4 == 0) {
+      // Contenido aleatorio tras una cabecera valida
+      for (size_t i = 4; i < mensaje.size(); i++) {
+        mensaje[i] = (uint8_t)next_random();
+      }
+    } else {
+      uint32_t cambios = 1 + next_random() % 4;
+      for (uint32_t k = 0; k < cambios; k++) {
+        uint32_t bit = next_random() % (mensaje.size() * 8);
+        mensaje[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+      }
+    }
+    // A veces tambien sobra o falta el final
+    if (ronda % 7 == 0) {
+      mensaje.resize(mensaje.size() - 1 - next_random() % (mensaje.size() / 2));
+    } else if (ronda % 11 == 0) {
+      mensaje.push_back((uint8_t)next_random());
+    }
+
+    Collector destino;
+    if (payload_decode(mensaje.data(), mensaje.size(), AHORA_MS, destino)) {
+      aceptados++;
+      CHECK(mensaje[1] != PAYLOAD_TYPE_GORILLA || destino.points.size() <= mensaje[3]);
+    }
+  }
+  printf("  %u mensajes corruptos, %u aceptados\n", RONDAS, aceptados);
+}
+
+int main() {
+  struct {
+    const char* name;
+    void (*run)();
+  } pruebas[] = {
+      {"round_trip", test_round_trip},
+      {"encoder_overflow", test_encoder_overflow},
+      {"truncated_rejected", test_truncated_rejected},
+      {"bad_header_rejected", test_bad_header_rejected},
+      {"corrupted_messages", test_corrupted_messages},
+  };
+  for (const auto& prueba : pruebas) {
+    int antes = fallos;
+    prueba.run();
+    printf("%s: %s\n", prueba.name, fallos == antes ? "ok" : "FALLO");
+  }
+  return fallos == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * Pruebas de los agregados por minuto, hora y dia (rollup.h) con instantes sinteticos: cuando
+ * se escribe cada ventana (margen de espera), las reescrituras por lecturas atrasadas, las
+ * lecturas que ya han salido del anillo, el estado guardado entre arranques, y que campos de
+ * cada sensor agrega el puente (Ingest). Se registra en ctest.
+ *
+ * Uso: rollup_test
+ */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../ingest.h"
+#include "../line_protocol.h"
+#include "../rollup.h"
+
+static int fallos = 0;
+
+#define CHECK(condicion)                                                  \
+  do {                                                                    \
+    if (!(condicion)) {                                                   \
+      printf("  FALLO %s:%d: %s\n", __FILE__, __LINE__, #condicion);      \
+      fallos++;                                                           \
+    }                                                                     \
+  } while (0)
+
+// Inicio de un dia UTC (ms) y duraciones
+static const int64_t DIA = 1760054400000LL;
+static const int64_t MINUTO = 60 * 1000LL;
+static const int64_t HORA = 3600 * 1000LL;
+static const int64_t MARGEN = 5000;
+
+static RollupConfig test_config() {
+  RollupConfig config;
+  config.slots[ROLLUP_MINUTE] = 3;
+  config.slots[ROLLUP_HOUR] = 2;
+  config.slots[ROLLUP_DAY] = 2;
+  config.graceMs = MARGEN;
+  config.decimals = 1;
+  return config;
+}
+
+static void add(RollupEngine& motor, const char* campo, double valor, int64_t instante) {
+  FieldView f = {campo, (uint16_t)strlen(campo), valor};
+  motor.add("esp32_1", 7, "params", 6, &f, 1, instante);
+}
+
+// Lineas escritas por un nivel en el instante indicado
+static std::vector<std::string> flush(RollupEngine& motor, RollupTier nivel, int64_t ahora, bool force = false) {
+  std::vector<char> out;
+  uint32_t n = motor.flush(nivel, ahora, force, out, 1 << 20);
+  std::vector<std::string> lineas;
+  size_t inicio = 0;
+  for (size_t i = 0; i < out.size(); i++) {
+    if (out[i] == '\n') {
+      lineas.emplace_back(out.data() + inicio, i - inicio);
+      inicio = i + 1;
+    }
+  }
+  CHECK(lineas.size() == n);
+  return lineas;
+}
+
+static std::string window_line(const char* campo, const char* valores, int64_t inicio) {
+  return std::string("esp32_1,sensor=params,campo=") + campo + " " + valores + " " + std::to_string(inicio);
+}
+
+/*
+///////////////// PRUEBAS \\\\\\\\\\\\\\\\\
+*/
+// Una ventana se escribe al pasar su final mas el margen, una sola vez, con sus valores
+static void test_grace_and_due() {
+  RollupEngine motor(test_config());
+  add(motor, "temperatura_sonda", 21.04, DIA + 10000);
+  add(motor, "temperatura_sonda", 22.5, DIA + 50000);
+  add(motor, "temperatura_sonda", 20.0, DIA + 30000);
+
+  CHECK(flush(motor, ROLLUP_MINUTE, DIA + MINUTO + MARGEN - 1).empty());
+  std::vector<std::string> lineas = flush(motor, ROLLUP_MINUTE, DIA + MINUTO + MARGEN);
+  CHECK(lineas.size() == 1);
+  // El ultimo valor es el de la lectura mas reciente, no el de la ultima en llegar
+  CHECK(lineas.size() == 1 &&
+        lineas[0] == window_line("temperatura_sonda", "count=3i,min=20,max=22.5,sum=63.5,last=22.5", DIA));
+  CHECK(flush(motor, ROLLUP_MINUTE, DIA + 2 * MINUTO).empty());
+  // La hora sigue abierta
+  CHECK(flush(motor, ROLLUP_HOUR, DIA + MINUTO + MARGEN).empty());
+  CHECK(flush(motor, ROLLUP_HOUR, DIA + HORA + MARGEN).size() == 1);
+  // Al parar se escriben tambien las abiertas
+  CHECK(flush(motor, ROLLUP_DAY, DIA + HORA, true).size() == 1);
+  CHECK(motor.stats().windows == 3);
+  CHECK(motor.stats().rewrites == 0);
+}
+
+// Una lectura atrasada que cae en una ventana ya escrita la vuelve a escribir completa
+static void test_late_rewrite() {
+  RollupEngine motor(test_config());
+  add(motor, "humedad_dht", 50, DIA + 1000);
+  CHECK(flush(motor, ROLLUP_MINUTE, DIA + MINUTO + MARGEN).size() == 1);
+
+  add(motor, "humedad_dht", 60, DIA + 2000);
+  std::vector<std::string> lineas = flush(motor, ROLLUP_MINUTE, DIA + 2 * MINUTO);
+  CHECK(lineas.size() == 1 && lineas[0] == window_line("humedad_dht", "count=2i,min=50,max=60,sum=110,last=60", DIA));
+  CHECK(motor.stats().rewrites == 1);
+  CHECK(motor.stats().late == 0);
+}
+
+// Lecturas de ventanas que ya han salido del anillo: se cuentan y no se escriben. Una ventana
+// sin escribir que se sustituye por otra mas reciente tambien se cuenta
+static void test_ring_eviction() {
+  RollupEngine motor(test_config());
+  add(motor, "temperatura_dht", 20, DIA + 5 * MINUTO);
+  // Tres huecos por minuto: el minuto 2 comparte hueco con el 5
+  add(motor, "temperatura_dht", 19, DIA + 2 * MINUTO);
+  CHECK(motor.stats().late == 1);
+  CHECK(flush(motor, ROLLUP_MINUTE, DIA + 6 * MINUTO + MARGEN).size() == 1);
+
+  // Minuto 8 (hueco del 5, ya escrito) y minuto 11 antes de escribir el 8
+  add(motor, "temperatura_dht", 21, DIA + 8 * MINUTO);
+  add(motor, "temperatura_dht", 22, DIA + 8 * MINUTO + 1000);
+  add(motor, "temperatura_dht", 23, DIA + 11 * MINUTO);
+  CHECK(motor.stats().late == 3);
+  std::vector<std::string> lineas = flush(motor, ROLLUP_MINUTE, DIA + 12 * MINUTO + MARGEN);
+  CHECK(lineas.size() == 1 && lineas[0] == window_line("temperatura_dht", "count=1i,min=23,max=23,sum=23,last=23",
+                                                       DIA + 11 * MINUTO));
+}
+
+// El estado guardado al parar se recupera: la ventana abierta sigue acumulando, y se reescribe
+// con las lecturas de antes y despues del reinicio
+static void test_state_survives_restart() {
+  char path[] = "/tmp/rollup_test_XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  close(fd);
+  {
+    RollupEngine motor(test_config());
+    add(motor, "temperatura_sonda", 20, DIA + HORA);
+    add(motor, "temperatura_sonda", 30, DIA + 23 * HORA);
+    // Parada a las 23:00 con el dia abierto
+    CHECK(flush(motor, ROLLUP_DAY, DIA + 23 * HORA, true).size() == 1);
+    CHECK(motor.save(path));
+  }
+
+  RollupEngine motor(test_config());
+  CHECK(motor.load(path));
+  CHECK(motor.series() == 1);
+  add(motor, "temperatura_sonda", 25, DIA + 23 * HORA + 30 * MINUTO);
+  std::vector<std::string> lineas = flush(motor, ROLLUP_DAY, DIA + 24 * HORA + MARGEN);
+  CHECK(lineas.size() == 1 &&
+        lineas[0] == window_line("temperatura_sonda", "count=3i,min=20,max=30,sum=75,last=25", DIA));
+  CHECK(motor.stats().rewrites == 1);
+  // La hora de las 23:00 no se habia escrito: se escribe con las lecturas de los dos arranques
+  CHECK(flush(motor, ROLLUP_HOUR, DIA + 24 * HORA + MARGEN).size() == 1);
+
+  // Otra configuracion de huecos no aprovecha el fichero
+  RollupConfig distinta = test_config();
+  distinta.slots[ROLLUP_MINUTE] = 4;
+  RollupEngine otro(distinta);
+  CHECK(!otro.load(path));
+  CHECK(otro.series() == 0);
+  unlink(path);
+  CHECK(!otro.load(path));
+}
+
+// Una lectura sin ningun valor finito no genera linea
+static void test_line_without_fields() {
+  FieldView campos[] = {{"temperatura_sonda", 17, NAN}, {"humedad_dht", 11, INFINITY}};
+  std::vector<char> out;
+  CHECK(!line_append(out, "esp32_1", 7, "params", 6, campos, 2, DIA, 1));
+  CHECK(out.empty());
+  campos[1].value = 55.04;
+  CHECK(line_append(out, "esp32_1", 7, "params", 6, campos, 2, DIA, 1));
+  CHECK(std::string(out.begin(), out.end()) == "esp32_1,sensor=params humedad_dht=55 1760054400000\n");
+}
+
+// Ingest agrega todos los campos de params y solo la media, el minimo y el maximo del resumen
+static void test_ingest_field_filter() {
+  IngestConfig config;
+  config.rollupState.clear();
+  Ingest ingest(config);
+  const char* resumen = "{\"ventana_ms\":300000,\"temperatura_sonda_n\":10,\"temperatura_sonda_min\":20.1,"
+                        "\"temperatura_sonda_max\":22.3,\"temperatura_sonda_media\":21.2,"
+                        "\"temperatura_sonda_desv\":0.4,\"ts\":1760054400000}";
+  ingest.handle("esp32_1/summary", 15, (const uint8_t*)resumen, strlen(resumen), 0, DIA);
+  CHECK(ingest.stats().series == 3);
+
+  const char* params = "{\"temperatura_sonda\":21.5,\"humedad_dht\":55,\"ts\":1760054400000}";
+  ingest.handle("esp32_1/params", 14, (const uint8_t*)params, strlen(params), 0, DIA);
+  CHECK(ingest.stats().series == 5);
+
+  // Un sensor que no esta en rollupSensors no se agrega
+  ingest.handle("esp32_1/link", 12, (const uint8_t*)params, strlen(params), 0, DIA);
+  CHECK(ingest.stats().series == 5);
+  CHECK(ingest.stats().lines == 3);
+}
+
+int main() {
+  struct {
+    const char* name;
+    void (*run)();
+  } pruebas[] = {
+      {"grace_and_due", test_grace_and_due},
+      {"late_rewrite", test_late_rewrite},
+      {"ring_eviction", test_ring_eviction},
+      {"state_survives_restart", test_state_survives_restart},
+      {"line_without_fields", test_line_without_fields},
+      {"ingest_field_filter", test_ingest_field_filter},
+  };
+  for (const auto& prueba : pruebas) {
+    int antes = fallos;
+    prueba.run();
+    printf("%s: %s\n", prueba.name, fallos == antes ? "ok" : "FALLO");
+  }
+  return fallos == 0 ? 0 : 1;
+}
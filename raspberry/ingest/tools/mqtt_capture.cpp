@@ -0,0 +1,173 @@
+/*
+ * Captura el trafico MQTT de los nodos en un registro proyectado en memoria (capture_log.h)
+ * para reproducirlo despues con mqtt_replay: sirve para repetir un dia o un mes reales contra
+ * otra version del puente, de la base de datos o del broker.
+ *
+ * Cada mensaje se guarda tal cual con su topic y su hora de llegada. Con SIGINT o SIGTERM se
+ * cierra el segmento en curso; si el proceso muere, lo escrito hasta entonces se puede leer.
+ *
+ * Uso: mqtt_capture [opciones] directorio
+ *   -m broker[:puerto] (127.0.0.1:1883)    -t topics separados por comas (+/params,+/coverage)
+ *   -q QoS, 0 o 1 (0)                      -s MB por segmento (64)
+ */
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include "../capture_log.h"
+#include "../mqtt_client.h"
+
+static const uint16_t KEEPALIVE = 60;
+static const int TIMEOUT_MS = 10000;
+// Espera entre intentos de conexion con el broker: de 1 s a 30 s
+static const int RECONEXION_INICIAL = 1000;
+static const int RECONEXION_MAXIMA = 30000;
+static const int PASADA_MS = 200;
+// Periodo del resumen en stderr (s)
+static const int INFORME_S = 60;
+
+static volatile sig_atomic_t parar = 0;
+
+static void on_signal(int) {
+  parar = 1;
+}
+
+static int64_t unix_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static bool parse_host(const char* text, std::string& host, int& port) {
+  std::string valor = text;
+  size_t dos = valor.rfind(':');
+  host = valor.substr(0, dos);
+  if (dos != std::string::npos) {
+    port = atoi(valor.c_str() + dos + 1);
+  }
+  return !host.empty() && port > 0;
+}
+
+static std::vector<std::string> split_topics(const std::string& text) {
+  std::vector<std::string> topics;
+  size_t inicio = 0;
+  while (inicio <= text.size()) {
+    size_t coma = text.find(',', inicio);
+    if (coma == std::string::npos) {
+      coma = text.size();
+    }
+    if (coma > inicio) {
+      topics.push_back(text.substr(inicio, coma - inicio));
+    }
+    inicio = coma + 1;
+  }
+  return topics;
+}
+
+class Recorder : public MqttHandler {
+public:
+  explicit Recorder(CaptureWriter& log) : log(log), failed(0) {}
+
+  void message(const char* topic, size_t topicLen, const uint8_t* payload, size_t len) override {
+    if (!log.append(topic, topicLen, payload, len, unix_us())) {
+      failed++;
+    }
+  }
+
+  CaptureWriter& log;
+  uint64_t failed;
+};
+
+int main(int argc, char** argv) {
+  std::string broker = "127.0.0.1";
+  int puerto = 1883;
+  std::string topics = "+/params,+/coverage";
+  int qos = 0;
+  size_t segmento = 64;
+  int opcion;
+  bool ok = true;
+  while ((opcion = getopt(argc, argv, "m:t:q:s:")) != -1) {
+    switch (opcion) {
+      case 'm':
+        ok = parse_host(optarg, broker, puerto);
+        break;
+      case 't':
+        topics = optarg;
+        break;
+      case 'q':
+        qos = atoi(optarg) > 0 ? 1 : 0;
+        break;
+      case 's':
+        segmento = strtoul(optarg, nullptr, 10);
+        break;
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+      break;
+    }
+  }
+  std::vector<std::string> filtros = split_topics(topics);
+  if (!ok || optind != argc - 1 || filtros.empty() || segmento < 1 || segmento > 2048) {
+    fprintf(stderr, "Uso: %s [-m broker[:puerto]] [-t topic,topic...] [-q qos] [-s MB_segmento] directorio\n",
+            argv[0]);
+    return 1;
+  }
+
+  CaptureWriter log(argv[optind], segmento << 20);
+  if (!log.open()) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  struct sigaction accion = {};
+  accion.sa_handler = on_signal;
+  sigaction(SIGINT, &accion, nullptr);
+  sigaction(SIGTERM, &accion, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  MqttClient client;
+  Recorder recorder(log);
+  std::string id = "capture-" + std::to_string(getpid());
+  int espera = RECONEXION_INICIAL;
+  uint64_t previos = 0;
+  auto ultimoInforme = std::chrono::steady_clock::now();
+
+  while (!parar) {
+    if (!client.connected()) {
+      if (client.connect(broker, puerto, id, KEEPALIVE, TIMEOUT_MS) && client.subscribe(filtros, qos)) {
+        fprintf(stderr, "Conectado con el broker %s, capturando en %s\n", broker.c_str(), argv[optind]);
+        espera = RECONEXION_INICIAL;
+      } else {
+        fprintf(stderr, "Sin conexion con el broker %s, reintento en %d ms\n", broker.c_str(), espera);
+        for (int t = 0; t < espera && !parar; t += PASADA_MS) {
+          usleep(PASADA_MS * 1000);
+        }
+        espera = espera * 2 < RECONEXION_MAXIMA ? espera * 2 : RECONEXION_MAXIMA;
+        continue;
+      }
+    }
+
+    if (!client.poll(PASADA_MS, recorder)) {
+      fprintf(stderr, "Conexion con el broker perdida\n");
+    }
+
+    auto ahora = std::chrono::steady_clock::now();
+    double segundos = std::chrono::duration<double>(ahora - ultimoInforme).count();
+    if (segundos >= INFORME_S) {
+      fprintf(stderr, "%.1f msg/s | capturados %llu (%.1f MB), segmentos %u, fallidos %llu\n",
+              (log.records() - previos) / segundos, (unsigned long long)log.records(), log.bytes() / 1e6,
+              log.segments(), (unsigned long long)recorder.failed);
+      previos = log.records();
+      ultimoInforme = ahora;
+    }
+  }
+
+  client.disconnect();
+  log.close();
+  fprintf(stderr, "Capturados %llu mensajes (%.1f MB) en %u segmentos, fallidos %llu\n",
+          (unsigned long long)log.records(), log.bytes() / 1e6, log.segments(), (unsigned long long)recorder.failed);
+  return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Reproduce un registro de mqtt_capture (capture_log.h) y mide el rendimiento conseguido.
+ *
+ * Destino de los mensajes:
+ *  - Por defecto solo se decodifican (payload_decode): mide la lectura del registro y el
+ *    decodificador sin red.
+ *  - -m: se vuelven a publicar en su topic (QoS 0) para un mqtt_ingest o mqtt_sub.py que
+ *    escuche en ese broker. Las lecturas sin fecha propia toman la de su nueva llegada.
+ *  - -c: se entregan al puente (Ingest) con la configuracion de main.conf, como si llegaran
+ *    en su instante original: las lecturas sin fecha y los agregados usan la hora capturada.
+ *    Si InfluxDB no da abasto se espera en lugar de descartar mensajes.
+ *
+ * Velocidad: -x 1 tiempo real, -x N N veces mas rapido, -x 0 lo mas rapido posible. Un mes
+ * capturado se reproduce en minutos a maxima velocidad.
+ *
+ * Uso: mqtt_replay [opciones] directorio
+ *   -x velocidad (0)       -f desde, s Unix        -h hasta, s Unix
+ *   -m broker[:puerto]     -c main.conf
+ */
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include "../capture_log.h"
+#include "../config.h"
+#include "../ingest.h"
+#include "../mqtt_client.h"
+#include "../payload_decoder.h"
+
+static const uint16_t KEEPALIVE = 60;
+static const int TIMEOUT_MS = 10000;
+// Mensajes entre pasadas de mantenimiento (keepalive MQTT, tick() del puente, informe)
+static const int PASADA_MENSAJES = 1024;
+// Periodo del progreso en stderr (s)
+static const int INFORME_S = 10;
+// Espera maxima por un bloque libre del puente: los mensajes no se descartan
+static const int ESPERA_BLOQUE_MS = 600000;
+
+static volatile sig_atomic_t parar = 0;
+
+static void on_signal(int) {
+  parar = 1;
+}
+
+static uint64_t monotonic_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static bool parse_host(const char* text, std::string& host, int& port) {
+  std::string valor = text;
+  size_t dos = valor.rfind(':');
+  host = valor.substr(0, dos);
+  if (dos != std::string::npos) {
+    port = atoi(valor.c_str() + dos + 1);
+  }
+  return !host.empty() && port > 0;
+}
+
+static std::string format_time(int64_t timeUs) {
+  time_t segundos = timeUs / 1000000;
+  struct tm fecha;
+  gmtime_r(&segundos, &fecha);
+  char texto[32];
+  strftime(texto, sizeof(texto), "%Y-%m-%d %H:%M:%S", &fecha);
+  return texto;
+}
+
+// Cuenta las lecturas decodificadas
+class CountingSink : public PointSink {
+public:
+  CountingSink() : points(0), values(0) {}
+
+  void point(int64_t, const FieldView*, size_t count) override {
+    points++;
+    values += count;
+  }
+
+  uint64_t points;
+  uint64_t values;
+};
+
+// Los mensajes que lleguen al cliente de reproduccion se ignoran
+class IgnoreHandler : public MqttHandler {
+public:
+  void message(const char*, size_t, const uint8_t*, size_t) override {}
+};
+
+int main(int argc, char** argv) {
+  double velocidad = 0;
+  int64_t desdeUs = INT64_MIN, hastaUs = INT64_MAX;
+  std::string broker, conf;
+  int puerto = 1883;
+  int opcion;
+  bool ok = true;
+  while ((opcion = getopt(argc, argv, "x:f:h:m:c:")) != -1) {
+    switch (opcion) {
+      case 'x':
+        velocidad = atof(optarg);
+        break;
+      case 'f':
+        desdeUs = atoll(optarg) * 1000000LL;
+        break;
+      case 'h':
+        hastaUs = atoll(optarg) * 1000000LL;
+        break;
+      case 'm':
+        ok = parse_host(optarg, broker, puerto);
+        break;
+      case 'c':
+        conf = optarg;
+        break;
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+      break;
+    }
+  }
+  if (!ok || optind != argc - 1 || velocidad < 0 || (!broker.empty() && !conf.empty())) {
+    fprintf(stderr, "Uso: %s [-x velocidad] [-f desde_s] [-h hasta_s] [-m broker[:puerto] | -c main.conf] directorio\n",
+            argv[0]);
+    return 1;
+  }
+
+  CaptureReader log(argv[optind]);
+  if (!log.open()) {
+    fprintf(stderr, "%s no es un registro de mqtt_capture\n", argv[optind]);
+    return 1;
+  }
+  if (desdeUs != INT64_MIN) {
+    log.seek(desdeUs);
+  }
+
+  struct sigaction accion = {};
+  accion.sa_handler = on_signal;
+  sigaction(SIGINT, &accion, nullptr);
+  sigaction(SIGTERM, &accion, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  MqttClient client;
+  IgnoreHandler ignorar;
+  if (!broker.empty() &&
+      !client.connect(broker, puerto, "replay-" + std::to_string(getpid()), KEEPALIVE, TIMEOUT_MS)) {
+    fprintf(stderr, "Sin conexion con el broker %s\n", broker.c_str());
+    return 1;
+  }
+
+  IngestConfig config;
+  std::unique_ptr<Ingest> ingest;
+  if (!conf.empty()) {
+    try {
+      if (!config_load(conf.c_str(), config)) {
+        fprintf(stderr, "No se puede leer %s\n", conf.c_str());
+        return 1;
+      }
+    } catch (const std::exception& e) {
+      fprintf(stderr, "Configuracion no valida en %s: %s\n", conf.c_str(), e.what());
+      return 1;
+    }
+    config.backpressureMs = ESPERA_BLOQUE_MS;
+    // Los agregados de la reproduccion no se mezclan con los del puente en marcha
+    config.rollupState.clear();
+    ingest.reset(new Ingest(config));
+    ingest->start();
+  }
+
+  CountingSink contador;
+  CaptureMessage m;
+  uint64_t mensajes = 0, bytes = 0, fallidos = 0, previos = 0;
+  int64_t primeroUs = 0, ultimoUs = 0;
+  auto inicio = std::chrono::steady_clock::now();
+  auto ultimoInforme = inicio;
+
+  // Keepalive con el broker y envios pendientes del puente, con el reloj de la captura
+  auto mantenimiento = [&](int64_t capturaUs) {
+    if (!broker.empty() && !client.poll(0, ignorar)) {
+      fprintf(stderr, "Conexion con el broker perdida\n");
+      return false;
+    }
+    if (ingest) {
+      ingest->tick(capturaUs / 1000);
+    }
+    return true;
+  };
+
+  while (!parar && log.next(m) && m.timeUs < hastaUs) {
+    if (mensajes == 0) {
+      primeroUs = m.timeUs;
+    }
+    ultimoUs = m.timeUs;
+    if (velocidad > 0) {
+      // Las esperas largas (huecos de la captura) se hacen por tramos de un segundo
+      auto objetivo = inicio + std::chrono::microseconds((int64_t)((m.timeUs - primeroUs) / velocidad));
+      while (!parar && objetivo > std::chrono::steady_clock::now()) {
+        if (ingest) {
+          ingest->flush();
+        }
+        std::this_thread::sleep_until(std::min(objetivo, std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+        if (!mantenimiento(m.timeUs)) {
+          parar = 1;
+        }
+      }
+      if (parar) {
+        break;
+      }
+    }
+
+    if (!broker.empty()) {
+      if (!client.publish(m.topic, m.topicLen, m.payload, m.len, 0)) {
+        fprintf(stderr, "Conexion con el broker perdida\n");
+        break;
+      }
+    } else if (ingest) {
+      ingest->handle(m.topic, m.topicLen, m.payload, m.len, monotonic_ns(), m.timeUs / 1000);
+    } else if (!payload_decode(m.payload, m.len, m.timeUs / 1000, contador)) {
+      fallidos++;
+    }
+    mensajes++;
+    bytes += m.len;
+
+    if (mensajes % PASADA_MENSAJES == 0) {
+      if (!mantenimiento(m.timeUs)) {
+        break;
+      }
+      auto ahora = std::chrono::steady_clock::now();
+      double segundos = std::chrono::duration<double>(ahora - ultimoInforme).count();
+      if (segundos >= INFORME_S) {
+        fprintf(stderr, "%s | %.0f msg/s, %llu mensajes\n", format_time(m.timeUs).c_str(),
+                (mensajes - previos) / segundos, (unsigned long long)mensajes);
+        previos = mensajes;
+        ultimoInforme = ahora;
+      }
+    }
+  }
+
+  if (!broker.empty()) {
+    client.disconnect();
+  }
+  if (ingest) {
+    // Sin estado guardado, stop() no escribe las ventanas abiertas: la reproduccion si, con un
+    // reloj en el que todas estan cerradas
+    ingest->tick(INT64_MAX / 2);
+    ingest->stop();
+  }
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  double capturado = (ultimoUs - primeroUs) / 1e6;
+
+  printf("%llu mensajes, %.1f MB en %.2f s: %.0f msg/s, %.1f MB/s\n", (unsigned long long)mensajes, bytes / 1e6,
+         segundos, mensajes / segundos, bytes / 1e6 / segundos);
+  if (mensajes > 0) {
+    printf("capturado: %s a %s (%.1f h), %.0f veces el tiempo real\n", format_time(primeroUs).c_str(),
+           format_time(ultimoUs).c_str(), capturado / 3600, capturado / segundos);
+  }
+  printf("registros danados %llu\n", (unsigned long long)log.corrupt());
+  if (ingest) {
+    IngestStats s = ingest->stats();
+    printf("puente: lineas %llu, escritas %llu, descartados %llu, rechazadas %llu, mal formados %llu, "
+           "peticiones %llu, reintentos %llu, agregados %llu, atrasados %llu\n",
+           (unsigned long long)s.lines, (unsigned long long)s.written, (unsigned long long)s.dropped,
+           (unsigned long long)s.rejected, (unsigned long long)s.malformed, (unsigned long long)s.requests,
+           (unsigned long long)s.retries, (unsigned long long)s.rollups, (unsigned long long)s.late);
+  } else if (broker.empty()) {
+    printf("decodificados: %llu lecturas, %llu valores, %llu mensajes no validos\n",
+           (unsigned long long)contador.points, (unsigned long long)contador.values, (unsigned long long)fallidos);
+  }
+  return 0;
+}
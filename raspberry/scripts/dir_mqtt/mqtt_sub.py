@@ -5,9 +5,8 @@ almacenarlo en InfluxDB
 import logging
 import os
 import sys
-import json
 from configparser import ConfigParser
-from time import sleep
+from time import sleep, time
 
 import paho.mqtt.client as mqtt
 from influxdb import InfluxDBClient
@@ -20,6 +19,7 @@ sys.path.append("/home/ctacoronte/Escritorio/GitHub/raspberry-micgridblue")
 sys.path.append(os.environ.get("PATH_MGB"))
 
 from func import microgridblue as fn
+from func import payload as pl
 
 
 class SubMqtt:
@@ -93,29 +93,39 @@ class SubMqtt:
         :return: None
         """
         try:
-            # Obtener el diccionario construido por el nodo
-            # '{"temperatura":29.79999924,"humedad":48}' -> {"temperatura":29.79999924,"humedad":48}
-            value = json.loads(msg.payload.decode())
-            # Forzar a que sean un tipo de variable en concreto para evitar futuros errores
-            for clave, valor in value.items():
-                value[clave] = round(float(valor),1)
-
             measurement = msg.topic.split("/")[0]
             tag_sensor = msg.topic.split("/")[1]
-
-            # Construir diccionario
-            points = [
-                {
+            ahora = int(time() * 1000)
+
+            # Un mensaje puede contener una lectura o un lote de lecturas (JSON o binario)
+            points = []
+            for instante, value in pl.decode_points(msg.payload, ahora):
+                # InfluxDB no admite puntos sin campos (lectura sin ningun canal valido)
+                if not value:
+                    continue
+                # Forzar a que sean un tipo de variable en concreto para evitar futuros errores
+                for clave, valor in value.items():
+                    value[clave] = round(float(valor),1)
+
+                # Construir diccionario
+                point = {
                     "measurement": measurement,
                     "tags": {
                         "sensor": tag_sensor,
                     },
                     "fields": value
                 }
-            ]
-
-            # Registrar datos en base datos local InfluxDB
-            self.client_influx.write_points(points=points, time_precision="s")
+                # Las lecturas fechadas en el nodo o diferidas se registran en el instante de
+                # adquisicion; las demas, en el de recepcion. Las diferidas de las que no se
+                # sabe cuando se tomaron se marcan para no confundirlas con lecturas nuevas
+                if instante == pl.SIN_FECHA:
+                    point["tags"]["sin_fecha"] = "1"
+                elif instante is not None:
+                    point["time"] = instante
+                points.append(point)
+
+            # Registrar todas las lecturas en una sola escritura en la base datos local InfluxDB
+            self.client_influx.write_points(points=points, time_precision="ms")
 
             logging.info(points)
         except Exception as e:
@@ -0,0 +1,114 @@
+#!/bin/sh
+# Informe de ocupacion de flash y RAM de cada entorno PlatformIO de los nodos.
+#
+# Uso: tools/size_report.sh [--host] [revision]
+#   Sin argumentos compila el arbol actual y muestra la ocupacion de cada entorno.
+#   Con una revision de git (p. ej. HEAD~1) compila tambien esa revision en un worktree
+#   temporal y muestra la diferencia en bytes (negativo = ahorro).
+#
+#   --host: sin PlatformIO ni el compilador de Xtensa. Compila el firmware de cada nodo en
+#   el PC sobre la HAL simulada (../native/fake_hal) con -Os y eliminacion de secciones sin
+#   usar, con las opciones de su entorno native. Es una aproximacion: codigo x86-64 y drivers
+#   simulados, no la imagen de la placa. Sirve para comparar revisiones o conjuntos de
+#   sensores, no para saber si una imagen cabe. Como flash se cuenta text y como RAM data y
+#   bss; la columna drivers es el numero de simbolos de OneWire, DallasTemperature y DHT que
+#   quedan en el ejecutable. ArduinoJson se busca en ARDUINOJSON_DIR o en las dependencias
+#   que descarga pio para el entorno native.
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+PROJECTS="esp32_1 nodemcu_1"
+
+# Compila todos los entornos de un arbol y escribe "proyecto entorno flash ram" por linea
+measure() {
+  tree=$1
+  for project in $PROJECTS; do
+    # El entorno native se ejecuta en el PC y no tiene imagen de flash
+    for env in $(sed -n 's/^\[env:\(.*\)\]/\1/p' "$tree/$project/platformio.ini" | grep -v '^native$'); do
+      log=$(pio run -d "$tree/$project" -e "$env" 2>&1) || {
+        echo "$project/$env: error de compilacion" >&2
+        echo "$log" | tail -20 >&2
+        continue
+      }
+      # Lineas de la forma "RAM:   [==  ]  15.2% (used 49876 bytes from 327680 bytes)"
+      ram=$(echo "$log" | sed -n 's/^RAM:.*used \([0-9]*\) bytes.*/\1/p' | tail -1)
+      flash=$(echo "$log" | sed -n 's/^Flash:.*used \([0-9]*\) bytes.*/\1/p' | tail -1)
+      echo "$project $env ${flash:-0} ${ram:-0}"
+    done
+  done
+}
+
+# Aproximacion en el PC: mismo formato que measure(), con el entorno "native-host" y el
+# numero de simbolos de drivers como quinta columna
+measure_host() {
+  tree=$1
+  for project in $PROJECTS; do
+    # Opciones -D del entorno native del proyecto
+    flags=$(sed -n '/^\[env:native\]/,/^\[/s/^build_flags *= *//p' "$tree/$project/platformio.ini")
+    json=${ARDUINOJSON_DIR:-$tree/$project/.pio/libdeps/native/ArduinoJson/src}
+    if [ ! -f "$json/ArduinoJson.h" ] || [ ! -d "$tree/native/fake_hal" ]; then
+      echo "$project/native-host: falta ArduinoJson o la HAL simulada" >&2
+      continue
+    fi
+    objects=$(mktemp -d)
+    includes="-I$tree/native/fake_hal -I$tree/native/bench -I$json"
+    for dir in "$tree"/lib/*/; do
+      includes="$includes -I$dir"
+    done
+    sources="$(ls "$tree"/lib/*/*.cpp "$tree"/native/fake_hal/*.cpp "$tree"/native/bench/*.cpp)"
+    sources="$sources $(find "$tree/$project/src" -name '*.cpp' -not -path '*/sleep/*')"
+    ok=1
+    for source in $sources; do
+      ${CXX:-g++} -std=gnu++17 -Os -ffunction-sections -fdata-sections $flags $includes -c "$source" \
+        -o "$objects/$(echo "$source" | tr '/' '_').o" 2>"$objects/log" || { ok=0; break; }
+    done
+    if [ $ok = 1 ] && ${CXX:-g++} -Wl,--gc-sections "$objects"/*.o -o "$objects/program" -lpthread 2>"$objects/log"; then
+      set -- $(size "$objects/program" | tail -1)
+      drivers=$(nm -C "$objects/program" | grep -c -E 'OneWire|DallasTemperature|DHT' || true)
+      echo "$project native-host $1 $(($2 + $3)) $drivers"
+    else
+      echo "$project/native-host: error de compilacion" >&2
+      tail -20 "$objects/log" >&2
+    fi
+    rm -rf "$objects"
+  done
+}
+
+if [ "$1" = "--host" ]; then
+  shift
+  # Mismo informe con la aproximacion en el PC en lugar de las imagenes de las placas
+  measure() {
+    measure_host "$@"
+  }
+  echo "Aproximacion en el PC (x86-64, HAL simulada): no son las imagenes de las placas"
+fi
+
+current=$(mktemp)
+trap 'rm -f "$current"' EXIT
+measure "$ROOT" > "$current"
+
+if [ -z "$1" ]; then
+  printf '%-12s %-22s %10s %10s\n' proyecto entorno flash ram
+  while read -r project env flash ram drivers; do
+    printf '%-12s %-22s %10s %10s %s\n' "$project" "$env" "$flash" "$ram" "${drivers:+drivers $drivers}"
+  done < "$current"
+  exit 0
+fi
+
+# Compila la revision de referencia en un worktree aparte para no tocar el arbol de trabajo
+base=$(mktemp -d)
+reference=$(mktemp)
+trap 'rm -f "$current" "$reference"; git -C "$ROOT" worktree remove --force "$base" >/dev/null 2>&1 || true' EXIT
+git -C "$ROOT" worktree add --detach "$base" "$1" >/dev/null
+measure "$base" > "$reference"
+
+printf '%-12s %-22s %10s %10s %10s %10s\n' proyecto entorno flash "d.flash" ram "d.ram"
+while read -r project env flash ram drivers; do
+  old=$(awk -v p="$project" -v e="$env" '$1 == p && $2 == e { print $3, $4 }' "$reference")
+  if [ -z "$old" ]; then
+    printf '%-12s %-22s %10s %10s %10s %10s\n' "$project" "$env" "$flash" - "$ram" -
+    continue
+  fi
+  set -- $old
+  printf '%-12s %-22s %10s %+10d %10s %+10d\n' "$project" "$env" "$flash" $((flash - $1)) "$ram" $((ram - $2))
+done < "$current"